@@ -38,8 +38,10 @@
 #include "crypto_mem.h"
 #include "crypto_rand.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 const char* emv_lib_version_string(void)
@@ -66,6 +68,44 @@ int emv_ctx_init(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl)
 
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->ttl = ttl;
+	if (ttl) {
+		emv_ttl_set_stats(ttl, &ctx->stats);
+	}
+
+	// Index the lists that are searched for most fields during processing
+	emv_tlv_list_enable_index(&ctx->config.data);
+	emv_tlv_list_enable_index(&ctx->params);
+	emv_tlv_list_enable_index(&ctx->icc);
+	emv_tlv_list_enable_index(&ctx->terminal);
+
+	return 0;
+}
+
+int emv_ctx_arena_init(struct emv_ctx_t* ctx, size_t block_size)
+{
+	int r;
+
+	if (!ctx) {
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	if (!emv_tlv_list_is_empty(&ctx->params) ||
+		!emv_tlv_list_is_empty(&ctx->icc) ||
+		!emv_tlv_list_is_empty(&ctx->terminal)
+	) {
+		// Arena must be initialised before any transaction data is populated
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	emv_tlv_arena_clear(&ctx->arena);
+	r = emv_tlv_arena_init(&ctx->arena, block_size);
+	if (r) {
+		return EMV_ERROR_INTERNAL;
+	}
+
+	ctx->params.arena = &ctx->arena;
+	ctx->icc.arena = &ctx->arena;
+	ctx->terminal.arena = &ctx->arena;
 
 	return 0;
 }
@@ -89,6 +129,10 @@ int emv_ctx_reset(struct emv_ctx_t* ctx)
 	ctx->aip = NULL;
 	ctx->afl = NULL;
 
+	// Release all transaction data in a single step but retain the arena
+	// memory for the next transaction
+	emv_tlv_arena_reset(&ctx->arena);
+
 	return 0;
 }
 
@@ -101,6 +145,9 @@ int emv_ctx_clear(struct emv_ctx_t* ctx)
 	ctx->ttl = NULL;
 	emv_config_clear(&ctx->config);
 	emv_ctx_reset(ctx);
+	emv_tlv_arena_clear(&ctx->arena);
+	emv_tlv_sources_index_clear(&ctx->sources_index);
+	emv_dol_cache_clear(&ctx->dol_cache);
 
 	return 0;
 }
@@ -352,25 +399,56 @@ int emv_card_activated(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl)
 	}
 
 	ctx->ttl = ttl;
+	emv_ttl_set_stats(ttl, &ctx->stats);
 
 	return 0;
 }
 
-int emv_build_candidate_list(
-	const struct emv_ctx_t* ctx,
-	struct emv_app_list_t* app_list
+int emv_card_activated_atr(
+	struct emv_ctx_t* ctx,
+	struct emv_ttl_t* ttl,
+	const void* atr,
+	size_t atr_len
 )
 {
 	int r;
+	struct iso7816_atr_info_t atr_info;
 
-	if (!ctx || !app_list) {
-		emv_debug_trace_msg("ctx=%p, app_list=%p", ctx, app_list);
+	if (!ctx || !ttl || !atr || !atr_len) {
+		emv_debug_trace_msg("ctx=%p, ttl=%p, atr=%p, atr_len=%zu", ctx, ttl, atr, atr_len);
 		emv_debug_error("Invalid parameter");
 		return EMV_ERROR_INVALID_PARAMETER;
 	}
 
-	emv_debug_info("Select Payment System Environment (PSE)");
-	r = emv_tal_read_pse(ctx->ttl, &ctx->config, app_list);
+	r = iso7816_atr_parse(atr, atr_len, &atr_info);
+	if (r) {
+		emv_debug_trace_msg("iso7816_atr_parse() failed; r=%d", r);
+		if (r < 0) {
+			emv_debug_error("Internal error");
+			return EMV_ERROR_INTERNAL;
+		}
+		emv_debug_error("Failed to parse ATR");
+		return EMV_OUTCOME_CARD_ERROR;
+	}
+
+	// Select transmission protocol before any other command is exchanged
+	// See EMV Contact Interface Specification v1.0, 9.2.4.3
+	r = emv_ttl_select_protocol(ttl, &atr_info);
+	if (r) {
+		emv_debug_trace_msg("emv_ttl_select_protocol() failed; r=%d", r);
+		if (r < 0) {
+			emv_debug_error("Internal error");
+			return EMV_ERROR_INTERNAL;
+		}
+		emv_debug_error("Failed to select transmission protocol");
+		return EMV_OUTCOME_CARD_ERROR;
+	}
+
+	return emv_card_activated(ctx, ttl);
+}
+
+static int emv_build_candidate_list_pse_finalise(int r)
+{
 	if (r < 0) {
 		emv_debug_trace_msg("emv_tal_read_pse() failed; r=%d", r);
 		emv_debug_error("Failed to read PSE; terminate session");
@@ -385,19 +463,21 @@ int emv_build_candidate_list(
 		emv_debug_info("Failed to process PSE; continue session");
 	}
 
-	// If PSE failed or no apps found by PSE, use list of AIDs method
-	// See EMV 4.4 Book 1, 12.3.2, step 5
-	if (emv_app_list_is_empty(app_list)) {
-		emv_debug_info("Discover list of AIDs");
-		r = emv_tal_find_supported_apps(ctx->ttl, &ctx->config, app_list);
-		if (r) {
-			emv_debug_trace_msg("emv_tal_find_supported_apps() failed; r=%d", r);
-			emv_debug_error("Failed to find supported AIDs; terminate session");
-			if (r == EMV_TAL_ERROR_CARD_BLOCKED) {
-				return EMV_OUTCOME_CARD_BLOCKED;
-			} else {
-				return EMV_OUTCOME_CARD_ERROR;
-			}
+	return 0;
+}
+
+static int emv_build_candidate_list_finalise(
+	int r,
+	struct emv_app_list_t* app_list
+)
+{
+	if (r) {
+		emv_debug_trace_msg("emv_tal_find_supported_apps() failed; r=%d", r);
+		emv_debug_error("Failed to find supported AIDs; terminate session");
+		if (r == EMV_TAL_ERROR_CARD_BLOCKED) {
+			return EMV_OUTCOME_CARD_BLOCKED;
+		} else {
+			return EMV_OUTCOME_CARD_ERROR;
 		}
 	}
 
@@ -420,17 +500,60 @@ int emv_build_candidate_list(
 	return 0;
 }
 
-int emv_select_application(
+int emv_build_candidate_list(
+	const struct emv_ctx_t* ctx,
+	struct emv_app_list_t* app_list
+)
+{
+	int r;
+
+	if (!ctx || !app_list) {
+		emv_debug_trace_msg("ctx=%p, app_list=%p", ctx, app_list);
+		emv_debug_error("Invalid parameter");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	emv_debug_info("Select Payment System Environment (PSE)");
+	r = emv_tal_read_pse(ctx->ttl, &ctx->config, app_list);
+	r = emv_build_candidate_list_pse_finalise(r);
+	if (r) {
+		return r;
+	}
+
+	// If PSE failed or no apps found by PSE, use list of AIDs method
+	// See EMV 4.4 Book 1, 12.3.2, step 5
+	if (emv_app_list_is_empty(app_list)) {
+		emv_debug_info("Discover list of AIDs");
+		r = emv_tal_find_supported_apps(ctx->ttl, &ctx->config, app_list);
+	}
+
+	return emv_build_candidate_list_finalise(r, app_list);
+}
+
+static int emv_select_application_try_again(const struct emv_app_list_t* app_list)
+{
+	// If no applications remain, terminate session
+	// Otherwise, try again
+	// See EMV 4.4 Book 1, 12.4
+	// See EMV 4.4 Book 4, 11.3
+	if (emv_app_list_is_empty(app_list)) {
+		emv_debug_info("Candidate list empty");
+		return EMV_OUTCOME_NOT_ACCEPTED;
+	} else {
+		return EMV_OUTCOME_TRY_AGAIN;
+	}
+}
+
+static int emv_select_application_prepare(
 	struct emv_ctx_t* ctx,
 	struct emv_app_list_t* app_list,
-	unsigned int index
+	unsigned int index,
+	uint8_t* aid,
+	size_t* aid_len
 )
 {
 	int r;
-	struct emv_app_t* current_app = NULL;
-	uint8_t current_aid[16];
-	size_t current_aid_len;
-	const struct emv_config_app_t* config_app;
+	struct emv_app_t* current_app;
 
 	if (!ctx || !app_list) {
 		emv_debug_trace_msg("ctx=%p, app_list=%p, index=%u", ctx, app_list, index);
@@ -458,90 +581,94 @@ int emv_select_application(
 		return EMV_ERROR_INVALID_PARAMETER;
 	}
 
-	if (current_app->aid->length > sizeof(current_aid)) {
-		goto try_again;
+	if (current_app->aid->length > 16) {
+		emv_app_free(current_app);
+		return emv_select_application_try_again(app_list);
 	}
-	current_aid_len = current_app->aid->length;
-	memcpy(current_aid, current_app->aid->value, current_app->aid->length);
+	*aid_len = current_app->aid->length;
+	memcpy(aid, current_app->aid->value, current_app->aid->length);
 	emv_app_free(current_app);
-	current_app = NULL;
 
-	r = emv_tal_select_app(
-		ctx->ttl,
-		current_aid,
-		current_aid_len,
-		&ctx->selected_app
-	);
+	return 0;
+}
+
+static int emv_select_application_finalise(
+	struct emv_ctx_t* ctx,
+	struct emv_app_list_t* app_list,
+	int r
+)
+{
+	const struct emv_config_app_t* config_app;
+
 	if (r) {
 		emv_debug_trace_msg("emv_tal_select_app() failed; r=%d", r);
 		if (r < 0) {
 			emv_debug_error("Error during application selection; terminate session");
 			if (r == EMV_TAL_ERROR_CARD_BLOCKED) {
-				r = EMV_OUTCOME_CARD_BLOCKED;
+				return EMV_OUTCOME_CARD_BLOCKED;
 			} else {
-				r = EMV_OUTCOME_CARD_ERROR;
+				return EMV_OUTCOME_CARD_ERROR;
 			}
-			goto exit;
 		}
 		if (r > 0) {
 			emv_debug_info("Failed to select application; continue session");
-			goto try_again;
+			return emv_select_application_try_again(app_list);
 		}
 	}
 	if (!ctx->selected_app) {
 		emv_debug_trace_msg("emv_tal_select_app() failed to populate selected_app");
 		emv_debug_error("Internal error");
-		r = EMV_ERROR_INTERNAL;
-		goto exit;
+		return EMV_ERROR_INTERNAL;
 	}
 
 	// Populate matching application dependent data
 	config_app = emv_config_app_find_supported(&ctx->config, ctx->selected_app);
 	if (!config_app) {
 		emv_debug_error("Application configuration not found");
-		r = EMV_ERROR_INTERNAL;
-		goto exit;
+		return EMV_ERROR_INTERNAL;
 	}
 	emv_debug_info_tlv_list("Application dependent data", &config_app->data);
 	ctx->selected_app->config = config_app;
 
-	// Success
-	r = 0;
-	goto exit;
+	return 0;
+}
 
-try_again:
-	// If no applications remain, terminate session
-	// Otherwise, try again
-	// See EMV 4.4 Book 1, 12.4
-	// See EMV 4.4 Book 4, 11.3
-	if (emv_app_list_is_empty(app_list)) {
-		emv_debug_info("Candidate list empty");
-		r = EMV_OUTCOME_NOT_ACCEPTED;
-	} else {
-		r = EMV_OUTCOME_TRY_AGAIN;
-	}
+int emv_select_application(
+	struct emv_ctx_t* ctx,
+	struct emv_app_list_t* app_list,
+	unsigned int index
+)
+{
+	int r;
+	uint8_t aid[16];
+	size_t aid_len;
 
-exit:
-	if (current_app) {
-		emv_app_free(current_app);
-		current_app = NULL;
+	r = emv_select_application_prepare(ctx, app_list, index, aid, &aid_len);
+	if (r) {
+		return r;
 	}
 
-	return r;
+	r = emv_tal_select_app(
+		ctx->ttl,
+		aid,
+		aid_len,
+		&ctx->selected_app
+	);
+
+	return emv_select_application_finalise(ctx, app_list, r);
 }
 
-int emv_initiate_application_processing(
+static int emv_initiate_application_processing_prepare(
 	struct emv_ctx_t* ctx,
-	uint8_t pos_entry_mode
+	uint8_t pos_entry_mode,
+	uint8_t* gpo_data,
+	size_t* gpo_data_len
 )
 {
 	int r;
 	uint8_t un[4];
+	const struct emv_tlv_t* param_un;
 	const struct emv_tlv_t* pdol;
-	uint8_t gpo_data_buf[EMV_CAPDU_DATA_MAX];
-	uint8_t* gpo_data;
-	size_t gpo_data_len;
-	struct emv_tlv_list_t gpo_output = EMV_TLV_LIST_INIT;
 
 	if (!ctx || !ctx->selected_app) {
 		emv_debug_trace_msg("ctx=%p, selected_app=%p", ctx, ctx->selected_app);
@@ -556,6 +683,7 @@ int emv_initiate_application_processing(
 	emv_tlv_list_clear(&ctx->terminal);
 
 	// Clear existing ODA state to avoid ambiguity
+	emv_oda_clear_records(&ctx->oda);
 	r = emv_oda_init(&ctx->oda);
 	if (r) {
 		emv_debug_trace_msg("emv_oda_init() failed; r=%d", r);
@@ -640,7 +768,14 @@ int emv_initiate_application_processing(
 
 	// Create Unpredictable Number (field 9F37)
 	// See EMV 4.4 Book 4, 6.5.6
-	crypto_rand(un, sizeof(un));
+	param_un = emv_tlv_list_find_const(&ctx->params, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+	if (param_un && param_un->length == sizeof(un)) {
+		// Use recorded value to replay transaction
+		emv_debug_trace_msg("Using Unpredictable Number from transaction parameters");
+		memcpy(un, param_un->value, sizeof(un));
+	} else {
+		crypto_rand(un, sizeof(un));
+	}
 	r = emv_tlv_list_push(
 		&ctx->terminal,
 		EMV_TAG_9F37_UNPREDICTABLE_NUMBER,
@@ -691,6 +826,8 @@ int emv_initiate_application_processing(
 			emv_debug_error("Failed to build PDOL sources");
 			return EMV_ERROR_INTERNAL;
 		}
+		// Use merged tag index to avoid searching each source per DOL entry
+		emv_tlv_sources_enable_index(&sources, &ctx->sources_index);
 
 		// Validate PDOL data length
 		pdol_data_len = emv_dol_compute_data_length(pdol->value, pdol->length);
@@ -705,7 +842,6 @@ int emv_initiate_application_processing(
 		}
 
 		// Prepare GPO data buffer with field 83
-		gpo_data = gpo_data_buf;
 		gpo_data[0] = EMV_TAG_83_COMMAND_TEMPLATE;
 		pdol_data_offset = 1;
 		if (pdol_data_len < 0x80) {
@@ -721,7 +857,8 @@ int emv_initiate_application_processing(
 
 		// Populate PDOL data in cache buffer
 		ctx->oda.pdol_data_len = sizeof(ctx->oda.pdol_data);
-		r = emv_dol_build_data(
+		r = emv_dol_cache_build_data(
+			&ctx->dol_cache,
 			pdol->value,
 			pdol->length,
 			&sources,
@@ -729,7 +866,7 @@ int emv_initiate_application_processing(
 			&ctx->oda.pdol_data_len
 		);
 		if (r) {
-			emv_debug_trace_msg("emv_dol_build_data() failed; r=%d", r);
+			emv_debug_trace_msg("emv_dol_cache_build_data() failed; r=%d", r);
 			emv_debug_error("Failed to build PDOL data");
 
 			// This is considered an internal error because the PDOL has
@@ -739,31 +876,31 @@ int emv_initiate_application_processing(
 		}
 
 		// Finalise GPO data buffer
-		if (ctx->oda.pdol_data_len > sizeof(gpo_data_buf) - pdol_data_offset) {
+		if (ctx->oda.pdol_data_len > EMV_CAPDU_DATA_MAX - pdol_data_offset) {
 			emv_debug_error("Error during PDOL processing; "
-				"pdol_data_len=%zu; sizeof(gpo_data_buf)=%zu; pdol_data_offset=%zu",
-				ctx->oda.pdol_data_len, sizeof(gpo_data_buf), pdol_data_offset
+				"pdol_data_len=%zu; gpo_data_max=%u; pdol_data_offset=%zu",
+				ctx->oda.pdol_data_len, EMV_CAPDU_DATA_MAX, pdol_data_offset
 			);
 			return EMV_ERROR_INTERNAL;
 		}
 		memcpy(gpo_data + pdol_data_offset, ctx->oda.pdol_data, ctx->oda.pdol_data_len);
-		gpo_data_len = pdol_data_offset + ctx->oda.pdol_data_len;
+		*gpo_data_len = pdol_data_offset + ctx->oda.pdol_data_len;
 
 	} else {
 		// PDOL not available. emv_ttl_get_processing_options() will build
 		// empty Command Template (field 83) if no GPO data is provided
-		gpo_data = NULL;
-		gpo_data_len = 0;
+		*gpo_data_len = 0;
 	}
 
-	r = emv_tal_get_processing_options(
-		ctx->ttl,
-		gpo_data,
-		gpo_data_len,
-		&gpo_output,
-		&ctx->aip,
-		&ctx->afl
-	);
+	return 0;
+}
+
+static int emv_initiate_application_processing_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* gpo_output
+)
+{
 	if (r) {
 		emv_debug_trace_msg("emv_tal_get_processing_options() failed; r=%d", r);
 		if (r < 0) {
@@ -794,11 +931,18 @@ int emv_initiate_application_processing(
 	}
 
 	// Move application data to ICC data list
-	ctx->icc = ctx->selected_app->tlv_list;
-	ctx->selected_app->tlv_list = EMV_TLV_LIST_INIT;
+	r = emv_tlv_list_append(&ctx->icc, &ctx->selected_app->tlv_list);
+	if (r) {
+		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
+
+		// Internal error; terminate session
+		emv_debug_error("Internal error");
+		r = EMV_ERROR_INTERNAL;
+		goto error;
+	}
 
 	// Append GPO output to ICC data list
-	r = emv_tlv_list_append(&ctx->icc, &gpo_output);
+	r = emv_tlv_list_append(&ctx->icc, gpo_output);
 	if (r) {
 		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
 
@@ -813,19 +957,44 @@ int emv_initiate_application_processing(
 	goto exit;
 
 error:
-	emv_tlv_list_clear(&gpo_output);
+	emv_tlv_list_clear(gpo_output);
 exit:
 	return r;
 }
 
-int emv_read_application_data(struct emv_ctx_t* ctx)
+int emv_initiate_application_processing(
+	struct emv_ctx_t* ctx,
+	uint8_t pos_entry_mode
+)
+{
+	int r;
+	uint8_t gpo_data[EMV_CAPDU_DATA_MAX];
+	size_t gpo_data_len;
+	struct emv_tlv_list_t gpo_output = EMV_TLV_LIST_INIT;
+
+	r = emv_initiate_application_processing_prepare(ctx, pos_entry_mode, gpo_data, &gpo_data_len);
+	if (r) {
+		return r;
+	}
+
+	// Temporary ICC data list uses the same arena as the ICC data list
+	gpo_output.arena = ctx->icc.arena;
+
+	r = emv_tal_get_processing_options(
+		ctx->ttl,
+		gpo_data_len ? gpo_data : NULL,
+		gpo_data_len,
+		&gpo_output,
+		&ctx->aip,
+		&ctx->afl
+	);
+
+	return emv_initiate_application_processing_finalise(ctx, r, &gpo_output);
+}
+
+static int emv_read_application_data_prepare(struct emv_ctx_t* ctx)
 {
 	int r;
-	struct emv_tlv_list_t record_data = EMV_TLV_LIST_INIT;
-	bool found_5F24 = false;
-	bool found_5A = false;
-	bool found_8C = false;
-	bool found_8D = false;
 
 	if (!ctx) {
 		emv_debug_trace_msg("ctx=%p", ctx);
@@ -862,15 +1031,36 @@ int emv_read_application_data(struct emv_ctx_t* ctx)
 		}
 	}
 
-	// Process Application File Locator (AFL)
-	// See EMV 4.4 Book 3, 10.2
-	r = emv_tal_read_afl_records(
-		ctx->ttl,
-		ctx->afl->value,
-		ctx->afl->length,
-		&record_data,
-		&ctx->oda
-	);
+	if (ctx->oda_pipeline && ctx->aid && ctx->aid->length >= 5) {
+		r = emv_oda_enable_pipeline(&ctx->oda, ctx->aid->value, &ctx->params);
+		if (r) {
+			emv_debug_trace_msg("emv_oda_enable_pipeline() failed; r=%d", r);
+			// Continue without pipelining
+		} else {
+			// The GPO response may already provide some or all of the fields
+			// required for issuer public key recovery
+			r = emv_oda_update_pipeline(&ctx->oda, &ctx->icc);
+			if (r) {
+				emv_debug_trace_msg("emv_oda_update_pipeline() failed; r=%d", r);
+				// Continue without pipelining
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int emv_read_application_data_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* record_data
+)
+{
+	bool found_5F24 = false;
+	bool found_5A = false;
+	bool found_8C = false;
+	bool found_8D = false;
+
 	if (r) {
 		emv_debug_trace_msg("emv_tal_read_afl_records() failed; r=%d", r);
 		if (r < 0) {
@@ -891,7 +1081,7 @@ int emv_read_application_data(struct emv_ctx_t* ctx)
 		// See EMV 4.4 Book 3, 10.3 (page 98)
 	}
 
-	if (emv_tlv_list_has_duplicate(&record_data)) {
+	if (emv_tlv_list_has_duplicate(record_data)) {
 		// Redundant primitive data objects are not permitted
 		// See EMV 4.4 Book 3, 10.2
 		emv_debug_error("Application data contains redundant fields");
@@ -899,7 +1089,7 @@ int emv_read_application_data(struct emv_ctx_t* ctx)
 		goto error;
 	}
 
-	for (const struct emv_tlv_t* tlv = record_data.front; tlv != NULL; tlv = tlv->next) {
+	for (const struct emv_tlv_t* tlv = record_data->front; tlv != NULL; tlv = tlv->next) {
 		// Mandatory data objects
 		// See EMV 4.4 Book 3, 7.2
 		if (tlv->tag == EMV_TAG_5F24_APPLICATION_EXPIRATION_DATE) {
@@ -923,7 +1113,7 @@ int emv_read_application_data(struct emv_ctx_t* ctx)
 		goto error;
 	}
 
-	r = emv_tlv_list_append(&ctx->icc, &record_data);
+	r = emv_tlv_list_append(&ctx->icc, record_data);
 	if (r) {
 		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
 
@@ -940,14 +1130,42 @@ int emv_read_application_data(struct emv_ctx_t* ctx)
 error:
 	emv_oda_clear(&ctx->oda);
 exit:
-	emv_tlv_list_clear(&record_data);
+	emv_tlv_list_clear(record_data);
 	return r;
 }
 
-int emv_offline_data_authentication(struct emv_ctx_t* ctx)
+int emv_read_application_data(struct emv_ctx_t* ctx)
 {
 	int r;
-	const struct emv_tlv_t* term_caps;
+	struct emv_tlv_list_t record_data = EMV_TLV_LIST_INIT;
+
+	r = emv_read_application_data_prepare(ctx);
+	if (r) {
+		return r;
+	}
+
+	// Temporary ICC data list uses the same arena as the ICC data list
+	record_data.arena = ctx->icc.arena;
+
+	// Process Application File Locator (AFL)
+	// See EMV 4.4 Book 3, 10.2
+	r = emv_tal_read_afl_records(
+		ctx->ttl,
+		ctx->afl->value,
+		ctx->afl->length,
+		&record_data,
+		&ctx->oda
+	);
+
+	return emv_read_application_data_finalise(ctx, r, &record_data);
+}
+
+static int emv_offline_data_authentication_prepare(
+	struct emv_ctx_t* ctx,
+	const uint8_t** term_caps_value
+)
+{
+	const struct emv_tlv_t* term_caps;
 	const struct emv_tlv_t* default_ddol;
 
 	if (!ctx) {
@@ -964,19 +1182,31 @@ int emv_offline_data_authentication(struct emv_ctx_t* ctx)
 		emv_debug_trace_msg("term_caps=%p, term_caps->length=%u",
 			term_caps, term_caps ? term_caps->length : 0);
 		emv_debug_error("Terminal Capabilities (9F33) not found or invalid");
-		r = EMV_ERROR_INVALID_CONFIG;
-		goto exit;
+		goto error;
 	}
 	default_ddol = emv_config_data_get(ctx, EMV_TAG_9F49_DDOL);
 	if (!default_ddol || default_ddol->length < 2) {
 		emv_debug_trace_msg("default_ddol=%p, default_ddol->length=%u",
 			default_ddol, default_ddol ? default_ddol->length : 0);
 		emv_debug_error("Default DDOL (9F49) not found or invalid");
-		r = EMV_ERROR_INVALID_CONFIG;
-		goto exit;
+		goto error;
 	}
+	*term_caps_value = term_caps->value;
+
+	return 0;
+
+error:
+	// Clear only records because they are no longer needed and contain
+	// sensitive card data.
+	emv_oda_clear_records(&ctx->oda);
+	return EMV_ERROR_INVALID_CONFIG;
+}
 
-	r = emv_oda_apply(ctx, term_caps->value);
+static int emv_offline_data_authentication_finalise(
+	struct emv_ctx_t* ctx,
+	int r
+)
+{
 	if (r) {
 		if (r < 0) {
 			emv_debug_trace_msg("emv_oda_apply() failed; r=%d", r);
@@ -1009,6 +1239,21 @@ exit:
 	return r;
 }
 
+int emv_offline_data_authentication(struct emv_ctx_t* ctx)
+{
+	int r;
+	const uint8_t* term_caps;
+
+	r = emv_offline_data_authentication_prepare(ctx, &term_caps);
+	if (r) {
+		return r;
+	}
+
+	r = emv_oda_apply(ctx, term_caps);
+
+	return emv_offline_data_authentication_finalise(ctx, r);
+}
+
 int emv_processing_restrictions(struct emv_ctx_t* ctx)
 {
 	const struct emv_tlv_t* term_app_version;
@@ -1236,9 +1481,11 @@ int emv_processing_restrictions(struct emv_ctx_t* ctx)
 	return 0;
 }
 
-int emv_terminal_risk_management(struct emv_ctx_t* ctx,
+static int emv_terminal_risk_management_prepare(
+	struct emv_ctx_t* ctx,
 	const struct emv_txn_log_entry_t* txn_log,
-	size_t txn_log_cnt
+	size_t txn_log_cnt,
+	bool* velocity_checking
 )
 {
 	int r;
@@ -1251,7 +1498,6 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
 	uint32_t amount_value;
 	const struct emv_tlv_t* lower_offline_limit;
 	const struct emv_tlv_t* upper_offline_limit;
-	struct emv_tlv_list_t get_data_list = EMV_TLV_LIST_INIT;
 
 	if (!ctx) {
 		emv_debug_trace_msg("ctx=%p", ctx);
@@ -1444,34 +1690,70 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
 	if (lower_offline_limit && lower_offline_limit->length == 1 &&
 		 upper_offline_limit && upper_offline_limit->length == 1
 	) {
+		// Velocity checking requires GET DATA for Application Transaction
+		// Counter (9F36) and Last Online ATC Register (9F13)
+		*velocity_checking = true;
+	} else {
+		// If not present, skip velocity checking
+		// See EMV 4.4 Book 3, 10.6.3
+		// See EMV 4.4 Book 3, 7.3
+		emv_debug_trace_msg("One or both Consecutive Offline Limits (9F14 or 9F23) not found");
+		emv_debug_info("ICC does not support velocity checking");
+		ctx->tvr->value[1] &= ~EMV_TVR_NEW_CARD;
+		ctx->tvr->value[3] &= ~EMV_TVR_LOWER_CONSECUTIVE_OFFLINE_LIMIT_EXCEEDED;
+		ctx->tvr->value[3] &= ~EMV_TVR_UPPER_CONSECUTIVE_OFFLINE_LIMIT_EXCEEDED;
+		*velocity_checking = false;
+	}
+
+	return 0;
+}
+
+static int emv_terminal_risk_management_get_data_finalise(
+	int r,
+	const char* name
+)
+{
+	if (r) {
+		emv_debug_trace_msg("emv_tal_get_data() failed; r=%d", r);
+		emv_debug_error("Failed to retrieve %s", name);
+
+		if (r < 0) {
+			if (r == EMV_TAL_ERROR_INTERNAL || r == EMV_TAL_ERROR_INVALID_PARAMETER) {
+				return EMV_ERROR_INTERNAL;
+			} else {
+				// All other GET DATA errors are card errors
+				return EMV_OUTCOME_CARD_ERROR;
+			}
+		}
+
+		// Otherwise continue processing
+	}
+
+	return 0;
+}
+
+static int emv_terminal_risk_management_finalise(
+	struct emv_ctx_t* ctx,
+	bool velocity_checking,
+	struct emv_tlv_list_t* get_data_list
+)
+{
+	int r;
+
+	if (velocity_checking) {
+		const struct emv_tlv_t* lower_offline_limit;
+		const struct emv_tlv_t* upper_offline_limit;
 		const struct emv_tlv_t* atc;
 		uint32_t atc_value;
 		const struct emv_tlv_t* last_online_atc;
 		uint32_t last_online_atc_value;
 
-		// Retrieve Application Transaction Counter (9F36)
-		r = emv_tal_get_data(
-			ctx->ttl,
-			EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER,
-			&get_data_list
-		);
-		if (r) {
-			emv_debug_trace_msg("emv_tal_get_data() failed; r=%d", r);
-			emv_debug_error("Failed to retrieve Application Transaction Counter (9F36)");
-
-			if (r < 0) {
-				if (r == EMV_TAL_ERROR_INTERNAL || r == EMV_TAL_ERROR_INVALID_PARAMETER) {
-					r = EMV_ERROR_INTERNAL;
-				} else {
-					// All other GET DATA errors are card errors
-					r = EMV_OUTCOME_CARD_ERROR;
-				}
-				goto exit;
-			}
+		// Presence of both Consecutive Offline Limits has been confirmed by
+		// emv_terminal_risk_management_prepare()
+		lower_offline_limit = emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F14_LOWER_CONSECUTIVE_OFFLINE_LIMIT);
+		upper_offline_limit = emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F23_UPPER_CONSECUTIVE_OFFLINE_LIMIT);
 
-			// Otherwise continue processing
-		}
-		atc = emv_tlv_list_find_const(&get_data_list, EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER);
+		atc = emv_tlv_list_find_const(get_data_list, EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER);
 		if (atc) {
 			r = emv_format_b_to_uint(
 				atc->value,
@@ -1490,29 +1772,7 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
 			emv_debug_trace_msg("ATC value is %u", atc_value);
 		}
 
-		// Retrieve Last Online ATC Register (9F13)
-		r = emv_tal_get_data(
-			ctx->ttl,
-			EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER,
-			&get_data_list
-		);
-		if (r) {
-			emv_debug_trace_msg("emv_tal_get_data() failed; r=%d", r);
-			emv_debug_error("Failed to retrieve Last Online ATC Register (9F13)");
-
-			if (r < 0) {
-				if (r == EMV_TAL_ERROR_INTERNAL || r == EMV_TAL_ERROR_INVALID_PARAMETER) {
-					r = EMV_ERROR_INTERNAL;
-				} else {
-					// All other GET DATA errors are card errors
-					r = EMV_OUTCOME_CARD_ERROR;
-				}
-				goto exit;
-			}
-
-			// Otherwise continue processing
-		}
-		last_online_atc = emv_tlv_list_find_const(&get_data_list, EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER);
+		last_online_atc = emv_tlv_list_find_const(get_data_list, EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER);
 		if (last_online_atc) {
 			r = emv_format_b_to_uint(
 				last_online_atc->value,
@@ -1570,20 +1830,10 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
 		} else {
 			ctx->tvr->value[1] &= ~EMV_TVR_NEW_CARD;
 		}
-
-	} else {
-		// If not present, skip velocity checking
-		// See EMV 4.4 Book 3, 10.6.3
-		// See EMV 4.4 Book 3, 7.3
-		emv_debug_trace_msg("One or both Consecutive Offline Limits (9F14 or 9F23) not found");
-		emv_debug_info("ICC does not support velocity checking");
-		ctx->tvr->value[1] &= ~EMV_TVR_NEW_CARD;
-		ctx->tvr->value[3] &= ~EMV_TVR_LOWER_CONSECUTIVE_OFFLINE_LIMIT_EXCEEDED;
-		ctx->tvr->value[3] &= ~EMV_TVR_UPPER_CONSECUTIVE_OFFLINE_LIMIT_EXCEEDED;
 	}
 
 	// Append GET DATA output to ICC data list
-	r = emv_tlv_list_append(&ctx->icc, &get_data_list);
+	r = emv_tlv_list_append(&ctx->icc, get_data_list);
 	if (r) {
 		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
 
@@ -1597,18 +1847,68 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
 	r = 0;
 	goto exit;
 
+exit:
+	emv_tlv_list_clear(get_data_list);
+	return r;
+}
+
+int emv_terminal_risk_management(struct emv_ctx_t* ctx,
+	const struct emv_txn_log_entry_t* txn_log,
+	size_t txn_log_cnt
+)
+{
+	int r;
+	bool velocity_checking;
+	struct emv_tlv_list_t get_data_list = EMV_TLV_LIST_INIT;
+
+	r = emv_terminal_risk_management_prepare(ctx, txn_log, txn_log_cnt, &velocity_checking);
+	if (r) {
+		return r;
+	}
+
+	// Temporary ICC data list uses the same arena as the ICC data list
+	get_data_list.arena = ctx->icc.arena;
+
+	if (velocity_checking) {
+		// Retrieve Application Transaction Counter (9F36)
+		r = emv_tal_get_data(
+			ctx->ttl,
+			EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER,
+			&get_data_list
+		);
+		r = emv_terminal_risk_management_get_data_finalise(r, "Application Transaction Counter (9F36)");
+		if (r) {
+			goto exit;
+		}
+
+		// Retrieve Last Online ATC Register (9F13)
+		r = emv_tal_get_data(
+			ctx->ttl,
+			EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER,
+			&get_data_list
+		);
+		r = emv_terminal_risk_management_get_data_finalise(r, "Last Online ATC Register (9F13)");
+		if (r) {
+			goto exit;
+		}
+	}
+
+	return emv_terminal_risk_management_finalise(ctx, velocity_checking, &get_data_list);
+
 exit:
 	emv_tlv_list_clear(&get_data_list);
 	return r;
 }
 
-int emv_card_action_analysis(struct emv_ctx_t* ctx)
+static int emv_card_action_analysis_prepare(
+	struct emv_ctx_t* ctx,
+	uint8_t* genac_ref_ctrl
+)
 {
 	int r;
 	uint8_t ref_ctrl;
 	struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
 	const struct emv_tlv_t* cdol1;
-	struct emv_tlv_list_t genac_list = EMV_TLV_LIST_INIT;
 
 	if (!ctx) {
 		emv_debug_trace_msg("ctx=%p", ctx);
@@ -1653,6 +1953,8 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 		emv_debug_error("Failed to build CDOL1 sources");
 		return EMV_ERROR_INTERNAL;
 	}
+	// Use merged tag index to avoid searching each source per DOL entry
+	emv_tlv_sources_enable_index(&sources, &ctx->sources_index);
 
 	// Prepare Card Risk Management Data
 	// See EMV 4.4 Book 3, 9.2.1
@@ -1666,7 +1968,8 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 
 	// Populate CDOL1 data in cache buffer
 	ctx->oda.cdol1_data_len = sizeof(ctx->oda.cdol1_data);
-	r = emv_dol_build_data(
+	r = emv_dol_cache_build_data(
+		&ctx->dol_cache,
 		cdol1->value,
 		cdol1->length,
 		&sources,
@@ -1674,7 +1977,7 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 		&ctx->oda.cdol1_data_len
 	);
 	if (r) {
-		emv_debug_trace_msg("emv_dol_build_data() failed; r=%d", r);
+		emv_debug_trace_msg("emv_dol_cache_build_data() failed; r=%d", r);
 		emv_debug_error("Failed to build CDOL1 data");
 
 		// This is considered a card error because CDOL1 is provided by the
@@ -1682,17 +1985,18 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 		// exceeded.
 		return EMV_OUTCOME_CARD_ERROR;
 	}
+	*genac_ref_ctrl = ref_ctrl;
 
-	// Perform Card Action Analysis using GENAC1
-	// See EMV 4.4 Book 3, 10.8
-	r = emv_tal_genac(
-		ctx->ttl,
-		ref_ctrl,
-		ctx->oda.cdol1_data,
-		ctx->oda.cdol1_data_len,
-		&genac_list,
-		(ref_ctrl & EMV_TTL_GENAC_SIG_MASK) ? &ctx->oda : NULL
-	);
+	return 0;
+}
+
+static int emv_card_action_analysis_finalise(
+	struct emv_ctx_t* ctx,
+	uint8_t ref_ctrl,
+	int r,
+	struct emv_tlv_list_t* genac_list
+)
+{
 	if (r) {
 		emv_debug_trace_msg("emv_tal_genac() failed; r=%d", r);
 		emv_debug_error("Error during card action analysis; terminate session");
@@ -1713,7 +2017,7 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 	if (ref_ctrl & EMV_TTL_GENAC_SIG_MASK) {
 		// Validate GENAC1 response which will in turn append it to the ICC
 		// data list
-		r = emv_oda_process_genac(ctx, &genac_list);
+		r = emv_oda_process_genac(ctx, genac_list);
 		if (r) {
 			if (r < 0) {
 				emv_debug_trace_msg("emv_oda_process_genac() failed; r=%d", r);
@@ -1732,7 +2036,7 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 		}
 	} else {
 		// Append GENAC1 output to ICC data list
-		r = emv_tlv_list_append(&ctx->icc, &genac_list);
+		r = emv_tlv_list_append(&ctx->icc, genac_list);
 		if (r) {
 			emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
 
@@ -1748,6 +2052,944 @@ int emv_card_action_analysis(struct emv_ctx_t* ctx)
 	goto exit;
 
 exit:
-	emv_tlv_list_clear(&genac_list);
+	emv_tlv_list_clear(genac_list);
+	return r;
+}
+
+int emv_card_action_analysis(struct emv_ctx_t* ctx)
+{
+	int r;
+	uint8_t ref_ctrl;
+	struct emv_tlv_list_t genac_list = EMV_TLV_LIST_INIT;
+
+	r = emv_card_action_analysis_prepare(ctx, &ref_ctrl);
+	if (r) {
+		return r;
+	}
+
+	// Temporary ICC data list uses the same arena as the ICC data list
+	genac_list.arena = ctx->icc.arena;
+
+	// Perform Card Action Analysis using GENAC1
+	// See EMV 4.4 Book 3, 10.8
+	r = emv_tal_genac(
+		ctx->ttl,
+		ref_ctrl,
+		ctx->oda.cdol1_data,
+		ctx->oda.cdol1_data_len,
+		&genac_list,
+		(ref_ctrl & EMV_TTL_GENAC_SIG_MASK) ? &ctx->oda : NULL
+	);
+
+	return emv_card_action_analysis_finalise(ctx, ref_ctrl, r, &genac_list);
+}
+
+/// Resumable EMV transaction states
+enum emv_txn_state_t {
+	EMV_TXN_STATE_BUILD_CANDIDATE_LIST = 0,
+	EMV_TXN_STATE_SELECT_PSE,
+	EMV_TXN_STATE_READ_PSE_RECORD,
+	EMV_TXN_STATE_FIND_SUPPORTED_APPS,
+	EMV_TXN_STATE_NEXT_SUPPORTED_APP,
+	EMV_TXN_STATE_SELECT_SUPPORTED_APP,
+	EMV_TXN_STATE_APP_SELECTION,
+	EMV_TXN_STATE_SELECT_APP,
+	EMV_TXN_STATE_GPO,
+	EMV_TXN_STATE_NEXT_AFL_ENTRY,
+	EMV_TXN_STATE_READ_RECORD,
+	EMV_TXN_STATE_ODA,
+	EMV_TXN_STATE_INTERNAL_AUTHENTICATE,
+	EMV_TXN_STATE_PROCESSING_RESTRICTIONS,
+	EMV_TXN_STATE_TERMINAL_RISK_MANAGEMENT,
+	EMV_TXN_STATE_GET_DATA_ATC,
+	EMV_TXN_STATE_GET_DATA_LAST_ONLINE_ATC,
+	EMV_TXN_STATE_CARD_ACTION_ANALYSIS,
+	EMV_TXN_STATE_GENAC,
+	EMV_TXN_STATE_DONE,
+	EMV_TXN_STATE_OUTCOME,
+};
+
+static int emv_txn_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	struct emv_txn_t* txn = ctx;
+
+	if (txn->replay_offset < txn->transcript_len) {
+		// Replay previous exchange of current command. Each exchange is stored
+		// as a two byte C-APDU length, the C-APDU, a two byte R-APDU length
+		// and the R-APDU.
+		const uint8_t* c_apdu = txn->transcript + txn->replay_offset + 2;
+		size_t c_apdu_len = ((size_t)c_apdu[-2] << 8) | c_apdu[-1];
+		const uint8_t* r_apdu = c_apdu + c_apdu_len + 2;
+		size_t r_apdu_len = ((size_t)r_apdu[-2] << 8) | r_apdu[-1];
+		bool reader_failure;
+
+		if (tx_buf_len != c_apdu_len ||
+			memcmp(tx_buf, c_apdu, c_apdu_len) != 0 ||
+			r_apdu_len > *rx_buf_len
+		) {
+			// Kernel did not repeat the previous exchange
+			txn->replay_mismatch = true;
+			emv_ttl_set_stats(&txn->ttl, NULL);
+			return -1;
+		}
+
+		// An empty R-APDU indicates that the caller's card reader failed
+		reader_failure = !r_apdu_len;
+		if (!reader_failure) {
+			memcpy(rx_buf, r_apdu, r_apdu_len);
+			*rx_buf_len = r_apdu_len;
+		}
+		txn->replay_offset += 4 + c_apdu_len + r_apdu_len;
+
+		// Only emit debug events for processing beyond the replayed exchanges
+		emv_debug_suppress(txn->replay_offset < txn->transcript_len);
+
+		// Only count the command that completes with the newest exchange
+		// because commands completed by earlier exchanges have already been
+		// counted by previous steps
+		emv_ttl_set_stats(
+			&txn->ttl,
+			txn->replay_offset == txn->transcript_len ? txn->stats : NULL
+		);
+
+		if (reader_failure) {
+			return -3;
+		}
+
+		return 0;
+	}
+
+	if (txn->c_apdu_pending || tx_buf_len > sizeof(txn->c_apdu)) {
+		return -2;
+	}
+
+	// Provide C-APDU to caller and abandon current processing. The debug
+	// events for abandoned processing are suppressed because the processing
+	// will be repeated when the R-APDU is available.
+	memcpy(txn->c_apdu, tx_buf, tx_buf_len);
+	txn->c_apdu_len = tx_buf_len;
+	txn->c_apdu_pending = true;
+	emv_debug_suppress(true);
+
+	// Abandoned command will be counted when it is repeated
+	emv_ttl_set_stats(&txn->ttl, NULL);
+
+	return 1;
+}
+
+static int emv_txn_transcript_append(
+	struct emv_txn_t* txn,
+	const void* r_apdu,
+	size_t r_apdu_len
+)
+{
+	size_t entry_len = 4 + txn->c_apdu_len + r_apdu_len;
+	uint8_t* ptr;
+
+	if (txn->transcript_size - txn->transcript_len < entry_len) {
+		size_t new_size = txn->transcript_size * 2;
+		uint8_t* new_buf;
+
+		if (new_size < txn->transcript_len + entry_len) {
+			new_size = txn->transcript_len + entry_len;
+		}
+		if (new_size < 4 * (EMV_CAPDU_MAX + EMV_RAPDU_MAX)) {
+			new_size = 4 * (EMV_CAPDU_MAX + EMV_RAPDU_MAX);
+		}
+
+		// Transcript contains sensitive card data and is therefore not
+		// reallocated in place
+		new_buf = malloc(new_size);
+		if (!new_buf) {
+			return -1;
+		}
+		if (txn->transcript) {
+			memcpy(new_buf, txn->transcript, txn->transcript_len);
+			crypto_cleanse(txn->transcript, txn->transcript_len);
+			free(txn->transcript);
+		}
+		txn->transcript = new_buf;
+		txn->transcript_size = new_size;
+	}
+
+	ptr = txn->transcript + txn->transcript_len;
+	ptr[0] = txn->c_apdu_len >> 8;
+	ptr[1] = txn->c_apdu_len & 0xFF;
+	memcpy(ptr + 2, txn->c_apdu, txn->c_apdu_len);
+	ptr += 2 + txn->c_apdu_len;
+	ptr[0] = r_apdu_len >> 8;
+	ptr[1] = r_apdu_len & 0xFF;
+	if (r_apdu_len) {
+		memcpy(ptr + 2, r_apdu, r_apdu_len);
+	}
+	txn->transcript_len += entry_len;
+
+	return 0;
+}
+
+static void emv_txn_run_begin(struct emv_txn_t* txn)
+{
+	txn->replay_offset = 0;
+	txn->replay_mismatch = false;
+
+	// Debug events up to the end of the replayed exchanges have already been
+	// emitted by previous steps
+	emv_debug_suppress(txn->transcript_len != 0);
+
+	// Commands are only counted by emv_txn_trx() once their final exchange
+	// is available
+	emv_ttl_set_stats(&txn->ttl, NULL);
+}
+
+static void emv_txn_release(struct emv_txn_t* txn)
+{
+	// Resume debug events and restore the caller's TTL such that further
+	// processing, such as offline data authentication, uses it
+	emv_debug_suppress(false);
+	if (txn->ctx && txn->ctx->ttl == &txn->ttl) {
+		txn->ctx->ttl = txn->ctx_ttl;
+	}
+}
+
+static int emv_txn_run_end(struct emv_txn_t* txn)
+{
+	bool mismatch;
+
+	emv_debug_suppress(false);
+
+	if (txn->c_apdu_pending) {
+		// Processing abandoned until R-APDU is available
+		return 1;
+	}
+
+	// Current command complete
+	mismatch = txn->replay_mismatch || txn->replay_offset != txn->transcript_len;
+	crypto_cleanse(txn->transcript, txn->transcript_len);
+	txn->transcript_len = 0;
+
+	if (mismatch) {
+		emv_debug_error("Card exchanges not repeated during resumed processing");
+		return -1;
+	}
+
+	return 0;
+}
+
+int emv_txn_init(
+	struct emv_txn_t* txn,
+	struct emv_ctx_t* ctx,
+	uint8_t pos_entry_mode
+)
+{
+	if (!txn || !ctx) {
+		emv_debug_trace_msg("txn=%p, ctx=%p", txn, ctx);
+		emv_debug_error("Invalid parameter");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	memset(txn, 0, sizeof(*txn));
+	txn->ctx = ctx;
+	txn->stats = &ctx->stats;
+	txn->pos_entry_mode = pos_entry_mode;
+	txn->state = EMV_TXN_STATE_BUILD_CANDIDATE_LIST;
+
+	// Exchanges are performed by the caller in APDU mode
+	txn->ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+	txn->ttl.cardreader.ctx = txn;
+	txn->ttl.cardreader.trx = &emv_txn_trx;
+	txn->ctx_ttl = ctx->ttl;
+	ctx->ttl = &txn->ttl;
+
+	return 0;
+}
+
+int emv_txn_step(
+	struct emv_txn_t* txn,
+	const void* r_apdu,
+	size_t r_apdu_len,
+	enum emv_txn_event_t* event
+)
+{
+	int r;
+	int run;
+	struct emv_ctx_t* ctx;
+
+	if (!txn || !txn->ctx || !event) {
+		emv_debug_trace_msg("txn=%p, event=%p", txn, event);
+		emv_debug_error("Invalid parameter");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+	ctx = txn->ctx;
+
+	if (txn->c_apdu_pending) {
+		// No R-APDU indicates a card reader failure that is processed by the
+		// kernel when the exchange is replayed
+		if ((r_apdu || r_apdu_len) &&
+			(!r_apdu || r_apdu_len < 2 || r_apdu_len > EMV_RAPDU_MAX)
+		) {
+			emv_debug_trace_msg("r_apdu=%p, r_apdu_len=%zu", r_apdu, r_apdu_len);
+			emv_debug_error("Invalid R-APDU");
+			return EMV_ERROR_INVALID_PARAMETER;
+		}
+
+		r = emv_txn_transcript_append(txn, r_apdu, r_apdu_len);
+		if (r) {
+			emv_debug_trace_msg("emv_txn_transcript_append() failed; r=%d", r);
+			emv_debug_error("Internal error");
+			return EMV_ERROR_INTERNAL;
+		}
+		txn->c_apdu_pending = false;
+	}
+
+	// Each state that exchanges a command with the card repeats only that
+	// command until it completes. Progress of the current stage is retained
+	// by the transaction and the command's outcome is processed exactly once.
+	while (true) {
+		switch (txn->state) {
+			case EMV_TXN_STATE_BUILD_CANDIDATE_LIST:
+				emv_app_list_clear(&txn->app_list);
+				emv_debug_info("Select Payment System Environment (PSE)");
+				txn->state = EMV_TXN_STATE_SELECT_PSE;
+				continue;
+
+			case EMV_TXN_STATE_SELECT_PSE:
+				txn->pse_fci_len = sizeof(txn->pse_fci);
+				emv_txn_run_begin(txn);
+				r = emv_tal_select_pse(
+					ctx->ttl,
+					txn->pse_fci,
+					&txn->pse_fci_len,
+					&txn->list,
+					&txn->pse_sfi
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				if (r == 0) {
+					// Read all records from PSE AEF using the SFI
+					// See EMV 4.4 Book 1, 12.2.3
+					txn->record_number = 1;
+					txn->state = EMV_TXN_STATE_READ_PSE_RECORD;
+					continue;
+				}
+				r = emv_build_candidate_list_pse_finalise(r);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_FIND_SUPPORTED_APPS;
+				continue;
+
+			case EMV_TXN_STATE_READ_PSE_RECORD:
+				emv_txn_run_begin(txn);
+				r = emv_tal_read_pse_record(
+					ctx->ttl,
+					&txn->list,
+					txn->pse_sfi,
+					txn->record_number,
+					&ctx->config,
+					&txn->app_list
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				if (r >= 0 && r != EMV_TAL_RESULT_PSE_RECORD_NOT_FOUND) {
+					// Continue with next PSE record
+					++txn->record_number;
+					continue;
+				}
+
+				// PSE processing complete
+				emv_tlv_list_clear(&txn->list);
+				if (r < 0) {
+					emv_app_list_clear(&txn->app_list);
+				} else {
+					r = 0;
+				}
+				r = emv_build_candidate_list_pse_finalise(r);
+				if (r) {
+					goto outcome;
+				}
+
+				if (!emv_app_list_is_empty(&txn->app_list)) {
+					r = emv_build_candidate_list_finalise(0, &txn->app_list);
+					if (r) {
+						goto outcome;
+					}
+
+					txn->state = EMV_TXN_STATE_APP_SELECTION;
+					continue;
+				}
+
+				txn->state = EMV_TXN_STATE_FIND_SUPPORTED_APPS;
+				continue;
+
+			case EMV_TXN_STATE_FIND_SUPPORTED_APPS:
+				// If PSE failed or no apps found by PSE, use list of AIDs method
+				// See EMV 4.4 Book 1, 12.3.2, step 5
+				emv_debug_info("Discover list of AIDs");
+				r = emv_config_app_itr_init(&ctx->config, &txn->config_app_itr);
+				if (r) {
+					emv_debug_error("Internal error");
+					r = emv_build_candidate_list_finalise(EMV_TAL_ERROR_INTERNAL, &txn->app_list);
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_NEXT_SUPPORTED_APP;
+				continue;
+
+			case EMV_TXN_STATE_NEXT_SUPPORTED_APP:
+				// Retrieve next supported application
+				// See EMV 4.4 Book 1, 12.3.3
+				txn->config_app = emv_config_app_itr_next(&txn->config_app_itr);
+				if (!txn->config_app) {
+					// End of supported application list
+					r = emv_build_candidate_list_finalise(0, &txn->app_list);
+					if (r) {
+						goto outcome;
+					}
+
+					txn->state = EMV_TXN_STATE_APP_SELECTION;
+					continue;
+				}
+
+				txn->select_next = false;
+				txn->state = EMV_TXN_STATE_SELECT_SUPPORTED_APP;
+				continue;
+
+			case EMV_TXN_STATE_SELECT_SUPPORTED_APP:
+				emv_txn_run_begin(txn);
+				r = emv_tal_select_supported_app(
+					ctx->ttl,
+					txn->config_app,
+					txn->select_next,
+					&txn->app_list
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				if (r < 0) {
+					r = emv_build_candidate_list_finalise(r, &txn->app_list);
+					goto outcome;
+				}
+
+				// Continue with next partial AID match or next supported AID
+				// See EMV 4.4 Book 1, 12.3.3, step 5 and 7
+				if (r == EMV_TAL_RESULT_APP_SELECT_NEXT) {
+					txn->select_next = true;
+					continue;
+				}
+
+				txn->state = EMV_TXN_STATE_NEXT_SUPPORTED_APP;
+				continue;
+
+			case EMV_TXN_STATE_APP_SELECTION: {
+				unsigned int index = 0;
+
+				if (emv_app_list_selection_is_required(&txn->app_list)) {
+					if (!txn->app_index_valid) {
+						*event = EMV_TXN_EVENT_APP_SELECTION;
+						return 0;
+					}
+					index = txn->app_index;
+					txn->app_index_valid = false;
+				}
+
+				r = emv_select_application_prepare(ctx, &txn->app_list, index, txn->aid, &txn->aid_len);
+				if (r == EMV_ERROR_INVALID_PARAMETER) {
+					// Invalid application index; caller may try again
+					return r;
+				}
+				if (r == EMV_OUTCOME_TRY_AGAIN) {
+					// Return to cardholder application selection/confirmation
+					continue;
+				}
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_SELECT_APP;
+				continue;
+			}
+
+			case EMV_TXN_STATE_SELECT_APP:
+				emv_txn_run_begin(txn);
+				r = emv_tal_select_app(ctx->ttl, txn->aid, txn->aid_len, &ctx->selected_app);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_select_application_finalise(ctx, &txn->app_list, r);
+				if (r == EMV_OUTCOME_TRY_AGAIN) {
+					// Return to cardholder application selection/confirmation
+					// See EMV 4.4 Book 4, 11.3
+					txn->state = EMV_TXN_STATE_APP_SELECTION;
+					continue;
+				}
+				if (r) {
+					goto outcome;
+				}
+
+				txn->dol_data_len = sizeof(txn->dol_data);
+				r = emv_initiate_application_processing_prepare(
+					ctx,
+					txn->pos_entry_mode,
+					txn->dol_data,
+					&txn->dol_data_len
+				);
+				if (r) {
+					goto outcome;
+				}
+
+				// Temporary ICC data list uses the same arena as the ICC data
+				// list from here onwards
+				txn->list.arena = ctx->icc.arena;
+
+				txn->state = EMV_TXN_STATE_GPO;
+				continue;
+
+			case EMV_TXN_STATE_GPO:
+				emv_txn_run_begin(txn);
+				r = emv_tal_get_processing_options(
+					ctx->ttl,
+					txn->dol_data_len ? txn->dol_data : NULL,
+					txn->dol_data_len,
+					&txn->list,
+					&ctx->aip,
+					&ctx->afl
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_initiate_application_processing_finalise(ctx, r, &txn->list);
+				if (r == EMV_OUTCOME_GPO_NOT_ACCEPTED &&
+					!emv_app_list_is_empty(&txn->app_list)
+				) {
+					// Return to cardholder application selection/confirmation
+					// See EMV 4.4 Book 4, 6.3.1
+					txn->state = EMV_TXN_STATE_APP_SELECTION;
+					continue;
+				}
+				if (r) {
+					goto outcome;
+				}
+
+				// Application selection has been successful and the
+				// application list is no longer needed.
+				emv_app_list_clear(&txn->app_list);
+
+				r = emv_read_application_data_prepare(ctx);
+				if (r) {
+					goto outcome;
+				}
+
+				// Process Application File Locator (AFL)
+				// See EMV 4.4 Book 3, 10.2
+				r = emv_afl_itr_init(ctx->afl->value, ctx->afl->length, &txn->afl_itr);
+				if (r) {
+					emv_debug_trace_msg("emv_afl_itr_init() failed; r=%d", r);
+					if (r < 0) {
+						// Internal error; terminate session
+						emv_debug_error("Internal error");
+						r = EMV_TAL_ERROR_INTERNAL;
+					} else {
+						// Invalid AFL; terminate session
+						emv_debug_error("Invalid AFL");
+						r = EMV_TAL_ERROR_AFL_INVALID;
+					}
+					r = emv_read_application_data_finalise(ctx, r, &txn->list);
+					goto outcome;
+				}
+				txn->oda_records_invalid = false;
+
+				txn->state = EMV_TXN_STATE_NEXT_AFL_ENTRY;
+				continue;
+
+			case EMV_TXN_STATE_NEXT_AFL_ENTRY:
+				r = emv_afl_itr_next(&txn->afl_itr, &txn->afl_entry);
+				if (r < 0) {
+					emv_debug_trace_msg("emv_afl_itr_next() failed; r=%d", r);
+
+					// AFL parse error; terminate session
+					// See EMV 4.4 Book 3, 10.2
+					emv_debug_error("AFL parse error");
+					r = emv_read_application_data_finalise(ctx, EMV_TAL_ERROR_AFL_INVALID, &txn->list);
+					goto outcome;
+				}
+				if (r == 0) {
+					// Successfully read records although offline data
+					// authentication may have failed
+					r = emv_read_application_data_finalise(
+						ctx,
+						txn->oda_records_invalid ? EMV_TAL_RESULT_ODA_RECORD_INVALID : 0,
+						&txn->list
+					);
+					if (r) {
+						goto outcome;
+					}
+
+					txn->state = EMV_TXN_STATE_ODA;
+					continue;
+				}
+
+				txn->record_number = txn->afl_entry.first_record;
+				txn->oda_record_invalid = false;
+				txn->state = EMV_TXN_STATE_READ_RECORD;
+				continue;
+
+			case EMV_TXN_STATE_READ_RECORD:
+				// Records are no longer provided for offline data
+				// authentication once a record of the current AFL entry that
+				// is intended for offline data authentication is invalid
+				emv_txn_run_begin(txn);
+				r = emv_tal_read_afl_record(
+					ctx->ttl,
+					&txn->afl_entry,
+					txn->record_number,
+					&txn->list,
+					txn->oda_record_invalid ? NULL : &ctx->oda
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				if (r < 0) {
+					r = emv_read_application_data_finalise(ctx, r, &txn->list);
+					goto outcome;
+				}
+				if (r == EMV_TAL_RESULT_ODA_RECORD_INVALID) {
+					// Continue regardless of offline data authentication failure
+					// See EMV 4.4 Book 3, 10.3 (page 98)
+					txn->oda_record_invalid = true;
+					txn->oda_records_invalid = true;
+				}
+
+				if (txn->record_number < txn->afl_entry.last_record) {
+					++txn->record_number;
+					continue;
+				}
+
+				txn->state = EMV_TXN_STATE_NEXT_AFL_ENTRY;
+				continue;
+
+			case EMV_TXN_STATE_ODA: {
+				const uint8_t* term_caps;
+
+				r = emv_offline_data_authentication_prepare(ctx, &term_caps);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->dol_data_len = sizeof(txn->dol_data);
+				r = emv_oda_apply_prepare(ctx, term_caps, txn->dol_data, &txn->dol_data_len);
+				if (!r && txn->dol_data_len) {
+					// Authenticate ICC
+					// See EMV 4.4 Book 2, 6.5.1
+					txn->state = EMV_TXN_STATE_INTERNAL_AUTHENTICATE;
+					continue;
+				}
+				r = emv_offline_data_authentication_finalise(ctx, r);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_PROCESSING_RESTRICTIONS;
+				continue;
+			}
+
+			case EMV_TXN_STATE_INTERNAL_AUTHENTICATE:
+				emv_txn_run_begin(txn);
+				r = emv_tal_internal_authenticate(
+					ctx->ttl,
+					txn->dol_data,
+					txn->dol_data_len,
+					&txn->list
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_oda_apply_finalise(ctx, r, &txn->list, txn->dol_data, txn->dol_data_len);
+				r = emv_offline_data_authentication_finalise(ctx, r);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_PROCESSING_RESTRICTIONS;
+				continue;
+
+			case EMV_TXN_STATE_PROCESSING_RESTRICTIONS:
+				r = emv_processing_restrictions(ctx);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_TERMINAL_RISK_MANAGEMENT;
+				continue;
+
+			case EMV_TXN_STATE_TERMINAL_RISK_MANAGEMENT:
+				r = emv_terminal_risk_management_prepare(
+					ctx,
+					txn->txn_log,
+					txn->txn_log_cnt,
+					&txn->velocity_checking
+				);
+				if (r) {
+					goto outcome;
+				}
+				if (txn->velocity_checking) {
+					txn->state = EMV_TXN_STATE_GET_DATA_ATC;
+					continue;
+				}
+				r = emv_terminal_risk_management_finalise(ctx, false, &txn->list);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_CARD_ACTION_ANALYSIS;
+				continue;
+
+			case EMV_TXN_STATE_GET_DATA_ATC:
+				// Retrieve Application Transaction Counter (9F36)
+				emv_txn_run_begin(txn);
+				r = emv_tal_get_data(
+					ctx->ttl,
+					EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER,
+					&txn->list
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_terminal_risk_management_get_data_finalise(r, "Application Transaction Counter (9F36)");
+				if (r) {
+					emv_tlv_list_clear(&txn->list);
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_GET_DATA_LAST_ONLINE_ATC;
+				continue;
+
+			case EMV_TXN_STATE_GET_DATA_LAST_ONLINE_ATC:
+				// Retrieve Last Online ATC Register (9F13)
+				emv_txn_run_begin(txn);
+				r = emv_tal_get_data(
+					ctx->ttl,
+					EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER,
+					&txn->list
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_terminal_risk_management_get_data_finalise(r, "Last Online ATC Register (9F13)");
+				if (r) {
+					emv_tlv_list_clear(&txn->list);
+					goto outcome;
+				}
+				r = emv_terminal_risk_management_finalise(ctx, true, &txn->list);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_CARD_ACTION_ANALYSIS;
+				continue;
+
+			case EMV_TXN_STATE_CARD_ACTION_ANALYSIS:
+				r = emv_card_action_analysis_prepare(ctx, &txn->genac_ref_ctrl);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_GENAC;
+				continue;
+
+			case EMV_TXN_STATE_GENAC:
+				// Perform Card Action Analysis using GENAC1
+				// See EMV 4.4 Book 3, 10.8
+				emv_txn_run_begin(txn);
+				r = emv_tal_genac(
+					ctx->ttl,
+					txn->genac_ref_ctrl,
+					ctx->oda.cdol1_data,
+					ctx->oda.cdol1_data_len,
+					&txn->list,
+					(txn->genac_ref_ctrl & EMV_TTL_GENAC_SIG_MASK) ? &ctx->oda : NULL
+				);
+				run = emv_txn_run_end(txn);
+				if (run) {
+					goto run_end;
+				}
+				r = emv_card_action_analysis_finalise(ctx, txn->genac_ref_ctrl, r, &txn->list);
+				if (r) {
+					goto outcome;
+				}
+
+				txn->state = EMV_TXN_STATE_DONE;
+				continue;
+
+			case EMV_TXN_STATE_DONE:
+				emv_txn_release(txn);
+				*event = EMV_TXN_EVENT_DONE;
+				return 0;
+
+			case EMV_TXN_STATE_OUTCOME:
+				emv_txn_release(txn);
+				return txn->outcome;
+
+			default:
+				emv_txn_release(txn);
+				emv_debug_error("Invalid transaction state %d", txn->state);
+				return EMV_ERROR_INTERNAL;
+		}
+	}
+
+run_end:
+	if (run > 0) {
+		// Current command requires the next exchange
+		*event = EMV_TXN_EVENT_CAPDU;
+		return 0;
+	}
+
+	// Exchanges were not repeated by resumed processing
+	emv_tlv_list_clear(&txn->list);
+	r = EMV_ERROR_INTERNAL;
+
+outcome:
+	// Session ends with the current outcome
+	emv_txn_release(txn);
+	txn->state = EMV_TXN_STATE_OUTCOME;
+	txn->outcome = r;
 	return r;
 }
+
+static void emv_txn_async_complete(void* complete_ctx, int r);
+
+static void emv_txn_async_next(
+	struct emv_txn_t* txn,
+	const void* r_apdu,
+	size_t r_apdu_len
+)
+{
+	int r;
+	enum emv_txn_event_t event = 0;
+
+	while (true) {
+		r = emv_txn_step(txn, r_apdu, r_apdu_len, &event);
+		if (r || event != EMV_TXN_EVENT_CAPDU) {
+			txn->complete(txn->complete_ctx, r, event);
+			return;
+		}
+
+		// Exchange C-APDU using the caller's TTL and resume processing
+		// from the completion function
+		txn->r_apdu_len = sizeof(txn->r_apdu);
+		r = emv_ttl_trx_async(
+			txn->ctx_ttl,
+			&txn->trx_state,
+			txn->c_apdu,
+			txn->c_apdu_len,
+			txn->r_apdu,
+			&txn->r_apdu_len,
+			&txn->sw1sw2,
+			&emv_txn_async_complete,
+			txn
+		);
+		if (!r) {
+			return;
+		}
+
+		// Completion function will not be invoked and the card reader
+		// failure is therefore provided to the next step
+		emv_debug_trace_msg("emv_ttl_trx_async() failed; r=%d", r);
+		r_apdu = NULL;
+		r_apdu_len = 0;
+	}
+}
+
+static void emv_txn_async_complete(void* complete_ctx, int r)
+{
+	struct emv_txn_t* txn = complete_ctx;
+
+	if (r) {
+		emv_debug_trace_msg("emv_ttl_trx_async() failed; r=%d", r);
+		emv_txn_async_next(txn, NULL, 0);
+		return;
+	}
+
+	emv_txn_async_next(txn, txn->r_apdu, txn->r_apdu_len);
+}
+
+int emv_txn_run_async(
+	struct emv_txn_t* txn,
+	emv_txn_complete_t complete,
+	void* complete_ctx
+)
+{
+	if (!txn || !txn->ctx || !complete) {
+		emv_debug_trace_msg("txn=%p, complete=%p", txn, complete);
+		emv_debug_error("Invalid parameter");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+	if (!txn->ctx_ttl || !txn->ctx_ttl->cardreader.submit) {
+		emv_debug_trace_msg("ctx_ttl=%p", txn->ctx_ttl);
+		emv_debug_error("Card reader does not support asynchronous transmission");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+	if (txn->c_apdu_pending) {
+		emv_debug_error("Card exchange already in progress");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	txn->complete = complete;
+	txn->complete_ctx = complete_ctx;
+
+	// Exchanges are counted by the caller's TTL instead
+	txn->stats = NULL;
+
+	emv_txn_async_next(txn, NULL, 0);
+
+	return 0;
+}
+
+int emv_txn_select_app(struct emv_txn_t* txn, unsigned int index)
+{
+	if (!txn || txn->state != EMV_TXN_STATE_APP_SELECTION) {
+		emv_debug_trace_msg("txn=%p, index=%u", txn, index);
+		emv_debug_error("Invalid parameter");
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	txn->app_index = index;
+	txn->app_index_valid = true;
+
+	return 0;
+}
+
+int emv_txn_clear(struct emv_txn_t* txn)
+{
+	if (!txn) {
+		return EMV_ERROR_INVALID_PARAMETER;
+	}
+
+	emv_app_list_clear(&txn->app_list);
+	emv_tlv_list_clear(&txn->list);
+	if (txn->transcript) {
+		crypto_cleanse(txn->transcript, txn->transcript_len);
+		free(txn->transcript);
+	}
+	emv_txn_release(txn);
+	crypto_cleanse(txn, sizeof(*txn));
+
+	return 0;
+}
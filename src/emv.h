@@ -23,19 +23,22 @@
 #define EMV_H
 
 #include "emv_config.h"
+#include "emv_fields.h"
 #include "emv_tlv.h"
+#include "emv_dol.h"
 #include "emv_oda_types.h"
+#include "emv_app.h"
+#include "emv_ttl.h"
 
 #include <sys/cdefs.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 __BEGIN_DECLS
 
 // Forward declarations
-struct emv_ttl_t;
-struct emv_app_list_t;
-struct emv_app_t;
+struct emv_oda_ipk_cache_t;
 
 /**
  * @brief EMV processing context
@@ -57,6 +60,20 @@ struct emv_ctx_t {
 	 */
 	struct emv_ttl_t* ttl;
 
+	/**
+	 * @brief Per-command Terminal Transport Layer (TTL) statistics.
+	 *
+	 * Attached to the TTL context by @ref emv_ctx_init(),
+	 * @ref emv_card_activated() and @ref emv_txn_init() and accumulated
+	 * across transactions. Reset using @ref emv_ttl_stats_reset(). See
+	 * @ref emv_ttl_stats_t.
+	 *
+	 * For @ref emv_txn_step(), each command is counted once when its final
+	 * R-APDU has been provided and the latency excludes the time taken by
+	 * the caller to exchange the C-APDUs.
+	 */
+	struct emv_ttl_stats_t stats;
+
 	/**
 	 * @brief Terminal configuration data.
 	 * @remark See EMV 4.4 Book 4, 10
@@ -87,6 +104,10 @@ struct emv_ctx_t {
 	 * Optional fields are:
 	 * - @ref EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC
 	 * - @ref EMV_TAG_9F04_AMOUNT_OTHER_BINARY
+	 * - @ref EMV_TAG_9F37_UNPREDICTABLE_NUMBER, which replaces the random
+	 *   value generated by @ref emv_initiate_application_processing() and
+	 *   must only be used to replay a recorded transaction. See
+	 *   @ref emv_transcript_replayer_load_terminal_data().
 	 */
 	struct emv_tlv_list_t params;
 
@@ -117,6 +138,37 @@ struct emv_ctx_t {
 	 */
 	struct emv_tlv_list_t terminal;
 
+	/**
+	 * @brief Per-transaction arena for ICC data, terminal data and
+	 * transaction parameters.
+	 *
+	 * Optionally initialised by @ref emv_ctx_arena_init() and released in a
+	 * single step by @ref emv_ctx_reset().
+	 */
+	struct emv_tlv_arena_t arena;
+
+	/**
+	 * @brief Merged tag index for the data sources used by Data Object List
+	 * (DOL) processing.
+	 *
+	 * Rebuilt lazily whenever the transaction data changes and released by
+	 * @ref emv_ctx_clear().
+	 * @cond INTERNAL
+	 */
+	struct emv_tlv_sources_index_t sources_index;
+	/// @endcond
+
+	/**
+	 * @brief Compiled Data Object List (DOL) plans for PDOL, CDOL1 and DDOL
+	 * processing.
+	 *
+	 * Retained across transactions by @ref emv_ctx_reset() and released by
+	 * @ref emv_ctx_clear().
+	 * @cond INTERNAL
+	 */
+	struct emv_dol_cache_t dol_cache;
+	/// @endcond
+
 	/**
 	 * @brief Offline Data Authentication (ODA) context.
 	 *
@@ -126,6 +178,26 @@ struct emv_ctx_t {
 	 */
 	struct emv_oda_ctx_t oda;
 
+	/**
+	 * @brief Optional issuer public key cache used by Offline Data
+	 * Authentication (ODA).
+	 *
+	 * Owned by the caller and may be populated after @ref emv_ctx_init() to
+	 * reuse issuer public keys across transactions. NULL to disable. See
+	 * @ref emv_oda_ipk_cache_t.
+	 */
+	struct emv_oda_ipk_cache_t* ipk_cache;
+
+	/**
+	 * @brief Recover the issuer public key on a worker thread while
+	 * application records are still being read.
+	 *
+	 * Optionally set by the caller after @ref emv_ctx_init() and used by
+	 * @ref emv_read_application_data(). Ignored if the library was built
+	 * without thread support. See @ref emv_oda_enable_pipeline().
+	 */
+	bool oda_pipeline;
+
 	/**
 	 * @brief Various cached fields for internal use
 	 *
@@ -192,6 +264,30 @@ const char* emv_lib_version_string(void);
  */
 int emv_ctx_init(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl);
 
+/**
+ * Initialise per-transaction arena for EMV processing context.
+ *
+ * When enabled, all fields pushed to these context members will be allocated
+ * from @ref emv_ctx_t.arena instead of individual heap allocations:
+ * - @ref emv_ctx_t.params
+ * - @ref emv_ctx_t.icc
+ * - @ref emv_ctx_t.terminal
+ *
+ * The arena is rewound by @ref emv_ctx_reset() such that its memory is reused
+ * for the next transaction, and released by @ref emv_ctx_clear().
+ *
+ * @note This function must be called after @ref emv_ctx_init() and before
+ *       populating @ref emv_ctx_t.params
+ *
+ * @param ctx EMV processing context
+ * @param block_size Minimum size of arena blocks in bytes. Use zero for
+ *                   @ref EMV_TLV_ARENA_BLOCK_SIZE_DEFAULT.
+ *
+ * @return Zero for success
+ * @return Less than zero for errors. See @ref emv_error_t
+ */
+int emv_ctx_arena_init(struct emv_ctx_t* ctx, size_t block_size);
+
 /**
  * Reset EMV processing context for next transaction.
  *
@@ -200,6 +296,9 @@ int emv_ctx_init(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl);
  * - @ref emv_ctx_t.icc
  * - @ref emv_ctx_t.terminal
  *
+ * If @ref emv_ctx_arena_init() was used, this function will also rewind
+ * @ref emv_ctx_t.arena while retaining its memory for the next transaction.
+ *
  * And this function will preserve these members that can be reused for the
  * next transaction:
  * - @ref emv_ctx_t.ttl
@@ -269,6 +368,34 @@ int emv_atr_parse(const void* atr, size_t atr_len);
  */
 int emv_card_activated(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl);
 
+/**
+ * Indicate that EMV card has been presented to reader and select the
+ * transmission protocol indicated by the ISO 7816 Answer To Reset (ATR). For
+ * card readers in TPDU mode, this selects protocol T=0 or T=1 and negotiates
+ * the protocol T=1 IFSD before any other command is exchanged. For card
+ * readers in APDU mode, this is equivalent to @ref emv_card_activated().
+ *
+ * @note Use @ref emv_atr_parse() beforehand to determine whether the card is
+ *       suitable for EMV processing.
+ * @note Card reader transcript recording should start before this function
+ *       is called such that the protocol T=1 IFSD negotiation is recorded.
+ *
+ * @param ctx EMV processing context
+ * @param ttl Terminal Transport Layer (TTL) context
+ * @param atr ATR data
+ * @param atr_len Length of ATR data
+ *
+ * @return Zero for success
+ * @return Less than zero for errors. See @ref emv_error_t
+ * @return Greater than zero for EMV processing outcome. See @ref emv_outcome_t
+ */
+int emv_card_activated_atr(
+	struct emv_ctx_t* ctx,
+	struct emv_ttl_t* ttl,
+	const void* atr,
+	size_t atr_len
+);
+
 /**
  * Build candidate application list using Payment System Environment (PSE) or
  * discovery of supported AIDs, and then sort according to Application Priority
@@ -470,6 +597,239 @@ int emv_terminal_risk_management(struct emv_ctx_t* ctx,
  */
 int emv_card_action_analysis(struct emv_ctx_t* ctx);
 
+/**
+ * EMV transaction step events
+ */
+enum emv_txn_event_t {
+	EMV_TXN_EVENT_CAPDU = 1, ///< Transmit @ref emv_txn_t.c_apdu and provide the R-APDU to the next @ref emv_txn_step()
+	EMV_TXN_EVENT_APP_SELECTION, ///< Cardholder selection from @ref emv_txn_t.app_list is required. See @ref emv_txn_select_app()
+	EMV_TXN_EVENT_DONE, ///< Card action analysis is complete and the GENAC1 response is available in @ref emv_ctx_t.icc
+};
+
+/**
+ * Resumable EMV transaction completion function type for
+ * @ref emv_txn_run_async()
+ *
+ * @param complete_ctx Completion context provided to @ref emv_txn_run_async()
+ * @param r Same as return value of @ref emv_txn_step()
+ * @param event Transaction event when @p r is zero. Either
+ *              @ref EMV_TXN_EVENT_APP_SELECTION or @ref EMV_TXN_EVENT_DONE.
+ */
+typedef void (*emv_txn_complete_t)(
+	void* complete_ctx,
+	int r,
+	enum emv_txn_event_t event
+);
+
+/**
+ * @brief Resumable EMV transaction
+ *
+ * Performs the same processing as @ref emv_build_candidate_list(),
+ * @ref emv_select_application(), @ref emv_initiate_application_processing(),
+ * @ref emv_read_application_data(), @ref emv_offline_data_authentication(),
+ * @ref emv_processing_restrictions(), @ref emv_terminal_risk_management()
+ * and @ref emv_card_action_analysis() without blocking on the card reader.
+ * Instead @ref emv_txn_step() returns whenever a C-APDU must be exchanged
+ * with the card, such that many transactions can be interleaved by a single
+ * thread. Alternatively, @ref emv_txn_run_async() exchanges the C-APDUs using
+ * the asynchronous card reader interface of the EMV processing context's TTL.
+ *
+ * Initialise using @ref emv_txn_init() and clear using @ref emv_txn_clear().
+ */
+struct emv_txn_t {
+	/**
+	 * @brief Candidate application list.
+	 *
+	 * Populated before @ref EMV_TXN_EVENT_APP_SELECTION and cleared once
+	 * application processing has been initiated.
+	 */
+	struct emv_app_list_t app_list;
+
+	/**
+	 * @brief Command Application Protocol Data Unit (C-APDU) to transmit
+	 * for @ref EMV_TXN_EVENT_CAPDU.
+	 */
+	uint8_t c_apdu[EMV_CAPDU_MAX];
+
+	/// Length of @ref emv_txn_t.c_apdu in bytes
+	size_t c_apdu_len;
+
+	/**
+	 * @brief Previous transactions for terminal risk management.
+	 *
+	 * Optionally set after @ref emv_txn_init(). See
+	 * @ref emv_terminal_risk_management(). NULL to ignore.
+	 */
+	const struct emv_txn_log_entry_t* txn_log;
+
+	/// Number of transaction entries in @ref emv_txn_t.txn_log
+	size_t txn_log_cnt;
+
+	/// @cond INTERNAL
+	struct emv_ctx_t* ctx;
+	struct emv_ttl_t* ctx_ttl;
+	struct emv_ttl_t ttl;
+	struct emv_ttl_stats_t* stats;
+	uint8_t pos_entry_mode;
+	int state;
+	int outcome;
+	bool app_index_valid;
+	unsigned int app_index;
+	bool c_apdu_pending;
+	bool replay_mismatch;
+	uint8_t* transcript;
+	size_t transcript_len;
+	size_t transcript_size;
+	size_t replay_offset;
+	uint8_t aid[16];
+	size_t aid_len;
+	uint8_t dol_data[EMV_CAPDU_DATA_MAX];
+	size_t dol_data_len;
+	struct emv_tlv_list_t list;
+	uint8_t pse_fci[EMV_RAPDU_DATA_MAX];
+	size_t pse_fci_len;
+	uint8_t pse_sfi;
+	uint8_t record_number;
+	struct emv_config_app_itr_t config_app_itr;
+	const struct emv_config_app_t* config_app;
+	bool select_next;
+	struct emv_afl_itr_t afl_itr;
+	struct emv_afl_entry_t afl_entry;
+	bool oda_record_invalid;
+	bool oda_records_invalid;
+	bool velocity_checking;
+	uint8_t genac_ref_ctrl;
+	struct emv_ttl_trx_state_t trx_state;
+	uint8_t r_apdu[EMV_RAPDU_MAX];
+	size_t r_apdu_len;
+	uint16_t sw1sw2;
+	emv_txn_complete_t complete;
+	void* complete_ctx;
+	/// @endcond
+};
+
+/**
+ * Initialise resumable EMV transaction.
+ *
+ * @note The EMV processing context must be prepared as for
+ *       @ref emv_build_candidate_list() and the subsequent processing
+ *       functions listed for @ref emv_txn_t, and must remain valid until
+ *       @ref emv_txn_clear(). This function replaces @ref emv_ctx_t.ttl with
+ *       the transaction's own Terminal Transport Layer (TTL) context, which
+ *       operates in APDU mode, and therefore the transaction must not be
+ *       moved in memory while in use. The previous @ref emv_ctx_t.ttl is
+ *       restored when @ref emv_txn_step() reports @ref EMV_TXN_EVENT_DONE,
+ *       an error or an outcome, or by @ref emv_txn_clear().
+ *
+ * @param txn Resumable EMV transaction
+ * @param ctx EMV processing context
+ * @param pos_entry_mode Point-of-Service (POS) Entry Mode (field 9F39) value.
+ *                       See @ref pos-entry-mode-values "values".
+ *
+ * @return Zero for success
+ * @return Less than zero for errors. See @ref emv_error_t
+ */
+int emv_txn_init(
+	struct emv_txn_t* txn,
+	struct emv_ctx_t* ctx,
+	uint8_t pos_entry_mode
+);
+
+/**
+ * Advance resumable EMV transaction until the next event.
+ *
+ * For the first step, and after @ref emv_txn_select_app(), provide no R-APDU.
+ * After @ref EMV_TXN_EVENT_CAPDU, provide the complete R-APDU, including
+ * status bytes SW1-SW2, received for @ref emv_txn_t.c_apdu. Responses
+ * requiring GET RESPONSE are handled by subsequent C-APDUs. If the card
+ * reader failed to exchange the C-APDU, provide no R-APDU and the failure
+ * will be processed in the same manner as a card reader failure during
+ * blocking processing.
+ *
+ * @note Progress within each stage, such as the current AFL entry, record
+ *       number and the fields read so far, is retained by the transaction
+ *       and each step therefore only resumes the current command. Only the
+ *       preceding exchanges of the current command, for example those
+ *       leading to GET RESPONSE, are replayed. Debug events and TTL
+ *       statistics are not repeated for replayed exchanges and debug
+ *       suppression is always released before this function returns.
+ *
+ * @param txn Resumable EMV transaction
+ * @param r_apdu Response Application Protocol Data Unit (R-APDU). NULL if not
+ *               applicable.
+ * @param r_apdu_len Length of R-APDU in bytes. Zero if not applicable.
+ * @param event Transaction event output
+ *
+ * @return Zero for success and @p event indicates the next action
+ * @return Less than zero for errors. See @ref emv_error_t
+ * @return Greater than zero for EMV processing outcome. See @ref emv_outcome_t
+ */
+int emv_txn_step(
+	struct emv_txn_t* txn,
+	const void* r_apdu,
+	size_t r_apdu_len,
+	enum emv_txn_event_t* event
+);
+
+/**
+ * Advance resumable EMV transaction asynchronously until the next event other
+ * than @ref EMV_TXN_EVENT_CAPDU.
+ *
+ * Each C-APDU is exchanged using @ref emv_ttl_trx_async() on the TTL that
+ * was provided by the EMV processing context to @ref emv_txn_init(), and
+ * each completion is provided to the next @ref emv_txn_step(). The card
+ * reader's event loop therefore drives the transaction and many
+ * transactions, each with its own card reader, can be multiplexed on a
+ * single thread. After @ref EMV_TXN_EVENT_APP_SELECTION, use
+ * @ref emv_txn_select_app() and call this function again to continue.
+ *
+ * @note The completion function is invoked exactly once for each successful
+ *       call of this function, either from the card reader's completion
+ *       function or, if no card exchange is required, before this function
+ *       returns. Exchanges are counted by the statistics of the card reader's
+ *       TTL instead of those of the transaction. Do not use
+ *       @ref emv_txn_step() or @ref emv_txn_clear() until the completion
+ *       function has been invoked.
+ *
+ * @param txn Resumable EMV transaction
+ * @param complete Completion function
+ * @param complete_ctx Completion function context
+ *
+ * @return Zero if started and @p complete will be invoked
+ * @return Less than zero for errors. See @ref emv_error_t
+ */
+int emv_txn_run_async(
+	struct emv_txn_t* txn,
+	emv_txn_complete_t complete,
+	void* complete_ctx
+);
+
+/**
+ * Provide cardholder application selection after
+ * @ref EMV_TXN_EVENT_APP_SELECTION. Thereafter continue with
+ * @ref emv_txn_step().
+ *
+ * @param txn Resumable EMV transaction
+ * @param index Index (starting from zero) of EMV application in
+ *              @ref emv_txn_t.app_list to select
+ *
+ * @return Zero for success
+ * @return Less than zero for errors. See @ref emv_error_t
+ */
+int emv_txn_select_app(struct emv_txn_t* txn, unsigned int index);
+
+/**
+ * Clear resumable EMV transaction. This will not clear the EMV processing
+ * context, but will restore the previous @ref emv_ctx_t.ttl if it is still
+ * replaced by the transaction.
+ *
+ * @param txn Resumable EMV transaction
+ *
+ * @return Zero for success
+ * @return Less than zero for errors. See @ref emv_error_t
+ */
+int emv_txn_clear(struct emv_txn_t* txn);
+
 __END_DECLS
 
 #endif
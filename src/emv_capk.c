@@ -21,6 +21,7 @@
 
 #include "emv_capk.h"
 #include "emv_capk_static_data.h"
+#include "emv_utils_config.h"
 
 #include "crypto_sha.h"
 #include "crypto_mem.h"
@@ -30,16 +31,54 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
-static bool static_enabled = false;
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
+// Dynamic CAPK list entry. Entries are reference counted because the list is
+// shared by the writer and by each snapshot that was published while the
+// entry was part of the list. Each entry holds a reference to the next entry.
 struct emv_capk_list_entry_t {
 	struct emv_capk_t capk;
 	struct emv_capk_list_entry_t* next;
+	atomic_uint refs;
 	uint8_t data[]; // RID | modulus | exponent | hash
 };
+
+// Immutable snapshot of the CAPK store that is published by writers and
+// consumed by readers. The table indexes dynamic CAPKs, in list order, before
+// built-in CAPKs such that the first match in the probe sequence has the
+// highest priority. The snapshot holds a reference to the dynamic CAPK list
+// such that the entries remain valid for as long as the snapshot is in use,
+// and the snapshot is released when the last reference to it is released.
+struct emv_capk_snapshot_t {
+	atomic_uint refs;
+	struct emv_capk_list_entry_t* list;
+	bool static_enabled;
+	size_t table_mask;
+	const struct emv_capk_t* table[];
+};
+
+// Writer state. Only modified by emv_capk_load_static(), emv_capk_add() and
+// emv_capk_clear() which must not be called concurrently with each other.
+static bool static_enabled = false;
 static struct emv_capk_list_entry_t* dynamic_list = NULL;
 
+// Current snapshot. Holds a reference to the snapshot. The lock only protects
+// loading the current snapshot and acquiring a reference to it, such that
+// neither readers nor writers need to wait for each other beyond that.
+static struct emv_capk_snapshot_t* current_snapshot = NULL;
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t current_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// CAPK store generation. Incremented after each snapshot is published such
+// that a reader that observed a generation before acquiring a snapshot never
+// uses a snapshot that is older than that generation.
+static atomic_uint_least64_t current_generation = 0;
+
 static int emv_capk_validate(const struct emv_capk_t* capk)
 {
 	int r;
@@ -85,6 +124,142 @@ static int emv_capk_validate(const struct emv_capk_t* capk)
 	return r;
 }
 
+static size_t emv_capk_hash(const uint8_t* rid, uint8_t index)
+{
+	// FNV-1a hash of RID and index
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < EMV_CAPK_RID_LEN; ++i) {
+		hash ^= rid[i];
+		hash *= 16777619U;
+	}
+	hash ^= index;
+	hash *= 16777619U;
+
+	return hash;
+}
+
+static void emv_capk_snapshot_insert(
+	struct emv_capk_snapshot_t* snapshot,
+	const struct emv_capk_t* capk
+)
+{
+	size_t i = emv_capk_hash(capk->rid, capk->index) & snapshot->table_mask;
+
+	while (snapshot->table[i]) {
+		i = (i + 1) & snapshot->table_mask;
+	}
+	snapshot->table[i] = capk;
+}
+
+static void emv_capk_entry_release(struct emv_capk_list_entry_t* entry)
+{
+	// Release entry and each subsequent entry that is no longer referenced
+	while (entry && atomic_fetch_sub(&entry->refs, 1) == 1) {
+		struct emv_capk_list_entry_t* next = entry->next;
+		free(entry);
+		entry = next;
+	}
+}
+
+static struct emv_capk_snapshot_t* emv_capk_snapshot_acquire(void)
+{
+	struct emv_capk_snapshot_t* snapshot;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&current_snapshot_lock);
+#endif
+	snapshot = current_snapshot;
+	if (snapshot) {
+		atomic_fetch_add(&snapshot->refs, 1);
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&current_snapshot_lock);
+#endif
+
+	return snapshot;
+}
+
+static void emv_capk_snapshot_release(struct emv_capk_snapshot_t* snapshot)
+{
+	if (!snapshot) {
+		return;
+	}
+
+	// The last reference to be released, whether by a reader or by the
+	// writer, releases the snapshot and its reference to the dynamic list
+	if (atomic_fetch_sub(&snapshot->refs, 1) == 1) {
+		emv_capk_entry_release(snapshot->list);
+		free(snapshot);
+	}
+}
+
+static void emv_capk_snapshot_publish(struct emv_capk_snapshot_t* snapshot)
+{
+	struct emv_capk_snapshot_t* old_snapshot;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&current_snapshot_lock);
+#endif
+	old_snapshot = current_snapshot;
+	current_snapshot = snapshot;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&current_snapshot_lock);
+#endif
+	atomic_fetch_add(&current_generation, 1);
+
+	// Readers that still use the previous snapshot hold their own reference
+	// and the previous snapshot is only released after they are done
+	emv_capk_snapshot_release(old_snapshot);
+}
+
+static int emv_capk_snapshot_update(void)
+{
+	size_t count = 0;
+	size_t table_size = 8;
+	struct emv_capk_snapshot_t* snapshot;
+
+	for (struct emv_capk_list_entry_t* entry = dynamic_list; entry != NULL; entry = entry->next) {
+		++count;
+	}
+	if (static_enabled) {
+		count += sizeof(capk_list) / sizeof(capk_list[0]);
+	}
+	if (!count) {
+		emv_capk_snapshot_publish(NULL);
+		return 0;
+	}
+
+	// Keep load factor at or below 50%
+	while (table_size < count * 2) {
+		table_size <<= 1;
+	}
+
+	snapshot = calloc(1, sizeof(*snapshot) + table_size * sizeof(snapshot->table[0]));
+	if (!snapshot) {
+		return -2;
+	}
+	atomic_init(&snapshot->refs, 1); // Reference held by current_snapshot
+	snapshot->list = dynamic_list;
+	if (snapshot->list) {
+		atomic_fetch_add(&snapshot->list->refs, 1);
+	}
+	snapshot->static_enabled = static_enabled;
+	snapshot->table_mask = table_size - 1;
+
+	for (struct emv_capk_list_entry_t* entry = dynamic_list; entry != NULL; entry = entry->next) {
+		emv_capk_snapshot_insert(snapshot, &entry->capk);
+	}
+	if (static_enabled) {
+		for (size_t i = 0; i < sizeof(capk_list) / sizeof(capk_list[0]); ++i) {
+			emv_capk_snapshot_insert(snapshot, &capk_list[i]);
+		}
+	}
+
+	emv_capk_snapshot_publish(snapshot);
+	return 0;
+}
+
 int emv_capk_load_static(void)
 {
 	int r;
@@ -98,6 +273,12 @@ int emv_capk_load_static(void)
 	}
 
 	static_enabled = true;
+	r = emv_capk_snapshot_update();
+	if (r) {
+		static_enabled = false;
+		return r;
+	}
+
 	return 0;
 }
 
@@ -151,72 +332,161 @@ int emv_capk_add(const struct emv_capk_t* capk)
 	entry->capk.index = capk->index;
 	entry->capk.hash_id = capk->hash_id;
 
+	// Reference held by dynamic_list and the reference to the previous list
+	// head is transferred to the new entry
+	atomic_init(&entry->refs, 1);
 	entry->next = dynamic_list;
 	dynamic_list = entry;
 
+	r = emv_capk_snapshot_update();
+	if (r) {
+		dynamic_list = entry->next;
+		free(entry);
+		return r;
+	}
+
 	return 0;
 }
 
 void emv_capk_clear(void)
 {
-	while (dynamic_list) {
-		struct emv_capk_list_entry_t* entry = dynamic_list;
-		dynamic_list = entry->next;
-		free(entry);
-	}
+	struct emv_capk_list_entry_t* list = dynamic_list;
 
+	dynamic_list = NULL;
 	static_enabled = false;
+	emv_capk_snapshot_publish(NULL);
+
+	// Entries are only released after snapshots that are still in use by
+	// readers are released as well
+	emv_capk_entry_release(list);
 }
 
-const struct emv_capk_t* emv_capk_lookup(const uint8_t* rid, uint8_t index)
+uint64_t emv_capk_get_generation(void)
+{
+	return atomic_load(&current_generation);
+}
+
+static bool emv_capk_is_static(const struct emv_capk_t* capk)
+{
+	return capk >= &capk_list[0] &&
+		capk < &capk_list[sizeof(capk_list) / sizeof(capk_list[0])];
+}
+
+static const struct emv_capk_t* emv_capk_snapshot_lookup(
+	const struct emv_capk_snapshot_t* snapshot,
+	const uint8_t* rid,
+	uint8_t index
+)
 {
 	int r;
 
-	// Search dynamic CAPK list
-	for (struct emv_capk_list_entry_t* entry = dynamic_list; entry != NULL; entry = entry->next) {
-		if (index == entry->capk.index &&
-			memcmp(rid, entry->capk.rid, EMV_CAPK_RID_LEN) == 0
+	for (size_t i = emv_capk_hash(rid, index) & snapshot->table_mask;
+		snapshot->table[i] != NULL;
+		i = (i + 1) & snapshot->table_mask
+	) {
+		const struct emv_capk_t* capk = snapshot->table[i];
+
+		if (index == capk->index &&
+			memcmp(rid, capk->rid, EMV_CAPK_RID_LEN) == 0
 		) {
-			r = emv_capk_validate(&entry->capk);
+			r = emv_capk_validate(capk);
 			if (r) {
+				if (emv_capk_is_static(capk)) {
+					// Built-in CAPKs are only probed after all dynamic CAPKs
+					// with the same RID and index, and an invalid built-in
+					// CAPK ends the lookup
+					return NULL;
+				}
+
+				// Try next dynamic CAPK
 				continue;
 			}
-			return &entry->capk;
+			return capk;
 		}
 	}
 
-	if (!static_enabled) {
+	return NULL;
+}
+
+const struct emv_capk_t* emv_capk_lookup(const uint8_t* rid, uint8_t index)
+{
+	struct emv_capk_snapshot_t* snapshot;
+	const struct emv_capk_t* capk;
+
+	snapshot = emv_capk_snapshot_acquire();
+	if (!snapshot) {
 		return NULL;
 	}
+	capk = emv_capk_snapshot_lookup(snapshot, rid, index);
+	emv_capk_snapshot_release(snapshot);
 
-	// Search static CAPK list
-	for (size_t i = 0; i < sizeof(capk_list) / sizeof(capk_list[0]); ++i) {
-		if (index == capk_list[i].index &&
-			memcmp(rid, capk_list[i].rid, EMV_CAPK_RID_LEN) == 0
-		) {
-			const struct emv_capk_t* capk = &capk_list[i];
+	return capk;
+}
 
-			r = emv_capk_validate(capk);
-			if (r) {
-				return NULL;
-			}
+const struct emv_capk_t* emv_capk_acquire(
+	const uint8_t* rid,
+	uint8_t index,
+	struct emv_capk_ref_t* ref
+)
+{
+	struct emv_capk_snapshot_t* snapshot;
+	const struct emv_capk_t* capk;
 
-			return capk;
-		}
+	if (!ref) {
+		return NULL;
 	}
+	ref->snapshot = NULL;
 
-	return NULL;
+	if (!rid) {
+		return NULL;
+	}
+
+	snapshot = emv_capk_snapshot_acquire();
+	if (!snapshot) {
+		return NULL;
+	}
+	capk = emv_capk_snapshot_lookup(snapshot, rid, index);
+	if (!capk) {
+		emv_capk_snapshot_release(snapshot);
+		return NULL;
+	}
+
+	// Retain snapshot until caller releases the reference
+	ref->snapshot = snapshot;
+	return capk;
+}
+
+void emv_capk_release(struct emv_capk_ref_t* ref)
+{
+	if (!ref) {
+		return;
+	}
+
+	emv_capk_snapshot_release(ref->snapshot);
+	ref->snapshot = NULL;
 }
 
 int emv_capk_itr_init(struct emv_capk_itr_t* itr)
 {
+	struct emv_capk_snapshot_t* snapshot;
+
 	if (!itr) {
 		return -1;
 	}
 
+	// Retain snapshot until the iterator reaches the end of the list or is
+	// released by emv_capk_itr_release()
 	memset(itr, 0, sizeof(*itr));
-	itr->entry = dynamic_list;
-	itr->idx = 0;
+	snapshot = emv_capk_snapshot_acquire();
+	if (snapshot) {
+		itr->snapshot = snapshot;
+		itr->entry = snapshot->list;
+		itr->idx = snapshot->static_enabled ? 0 : sizeof(capk_list) / sizeof(capk_list[0]);
+	} else {
+		itr->entry = NULL;
+		itr->idx = sizeof(capk_list) / sizeof(capk_list[0]);
+	}
+
 	return 0;
 }
 
@@ -243,10 +513,6 @@ const struct emv_capk_t* emv_capk_itr_next(struct emv_capk_itr_t* itr)
 		return &entry->capk;
 	}
 
-	if (!static_enabled) {
-		return NULL;
-	}
-
 	// Iterate static CAPK list
 	while (itr->idx < sizeof(capk_list) / sizeof(capk_list[0])) {
 		const struct emv_capk_t* capk = &capk_list[itr->idx];
@@ -262,5 +528,19 @@ const struct emv_capk_t* emv_capk_itr_next(struct emv_capk_itr_t* itr)
 		return capk;
 	}
 
+	// End of list
+	emv_capk_itr_release(itr);
 	return NULL;
 }
+
+void emv_capk_itr_release(struct emv_capk_itr_t* itr)
+{
+	if (!itr) {
+		return;
+	}
+
+	emv_capk_snapshot_release(itr->snapshot);
+	itr->snapshot = NULL;
+	itr->entry = NULL;
+	itr->idx = sizeof(capk_list) / sizeof(capk_list[0]);
+}
@@ -51,12 +51,33 @@ struct emv_capk_t {
  * Certificate Authority Public Key (CAPK) iterator.
  * Iterates CAPKs added by @ref emv_capk_add() before built-in CAPKs loaded by
  * @ref emv_capk_load_static().
+ *
+ * @note The CAPK store is indexed by RID and CAPK index and is published as an
+ *       immutable, reference counted snapshot such that @ref emv_capk_acquire()
+ *       and the iterator functions may be used concurrently with
+ *       @ref emv_capk_load_static(), @ref emv_capk_add() and
+ *       @ref emv_capk_clear(). The iterator retains its snapshot until it
+ *       reaches the end of the list or is released using
+ *       @ref emv_capk_itr_release(). These update functions must not be called
+ *       concurrently with each other, for example by only calling them from a
+ *       single management thread.
  */
 struct emv_capk_itr_t {
+	void* snapshot; ///< Retained CAPK store snapshot
 	void* entry; ///< Current dynamic CAPK list entry
 	unsigned int idx; ///< Current static CAPK list index
 };
 
+/**
+ * Reference to Certificate Authority Public Key (CAPK) obtained using
+ * @ref emv_capk_acquire(). The CAPK remains valid, even if the CAPK store is
+ * updated or cleared, until the reference is released using
+ * @ref emv_capk_release().
+ */
+struct emv_capk_ref_t {
+	void* snapshot; ///< Retained CAPK store snapshot. NULL if none.
+};
+
 /**
  * Load built-in Certificate Authority Public Key (CAPK) data and validate
  * integrity.
@@ -76,14 +97,36 @@ int emv_capk_load_static(void);
 int emv_capk_add(const struct emv_capk_t* capk);
 
 /**
- * Clear all Certificate Authority Public Keys (CAPKs) data
+ * Clear all Certificate Authority Public Keys (CAPKs) data. CAPKs previously
+ * added by @ref emv_capk_add() are only released once all references obtained
+ * using @ref emv_capk_acquire() and all iterators that were initialised before
+ * this function was called have been released. CAPK pointers previously
+ * retrieved by @ref emv_capk_lookup() must no longer be in use.
  */
 void emv_capk_clear(void);
 
+/**
+ * Retrieve Certificate Authority Public Key (CAPK) store generation. The
+ * generation changes whenever the CAPK store is updated by
+ * @ref emv_capk_load_static(), @ref emv_capk_add() or @ref emv_capk_clear(),
+ * such that outcomes that depend on the CAPK store can be cached.
+ *
+ * @note A CAPK that is retrieved after this function returns is never older
+ *       than the returned generation, but may be newer.
+ *
+ * @return CAPK store generation
+ */
+uint64_t emv_capk_get_generation(void);
+
 /**
  * Lookup Certificate Authority Public Key (CAPK). This function searches
  * CAPKs added by @ref emv_capk_add() before built-in CAPKs loaded by
- * @ref emv_capk_load_static().
+ * @ref emv_capk_load_static(). This function does not depend on the number of
+ * CAPKs.
+ *
+ * @note The CAPK is only valid until the next call to @ref emv_capk_clear().
+ *       Use @ref emv_capk_acquire() if the CAPK store may be cleared while the
+ *       CAPK is in use, for example by another thread.
  *
  * @param rid Registered Application Provider Identifier (RID). Must be 5 bytes.
  * @param index Index of Certificate Authority Public Key (CAPK)
@@ -92,6 +135,32 @@ void emv_capk_clear(void);
  */
 const struct emv_capk_t* emv_capk_lookup(const uint8_t* rid, uint8_t index);
 
+/**
+ * Lookup Certificate Authority Public Key (CAPK) and retain it until the
+ * reference is released using @ref emv_capk_release(). This function searches
+ * in the same order as @ref emv_capk_lookup().
+ *
+ * @param rid Registered Application Provider Identifier (RID). Must be 5 bytes.
+ * @param index Index of Certificate Authority Public Key (CAPK)
+ * @param ref CAPK reference output. Must be released using
+ *            @ref emv_capk_release(), also if the CAPK is not found.
+ * @return Pointer to Certificate Authority Public Key (CAPK). Do NOT free.
+ *         NULL if not found or invalid.
+ */
+const struct emv_capk_t* emv_capk_acquire(
+	const uint8_t* rid,
+	uint8_t index,
+	struct emv_capk_ref_t* ref
+);
+
+/**
+ * Release Certificate Authority Public Key (CAPK) reference obtained using
+ * @ref emv_capk_acquire(). The CAPK must no longer be used afterwards.
+ *
+ * @param ref CAPK reference
+ */
+void emv_capk_release(struct emv_capk_ref_t* ref);
+
 /**
  * Initialise Certificate Authority Public Key (CAPK) iterator
  *
@@ -103,14 +172,25 @@ int emv_capk_itr_init(struct emv_capk_itr_t* itr);
 /**
  * Retrieve next Certificate Authority Public Key (CAPK) and advance iterator.
  * This function iterates CAPKs added by @ref emv_capk_add() before built-in
- * CAPKs loaded by @ref emv_capk_load_static().
+ * CAPKs loaded by @ref emv_capk_load_static(). The iterator is released
+ * automatically when the end of the list is reached.
  *
  * @param itr Certificate Authority Public Key (CAPK) iterator
  * @return Pointer to Certificate Authority Public Key (CAPK). Do NOT free.
- *         NULL for end of list.
+ *         Only valid until the iterator is released. NULL for end of list.
  */
 const struct emv_capk_t* emv_capk_itr_next(struct emv_capk_itr_t* itr);
 
+/**
+ * Release Certificate Authority Public Key (CAPK) iterator before reaching the
+ * end of the list. CAPKs retrieved using the iterator must no longer be used
+ * afterwards. It is safe to call this function after the end of the list was
+ * reached.
+ *
+ * @param itr Certificate Authority Public Key (CAPK) iterator
+ */
+void emv_capk_itr_release(struct emv_capk_itr_t* itr);
+
 __END_DECLS
 
 #endif
@@ -2,7 +2,7 @@
  * @file emv_debug.c
  * @brief EMV debug implementation
  *
- * Copyright 2021, 2024-2025 Leon Lynch
+ * Copyright 2021, 2024-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -27,14 +27,607 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#endif
+
 // TODO: replace with HAL interface in future
 #ifdef HAVE_TIME_H
 #include <time.h>
 #endif
 
-static unsigned int debug_sources_mask = EMV_DEBUG_SOURCE_NONE;
-static enum emv_debug_level_t debug_level = EMV_DEBUG_LEVEL_NONE;
-static emv_debug_func_t debug_func = NULL;
+static struct emv_debug_config_t debug_config = { EMV_DEBUG_SOURCE_NONE, EMV_DEBUG_LEVEL_NONE, NULL, NULL };
+static _Thread_local struct emv_debug_config_t debug_thread_config;
+static _Thread_local bool debug_thread_config_valid = false;
+static _Thread_local void* debug_user_data = NULL;
+static _Thread_local bool debug_suppressed = false;
+
+#ifdef HAVE_PTHREAD
+
+// Maximum number of format arguments recorded per asynchronous debug event
+#define EMV_DEBUG_ASYNC_ARGS_MAX (8)
+
+// Maximum length of binary data and string arguments recorded per
+// asynchronous debug event
+#define EMV_DEBUG_ASYNC_DATA_MAX (512)
+
+// Maximum length of a single conversion specification
+#define EMV_DEBUG_ASYNC_SPEC_MAX (16)
+
+// Debug event argument types for deferred formatting
+enum emv_debug_arg_type_t {
+	EMV_DEBUG_ARG_NONE = 0, // Conversion specification without argument
+	EMV_DEBUG_ARG_INT,
+	EMV_DEBUG_ARG_LONG,
+	EMV_DEBUG_ARG_LLONG,
+	EMV_DEBUG_ARG_SIZE,
+	EMV_DEBUG_ARG_INTMAX,
+	EMV_DEBUG_ARG_PTRDIFF,
+	EMV_DEBUG_ARG_DOUBLE,
+	EMV_DEBUG_ARG_LDOUBLE,
+	EMV_DEBUG_ARG_PTR,
+	EMV_DEBUG_ARG_STR,
+};
+
+struct emv_debug_arg_t {
+	enum emv_debug_arg_type_t type;
+	union {
+		int i;
+		long l;
+		long long ll;
+		size_t z;
+		intmax_t j;
+		ptrdiff_t t;
+		double d;
+		long double ld;
+		const void* p;
+		size_t str_offset; // Offset of string in event data, or SIZE_MAX for NULL
+	} value;
+};
+
+struct emv_debug_event_t {
+	atomic_size_t seq;
+	uint32_t timestamp;
+	enum emv_debug_source_t source;
+	enum emv_debug_level_t level;
+	enum emv_debug_type_t debug_type;
+	emv_debug_func_t func;
+	void* user_data;
+	const char* fmt; // NULL if already formatted
+	size_t str_offset; // Offset of formatted string in event data if fmt is NULL
+	bool has_buf;
+	size_t buf_len;
+	unsigned int arg_count;
+	struct emv_debug_arg_t args[EMV_DEBUG_ASYNC_ARGS_MAX];
+	uint8_t data[EMV_DEBUG_ASYNC_DATA_MAX];
+};
+
+struct emv_debug_async_t {
+	struct emv_debug_event_t* slots;
+	size_t mask;
+	atomic_size_t enqueue_pos;
+	atomic_size_t dequeue_pos;
+	atomic_ulong dropped_count;
+	atomic_bool running;
+	pthread_t thread;
+};
+
+static struct emv_debug_async_t* _Atomic debug_async = NULL;
+
+// Number of threads that may be using the current ring buffer. This allows
+// emv_debug_async_stop() to wait for producers before releasing it.
+static atomic_uint debug_async_users = 0;
+
+#endif // HAVE_PTHREAD
+
+static uint32_t emv_debug_timestamp(void)
+{
+	struct timespec t;
+
+	// TODO: replace with HAL interface in future
+#if defined(HAVE_TIMESPEC_GET)
+	timespec_get(&t, TIME_UTC);
+#elif defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &t);
+#else
+#error "No platform function for current time"
+#endif
+
+	// Pack timespec fields into 32-bit timestamp with microsecond granularity
+	return (uint32_t)(((t.tv_sec * 1000000) + (t.tv_nsec / 1000)));
+}
+
+static void emv_debug_deliver(
+	emv_debug_func_t func,
+	void* user_data,
+	uint32_t timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	void* prev_user_data;
+
+#ifdef CONFIG_SRC_BASE
+	{
+		const size_t src_base_len = strlen(CONFIG_SRC_BASE);
+		// Remove project's base path from source path for trace messages
+		if (strncmp(CONFIG_SRC_BASE, str, src_base_len) == 0) {
+			str += src_base_len;
+			if (*str == '/' || *str == '\\') {
+				// If project's base path did not end with a slash, then
+				// skip over it
+				++str;
+			}
+		}
+	}
+#endif
+
+	// Make user data available to the debug event function, which may be
+	// invoked by a different thread than the one that emitted the event
+	prev_user_data = debug_user_data;
+	debug_user_data = user_data;
+	func(timestamp, source, level, debug_type, str, buf, buf_len);
+	debug_user_data = prev_user_data;
+}
+
+#ifdef HAVE_PTHREAD
+
+static const char* emv_debug_parse_spec(
+	const char* spec,
+	enum emv_debug_arg_type_t* type
+)
+{
+	// Parse conversion specification, excluding the leading '%', and
+	// determine the argument type. Field width and precision provided as
+	// arguments using '*' are not supported.
+	const char* ptr = spec;
+	char length = 0;
+
+	if (*ptr == '%') {
+		*type = EMV_DEBUG_ARG_NONE;
+		return ptr + 1;
+	}
+
+	// Flags, field width and precision
+	ptr += strspn(ptr, "-+ #0'");
+	ptr += strspn(ptr, "0123456789");
+	if (*ptr == '.') {
+		++ptr;
+		ptr += strspn(ptr, "0123456789");
+	}
+
+	// Length modifier
+	switch (*ptr) {
+		case 'h':
+			++ptr;
+			if (*ptr == 'h') {
+				++ptr;
+			}
+			break;
+
+		case 'l':
+			length = 'l';
+			++ptr;
+			if (*ptr == 'l') {
+				length = 'q';
+				++ptr;
+			}
+			break;
+
+		case 'z':
+		case 'j':
+		case 't':
+		case 'L':
+			length = *ptr;
+			++ptr;
+			break;
+	}
+
+	// Conversion specifier
+	switch (*ptr) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			switch (length) {
+				case 0: *type = EMV_DEBUG_ARG_INT; break;
+				case 'l': *type = EMV_DEBUG_ARG_LONG; break;
+				case 'q': *type = EMV_DEBUG_ARG_LLONG; break;
+				case 'z': *type = EMV_DEBUG_ARG_SIZE; break;
+				case 'j': *type = EMV_DEBUG_ARG_INTMAX; break;
+				case 't': *type = EMV_DEBUG_ARG_PTRDIFF; break;
+				default: return NULL;
+			}
+			break;
+
+		case 'c':
+			if (length) {
+				return NULL;
+			}
+			*type = EMV_DEBUG_ARG_INT;
+			break;
+
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			*type = length == 'L' ? EMV_DEBUG_ARG_LDOUBLE : EMV_DEBUG_ARG_DOUBLE;
+			break;
+
+		case 'p':
+			*type = EMV_DEBUG_ARG_PTR;
+			break;
+
+		case 's':
+			if (length) {
+				return NULL;
+			}
+			*type = EMV_DEBUG_ARG_STR;
+			break;
+
+		default:
+			// Unsupported conversion, including '*' and 'n'
+			return NULL;
+	}
+	++ptr;
+
+	if (ptr - spec >= EMV_DEBUG_ASYNC_SPEC_MAX - 1) {
+		return NULL;
+	}
+
+	return ptr;
+}
+
+static int emv_debug_async_record_args(
+	struct emv_debug_event_t* event,
+	size_t* data_len,
+	const char* fmt,
+	va_list ap
+)
+{
+	const char* ptr = fmt;
+
+	event->arg_count = 0;
+	while ((ptr = strchr(ptr, '%'))) {
+		struct emv_debug_arg_t* arg;
+		enum emv_debug_arg_type_t type;
+
+		ptr = emv_debug_parse_spec(ptr + 1, &type);
+		if (!ptr) {
+			return 1;
+		}
+		if (type == EMV_DEBUG_ARG_NONE) {
+			continue;
+		}
+		if (event->arg_count >= EMV_DEBUG_ASYNC_ARGS_MAX) {
+			return 1;
+		}
+
+		arg = &event->args[event->arg_count++];
+		arg->type = type;
+		switch (type) {
+			case EMV_DEBUG_ARG_INT: arg->value.i = va_arg(ap, int); break;
+			case EMV_DEBUG_ARG_LONG: arg->value.l = va_arg(ap, long); break;
+			case EMV_DEBUG_ARG_LLONG: arg->value.ll = va_arg(ap, long long); break;
+			case EMV_DEBUG_ARG_SIZE: arg->value.z = va_arg(ap, size_t); break;
+			case EMV_DEBUG_ARG_INTMAX: arg->value.j = va_arg(ap, intmax_t); break;
+			case EMV_DEBUG_ARG_PTRDIFF: arg->value.t = va_arg(ap, ptrdiff_t); break;
+			case EMV_DEBUG_ARG_DOUBLE: arg->value.d = va_arg(ap, double); break;
+			case EMV_DEBUG_ARG_LDOUBLE: arg->value.ld = va_arg(ap, long double); break;
+			case EMV_DEBUG_ARG_PTR: arg->value.p = va_arg(ap, const void*); break;
+
+			case EMV_DEBUG_ARG_STR: {
+				// Strings may not outlive the debug event and must be copied
+				const char* str = va_arg(ap, const char*);
+				size_t str_len;
+
+				if (!str) {
+					arg->value.str_offset = SIZE_MAX;
+					break;
+				}
+				str_len = strlen(str) + 1;
+				if (str_len > sizeof(event->data) - *data_len) {
+					return -1;
+				}
+				memcpy(event->data + *data_len, str, str_len);
+				arg->value.str_offset = *data_len;
+				*data_len += str_len;
+				break;
+			}
+
+			default:
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void emv_debug_async_format(
+	const struct emv_debug_event_t* event,
+	char* str,
+	size_t str_len
+)
+{
+	const char* ptr = event->fmt;
+	size_t offset = 0;
+	unsigned int arg_idx = 0;
+
+	str[0] = 0;
+	while (*ptr && offset < str_len - 1) {
+		const char* spec_end;
+		char spec[EMV_DEBUG_ASYNC_SPEC_MAX];
+		enum emv_debug_arg_type_t type;
+		const struct emv_debug_arg_t* arg;
+		const char* str_arg;
+		int r;
+
+		if (*ptr != '%') {
+			str[offset++] = *ptr++;
+			str[offset] = 0;
+			continue;
+		}
+
+		// Format string was validated when the event was recorded
+		spec_end = emv_debug_parse_spec(ptr + 1, &type);
+		if (!spec_end) {
+			return;
+		}
+		memcpy(spec, ptr, spec_end - ptr);
+		spec[spec_end - ptr] = 0;
+		ptr = spec_end;
+
+		if (type == EMV_DEBUG_ARG_NONE) {
+			str[offset++] = '%';
+			str[offset] = 0;
+			continue;
+		}
+
+		arg = &event->args[arg_idx++];
+		switch (arg->type) {
+			case EMV_DEBUG_ARG_INT: r = snprintf(str + offset, str_len - offset, spec, arg->value.i); break;
+			case EMV_DEBUG_ARG_LONG: r = snprintf(str + offset, str_len - offset, spec, arg->value.l); break;
+			case EMV_DEBUG_ARG_LLONG: r = snprintf(str + offset, str_len - offset, spec, arg->value.ll); break;
+			case EMV_DEBUG_ARG_SIZE: r = snprintf(str + offset, str_len - offset, spec, arg->value.z); break;
+			case EMV_DEBUG_ARG_INTMAX: r = snprintf(str + offset, str_len - offset, spec, arg->value.j); break;
+			case EMV_DEBUG_ARG_PTRDIFF: r = snprintf(str + offset, str_len - offset, spec, arg->value.t); break;
+			case EMV_DEBUG_ARG_DOUBLE: r = snprintf(str + offset, str_len - offset, spec, arg->value.d); break;
+			case EMV_DEBUG_ARG_LDOUBLE: r = snprintf(str + offset, str_len - offset, spec, arg->value.ld); break;
+			case EMV_DEBUG_ARG_PTR: r = snprintf(str + offset, str_len - offset, spec, arg->value.p); break;
+
+			case EMV_DEBUG_ARG_STR:
+				if (arg->value.str_offset == SIZE_MAX) {
+					str_arg = NULL;
+				} else {
+					str_arg = (const char*)event->data + arg->value.str_offset;
+				}
+				r = snprintf(str + offset, str_len - offset, spec, str_arg);
+				break;
+
+			default:
+				return;
+		}
+		if (r < 0) {
+			return;
+		}
+		offset += r;
+	}
+}
+
+static void emv_debug_async_deliver(const struct emv_debug_event_t* event)
+{
+	char str[1024];
+	const char* event_str;
+
+	if (event->fmt) {
+		emv_debug_async_format(event, str, sizeof(str));
+		event_str = str;
+	} else {
+		event_str = (const char*)event->data + event->str_offset;
+	}
+
+	emv_debug_deliver(
+		event->func,
+		event->user_data,
+		event->timestamp,
+		event->source,
+		event->level,
+		event->debug_type,
+		event_str,
+		event->has_buf ? event->data : NULL,
+		event->buf_len
+	);
+}
+
+static bool emv_debug_async_consume(struct emv_debug_async_t* async)
+{
+	// Single consumer of bounded multi-producer queue using per-slot
+	// sequence numbers
+	size_t pos = atomic_load_explicit(&async->dequeue_pos, memory_order_relaxed);
+	struct emv_debug_event_t* event = &async->slots[pos & async->mask];
+
+	if (atomic_load_explicit(&event->seq, memory_order_acquire) != pos + 1) {
+		// Ring buffer is empty or the next event is still being recorded
+		return false;
+	}
+
+	emv_debug_async_deliver(event);
+
+	// Release slot for the next cycle and publish progress for flushing
+	atomic_store_explicit(&event->seq, pos + async->mask + 1, memory_order_release);
+	atomic_store_explicit(&async->dequeue_pos, pos + 1, memory_order_release);
+
+	return true;
+}
+
+static void emv_debug_async_sleep(void)
+{
+	const struct timespec t = { 0, 200000 }; // 200us
+
+	nanosleep(&t, NULL);
+}
+
+static void* emv_debug_async_thread(void* ptr)
+{
+	struct emv_debug_async_t* async = ptr;
+
+	while (true) {
+		if (emv_debug_async_consume(async)) {
+			continue;
+		}
+		if (!atomic_load_explicit(&async->running, memory_order_acquire)) {
+			// Deliver events that were recorded before stopping
+			if (atomic_load(&async->dequeue_pos) == atomic_load(&async->enqueue_pos)) {
+				break;
+			}
+		}
+		emv_debug_async_sleep();
+	}
+
+	return NULL;
+}
+
+static struct emv_debug_async_t* emv_debug_async_acquire(void)
+{
+	struct emv_debug_async_t* async;
+
+	// Register as user before loading the ring buffer such that
+	// emv_debug_async_stop() either observes this user or this thread
+	// observes that the ring buffer was removed
+	atomic_fetch_add(&debug_async_users, 1);
+	async = atomic_load(&debug_async);
+	if (!async) {
+		atomic_fetch_sub_explicit(&debug_async_users, 1, memory_order_release);
+	}
+
+	return async;
+}
+
+static void emv_debug_async_release(void)
+{
+	atomic_fetch_sub_explicit(&debug_async_users, 1, memory_order_release);
+}
+
+static void emv_debug_async_wait(struct emv_debug_async_t* async)
+{
+	size_t pos = atomic_load(&async->enqueue_pos);
+
+	if (pthread_equal(pthread_self(), async->thread)) {
+		// Debug event function emitted debug events itself
+		return;
+	}
+
+	while ((ptrdiff_t)(pos - atomic_load_explicit(&async->dequeue_pos, memory_order_acquire)) > 0) {
+		emv_debug_async_sleep();
+	}
+}
+
+static int emv_debug_async_record(
+	struct emv_debug_async_t* async,
+	const struct emv_debug_config_t* config,
+	uint32_t timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* fmt,
+	const void* buf,
+	size_t buf_len,
+	va_list ap
+)
+{
+	int r;
+	size_t pos;
+	struct emv_debug_event_t* event;
+	size_t data_len;
+	va_list ap_copy;
+
+	if (debug_type == EMV_DEBUG_TYPE_TLV_LIST ||
+		debug_type == EMV_DEBUG_TYPE_ATR ||
+		buf_len > sizeof(event->data) - 1
+	) {
+		// Data references external memory or does not fit while leaving
+		// room for at least the NULL termination of a formatted string
+		return 1;
+	}
+
+	// Claim slot without locking
+	pos = atomic_load_explicit(&async->enqueue_pos, memory_order_relaxed);
+	while (true) {
+		size_t seq;
+
+		event = &async->slots[pos & async->mask];
+		seq = atomic_load_explicit(&event->seq, memory_order_acquire);
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit(
+				&async->enqueue_pos,
+				&pos,
+				pos + 1,
+				memory_order_relaxed,
+				memory_order_relaxed
+			)) {
+				break;
+			}
+		} else if ((ptrdiff_t)(seq - pos) < 0) {
+			// Ring buffer is full
+			atomic_fetch_add_explicit(&async->dropped_count, 1, memory_order_relaxed);
+			return 0;
+		} else {
+			pos = atomic_load_explicit(&async->enqueue_pos, memory_order_relaxed);
+		}
+	}
+
+	event->func = config->func;
+	event->user_data = config->user_data;
+	event->timestamp = timestamp;
+	event->source = source;
+	event->level = level;
+	event->debug_type = debug_type;
+	event->has_buf = buf != NULL;
+	event->buf_len = buf_len;
+	if (buf_len) {
+		memcpy(event->data, buf, buf_len);
+	}
+	data_len = buf_len;
+
+	// Record arguments for deferred formatting
+	va_copy(ap_copy, ap);
+	r = emv_debug_async_record_args(event, &data_len, fmt, ap_copy);
+	va_end(ap_copy);
+	if (r == 0) {
+		event->fmt = fmt;
+	} else {
+		// Format string is not suitable for deferred formatting; format it
+		// now but still defer delivery. Strings copied for deferred
+		// formatting are no longer needed.
+		data_len = buf_len;
+		event->fmt = NULL;
+		event->str_offset = data_len;
+		r = vsnprintf((char*)event->data + data_len, sizeof(event->data) - data_len, fmt, ap);
+		if (r < 0 || (size_t)r >= sizeof(event->data) - data_len) {
+			// Deliver truncated string rather than losing the slot
+			event->data[sizeof(event->data) - 1] = 0;
+		}
+	}
+
+	// Publish event to consumer
+	atomic_store_explicit(&event->seq, pos + 1, memory_order_release);
+
+	return 0;
+}
+
+#endif // HAVE_PTHREAD
 
 int emv_debug_init(
 	unsigned int sources_mask,
@@ -42,13 +635,162 @@ int emv_debug_init(
 	emv_debug_func_t func
 )
 {
-	debug_sources_mask = sources_mask;
-	debug_level = level;
-	debug_func = func;
+	debug_config.sources_mask = sources_mask;
+	debug_config.level = level;
+	debug_config.func = func;
+	debug_config.user_data = NULL;
+
+	return 0;
+}
+
+int emv_debug_set_thread_config(const struct emv_debug_config_t* config)
+{
+	if (!config) {
+		debug_thread_config_valid = false;
+		return 0;
+	}
+
+	debug_thread_config = *config;
+	debug_thread_config_valid = true;
+
+	return 0;
+}
+
+int emv_debug_get_thread_config(struct emv_debug_config_t* config)
+{
+	if (!config) {
+		return -1;
+	}
+
+	*config = debug_thread_config_valid ? debug_thread_config : debug_config;
+	if (debug_suppressed) {
+		config->func = NULL;
+	}
+
+	return 0;
+}
+
+void* emv_debug_get_user_data(void)
+{
+	return debug_user_data;
+}
+
+int emv_debug_async_start(unsigned int slot_count)
+{
+#ifdef HAVE_PTHREAD
+	int r;
+	struct emv_debug_async_t* async;
+
+	struct emv_debug_async_t* expected = NULL;
+
+	if (!slot_count || (slot_count & (slot_count - 1))) {
+		return -1;
+	}
+	if (atomic_load(&debug_async)) {
+		// Already started
+		return 1;
+	}
+
+	async = calloc(1, sizeof(*async));
+	if (!async) {
+		return -2;
+	}
+	async->slots = calloc(slot_count, sizeof(*async->slots));
+	if (!async->slots) {
+		free(async);
+		return -3;
+	}
+	async->mask = slot_count - 1;
+	for (size_t i = 0; i < slot_count; ++i) {
+		atomic_init(&async->slots[i].seq, i);
+	}
+	atomic_init(&async->enqueue_pos, 0);
+	atomic_init(&async->dequeue_pos, 0);
+	atomic_init(&async->dropped_count, 0);
+	atomic_init(&async->running, true);
+
+	r = pthread_create(&async->thread, NULL, &emv_debug_async_thread, async);
+	if (r) {
+		free(async->slots);
+		free(async);
+		return -4;
+	}
+
+	// Publish ring buffer unless another thread started asynchronous
+	// delivery concurrently
+	if (!atomic_compare_exchange_strong(&debug_async, &expected, async)) {
+		atomic_store(&async->running, false);
+		pthread_join(async->thread, NULL);
+		free(async->slots);
+		free(async);
+		return 1;
+	}
+
+	return 0;
+
+#else
+	(void)slot_count;
+
+	// Asynchronous delivery not supported without thread support
+	return 1;
+#endif
+}
+
+void emv_debug_async_flush(void)
+{
+#ifdef HAVE_PTHREAD
+	struct emv_debug_async_t* async = emv_debug_async_acquire();
+
+	if (async) {
+		emv_debug_async_wait(async);
+		emv_debug_async_release();
+	}
+#endif
+}
+
+void emv_debug_async_stop(void)
+{
+#ifdef HAVE_PTHREAD
+	struct emv_debug_async_t* async = atomic_exchange(&debug_async, NULL);
+
+	if (!async) {
+		return;
+	}
+
+	// Wait for producers that may still be recording events in the ring
+	// buffer. New producers will observe that the ring buffer was removed.
+	while (atomic_load_explicit(&debug_async_users, memory_order_acquire)) {
+		emv_debug_async_sleep();
+	}
+
+	atomic_store(&async->running, false);
+	pthread_join(async->thread, NULL);
+	free(async->slots);
+	free(async);
+#endif
+}
+
+unsigned long emv_debug_async_dropped_count(void)
+{
+#ifdef HAVE_PTHREAD
+	struct emv_debug_async_t* async = emv_debug_async_acquire();
+
+	if (async) {
+		unsigned long dropped_count = atomic_load(&async->dropped_count);
+
+		emv_debug_async_release();
+		return dropped_count;
+	}
+#endif
 
 	return 0;
 }
 
+void emv_debug_suppress(bool suppress)
+{
+	debug_suppressed = suppress;
+}
+
 void emv_debug_internal(
 	enum emv_debug_source_t source,
 	enum emv_debug_level_t level,
@@ -60,24 +802,53 @@ void emv_debug_internal(
 )
 {
 	int r;
+	const struct emv_debug_config_t* config;
 	char str[1024];
-	unsigned int str_offset = 0;
-	struct timespec t;
 	uint32_t timestamp;
+	va_list ap;
 
-	if (!debug_func) {
+	// Thread configuration, if any, replaces the process configuration
+	config = debug_thread_config_valid ? &debug_thread_config : &debug_config;
+	if (level > config->level ||
+		(config->sources_mask & source) == 0 ||
+		!config->func ||
+		debug_suppressed
+	) {
 		return;
 	}
 
-	if ((debug_sources_mask & source) == 0) {
-		return;
-	}
+	timestamp = emv_debug_timestamp();
 
-	if (level > debug_level) {
-		return;
+#ifdef HAVE_PTHREAD
+	if (atomic_load_explicit(&debug_async, memory_order_relaxed)) {
+		struct emv_debug_async_t* async = emv_debug_async_acquire();
+		if (async) {
+			va_start(ap, buf_len);
+			r = emv_debug_async_record(
+				async,
+				config,
+				timestamp,
+				source,
+				level,
+				debug_type,
+				fmt,
+				buf,
+				buf_len,
+				ap
+			);
+			va_end(ap);
+			if (r == 0) {
+				emv_debug_async_release();
+				return;
+			}
+
+			// Preserve event order before delivering synchronously
+			emv_debug_async_wait(async);
+			emv_debug_async_release();
+		}
 	}
+#endif
 
-	va_list ap;
 	va_start(ap, buf_len);
 	r = vsnprintf(str, sizeof(str), fmt, ap);
 	va_end(ap);
@@ -86,34 +857,5 @@ void emv_debug_internal(
 		return;
 	}
 
-#ifdef CONFIG_SRC_BASE
-	{
-		const size_t src_base_len = strlen(CONFIG_SRC_BASE);
-		// Remove project's base path from source path for trace messages
-		if (src_base_len < sizeof(str) &&
-			strncmp(CONFIG_SRC_BASE, str, src_base_len) == 0
-		) {
-			str_offset = src_base_len;
-			if (str[str_offset] == '/' || str[str_offset] == '\\') {
-				// If project's base path did not end with a slash, then
-				// skip over it
-				++str_offset;
-			}
-		}
-	}
-#endif
-
-	// TODO: replace with HAL interface in future
-#if defined(HAVE_TIMESPEC_GET)
-	timespec_get(&t, TIME_UTC);
-#elif defined(HAVE_CLOCK_GETTIME)
-	clock_gettime(CLOCK_MONOTONIC, &t);
-#else
-#error "No platform function for current time"
-#endif
-
-	// Pack timespec fields into 32-bit timestamp with microsecond granularity
-	timestamp = (uint32_t)(((t.tv_sec * 1000000) + (t.tv_nsec / 1000)));
-
-	debug_func(timestamp, source, level, debug_type, str + str_offset, buf, buf_len);
+	emv_debug_deliver(config->func, config->user_data, timestamp, source, level, debug_type, str, buf, buf_len);
 }
@@ -2,7 +2,7 @@
  * @file emv_debug.h
  * @brief EMV debug implementation
  *
- * Copyright 2021, 2023, 2025 Leon Lynch
+ * Copyright 2021, 2023, 2025-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -23,6 +23,7 @@
 #define EMV_DEBUG_H
 
 #include <sys/cdefs.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 __BEGIN_DECLS
@@ -83,7 +84,9 @@ typedef void (*emv_debug_func_t)(
 );
 
 /**
- * Initialise debug event function
+ * Initialise process-wide debug event function. This configuration is used by
+ * all threads that have not set their own configuration using
+ * @ref emv_debug_set_thread_config().
  *
  * @param sources_mask Bitmask of debug sources to pass to event function. See @ref emv_debug_source_t
  * @param level Maximum debug level event to pass to event function. See @ref emv_debug_level_t
@@ -95,6 +98,116 @@ int emv_debug_init(
 	emv_debug_func_t func
 );
 
+/**
+ * Debug configuration
+ * @see emv_debug_set_thread_config()
+ */
+struct emv_debug_config_t {
+	unsigned int sources_mask;                  ///< Bitmask of debug sources to pass to event function. See @ref emv_debug_source_t
+	enum emv_debug_level_t level;               ///< Maximum debug level event to pass to event function. See @ref emv_debug_level_t
+	emv_debug_func_t func;                      ///< Callback function to use for debug events. NULL to disable.
+	void* user_data;                            ///< User data available to callback function using @ref emv_debug_get_user_data()
+};
+
+/**
+ * Set debug configuration for the current thread. The configuration replaces
+ * the process-wide configuration provided to @ref emv_debug_init() for all
+ * debug events emitted by the current thread, which allows each thread
+ * performing EMV processing to use its own debug sources, debug level,
+ * callback function and user data without affecting other threads. Debug
+ * events that are not enabled by the configuration are discarded before any
+ * formatting.
+ *
+ * @param config Debug configuration to copy. NULL to revert to the
+ *               process-wide configuration.
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_debug_set_thread_config(const struct emv_debug_config_t* config);
+
+/**
+ * Retrieve debug configuration that applies to the current thread. This is
+ * the configuration set using @ref emv_debug_set_thread_config(), if any, or
+ * otherwise the process-wide configuration provided to @ref emv_debug_init().
+ * If debug events are currently suppressed for the current thread, the
+ * callback function is NULL. This allows a worker thread to emit debug events
+ * on behalf of the current thread by providing the configuration to
+ * @ref emv_debug_set_thread_config().
+ *
+ * @param config Debug configuration output
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_debug_get_thread_config(struct emv_debug_config_t* config);
+
+/**
+ * Retrieve user data of the debug configuration that emitted the debug event
+ * that is currently being delivered. This function is intended to be called
+ * by the debug event function, including when events are delivered by a
+ * different thread. See @ref emv_debug_async_start().
+ *
+ * @return User data. NULL if not available.
+ */
+void* emv_debug_get_user_data(void);
+
+/**
+ * Start asynchronous delivery of debug events. Debug events are recorded
+ * together with their unformatted arguments and binary data in a lock-free
+ * ring buffer and a background thread formats them and invokes the debug
+ * event function provided to @ref emv_debug_init(). This avoids formatting
+ * and output on the thread emitting the debug event.
+ *
+ * Events are delivered in the order that they were recorded. If the ring
+ * buffer is full, new events are dropped and counted instead of blocking the
+ * emitting thread. See @ref emv_debug_async_dropped_count(). Events that
+ * reference external data, such as EMV TLV lists or parsed ATR information,
+ * and events that do not fit into a ring buffer slot are delivered
+ * synchronously by the emitting thread after all earlier events have been
+ * delivered.
+ *
+ * @note The debug event function may be invoked by the background thread as
+ * well as by the emitting threads and must therefore be thread safe.
+ *
+ * @param slot_count Number of ring buffer slots. Must be a power of two.
+ * @return Zero for success. Less than zero for error. Greater than zero if
+ *         not supported or already started.
+ */
+int emv_debug_async_start(unsigned int slot_count);
+
+/**
+ * Wait for all debug events that have been recorded so far to be delivered.
+ * This function has no effect if asynchronous delivery is not started.
+ */
+void emv_debug_async_flush(void);
+
+/**
+ * Stop asynchronous delivery of debug events after delivering all recorded
+ * events and release the ring buffer. Subsequent debug events are delivered
+ * synchronously.
+ * @note Other threads may continue to emit debug events while this function
+ * is in progress. The ring buffer is only released once those threads have
+ * finished recording, but their synchronously delivered events may be
+ * interleaved with the remaining recorded events. This function must not be
+ * called by the debug event function.
+ */
+void emv_debug_async_stop(void);
+
+/**
+ * Retrieve number of debug events dropped by asynchronous delivery because
+ * the ring buffer was full.
+ * @return Number of dropped debug events since @ref emv_debug_async_start()
+ */
+unsigned long emv_debug_async_dropped_count(void);
+
+/**
+ * Suppress debug events emitted by the current thread. This is used
+ * internally by @ref emv_txn_step() to avoid repeating debug events while
+ * card exchanges are replayed.
+ * @cond INTERNAL
+ *
+ * @param suppress True to suppress debug events. False to resume.
+ */
+void emv_debug_suppress(bool suppress);
+/// @endcond
+
 /**
  * Internal debugging implementation used by macros. Callers should use the
  * macros instead.
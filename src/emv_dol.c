@@ -23,8 +23,80 @@
 #include "iso8825_ber.h"
 #include "emv_tlv.h"
 
+#include <stdbool.h>
 #include <string.h>
 
+// Helper functions
+static int emv_dol_validate_sources(const struct emv_tlv_sources_t* sources);
+static void emv_dol_build_entry(
+	const struct emv_tlv_t* tlv,
+	unsigned int length,
+	enum emv_dol_format_t format,
+	uint8_t* data
+);
+
+static int emv_dol_validate_sources(const struct emv_tlv_sources_t* sources)
+{
+	if (!sources->count ||
+		sources->count > sizeof(sources->list) / sizeof(sources->list[0])
+	) {
+		return -2;
+	}
+	for (size_t i = 0; i < sources->count; ++i) {
+		if (!sources->list[i]) {
+			return -3;
+		}
+	}
+
+	return 0;
+}
+
+static void emv_dol_build_entry(
+	const struct emv_tlv_t* tlv,
+	unsigned int length,
+	enum emv_dol_format_t format,
+	uint8_t* data
+)
+{
+	if (!tlv) {
+		// If TLV is not found, zero data output
+		// See EMV 4.4 Book 3, 5.4, step 2b
+		memset(data, 0, length);
+		return;
+	}
+
+	if (tlv->length == length) {
+		// TLV is found and length matches DOL entry
+		memcpy(data, tlv->value, length);
+		return;
+	}
+
+	if (tlv->length > length) {
+		// TLV is found and length is more than DOL entry, requiring truncation
+		// See EMV 4.4 Book 3, 5.4, step 2c
+		unsigned int offset = 0;
+		if (format == EMV_DOL_FORMAT_N) {
+			offset = tlv->length - length;
+		}
+		memcpy(data, tlv->value + offset, length);
+		return;
+	}
+
+	// TLV is found and length is less than DOL entry, requiring padding
+	// See EMV 4.4 Book 3, 5.4, step 2d
+	unsigned int pad_len = length - tlv->length;
+	if (format == EMV_DOL_FORMAT_N) {
+		memset(data, 0, pad_len);
+		memcpy(data + pad_len, tlv->value, tlv->length);
+	} else if (format == EMV_DOL_FORMAT_CN) {
+		memcpy(data, tlv->value, tlv->length);
+		memset(data + tlv->length, 0xFF, pad_len);
+	} else {
+		memcpy(data, tlv->value, tlv->length);
+		memset(data + tlv->length, 0, pad_len);
+	}
+}
+
 int emv_dol_decode(const void* ptr, size_t len, struct emv_dol_entry_t* entry)
 {
 	int r;
@@ -145,15 +217,9 @@ int emv_dol_build_data(
 	if (!ptr || !len || !sources || !data || !data_len || !*data_len) {
 		return -1;
 	}
-	if (!sources->count ||
-		sources->count > sizeof(sources->list) / sizeof(sources->list[0])
-	) {
-		return -2;
-	}
-	for (size_t i = 0; i < sources->count; ++i) {
-		if (!sources->list[i]) {
-			return -3;
-		}
+	r = emv_dol_validate_sources(sources);
+	if (r) {
+		return r;
 	}
 
 	r = emv_dol_itr_init(ptr, len, &itr);
@@ -162,71 +228,208 @@ int emv_dol_build_data(
 	}
 
 	while ((r = emv_dol_itr_next(&itr, &entry)) > 0) {
-		const struct emv_tlv_t* tlv;
+		enum emv_dol_format_t format;
 
 		if (*data_len < entry.length) {
 			// Output data length too small
 			return 1;
 		}
 
+		if (emv_tlv_is_format_n(entry.tag)) {
+			format = EMV_DOL_FORMAT_N;
+		} else if (emv_tlv_is_format_cn(entry.tag)) {
+			format = EMV_DOL_FORMAT_CN;
+		} else {
+			format = EMV_DOL_FORMAT_DEFAULT;
+		}
+
 		// Populate concatenated data for DOL entry
-		tlv = emv_tlv_sources_find_const(sources, entry.tag);
-		if (!tlv) {
-			// If TLV is not found, zero data output
-			// See EMV 4.4 Book 3, 5.4, step 2b
-			memset(data_ptr, 0, entry.length);
-			data_ptr += entry.length;
-			*data_len -= entry.length;
-			continue;
+		emv_dol_build_entry(
+			emv_tlv_sources_find_const(sources, entry.tag),
+			entry.length,
+			format,
+			data_ptr
+		);
+		data_ptr += entry.length;
+		*data_len -= entry.length;
+	}
+	if (r != 0) {
+		return -6;
+	}
+
+	*data_len = data_ptr - data;
+	return 0;
+}
+
+int emv_dol_plan_compile(const void* ptr, size_t len, struct emv_dol_plan_t* plan)
+{
+	int r;
+	struct emv_dol_itr_t itr;
+	struct emv_dol_entry_t entry;
+
+	if (!ptr || !len || !plan) {
+		return -1;
+	}
+
+	if (len > sizeof(plan->dol)) {
+		// DOL too large for plan
+		return 1;
+	}
+
+	r = emv_dol_itr_init(ptr, len, &itr);
+	if (r) {
+		return -2;
+	}
+
+	plan->count = 0;
+	plan->data_len = 0;
+	while ((r = emv_dol_itr_next(&itr, &entry)) > 0) {
+		struct emv_dol_plan_entry_t* plan_entry;
+
+		if (plan->count >= sizeof(plan->entries) / sizeof(plan->entries[0])) {
+			// Too many DOL entries for plan
+			plan->dol_len = 0;
+			return 2;
 		}
 
-		if (tlv->length == entry.length) {
-			// TLV is found and length matches DOL entry
-			memcpy(data_ptr, tlv->value, entry.length);
-			data_ptr += entry.length;
-			*data_len -= entry.length;
-			continue;
+		plan_entry = &plan->entries[plan->count++];
+		plan_entry->tag = entry.tag;
+		plan_entry->length = entry.length;
+		if (emv_tlv_is_format_n(entry.tag)) {
+			plan_entry->format = EMV_DOL_FORMAT_N;
+		} else if (emv_tlv_is_format_cn(entry.tag)) {
+			plan_entry->format = EMV_DOL_FORMAT_CN;
+		} else {
+			plan_entry->format = EMV_DOL_FORMAT_DEFAULT;
 		}
 
-		if (tlv->length > entry.length) {
-			// TLV is found and length is more than DOL entry, requiring truncation
-			// See EMV 4.4 Book 3, 5.4, step 2c
-			unsigned int offset = 0;
-			if (emv_tlv_is_format_n(tlv->tag)) {
-				offset = tlv->length - entry.length;
-			}
-			memcpy(data_ptr, tlv->value + offset, entry.length);
-			data_ptr += entry.length;
-			*data_len -= entry.length;
-			continue;
+		plan->data_len += entry.length;
+	}
+	if (r != 0) {
+		plan->dol_len = 0;
+		return -3;
+	}
+
+	memcpy(plan->dol, ptr, len);
+	plan->dol_len = len;
+
+	return 0;
+}
+
+int emv_dol_plan_build_data(
+	const struct emv_dol_plan_t* plan,
+	const struct emv_tlv_sources_t* sources,
+	void* data,
+	size_t* data_len
+)
+{
+	int r;
+	uint8_t* data_ptr = data;
+
+	if (!plan || !plan->dol_len || !sources || !data || !data_len || !*data_len) {
+		return -1;
+	}
+	r = emv_dol_validate_sources(sources);
+	if (r) {
+		return r;
+	}
+
+	if (*data_len < plan->data_len) {
+		// Output data length too small
+		return 1;
+	}
+
+	for (unsigned int i = 0; i < plan->count; ++i) {
+		const struct emv_dol_plan_entry_t* entry = &plan->entries[i];
+
+		// Populate concatenated data for DOL entry
+		emv_dol_build_entry(
+			emv_tlv_sources_find_const(sources, entry->tag),
+			entry->length,
+			entry->format,
+			data_ptr
+		);
+		data_ptr += entry->length;
+	}
+
+	*data_len = plan->data_len;
+	return 0;
+}
+
+const struct emv_dol_plan_t* emv_dol_cache_get(
+	struct emv_dol_cache_t* cache,
+	const void* ptr,
+	size_t len
+)
+{
+	int r;
+	unsigned int idx;
+
+	if (!cache || !ptr || !len) {
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < cache->count; ++i) {
+		const struct emv_dol_plan_t* plan = &cache->plans[i];
+
+		if (plan->dol_len == len && memcmp(plan->dol, ptr, len) == 0) {
+			cache->last_used[i] = ++cache->tick;
+			return plan;
 		}
+	}
 
-		if (tlv->length < entry.length) {
-			// TLV is found and length is less than DOL entry, requiring padding
-			// See EMV 4.4 Book 3, 5.4, step 2d
-			unsigned int pad_len = entry.length - tlv->length;
-			if (emv_tlv_is_format_n(tlv->tag)) {
-				memset(data_ptr, 0, pad_len);
-				memcpy(data_ptr + pad_len, tlv->value, tlv->length);
-			} else if (emv_tlv_is_format_cn(tlv->tag)) {
-				memcpy(data_ptr, tlv->value, tlv->length);
-				memset(data_ptr + tlv->length, 0xFF, pad_len);
-			} else {
-				memcpy(data_ptr, tlv->value, tlv->length);
-				memset(data_ptr + tlv->length, 0, pad_len);
+	if (cache->count < EMV_DOL_CACHE_SIZE) {
+		idx = cache->count;
+	} else {
+		// Replace least recently used plan
+		idx = 0;
+		for (unsigned int i = 1; i < cache->count; ++i) {
+			if (cache->last_used[i] < cache->last_used[idx]) {
+				idx = i;
 			}
-			data_ptr += entry.length;
-			*data_len -= entry.length;
-			continue;
 		}
+	}
 
-		// This should never happen
-		return -5;
+	r = emv_dol_plan_compile(ptr, len, &cache->plans[idx]);
+	if (r) {
+		// Failed plan, if any, is invalid and will be replaced first
+		cache->plans[idx].dol_len = 0;
+		cache->last_used[idx] = 0;
+		return NULL;
 	}
-	if (r != 0) {
-		return -6;
+	if (idx == cache->count) {
+		++cache->count;
 	}
+	cache->last_used[idx] = ++cache->tick;
 
-	*data_len = data_ptr - data;
-	return 0;
+	return &cache->plans[idx];
+}
+
+int emv_dol_cache_build_data(
+	struct emv_dol_cache_t* cache,
+	const void* ptr,
+	size_t len,
+	const struct emv_tlv_sources_t* sources,
+	void* data,
+	size_t* data_len
+)
+{
+	const struct emv_dol_plan_t* plan;
+
+	plan = emv_dol_cache_get(cache, ptr, len);
+	if (!plan) {
+		// Decode DOL without plan
+		return emv_dol_build_data(ptr, len, sources, data, data_len);
+	}
+
+	return emv_dol_plan_build_data(plan, sources, data, data_len);
+}
+
+void emv_dol_cache_clear(struct emv_dol_cache_t* cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	memset(cache, 0, sizeof(*cache));
 }
@@ -26,6 +26,7 @@
 
 #include <sys/cdefs.h>
 #include <stddef.h>
+#include <stdint.h>
 
 __BEGIN_DECLS
 
@@ -44,6 +45,63 @@ struct emv_dol_itr_t {
 	size_t len; ///< Length of encoded EMV Data Object List (DOL) in bytes
 };
 
+/// Maximum length of encoded EMV Data Object List (DOL) for compiled plan
+#define EMV_DOL_PLAN_DOL_MAX_LEN (252)
+
+/// Maximum number of EMV Data Object List (DOL) entries for compiled plan
+#define EMV_DOL_PLAN_ENTRY_MAX (64)
+
+/// Number of compiled plans in EMV Data Object List (DOL) cache
+#define EMV_DOL_CACHE_SIZE (8)
+
+/// EMV Data Object List (DOL) padding and truncation rules
+enum emv_dol_format_t {
+	EMV_DOL_FORMAT_DEFAULT = 0, ///< Truncate right, pad right with zeros
+	EMV_DOL_FORMAT_N, ///< Format 'n': truncate left, pad left with zeros
+	EMV_DOL_FORMAT_CN, ///< Format 'cn': truncate right, pad right with 0xFF
+};
+
+/// Compiled EMV Data Object List (DOL) entry
+struct emv_dol_plan_entry_t {
+	unsigned int tag; ///< EMV tag
+	unsigned int length; ///< Expected length
+	enum emv_dol_format_t format; ///< Padding and truncation rule
+};
+
+/**
+ * Compiled EMV Data Object List (DOL)
+ *
+ * A plan contains the decoded DOL entries, their padding and truncation rules
+ * and the concatenated data length, such that concatenated data can be built
+ * for multiple transactions without decoding the DOL again.
+ */
+struct emv_dol_plan_t {
+	uint8_t dol[EMV_DOL_PLAN_DOL_MAX_LEN]; ///< Encoded EMV Data Object List (DOL)
+	size_t dol_len; ///< Length of encoded EMV Data Object List (DOL) in bytes
+	size_t data_len; ///< Length of concatenated data in bytes
+	unsigned int count; ///< Number of DOL entries
+	struct emv_dol_plan_entry_t entries[EMV_DOL_PLAN_ENTRY_MAX]; ///< DOL entries
+};
+
+/**
+ * EMV Data Object List (DOL) cache
+ *
+ * Small cache of compiled plans, keyed by the encoded DOL, that can be
+ * retained across transactions. When the cache is full, the least recently
+ * used plan is replaced.
+ *
+ * @note Initialise by zeroing the cache and release using
+ *       @ref emv_dol_cache_clear(). The cache does not allocate memory.
+ */
+struct emv_dol_cache_t {
+	/// @cond INTERNAL
+	unsigned int count;
+	unsigned long tick;
+	unsigned long last_used[EMV_DOL_CACHE_SIZE];
+	struct emv_dol_plan_t plans[EMV_DOL_CACHE_SIZE];
+	/// @endcond
+};
+
 /**
  * Decode EMV Data Object List (DOL) entry
  * @remark See EMV 4.4 Book 3, 5.4
@@ -97,6 +155,72 @@ int emv_dol_build_data(
 	size_t* data_len
 );
 
+/**
+ * Compile EMV Data Object List (DOL) into plan
+ * @param ptr Encoded EMV Data Object List (DOL)
+ * @param len Length of encoded EMV Data Object List (DOL) in bytes
+ * @param plan Compiled DOL plan output
+ * @return Zero for success. Less than zero for error.
+ *         Greater than zero if DOL is too large for plan.
+ */
+int emv_dol_plan_compile(const void* ptr, size_t len, struct emv_dol_plan_t* plan);
+
+/**
+ * Build concatenated data according to compiled Data Object List (DOL) plan
+ * @param plan Compiled DOL plan
+ * @param sources EMV TLV sources to use when building concatenated data
+ * @param data Concatenated data output
+ * @param data_len Length of concatenated data output in bytes
+ * @return Zero for success. Less than zero for internal error. Greater than zero if output data length too small.
+ */
+int emv_dol_plan_build_data(
+	const struct emv_dol_plan_t* plan,
+	const struct emv_tlv_sources_t* sources,
+	void* data,
+	size_t* data_len
+);
+
+/**
+ * Find compiled Data Object List (DOL) plan in cache, or compile DOL and add
+ * the plan to the cache if not found.
+ * @param cache DOL cache
+ * @param ptr Encoded EMV Data Object List (DOL)
+ * @param len Length of encoded EMV Data Object List (DOL) in bytes
+ * @return Compiled DOL plan. Do NOT free. NULL if DOL could not be compiled.
+ */
+const struct emv_dol_plan_t* emv_dol_cache_get(
+	struct emv_dol_cache_t* cache,
+	const void* ptr,
+	size_t len
+);
+
+/**
+ * Build concatenated data according to Data Object List (DOL) using the
+ * compiled plan from the cache, if possible. Otherwise this function is the
+ * same as @ref emv_dol_build_data().
+ * @param cache DOL cache. NULL to ignore.
+ * @param ptr Encoded EMV Data Object List (DOL)
+ * @param len Length of encoded EMV Data Object List (DOL) in bytes
+ * @param sources EMV TLV sources to use when building concatenated data
+ * @param data Concatenated data output
+ * @param data_len Length of concatenated data output in bytes
+ * @return Zero for success. Less than zero for internal error. Greater than zero if output data length too small.
+ */
+int emv_dol_cache_build_data(
+	struct emv_dol_cache_t* cache,
+	const void* ptr,
+	size_t len,
+	const struct emv_tlv_sources_t* sources,
+	void* data,
+	size_t* data_len
+);
+
+/**
+ * Clear EMV Data Object List (DOL) cache
+ * @param cache DOL cache
+ */
+void emv_dol_cache_clear(struct emv_dol_cache_t* cache);
+
 __END_DECLS
 
 #endif
@@ -21,6 +21,7 @@
 
 #include "emv_oda.h"
 #include "emv.h"
+#include "emv_utils_config.h"
 #include "emv_tlv.h"
 #include "emv_tags.h"
 #include "emv_fields.h"
@@ -40,6 +41,53 @@
 #include <stdlib.h> // For malloc() and free()
 #include <string.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+struct emv_oda_pipeline_t {
+	uint8_t rid[EMV_CAPK_RID_LEN];
+	uint8_t capk_index;
+	bool started;
+	bool joined;
+	pthread_t thread;
+
+	// Worker input
+	struct emv_capk_ref_t capk_ref;
+	const struct emv_capk_t* capk;
+	uint8_t hash[SHA1_SIZE];
+	struct emv_tlv_list_t icc;
+	struct emv_tlv_list_t params;
+	struct emv_debug_config_t debug_config;
+
+	// Worker output
+	int result;
+	struct emv_rsa_issuer_pkey_t pkey;
+};
+#endif
+
+static int emv_oda_ipk_cache_hash(
+	const struct emv_capk_t* capk,
+	const struct emv_tlv_t* ipk_cert,
+	const struct emv_tlv_list_t* icc,
+	uint8_t* hash
+);
+#ifdef HAVE_PTHREAD
+static void emv_oda_pipeline_disable(struct emv_oda_pipeline_t* pipeline);
+#endif
+static void emv_oda_pipeline_release(struct emv_oda_ctx_t* ctx);
+static int emv_oda_apply_dda_prepare(
+	struct emv_ctx_t* ctx,
+	uint8_t* ddol_data,
+	size_t* ddol_data_len
+);
+static int emv_oda_apply_dda_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* list,
+	const uint8_t* ddol_data,
+	size_t ddol_data_len
+);
+
 int emv_oda_init(struct emv_oda_ctx_t* ctx)
 {
 	if (!ctx) {
@@ -104,16 +152,21 @@ int emv_oda_prepare_records(
 		return EMV_ODA_ERROR_AFL_INVALID;
 	}
 
-	// Allocate enough space for the total number of full length records
-	// that are intended for offline data authentication, as well as the
-	// encoded AIP, AID (terminal) and PDOL. Assume that the encoded fields
-	// cannot exceed two R-APDU responses in total.
+	// Allocate space for a single full length record and grow the buffer as
+	// records are appended. The static data to be authenticated cannot be
+	// hashed as records arrive because the hash input starts with data that
+	// is only recovered from the SSAD or ICC public key certificate after all
+	// records have been read, but most records are much shorter than the
+	// maximum R-APDU length and the buffer need not allow for the worst case.
+	// See EMV 4.4 Book 2, 5.4, step 5
+	// See EMV 4.4 Book 2, 6.4, step 5
 	// See EMV 4.4 Book 3, 10.3 (page 98)
-	ctx->record_buf = malloc(EMV_RAPDU_DATA_MAX * (oda_record_count + 2));
+	ctx->record_buf = malloc(EMV_RAPDU_DATA_MAX);
 	if (!ctx->record_buf) {
 		emv_debug_error("Failed to allocate ODA buffer");
 		return EMV_ODA_ERROR_INTERNAL;
 	}
+	ctx->record_buf_size = EMV_RAPDU_DATA_MAX;
 
 	return 0;
 }
@@ -132,6 +185,9 @@ int emv_oda_clear_records(struct emv_oda_ctx_t* ctx)
 	}
 	ctx->record_buf = NULL;
 	ctx->record_buf_len = 0;
+	ctx->record_buf_size = 0;
+
+	emv_oda_pipeline_release(ctx);
 
 	return 0;
 }
@@ -150,6 +206,307 @@ int emv_oda_clear(struct emv_oda_ctx_t* ctx)
 	return 0;
 }
 
+#ifdef HAVE_PTHREAD
+static void* emv_oda_pipeline_worker(void* arg)
+{
+	struct emv_oda_pipeline_t* pipeline = arg;
+	const struct emv_tlv_t* ipk_cert;
+
+	// Emit debug events according to the configuration of the thread that
+	// started the worker, including suppression of debug events
+	emv_debug_set_thread_config(&pipeline->debug_config);
+
+	ipk_cert = emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE);
+	pipeline->result = emv_rsa_retrieve_issuer_pkey(
+		ipk_cert->value,
+		ipk_cert->length,
+		pipeline->capk,
+		&pipeline->icc,
+		&pipeline->params,
+		&pipeline->pkey
+	);
+
+	return NULL;
+}
+#endif
+
+int emv_oda_enable_pipeline(
+	struct emv_oda_ctx_t* ctx,
+	const uint8_t* rid,
+	const struct emv_tlv_list_t* params
+)
+{
+#ifdef HAVE_PTHREAD
+	int r;
+	struct emv_oda_pipeline_t* pipeline;
+	const struct emv_tlv_t* txn_date;
+
+	if (!ctx || !rid || !params) {
+		emv_debug_trace_msg("ctx=%p, rid=%p, params=%p", ctx, rid, params);
+		emv_debug_error("Invalid parameter");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+
+	emv_oda_pipeline_release(ctx);
+
+	pipeline = calloc(1, sizeof(*pipeline));
+	if (!pipeline) {
+		emv_debug_error("Failed to allocate ODA pipeline");
+		return EMV_ODA_ERROR_INTERNAL;
+	}
+	memcpy(pipeline->rid, rid, sizeof(pipeline->rid));
+
+	// Copy transaction date because the worker thread may not access the
+	// transaction parameters while the transaction is in progress
+	txn_date = emv_tlv_list_find_const(params, EMV_TAG_9A_TRANSACTION_DATE);
+	if (txn_date) {
+		r = emv_tlv_list_push(&pipeline->params, txn_date->tag, txn_date->length, txn_date->value, 0);
+		if (r) {
+			emv_debug_trace_msg("emv_tlv_list_push() failed; r=%d", r);
+			emv_debug_error("Internal error");
+			free(pipeline);
+			return EMV_ODA_ERROR_INTERNAL;
+		}
+	}
+
+	ctx->pipeline = pipeline;
+	return 0;
+
+#else
+	if (!ctx || !rid || !params) {
+		emv_debug_trace_msg("ctx=%p, rid=%p, params=%p", ctx, rid, params);
+		emv_debug_error("Invalid parameter");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+
+	// Pipelining not supported without thread support
+	return 1;
+#endif
+}
+
+int emv_oda_update_pipeline(
+	struct emv_oda_ctx_t* ctx,
+	const struct emv_tlv_list_t* list
+)
+{
+#ifdef HAVE_PTHREAD
+	int r;
+	struct emv_oda_pipeline_t* pipeline;
+	const struct emv_tlv_t* capk_index;
+	const unsigned int tags[] = {
+		EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX,
+		EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE,
+		EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER,
+		EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT,
+		EMV_TAG_5A_APPLICATION_PAN,
+	};
+
+	if (!ctx || !list) {
+		emv_debug_trace_msg("ctx=%p, list=%p", ctx, list);
+		emv_debug_error("Invalid parameter");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+
+	pipeline = ctx->pipeline;
+	if (!pipeline || pipeline->started) {
+		// Pipelining not enabled or already started
+		return 0;
+	}
+
+	// Copy fields because the worker thread may not access the application
+	// data while records are being read. Fields are accumulated across calls
+	// because they may be provided by the GPO response as well as by
+	// different records.
+	for (size_t i = 0; i < sizeof(tags) / sizeof(tags[0]); ++i) {
+		const struct emv_tlv_t* tlv;
+
+		if (emv_tlv_list_find_const(&pipeline->icc, tags[i])) {
+			// Retain the field that was provided first
+			continue;
+		}
+		tlv = emv_tlv_list_find_const(list, tags[i]);
+		if (!tlv) {
+			continue;
+		}
+		r = emv_tlv_list_push(&pipeline->icc, tlv->tag, tlv->length, tlv->value, 0);
+		if (r) {
+			emv_debug_trace_msg("emv_tlv_list_push() failed; r=%d", r);
+			emv_debug_error("Internal error");
+			emv_oda_pipeline_disable(pipeline);
+			return EMV_ODA_ERROR_INTERNAL;
+		}
+	}
+
+	// Issuer public key recovery requires fields 8F, 90 and 9F32, and
+	// validation of the issuer identifier requires field 5A. Field 92 is
+	// optional and if it is only read later, the outcome of the worker thread
+	// will not match and will be ignored.
+	// See EMV 4.4 Book 2, 5.3
+	capk_index = emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX);
+	if (!capk_index ||
+		!emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE) ||
+		!emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT) ||
+		!emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_5A_APPLICATION_PAN)
+	) {
+		// Not ready yet
+		return 0;
+	}
+	if (capk_index->length != 1) {
+		// Leave it to offline data authentication to report invalid field
+		emv_oda_pipeline_disable(pipeline);
+		return 0;
+	}
+
+	// Retain CAPK until the worker thread is joined in case the CAPK store is
+	// updated concurrently
+	pipeline->capk_index = capk_index->value[0];
+	pipeline->capk = emv_capk_acquire(pipeline->rid, pipeline->capk_index, &pipeline->capk_ref);
+	if (!pipeline->capk) {
+		// Leave it to offline data authentication to report missing CAPK
+		emv_oda_pipeline_disable(pipeline);
+		return 0;
+	}
+
+	r = emv_oda_ipk_cache_hash(
+		pipeline->capk,
+		emv_tlv_list_find_const(&pipeline->icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE),
+		&pipeline->icc,
+		pipeline->hash
+	);
+	if (r) {
+		emv_debug_trace_msg("emv_oda_ipk_cache_hash() failed; r=%d", r);
+		emv_debug_error("Internal error");
+		emv_oda_pipeline_disable(pipeline);
+		return EMV_ODA_ERROR_INTERNAL;
+	}
+
+	// Worker thread emits debug events on behalf of the current thread
+	emv_debug_get_thread_config(&pipeline->debug_config);
+
+	r = pthread_create(&pipeline->thread, NULL, &emv_oda_pipeline_worker, pipeline);
+	if (r) {
+		emv_debug_trace_msg("pthread_create() failed; r=%d", r);
+		emv_debug_error("Internal error");
+		emv_oda_pipeline_disable(pipeline);
+		return EMV_ODA_ERROR_INTERNAL;
+	}
+	pipeline->started = true;
+	emv_debug_info("Started pipelined issuer public key recovery");
+
+	return 0;
+
+#else
+	if (!ctx || !list) {
+		emv_debug_trace_msg("ctx=%p, list=%p", ctx, list);
+		emv_debug_error("Invalid parameter");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+
+	// Pipelining not supported without thread support
+	return 0;
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+static void emv_oda_pipeline_disable(struct emv_oda_pipeline_t* pipeline)
+{
+	// Mark pipeline as completed without an outcome such that the issuer
+	// public key recovery is performed by offline data authentication
+	pipeline->started = true;
+	pipeline->joined = true;
+	pipeline->result = -1;
+	emv_capk_release(&pipeline->capk_ref);
+	pipeline->capk = NULL;
+	emv_tlv_list_clear(&pipeline->icc);
+}
+#endif
+
+static int emv_oda_pipeline_get_issuer_pkey(
+	struct emv_oda_ctx_t* ctx,
+	const struct emv_capk_t* capk,
+	const struct emv_tlv_t* ipk_cert,
+	const struct emv_tlv_list_t* icc,
+	struct emv_rsa_issuer_pkey_t* ipk
+)
+{
+#ifdef HAVE_PTHREAD
+	int r;
+	struct emv_oda_pipeline_t* pipeline = ctx->pipeline;
+	uint8_t hash[SHA1_SIZE];
+
+	if (!pipeline || !pipeline->started) {
+		// Pipelining not enabled or not started
+		return 1;
+	}
+
+	if (!pipeline->joined) {
+		r = pthread_join(pipeline->thread, NULL);
+		if (r) {
+			emv_debug_trace_msg("pthread_join() failed; r=%d", r);
+			return -1;
+		}
+		pipeline->joined = true;
+	}
+
+	// Only use the outcome of the worker thread if it succeeded and the
+	// current CAPK and fields are the same as those used by the worker thread.
+	// The CAPK is identified by RID and index while the hash includes the
+	// CAPK modulus in case the CAPK was replaced. Otherwise repeat the
+	// recovery to obtain the appropriate outcome.
+	if (pipeline->result ||
+		pipeline->capk_index != capk->index ||
+		memcmp(pipeline->rid, capk->rid, sizeof(pipeline->rid)) != 0
+	) {
+		return 2;
+	}
+	r = emv_oda_ipk_cache_hash(capk, ipk_cert, icc, hash);
+	if (r) {
+		emv_debug_trace_msg("emv_oda_ipk_cache_hash() failed; r=%d", r);
+		return -2;
+	}
+	if (crypto_memcmp_s(hash, pipeline->hash, sizeof(hash)) != 0) {
+		return 3;
+	}
+
+	*ipk = pipeline->pkey;
+	return 0;
+
+#else
+	(void)ctx;
+	(void)capk;
+	(void)ipk_cert;
+	(void)icc;
+	(void)ipk;
+
+	// Pipelining not supported without thread support
+	return 1;
+#endif
+}
+
+static void emv_oda_pipeline_release(struct emv_oda_ctx_t* ctx)
+{
+#ifdef HAVE_PTHREAD
+	struct emv_oda_pipeline_t* pipeline = ctx->pipeline;
+
+	if (!pipeline) {
+		return;
+	}
+
+	if (pipeline->started && !pipeline->joined) {
+		pthread_join(pipeline->thread, NULL);
+	}
+	emv_capk_release(&pipeline->capk_ref);
+	emv_tlv_list_clear(&pipeline->icc);
+	emv_tlv_list_clear(&pipeline->params);
+
+	// Cleanse pipeline because it contains the PAN
+	crypto_cleanse(pipeline, sizeof(*pipeline));
+	free(pipeline);
+#endif
+
+	ctx->pipeline = NULL;
+}
+
 int emv_oda_append_record(
 	struct emv_oda_ctx_t* ctx,
 	const void* record,
@@ -174,6 +531,28 @@ int emv_oda_append_record(
 		return EMV_ODA_ERROR_INVALID_PARAMETER;
 	}
 
+	if (ctx->record_buf_len + record_len > ctx->record_buf_size) {
+		unsigned int new_size;
+		uint8_t* new_buf;
+
+		// Grow buffer geometrically and cleanse the previous buffer because
+		// realloc() does not allow for that
+		new_size = ctx->record_buf_size * 2;
+		if (new_size < ctx->record_buf_len + record_len) {
+			new_size = ctx->record_buf_len + record_len;
+		}
+		new_buf = malloc(new_size);
+		if (!new_buf) {
+			emv_debug_error("Failed to allocate ODA buffer");
+			return EMV_ODA_ERROR_INTERNAL;
+		}
+		memcpy(new_buf, ctx->record_buf, ctx->record_buf_len);
+		crypto_cleanse(ctx->record_buf, ctx->record_buf_len);
+		free(ctx->record_buf);
+		ctx->record_buf = new_buf;
+		ctx->record_buf_size = new_size;
+	}
+
 	memcpy(ctx->record_buf + ctx->record_buf_len, record, record_len);
 	ctx->record_buf_len += record_len;
 
@@ -185,8 +564,41 @@ int emv_oda_apply(
 	const uint8_t* term_caps
 )
 {
-	if (!ctx || !term_caps) {
-		emv_debug_trace_msg("ctx=%p, term_caps=%p", ctx, term_caps);
+	int r;
+	uint8_t ddol_data[EMV_CAPDU_DATA_MAX];
+	size_t ddol_data_len = sizeof(ddol_data);
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+
+	r = emv_oda_apply_prepare(ctx, term_caps, ddol_data, &ddol_data_len);
+	if (r || !ddol_data_len) {
+		return r;
+	}
+
+	// Authenticate ICC
+	// See EMV 4.4 Book 2, 6.5.1
+	r = emv_tal_internal_authenticate(
+		ctx->ttl,
+		ddol_data,
+		ddol_data_len,
+		&list
+	);
+
+	return emv_oda_apply_finalise(ctx, r, &list, ddol_data, ddol_data_len);
+}
+
+int emv_oda_apply_prepare(
+	struct emv_ctx_t* ctx,
+	const uint8_t* term_caps,
+	uint8_t* ddol_data,
+	size_t* ddol_data_len
+)
+{
+	size_t ddol_data_size;
+
+	if (!ctx || !term_caps || !ddol_data || !ddol_data_len) {
+		emv_debug_trace_msg("ctx=%p, term_caps=%p, ddol_data=%p, ddol_data_len=%p",
+			ctx, term_caps, ddol_data, ddol_data_len
+		);
 		emv_debug_error("Invalid parameter");
 		return EMV_ODA_ERROR_INVALID_PARAMETER;
 	}
@@ -198,6 +610,11 @@ int emv_oda_apply(
 		return EMV_ODA_ERROR_INVALID_PARAMETER;
 	}
 
+	// Only Dynamic Data Authentication (DDA) requires INTERNAL AUTHENTICATE
+	// and the other methods complete without it
+	ddol_data_size = *ddol_data_len;
+	*ddol_data_len = 0;
+
 	// Determine whether Extended Data Authentication (XDA) is supported by
 	// both the terminal and the card. If so, apply it.
 	// See EMV 4.4 Book 3, 10.3 (page 96)
@@ -227,7 +644,8 @@ int emv_oda_apply(
 		ctx->aip->value[0] & EMV_AIP_DDA_SUPPORTED
 	) {
 		ctx->oda.method = EMV_ODA_METHOD_DDA;
-		return emv_oda_apply_dda(ctx);
+		*ddol_data_len = ddol_data_size;
+		return emv_oda_apply_dda_prepare(ctx, ddol_data, ddol_data_len);
 	}
 
 	// Determine whether Static Data Authentication (SDA) is supported by both
@@ -252,6 +670,196 @@ int emv_oda_apply(
 	return EMV_ODA_NO_SUPPORTED_METHOD;
 }
 
+int emv_oda_apply_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* list,
+	const uint8_t* ddol_data,
+	size_t ddol_data_len
+)
+{
+	if (!ctx || !list || !ddol_data || !ddol_data_len) {
+		emv_debug_trace_msg("ctx=%p, list=%p, ddol_data=%p, ddol_data_len=%zu",
+			ctx, list, ddol_data, ddol_data_len
+		);
+		emv_debug_error("Invalid parameter");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+	if (ctx->oda.method != EMV_ODA_METHOD_DDA || !ctx->tvr) {
+		emv_debug_trace_msg("method=%d, tvr=%p", ctx->oda.method, ctx->tvr);
+		emv_debug_error("Invalid context variable");
+		return EMV_ODA_ERROR_INVALID_PARAMETER;
+	}
+
+	return emv_oda_apply_dda_finalise(ctx, r, list, ddol_data, ddol_data_len);
+}
+
+void emv_oda_ipk_cache_clear(struct emv_oda_ipk_cache_t* cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	// Cleanse issuer public keys because they contain up to 8 PAN digits
+	crypto_cleanse(cache, sizeof(*cache));
+}
+
+static int emv_oda_ipk_cache_hash(
+	const struct emv_capk_t* capk,
+	const struct emv_tlv_t* ipk_cert,
+	const struct emv_tlv_list_t* icc,
+	uint8_t* hash
+)
+{
+	int r;
+	crypto_sha1_ctx_t sha1_ctx = NULL;
+	const struct emv_tlv_t* tlv_list[3];
+
+	tlv_list[0] = ipk_cert;
+	tlv_list[1] = emv_tlv_list_find_const(icc, EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER);
+	tlv_list[2] = emv_tlv_list_find_const(icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT);
+
+	r = crypto_sha1_init(&sha1_ctx);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_init() failed; r=%d", r);
+		r = -1;
+		goto exit;
+	}
+
+	// Hash the length of each field, or zero if absent, followed by its value
+	// to ensure that different combinations of fields have different hashes
+	for (size_t i = 0; i < sizeof(tlv_list) / sizeof(tlv_list[0]); ++i) {
+		const struct emv_tlv_t* tlv = tlv_list[i];
+		uint8_t len[2] = { 0 };
+
+		if (tlv) {
+			len[0] = tlv->length >> 8;
+			len[1] = tlv->length;
+		}
+		r = crypto_sha1_update(&sha1_ctx, len, sizeof(len));
+		if (r) {
+			emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+			r = -2;
+			goto exit;
+		}
+
+		if (tlv && tlv->length) {
+			r = crypto_sha1_update(&sha1_ctx, tlv->value, tlv->length);
+			if (r) {
+				emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+				r = -3;
+				goto exit;
+			}
+		}
+	}
+
+	// Include CAPK modulus in case CAPK is replaced
+	r = crypto_sha1_update(&sha1_ctx, capk->modulus, capk->modulus_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -4;
+		goto exit;
+	}
+
+	r = crypto_sha1_finish(&sha1_ctx, hash);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_finish() failed; r=%d", r);
+		r = -5;
+		goto exit;
+	}
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	return r;
+}
+
+static int emv_oda_retrieve_issuer_pkey(
+	struct emv_ctx_t* ctx,
+	const struct emv_capk_t* capk,
+	const struct emv_tlv_t* ipk_cert,
+	struct emv_rsa_issuer_pkey_t* ipk
+)
+{
+	int r;
+	struct emv_oda_ipk_cache_t* cache = ctx->ipk_cache;
+	uint8_t hash[SHA1_SIZE];
+	struct emv_oda_ipk_cache_entry_t* entry;
+
+	if (cache) {
+		r = emv_oda_ipk_cache_hash(capk, ipk_cert, &ctx->icc, hash);
+		if (r) {
+			emv_debug_trace_msg("emv_oda_ipk_cache_hash() failed; r=%d", r);
+			// Continue without issuer public key cache
+			cache = NULL;
+		}
+	}
+
+	if (cache) {
+		for (size_t i = 0; i < EMV_ODA_IPK_CACHE_SIZE; ++i) {
+			entry = &cache->entries[i];
+
+			if (entry->last_used &&
+				entry->index == capk->index &&
+				memcmp(entry->rid, capk->rid, sizeof(entry->rid)) == 0 &&
+				memcmp(entry->hash, hash, sizeof(entry->hash)) == 0
+			) {
+				emv_debug_info("Using cached issuer public key");
+				entry->last_used = ++cache->tick;
+				*ipk = entry->pkey;
+
+				// Cached issuer public key was validated for a previous card
+				// and transaction
+				return emv_rsa_validate_issuer_pkey(ipk, &ctx->icc, &ctx->params);
+			}
+		}
+	}
+
+	r = emv_oda_pipeline_get_issuer_pkey(&ctx->oda, capk, ipk_cert, &ctx->icc, ipk);
+	if (r == 0) {
+		emv_debug_info("Using pipelined issuer public key");
+
+		// Pipelined issuer public key was validated using the same fields
+		// but repeat the validation against the current fields
+		r = emv_rsa_validate_issuer_pkey(ipk, &ctx->icc, &ctx->params);
+	} else {
+		if (r < 0) {
+			emv_debug_trace_msg("emv_oda_pipeline_get_issuer_pkey() failed; r=%d", r);
+			// Continue without pipelined issuer public key
+		}
+
+		r = emv_rsa_retrieve_issuer_pkey(
+			ipk_cert->value,
+			ipk_cert->length,
+			capk,
+			&ctx->icc,
+			&ctx->params,
+			ipk
+		);
+	}
+	if (r || !cache) {
+		return r;
+	}
+
+	// Replace unused or least recently used entry
+	entry = &cache->entries[0];
+	for (size_t i = 0; i < EMV_ODA_IPK_CACHE_SIZE; ++i) {
+		if (cache->entries[i].last_used < entry->last_used) {
+			entry = &cache->entries[i];
+		}
+	}
+	memcpy(entry->rid, capk->rid, sizeof(entry->rid));
+	entry->index = capk->index;
+	memcpy(entry->hash, hash, sizeof(entry->hash));
+	entry->pkey = *ipk;
+	entry->last_used = ++cache->tick;
+
+	return 0;
+}
+
 int emv_oda_apply_sda(struct emv_ctx_t* ctx)
 {
 	int r;
@@ -260,6 +868,7 @@ int emv_oda_apply_sda(struct emv_ctx_t* ctx)
 	const struct emv_tlv_t* ipk_exp;
 	const struct emv_tlv_t* enc_ssad;
 	const struct emv_tlv_t* sdatl;
+	struct emv_capk_ref_t capk_ref = { NULL };
 	const struct emv_capk_t* capk;
 	struct emv_rsa_issuer_pkey_t ipk;
 	struct emv_rsa_ssad_t ssad;
@@ -334,9 +943,10 @@ int emv_oda_apply_sda(struct emv_ctx_t* ctx)
 		}
 	}
 
-	// Retrieve Certificate Authority Public Key (CAPK)
+	// Retrieve Certificate Authority Public Key (CAPK) and retain it in case
+	// the CAPK store is updated concurrently
 	// See EMV 4.4 Book 2, 5.2
-	capk = emv_capk_lookup(ctx->aid->value, capk_index->value[0]);
+	capk = emv_capk_acquire(ctx->aid->value, capk_index->value[0], &capk_ref);
 	if (!capk) {
 		emv_debug_error(
 			"CAPK %02X%02X%02X%02X%02X #%02X not found",
@@ -361,16 +971,9 @@ int emv_oda_apply_sda(struct emv_ctx_t* ctx)
 
 	// Retrieve issuer public key
 	// See EMV 4.4 Book 2, 5.3
-	r = emv_rsa_retrieve_issuer_pkey(
-		ipk_cert->value,
-		ipk_cert->length,
-		capk,
-		&ctx->icc,
-		&ctx->params,
-		&ipk
-	);
+	r = emv_oda_retrieve_issuer_pkey(ctx, capk, ipk_cert, &ipk);
 	if (r) {
-		emv_debug_trace_msg("emv_rsa_retrieve_issuer_pkey() failed; r=%d", r);
+		emv_debug_trace_msg("emv_oda_retrieve_issuer_pkey() failed; r=%d", r);
 		emv_debug_error("Failed to retrieve issuer public key");
 		// EMV_TVR_SDA_FAILED already set in TVR
 		r = EMV_ODA_SDA_FAILED;
@@ -441,6 +1044,7 @@ int emv_oda_apply_sda(struct emv_ctx_t* ctx)
 exit:
 	// Cleanse issuer public key because it contains up to 8 PAN digits
 	crypto_cleanse(&ipk, sizeof(ipk));
+	emv_capk_release(&capk_ref);
 	return r;
 }
 
@@ -453,6 +1057,7 @@ static int emv_oda_apply_sad_auth(struct emv_ctx_t* ctx, struct emv_rsa_icc_pkey
 	const struct emv_tlv_t* icc_cert;
 	const struct emv_tlv_t* icc_exp;
 	const struct emv_tlv_t* sdatl;
+	struct emv_capk_ref_t capk_ref = { NULL };
 	const struct emv_capk_t* capk;
 	struct emv_rsa_issuer_pkey_t ipk;
 
@@ -503,9 +1108,10 @@ static int emv_oda_apply_sad_auth(struct emv_ctx_t* ctx, struct emv_rsa_icc_pkey
 		}
 	}
 
-	// Retrieve Certificate Authority Public Key (CAPK)
+	// Retrieve Certificate Authority Public Key (CAPK) and retain it in case
+	// the CAPK store is updated concurrently
 	// See EMV 4.4 Book 2, 6.2
-	capk = emv_capk_lookup(ctx->aid->value, capk_index->value[0]);
+	capk = emv_capk_acquire(ctx->aid->value, capk_index->value[0], &capk_ref);
 	if (!capk) {
 		emv_debug_error(
 			"CAPK %02X%02X%02X%02X%02X #%02X not found",
@@ -529,16 +1135,9 @@ static int emv_oda_apply_sad_auth(struct emv_ctx_t* ctx, struct emv_rsa_icc_pkey
 
 	// Retrieve issuer public key
 	// See EMV 4.4 Book 2, 6.3
-	r = emv_rsa_retrieve_issuer_pkey(
-		ipk_cert->value,
-		ipk_cert->length,
-		capk,
-		&ctx->icc,
-		&ctx->params,
-		&ipk
-	);
+	r = emv_oda_retrieve_issuer_pkey(ctx, capk, ipk_cert, &ipk);
 	if (r) {
-		emv_debug_trace_msg("emv_rsa_retrieve_issuer_pkey() failed; r=%d", r);
+		emv_debug_trace_msg("emv_oda_retrieve_issuer_pkey() failed; r=%d", r);
 		if (r < 0) {
 			emv_debug_error("Failed to retrieve issuer public key");
 		} else {
@@ -589,24 +1188,24 @@ static int emv_oda_apply_sad_auth(struct emv_ctx_t* ctx, struct emv_rsa_icc_pkey
 exit:
 	// Cleanse issuer public key because it contains up to 8 PAN digits
 	crypto_cleanse(&ipk, sizeof(ipk));
+	emv_capk_release(&capk_ref);
 	return r;
 }
 
-int emv_oda_apply_dda(struct emv_ctx_t* ctx)
+static int emv_oda_apply_dda_prepare(
+	struct emv_ctx_t* ctx,
+	uint8_t* ddol_data,
+	size_t* ddol_data_len
+)
 {
 	int r;
 	const struct emv_tlv_t* un;
 	struct emv_rsa_icc_pkey_t icc_pkey;
 	const struct emv_tlv_t* ddol;
 	struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
-	uint8_t ddol_data_buf[EMV_CAPDU_DATA_MAX];
-	size_t ddol_data_len = sizeof(ddol_data_buf);
-	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
-	const struct emv_tlv_t* enc_sdad;
-	struct emv_rsa_sdad_t sdad;
 
-	if (!ctx) {
-		emv_debug_trace_msg("ctx=%p", ctx);
+	if (!ctx || !ddol_data || !ddol_data_len) {
+		emv_debug_trace_msg("ctx=%p, ddol_data=%p, ddol_data_len=%p", ctx, ddol_data, ddol_data_len);
 		emv_debug_error("Invalid parameter");
 		return EMV_ODA_ERROR_INVALID_PARAMETER;
 	}
@@ -713,34 +1312,57 @@ int emv_oda_apply_dda(struct emv_ctx_t* ctx)
 	if (r) {
 		emv_debug_trace_msg("emv_tlv_sources_init_from_ctx() failed; r=%d", r);
 		emv_debug_error("Failed to build DDOL sources");
-		return EMV_ERROR_INTERNAL;
+		r = EMV_ERROR_INTERNAL;
+		goto exit;
 	}
+	// Use merged tag index to avoid searching each source per DOL entry
+	emv_tlv_sources_enable_index(&sources, &ctx->sources_index);
 
 	// Build DDOL data
 	// See EMV 4.4 Book 3, 5.4
-	r = emv_dol_build_data(
+	r = emv_dol_cache_build_data(
+		&ctx->dol_cache,
 		ddol->value,
 		ddol->length,
 		&sources,
-		ddol_data_buf,
-		&ddol_data_len
+		ddol_data,
+		ddol_data_len
 	);
 	if (r) {
-		emv_debug_trace_msg("emv_dol_build_data() failed; r=%d", r);
+		emv_debug_trace_msg("emv_dol_cache_build_data() failed; r=%d", r);
 		emv_debug_error("Failed to build DDOL data");
 		// EMV_TVR_DDA_FAILED already set in TVR
 		r = EMV_ODA_DDA_FAILED;
 		goto exit;
 	}
 
-	// Authenticate ICC
-	// See EMV 4.4 Book 2, 6.5.1
-	r = emv_tal_internal_authenticate(
-		ctx->ttl,
-		ddol_data_buf,
-		ddol_data_len,
-		&list
-	);
+	// Retain ICC public key until INTERNAL AUTHENTICATE response is available
+	ctx->oda.icc_pkey = icc_pkey;
+	r = 0;
+	goto exit;
+
+exit:
+	if (r) {
+		// No INTERNAL AUTHENTICATE required
+		*ddol_data_len = 0;
+	}
+
+	// Cleanse ICC public key because it contains the PAN
+	crypto_cleanse(&icc_pkey, sizeof(icc_pkey));
+	return r;
+}
+
+static int emv_oda_apply_dda_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* list,
+	const uint8_t* ddol_data,
+	size_t ddol_data_len
+)
+{
+	const struct emv_tlv_t* enc_sdad;
+	struct emv_rsa_sdad_t sdad;
+
 	if (r) {
 		emv_debug_trace_msg("emv_tal_internal_authenticate() failed; r=%d", r);
 		emv_debug_error("Error during dynamic data authentication");
@@ -755,7 +1377,7 @@ int emv_oda_apply_dda(struct emv_ctx_t* ctx)
 		// See EMV 4.4 Book 3, 6.5.9.4
 		goto exit;
 	}
-	enc_sdad = emv_tlv_list_find_const(&list, EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA);
+	enc_sdad = emv_tlv_list_find_const(list, EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA);
 	if (!enc_sdad) {
 		// Presence of SDAD should have been confirmed by
 		// emv_tal_internal_authenticate()
@@ -769,8 +1391,8 @@ int emv_oda_apply_dda(struct emv_ctx_t* ctx)
 	r = emv_rsa_retrieve_sdad(
 		enc_sdad->value,
 		enc_sdad->length,
-		&icc_pkey,
-		ddol_data_buf,
+		&ctx->oda.icc_pkey,
+		ddol_data,
 		ddol_data_len,
 		&sdad
 	);
@@ -788,7 +1410,7 @@ int emv_oda_apply_dda(struct emv_ctx_t* ctx)
 	emv_debug_info("Valid Signed Dynamic Application Data hash");
 
 	// Append INTERNAL AUTHENTICATE output to ICC data list
-	r = emv_tlv_list_append(&ctx->icc, &list);
+	r = emv_tlv_list_append(&ctx->icc, list);
 	if (r) {
 		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
 
@@ -822,11 +1444,37 @@ int emv_oda_apply_dda(struct emv_ctx_t* ctx)
 	goto exit;
 
 exit:
+	emv_tlv_list_clear(list);
+
 	// Cleanse ICC public key because it contains the PAN
-	crypto_cleanse(&icc_pkey, sizeof(icc_pkey));
+	crypto_cleanse(&ctx->oda.icc_pkey, sizeof(ctx->oda.icc_pkey));
 	return r;
 }
 
+int emv_oda_apply_dda(struct emv_ctx_t* ctx)
+{
+	int r;
+	uint8_t ddol_data[EMV_CAPDU_DATA_MAX];
+	size_t ddol_data_len = sizeof(ddol_data);
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+
+	r = emv_oda_apply_dda_prepare(ctx, ddol_data, &ddol_data_len);
+	if (r) {
+		return r;
+	}
+
+	// Authenticate ICC
+	// See EMV 4.4 Book 2, 6.5.1
+	r = emv_tal_internal_authenticate(
+		ctx->ttl,
+		ddol_data,
+		ddol_data_len,
+		&list
+	);
+
+	return emv_oda_apply_dda_finalise(ctx, r, &list, ddol_data, ddol_data_len);
+}
+
 int emv_oda_apply_cda(struct emv_ctx_t* ctx)
 {
 	int r;
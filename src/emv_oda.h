@@ -2,7 +2,7 @@
  * @file emv_oda.h
  * @brief EMV Offline Data Authentication (ODA) helper functions
  *
- * Copyright 2025 Leon Lynch
+ * Copyright 2025-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -23,6 +23,7 @@
 #define EMV_ODA_H
 
 #include "emv_oda_types.h"
+#include "emv_rsa.h"
 
 #include <sys/cdefs.h>
 #include <stddef.h>
@@ -61,6 +62,47 @@ enum emv_oda_result_t {
 	EMV_ODA_CDA_FAILED, ///< Combined DDA/Application Cryptogram Generation (CDA) failed
 };
 
+/// Number of entries in issuer public key cache
+#define EMV_ODA_IPK_CACHE_SIZE (16)
+
+/**
+ * Issuer public key cache
+ *
+ * Bounded cache of issuer public keys that were previously retrieved and
+ * validated by @ref emv_rsa_retrieve_issuer_pkey(), such that the CAPK RSA
+ * operation can be avoided for subsequent cards having the same issuer
+ * certificate. Entries are keyed by the CAPK RID and index, as well as a
+ * hash of the Issuer Public Key Certificate (field 90), Issuer Public Key
+ * Remainder (field 92), Issuer Public Key Exponent (field 9F32) and CAPK
+ * modulus. When the cache is full, the least recently used entry is replaced.
+ *
+ * The issuer identifier and certificate expiration date are validated using
+ * @ref emv_rsa_validate_issuer_pkey() whenever an entry is used.
+ *
+ * @note Initialise by zeroing the cache and release using
+ *       @ref emv_oda_ipk_cache_clear(). Provide to EMV processing using
+ *       @ref emv_ctx_t.ipk_cache.
+ * @note The cache should not be used concurrently by multiple threads.
+ */
+struct emv_oda_ipk_cache_t {
+	/// @cond INTERNAL
+	unsigned long tick;
+	struct emv_oda_ipk_cache_entry_t {
+		unsigned long last_used;
+		uint8_t rid[5];
+		uint8_t index;
+		uint8_t hash[20];
+		struct emv_rsa_issuer_pkey_t pkey;
+	} entries[EMV_ODA_IPK_CACHE_SIZE];
+	/// @endcond
+};
+
+/**
+ * Clear issuer public key cache
+ * @param cache Issuer public key cache
+ */
+void emv_oda_ipk_cache_clear(struct emv_oda_ipk_cache_t* cache);
+
 /**
  * Initialise Offline Data Authentication (ODA) context
  *
@@ -113,6 +155,56 @@ int emv_oda_clear_records(struct emv_oda_ctx_t* ctx);
  */
 int emv_oda_clear(struct emv_oda_ctx_t* ctx);
 
+/**
+ * Enable pipelined recovery of the issuer public key for the application
+ * records that will subsequently be read. Once the application data provided
+ * to @ref emv_oda_update_pipeline() contains the fields required for issuer
+ * public key recovery, the recovery will be performed on a worker thread
+ * while the remaining application records are read. The outcome will be used
+ * by the subsequent offline data authentication if the fields still match.
+ *
+ * This function must be called after @ref emv_oda_prepare_records() and the
+ * worker thread will be joined by @ref emv_oda_clear_records().
+ *
+ * @param ctx Offline Data Authentication (ODA) context
+ * @param rid Registered Application Provider Identifier (RID) of the current
+ *            application. Must be 5 bytes.
+ * @param params Transaction parameters used for issuer public key validation.
+ *               See @ref emv_rsa_retrieve_issuer_pkey().
+ *
+ * @return Zero for success.
+ * @return Less than zero for error. See @ref emv_oda_error_t
+ * @return Greater than zero if not supported by this build.
+ */
+int emv_oda_enable_pipeline(
+	struct emv_oda_ctx_t* ctx,
+	const uint8_t* rid,
+	const struct emv_tlv_list_t* params
+);
+
+/**
+ * Provide application data that has been read so far for pipelined recovery
+ * of the issuer public key. This function does nothing unless
+ * @ref emv_oda_enable_pipeline() was called, and starts the worker thread once
+ * the Certificate Authority Public Key Index (field 8F), Issuer Public Key
+ * Certificate (field 90), Issuer Public Key Exponent (field 9F32) and
+ * Application PAN (field 5A) are available. These fields are accumulated
+ * across calls such that they may be provided by the GPO response as well as
+ * by the application records. The worker thread retains the CAPK and emits
+ * debug events according to the debug configuration of the calling thread.
+ * See @ref emv_debug_get_thread_config().
+ *
+ * @param ctx Offline Data Authentication (ODA) context
+ * @param list Application data that has been read so far
+ *
+ * @return Zero for success, including when the worker thread was not started.
+ * @return Less than zero for error. See @ref emv_oda_error_t
+ */
+int emv_oda_update_pipeline(
+	struct emv_oda_ctx_t* ctx,
+	const struct emv_tlv_list_t* list
+);
+
 /**
  * Append Offline Data Authentication (ODA) application record
  *
@@ -170,6 +262,64 @@ int emv_oda_apply(
 	const uint8_t* term_caps
 );
 
+/**
+ * Select and apply Offline Data Authentication (ODA) up to, but excluding,
+ * INTERNAL AUTHENTICATE. This allows the caller to perform INTERNAL
+ * AUTHENTICATE without blocking and to continue with
+ * @ref emv_oda_apply_finalise() thereafter.
+ *
+ * This function has the same requirements as @ref emv_oda_apply().
+ *
+ * @param ctx EMV processing context
+ * @param term_caps Terminal Capabilities (field 9F33). Must be 3 bytes.
+ * @param ddol_data DDOL data output for INTERNAL AUTHENTICATE
+ * @param ddol_data_len Length of DDOL data buffer in bytes, updated to the
+ *                      length of the DDOL data output. Zero if INTERNAL
+ *                      AUTHENTICATE is not required.
+ *
+ * @return Zero for success. If @p ddol_data_len is not zero, perform
+ *         INTERNAL AUTHENTICATE using @ref emv_tal_internal_authenticate()
+ *         and provide the outcome to @ref emv_oda_apply_finalise().
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_oda_error_t
+ * @return Greater than zero indicates that offline data authentication is
+ *         either not possible or has failed, but that the terminal may
+ *         continue the card session. See @ref emv_oda_result_t
+ */
+int emv_oda_apply_prepare(
+	struct emv_ctx_t* ctx,
+	const uint8_t* term_caps,
+	uint8_t* ddol_data,
+	size_t* ddol_data_len
+);
+
+/**
+ * Finalise Offline Data Authentication (ODA) using the outcome of INTERNAL
+ * AUTHENTICATE requested by @ref emv_oda_apply_prepare().
+ *
+ * @param ctx EMV processing context
+ * @param r Return value of @ref emv_tal_internal_authenticate()
+ * @param list Fields provided by INTERNAL AUTHENTICATE. This list will be
+ *             appended to @ref emv_ctx_t.icc upon success and is always
+ *             cleared.
+ * @param ddol_data DDOL data provided by @ref emv_oda_apply_prepare()
+ * @param ddol_data_len Length of DDOL data in bytes
+ *
+ * @return Zero for success.
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_oda_error_t
+ * @return Greater than zero indicates that offline data authentication has
+ *         failed, but that the terminal may continue the card session.
+ *         See @ref emv_oda_result_t
+ */
+int emv_oda_apply_finalise(
+	struct emv_ctx_t* ctx,
+	int r,
+	struct emv_tlv_list_t* list,
+	const uint8_t* ddol_data,
+	size_t ddol_data_len
+);
+
 /**
  * Apply Static Data Authentication (SDA).
  * @remark See EMV 4.4 Book 2, 5
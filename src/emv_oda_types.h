@@ -29,6 +29,9 @@
 
 __BEGIN_DECLS
 
+// Forward declarations
+struct emv_oda_pipeline_t;
+
 /**
  * EMV Offline Data Authentication (ODA) method
  */
@@ -70,6 +73,7 @@ struct emv_rsa_icc_pkey_t {
 struct emv_oda_ctx_t {
 	uint8_t* record_buf; ///< Application record buffer
 	unsigned int record_buf_len; ///< Length of application record buffer
+	unsigned int record_buf_size; ///< Allocated size of application record buffer
 
 	/**
 	 * Cached Processing Options Data Object List (PDOL) data for validating
@@ -104,6 +108,15 @@ struct emv_oda_ctx_t {
 	 * Combined DDA/Application Cryptogram Generation (CDA)
 	 */
 	struct emv_rsa_icc_pkey_t icc_pkey;
+
+	/**
+	 * Pipelined issuer public key recovery state. Populated by
+	 * @ref emv_oda_enable_pipeline() and released by
+	 * @ref emv_oda_clear_records().
+	 * @cond INTERNAL
+	 */
+	struct emv_oda_pipeline_t* pipeline;
+	/// @endcond
 };
 
 __END_DECLS
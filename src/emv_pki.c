@@ -0,0 +1,827 @@
+/**
+ * @file emv_pki.c
+ * @brief EMV test Public Key Infrastructure (PKI) generation
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_pki.h"
+#include "emv_capk.h"
+#include "emv_fields.h"
+#include "emv_utils_config.h"
+
+#define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_ODA
+#include "emv_debug.h"
+
+#include "crypto_rsa.h"
+#include "crypto_sha.h"
+#include "crypto_rand.h"
+#include "crypto_mem.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#endif
+
+// Odd primes used to sieve prime candidates before Miller-Rabin testing
+static const uint16_t emv_pki_small_primes[] = {
+	3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59,
+	61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137,
+	139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223, 227,
+	229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311, 313,
+	317, 331, 337, 347, 349, 353, 359, 367, 373, 379, 383, 389, 397, 401, 409, 419,
+	421, 431, 433, 439, 443, 449, 457, 461, 463, 467, 479, 487, 491, 499, 503, 509,
+	521, 523, 541, 547, 557, 563, 569, 571, 577, 587, 593, 599, 601, 607, 613, 617,
+	619, 631, 641, 643, 647, 653, 659, 661, 673, 677, 683, 691, 701, 709, 719, 727,
+	733, 739, 743, 751, 757, 761, 769, 773, 787, 797, 809, 811, 821, 823, 827, 829,
+	839, 853, 857, 859, 863, 877, 881, 883, 887, 907, 911, 919, 929, 937, 941, 947,
+	953, 967, 971, 977, 983, 991, 997,
+};
+#define EMV_PKI_SMALL_PRIME_COUNT (sizeof(emv_pki_small_primes) / sizeof(emv_pki_small_primes[0]))
+
+// Miller-Rabin bases. Sufficient for random candidates of at least 256 bits.
+static const uint8_t emv_pki_mr_bases[] = { 2, 3, 5, 7, 11, 13, 17, 19 };
+
+// Number of candidates to sieve before choosing a new random starting point
+#define EMV_PKI_PRIME_SEARCH_LEN (4096)
+
+// Length of prime buffers; at most half the modulus, rounded up
+#define EMV_PKI_PRIME_MAX ((EMV_PKI_MODULUS_MAX + 1) / 2)
+
+// See EMV 4.4 Book 2, 5.3, table 6
+#define EMV_PKI_ISSUER_CERT_META_LEN (15)
+#define EMV_PKI_ISSUER_CERT_OVERHEAD (36)
+
+// See EMV 4.4 Book 2, 6.4, table 14
+#define EMV_PKI_ICC_CERT_META_LEN (21)
+#define EMV_PKI_ICC_CERT_OVERHEAD (42)
+
+#define EMV_PKI_CERT_HEADER (0x6A)
+#define EMV_PKI_CERT_TRAILER (0xBC)
+#define EMV_PKI_CERT_PADDING (0xBB)
+#define EMV_PKI_CERT_FORMAT_ISSUER (0x02)
+#define EMV_PKI_CERT_FORMAT_ICC (0x04)
+
+/*
+ * The helpers below operate on unsigned big endian byte arrays. Modular
+ * exponentiation is delegated to crypto_rsa_mod_exp() such that only small
+ * multiplications and divisions are required here.
+ */
+
+static uint32_t emv_pki_mod_small(const uint8_t* a, size_t len, uint32_t m)
+{
+	uint32_t r = 0;
+
+	for (size_t i = 0; i < len; ++i) {
+		r = ((r << 8) | a[i]) % m;
+	}
+
+	return r;
+}
+
+static void emv_pki_div_small(uint8_t* a, size_t len, uint32_t d)
+{
+	uint32_t r = 0;
+
+	for (size_t i = 0; i < len; ++i) {
+		uint32_t x = (r << 8) | a[i];
+		a[i] = x / d;
+		r = x % d;
+	}
+}
+
+static uint32_t emv_pki_mul_small_add(uint8_t* a, size_t len, uint32_t m, uint32_t add)
+{
+	uint32_t carry = add;
+
+	for (size_t i = len; i > 0; --i) {
+		uint32_t x = a[i - 1] * m + carry;
+		a[i - 1] = x & 0xFF;
+		carry = x >> 8;
+	}
+
+	return carry;
+}
+
+static void emv_pki_mul(
+	const uint8_t* a,
+	size_t a_len,
+	const uint8_t* b,
+	size_t b_len,
+	uint8_t* out
+)
+{
+	memset(out, 0, a_len + b_len);
+	for (size_t i = a_len; i > 0; --i) {
+		uint32_t carry = 0;
+
+		for (size_t j = b_len; j > 0; --j) {
+			uint32_t x = out[i + j - 1] + a[i - 1] * b[j - 1] + carry;
+			out[i + j - 1] = x & 0xFF;
+			carry = x >> 8;
+		}
+		out[i - 1] = carry;
+	}
+}
+
+static bool emv_pki_is_one(const uint8_t* a, size_t len)
+{
+	for (size_t i = 0; i < len - 1; ++i) {
+		if (a[i]) {
+			return false;
+		}
+	}
+	return a[len - 1] == 0x01;
+}
+
+static int emv_pki_is_probable_prime(const uint8_t* p, size_t len)
+{
+	int r;
+	uint8_t p_minus_1[EMV_PKI_PRIME_MAX];
+	uint8_t d[EMV_PKI_PRIME_MAX];
+	uint8_t base[EMV_PKI_PRIME_MAX];
+	uint8_t x[EMV_PKI_PRIME_MAX];
+	uint8_t y[EMV_PKI_PRIME_MAX];
+	static const uint8_t two[] = { 0x02 };
+	unsigned int s = 0;
+
+	// Decompose odd p as p - 1 = 2^s * d
+	memcpy(p_minus_1, p, len);
+	p_minus_1[len - 1] &= 0xFE;
+	memcpy(d, p_minus_1, len);
+	while (!(d[len - 1] & 0x01)) {
+		for (size_t i = len; i > 0; --i) {
+			d[i - 1] = (d[i - 1] >> 1) | (i > 1 ? (d[i - 2] << 7) : 0);
+		}
+		++s;
+	}
+
+	memset(base, 0, len);
+	for (size_t i = 0; i < sizeof(emv_pki_mr_bases); ++i) {
+		unsigned int j;
+
+		base[len - 1] = emv_pki_mr_bases[i];
+		r = crypto_rsa_mod_exp(p, len, d, len, base, x);
+		if (r) {
+			emv_debug_trace_msg("crypto_rsa_mod_exp() failed; r=%d", r);
+			r = -1;
+			goto exit;
+		}
+		if (emv_pki_is_one(x, len) || memcmp(x, p_minus_1, len) == 0) {
+			continue;
+		}
+
+		for (j = 1; j < s; ++j) {
+			r = crypto_rsa_mod_exp(p, len, two, sizeof(two), x, y);
+			if (r) {
+				emv_debug_trace_msg("crypto_rsa_mod_exp() failed; r=%d", r);
+				r = -1;
+				goto exit;
+			}
+			memcpy(x, y, len);
+			if (memcmp(x, p_minus_1, len) == 0) {
+				break;
+			}
+		}
+		if (j >= s) {
+			// Composite
+			r = 1;
+			goto exit;
+		}
+	}
+
+	// Probable prime
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_cleanse(p_minus_1, sizeof(p_minus_1));
+	crypto_cleanse(d, sizeof(d));
+	crypto_cleanse(x, sizeof(x));
+	crypto_cleanse(y, sizeof(y));
+	return r;
+}
+
+static int emv_pki_generate_prime(size_t len, uint32_t exponent, uint8_t* p)
+{
+	int r;
+	uint16_t residues[EMV_PKI_SMALL_PRIME_COUNT];
+	uint32_t exponent_residue;
+	uint8_t candidate[EMV_PKI_PRIME_MAX];
+
+	while (true) {
+		// Random odd starting point with the two most significant bits set
+		// such that the product of two primes has the full modulus length
+		crypto_rand(p, len);
+		p[0] |= 0xC0;
+		p[len - 1] |= 0x01;
+
+		for (size_t i = 0; i < EMV_PKI_SMALL_PRIME_COUNT; ++i) {
+			residues[i] = emv_pki_mod_small(p, len, emv_pki_small_primes[i]);
+		}
+		exponent_residue = emv_pki_mod_small(p, len, exponent);
+
+		for (uint32_t delta = 0; delta < EMV_PKI_PRIME_SEARCH_LEN * 2; delta += 2) {
+			bool sieved = false;
+
+			for (size_t i = 0; i < EMV_PKI_SMALL_PRIME_COUNT; ++i) {
+				if ((residues[i] + delta) % emv_pki_small_primes[i] == 0) {
+					sieved = true;
+					break;
+				}
+			}
+			// Public exponent must be coprime to p - 1
+			if (sieved || (exponent_residue + delta) % exponent == 1) {
+				continue;
+			}
+
+			memcpy(candidate, p, len);
+			if (emv_pki_mul_small_add(candidate, len, 1, delta)) {
+				// Overflow; choose new starting point
+				break;
+			}
+
+			r = emv_pki_is_probable_prime(candidate, len);
+			if (r < 0) {
+				goto exit;
+			}
+			if (r == 0) {
+				memcpy(p, candidate, len);
+				goto exit;
+			}
+		}
+	}
+
+exit:
+	crypto_cleanse(candidate, sizeof(candidate));
+	return r;
+}
+
+int emv_pki_generate_key(
+	size_t modulus_len,
+	uint32_t exponent,
+	struct emv_pki_key_t* key
+)
+{
+	int r;
+	size_t p_len;
+	size_t q_len;
+	uint8_t p[EMV_PKI_PRIME_MAX];
+	uint8_t q[EMV_PKI_PRIME_MAX];
+	uint8_t phi[EMV_PKI_MODULUS_MAX + 4];
+	uint32_t phi_residue;
+	uint32_t k;
+	uint8_t msg[EMV_PKI_MODULUS_MAX];
+	uint8_t enc[EMV_PKI_MODULUS_MAX];
+	uint8_t dec[EMV_PKI_MODULUS_MAX];
+
+	if (modulus_len < EMV_PKI_MODULUS_MIN ||
+		modulus_len > EMV_PKI_MODULUS_MAX ||
+		!key
+	) {
+		return -1;
+	}
+	if (exponent != 3 && exponent != 65537) {
+		return -2;
+	}
+
+	memset(key, 0, sizeof(*key));
+	key->modulus_len = modulus_len;
+	if (exponent == 3) {
+		key->exponent[0] = 0x03;
+		key->exponent_len = 1;
+	} else {
+		key->exponent[0] = 0x01;
+		key->exponent[1] = 0x00;
+		key->exponent[2] = 0x01;
+		key->exponent_len = 3;
+	}
+
+	// Odd modulus lengths use primes of different lengths
+	p_len = (modulus_len + 1) / 2;
+	q_len = modulus_len - p_len;
+	do {
+		r = emv_pki_generate_prime(p_len, exponent, p);
+		if (r) {
+			emv_debug_trace_msg("emv_pki_generate_prime() failed; r=%d", r);
+			r = -3;
+			goto exit;
+		}
+		r = emv_pki_generate_prime(q_len, exponent, q);
+		if (r) {
+			emv_debug_trace_msg("emv_pki_generate_prime() failed; r=%d", r);
+			r = -3;
+			goto exit;
+		}
+	} while (p_len == q_len && memcmp(p, q, p_len) == 0);
+
+	// n = p * q
+	emv_pki_mul(p, p_len, q, q_len, key->modulus);
+
+	// phi = (p - 1) * (q - 1), stored with four bytes of headroom such that
+	// k * phi + 1 below does not overflow for k < 65537
+	p[p_len - 1] &= 0xFE;
+	q[q_len - 1] &= 0xFE;
+	memset(phi, 0, 4);
+	emv_pki_mul(p, p_len, q, q_len, phi + 4);
+
+	// d = (k * phi + 1) / e where k is chosen such that the division is exact
+	phi_residue = emv_pki_mod_small(phi, modulus_len + 4, exponent);
+	for (k = 1; k < exponent; ++k) {
+		if ((1 + (uint64_t)k * phi_residue) % exponent == 0) {
+			break;
+		}
+	}
+	if (k >= exponent) {
+		// Only possible if e is not coprime to phi
+		r = -4;
+		goto exit;
+	}
+	emv_pki_mul_small_add(phi, modulus_len + 4, k, 1);
+	emv_pki_div_small(phi, modulus_len + 4, exponent);
+	memcpy(key->private_exponent, phi + 4, modulus_len);
+
+	// Validate key pair using encryption followed by decryption
+	crypto_rand(msg, modulus_len);
+	msg[0] = 0x00;
+	r = crypto_rsa_mod_exp(key->modulus, modulus_len, key->exponent, key->exponent_len, msg, enc);
+	if (r) {
+		emv_debug_trace_msg("crypto_rsa_mod_exp() failed; r=%d", r);
+		r = -5;
+		goto exit;
+	}
+	r = crypto_rsa_mod_exp(key->modulus, modulus_len, key->private_exponent, modulus_len, enc, dec);
+	if (r) {
+		emv_debug_trace_msg("crypto_rsa_mod_exp() failed; r=%d", r);
+		r = -5;
+		goto exit;
+	}
+	if (memcmp(msg, dec, modulus_len) != 0) {
+		emv_debug_trace_msg("Key pair validation failed");
+		r = -6;
+		goto exit;
+	}
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_cleanse(p, sizeof(p));
+	crypto_cleanse(q, sizeof(q));
+	crypto_cleanse(phi, sizeof(phi));
+	crypto_cleanse(dec, sizeof(dec));
+	if (r) {
+		crypto_cleanse(key, sizeof(*key));
+	}
+	return r;
+}
+
+int emv_pki_populate_capk(
+	const struct emv_pki_key_t* ca_key,
+	const uint8_t* rid,
+	uint8_t index,
+	uint8_t* hash,
+	struct emv_capk_t* capk
+)
+{
+	int r;
+	crypto_sha1_ctx_t sha1_ctx = NULL;
+
+	if (!ca_key || !rid || !hash || !capk) {
+		return -1;
+	}
+
+	// See EMV 4.4 Book 2, 11.2.2, Table 30
+	r = crypto_sha1_init(&sha1_ctx);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_init() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, rid, EMV_CAPK_RID_LEN);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, &index, sizeof(index));
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, ca_key->modulus, ca_key->modulus_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, ca_key->exponent, ca_key->exponent_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_finish(&sha1_ctx, hash);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_finish() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+
+	memset(capk, 0, sizeof(*capk));
+	capk->rid = rid;
+	capk->index = index;
+	capk->hash_id = EMV_PKEY_HASH_SHA1;
+	capk->modulus = ca_key->modulus;
+	capk->modulus_len = ca_key->modulus_len;
+	capk->exponent = ca_key->exponent;
+	capk->exponent_len = ca_key->exponent_len;
+	capk->hash = hash;
+	capk->hash_len = SHA1_SIZE;
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	return r;
+}
+
+static int emv_pki_sign_cert(
+	const struct emv_pki_key_t* signer_key,
+	uint8_t* buf,
+	size_t hashed_len,
+	const struct emv_pki_key_t* subject_key,
+	size_t remainder_len,
+	const void* static_data,
+	size_t static_data_len,
+	struct emv_pki_cert_t* cert
+)
+{
+	int r;
+	const size_t cert_len = signer_key->modulus_len;
+	crypto_sha1_ctx_t sha1_ctx = NULL;
+
+	// Certificate hash over format field up to and including the public key
+	// field, followed by the remainder, exponent and static data
+	r = crypto_sha1_init(&sha1_ctx);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_init() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, buf + 1, hashed_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	if (remainder_len) {
+		r = crypto_sha1_update(
+			&sha1_ctx,
+			subject_key->modulus + subject_key->modulus_len - remainder_len,
+			remainder_len
+		);
+		if (r) {
+			emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+			r = -2;
+			goto exit;
+		}
+	}
+	r = crypto_sha1_update(&sha1_ctx, subject_key->exponent, subject_key->exponent_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	if (static_data && static_data_len) {
+		r = crypto_sha1_update(&sha1_ctx, static_data, static_data_len);
+		if (r) {
+			emv_debug_trace_msg("crypto_sha1_update() failed; r=%d", r);
+			r = -2;
+			goto exit;
+		}
+	}
+	r = crypto_sha1_finish(&sha1_ctx, buf + 1 + hashed_len);
+	if (r) {
+		emv_debug_trace_msg("crypto_sha1_finish() failed; r=%d", r);
+		r = -2;
+		goto exit;
+	}
+	buf[cert_len - 1] = EMV_PKI_CERT_TRAILER;
+
+	// Recover operation of EMV 4.4 Book 2 is the inverse of this operation
+	r = crypto_rsa_mod_exp(
+		signer_key->modulus,
+		signer_key->modulus_len,
+		signer_key->private_exponent,
+		signer_key->modulus_len,
+		buf,
+		cert->cert
+	);
+	if (r) {
+		emv_debug_trace_msg("crypto_rsa_mod_exp() failed; r=%d", r);
+		r = -3;
+		goto exit;
+	}
+	cert->cert_len = cert_len;
+
+	cert->remainder_len = remainder_len;
+	if (remainder_len) {
+		memcpy(
+			cert->remainder,
+			subject_key->modulus + subject_key->modulus_len - remainder_len,
+			remainder_len
+		);
+	}
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	return r;
+}
+
+static size_t emv_pki_pack_modulus(
+	const struct emv_pki_key_t* key,
+	uint8_t* field,
+	size_t field_len
+)
+{
+	if (key->modulus_len > field_len) {
+		// Leftmost digits in certificate and the rest in the remainder
+		memcpy(field, key->modulus, field_len);
+		return key->modulus_len - field_len;
+	}
+
+	memcpy(field, key->modulus, key->modulus_len);
+	memset(field + key->modulus_len, EMV_PKI_CERT_PADDING, field_len - key->modulus_len);
+	return 0;
+}
+
+int emv_pki_create_issuer_cert(
+	const struct emv_pki_key_t* ca_key,
+	const uint8_t* issuer_id,
+	const uint8_t* cert_exp,
+	const uint8_t* cert_sn,
+	const struct emv_pki_key_t* issuer_key,
+	struct emv_pki_cert_t* cert
+)
+{
+	int r;
+	uint8_t buf[EMV_PKI_MODULUS_MAX];
+	size_t field_len;
+	size_t remainder_len;
+
+	if (!ca_key || !issuer_id || !cert_exp || !cert_sn || !issuer_key || !cert) {
+		return -1;
+	}
+	if (ca_key->modulus_len < EMV_PKI_MODULUS_MIN ||
+		ca_key->modulus_len > EMV_PKI_MODULUS_MAX ||
+		!issuer_key->modulus_len ||
+		issuer_key->modulus_len > EMV_PKI_MODULUS_MAX
+	) {
+		return -1;
+	}
+	memset(cert, 0, sizeof(*cert));
+
+	// See EMV 4.4 Book 2, 5.3, table 6
+	field_len = ca_key->modulus_len - EMV_PKI_ISSUER_CERT_OVERHEAD;
+	buf[0] = EMV_PKI_CERT_HEADER;
+	buf[1] = EMV_PKI_CERT_FORMAT_ISSUER;
+	memcpy(buf + 2, issuer_id, 4);
+	memcpy(buf + 6, cert_exp, 2);
+	memcpy(buf + 8, cert_sn, 3);
+	buf[11] = EMV_PKEY_HASH_SHA1;
+	buf[12] = EMV_PKEY_SIG_RSA_SHA1;
+	buf[13] = issuer_key->modulus_len;
+	buf[14] = issuer_key->exponent_len;
+	remainder_len = emv_pki_pack_modulus(
+		issuer_key,
+		buf + EMV_PKI_ISSUER_CERT_META_LEN,
+		field_len
+	);
+
+	r = emv_pki_sign_cert(
+		ca_key,
+		buf,
+		EMV_PKI_ISSUER_CERT_META_LEN - 1 + field_len,
+		issuer_key,
+		remainder_len,
+		NULL,
+		0,
+		cert
+	);
+	crypto_cleanse(buf, sizeof(buf));
+	return r;
+}
+
+int emv_pki_create_icc_cert(
+	const struct emv_pki_key_t* issuer_key,
+	const uint8_t* pan,
+	const uint8_t* cert_exp,
+	const uint8_t* cert_sn,
+	const struct emv_pki_key_t* icc_key,
+	const void* static_data,
+	size_t static_data_len,
+	struct emv_pki_cert_t* cert
+)
+{
+	int r;
+	uint8_t buf[EMV_PKI_MODULUS_MAX];
+	size_t field_len;
+	size_t remainder_len;
+
+	if (!issuer_key || !pan || !cert_exp || !cert_sn || !icc_key || !cert) {
+		return -1;
+	}
+	if (static_data_len && !static_data) {
+		return -1;
+	}
+	if (issuer_key->modulus_len < EMV_PKI_MODULUS_MIN ||
+		issuer_key->modulus_len > EMV_PKI_MODULUS_MAX ||
+		!icc_key->modulus_len ||
+		icc_key->modulus_len > EMV_PKI_MODULUS_MAX
+	) {
+		return -1;
+	}
+	memset(cert, 0, sizeof(*cert));
+
+	// See EMV 4.4 Book 2, 6.4, table 14
+	field_len = issuer_key->modulus_len - EMV_PKI_ICC_CERT_OVERHEAD;
+	buf[0] = EMV_PKI_CERT_HEADER;
+	buf[1] = EMV_PKI_CERT_FORMAT_ICC;
+	memcpy(buf + 2, pan, 10);
+	memcpy(buf + 12, cert_exp, 2);
+	memcpy(buf + 14, cert_sn, 3);
+	buf[17] = EMV_PKEY_HASH_SHA1;
+	buf[18] = EMV_PKEY_SIG_RSA_SHA1;
+	buf[19] = icc_key->modulus_len;
+	buf[20] = icc_key->exponent_len;
+	remainder_len = emv_pki_pack_modulus(
+		icc_key,
+		buf + EMV_PKI_ICC_CERT_META_LEN,
+		field_len
+	);
+
+	r = emv_pki_sign_cert(
+		issuer_key,
+		buf,
+		EMV_PKI_ICC_CERT_META_LEN - 1 + field_len,
+		icc_key,
+		remainder_len,
+		static_data,
+		static_data_len,
+		cert
+	);
+	crypto_cleanse(buf, sizeof(buf));
+	return r;
+}
+
+static int emv_pki_process_icc_request(
+	const struct emv_pki_key_t* issuer_key,
+	struct emv_pki_icc_request_t* req
+)
+{
+	int r;
+
+	if (req->modulus_len) {
+		r = emv_pki_generate_key(req->modulus_len, req->exponent, &req->icc_key);
+		if (r) {
+			emv_debug_trace_msg("emv_pki_generate_key() failed; r=%d", r);
+			return r;
+		}
+	}
+
+	r = emv_pki_create_icc_cert(
+		issuer_key,
+		req->pan,
+		req->cert_exp,
+		req->cert_sn,
+		&req->icc_key,
+		req->static_data,
+		req->static_data_len,
+		&req->cert
+	);
+	if (r) {
+		emv_debug_trace_msg("emv_pki_create_icc_cert() failed; r=%d", r);
+		return r;
+	}
+
+	return 0;
+}
+
+#ifdef HAVE_PTHREAD
+struct emv_pki_batch_t {
+	const struct emv_pki_key_t* issuer_key;
+	struct emv_pki_icc_request_t* requests;
+	size_t count;
+	atomic_size_t next;
+};
+
+static void* emv_pki_batch_worker(void* arg)
+{
+	struct emv_pki_batch_t* batch = arg;
+	size_t i;
+
+	// Claim requests one at a time such that workers remain balanced when
+	// requests differ in key length
+	while ((i = atomic_fetch_add(&batch->next, 1)) < batch->count) {
+		batch->requests[i].result = emv_pki_process_icc_request(
+			batch->issuer_key,
+			&batch->requests[i]
+		);
+	}
+
+	return NULL;
+}
+#endif
+
+int emv_pki_create_icc_batch(
+	const struct emv_pki_key_t* issuer_key,
+	struct emv_pki_icc_request_t* requests,
+	size_t count,
+	unsigned int thread_count
+)
+{
+	int failed = 0;
+
+	if (!issuer_key || (count && !requests)) {
+		return -1;
+	}
+
+#ifdef HAVE_PTHREAD
+	if (thread_count > 1 && count > 1) {
+		struct emv_pki_batch_t batch;
+		pthread_t* threads;
+		unsigned int started = 0;
+
+		if (thread_count > count) {
+			thread_count = count;
+		}
+		threads = malloc(thread_count * sizeof(*threads));
+		if (!threads) {
+			return -2;
+		}
+
+		batch.issuer_key = issuer_key;
+		batch.requests = requests;
+		batch.count = count;
+		atomic_init(&batch.next, 0);
+		for (; started < thread_count; ++started) {
+			if (pthread_create(&threads[started], NULL, emv_pki_batch_worker, &batch)) {
+				// Remaining requests are processed by started workers and by
+				// the calling thread below
+				emv_debug_trace_msg("pthread_create() failed");
+				break;
+			}
+		}
+
+		// Calling thread assists until all requests have been claimed
+		emv_pki_batch_worker(&batch);
+		for (unsigned int i = 0; i < started; ++i) {
+			pthread_join(threads[i], NULL);
+		}
+		free(threads);
+	} else
+#endif
+	{
+		(void)thread_count;
+		for (size_t i = 0; i < count; ++i) {
+			requests[i].result = emv_pki_process_icc_request(issuer_key, &requests[i]);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		if (requests[i].result) {
+			++failed;
+		}
+	}
+
+	return failed;
+}
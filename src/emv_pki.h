@@ -0,0 +1,197 @@
+/**
+ * @file emv_pki.h
+ * @brief EMV test Public Key Infrastructure (PKI) generation
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_PKI_H
+#define EMV_PKI_H
+
+#include <sys/cdefs.h>
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+// Forward declarations
+struct emv_capk_t;
+
+/// Maximum EMV public key modulus length in bytes
+#define EMV_PKI_MODULUS_MAX (1984 / 8)
+
+/// Minimum modulus length in bytes supported by @ref emv_pki_generate_key()
+#define EMV_PKI_MODULUS_MIN (512 / 8)
+
+/**
+ * EMV test RSA key pair
+ *
+ * @warning These keys are intended for testing only. Key generation uses
+ *          probabilistic primality testing that is suitable for test keys but
+ *          the private exponent is not protected in any way.
+ */
+struct emv_pki_key_t {
+	uint8_t modulus_len; ///< Modulus length in bytes
+	uint8_t exponent_len; ///< Public exponent length in bytes
+	uint8_t modulus[EMV_PKI_MODULUS_MAX]; ///< Modulus
+	uint8_t exponent[3]; ///< Public exponent
+	uint8_t private_exponent[EMV_PKI_MODULUS_MAX]; ///< Private exponent. Same length as modulus.
+};
+
+/**
+ * EMV public key certificate and public key remainder
+ * @remark See EMV 4.4 Book 2, 5.1
+ * @remark See EMV 4.4 Book 2, 6.1
+ */
+struct emv_pki_cert_t {
+	uint8_t cert[EMV_PKI_MODULUS_MAX]; ///< Public key certificate (field 90 or 9F46)
+	size_t cert_len; ///< Length of public key certificate in bytes
+	uint8_t remainder[EMV_PKI_MODULUS_MAX]; ///< Public key remainder (field 92 or 9F48)
+	size_t remainder_len; ///< Length of public key remainder in bytes. Zero if not required.
+};
+
+/**
+ * ICC public key certificate request for @ref emv_pki_create_icc_batch()
+ */
+struct emv_pki_icc_request_t {
+	uint8_t pan[10]; ///< Application PAN (field 5A), padded to the right with hex 'F's
+	uint8_t cert_exp[2]; ///< Certificate Expiration Date (MMYY)
+	uint8_t cert_sn[3]; ///< Certificate Serial Number
+	size_t modulus_len; ///< Modulus length in bytes of ICC key to generate. Zero to use @ref icc_key as provided.
+	uint32_t exponent; ///< Public exponent of ICC key to generate
+	const void* static_data; ///< Static data to be authenticated. May be NULL.
+	size_t static_data_len; ///< Length of static data to be authenticated in bytes
+
+	struct emv_pki_key_t icc_key; ///< ICC key. Generated unless @ref modulus_len is zero.
+	struct emv_pki_cert_t cert; ///< ICC public key certificate output
+	int result; ///< Result of this request. See @ref emv_pki_create_icc_cert().
+};
+
+/**
+ * Generate test RSA key pair
+ *
+ * @param modulus_len Modulus length in bytes. Must be between
+ *                    @ref EMV_PKI_MODULUS_MIN and @ref EMV_PKI_MODULUS_MAX.
+ * @param exponent Public exponent. Must be 3 or 65537.
+ * @param key Key pair output
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_pki_generate_key(
+	size_t modulus_len,
+	uint32_t exponent,
+	struct emv_pki_key_t* key
+);
+
+/**
+ * Populate Certificate Authority Public Key (CAPK) for test CA key such that
+ * it can be added using @ref emv_capk_add(). The populated CAPK references
+ * @p rid, @p ca_key and @p hash which must remain valid while the CAPK is in
+ * use.
+ *
+ * @param ca_key Certificate Authority (CA) key
+ * @param rid Registered Application Provider Identifier (RID). Must be 5 bytes.
+ * @param index CAPK index
+ * @param hash CAPK hash output. Must be 20 bytes.
+ * @param capk CAPK output
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_pki_populate_capk(
+	const struct emv_pki_key_t* ca_key,
+	const uint8_t* rid,
+	uint8_t index,
+	uint8_t* hash,
+	struct emv_capk_t* capk
+);
+
+/**
+ * Create Issuer Public Key Certificate
+ * @remark See EMV 4.4 Book 2, 5.3, table 6
+ *
+ * @param ca_key Certificate Authority (CA) key used to sign the certificate
+ * @param issuer_id Issuer Identifier. Leftmost 3-8 digits from the PAN padded
+ *                  to the right with hex 'F's. Must be 4 bytes.
+ * @param cert_exp Certificate Expiration Date (MMYY). Must be 2 bytes.
+ * @param cert_sn Certificate Serial Number. Must be 3 bytes.
+ * @param issuer_key Issuer key to certify
+ * @param cert Issuer Public Key Certificate (field 90) and Issuer Public Key
+ *             Remainder (field 92) output
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_pki_create_issuer_cert(
+	const struct emv_pki_key_t* ca_key,
+	const uint8_t* issuer_id,
+	const uint8_t* cert_exp,
+	const uint8_t* cert_sn,
+	const struct emv_pki_key_t* issuer_key,
+	struct emv_pki_cert_t* cert
+);
+
+/**
+ * Create ICC Public Key Certificate
+ * @remark See EMV 4.4 Book 2, 6.4, table 14
+ *
+ * @param issuer_key Issuer key used to sign the certificate
+ * @param pan Application PAN padded to the right with hex 'F's. Must be 10 bytes.
+ * @param cert_exp Certificate Expiration Date (MMYY). Must be 2 bytes.
+ * @param cert_sn Certificate Serial Number. Must be 3 bytes.
+ * @param icc_key ICC key to certify
+ * @param static_data Static data to be authenticated. May be NULL.
+ * @param static_data_len Length of static data to be authenticated in bytes
+ * @param cert ICC Public Key Certificate (field 9F46) and ICC Public Key
+ *             Remainder (field 9F48) output
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_pki_create_icc_cert(
+	const struct emv_pki_key_t* issuer_key,
+	const uint8_t* pan,
+	const uint8_t* cert_exp,
+	const uint8_t* cert_sn,
+	const struct emv_pki_key_t* icc_key,
+	const void* static_data,
+	size_t static_data_len,
+	struct emv_pki_cert_t* cert
+);
+
+/**
+ * Process a batch of ICC public key certificate requests, including ICC key
+ * generation where requested, using multiple threads if available. The
+ * outcome of each request is available in @ref emv_pki_icc_request_t.result.
+ *
+ * @param issuer_key Issuer key used to sign the certificates
+ * @param requests ICC public key certificate requests
+ * @param count Number of requests
+ * @param thread_count Number of worker threads. Zero to process all requests
+ *                     in the calling thread.
+ *
+ * @return Zero if all requests succeeded.
+ * @return Less than zero for error.
+ * @return Greater than zero for the number of failed requests.
+ */
+int emv_pki_create_icc_batch(
+	const struct emv_pki_key_t* issuer_key,
+	struct emv_pki_icc_request_t* requests,
+	size_t count,
+	unsigned int thread_count
+);
+
+__END_DECLS
+
+#endif
@@ -106,8 +106,6 @@ int emv_rsa_retrieve_issuer_pkey(
 	uint8_t hash[SHA1_SIZE];
 	const struct emv_tlv_t* remainder_tlv;
 	const struct emv_tlv_t* exponent_tlv;
-	const struct emv_tlv_t* pan_tlv;
-	const struct emv_tlv_t* txn_date_tlv;
 
 	if (!issuer_cert || !issuer_cert_len || !capk || !pkey) {
 		return -1;
@@ -292,13 +290,37 @@ int emv_rsa_retrieve_issuer_pkey(
 		goto exit;
 	}
 
+	// Validate issuer identifier and certificate expiration date
+	// See EMV 4.4 Book 2, 5.3, step 8 - 9
+	r = emv_rsa_validate_issuer_pkey(pkey, icc, params);
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	// Cleanse decrypted certificate because it contains up to 8 PAN digits
+	crypto_cleanse(&cert, sizeof(cert));
+	return r;
+}
+
+int emv_rsa_validate_issuer_pkey(
+	const struct emv_rsa_issuer_pkey_t* pkey,
+	const struct emv_tlv_list_t* icc,
+	const struct emv_tlv_list_t* params
+)
+{
+	const struct emv_tlv_t* pan_tlv;
+	const struct emv_tlv_t* txn_date_tlv;
+
+	if (!pkey || !icc) {
+		return -1;
+	}
+
 	// See EMV 4.4 Book 2, 5.3, step 8
 	pan_tlv = emv_tlv_list_find_const(icc, EMV_TAG_5A_APPLICATION_PAN);
 	if (!pan_tlv || pan_tlv->length < sizeof(pkey->issuer_id)) {
 		// PAN not available or not valid. Issuer identifier validation not
 		// possible.
-		r = 7;
-		goto exit;
+		return 7;
 	}
 	for (size_t i = 0; i < sizeof(pkey->issuer_id); ++i) {
 		if (pkey->issuer_id[i] == 0xFF) {
@@ -309,14 +331,12 @@ int emv_rsa_retrieve_issuer_pkey(
 			// Only compare first nibble of byte
 			if ((pkey->issuer_id[i] & 0xF0) != (pan_tlv->value[i] & 0xF0)) {
 				// Issuer identifier is invalid
-				r = 8;
-				goto exit;
+				return 8;
 			}
 		}
 		if (pkey->issuer_id[i] != pan_tlv->value[i]) {
 			// Issuer identifier is invalid
-			r = 9;
-			goto exit;
+			return 9;
 		}
 	}
 
@@ -327,19 +347,11 @@ int emv_rsa_retrieve_issuer_pkey(
 		// certificate is expired
 		emv_debug_trace_data("Certificate expiration date", pkey->cert_exp, sizeof(pkey->cert_exp));
 		emv_debug_error("Certificate is expired");
-		r = 10;
-		goto exit;
+		return 10;
 	}
 
 	// Success
-	r = 0;
-	goto exit;
-
-exit:
-	crypto_sha1_free(&sha1_ctx);
-	// Cleanse decrypted certificate because it contains up to 8 PAN digits
-	crypto_cleanse(&cert, sizeof(cert));
-	return r;
+	return 0;
 }
 
 int emv_rsa_retrieve_ssad(
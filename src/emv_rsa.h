@@ -144,6 +144,34 @@ int emv_rsa_retrieve_issuer_pkey(
 	struct emv_rsa_issuer_pkey_t* pkey
 );
 
+/**
+ * Validate issuer public key for the current card and transaction.
+ * @remark See EMV 4.4 Book 2, 5.3, step 8 - 9
+ *
+ * This function validates the issuer identifier of the issuer public key
+ * against @ref EMV_TAG_5A_APPLICATION_PAN in @p icc and validates the
+ * certificate expiration date of the issuer public key against
+ * @ref EMV_TAG_9A_TRANSACTION_DATE in @p params. It is used by
+ * @ref emv_rsa_retrieve_issuer_pkey() and must also be used whenever a
+ * previously retrieved issuer public key is reused for another card or
+ * transaction.
+ *
+ * @param pkey Issuer public key
+ * @param icc ICC data used during issuer public key validation
+ * @param params Transaction parameters used during issuer public key
+ *        validation. NULL to ignore.
+ *
+ * @return Zero if validated.
+ * @return Less than zero for error.
+ * @return Greater than zero if validation failed. Same values as
+ *         @ref emv_rsa_retrieve_issuer_pkey().
+ */
+int emv_rsa_validate_issuer_pkey(
+	const struct emv_rsa_issuer_pkey_t* pkey,
+	const struct emv_tlv_list_t* icc,
+	const struct emv_tlv_list_t* params
+);
+
 /**
  * Retrieve Signed Static Application Data (SSAD) and optionally validate the
  * hash.
@@ -20,6 +20,7 @@
  */
 
 #include "emv_strings.h"
+#include "emv_tag_info_static_data.h"
 #include "emv_tlv.h"
 #include "emv_tags.h"
 #include "emv_fields.h"
@@ -32,12 +33,18 @@
 #include "iso8859.h"
 #include "iso7816_apdu.h"
 #include "iso7816_strings.h"
+#include "emv_utils_config.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h> // for vsnprintf() and snprintf()
 #include <ctype.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #if defined(__clang__)
 	// Check for Clang first because it also defines __GNUC__
 	#define ATTRIBUTE_FORMAT_PRINTF(str_idx, va_idx) __attribute__((format(printf, str_idx, va_idx)))
@@ -60,7 +67,39 @@ struct emv_kernel_id_info_t {
 	char currency[128]; // Current longest string in iso_4217.json is 65 chars
 };
 
+enum emv_cert_cache_type_t {
+	EMV_CERT_CACHE_ISSUER_PKEY,
+	EMV_CERT_CACHE_SSAD,
+	EMV_CERT_CACHE_ICC_PKEY,
+	EMV_CERT_CACHE_SDAD,
+};
+
+struct emv_cert_cache_entry_t {
+	struct emv_cert_cache_entry_t* next;
+	enum emv_cert_cache_type_t type;
+	int result;
+	size_t cert_len;
+	uint8_t data[]; // Certificate followed by recovery output
+};
+
+// Identity of the CAPK used to recover the Issuer Public Key. Copied from the
+// CAPK because the CAPK itself may be released by emv_capk_clear().
+struct emv_cert_capk_id_t {
+	uint8_t rid[EMV_CAPK_RID_LEN];
+	uint8_t index;
+};
+
+// Protects all certificate recovery caches because they are modified through
+// const EMV TLV sources that may be shared by multiple threads
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t cert_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 // Helper functions
+static const struct emv_tag_info_entry_t* emv_tag_info_find(const struct emv_tlv_t* tlv);
+static bool emv_tag_info_match(const struct emv_tag_info_entry_t* entry, const struct emv_tlv_t* tlv);
+static int emv_tag_info_render(const struct emv_tag_info_entry_t* entry, const struct emv_tlv_t* tlv, const struct emv_tlv_sources_t* sources, char* value_str, size_t value_str_len);
+static int emv_tlv_get_asn1_info(const struct emv_tlv_t* tlv, struct emv_tlv_info_t* info, char* value_str, size_t value_str_len);
 static int emv_tlv_value_get_string(const struct emv_tlv_t* tlv, enum emv_format_t format, size_t max_format_len, char* value_str, size_t value_str_len);
 static int emv_uint_to_str(uint32_t value, char* str, size_t str_len);
 static void emv_str_list_init(struct str_itr_t* itr, char* buf, size_t len);
@@ -76,10 +115,16 @@ static int emv_currency_numeric_code_get_string(const uint8_t* buf, size_t buf_l
 static int emv_language_alpha2_code_get_string(const uint8_t* buf, size_t buf_len, char* str, size_t str_len);
 static const char* emv_cvm_code_get_string(uint8_t cvm_code);
 static int emv_cvm_cond_code_get_string(uint8_t cvm_cond_code, const struct emv_cvmlist_amounts_t* amounts, char* str, size_t str_len);
-static int emv_decrypt_issuer_pkey(const uint8_t* issuer_cert, size_t issuer_cert_len, const struct emv_tlv_sources_t* sources, const struct emv_capk_t** capk, struct emv_rsa_issuer_pkey_t* pkey);
+static bool emv_cert_cache_get(const struct emv_tlv_sources_t* sources, uint64_t capk_generation, enum emv_cert_cache_type_t type, const uint8_t* cert, size_t cert_len, void* out1, size_t out1_len, void* out2, size_t out2_len, int* result);
+static void emv_cert_cache_put(const struct emv_tlv_sources_t* sources, uint64_t capk_generation, enum emv_cert_cache_type_t type, const uint8_t* cert, size_t cert_len, const void* out1, size_t out1_len, const void* out2, size_t out2_len, int result);
+static int emv_decrypt_issuer_pkey(const uint8_t* issuer_cert, size_t issuer_cert_len, const struct emv_tlv_sources_t* sources, struct emv_cert_capk_id_t* capk_id, struct emv_rsa_issuer_pkey_t* pkey);
 static int emv_decrypt_ssad(const uint8_t* ssad, size_t ssad_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_issuer_pkey_t* issuer_pkey, struct emv_rsa_ssad_t* data);
 static int emv_decrypt_icc_pkey(const uint8_t* icc_cert, size_t icc_cert_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_issuer_pkey_t* issuer_pkey, struct emv_rsa_icc_pkey_t* icc_pkey);
 static int emv_decrypt_sdad(const uint8_t* sdad, size_t sdad_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_icc_pkey_t* icc_pkey, struct emv_rsa_sdad_t* data);
+static int emv_decrypt_issuer_pkey_uncached(const uint8_t* issuer_cert, size_t issuer_cert_len, const struct emv_tlv_sources_t* sources, struct emv_cert_capk_id_t* capk_id, struct emv_rsa_issuer_pkey_t* pkey);
+static int emv_decrypt_ssad_uncached(const uint8_t* ssad, size_t ssad_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_issuer_pkey_t* issuer_pkey, struct emv_rsa_ssad_t* data);
+static int emv_decrypt_icc_pkey_uncached(const uint8_t* icc_cert, size_t icc_cert_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_issuer_pkey_t* issuer_pkey, struct emv_rsa_icc_pkey_t* icc_pkey);
+static int emv_decrypt_sdad_uncached(const uint8_t* sdad, size_t sdad_len, const struct emv_tlv_sources_t* sources, struct emv_rsa_icc_pkey_t* icc_pkey, struct emv_rsa_sdad_t* data);
 static const char* emv_oda_format_get_string(uint8_t format);
 static const char* emv_pkey_hash_alg_get_string(uint8_t hash_id);
 static const char* emv_pkey_sig_alg_get_string(uint8_t alg_id);
@@ -110,6 +155,24 @@ int emv_strings_init(const char* isocodes_path, const char* mcc_path)
 	return 0;
 }
 
+void emv_strings_init_lazy(const char* isocodes_path, const char* mcc_path)
+{
+	isocodes_init_lazy(isocodes_path);
+	mcc_init_lazy(mcc_path);
+}
+
+int emv_strings_get_load_result(void)
+{
+	int r;
+
+	r = isocodes_get_load_result();
+	if (r) {
+		return r;
+	}
+
+	return mcc_get_load_result();
+}
+
 int emv_tlv_get_info(
 	const struct emv_tlv_t* tlv,
 	const struct emv_tlv_sources_t* sources,
@@ -118,7 +181,7 @@ int emv_tlv_get_info(
 	size_t value_str_len
 )
 {
-	int r;
+	const struct emv_tag_info_entry_t* entry;
 
 	if (!tlv || !info) {
 		return -1;
@@ -129,146 +192,156 @@ int emv_tlv_get_info(
 		value_str[0] = 0; // Default to empty value string
 	}
 
-	switch (tlv->tag) {
-		case EMV_TAG_42_IIN:
-			info->tag_name = "Issuer Identification Number (IIN)";
-			info->tag_desc =
-				"The number that identifies the major industry and the card "
-				"issuer and that forms the first part of the Primary Account "
-				"Number (PAN)";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 6, value_str, value_str_len);
-
-		case EMV_TAG_4F_APPLICATION_DF_NAME:
-			info->tag_name = "Application Dedicated File (ADF) Name";
-			info->tag_desc =
-				"Identifies the application as described in ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_B;
-			return emv_aid_get_string(tlv->value, tlv->length, value_str, value_str_len);
+	entry = emv_tag_info_find(tlv);
+	if (!entry) {
+		return emv_tlv_get_asn1_info(tlv, info, value_str, value_str_len);
+	}
 
-		case EMV_TAG_50_APPLICATION_LABEL:
-			info->tag_name = "Application Label";
-			info->tag_desc =
-				"Mnemonic associated with the AID according to ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 16, value_str, value_str_len);
-
-		case EMV_TAG_56_TRACK1_DATA:
-			info->tag_name = "Track 1 Data";
-			info->tag_desc =
-				"Contains the data objects of the track 1 according to "
-				"ISO/IEC 7813 Structure B, excluding start sentinel, end "
-				"sentinel and Longitudinal Redundancy Check (LRC)";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 76, value_str, value_str_len);
-
-		case EMV_TAG_57_TRACK2_EQUIVALENT_DATA:
-			info->tag_name = "Track 2 Equivalent Data";
-			info->tag_desc =
-				"Contains the data elements of track 2 according to "
-				"ISO/IEC 7813, excluding start sentinel, end sentinel, and "
-				"Longitudinal Redundancy Check (LRC)";
-			info->format = EMV_FORMAT_B;
-			return emv_track2_equivalent_data_get_string(tlv->value, tlv->length, value_str, value_str_len);
+	info->tag_name = entry->tag_name;
+	info->tag_desc = entry->tag_desc;
+	info->format = entry->format;
 
-		case EMV_TAG_5A_APPLICATION_PAN:
-			info->tag_name = "Application Primary Account Number (PAN)";
-			info->tag_desc =
-				"Valid cardholder account number";
-			info->format = EMV_FORMAT_CN;
-			return emv_tlv_value_get_string(tlv, info->format, 19, value_str, value_str_len);
-
-		case EMV_TAG_61_APPLICATION_TEMPLATE:
-			info->tag_name = "Application Template";
-			info->tag_desc =
-				"Contains one or more data objects relevant to an application "
-				"directory entry according to ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_B;
-			return 0;
+	return emv_tag_info_render(entry, tlv, sources, value_str, value_str_len);
+}
 
-		case EMV_TAG_6F_FCI_TEMPLATE:
-			info->tag_name = "File Control Information (FCI) Template";
-			info->tag_desc =
-				"Identifies the FCI template according to ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+int emv_tlv_get_tag_info(
+	const struct emv_tlv_t* tlv,
+	struct emv_tlv_info_t* info
+)
+{
+	const struct emv_tag_info_entry_t* entry;
 
-		case EMV_TAG_70_DATA_TEMPLATE:
-			info->tag_name = "EMV Data Template";
-			info->tag_desc = "Contains EMV data";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	if (!tlv || !info) {
+		return -1;
+	}
 
-		case EMV_TAG_71_ISSUER_SCRIPT_TEMPLATE_1:
-			info->tag_name = "Issuer Script Template 1";
-			info->tag_desc =
-				"Contains proprietary issuer data for "
-				"transmission to the ICC before the second "
-				"GENERATE AC command";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	memset(info, 0, sizeof(*info));
 
-		case EMV_TAG_72_ISSUER_SCRIPT_TEMPLATE_2:
-			info->tag_name = "Issuer Script Template 2";
-			info->tag_desc =
-				"Contains proprietary issuer data for "
-				"transmission to the ICC after the second "
-				"GENERATE AC command";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	entry = emv_tag_info_find(tlv);
+	if (!entry) {
+		emv_tlv_get_asn1_info(tlv, info, NULL, 0);
+		return info->tag_name ? 0 : 1;
+	}
 
-		case EMV_TAG_73_DIRECTORY_DISCRETIONARY_TEMPLATE:
-			info->tag_name = "Directory Discretionary Template";
-			info->tag_desc =
-				"Issuer discretionary part of the directory according to "
-				"ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	info->tag_name = entry->tag_name;
+	info->tag_desc = entry->tag_desc;
+	info->format = entry->format;
 
-		case EMV_TAG_77_RESPONSE_MESSAGE_TEMPLATE_FORMAT_2:
-			info->tag_name = "Response Message Template Format 2";
-			info->tag_desc =
-				"Contains the data objects (with tags and lengths) returned "
-				"by the ICC in response to a command";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	return 0;
+}
 
-		case EMV_TAG_80_RESPONSE_MESSAGE_TEMPLATE_FORMAT_1:
-			info->tag_name = "Response Message Template Format 1";
-			info->tag_desc =
-				"Contains the data objects (without tags and lengths) "
-				"returned by the ICC in response to a command";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+int emv_tlv_get_value_string(
+	const struct emv_tlv_t* tlv,
+	const struct emv_tlv_sources_t* sources,
+	char* value_str,
+	size_t value_str_len
+)
+{
+	const struct emv_tag_info_entry_t* entry;
 
-		case EMV_TAG_81_AMOUNT_AUTHORISED_BINARY:
-			info->tag_name = "Amount, Authorised (Binary)";
-			info->tag_desc =
-				"Authorised amount of the transaction (excluding adjustments)";
-			info->format = EMV_FORMAT_B;
-			return emv_amount_get_string(tlv->value, tlv->length, value_str, value_str_len);
+	if (!tlv) {
+		return -1;
+	}
 
-		case EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE:
-			info->tag_name = "Application Interchange Profile (AIP)";
-			info->tag_desc =
-				"Indicates the capabilities of the card to support specific "
-				"functions in the application";
-			info->format = EMV_FORMAT_B;
-			return emv_aip_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+	if (value_str && value_str_len) {
+		value_str[0] = 0; // Default to empty value string
+	}
+
+	entry = emv_tag_info_find(tlv);
+	if (!entry) {
+		struct emv_tlv_info_t info;
+		return emv_tlv_get_asn1_info(tlv, &info, value_str, value_str_len);
+	}
 
-		case EMV_TAG_83_COMMAND_TEMPLATE:
-			info->tag_name = "Command Template";
-			info->tag_desc =
-				"Identifies the data field of a command message";
-			info->format = EMV_FORMAT_VAR;
+	return emv_tag_info_render(entry, tlv, sources, value_str, value_str_len);
+}
+
+static const struct emv_tag_info_entry_t* emv_tag_info_find(const struct emv_tlv_t* tlv)
+{
+	const size_t count = sizeof(emv_tag_info_table) / sizeof(emv_tag_info_table[0]);
+	size_t lower = 0;
+	size_t upper = count;
+
+	// Find first entry for tag
+	while (lower < upper) {
+		size_t mid = lower + (upper - lower) / 2;
+		if (emv_tag_info_table[mid].tag < tlv->tag) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
+		}
+	}
+
+	// Tags that are used for different purposes by different kernels have
+	// consecutive entries that are matched in order
+	for (size_t i = lower; i < count && emv_tag_info_table[i].tag == tlv->tag; ++i) {
+		if (emv_tag_info_match(&emv_tag_info_table[i], tlv)) {
+			return &emv_tag_info_table[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool emv_tag_info_match(const struct emv_tag_info_entry_t* entry, const struct emv_tlv_t* tlv)
+{
+	switch (entry->match) {
+		case EMV_TAG_MATCH_ANY:
+			return true;
+
+		case EMV_TAG_MATCH_LENGTH:
+			return tlv->length >= entry->min_len && tlv->length <= entry->max_len;
+
+		case EMV_TAG_MATCH_VISA_CARD_AUTH_DATA:
+			return tlv->length >= 5 && tlv->length <= 16 &&
+				tlv->value && tlv->value[0] == 0x01;
+
+		case EMV_TAG_MATCH_VISA_FFI:
+			return tlv->length == 4 &&
+				tlv->value &&
+				(tlv->value[0] & VISA_FFI_VERSION_MASK) == VISA_FFI_VERSION_NUMBER_1 && // VCPS only defines version number 1
+				!tlv->value[2] && // VCPS indicates that byte 3 is RFU and should be zero'd
+				tlv->value[3] == VISA_FFI_PAYMENT_TXN_TECHNOLOGY_CONTACTLESS; // VCPS only defines contactless
+
+		case EMV_TAG_MATCH_AMEX_ENH_CL_READER_CAPS:
+			return tlv->length == 4 &&
+				tlv->value &&
+				// Mandatory according to specification
+				(tlv->value[0] & AMEX_ENH_CL_READER_CAPS_FULL_ONLINE_MODE_SUPPORTED) == 0 &&
+				tlv->value[0] & AMEX_ENH_CL_READER_CAPS_PARTIAL_ONLINE_MODE_SUPPORTED &&
+				tlv->value[0] & AMEX_ENH_CL_READER_CAPS_MOBILE_SUPPORTED &&
+				(tlv->value[0] & AMEX_ENH_CL_READER_CAPS_BYTE1_RFU) == 0 &&
+				tlv->value[1] & AMEX_ENH_CL_READER_CAPS_MOBILE_CVM_SUPPORTED &&
+				(tlv->value[1] & AMEX_ENH_CL_READER_CAPS_BYTE2_RFU) == 0 &&
+				(tlv->value[2] & AMEX_ENH_CL_READER_CAPS_BYTE3_RFU) == 0 &&
+				(tlv->value[3] & AMEX_ENH_CL_READER_CAPS_BYTE4_RFU) == 0 &&
+				tlv->value[3] & AMEX_ENH_CL_READER_CAPS_KERNEL_VERSION_MASK;
+	}
+
+	return false;
+}
+
+static int emv_tag_info_render(
+	const struct emv_tag_info_entry_t* entry,
+	const struct emv_tlv_t* tlv,
+	const struct emv_tlv_sources_t* sources,
+	char* value_str,
+	size_t value_str_len
+)
+{
+	int r;
+
+	switch (entry->renderer) {
+		case EMV_TAG_RENDERER_NONE:
 			return 0;
 
-		case EMV_TAG_84_DF_NAME:
-			info->tag_name = "Dedicated File (DF) Name";
-			info->tag_desc =
-				"Identifies the name of the Dedicated File (DF) as described "
-				"in ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_FORMAT:
+			return emv_tlv_value_get_string(tlv, entry->format, entry->max_format_len, value_str, value_str_len);
+
+		case EMV_TAG_RENDERER_FORMAT_AN:
+			return emv_tlv_value_get_string(tlv, EMV_FORMAT_AN, entry->max_format_len, value_str, value_str_len);
+
+		case EMV_TAG_RENDERER_DF_NAME:
 			if ((tlv->length == strlen(EMV_PSE) && strncmp((const char*)tlv->value, EMV_PSE, strlen(EMV_PSE))) ||
 				(tlv->length == strlen(EMV_PPSE) && strncmp((const char*)tlv->value, EMV_PPSE, strlen(EMV_PPSE)))
 			) {
@@ -280,1431 +353,214 @@ int emv_tlv_get_info(
 			}
 			return emv_aid_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_86_ISSUER_SCRIPT_COMMAND:
-			info->tag_name = "Issuer Script Command";
-			info->tag_desc = "Contains a command for transmission to the ICC";
-			info->format = EMV_FORMAT_VAR;
-			return emv_capdu_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_87_APPLICATION_PRIORITY_INDICATOR:
-			info->tag_name = "Application Priority Indicator";
-			info->tag_desc =
-				"Indicates the priority of a given application or group of "
-				"applications in a directory";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_COUNTRY_ALPHA2:
+			// Lookup country code; fallback to format "a" string
+			r = emv_country_alpha2_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
+			if (r || (value_str && value_str_len && !value_str[0])) {
+				return emv_tlv_value_get_string(tlv, entry->format, entry->max_format_len, value_str, value_str_len);
+			}
 			return 0;
 
-		case EMV_TAG_88_SFI:
-			info->tag_name = "Short File Identifier (SFI)";
-			info->tag_desc =
-				"Identifies the Application Elementary File (AEF) referenced "
-				"in commands related to a given Application Definition File "
-				"or Directory Definition File (DDF). It is a binary data "
-				"object having a value in the range 1 - 30 and with the three "
-				"high order bits set to zero.";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_COUNTRY_ALPHA3:
+			// Lookup country code; fallback to format "a" string
+			r = emv_country_alpha3_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
+			if (r || (value_str && value_str_len && !value_str[0])) {
+				return emv_tlv_value_get_string(tlv, entry->format, entry->max_format_len, value_str, value_str_len);
+			}
 			return 0;
 
-		case EMV_TAG_89_AUTHORISATION_CODE:
-			info->tag_name = "Authorisation Code";
-			info->tag_desc =
-				"Value generated by the authorisation authority "
-				"(issuer) for an approved transaction";
-			// EMV 4.4 Book 3 Annex A indicates that the format is defined
-			// by the Payment System. M/Chip and VCPS both define this field
-			// as format 'ans' with length 6.
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 6, value_str, value_str_len);
-
-		case EMV_TAG_8A_AUTHORISATION_RESPONSE_CODE:
-			info->tag_name = "Authorisation Response Code";
-			info->tag_desc = "Code that defines the disposition of a message";
-			info->format = EMV_FORMAT_AN;
-			return emv_auth_response_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
+		case EMV_TAG_RENDERER_AID:
+			return emv_aid_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_8B_POI_INFORMATION:
-			info->tag_name = "POI Information";
-			info->tag_desc =
-				"Contains information about the terminal and the acceptance "
-				"environment.";
-			info->format = EMV_FORMAT_B;
-			return emv_poi_info_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+		case EMV_TAG_RENDERER_TRACK2_EQUIVALENT_DATA:
+			return emv_track2_equivalent_data_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_8C_CDOL1:
-			info->tag_name = "Card Risk Management Data Object List 1 (CDOL1)";
-			info->tag_desc =
-				"List of data objects (tag and length) to be passed to the "
-				"ICC in the first GENERATE AC command";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
+		case EMV_TAG_RENDERER_AMOUNT:
+			return emv_amount_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_8D_CDOL2:
-			info->tag_name = "Card Risk Management Data Object List 2 (CDOL2)";
-			info->tag_desc =
-				"List of data objects (tag and length) to be passed to the "
-				"ICC in the second GENERATE AC command";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
+		case EMV_TAG_RENDERER_AIP:
+			return emv_aip_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_8E_CVM_LIST:
-			info->tag_name = "Cardholder Verification Method (CVM) List";
-			info->tag_desc =
-				"Identifies a method of verification of the cardholder "
-				"supported by the application";
-			info->format = EMV_FORMAT_B;
-			return emv_cvm_list_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+		case EMV_TAG_RENDERER_CAPDU:
+			return emv_capdu_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX:
-			info->tag_name = "Certification Authority Public Key (CAPK) Index";
-			info->tag_desc =
-				"Identifies the certification authority's public key in "
-				"conjunction with the RID";
-			info->format = EMV_FORMAT_B;
-			return 0;
+		case EMV_TAG_RENDERER_AUTH_RESPONSE_CODE:
+			return emv_auth_response_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
+
+		case EMV_TAG_RENDERER_POI_INFO:
+			return emv_poi_info_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+
+		case EMV_TAG_RENDERER_CVM_LIST:
+			return emv_cvm_list_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE:
-			info->tag_name = "Issuer Public Key Certificate";
-			info->tag_desc =
-				"Issuer public key certified by a certification authority";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_ISSUER_CERT:
 			return emv_issuer_cert_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);
 
-		case EMV_TAG_91_ISSUER_AUTHENTICATION_DATA:
-			info->tag_name = "Issuer Authentication Data";
-			info->tag_desc =
-				"Data sent to the ICC for online issuer authentication";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_ISSUER_AUTH_DATA:
 			return emv_issuer_auth_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER:
-			info->tag_name = "Issuer Public Key Remainder";
-			info->tag_desc =
-				"Remaining digits of the Issuer Public Key Modulus";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_93_SIGNED_STATIC_APPLICATION_DATA:
-			info->tag_name = "Signed Static Application Data (SSAD)";
-			info->tag_desc =
-				"Digital signature on critical application "
-				"parameters for SDA";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_SSAD:
 			return emv_ssad_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);
 
-		case EMV_TAG_94_APPLICATION_FILE_LOCATOR:
-			info->tag_name = "Application File Locator (AFL)";
-			info->tag_desc =
-				"Indicates the location (SFI, range of records) of the "
-				"Application Elementary Files (AEFs) related to a given "
-				"application";
-			info->format = EMV_FORMAT_VAR;
+		case EMV_TAG_RENDERER_AFL:
 			return emv_afl_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS:
-			info->tag_name = "Terminal Verification Results (TVR)";
-			info->tag_desc =
-				"Status of the different functions as seen from the terminal";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_TVR:
 			return emv_tvr_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_96_KERNEL_IDENTIFIER_TERMINAL:
-			info->tag_name = "Kernel Identifier - terminal";
-			info->tag_desc = "Identifies the kernel used for the transaction";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_KERNEL_ID_TERMINAL:
 			return emv_kernel_id_terminal_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_97_TDOL:
-			info->tag_name = "Transaction Certificate Data Object List (TDOL)";
-			info->tag_desc =
-				"List of data objects (tag and length) to be used by the "
-				"terminal in generating the TC Hash Value";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
-
-		case EMV_TAG_98_TC_HASH:
-			info->tag_name = "Transaction Certificate (TC) Hash Value";
-			info->tag_desc =
-				"Result of a hash function using input created from the list "
-				"of data objects specified in the TDOL";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9A_TRANSACTION_DATE:
-			info->tag_name = "Transaction Date";
-			info->tag_desc =
-				"Local date that the transaction was authorised";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_DATE:
 			return emv_date_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION:
-			info->tag_name = "Transaction Status Information (TSI)";
-			info->tag_desc =
-				"Indicates the functions performed in a transaction";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_TSI:
 			return emv_tsi_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9C_TRANSACTION_TYPE:
-			info->tag_name = "Transaction Type";
-			info->tag_desc =
-				"Indicates the type of financial transaction, represented by "
-				"the first two digits of the ISO 8583:1987 Processing Code. "
-				"The actual values to be used for the Transaction Type data "
-				"element are defined by the relevant payment system.";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_TRANSACTION_TYPE:
 			if (!tlv->value) {
-				// Cannot use tlv->value[0], even if value_str is NULL.
-				// This is typically for Data Object List (DOL) entries that
-				// have been packed into TLV entries for this function to use.
 				return 0;
 			}
 			return emv_transaction_type_get_string(tlv->value[0], value_str, value_str_len);
 
-		case EMV_TAG_9D_DDF_NAME:
-			info->tag_name = "Directory Definition File (DDF) Name";
-			info->tag_desc =
-				"Identifies the name of a Dedicated File (DF) associated with "
-				"a directory";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_A5_FCI_PROPRIETARY_TEMPLATE:
-			info->tag_name = "File Control Information (FCI) Proprietary Template";
-			info->tag_desc =
-				"Identifies the data object proprietary to this specification "
-				"in the File Control Information (FCI) template according to "
-				"ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
-
-		case EMV_TAG_5F20_CARDHOLDER_NAME:
-			info->tag_name = "Cardholder Name";
-			info->tag_desc =
-				"Indicates cardholder name according to ISO 7813";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 26, value_str, value_str_len);
-
-		case EMV_TAG_5F24_APPLICATION_EXPIRATION_DATE:
-			info->tag_name = "Application Expiration Date";
-			info->tag_desc =
-				"Date after which application expires";
-			info->format = EMV_FORMAT_N;
-			return emv_date_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_5F25_APPLICATION_EFFECTIVE_DATE:
-			info->tag_name = "Application Effective Date";
-			info->tag_desc =
-				"Date from which the application may be used";
-			info->format = EMV_FORMAT_N;
-			return emv_date_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_5F28_ISSUER_COUNTRY_CODE:
-			info->tag_name = "Issuer Country Code";
-			info->tag_desc =
-				"Indicates the country of the issuer according to ISO 3166";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_COUNTRY_NUMERIC_CODE:
 			return emv_country_numeric_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_5F2A_TRANSACTION_CURRENCY_CODE:
-			info->tag_name = "Transaction Currency Code";
-			info->tag_desc =
-				"Indicates the currency code of the transaction according to "
-				"ISO 4217";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_CURRENCY_NUMERIC_CODE:
 			return emv_currency_numeric_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_5F2D_LANGUAGE_PREFERENCE:
-			info->tag_name = "Language Preference";
-			info->tag_desc =
-				"1-4 languages stored in order of preference, each "
-				"represented by 2 alphabetical characters according to "
-				"ISO 639";
-			info->format = EMV_FORMAT_AN;
+		case EMV_TAG_RENDERER_LANGUAGE_PREFERENCE:
 			return emv_language_preference_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_5F30_SERVICE_CODE:
-			info->tag_name = "Service Code";
-			info->tag_desc =
-				"Service code as defined in ISO/IEC 7813 for "
-				"track 1 and track 2";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 3, value_str, value_str_len);
-
-		case EMV_TAG_5F34_APPLICATION_PAN_SEQUENCE_NUMBER:
-			info->tag_name = "Application Primary Account Number (PAN) Sequence Number";
-			info->tag_desc =
-				"Identifies and differentiates cards with the same PAN";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_5F36_TRANSACTION_CURRENCY_EXPONENT:
-			info->tag_name = "Transaction Currency Exponent";
-			info->tag_desc =
-				"Indicates the implied position of the decimal point from the "
-				"right of the transaction amount represented according to "
-				"ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_5F50_ISSUER_URL:
-			info->tag_name = "Issuer URL";
-			info->tag_desc =
-				"The URL provides the location of the issuer's Library Server "
-				"on the Internet";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 0, value_str, value_str_len);
-
-		case EMV_TAG_5F53_IBAN:
-			info->tag_name = "International Bank Account Number (IBAN)";
-			info->tag_desc =
-				"Uniquely identifies the account of a customer at a financial "
-				"institution as defined in ISO 13616.";
-			info->format = EMV_FORMAT_VAR;
-			// EMV 4.4 Book 3 Annex A states that this field has format 'var'
-			// and a length of up to 34 bytes while Wikipedia states that an
-			// IBAN consists of 34 alphanumeric characters. Therefore this
-			// implementation assumes that this field can be interpreted as
-			// format 'an'.
-			return emv_tlv_value_get_string(tlv, EMV_FORMAT_AN, 34, value_str, value_str_len);
-
-		case EMV_TAG_5F54_BANK_IDENTIFIER_CODE:
-			info->tag_name = "Bank Identifier Code (BIC)";
-			info->tag_desc =
-				"Uniquely identifies a bank as defined in ISO 9362.";
-			info->format = EMV_FORMAT_VAR;
-			return emv_tlv_value_get_string(tlv, EMV_FORMAT_AN, 11, value_str, value_str_len);
-
-		case EMV_TAG_5F55_ISSUER_COUNTRY_CODE_ALPHA2:
-			info->tag_name = "Issuer Country Code (alpha2 format)";
-			info->tag_desc =
-				"Indicates the country of the issuer as defined in ISO 3166 "
-				"(using a 2 character alphabetic code)";
-			info->format = EMV_FORMAT_A;
-			// Lookup country code; fallback to format "a" string
-			r = emv_country_alpha2_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
-			if (r || (value_str && value_str_len && !value_str[0])) {
-				return emv_tlv_value_get_string(tlv, info->format, 2, value_str, value_str_len);
-			}
-			return 0;
-
-		case EMV_TAG_5F56_ISSUER_COUNTRY_CODE_ALPHA3:
-			info->tag_name = "Issuer Country Code (alpha3 format)";
-			info->tag_desc =
-				"Indicates the country of the issuer as defined in ISO 3166 "
-				"(using a 3 character alphabetic code)";
-			info->format = EMV_FORMAT_A;
-			// Lookup country code; fallback to format "a" string
-			r = emv_country_alpha3_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
-			if (r || (value_str && value_str_len && !value_str[0])) {
-				return emv_tlv_value_get_string(tlv, info->format, 3, value_str, value_str_len);
-			}
-			return 0;
-
-		case EMV_TAG_5F57_ACCOUNT_TYPE:
-			info->tag_name = "Account Type";
-			info->tag_desc =
-				"Indicates the type of account selected on the "
-				"terminal, coded as specified in Annex G";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_ACCOUNT_TYPE:
 			if (!tlv->value) {
-				// Cannot use tlv->value[0], even if value_str is NULL.
-				// This is typically for Data Object List (DOL) entries that
-				// have been packed into TLV entries for this function to use.
 				return 0;
 			}
 			return emv_account_type_get_string(tlv->value[0], value_str, value_str_len);
 
-		case EMV_TAG_9F01_ACQUIRER_IDENTIFIER:
-			info->tag_name = "Acquirer Identifier";
-			info->tag_desc =
-				"Uniquely identifies the acquirer within each payment system";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 11, value_str, value_str_len);
-
-		case EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC:
-			info->tag_name = "Amount, Authorised (Numeric)";
-			info->tag_desc =
-				"Authorised amount of the transaction (excluding adjustments)";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 12, value_str, value_str_len);
-
-		case EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC:
-			info->tag_name = "Amount, Other (Numeric)";
-			info->tag_desc =
-				"Secondary amount associated with the transaction "
-				"representing a cashback amount";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 12, value_str, value_str_len);
-
-		case EMV_TAG_9F04_AMOUNT_OTHER_BINARY:
-			info->tag_name = "Amount, Other (Binary)";
-			info->tag_desc =
-				"Secondary amount associated with the transaction "
-				"representing a cashback amount";
-			info->format = EMV_FORMAT_B;
-			return emv_amount_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F05_APPLICATION_DISCRETIONARY_DATA:
-			info->tag_name = "Application Discretionary Data";
-			info->tag_desc =
-				"Issuer or payment system specified data "
-				"relating to the application";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F06_AID:
-			info->tag_name = "Application Identifier (AID) - terminal";
-			info->tag_desc =
-				"Identifies the application as described in ISO/IEC 7816-4";
-			info->format = EMV_FORMAT_B;
-			return emv_aid_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F07_APPLICATION_USAGE_CONTROL:
-			info->tag_name = "Application Usage Control";
-			info->tag_desc =
-				"Indicates issuer's specified restrictions on the geographic "
-				"usage and services allowed for the application";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_APP_USAGE_CONTROL:
 			return emv_app_usage_control_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F08_APPLICATION_VERSION_NUMBER:
-			info->tag_name = "Application Version Number";
-			info->tag_desc =
-				"Version number assigned by the payment system for the "
-				"application";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F09_APPLICATION_VERSION_NUMBER_TERMINAL:
-			info->tag_name = "Application Version Number - terminal";
-			info->tag_desc =
-				"Version number assigned by the payment system for the "
-				"application";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F0A_ASRPD:
-			info->tag_name = "Application Selection Registered Proprietary Data (ASRPD)";
-			info->tag_desc =
-				"Proprietary data allowing for proprietary processing during "
-				"application selection. Proprietary data is identified using "
-				"Proprietary Data Identifiers that are managed by EMVCo and "
-				"their usage by the Application Selection processing is "
-				"according to their intended usage, as agreed by EMVCo during "
-				"registration.";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_ASRPD:
 			return emv_asrpd_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F0B_CARDHOLDER_NAME_EXTENDED:
-			info->tag_name = "Cardholder Name Extended";
-			info->tag_desc =
-				"Indicates the whole cardholder name when "
-				"greater than 26 characters using the same "
-				"coding convention as in ISO/IEC 7813";
-			info->format = EMV_FORMAT_ANS;
-		return emv_tlv_value_get_string(tlv, info->format, 45, value_str, value_str_len);
-
-		case EMV_TAG_9F0C_IINE:
-			info->tag_name = "Issuer Identification Number Extended (IINE)";
-			info->tag_desc =
-				"The number that identifies the major industry "
-				"and the card issuer and that forms the first "
-				"part of the Primary Account "
-				"Number (PAN).\n\n"
-				"While the first 6 digits of the IINE (tag '9F0C') "
-				"and IIN (tag '42') are the same and there is no "
-				"need to have both data objects on the card, "
-				"cards may have both the IIN and IINE data "
-				"objects present.";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 8, value_str, value_str_len);
-
-		case EMV_TAG_9F0D_ISSUER_ACTION_CODE_DEFAULT:
-			info->tag_name = "Issuer Action Code (IAC) - Default";
-			info->tag_desc =
-				"Specifies the issuer's conditions that cause a transaction "
-				"to be rejected if it might have been approved online, but "
-				"the terminal is unable to process the transaction online";
-			info->format = EMV_FORMAT_B;
-			return emv_tvr_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F0E_ISSUER_ACTION_CODE_DENIAL:
-			info->tag_name = "Issuer Action Code (IAC) - Denial";
-			info->tag_desc =
-				"Specifies the issuer's conditions that cause the denial of a "
-				"transaction without attempt to go online";
-			info->format = EMV_FORMAT_B;
-			return emv_tvr_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F0F_ISSUER_ACTION_CODE_ONLINE:
-			info->tag_name = "Issuer Action Code (IAC) - Online";
-			info->tag_desc =
-				"Specifies the issuer's conditions that cause a transaction "
-				"to be transmitted online";
-			info->format = EMV_FORMAT_B;
-			return emv_tvr_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F10_ISSUER_APPLICATION_DATA:
-			info->tag_name = "Issuer Application Data";
-			info->tag_desc =
-				"Contains proprietary application data for transmission to "
-				"the issuer in an online transaction.";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_IAD:
 			return emv_iad_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F11_ISSUER_CODE_TABLE_INDEX:
-			info->tag_name = "Issuer Code Table Index";
-			info->tag_desc =
-				"Indicates the code table according to ISO/IEC 8859 for "
-				"displaying the Application Preferred Name";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_9F12_APPLICATION_PREFERRED_NAME:
-			info->tag_name = "Application Preferred Name";
-			info->tag_desc =
-				"Preferred mnemonic associated with the AID";
-			info->format = EMV_FORMAT_ANS;
+		case EMV_TAG_RENDERER_APP_PREFERRED_NAME:
 			return emv_app_preferred_name_get_string(tlv->value, tlv->length, sources, value_str, value_str_len);
 
-		case EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER:
-			info->tag_name =
-				"Last Online Application Transaction Counter (ATC) Register";
-			info->tag_desc =
-				"Application Transaction Counter (ATC) "
-				"value of the last transaction that went "
-				"online";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F14_LOWER_CONSECUTIVE_OFFLINE_LIMIT:
-			info->tag_name = "Lower Consecutive Offline Limit";
-			info->tag_desc =
-				"Issuer-specified preference for the maximum "
-				"number of consecutive offline transactions for "
-				"this ICC application allowed in a terminal "
-				"with online capability";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F15_MCC:
-			info->tag_name = "Merchant Category Code (MCC)";
-			info->tag_desc = "Classifies the type of business being done by "
-				"the merchant, represented according to ISO 8583:1993 for "
-				"Card Acceptor Business Code.";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_MCC:
 			return emv_mcc_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F16_MERCHANT_IDENTIFIER:
-			info->tag_name = "Merchant Identifier";
-			info->tag_desc =
-				"When concatenated with the Acquirer Identifier, uniquely "
-				"identifies a given merchant";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 15, value_str, value_str_len);
-
-		case EMV_TAG_9F17_PIN_TRY_COUNTER:
-			info->tag_name =
-				"Personal Identification Number (PIN) Try Counter";
-			info->tag_desc = "Number of PIN tries remaining";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F18_ISSUER_SCRIPT_IDENTIFIER:
-			info->tag_name = "Issuer Script Identifier";
-			info->tag_desc = "Identification of the Issuer Script";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F19_TOKEN_REQUESTOR_ID:
-			info->tag_name = "Token Requestor ID";
-			info->tag_desc =
-				"Uniquely identifies the pairing of the Token "
-				"Requestor with the Token Domain, as defined "
-				"in the EMV Payment Tokenisation "
-				"Framework";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_9F1A_TERMINAL_COUNTRY_CODE:
-			info->tag_name = "Terminal Country Code";
-			info->tag_desc =
-				"Indicates the country of the terminal, represented according "
-				"to ISO 3166";
-			info->format = EMV_FORMAT_N;
-			return emv_country_numeric_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F1B_TERMINAL_FLOOR_LIMIT:
-			info->tag_name = "Terminal Floor Limit";
-			info->tag_desc =
-				"Indicates the floor limit in the terminal in conjunction "
-				"with the AID";
-			info->format = EMV_FORMAT_B;
-			return emv_amount_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F1C_TERMINAL_IDENTIFICATION:
-			info->tag_name = "Terminal Identification";
-			info->tag_desc =
-				"Designates the unique location of a terminal at a merchant";
-			info->format = EMV_FORMAT_AN;
-			return emv_tlv_value_get_string(tlv, info->format, 8, value_str, value_str_len);
-
-		case EMV_TAG_9F1D_TERMINAL_RISK_MANAGEMENT_DATA:
-			info->tag_name = "Terminal Risk Management Data";
-			info->tag_desc =
-				"Application-specific value used by the contactless card or "
-				"payment device for risk management purposes. All RFU bits "
-				"must be set to zero.";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_TERMINAL_RISK_MANAGEMENT_DATA:
 			return emv_terminal_risk_management_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F1E_IFD_SERIAL_NUMBER:
-			info->tag_name = "Interface Device (IFD) Serial Number";
-			info->tag_desc =
-				"Unique and permanent serial number assigned to the IFD by "
-				"the manufacturer";
-			info->format = EMV_FORMAT_AN;
-			return emv_tlv_value_get_string(tlv, info->format, 8, value_str, value_str_len);
-
-		case EMV_TAG_9F1F_TRACK1_DISCRETIONARY_DATA:
-			info->tag_name = "Track 1 Discretionary Data";
-			info->tag_desc =
-				"Discretionary part of track 1 according to ISO/IEC 7813";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 0, value_str, value_str_len);
-
-		case EMV_TAG_9F20_TRACK2_DISCRETIONARY_DATA:
-			info->tag_name = "Track 2 Discretionary Data";
-			info->tag_desc =
-				"Discretionary part of track 2 according to ISO/IEC 7813";
-			info->format = EMV_FORMAT_CN;
-			return emv_tlv_value_get_string(tlv, info->format, 0, value_str, value_str_len);
-
-		case EMV_TAG_9F21_TRANSACTION_TIME:
-			info->tag_name = "Transaction Time";
-			info->tag_desc =
-				"Local time that the transaction was authorised";
-			info->format = EMV_FORMAT_N;
+		case EMV_TAG_RENDERER_TIME:
 			return emv_time_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F22_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX:
-			info->tag_name = "Certification Authority Public Key (CAPK) Index - terminal";
-			info->tag_desc =
-				"Identifies the certification authority's public key in "
-				"conjunction with the RID";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F23_UPPER_CONSECUTIVE_OFFLINE_LIMIT:
-			info->tag_name = "Upper Consecutive Offline Limit";
-			info->tag_desc =
-				"Issuer-specified preference for the maximum "
-				"number of consecutive offline transactions for "
-				"this ICC application allowed in a terminal "
-				"without online capability";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F24_PAYMENT_ACCOUNT_REFERENCE:
-			info->tag_name = "Payment Account Reference (PAR)";
-			info->tag_desc =
-				"A non-financial reference assigned to each "
-				"unique PAN and used to link a Payment "
-				"Account represented by that PAN to affiliated "
-				"Payment Tokens, as defined in the EMV "
-				"Tokenisation Framework. The PAR may be "
-				"assigned in advance of Payment Token "
-				"issuance.";
-			info->format = EMV_FORMAT_AN;
-			return emv_tlv_value_get_string(tlv, info->format, 29, value_str, value_str_len);
-
-		case EMV_TAG_9F25_LAST_4_DIGITS_OF_PAN:
-			info->tag_name = "Last 4 Digits of PAN";
-			info->tag_desc =
-				"The last four digits of the PAN, as defined in "
-				"the EMV Payment Tokenisation Framework";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 4, value_str, value_str_len);
-
-		case EMV_TAG_9F26_APPLICATION_CRYPTOGRAM:
-			info->tag_name = "Application Cryptogram";
-			info->tag_desc =
-				"Cryptogram returned by the ICC in response of the "
-				"GENERATE AC command";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F27_CRYPTOGRAM_INFORMATION_DATA:
-			info->tag_name = "Cryptogram Information Data";
-			info->tag_desc =
-				"Indicates the type of cryptogram and the actions to be "
-				"performed by the terminal";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_CID:
 			if (!tlv->value) {
-				// Cannot use tlv->value[0], even if value_str is NULL.
-				// This is typically for Data Object List (DOL) entries that
-				// have been packed into TLV entries for this function to use.
 				return 0;
 			}
 			return emv_cid_get_string_list(tlv->value[0], value_str, value_str_len);
 
-		case EMV_TAG_9F29_EXTENDED_SELECTION:
-			info->tag_name = "Extended Selection";
-			info->tag_desc =
-				"The value to be appended to the ADF Name in the data field "
-				"of the SELECT command, if the Extended Selection Support "
-				"flag is present and set to 1.\n\n"
-				"Content is payment system proprietary.\n\n"
-				"Note: The maximum length of Extended Selection depends on "
-				"the length of ADF Name in the same directory entry such that "
-				"Length of Extended Selection + Length of ADF Name <= 16.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F2A_KERNEL_IDENTIFIER:
-			info->tag_name = "Kernel Identifier";
-			info->tag_desc =
-				"Indicates the card's preference for the kernel on which the "
-				"the contactless application can be processed";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_KERNEL_ID:
 			return emv_kernel_id_get_string(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT:
-			info->tag_name = "Issuer Public Key Exponent";
-			info->tag_desc =
-				"Issuer public key exponent used for the verification of the "
-				"Signed Static Application Data and the ICC Public Key "
-				"Certificate";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F33_TERMINAL_CAPABILITIES:
-			info->tag_name = "Terminal Capabilities";
-			info->tag_desc =
-				"Indicates the card data input, CVM, and security "
-				"capabilities of the terminal";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_TERM_CAPS:
 			return emv_term_caps_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F34_CVM_RESULTS:
-			info->tag_name = "Cardholder Verification Method (CVM) Results";
-			info->tag_desc =
-				"Indicates the results of the last CVM performed";
-			info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_CVM_RESULTS:
 			return emv_cvm_results_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F35_TERMINAL_TYPE:
-			info->tag_name = "Terminal Type";
-			info->tag_desc =
-				"Indicates the environment of the terminal, its "
-				"communications capability, and its operational control";
-			info->format = EMV_FORMAT_N;
-			if (!tlv->value) {
-				// Cannot use tlv->value[0], even if value_str is NULL.
-				// This is typically for Data Object List (DOL) entries that
-				// have been packed into TLV entries for this function to use.
-				return 0;
-			}
-			return emv_term_type_get_string_list(tlv->value[0], value_str, value_str_len);
-
-		case EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER:
-			info->tag_name = "Application Transaction Counter (ATC)";
-			info->tag_desc =
-				"Counter maintained by the application in the ICC "
-				"(incrementing the ATC is managed by the ICC)";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F37_UNPREDICTABLE_NUMBER:
-			info->tag_name = "Unpredictable Number";
-			info->tag_desc =
-				"Value to provide variability and uniqueness to the "
-				"generation of a cryptogram";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F38_PDOL:
-			info->tag_name = "Processing Options Data Object List (PDOL)";
-			info->tag_desc =
-				"Contains a list of terminal resident data objects (tags and "
-				"lengths) needed by the ICC in processing the GET PROCESSING "
-				"OPTIONS command";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
-
-		case EMV_TAG_9F39_POS_ENTRY_MODE:
-			info->tag_name = "Point-of-Service (POS) Entry Mode";
-			info->tag_desc =
-				"Indicates the method by which the PAN was entered, according "
-				"to the first two digits of the ISO 8583:1987 POS Entry Mode";
-			info->format = EMV_FORMAT_N;
-			if (!tlv->value) {
-				// Cannot use tlv->value[0], even if value_str is NULL.
-				// This is typically for Data Object List (DOL) entries that
-				// have been packed into TLV entries for this function to use.
-				return 0;
-			}
-			return emv_pos_entry_mode_get_string(tlv->value[0], value_str, value_str_len);
-
-		case EMV_TAG_9F3A_AMOUNT_REFERENCE_CURRENCY:
-			info->tag_name = "Amount, Reference Currency";
-			info->tag_desc =
-				"Authorised amount expressed in the reference currency";
-			info->format = EMV_FORMAT_B;
-			return emv_amount_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F3B_APPLICATION_REFERENCE_CURRENCY:
-			info->tag_name = "Application Reference Currency";
-			info->tag_desc =
-				"1-4 currency codes used between the terminal and the ICC "
-				"when the Transaction Currency Code is different from the "
-				"Application Currency Code; each code is 3 digits according "
-				"to ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return emv_app_reference_currency_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F3C_TRANSACTION_REFERENCE_CURRENCY:
-			info->tag_name = "Transaction Reference Currency";
-			info->tag_desc =
-				"Code defining the common currency used by the terminal in "
-				"case the Transaction Currency Code is different from the "
-				"Application Currency Code";
-			info->format = EMV_FORMAT_N;
-			return emv_currency_numeric_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F3D_TRANSACTION_REFERENCE_CURRENCY_EXPONENT:
-			info->tag_name = "Transaction Reference Currency Exponent";
-			info->tag_desc =
-				"Indicates the implied position of the decimal point from the "
-				"right of the transaction amount, with the Transaction "
-				"Reference Currency Code represented according to ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_9F3E_TERMINAL_CATEGORIES_SUPPORTED_LIST:
-			info->tag_name = "Terminal Categories Supported List";
-			info->tag_desc =
-				"Contains a list of one or more terminal categories supported "
-				"by the card.";
-			info->format = EMV_FORMAT_B;
-			return emv_terminal_categories_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F3F_SDOL:
-			info->tag_name = "Selection Data Object List (SDOL)";
-			info->tag_desc =
-				"Contains a list of terminal resident data objects (tags and "
-				"lengths) needed by the card in processing the SEND POI "
-				"INFORMATION (SPI) command.\n\n"
-				"The SDOL can be used to request the following terminal data "
-				"objects:\n"
-				"- Amount, Authorised (Numeric) (tag '9F02')\n"
-				"- POI Information (tag '8B')\n"
-				"- Terminal Country Code (tag '9F1A')\n"
-				"- Transaction Currency Code (tag '5F2A')\n\n"
-				"Only the data objects explicitly listed above must be known "
-				"and correct data object values provided by the terminal for "
-				"the SDOL. The terminal may recognize and be able to provide "
-				"the values for other data objects if requested via the SDOL, "
-				"but that is not required.";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
-
-		case EMV_TAG_9F40_ADDITIONAL_TERMINAL_CAPABILITIES:
-			info->tag_name = "Additional Terminal Capabilities";
-			info->tag_desc =
-				"Indicates the data input and output capabilities of the "
-				"terminal";
-			info->format = EMV_FORMAT_B;
-			return emv_addl_term_caps_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F41_TRANSACTION_SEQUENCE_COUNTER:
-			info->tag_name = "Transaction Sequence Counter";
-			info->tag_desc =
-				"Counter maintained by the terminal that is incremented by "
-				"one for each transaction";
-			info->format = EMV_FORMAT_N;
-			return emv_tlv_value_get_string(tlv, info->format, 8, value_str, value_str_len);
-
-		case EMV_TAG_9F42_APPLICATION_CURRENCY_CODE:
-			info->tag_name = "Application Currency Code";
-			info->tag_desc =
-				"Indicates the currency in which the account is managed "
-				"according to ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return emv_currency_numeric_code_get_string(tlv->value, tlv->length, value_str, value_str_len);
-
-		case EMV_TAG_9F43_APPLICATION_REFERENCE_CURRENCY_EXPONENT:
-			info->tag_name = "Application Reference Currency Exponent";
-			info->tag_desc =
-				"Indicates the implied position of the decimal point from the "
-				"right of the amount, for each of the 1-4 reference "
-				"currencies represented according to ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_9F44_APPLICATION_CURRENCY_EXPONENT:
-			info->tag_name = "Application Currency Exponent";
-			info->tag_desc =
-				"Indicates the implied position of the decimal point from the "
-				"right of the amount represented according to ISO 4217";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case EMV_TAG_9F45_DATA_AUTHENTICATION_CODE:
-			info->tag_name = "Data Authentication Code";
-			info->tag_desc =
-				"An issuer assigned value that is retained by the terminal "
-				"during the verification process of the Signed Static "
-				"Application Data";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F46_ICC_PUBLIC_KEY_CERTIFICATE:
-			info->tag_name = "Integrated Circuit Card (ICC) Public Key Certificate";
-			info->tag_desc =
-				"ICC Public Key certified by the issuer";
-			info->format = EMV_FORMAT_B;
-			return emv_icc_cert_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);;
-
-		case EMV_TAG_9F47_ICC_PUBLIC_KEY_EXPONENT:
-			info->tag_name = "Integrated Circuit Card (ICC) Public Key Exponent";
-			info->tag_desc =
-				"ICC Public Key Exponent used for the verification of the "
-				"Signed Dynamic Application Data";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F48_ICC_PUBLIC_KEY_REMAINDER:
-			info->tag_name = "Integrated Circuit Card (ICC) Public Key Remainder";
-			info->tag_desc =
-				"Remaining digits of the ICC Public Key Modulus";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F49_DDOL:
-			info->tag_name = "Dynamic Data Authentication Data Object List (DDOL)";
-			info->tag_desc =
-				"List of data objects (tag and length) to be passed to the "
-				"ICC in the INTERNAL AUTHENTICATE command";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
-
-		case EMV_TAG_9F4A_SDA_TAG_LIST:
-			info->tag_name = "Static Data Authentication (SDA) Tag List";
-			info->tag_desc =
-				"List of tags of primitive data objects defined in this "
-				"specification whose value fields are to be included in the "
-				"Signed Static or Dynamic Application Data";
-			info->format = EMV_FORMAT_TAG_LIST;
-			return 0;
-
-		case EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA:
-			info->tag_name = "Signed Dynamic Application Data (SDAD)";
-			info->tag_desc =
-				"Digital signature on critical application "
-				"parameters for DDA or CDA";
-			info->format = EMV_FORMAT_B;
-			return emv_sdad_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);
-
-		case EMV_TAG_9F4C_ICC_DYNAMIC_NUMBER:
-			info->tag_name = "Integrated Circuit Card (ICC) Dynamic Number";
-			info->tag_desc =
-				"Time-variant number generated by the ICC, to be captured by "
-				"the terminal";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F4D_LOG_ENTRY:
-			info->tag_name = "Log Entry";
-			info->tag_desc =
-				"Provides the SFI of the Transaction Log file and its number "
-				"of records";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case EMV_TAG_9F4E_MERCHANT_NAME_AND_LOCATION:
-			info->tag_name = "Merchant Name and Location";
-			info->tag_desc =
-				"Indicates the name and location of the merchant";
-			info->format = EMV_FORMAT_ANS;
-			return emv_tlv_value_get_string(tlv, info->format, 0, value_str, value_str_len);
-
-		case EMV_TAG_9F4F_LOG_FORMAT:
-			info->tag_name = "Log Format";
-			info->tag_desc =
-				"List (in tag and length format) of data objects representing "
-				"the logged data elements that are passed to the terminal when "
-				"a transaction log record is read";
-			info->format = EMV_FORMAT_DOL;
-			return 0;
-
-		case 0x9F5D: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F5D_APPLICATION_CAPABILITIES_INFORMATION && // Helps IDE find this case statement
-				tlv->length == 3
-			) {
-				// Kernel 2 defines 9F5D as Application Capabilities
-				// Information with a length of 3 bytes
-				info->tag_name = "Application Capabilities Information";
-				info->tag_desc =
-					"Lists a number of card features beyond regular payment.";
-				info->format = EMV_FORMAT_B;
-				return emv_mastercard_app_caps_info_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
-
-			if (tlv->tag == VISA_TAG_9F5D_AOSA && // Helps IDE find this case statement
-				tlv->length == 6
-			) {
-				// Kernel 3 defines 9F5D as Available Offline Spending Amount
-				// (AOSA) with a length of 6 bytes
-				info->tag_name = "Available Offline Spending Amount (AOSA)";
-				info->tag_desc =
-					"Kernel 3 proprietary data element indicating the "
-					"remaining amount available to be spent offline. The AOSA "
-					"is a calculated field used to allow the reader to "
-					"provide on a receipt or display the amount of offline "
-					"spend that is available on the card.";
-				info->format = EMV_FORMAT_N;
-				return emv_tlv_value_get_string(tlv, info->format, 12, value_str, value_str_len);
-			}
-
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
-
-		case MASTERCARD_TAG_9F60_CVC3_TRACK1:
-			info->tag_name = "CVC3 (Track1)";
-			info->tag_desc =
-				"The CVC3 (Track1) is a 2-byte cryptogram returned by the "
-				"Card in the response to the COMPUTE CRYPTOGRAPHIC CHECKSUM "
-				"command.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case MASTERCARD_TAG_9F61_CVC3_TRACK2:
-			info->tag_name = "CVC3 (Track2)";
-			info->tag_desc =
-				"The CVC3 (Track2) is a 2-byte cryptogram returned by the "
-				"Card in the response to the COMPUTE CRYPTOGRAPHIC CHECKSUM "
-				"command.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case MASTERCARD_TAG_9F62_PCVC3_TRACK1:
-			info->tag_name = "PCVC3(Track1)";
-			info->tag_desc =
-				"Indicates to the Kernel the positions in the discretionary "
-				"data field of the Track 1 Data where the CVC3 (Track1) "
-				"digits must be copied.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case 0x9F63: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F63_PUNATC_TRACK1 && // Helps IDE find this case statement
-				tlv->length == 6
-			) {
-				// Kernel 2 defines 9F63 as PUNATC(Track1) with a length of
-				// 6 bytes
-				info->tag_name = "PUNATC(Track1)";
-				info->tag_desc =
-					"Indicates to the Kernel the positions in the "
-					"discretionary data field of Track 1 Data where the "
-					"Unpredictable Number (Numeric) digits and Application "
-					"Transaction Counter (ATC) digits have to be copied.";
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
-
-			if (tlv->tag == VISA_TAG_9F63_OFFLINE_COUNTER_INITIAL_VALUE && // Helps IDE find this case statement
-				tlv->length == 1
-			) {
-				// Kernel 3 (VCPS) defines 9F63 as Offline Counter Initial
-				// Value with a length of 1 byte
-				info->tag_name = "Offline Counter Initial Value";
-				info->tag_desc =
-					"Contains the initial value of the Consecutive "
-					"Transaction Counter International (CTCI).";
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
-
-			if (tlv->tag == UNIONPAY_TAG_9F63_PRODUCT_IDENTIFICATION_INFORMATION && // Helps IDE find this case statement
-				tlv->length == 16
-			) {
-				// Kernel 7 defines 9F63 as Product Identification Information
-				// without specifying the length or description, but unverified
-				// internet sources indicate the length to be 16 bytes
-				info->tag_name = "Product Identification Information";
-				info->tag_desc = info->tag_name;
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
-
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
-
-		case MASTERCARD_TAG_9F64_NATC_TRACK1:
-			info->tag_name = "NATC(Track1)";
-			info->tag_desc =
-				"The value of NATC(Track1) represents the number of digits of "
-				"the Application Transaction Counter to be included in the "
-				"discretionary data field of Track 1 Data.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case MASTERCARD_TAG_9F65_PCVC3_TRACK2:
-			info->tag_name = "PCVC3(Track2)";
-			info->tag_desc =
-				"Indicates to the Kernel the positions in the discretionary "
-				"data field of the Track 2 Data where the CVC3 (Track2) "
-				"digits must be copied.";
-			info->format = EMV_FORMAT_B;
-			return 0;
-
-		case 0x9F66: // Used for different purposes by different kernels
-			if (tlv->tag == EMV_TAG_9F66_TTQ && // Helps IDE find this case statement
-				tlv->length == 4
-			) {
-				// Entry Point kernel as well as kernel 3, 6 and 7 define 9F66
-				// as TTQ with a length of 4 bytes
-				info->tag_name = "Terminal Transaction Qualifiers (TTQ)";
-				info->tag_desc =
-					"Indicates the requirements for online and CVM processing "
-					"as a result of Entry Point processing. The scope of this "
-					"tag is limited to Entry Point. Kernels may use this tag "
-					"for different purposes.";
-				info->format = EMV_FORMAT_B;
-				return emv_ttq_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
-
-			if (tlv->tag == MASTERCARD_TAG_9F66_PUNATC_TRACK2 && // Helps IDE find this case statement
-				tlv->length == 2
-			) {
-				// Kernel 2 defines 9F66 as PUNATC(Track2) with a length of
-				// 2 bytes
-				info->tag_name = "PUNATC(Track2)";
-				info->tag_desc =
-					"Indicates to the Kernel the positions in the "
-					"discretionary data field of Track 2 Data where the "
-					"Unpredictable Number (Numeric) digits and Application "
-					"Transaction Counter (ATC) digits have to be copied.";
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
-
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
-
-		case 0x9F67: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F67_NATC_TRACK2 && // Helps IDE find this case statement
-				tlv->length == 1
-			) {
-				// Kernel 2 defines 9F67 as NATC(Track2) with a length of
-				// 1 byte
-				info->tag_name = "NATC(Track2)";
-				info->tag_desc =
-					"The value of NATC(Track2) represents the number of "
-					"digits of the Application Transaction Counter to be "
-					"included in the discretionary data field of Track 2 "
-					"Data.";
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
-
-			if (tlv->tag == AMEX_TAG_9F67_FORM_FACTOR && // Helps IDE find this case statement
-				tlv->length == 3
-			) {
-				// Kernel 4 defines 9F67 as Form Factor with a length of
-				// 3 bytes
-				info->tag_name = "Form Factor";
-				info->tag_desc = "Identifies the form factor of the Card.";
-				info->format = EMV_FORMAT_N;
-				return emv_tlv_value_get_string(tlv, info->format, 6, value_str, value_str_len);
-			}
-
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
-
-		case 0x9F69: // Used for different purposes by different kernels
-			if (tlv->tag == VISA_TAG_9F69_CARD_AUTHENTICATION_RELATED_DATA && // Helps IDE find this case statement
-				tlv->length >= 5 && tlv->length <= 16 &&
-				tlv->value && tlv->value[0] == 0x01
-			) {
-				// Kernel 3 defines 9F69 as Card Authentication Related Data
-				// with a length of 5-16 bytes and first byte 0x01
-				info->tag_name = "Card Authentication Related Data";
-				info->tag_desc =
-					"Contains the fDDA Version Number, Card Unpredictable "
-					"Number, and Card Transaction Qualifiers.\n\n"
-					"For transactions where fDDA is performed, the Card "
-					"Authentication Related Data is returned in the last "
-					"record specified by the Application File Locator for "
-					"that transaction.";
-				info->format = EMV_FORMAT_B;
-				return emv_visa_card_auth_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
-
-			if (tlv->tag == MASTERCARD_TAG_9F69_UDOL) { // Helps IDE find this case statement
-				// Kernel 2 defines 9F69 as UDOL
-				info->tag_name = "UDOL";
-				info->tag_desc =
-					"The UDOL is the DOL that specifies the data objects to "
-					"be included in the data field of the COMPUTE "
-					"CRYPTOGRAPHIC CHECKSUM command. The UDOL must at least "
-					"include the Unpredictable Number (Numeric). The UDOL is "
-					"not mandatory for the Card. If it is not present in the "
-					"Card, then the Default UDOL is used.";
-				info->format = EMV_FORMAT_DOL;
-				return 0;
-			}
-
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
-
-		case MASTERCARD_TAG_9F6A_UNPREDICTABLE_NUMBER_NUMERIC:
-			info->tag_name = "Unpredictable Number (Numeric)";
-			info->tag_desc =
-				"Unpredictable number generated by the Kernel during a "
-				"Mag-stripe Mode transaction. The Unpredictable Number "
-				"(Numeric) is passed to the Card in the data field of the "
-				"COMPUTE CRYPTOGRAPHIC CHECKSUM command.\n\n"
-				"The 8-nUN most significant digits must be set to zero.";
-			info->format = EMV_FORMAT_N;
-			return 0;
-
-		case 0x9F6B: // Used for different purposes by different kernels
-			if (tlv->tag == VISA_TAG_9F6B_CARD_CVM_LIMIT && // Helps IDE find this case statement
-				tlv->length == 6
-			) {
-				// Kernel 3 (VCPS) defines 9F6B as Card CVM Limit with a length
-				// of 6 bytes
-				info->tag_name = "Card CVM Limit";
-				info->tag_desc =
-					"Visa proprietary data element indicating that for "
-					"domestic contactless transactions where this value is "
-					"exceeded, a CVM is required by the card.";
-				info->format = EMV_FORMAT_N;
-				return emv_tlv_value_get_string(tlv, info->format, 12, value_str, value_str_len);
+		case EMV_TAG_RENDERER_TERM_TYPE:
+			if (!tlv->value) {
+				return 0;
 			}
+			return emv_term_type_get_string_list(tlv->value[0], value_str, value_str_len);
 
-			if (tlv->tag == MASTERCARD_TAG_9F6B_TRACK2_DATA && // Helps IDE find this case statement
-				tlv->length > 6 && tlv->length <= 19
-			) {
-				// Kernel 2 defines 9F6B as Track 2 Data with a length of up to
-				// 19 bytes. Assume that it is more than 6 bytes because it
-				// would be unreasonable for track2 to be shorter than that.
-				info->tag_name = "Track 2 Data";
-				info->tag_desc =
-					"Contains the data objects of the track 2 according to "
-					"ISO/IEC 7813, excluding start sentinel, end sentinel and "
-					"Longitudinal Redundancy Check (LRC)";
-				info->format = EMV_FORMAT_VAR;
-				return emv_track2_equivalent_data_get_string(tlv->value, tlv->length, value_str, value_str_len);
+		case EMV_TAG_RENDERER_POS_ENTRY_MODE:
+			if (!tlv->value) {
+				return 0;
 			}
+			return emv_pos_entry_mode_get_string(tlv->value[0], value_str, value_str_len);
 
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
+		case EMV_TAG_RENDERER_APP_REFERENCE_CURRENCY:
+			return emv_app_reference_currency_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_9F6C_CTQ:
-			info->tag_name = "Card Transaction Qualifiers (CTQ)";
-			info->tag_desc =
-				"Used to indicate to the device the card CVM requirements, "
-				"issuer preferences, and card capabilities.";
-			info->format = EMV_FORMAT_B;
-			return emv_ctq_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+		case EMV_TAG_RENDERER_TERMINAL_CATEGORIES:
+			return emv_terminal_categories_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case 0x9F6D: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F6D_MAG_APPLICATION_VERSION_NUMBER && // Helps IDE find this case statement
-				tlv->length == 2
-			) {
-				// Kernel 2 defines 9F6D as Mag-stripe Application Version
-				// Number (Reader) with a length of 2 bytes
-				info->tag_name = "Mag-stripe Application Version Number (Reader)";
-				info->tag_desc =
-					"Version number assigned by the payment system for the "
-					"specific Mag-stripe Mode functionality of the Kernel.";
-				info->format = EMV_FORMAT_B;
-				return 0;
-			}
+		case EMV_TAG_RENDERER_ADDL_TERM_CAPS:
+			return emv_addl_term_caps_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-			if (tlv->tag == AMEX_TAG_9F6D_CONTACTLESS_READER_CAPABILITIES && // Helps IDE find this case statement
-				tlv->length == 1
-			) {
-				// Kernel 4 defines 9F6D as Contactless Reader Capabilities
-				// with a length of 1 byte
-				info->tag_name = "Contactless Reader Capabilities";
-				info->tag_desc =
-					"A proprietary data element with bits 8, 7, and 4 only "
-					"used to indicate a terminal's capability to support "
-					"Kernel 4 mag-stripe or EMV contactless. This data "
-					"element is OR'd with Terminal Type, Tag '9F35', "
-					"resulting in a modified Tag '9F35', which is passed to "
-					"the card when requested.";
-				info->format = EMV_FORMAT_B;
-				if (!tlv->value) {
-					// Cannot use tlv->value[0], even if value_str is NULL.
-					// This is typically for Data Object List (DOL) entries that
-					// have been packed into TLV entries for this function to use.
-					return 0;
-				}
-				return emv_amex_cl_reader_caps_get_string(tlv->value[0], value_str, value_str_len);
-			}
+		case EMV_TAG_RENDERER_ICC_CERT:
+			return emv_icc_cert_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);
 
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
+		case EMV_TAG_RENDERER_SDAD:
+			return emv_sdad_get_string_list(tlv->value, tlv->length, sources, value_str, value_str_len);
 
-		case 0x9F6E: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F6E_THIRD_PARTY_DATA && // Helps IDE find this case statement
-				tlv->length > 4 && tlv->length <= 32
-			) {
-				// Kernel 2 defines 9F6E as Third Party Data with a length of
-				// 5 to 32 bytes
-				info->tag_name = "Third Party Data";
-				info->tag_desc =
-					"The Third Party data object may be used to carry "
-					"specific product information to be optionally used by "
-					"the terminal in processing transactions.";
-				info->format = EMV_FORMAT_VAR;
-				return emv_mastercard_third_party_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
+		case EMV_TAG_RENDERER_MASTERCARD_APP_CAPS_INFO:
+			return emv_mastercard_app_caps_info_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-			if (tlv->tag == VISA_TAG_9F6E_FORM_FACTOR_INDICATOR && // Helps IDE find this case statement
-				tlv->length == 4 &&
-				tlv->value &&
-				(tlv->value[0] & VISA_FFI_VERSION_MASK) == VISA_FFI_VERSION_NUMBER_1 && // VCPS only defines version number 1
-				!tlv->value[2] && // VCPS indicates that byte 3 is RFU and should be zero'd
-				tlv->value[3] == VISA_FFI_PAYMENT_TXN_TECHNOLOGY_CONTACTLESS // VCPS only defines contactless
-			) {
-				// Kernel 3 defines 9F6E as Form Factor Indicator (FFI) with a
-				// length of 4 bytes and currently only FFI version number 1 is
-				// defined by VCPS.
-				info->tag_name = "Form Factor Indicator (FFI)";
-				info->tag_desc =
-					"Indicates the form factor of the consumer payment device "
-					"and thetype of contactless interface over which the "
-					"transaction was conducted. This information is made "
-					"available to the issuer host.";
-				info->format = EMV_FORMAT_B;
-				return emv_visa_form_factor_indicator_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
+		case EMV_TAG_RENDERER_TTQ:
+			return emv_ttq_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-			if (tlv->tag == AMEX_TAG_9F6E_ENHANCED_CONTACTLESS_READER_CAPABILITIES && // Helps IDE find this case statement
-				tlv->length == 4 &&
-				tlv->value &&
-				// Mandatory according to specification
-				(tlv->value[0] & AMEX_ENH_CL_READER_CAPS_FULL_ONLINE_MODE_SUPPORTED) == 0 &&
-				tlv->value[0] & AMEX_ENH_CL_READER_CAPS_PARTIAL_ONLINE_MODE_SUPPORTED &&
-				tlv->value[0] & AMEX_ENH_CL_READER_CAPS_MOBILE_SUPPORTED &&
-				(tlv->value[0] & AMEX_ENH_CL_READER_CAPS_BYTE1_RFU) == 0 &&
-				tlv->value[1] & AMEX_ENH_CL_READER_CAPS_MOBILE_CVM_SUPPORTED &&
-				(tlv->value[1] & AMEX_ENH_CL_READER_CAPS_BYTE2_RFU) == 0 &&
-				(tlv->value[2] & AMEX_ENH_CL_READER_CAPS_BYTE3_RFU) == 0 &&
-				(tlv->value[3] & AMEX_ENH_CL_READER_CAPS_BYTE4_RFU) == 0 &&
-				tlv->value[3] & AMEX_ENH_CL_READER_CAPS_KERNEL_VERSION_MASK
-			) {
-				// Kernel 4 defines 9F6E as Enhanced Contactless Reader
-				// Capabilities with a length of 4 bytes and various mandatory
-				// bits
-				info->tag_name = "Enhanced Contactless Reader Capabilities";
-				info->tag_desc =
-					"Proprietary Data Element for managing Contactless "
-					"transactions and includes Contactless terminal "
-					"capabilities (static) and contactless Mobile transaction "
-					"(dynamic data) around CVM";
-				info->format = EMV_FORMAT_B;
-				return emv_amex_enh_cl_reader_caps_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
-			}
+		case EMV_TAG_RENDERER_VISA_CARD_AUTH_DATA:
+			return emv_visa_card_auth_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
+		case EMV_TAG_RENDERER_CTQ:
+			return emv_ctq_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case 0x9F7C: // Used for different purposes by different kernels
-			if (tlv->tag == MASTERCARD_TAG_9F7C_MERCHANT_CUSTOM_DATA && // Helps IDE find this case statement
-				tlv->length == 20
-			) {
-				// Kernel 2 defines 9F7C as Merchant Custom Data with a length
-				// of 20 bytes
-				info->tag_name = "Merchant Custom Data";
-				info->tag_desc =
-					"Proprietary merchant data that may be requested by the "
-					"card.";
-				info->format = EMV_FORMAT_B;
+		case EMV_TAG_RENDERER_AMEX_CL_READER_CAPS:
+			if (!tlv->value) {
 				return 0;
 			}
+			return emv_amex_cl_reader_caps_get_string(tlv->value[0], value_str, value_str_len);
 
-			if (tlv->tag == VISA_TAG_9F7C_CUSTOMER_EXCLUSIVE_DATA && // Helps IDE find this case statement
-				tlv->length <= 32
-			) {
-				// Kernel 3 defines 9F7C as Customer Exclusive Data (CED) with
-				// a length of up to 32 bytes. Note that this implementation
-				// cannot distinguish it from kernel 2's definition when the
-				// provided field has a length of 20 bytes.
-				info->tag_name = "Customer Exclusive Data (CED)";
-				info->tag_desc =
-					"Contains data for transmission to the issuer.";
-				info->format = EMV_FORMAT_VAR;
-				return 0;
-			}
+		case EMV_TAG_RENDERER_MASTERCARD_THIRD_PARTY_DATA:
+			return emv_mastercard_third_party_data_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-			// Same as default case
-			info->format = EMV_FORMAT_B;
-			return 1;
+		case EMV_TAG_RENDERER_VISA_FORM_FACTOR_INDICATOR:
+			return emv_visa_form_factor_indicator_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
 
-		case EMV_TAG_BF0C_FCI_ISSUER_DISCRETIONARY_DATA:
-			info->tag_name = "File Control Information (FCI) Issuer Discretionary Data";
-			info->tag_desc =
-				"Issuer discretionary part of the File Control Information (FCI)";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+		case EMV_TAG_RENDERER_AMEX_ENH_CL_READER_CAPS:
+			return emv_amex_enh_cl_reader_caps_get_string_list(tlv->value, tlv->length, value_str, value_str_len);
+	}
 
-		case EMV_TAG_BF4C_BIOMETRIC_TRY_COUNTERS_TEMPLATE:
-			info->tag_name = "Biometric Try Counters Template";
-			info->tag_desc =
-				"A template that contains one or more Biometric Try Counters";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+	// Unknown renderer
+	return -1;
+}
 
-		case EMV_TAG_BF4D_PREFERRED_ATTEMPTS_TEMPLATE:
-			info->tag_name = "Preferred Attempts Template";
-			info->tag_desc =
-				"A template that contains the TLV-coded values for the "
-				"preferred attempts of any BIT of a Biometric Type";
-			info->format = EMV_FORMAT_VAR;
-			return 0;
+static int emv_tlv_get_asn1_info(
+	const struct emv_tlv_t* tlv,
+	struct emv_tlv_info_t* info,
+	char* value_str,
+	size_t value_str_len
+)
+{
+	int r;
+	struct iso8825_tlv_info_t iso8825_info;
 
-		default: {
-			// If it is not a known EMV field, attempt to decode it as an
-			// ASN.1 field
-			struct iso8825_tlv_info_t iso8825_info;
-			r = iso8825_tlv_get_info(
-				&tlv->ber,
-				&iso8825_info,
-				value_str,
-				value_str_len
-			);
-			if (iso8825_info.tag_name) {
-				// Known ASN.1 field
-				info->tag_name = iso8825_info.tag_name;
-				info->tag_desc = iso8825_info.tag_desc;
+	// If it is not a known EMV field, attempt to find it as an ASN.1 field
+	r = iso8825_tlv_get_info(&tlv->ber, &iso8825_info, value_str, value_str_len);
+	if (iso8825_info.tag_name) {
+		// Known ASN.1 field
+		info->tag_name = iso8825_info.tag_name;
+		info->tag_desc = iso8825_info.tag_desc;
 
-				// Even if known field, value parsing may still have failed
-				info->format = EMV_FORMAT_B;
-				return r;
-			}
+		// Even if known field, value parsing may still have failed
+		info->format = EMV_FORMAT_B;
+		return r;
+	}
 
-			// Unknown field
-			info->format = EMV_FORMAT_B;
-			if (value_str && value_str_len) {
-				value_str[0] = 0; // Default to empty value string
-			}
-			return 1;
-		}
+	// Unknown field
+	info->format = EMV_FORMAT_B;
+	if (value_str && value_str_len) {
+		value_str[0] = 0; // Default to empty value string
 	}
+	return 1;
 }
 
 /**
@@ -4495,27 +3351,427 @@ int emv_cvm_results_get_string_list(
 	return 0;
 }
 
+int emv_tlv_sources_enable_cert_cache(
+	struct emv_tlv_sources_t* sources,
+	struct emv_cert_cache_t* cache
+)
+{
+	if (!sources || !cache) {
+		return -1;
+	}
+
+	// Cache will be validated lazily by the next certificate recovery
+	sources->cert_cache = cache;
+
+	return 0;
+}
+
+static void emv_cert_cache_release(struct emv_cert_cache_t* cache)
+{
+	while (cache->entries) {
+		struct emv_cert_cache_entry_t* entry = cache->entries;
+		cache->entries = entry->next;
+		free(entry);
+	}
+	*cache = EMV_CERT_CACHE_INIT;
+}
+
+void emv_cert_cache_clear(struct emv_cert_cache_t* cache)
+{
+	if (!cache) {
+		return;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&cert_cache_lock);
+#endif
+	emv_cert_cache_release(cache);
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&cert_cache_lock);
+#endif
+}
+
+static bool emv_cert_cache_is_usable(const struct emv_tlv_sources_t* sources)
+{
+	if (!sources || !sources->cert_cache) {
+		return false;
+	}
+	if (sources->count > sizeof(sources->cert_cache->list) / sizeof(sources->cert_cache->list[0])) {
+		return false;
+	}
+
+	// Lists are identified by their generation, which is unique across all
+	// lists, instead of by their address such that a list that reuses the
+	// address of a previous list, for example on the stack, cannot match the
+	// cache. Lists that were populated without the EMV TLV list functions have
+	// no generation and cannot be identified.
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		const struct emv_tlv_list_t* list = sources->list[i];
+
+		if (list && list->front && !list->generation) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool emv_cert_cache_is_valid(
+	const struct emv_tlv_sources_t* sources,
+	uint64_t capk_generation
+)
+{
+	const struct emv_cert_cache_t* cache = sources->cert_cache;
+
+	// Cache is only valid for the same CAPKs and the same lists, without
+	// modification, in the same order
+	if (cache->capk_generation != capk_generation) {
+		return false;
+	}
+	if (cache->count != sources->count) {
+		return false;
+	}
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		const struct emv_tlv_list_t* list = sources->list[i];
+
+		if (cache->list[i].generation != (list ? list->generation : 0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void emv_cert_cache_reset(
+	const struct emv_tlv_sources_t* sources,
+	uint64_t capk_generation
+)
+{
+	struct emv_cert_cache_t* cache = sources->cert_cache;
+
+	emv_cert_cache_release(cache);
+
+	cache->capk_generation = capk_generation;
+	cache->count = sources->count;
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		const struct emv_tlv_list_t* list = sources->list[i];
+
+		cache->list[i].generation = list ? list->generation : 0;
+	}
+}
+
+static bool emv_cert_cache_get(
+	const struct emv_tlv_sources_t* sources,
+	uint64_t capk_generation,
+	enum emv_cert_cache_type_t type,
+	const uint8_t* cert,
+	size_t cert_len,
+	void* out1,
+	size_t out1_len,
+	void* out2,
+	size_t out2_len,
+	int* result
+)
+{
+	bool found = false;
+
+	if (!emv_cert_cache_is_usable(sources)) {
+		return false;
+	}
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&cert_cache_lock);
+#endif
+	if (!emv_cert_cache_is_valid(sources, capk_generation)) {
+		emv_cert_cache_reset(sources, capk_generation);
+	} else {
+		for (const struct emv_cert_cache_entry_t* entry = sources->cert_cache->entries; entry; entry = entry->next) {
+			if (entry->type != type ||
+				entry->cert_len != cert_len ||
+				memcmp(entry->data, cert, cert_len) != 0
+			) {
+				continue;
+			}
+
+			memcpy(out1, entry->data + cert_len, out1_len);
+			memcpy(out2, entry->data + cert_len + out1_len, out2_len);
+			*result = entry->result;
+			found = true;
+			break;
+		}
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&cert_cache_lock);
+#endif
+
+	return found;
+}
+
+static void emv_cert_cache_put(
+	const struct emv_tlv_sources_t* sources,
+	uint64_t capk_generation,
+	enum emv_cert_cache_type_t type,
+	const uint8_t* cert,
+	size_t cert_len,
+	const void* out1,
+	size_t out1_len,
+	const void* out2,
+	size_t out2_len,
+	int result
+)
+{
+	struct emv_cert_cache_t* cache;
+	struct emv_cert_cache_entry_t* entry;
+
+	if (!emv_cert_cache_is_usable(sources)) {
+		return;
+	}
+	cache = sources->cert_cache;
+
+	// Certificate followed by recovery output
+	entry = malloc(sizeof(*entry) + cert_len + out1_len + out2_len);
+	if (!entry) {
+		// Caching is optional
+		return;
+	}
+	entry->type = type;
+	entry->result = result;
+	entry->cert_len = cert_len;
+	memcpy(entry->data, cert, cert_len);
+	memcpy(entry->data + cert_len, out1, out1_len);
+	memcpy(entry->data + cert_len + out1_len, out2, out2_len);
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&cert_cache_lock);
+#endif
+	// The outcome is only cached for the CAPK store generation and the
+	// sources that were observed before recovery started. The CAPK store may
+	// have been updated, or another thread may have reset the cache for a
+	// newer CAPK store generation, during recovery.
+	if (emv_cert_cache_is_valid(sources, capk_generation) &&
+		capk_generation == emv_capk_get_generation()
+	) {
+		entry->next = cache->entries;
+		cache->entries = entry;
+		entry = NULL;
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&cert_cache_lock);
+#endif
+
+	free(entry);
+}
+
 static int emv_decrypt_issuer_pkey(
 	const uint8_t* issuer_cert,
 	size_t issuer_cert_len,
 	const struct emv_tlv_sources_t* sources,
-	const struct emv_capk_t** capk,
+	struct emv_cert_capk_id_t* capk_id,
+	struct emv_rsa_issuer_pkey_t* pkey
+)
+{
+	int r;
+	uint64_t capk_generation;
+
+	// Observe CAPK store generation before recovery such that the outcome is
+	// never cached for a newer generation than the CAPKs that were used
+	capk_generation = emv_capk_get_generation();
+	if (emv_cert_cache_get(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_ISSUER_PKEY,
+		issuer_cert,
+		issuer_cert_len,
+		capk_id,
+		sizeof(*capk_id),
+		pkey,
+		sizeof(*pkey),
+		&r
+	)) {
+		return r;
+	}
+
+	r = emv_decrypt_issuer_pkey_uncached(issuer_cert, issuer_cert_len, sources, capk_id, pkey);
+	emv_cert_cache_put(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_ISSUER_PKEY,
+		issuer_cert,
+		issuer_cert_len,
+		capk_id,
+		sizeof(*capk_id),
+		pkey,
+		sizeof(*pkey),
+		r
+	);
+
+	return r;
+}
+
+static int emv_decrypt_ssad(
+	const uint8_t* ssad,
+	size_t ssad_len,
+	const struct emv_tlv_sources_t* sources,
+	struct emv_rsa_issuer_pkey_t* issuer_pkey,
+	struct emv_rsa_ssad_t* data
+)
+{
+	int r;
+	uint64_t capk_generation;
+
+	// Observe CAPK store generation before recovery such that the outcome is
+	// never cached for a newer generation than the CAPKs that were used
+	capk_generation = emv_capk_get_generation();
+	if (emv_cert_cache_get(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_SSAD,
+		ssad,
+		ssad_len,
+		issuer_pkey,
+		sizeof(*issuer_pkey),
+		data,
+		sizeof(*data),
+		&r
+	)) {
+		return r;
+	}
+
+	r = emv_decrypt_ssad_uncached(ssad, ssad_len, sources, issuer_pkey, data);
+	emv_cert_cache_put(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_SSAD,
+		ssad,
+		ssad_len,
+		issuer_pkey,
+		sizeof(*issuer_pkey),
+		data,
+		sizeof(*data),
+		r
+	);
+
+	return r;
+}
+
+static int emv_decrypt_icc_pkey(
+	const uint8_t* icc_cert,
+	size_t icc_cert_len,
+	const struct emv_tlv_sources_t* sources,
+	struct emv_rsa_issuer_pkey_t* issuer_pkey,
+	struct emv_rsa_icc_pkey_t* icc_pkey
+)
+{
+	int r;
+	uint64_t capk_generation;
+
+	// Observe CAPK store generation before recovery such that the outcome is
+	// never cached for a newer generation than the CAPKs that were used
+	capk_generation = emv_capk_get_generation();
+	if (emv_cert_cache_get(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_ICC_PKEY,
+		icc_cert,
+		icc_cert_len,
+		issuer_pkey,
+		sizeof(*issuer_pkey),
+		icc_pkey,
+		sizeof(*icc_pkey),
+		&r
+	)) {
+		return r;
+	}
+
+	r = emv_decrypt_icc_pkey_uncached(icc_cert, icc_cert_len, sources, issuer_pkey, icc_pkey);
+	emv_cert_cache_put(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_ICC_PKEY,
+		icc_cert,
+		icc_cert_len,
+		issuer_pkey,
+		sizeof(*issuer_pkey),
+		icc_pkey,
+		sizeof(*icc_pkey),
+		r
+	);
+
+	return r;
+}
+
+static int emv_decrypt_sdad(
+	const uint8_t* sdad,
+	size_t sdad_len,
+	const struct emv_tlv_sources_t* sources,
+	struct emv_rsa_icc_pkey_t* icc_pkey,
+	struct emv_rsa_sdad_t* data
+)
+{
+	int r;
+	uint64_t capk_generation;
+
+	// Observe CAPK store generation before recovery such that the outcome is
+	// never cached for a newer generation than the CAPKs that were used
+	capk_generation = emv_capk_get_generation();
+	if (emv_cert_cache_get(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_SDAD,
+		sdad,
+		sdad_len,
+		icc_pkey,
+		sizeof(*icc_pkey),
+		data,
+		sizeof(*data),
+		&r
+	)) {
+		return r;
+	}
+
+	r = emv_decrypt_sdad_uncached(sdad, sdad_len, sources, icc_pkey, data);
+	emv_cert_cache_put(
+		sources,
+		capk_generation,
+		EMV_CERT_CACHE_SDAD,
+		sdad,
+		sdad_len,
+		icc_pkey,
+		sizeof(*icc_pkey),
+		data,
+		sizeof(*data),
+		r
+	);
+
+	return r;
+}
+
+static int emv_decrypt_issuer_pkey_uncached(
+	const uint8_t* issuer_cert,
+	size_t issuer_cert_len,
+	const struct emv_tlv_sources_t* sources,
+	struct emv_cert_capk_id_t* capk_id,
 	struct emv_rsa_issuer_pkey_t* pkey
 )
 {
 	int r;
 	struct emv_capk_itr_t capk_itr;
+	const struct emv_capk_t* capk;
+
+	// Outputs are cached, also for failures
+	memset(capk_id, 0, sizeof(*capk_id));
+	memset(pkey, 0, sizeof(*pkey));
 
 	// Try all available CAPKs to decrypt issuer public key certificate
 	r = emv_capk_itr_init(&capk_itr);
 	if (r) {
 		return -2;
 	}
-	while ((*capk = emv_capk_itr_next(&capk_itr)) != NULL) {
+	while ((capk = emv_capk_itr_next(&capk_itr)) != NULL) {
 		r = emv_rsa_retrieve_issuer_pkey(
 			issuer_cert,
 			issuer_cert_len,
-			*capk,
+			capk,
 			NULL,
 			NULL,
 			pkey
@@ -4526,6 +3782,10 @@ static int emv_decrypt_issuer_pkey(
 			continue;
 		}
 
+		// The CAPK is only valid until the iterator is released
+		memcpy(capk_id->rid, capk->rid, sizeof(capk_id->rid));
+		capk_id->index = capk->index;
+
 		// Issuer public certificate decrypted but public key not yet
 		// retrieved or validated
 		struct emv_tlv_sources_itr_t remainder_itr;
@@ -4535,9 +3795,12 @@ static int emv_decrypt_issuer_pkey(
 		// first try without it in case it is not needed
 		r = emv_tlv_sources_itr_init(sources, &remainder_itr);
 		if (r) {
+			emv_capk_itr_release(&capk_itr);
 			return -2;
 		}
 		do {
+			// These transient lists are only passed to the retrieval
+			// function and never to the certificate recovery cache
 			struct emv_tlv_list_t icc = EMV_TLV_LIST_INIT;
 			struct emv_tlv_list_t params = EMV_TLV_LIST_INIT;
 
@@ -4576,7 +3839,7 @@ static int emv_decrypt_issuer_pkey(
 			r = emv_rsa_retrieve_issuer_pkey(
 				issuer_cert,
 				issuer_cert_len,
-				*capk,
+				capk,
 				&icc,
 				&params,
 				pkey
@@ -4591,6 +3854,7 @@ static int emv_decrypt_issuer_pkey(
 			}
 
 			// Issuer public key retrieved and validated
+			emv_capk_itr_release(&capk_itr);
 			return 0;
 
 		} while (
@@ -4602,6 +3866,7 @@ static int emv_decrypt_issuer_pkey(
 
 		// Issuer public key certificate decrypted but public key
 		// retrieval or validation failed
+		emv_capk_itr_release(&capk_itr);
 		return 0;
 	}
 
@@ -4609,7 +3874,7 @@ static int emv_decrypt_issuer_pkey(
 	return 2;
 }
 
-static int emv_decrypt_ssad(
+static int emv_decrypt_ssad_uncached(
 	const uint8_t* ssad,
 	size_t ssad_len,
 	const struct emv_tlv_sources_t* sources,
@@ -4620,7 +3885,7 @@ static int emv_decrypt_ssad(
 	int r;
 	struct emv_tlv_sources_itr_t itr;
 	const struct emv_tlv_t* tlv;
-	const struct emv_capk_t* capk;
+	struct emv_cert_capk_id_t capk_id;
 
 	// Try all instances of Issuer Public Key Certificate (field 90) to decrypt
 	// the Signed Static Application Data (SSAD)
@@ -4638,7 +3903,7 @@ static int emv_decrypt_ssad(
 			tlv->value,
 			tlv->length,
 			sources,
-			&capk,
+			&capk_id,
 			issuer_pkey
 		);
 		if (r) {
@@ -4667,7 +3932,7 @@ static int emv_decrypt_ssad(
 	return 3;
 }
 
-static int emv_decrypt_icc_pkey(
+static int emv_decrypt_icc_pkey_uncached(
 	const uint8_t* icc_cert,
 	size_t icc_cert_len,
 	const struct emv_tlv_sources_t* sources,
@@ -4678,7 +3943,7 @@ static int emv_decrypt_icc_pkey(
 	int r;
 	struct emv_tlv_sources_itr_t itr;
 	const struct emv_tlv_t* tlv;
-	const struct emv_capk_t* capk;
+	struct emv_cert_capk_id_t capk_id;
 
 	// Try all instances of Issuer Public Key Certificate (field 90) to decrypt
 	// the ICC Public Key Certificate
@@ -4696,7 +3961,7 @@ static int emv_decrypt_icc_pkey(
 			tlv->value,
 			tlv->length,
 			sources,
-			&capk,
+			&capk_id,
 			issuer_pkey
 		);
 		if (r) {
@@ -4728,7 +3993,7 @@ static int emv_decrypt_icc_pkey(
 	return 4;
 }
 
-static int emv_decrypt_sdad(
+static int emv_decrypt_sdad_uncached(
 	const uint8_t* sdad,
 	size_t sdad_len,
 	const struct emv_tlv_sources_t* sources,
@@ -4926,7 +4191,7 @@ int emv_issuer_cert_get_string_list(
 {
 	int r;
 	struct str_itr_t str_itr;
-	const struct emv_capk_t* capk;
+	struct emv_cert_capk_id_t capk_id;
 	struct emv_rsa_issuer_pkey_t pkey;
 
 	if (!issuer_cert || !issuer_cert_len || !str || !str_len) {
@@ -4944,7 +4209,7 @@ int emv_issuer_cert_get_string_list(
 		issuer_cert,
 		issuer_cert_len,
 		sources,
-		&capk,
+		&capk_id,
 		&pkey
 	);
 	if (r) {
@@ -4952,8 +4217,8 @@ int emv_issuer_cert_get_string_list(
 	}
 
 	emv_str_list_add(&str_itr, "Retrieved using CAPK %02X%02X%02X%02X%02X #%02X",
-		capk->rid[0], capk->rid[1], capk->rid[2], capk->rid[3], capk->rid[4],
-		capk->index
+		capk_id.rid[0], capk_id.rid[1], capk_id.rid[2], capk_id.rid[3], capk_id.rid[4],
+		capk_id.index
 	);
 	emv_str_list_add(&str_itr, "Certificate Format: %02X (%s)",
 		pkey.format, emv_oda_format_get_string(pkey.format)
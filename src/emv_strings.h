@@ -2,7 +2,7 @@
  * @file emv_strings.h
  * @brief EMV string helper functions
  *
- * Copyright 2021-2025 Leon Lynch
+ * Copyright 2021-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -28,7 +28,9 @@
 
 // Forward declarations
 struct emv_tlv_t;
+struct emv_tlv_list_t;
 struct emv_tlv_sources_t;
+struct emv_cert_cache_entry_t;
 
 __BEGIN_DECLS
 
@@ -119,9 +121,48 @@ struct emv_tlv_info_t {
 	enum emv_format_t format;   ///< Value format. @see emv_format_t
 };
 
+/**
+ * EMV certificate recovery cache
+ *
+ * Caches the outcome of recovering the Issuer Public Key, Signed Static
+ * Application Data (SSAD), ICC Public Key and Signed Dynamic Application Data
+ * (SDAD) when converting values to human readable strings, such that each
+ * certificate is recovered at most once for the same EMV TLV sources. The
+ * cache is owned by the caller and referenced by
+ * @ref emv_tlv_sources_t.cert_cache. It is discarded lazily whenever any of
+ * the lists, the sources object, or the CAPK store changes.
+ *
+ * @note Use @ref emv_cert_cache_clear() to release the cache.
+ * @note A cache may be used concurrently by multiple threads, for example via
+ *       shared EMV TLV sources, but the lists must not be modified while in
+ *       use. Lists that were populated without the EMV TLV list functions
+ *       cannot be identified and are never cached.
+ */
+struct emv_cert_cache_t {
+	/// @cond INTERNAL
+	uint64_t capk_generation;
+	unsigned int count;
+	struct emv_cert_cache_list_t {
+		uint64_t generation;
+	} list[5];
+	struct emv_cert_cache_entry_t* entries;
+	/// @endcond
+};
+
+/// Static initialiser for @ref emv_cert_cache_t
+#define EMV_CERT_CACHE_INIT ((struct emv_cert_cache_t){ 0, 0, { { 0 } }, NULL })
+
 /**
  * Initialise EMV strings. This will load ISO 3166, ISO 4217,
- * and ISO 639 strings from the iso-codes package.
+ * and ISO 639 strings from the iso-codes package, as well as Merchant
+ * Category Code (MCC) strings from the mcc-codes JSON file. If emv_strings
+ * was built with the BUILD_EMV_STRINGS_DATA option, the default paths select
+ * the built-in data generated at build time instead.
+ *
+ * Calling this function is optional because each data set is loaded upon
+ * first use if it has not been loaded yet. Use this function to load all
+ * data sets immediately and to obtain loading errors, or use
+ * @ref emv_strings_init_lazy() to override paths without loading anything.
  *
  * @param isocodes_path Override directory path where iso-codes JSON files can
  *                      be found. NULL for default path (recommended).
@@ -131,6 +172,29 @@ struct emv_tlv_info_t {
  */
 int emv_strings_init(const char* isocodes_path, const char* mcc_path);
 
+/**
+ * Configure EMV strings such that each data set is only loaded upon first
+ * use. Loading upon first use is thread-safe but this function should not be
+ * called concurrently with other EMV strings functions. See
+ * @ref emv_strings_init() for the data sets.
+ *
+ * @param isocodes_path Override directory path where iso-codes JSON files can
+ *                      be found. NULL for default path (recommended).
+ * @param mcc_path Override path of mcc-codes JSON file. NULL for default
+ *                 path (recommended).
+ */
+void emv_strings_init_lazy(const char* isocodes_path, const char* mcc_path);
+
+/**
+ * Retrieve result of most recent attempt to load each data set, either by
+ * @ref emv_strings_init() or upon first use after
+ * @ref emv_strings_init_lazy(). This allows the caller to report a failure to
+ * load upon first use, for example before exiting.
+ *
+ * @return Zero for success or if no attempt was made yet. Less than zero for internal error. Greater than zero if iso-codes package or mcc-codes JSON file not found.
+ */
+int emv_strings_get_load_result(void);
+
 /**
  * Retrieve EMV TLV information, if available, and convert value to human
  * readable UTF-8 string(s), if possible.
@@ -154,6 +218,8 @@ int emv_strings_init(const char* isocodes_path, const char* mcc_path);
  * @c \\n\\n for paragraph breaks.
  * @note @c value_str output will be empty if a human readable string is not
  * available.
+ * @note This function is equivalent to @ref emv_tlv_get_tag_info() followed
+ * by @ref emv_tlv_get_value_string(), but only looks up the field once.
  *
  * @param tlv Decoded EMV TLV structure
  * @param sources EMV TLV sources to use during decoding. NULL to ignore.
@@ -170,6 +236,63 @@ int emv_tlv_get_info(
 	size_t value_str_len
 );
 
+/**
+ * Retrieve EMV TLV information, if available, without converting the value
+ * to human readable string(s). This is intended for callers that only need
+ * the tag name, description or format, such as when listing Data Object
+ * List (DOL) entries, and avoids the cost of value decoding.
+ *
+ * @param tlv Decoded EMV TLV structure
+ * @param info EMV TLV information output. See @ref emv_tlv_info_t
+ * @return Zero for success. Less than zero for error.
+ *         Greater than zero if EMV TLV field is unknown.
+ */
+int emv_tlv_get_tag_info(
+	const struct emv_tlv_t* tlv,
+	struct emv_tlv_info_t* info
+);
+
+/**
+ * Convert EMV TLV value to human readable UTF-8 string(s), if possible.
+ * See @ref emv_tlv_get_info() for fields that depend on @c sources.
+ *
+ * @note @c value_str output will be empty if a human readable string is not
+ * available.
+ *
+ * @param tlv Decoded EMV TLV structure
+ * @param sources EMV TLV sources to use during decoding. NULL to ignore.
+ * @param value_str Value string buffer output. NULL to ignore.
+ * @param value_str_len Length of value string buffer in bytes. Zero to ignore.
+ * @return Zero for success. Non-zero for error.
+ */
+int emv_tlv_get_value_string(
+	const struct emv_tlv_t* tlv,
+	const struct emv_tlv_sources_t* sources,
+	char* value_str,
+	size_t value_str_len
+);
+
+/**
+ * Enable certificate recovery cache for EMV TLV sources such that
+ * @ref emv_tlv_get_info() and @ref emv_tlv_get_value_string() recover each
+ * certificate at most once while the sources remain unchanged.
+ *
+ * @param sources EMV TLV sources
+ * @param cache EMV certificate recovery cache owned by the caller. Must
+ *              remain valid while the sources are in use.
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_tlv_sources_enable_cert_cache(
+	struct emv_tlv_sources_t* sources,
+	struct emv_cert_cache_t* cache
+);
+
+/**
+ * Clear EMV certificate recovery cache and release its resources
+ * @param cache EMV certificate recovery cache
+ */
+void emv_cert_cache_clear(struct emv_cert_cache_t* cache);
+
 /**
  * Stringify EMV format "a".
  * See @ref EMV_FORMAT_A
@@ -0,0 +1,1745 @@
+/**
+ * @file emv_tag_info_static_data.h
+ * @brief EMV tag information static data
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_TAG_INFO_STATIC_DATA_H
+#define EMV_TAG_INFO_STATIC_DATA_H
+
+#include "emv_strings.h"
+#include "emv_tags.h"
+
+#include <sys/cdefs.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+/// Criteria used to distinguish kernel specific definitions of the same tag
+enum emv_tag_match_t {
+	EMV_TAG_MATCH_ANY = 0,                      ///< Any field with this tag
+	EMV_TAG_MATCH_LENGTH,                       ///< Field length within @ref emv_tag_info_entry_t.min_len and @ref emv_tag_info_entry_t.max_len
+	EMV_TAG_MATCH_VISA_CARD_AUTH_DATA,          ///< Visa Card Authentication Related Data
+	EMV_TAG_MATCH_VISA_FFI,                     ///< Visa Form Factor Indicator (FFI) version 1
+	EMV_TAG_MATCH_AMEX_ENH_CL_READER_CAPS,      ///< Amex Enhanced Contactless Reader Capabilities
+};
+
+/// Value renderer used to convert field value to human readable string(s)
+enum emv_tag_renderer_t {
+	EMV_TAG_RENDERER_NONE = 0,                      ///< No value string
+	EMV_TAG_RENDERER_FORMAT,                        ///< Stringify according to format, up to maximum number of format digits
+	EMV_TAG_RENDERER_FORMAT_AN,                     ///< Stringify as format "an", up to maximum number of format digits
+	EMV_TAG_RENDERER_DF_NAME,                       ///< Dedicated File (DF) Name; either PSE/PPSE or AID
+	EMV_TAG_RENDERER_COUNTRY_ALPHA2,                ///< ISO 3166-1 alpha-2 country code, with fallback to format "a"
+	EMV_TAG_RENDERER_COUNTRY_ALPHA3,                ///< ISO 3166-1 alpha-3 country code, with fallback to format "a"
+	EMV_TAG_RENDERER_AID,                           ///< See @c emv_aid_get_string()
+	EMV_TAG_RENDERER_TRACK2_EQUIVALENT_DATA,        ///< See @c emv_track2_equivalent_data_get_string()
+	EMV_TAG_RENDERER_AMOUNT,                        ///< See @c emv_amount_get_string()
+	EMV_TAG_RENDERER_AIP,                           ///< See @c emv_aip_get_string_list()
+	EMV_TAG_RENDERER_CAPDU,                         ///< See @c emv_capdu_get_string()
+	EMV_TAG_RENDERER_AUTH_RESPONSE_CODE,            ///< See @c emv_auth_response_code_get_string()
+	EMV_TAG_RENDERER_POI_INFO,                      ///< See @c emv_poi_info_get_string_list()
+	EMV_TAG_RENDERER_CVM_LIST,                      ///< See @c emv_cvm_list_get_string_list()
+	EMV_TAG_RENDERER_ISSUER_CERT,                   ///< See @c emv_issuer_cert_get_string_list()
+	EMV_TAG_RENDERER_ISSUER_AUTH_DATA,              ///< See @c emv_issuer_auth_data_get_string_list()
+	EMV_TAG_RENDERER_SSAD,                          ///< See @c emv_ssad_get_string_list()
+	EMV_TAG_RENDERER_AFL,                           ///< See @c emv_afl_get_string_list()
+	EMV_TAG_RENDERER_TVR,                           ///< See @c emv_tvr_get_string_list()
+	EMV_TAG_RENDERER_KERNEL_ID_TERMINAL,            ///< See @c emv_kernel_id_terminal_get_string()
+	EMV_TAG_RENDERER_DATE,                          ///< See @c emv_date_get_string()
+	EMV_TAG_RENDERER_TSI,                           ///< See @c emv_tsi_get_string_list()
+	EMV_TAG_RENDERER_TRANSACTION_TYPE,              ///< See @c emv_transaction_type_get_string()
+	EMV_TAG_RENDERER_COUNTRY_NUMERIC_CODE,          ///< See @c emv_country_numeric_code_get_string()
+	EMV_TAG_RENDERER_CURRENCY_NUMERIC_CODE,         ///< See @c emv_currency_numeric_code_get_string()
+	EMV_TAG_RENDERER_LANGUAGE_PREFERENCE,           ///< See @c emv_language_preference_get_string_list()
+	EMV_TAG_RENDERER_ACCOUNT_TYPE,                  ///< See @c emv_account_type_get_string()
+	EMV_TAG_RENDERER_APP_USAGE_CONTROL,             ///< See @c emv_app_usage_control_get_string_list()
+	EMV_TAG_RENDERER_ASRPD,                         ///< See @c emv_asrpd_get_string_list()
+	EMV_TAG_RENDERER_IAD,                           ///< See @c emv_iad_get_string_list()
+	EMV_TAG_RENDERER_APP_PREFERRED_NAME,            ///< See @c emv_app_preferred_name_get_string()
+	EMV_TAG_RENDERER_MCC,                           ///< See @c emv_mcc_get_string()
+	EMV_TAG_RENDERER_TERMINAL_RISK_MANAGEMENT_DATA, ///< See @c emv_terminal_risk_management_data_get_string_list()
+	EMV_TAG_RENDERER_TIME,                          ///< See @c emv_time_get_string()
+	EMV_TAG_RENDERER_CID,                           ///< See @c emv_cid_get_string_list()
+	EMV_TAG_RENDERER_KERNEL_ID,                     ///< See @c emv_kernel_id_get_string()
+	EMV_TAG_RENDERER_TERM_CAPS,                     ///< See @c emv_term_caps_get_string_list()
+	EMV_TAG_RENDERER_CVM_RESULTS,                   ///< See @c emv_cvm_results_get_string_list()
+	EMV_TAG_RENDERER_TERM_TYPE,                     ///< See @c emv_term_type_get_string_list()
+	EMV_TAG_RENDERER_POS_ENTRY_MODE,                ///< See @c emv_pos_entry_mode_get_string()
+	EMV_TAG_RENDERER_APP_REFERENCE_CURRENCY,        ///< See @c emv_app_reference_currency_get_string_list()
+	EMV_TAG_RENDERER_TERMINAL_CATEGORIES,           ///< See @c emv_terminal_categories_get_string_list()
+	EMV_TAG_RENDERER_ADDL_TERM_CAPS,                ///< See @c emv_addl_term_caps_get_string_list()
+	EMV_TAG_RENDERER_ICC_CERT,                      ///< See @c emv_icc_cert_get_string_list()
+	EMV_TAG_RENDERER_SDAD,                          ///< See @c emv_sdad_get_string_list()
+	EMV_TAG_RENDERER_MASTERCARD_APP_CAPS_INFO,      ///< See @c emv_mastercard_app_caps_info_get_string_list()
+	EMV_TAG_RENDERER_TTQ,                           ///< See @c emv_ttq_get_string_list()
+	EMV_TAG_RENDERER_VISA_CARD_AUTH_DATA,           ///< See @c emv_visa_card_auth_data_get_string_list()
+	EMV_TAG_RENDERER_CTQ,                           ///< See @c emv_ctq_get_string_list()
+	EMV_TAG_RENDERER_AMEX_CL_READER_CAPS,           ///< See @c emv_amex_cl_reader_caps_get_string()
+	EMV_TAG_RENDERER_MASTERCARD_THIRD_PARTY_DATA,   ///< See @c emv_mastercard_third_party_data_get_string_list()
+	EMV_TAG_RENDERER_VISA_FORM_FACTOR_INDICATOR,    ///< See @c emv_visa_form_factor_indicator_get_string_list()
+	EMV_TAG_RENDERER_AMEX_ENH_CL_READER_CAPS,       ///< See @c emv_amex_enh_cl_reader_caps_get_string_list()
+};
+
+/**
+ * EMV tag information table entry
+ */
+struct emv_tag_info_entry_t {
+	unsigned int tag;                           ///< EMV tag
+	const char* tag_name;                       ///< Tag name
+	const char* tag_desc;                       ///< Tag description
+	enum emv_format_t format;                   ///< Value format
+	enum emv_tag_match_t match;                 ///< Criteria used to distinguish kernel specific definitions
+	uint8_t min_len;                            ///< Minimum field length for @ref EMV_TAG_MATCH_LENGTH
+	uint8_t max_len;                            ///< Maximum field length for @ref EMV_TAG_MATCH_LENGTH
+	enum emv_tag_renderer_t renderer;           ///< Value renderer
+	uint8_t max_format_len;                     ///< Maximum number of format digits for format renderers. Zero for no limit.
+};
+
+/**
+ * EMV tag information table
+ *
+ * @note This table must be sorted by tag value because it is searched using
+ *       binary search. Tags that are defined differently by different kernels
+ *       have multiple consecutive entries which are matched in order.
+ */
+static const struct emv_tag_info_entry_t emv_tag_info_table[] = {
+	{
+		.tag = EMV_TAG_42_IIN,
+		.tag_name = "Issuer Identification Number (IIN)",
+		.tag_desc =
+			"The number that identifies the major industry and the card "
+			"issuer and that forms the first part of the Primary Account "
+			"Number (PAN)",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 6,
+	},
+	{
+		.tag = EMV_TAG_4F_APPLICATION_DF_NAME,
+		.tag_name = "Application Dedicated File (ADF) Name",
+		.tag_desc =
+			"Identifies the application as described in ISO/IEC 7816-4",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AID,
+	},
+	{
+		.tag = EMV_TAG_50_APPLICATION_LABEL,
+		.tag_name = "Application Label",
+		.tag_desc =
+			"Mnemonic associated with the AID according to ISO/IEC 7816-4",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 16,
+	},
+	{
+		.tag = EMV_TAG_56_TRACK1_DATA,
+		.tag_name = "Track 1 Data",
+		.tag_desc =
+			"Contains the data objects of the track 1 according to "
+			"ISO/IEC 7813 Structure B, excluding start sentinel, end "
+			"sentinel and Longitudinal Redundancy Check (LRC)",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 76,
+	},
+	{
+		.tag = EMV_TAG_57_TRACK2_EQUIVALENT_DATA,
+		.tag_name = "Track 2 Equivalent Data",
+		.tag_desc =
+			"Contains the data elements of track 2 according to "
+			"ISO/IEC 7813, excluding start sentinel, end sentinel, and "
+			"Longitudinal Redundancy Check (LRC)",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TRACK2_EQUIVALENT_DATA,
+	},
+	{
+		.tag = EMV_TAG_5A_APPLICATION_PAN,
+		.tag_name = "Application Primary Account Number (PAN)",
+		.tag_desc =
+			"Valid cardholder account number",
+		.format = EMV_FORMAT_CN,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 19,
+	},
+	{
+		.tag = EMV_TAG_61_APPLICATION_TEMPLATE,
+		.tag_name = "Application Template",
+		.tag_desc =
+			"Contains one or more data objects relevant to an application "
+			"directory entry according to ISO/IEC 7816-4",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_6F_FCI_TEMPLATE,
+		.tag_name = "File Control Information (FCI) Template",
+		.tag_desc =
+			"Identifies the FCI template according to ISO/IEC 7816-4",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_70_DATA_TEMPLATE,
+		.tag_name = "EMV Data Template",
+		.tag_desc =
+			"Contains EMV data",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_71_ISSUER_SCRIPT_TEMPLATE_1,
+		.tag_name = "Issuer Script Template 1",
+		.tag_desc =
+			"Contains proprietary issuer data for "
+			"transmission to the ICC before the second "
+			"GENERATE AC command",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_72_ISSUER_SCRIPT_TEMPLATE_2,
+		.tag_name = "Issuer Script Template 2",
+		.tag_desc =
+			"Contains proprietary issuer data for "
+			"transmission to the ICC after the second "
+			"GENERATE AC command",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_73_DIRECTORY_DISCRETIONARY_TEMPLATE,
+		.tag_name = "Directory Discretionary Template",
+		.tag_desc =
+			"Issuer discretionary part of the directory according to "
+			"ISO/IEC 7816-4",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_77_RESPONSE_MESSAGE_TEMPLATE_FORMAT_2,
+		.tag_name = "Response Message Template Format 2",
+		.tag_desc =
+			"Contains the data objects (with tags and lengths) returned "
+			"by the ICC in response to a command",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_80_RESPONSE_MESSAGE_TEMPLATE_FORMAT_1,
+		.tag_name = "Response Message Template Format 1",
+		.tag_desc =
+			"Contains the data objects (without tags and lengths) "
+			"returned by the ICC in response to a command",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_81_AMOUNT_AUTHORISED_BINARY,
+		.tag_name = "Amount, Authorised (Binary)",
+		.tag_desc =
+			"Authorised amount of the transaction (excluding adjustments)",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AMOUNT,
+	},
+	{
+		.tag = EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE,
+		.tag_name = "Application Interchange Profile (AIP)",
+		.tag_desc =
+			"Indicates the capabilities of the card to support specific "
+			"functions in the application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AIP,
+	},
+	{
+		.tag = EMV_TAG_83_COMMAND_TEMPLATE,
+		.tag_name = "Command Template",
+		.tag_desc =
+			"Identifies the data field of a command message",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_84_DF_NAME,
+		.tag_name = "Dedicated File (DF) Name",
+		.tag_desc =
+			"Identifies the name of the Dedicated File (DF) as described "
+			"in ISO/IEC 7816-4",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_DF_NAME,
+	},
+	{
+		.tag = EMV_TAG_86_ISSUER_SCRIPT_COMMAND,
+		.tag_name = "Issuer Script Command",
+		.tag_desc =
+			"Contains a command for transmission to the ICC",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_CAPDU,
+	},
+	{
+		.tag = EMV_TAG_87_APPLICATION_PRIORITY_INDICATOR,
+		.tag_name = "Application Priority Indicator",
+		.tag_desc =
+			"Indicates the priority of a given application or group of "
+			"applications in a directory",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_88_SFI,
+		.tag_name = "Short File Identifier (SFI)",
+		.tag_desc =
+			"Identifies the Application Elementary File (AEF) referenced "
+			"in commands related to a given Application Definition File "
+			"or Directory Definition File (DDF). It is a binary data "
+			"object having a value in the range 1 - 30 and with the three "
+			"high order bits set to zero.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_89_AUTHORISATION_CODE,
+		.tag_name = "Authorisation Code",
+		.tag_desc =
+			"Value generated by the authorisation authority "
+			"(issuer) for an approved transaction",
+		.format = EMV_FORMAT_ANS,
+		// EMV 4.4 Book 3 Annex A indicates that the format is defined
+		// by the Payment System. M/Chip and VCPS both define this field
+		// as format 'ans' with length 6.
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 6,
+	},
+	{
+		.tag = EMV_TAG_8A_AUTHORISATION_RESPONSE_CODE,
+		.tag_name = "Authorisation Response Code",
+		.tag_desc =
+			"Code that defines the disposition of a message",
+		.format = EMV_FORMAT_AN,
+		.renderer = EMV_TAG_RENDERER_AUTH_RESPONSE_CODE,
+	},
+	{
+		.tag = EMV_TAG_8B_POI_INFORMATION,
+		.tag_name = "POI Information",
+		.tag_desc =
+			"Contains information about the terminal and the acceptance "
+			"environment.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_POI_INFO,
+	},
+	{
+		.tag = EMV_TAG_8C_CDOL1,
+		.tag_name = "Card Risk Management Data Object List 1 (CDOL1)",
+		.tag_desc =
+			"List of data objects (tag and length) to be passed to the "
+			"ICC in the first GENERATE AC command",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_8D_CDOL2,
+		.tag_name = "Card Risk Management Data Object List 2 (CDOL2)",
+		.tag_desc =
+			"List of data objects (tag and length) to be passed to the "
+			"ICC in the second GENERATE AC command",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_8E_CVM_LIST,
+		.tag_name = "Cardholder Verification Method (CVM) List",
+		.tag_desc =
+			"Identifies a method of verification of the cardholder "
+			"supported by the application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_CVM_LIST,
+	},
+	{
+		.tag = EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX,
+		.tag_name = "Certification Authority Public Key (CAPK) Index",
+		.tag_desc =
+			"Identifies the certification authority's public key in "
+			"conjunction with the RID",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE,
+		.tag_name = "Issuer Public Key Certificate",
+		.tag_desc =
+			"Issuer public key certified by a certification authority",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_ISSUER_CERT,
+	},
+	{
+		.tag = EMV_TAG_91_ISSUER_AUTHENTICATION_DATA,
+		.tag_name = "Issuer Authentication Data",
+		.tag_desc =
+			"Data sent to the ICC for online issuer authentication",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_ISSUER_AUTH_DATA,
+	},
+	{
+		.tag = EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER,
+		.tag_name = "Issuer Public Key Remainder",
+		.tag_desc =
+			"Remaining digits of the Issuer Public Key Modulus",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_93_SIGNED_STATIC_APPLICATION_DATA,
+		.tag_name = "Signed Static Application Data (SSAD)",
+		.tag_desc =
+			"Digital signature on critical application "
+			"parameters for SDA",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_SSAD,
+	},
+	{
+		.tag = EMV_TAG_94_APPLICATION_FILE_LOCATOR,
+		.tag_name = "Application File Locator (AFL)",
+		.tag_desc =
+			"Indicates the location (SFI, range of records) of the "
+			"Application Elementary Files (AEFs) related to a given "
+			"application",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_AFL,
+	},
+	{
+		.tag = EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS,
+		.tag_name = "Terminal Verification Results (TVR)",
+		.tag_desc =
+			"Status of the different functions as seen from the terminal",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TVR,
+	},
+	{
+		.tag = EMV_TAG_96_KERNEL_IDENTIFIER_TERMINAL,
+		.tag_name = "Kernel Identifier - terminal",
+		.tag_desc =
+			"Identifies the kernel used for the transaction",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_KERNEL_ID_TERMINAL,
+	},
+	{
+		.tag = EMV_TAG_97_TDOL,
+		.tag_name = "Transaction Certificate Data Object List (TDOL)",
+		.tag_desc =
+			"List of data objects (tag and length) to be used by the "
+			"terminal in generating the TC Hash Value",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_98_TC_HASH,
+		.tag_name = "Transaction Certificate (TC) Hash Value",
+		.tag_desc =
+			"Result of a hash function using input created from the list "
+			"of data objects specified in the TDOL",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9A_TRANSACTION_DATE,
+		.tag_name = "Transaction Date",
+		.tag_desc =
+			"Local date that the transaction was authorised",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_DATE,
+	},
+	{
+		.tag = EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION,
+		.tag_name = "Transaction Status Information (TSI)",
+		.tag_desc =
+			"Indicates the functions performed in a transaction",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TSI,
+	},
+	{
+		.tag = EMV_TAG_9C_TRANSACTION_TYPE,
+		.tag_name = "Transaction Type",
+		.tag_desc =
+			"Indicates the type of financial transaction, represented by "
+			"the first two digits of the ISO 8583:1987 Processing Code. "
+			"The actual values to be used for the Transaction Type data "
+			"element are defined by the relevant payment system.",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_TRANSACTION_TYPE,
+	},
+	{
+		.tag = EMV_TAG_9D_DDF_NAME,
+		.tag_name = "Directory Definition File (DDF) Name",
+		.tag_desc =
+			"Identifies the name of a Dedicated File (DF) associated with "
+			"a directory",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_A5_FCI_PROPRIETARY_TEMPLATE,
+		.tag_name = "File Control Information (FCI) Proprietary Template",
+		.tag_desc =
+			"Identifies the data object proprietary to this specification "
+			"in the File Control Information (FCI) template according to "
+			"ISO/IEC 7816-4",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_5F20_CARDHOLDER_NAME,
+		.tag_name = "Cardholder Name",
+		.tag_desc =
+			"Indicates cardholder name according to ISO 7813",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 26,
+	},
+	{
+		.tag = EMV_TAG_5F24_APPLICATION_EXPIRATION_DATE,
+		.tag_name = "Application Expiration Date",
+		.tag_desc =
+			"Date after which application expires",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_DATE,
+	},
+	{
+		.tag = EMV_TAG_5F25_APPLICATION_EFFECTIVE_DATE,
+		.tag_name = "Application Effective Date",
+		.tag_desc =
+			"Date from which the application may be used",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_DATE,
+	},
+	{
+		.tag = EMV_TAG_5F28_ISSUER_COUNTRY_CODE,
+		.tag_name = "Issuer Country Code",
+		.tag_desc =
+			"Indicates the country of the issuer according to ISO 3166",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_COUNTRY_NUMERIC_CODE,
+	},
+	{
+		.tag = EMV_TAG_5F2A_TRANSACTION_CURRENCY_CODE,
+		.tag_name = "Transaction Currency Code",
+		.tag_desc =
+			"Indicates the currency code of the transaction according to "
+			"ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_CURRENCY_NUMERIC_CODE,
+	},
+	{
+		.tag = EMV_TAG_5F2D_LANGUAGE_PREFERENCE,
+		.tag_name = "Language Preference",
+		.tag_desc =
+			"1-4 languages stored in order of preference, each "
+			"represented by 2 alphabetical characters according to "
+			"ISO 639",
+		.format = EMV_FORMAT_AN,
+		.renderer = EMV_TAG_RENDERER_LANGUAGE_PREFERENCE,
+	},
+	{
+		.tag = EMV_TAG_5F30_SERVICE_CODE,
+		.tag_name = "Service Code",
+		.tag_desc =
+			"Service code as defined in ISO/IEC 7813 for "
+			"track 1 and track 2",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 3,
+	},
+	{
+		.tag = EMV_TAG_5F34_APPLICATION_PAN_SEQUENCE_NUMBER,
+		.tag_name = "Application Primary Account Number (PAN) Sequence Number",
+		.tag_desc =
+			"Identifies and differentiates cards with the same PAN",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_5F36_TRANSACTION_CURRENCY_EXPONENT,
+		.tag_name = "Transaction Currency Exponent",
+		.tag_desc =
+			"Indicates the implied position of the decimal point from the "
+			"right of the transaction amount represented according to "
+			"ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_5F50_ISSUER_URL,
+		.tag_name = "Issuer URL",
+		.tag_desc =
+			"The URL provides the location of the issuer's Library Server "
+			"on the Internet",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 0,
+	},
+	{
+		.tag = EMV_TAG_5F53_IBAN,
+		.tag_name = "International Bank Account Number (IBAN)",
+		.tag_desc =
+			"Uniquely identifies the account of a customer at a financial "
+			"institution as defined in ISO 13616.",
+		.format = EMV_FORMAT_VAR,
+		// EMV 4.4 Book 3 Annex A states that this field has format 'var'
+		// and a length of up to 34 bytes while Wikipedia states that an
+		// IBAN consists of 34 alphanumeric characters. Therefore this
+		// implementation assumes that this field can be interpreted as
+		// format 'an'.
+		.renderer = EMV_TAG_RENDERER_FORMAT_AN,
+		.max_format_len = 34,
+	},
+	{
+		.tag = EMV_TAG_5F54_BANK_IDENTIFIER_CODE,
+		.tag_name = "Bank Identifier Code (BIC)",
+		.tag_desc =
+			"Uniquely identifies a bank as defined in ISO 9362.",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_FORMAT_AN,
+		.max_format_len = 11,
+	},
+	{
+		.tag = EMV_TAG_5F55_ISSUER_COUNTRY_CODE_ALPHA2,
+		.tag_name = "Issuer Country Code (alpha2 format)",
+		.tag_desc =
+			"Indicates the country of the issuer as defined in ISO 3166 "
+			"(using a 2 character alphabetic code)",
+		.format = EMV_FORMAT_A,
+		// Lookup country code; fallback to format "a" string
+		.renderer = EMV_TAG_RENDERER_COUNTRY_ALPHA2,
+		.max_format_len = 2,
+	},
+	{
+		.tag = EMV_TAG_5F56_ISSUER_COUNTRY_CODE_ALPHA3,
+		.tag_name = "Issuer Country Code (alpha3 format)",
+		.tag_desc =
+			"Indicates the country of the issuer as defined in ISO 3166 "
+			"(using a 3 character alphabetic code)",
+		.format = EMV_FORMAT_A,
+		// Lookup country code; fallback to format "a" string
+		.renderer = EMV_TAG_RENDERER_COUNTRY_ALPHA3,
+		.max_format_len = 3,
+	},
+	{
+		.tag = EMV_TAG_5F57_ACCOUNT_TYPE,
+		.tag_name = "Account Type",
+		.tag_desc =
+			"Indicates the type of account selected on the "
+			"terminal, coded as specified in Annex G",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_ACCOUNT_TYPE,
+	},
+	{
+		.tag = EMV_TAG_9F01_ACQUIRER_IDENTIFIER,
+		.tag_name = "Acquirer Identifier",
+		.tag_desc =
+			"Uniquely identifies the acquirer within each payment system",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 11,
+	},
+	{
+		.tag = EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC,
+		.tag_name = "Amount, Authorised (Numeric)",
+		.tag_desc =
+			"Authorised amount of the transaction (excluding adjustments)",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 12,
+	},
+	{
+		.tag = EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC,
+		.tag_name = "Amount, Other (Numeric)",
+		.tag_desc =
+			"Secondary amount associated with the transaction "
+			"representing a cashback amount",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 12,
+	},
+	{
+		.tag = EMV_TAG_9F04_AMOUNT_OTHER_BINARY,
+		.tag_name = "Amount, Other (Binary)",
+		.tag_desc =
+			"Secondary amount associated with the transaction "
+			"representing a cashback amount",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AMOUNT,
+	},
+	{
+		.tag = EMV_TAG_9F05_APPLICATION_DISCRETIONARY_DATA,
+		.tag_name = "Application Discretionary Data",
+		.tag_desc =
+			"Issuer or payment system specified data "
+			"relating to the application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F06_AID,
+		.tag_name = "Application Identifier (AID) - terminal",
+		.tag_desc =
+			"Identifies the application as described in ISO/IEC 7816-4",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AID,
+	},
+	{
+		.tag = EMV_TAG_9F07_APPLICATION_USAGE_CONTROL,
+		.tag_name = "Application Usage Control",
+		.tag_desc =
+			"Indicates issuer's specified restrictions on the geographic "
+			"usage and services allowed for the application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_APP_USAGE_CONTROL,
+	},
+	{
+		.tag = EMV_TAG_9F08_APPLICATION_VERSION_NUMBER,
+		.tag_name = "Application Version Number",
+		.tag_desc =
+			"Version number assigned by the payment system for the "
+			"application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F09_APPLICATION_VERSION_NUMBER_TERMINAL,
+		.tag_name = "Application Version Number - terminal",
+		.tag_desc =
+			"Version number assigned by the payment system for the "
+			"application",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F0A_ASRPD,
+		.tag_name = "Application Selection Registered Proprietary Data (ASRPD)",
+		.tag_desc =
+			"Proprietary data allowing for proprietary processing during "
+			"application selection. Proprietary data is identified using "
+			"Proprietary Data Identifiers that are managed by EMVCo and "
+			"their usage by the Application Selection processing is "
+			"according to their intended usage, as agreed by EMVCo during "
+			"registration.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_ASRPD,
+	},
+	{
+		.tag = EMV_TAG_9F0B_CARDHOLDER_NAME_EXTENDED,
+		.tag_name = "Cardholder Name Extended",
+		.tag_desc =
+			"Indicates the whole cardholder name when "
+			"greater than 26 characters using the same "
+			"coding convention as in ISO/IEC 7813",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 45,
+	},
+	{
+		.tag = EMV_TAG_9F0C_IINE,
+		.tag_name = "Issuer Identification Number Extended (IINE)",
+		.tag_desc =
+			"The number that identifies the major industry "
+			"and the card issuer and that forms the first "
+			"part of the Primary Account "
+			"Number (PAN).\n\n"
+			"While the first 6 digits of the IINE (tag '9F0C') "
+			"and IIN (tag '42') are the same and there is no "
+			"need to have both data objects on the card, "
+			"cards may have both the IIN and IINE data "
+			"objects present.",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 8,
+	},
+	{
+		.tag = EMV_TAG_9F0D_ISSUER_ACTION_CODE_DEFAULT,
+		.tag_name = "Issuer Action Code (IAC) - Default",
+		.tag_desc =
+			"Specifies the issuer's conditions that cause a transaction "
+			"to be rejected if it might have been approved online, but "
+			"the terminal is unable to process the transaction online",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TVR,
+	},
+	{
+		.tag = EMV_TAG_9F0E_ISSUER_ACTION_CODE_DENIAL,
+		.tag_name = "Issuer Action Code (IAC) - Denial",
+		.tag_desc =
+			"Specifies the issuer's conditions that cause the denial of a "
+			"transaction without attempt to go online",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TVR,
+	},
+	{
+		.tag = EMV_TAG_9F0F_ISSUER_ACTION_CODE_ONLINE,
+		.tag_name = "Issuer Action Code (IAC) - Online",
+		.tag_desc =
+			"Specifies the issuer's conditions that cause a transaction "
+			"to be transmitted online",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TVR,
+	},
+	{
+		.tag = EMV_TAG_9F10_ISSUER_APPLICATION_DATA,
+		.tag_name = "Issuer Application Data",
+		.tag_desc =
+			"Contains proprietary application data for transmission to "
+			"the issuer in an online transaction.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_IAD,
+	},
+	{
+		.tag = EMV_TAG_9F11_ISSUER_CODE_TABLE_INDEX,
+		.tag_name = "Issuer Code Table Index",
+		.tag_desc =
+			"Indicates the code table according to ISO/IEC 8859 for "
+			"displaying the Application Preferred Name",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F12_APPLICATION_PREFERRED_NAME,
+		.tag_name = "Application Preferred Name",
+		.tag_desc =
+			"Preferred mnemonic associated with the AID",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_APP_PREFERRED_NAME,
+	},
+	{
+		.tag = EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER,
+		.tag_name = "Last Online Application Transaction Counter (ATC) Register",
+		.tag_desc =
+			"Application Transaction Counter (ATC) "
+			"value of the last transaction that went "
+			"online",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F14_LOWER_CONSECUTIVE_OFFLINE_LIMIT,
+		.tag_name = "Lower Consecutive Offline Limit",
+		.tag_desc =
+			"Issuer-specified preference for the maximum "
+			"number of consecutive offline transactions for "
+			"this ICC application allowed in a terminal "
+			"with online capability",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F15_MCC,
+		.tag_name = "Merchant Category Code (MCC)",
+		.tag_desc =
+			"Classifies the type of business being done by "
+			"the merchant, represented according to ISO 8583:1993 for "
+			"Card Acceptor Business Code.",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_MCC,
+	},
+	{
+		.tag = EMV_TAG_9F16_MERCHANT_IDENTIFIER,
+		.tag_name = "Merchant Identifier",
+		.tag_desc =
+			"When concatenated with the Acquirer Identifier, uniquely "
+			"identifies a given merchant",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 15,
+	},
+	{
+		.tag = EMV_TAG_9F17_PIN_TRY_COUNTER,
+		.tag_name = "Personal Identification Number (PIN) Try Counter",
+		.tag_desc =
+			"Number of PIN tries remaining",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F18_ISSUER_SCRIPT_IDENTIFIER,
+		.tag_name = "Issuer Script Identifier",
+		.tag_desc =
+			"Identification of the Issuer Script",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F19_TOKEN_REQUESTOR_ID,
+		.tag_name = "Token Requestor ID",
+		.tag_desc =
+			"Uniquely identifies the pairing of the Token "
+			"Requestor with the Token Domain, as defined "
+			"in the EMV Payment Tokenisation "
+			"Framework",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F1A_TERMINAL_COUNTRY_CODE,
+		.tag_name = "Terminal Country Code",
+		.tag_desc =
+			"Indicates the country of the terminal, represented according "
+			"to ISO 3166",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_COUNTRY_NUMERIC_CODE,
+	},
+	{
+		.tag = EMV_TAG_9F1B_TERMINAL_FLOOR_LIMIT,
+		.tag_name = "Terminal Floor Limit",
+		.tag_desc =
+			"Indicates the floor limit in the terminal in conjunction "
+			"with the AID",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AMOUNT,
+	},
+	{
+		.tag = EMV_TAG_9F1C_TERMINAL_IDENTIFICATION,
+		.tag_name = "Terminal Identification",
+		.tag_desc =
+			"Designates the unique location of a terminal at a merchant",
+		.format = EMV_FORMAT_AN,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 8,
+	},
+	{
+		.tag = EMV_TAG_9F1D_TERMINAL_RISK_MANAGEMENT_DATA,
+		.tag_name = "Terminal Risk Management Data",
+		.tag_desc =
+			"Application-specific value used by the contactless card or "
+			"payment device for risk management purposes. All RFU bits "
+			"must be set to zero.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TERMINAL_RISK_MANAGEMENT_DATA,
+	},
+	{
+		.tag = EMV_TAG_9F1E_IFD_SERIAL_NUMBER,
+		.tag_name = "Interface Device (IFD) Serial Number",
+		.tag_desc =
+			"Unique and permanent serial number assigned to the IFD by "
+			"the manufacturer",
+		.format = EMV_FORMAT_AN,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 8,
+	},
+	{
+		.tag = EMV_TAG_9F1F_TRACK1_DISCRETIONARY_DATA,
+		.tag_name = "Track 1 Discretionary Data",
+		.tag_desc =
+			"Discretionary part of track 1 according to ISO/IEC 7813",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 0,
+	},
+	{
+		.tag = EMV_TAG_9F20_TRACK2_DISCRETIONARY_DATA,
+		.tag_name = "Track 2 Discretionary Data",
+		.tag_desc =
+			"Discretionary part of track 2 according to ISO/IEC 7813",
+		.format = EMV_FORMAT_CN,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 0,
+	},
+	{
+		.tag = EMV_TAG_9F21_TRANSACTION_TIME,
+		.tag_name = "Transaction Time",
+		.tag_desc =
+			"Local time that the transaction was authorised",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_TIME,
+	},
+	{
+		.tag = EMV_TAG_9F22_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX,
+		.tag_name = "Certification Authority Public Key (CAPK) Index - terminal",
+		.tag_desc =
+			"Identifies the certification authority's public key in "
+			"conjunction with the RID",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F23_UPPER_CONSECUTIVE_OFFLINE_LIMIT,
+		.tag_name = "Upper Consecutive Offline Limit",
+		.tag_desc =
+			"Issuer-specified preference for the maximum "
+			"number of consecutive offline transactions for "
+			"this ICC application allowed in a terminal "
+			"without online capability",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F24_PAYMENT_ACCOUNT_REFERENCE,
+		.tag_name = "Payment Account Reference (PAR)",
+		.tag_desc =
+			"A non-financial reference assigned to each "
+			"unique PAN and used to link a Payment "
+			"Account represented by that PAN to affiliated "
+			"Payment Tokens, as defined in the EMV "
+			"Tokenisation Framework. The PAR may be "
+			"assigned in advance of Payment Token "
+			"issuance.",
+		.format = EMV_FORMAT_AN,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 29,
+	},
+	{
+		.tag = EMV_TAG_9F25_LAST_4_DIGITS_OF_PAN,
+		.tag_name = "Last 4 Digits of PAN",
+		.tag_desc =
+			"The last four digits of the PAN, as defined in "
+			"the EMV Payment Tokenisation Framework",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 4,
+	},
+	{
+		.tag = EMV_TAG_9F26_APPLICATION_CRYPTOGRAM,
+		.tag_name = "Application Cryptogram",
+		.tag_desc =
+			"Cryptogram returned by the ICC in response of the "
+			"GENERATE AC command",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F27_CRYPTOGRAM_INFORMATION_DATA,
+		.tag_name = "Cryptogram Information Data",
+		.tag_desc =
+			"Indicates the type of cryptogram and the actions to be "
+			"performed by the terminal",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_CID,
+	},
+	{
+		.tag = EMV_TAG_9F29_EXTENDED_SELECTION,
+		.tag_name = "Extended Selection",
+		.tag_desc =
+			"The value to be appended to the ADF Name in the data field "
+			"of the SELECT command, if the Extended Selection Support "
+			"flag is present and set to 1.\n\n"
+			"Content is payment system proprietary.\n\n"
+			"Note: The maximum length of Extended Selection depends on "
+			"the length of ADF Name in the same directory entry such that "
+			"Length of Extended Selection + Length of ADF Name <= 16.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F2A_KERNEL_IDENTIFIER,
+		.tag_name = "Kernel Identifier",
+		.tag_desc =
+			"Indicates the card's preference for the kernel on which the "
+			"the contactless application can be processed",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_KERNEL_ID,
+	},
+	{
+		.tag = EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT,
+		.tag_name = "Issuer Public Key Exponent",
+		.tag_desc =
+			"Issuer public key exponent used for the verification of the "
+			"Signed Static Application Data and the ICC Public Key "
+			"Certificate",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F33_TERMINAL_CAPABILITIES,
+		.tag_name = "Terminal Capabilities",
+		.tag_desc =
+			"Indicates the card data input, CVM, and security "
+			"capabilities of the terminal",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TERM_CAPS,
+	},
+	{
+		.tag = EMV_TAG_9F34_CVM_RESULTS,
+		.tag_name = "Cardholder Verification Method (CVM) Results",
+		.tag_desc =
+			"Indicates the results of the last CVM performed",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_CVM_RESULTS,
+	},
+	{
+		.tag = EMV_TAG_9F35_TERMINAL_TYPE,
+		.tag_name = "Terminal Type",
+		.tag_desc =
+			"Indicates the environment of the terminal, its "
+			"communications capability, and its operational control",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_TERM_TYPE,
+	},
+	{
+		.tag = EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER,
+		.tag_name = "Application Transaction Counter (ATC)",
+		.tag_desc =
+			"Counter maintained by the application in the ICC "
+			"(incrementing the ATC is managed by the ICC)",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F37_UNPREDICTABLE_NUMBER,
+		.tag_name = "Unpredictable Number",
+		.tag_desc =
+			"Value to provide variability and uniqueness to the "
+			"generation of a cryptogram",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F38_PDOL,
+		.tag_name = "Processing Options Data Object List (PDOL)",
+		.tag_desc =
+			"Contains a list of terminal resident data objects (tags and "
+			"lengths) needed by the ICC in processing the GET PROCESSING "
+			"OPTIONS command",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F39_POS_ENTRY_MODE,
+		.tag_name = "Point-of-Service (POS) Entry Mode",
+		.tag_desc =
+			"Indicates the method by which the PAN was entered, according "
+			"to the first two digits of the ISO 8583:1987 POS Entry Mode",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_POS_ENTRY_MODE,
+	},
+	{
+		.tag = EMV_TAG_9F3A_AMOUNT_REFERENCE_CURRENCY,
+		.tag_name = "Amount, Reference Currency",
+		.tag_desc =
+			"Authorised amount expressed in the reference currency",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_AMOUNT,
+	},
+	{
+		.tag = EMV_TAG_9F3B_APPLICATION_REFERENCE_CURRENCY,
+		.tag_name = "Application Reference Currency",
+		.tag_desc =
+			"1-4 currency codes used between the terminal and the ICC "
+			"when the Transaction Currency Code is different from the "
+			"Application Currency Code; each code is 3 digits according "
+			"to ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_APP_REFERENCE_CURRENCY,
+	},
+	{
+		.tag = EMV_TAG_9F3C_TRANSACTION_REFERENCE_CURRENCY,
+		.tag_name = "Transaction Reference Currency",
+		.tag_desc =
+			"Code defining the common currency used by the terminal in "
+			"case the Transaction Currency Code is different from the "
+			"Application Currency Code",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_CURRENCY_NUMERIC_CODE,
+	},
+	{
+		.tag = EMV_TAG_9F3D_TRANSACTION_REFERENCE_CURRENCY_EXPONENT,
+		.tag_name = "Transaction Reference Currency Exponent",
+		.tag_desc =
+			"Indicates the implied position of the decimal point from the "
+			"right of the transaction amount, with the Transaction "
+			"Reference Currency Code represented according to ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F3E_TERMINAL_CATEGORIES_SUPPORTED_LIST,
+		.tag_name = "Terminal Categories Supported List",
+		.tag_desc =
+			"Contains a list of one or more terminal categories supported "
+			"by the card.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_TERMINAL_CATEGORIES,
+	},
+	{
+		.tag = EMV_TAG_9F3F_SDOL,
+		.tag_name = "Selection Data Object List (SDOL)",
+		.tag_desc =
+			"Contains a list of terminal resident data objects (tags and "
+			"lengths) needed by the card in processing the SEND POI "
+			"INFORMATION (SPI) command.\n\n"
+			"The SDOL can be used to request the following terminal data "
+			"objects:\n"
+			"- Amount, Authorised (Numeric) (tag '9F02')\n"
+			"- POI Information (tag '8B')\n"
+			"- Terminal Country Code (tag '9F1A')\n"
+			"- Transaction Currency Code (tag '5F2A')\n\n"
+			"Only the data objects explicitly listed above must be known "
+			"and correct data object values provided by the terminal for "
+			"the SDOL. The terminal may recognize and be able to provide "
+			"the values for other data objects if requested via the SDOL, "
+			"but that is not required.",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F40_ADDITIONAL_TERMINAL_CAPABILITIES,
+		.tag_name = "Additional Terminal Capabilities",
+		.tag_desc =
+			"Indicates the data input and output capabilities of the "
+			"terminal",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_ADDL_TERM_CAPS,
+	},
+	{
+		.tag = EMV_TAG_9F41_TRANSACTION_SEQUENCE_COUNTER,
+		.tag_name = "Transaction Sequence Counter",
+		.tag_desc =
+			"Counter maintained by the terminal that is incremented by "
+			"one for each transaction",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 8,
+	},
+	{
+		.tag = EMV_TAG_9F42_APPLICATION_CURRENCY_CODE,
+		.tag_name = "Application Currency Code",
+		.tag_desc =
+			"Indicates the currency in which the account is managed "
+			"according to ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_CURRENCY_NUMERIC_CODE,
+	},
+	{
+		.tag = EMV_TAG_9F43_APPLICATION_REFERENCE_CURRENCY_EXPONENT,
+		.tag_name = "Application Reference Currency Exponent",
+		.tag_desc =
+			"Indicates the implied position of the decimal point from the "
+			"right of the amount, for each of the 1-4 reference "
+			"currencies represented according to ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F44_APPLICATION_CURRENCY_EXPONENT,
+		.tag_name = "Application Currency Exponent",
+		.tag_desc =
+			"Indicates the implied position of the decimal point from the "
+			"right of the amount represented according to ISO 4217",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F45_DATA_AUTHENTICATION_CODE,
+		.tag_name = "Data Authentication Code",
+		.tag_desc =
+			"An issuer assigned value that is retained by the terminal "
+			"during the verification process of the Signed Static "
+			"Application Data",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F46_ICC_PUBLIC_KEY_CERTIFICATE,
+		.tag_name = "Integrated Circuit Card (ICC) Public Key Certificate",
+		.tag_desc =
+			"ICC Public Key certified by the issuer",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_ICC_CERT,
+	},
+	{
+		.tag = EMV_TAG_9F47_ICC_PUBLIC_KEY_EXPONENT,
+		.tag_name = "Integrated Circuit Card (ICC) Public Key Exponent",
+		.tag_desc =
+			"ICC Public Key Exponent used for the verification of the "
+			"Signed Dynamic Application Data",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F48_ICC_PUBLIC_KEY_REMAINDER,
+		.tag_name = "Integrated Circuit Card (ICC) Public Key Remainder",
+		.tag_desc =
+			"Remaining digits of the ICC Public Key Modulus",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F49_DDOL,
+		.tag_name = "Dynamic Data Authentication Data Object List (DDOL)",
+		.tag_desc =
+			"List of data objects (tag and length) to be passed to the "
+			"ICC in the INTERNAL AUTHENTICATE command",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F4A_SDA_TAG_LIST,
+		.tag_name = "Static Data Authentication (SDA) Tag List",
+		.tag_desc =
+			"List of tags of primitive data objects defined in this "
+			"specification whose value fields are to be included in the "
+			"Signed Static or Dynamic Application Data",
+		.format = EMV_FORMAT_TAG_LIST,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA,
+		.tag_name = "Signed Dynamic Application Data (SDAD)",
+		.tag_desc =
+			"Digital signature on critical application "
+			"parameters for DDA or CDA",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_SDAD,
+	},
+	{
+		.tag = EMV_TAG_9F4C_ICC_DYNAMIC_NUMBER,
+		.tag_name = "Integrated Circuit Card (ICC) Dynamic Number",
+		.tag_desc =
+			"Time-variant number generated by the ICC, to be captured by "
+			"the terminal",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F4D_LOG_ENTRY,
+		.tag_name = "Log Entry",
+		.tag_desc =
+			"Provides the SFI of the Transaction Log file and its number "
+			"of records",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_9F4E_MERCHANT_NAME_AND_LOCATION,
+		.tag_name = "Merchant Name and Location",
+		.tag_desc =
+			"Indicates the name and location of the merchant",
+		.format = EMV_FORMAT_ANS,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 0,
+	},
+	{
+		.tag = EMV_TAG_9F4F_LOG_FORMAT,
+		.tag_name = "Log Format",
+		.tag_desc =
+			"List (in tag and length format) of data objects representing "
+			"the logged data elements that are passed to the terminal when "
+			"a transaction log record is read",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 2 defines 9F5D as Application Capabilities
+		// Information with a length of 3 bytes
+		.tag = MASTERCARD_TAG_9F5D_APPLICATION_CAPABILITIES_INFORMATION,
+		.tag_name = "Application Capabilities Information",
+		.tag_desc =
+			"Lists a number of card features beyond regular payment.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 3,
+		.max_len = 3,
+		.renderer = EMV_TAG_RENDERER_MASTERCARD_APP_CAPS_INFO,
+	},
+	{
+		// Kernel 3 defines 9F5D as Available Offline Spending Amount
+		// (AOSA) with a length of 6 bytes
+		.tag = VISA_TAG_9F5D_AOSA,
+		.tag_name = "Available Offline Spending Amount (AOSA)",
+		.tag_desc =
+			"Kernel 3 proprietary data element indicating the "
+			"remaining amount available to be spent offline. The AOSA "
+			"is a calculated field used to allow the reader to "
+			"provide on a receipt or display the amount of offline "
+			"spend that is available on the card.",
+		.format = EMV_FORMAT_N,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 6,
+		.max_len = 6,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 12,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F60_CVC3_TRACK1,
+		.tag_name = "CVC3 (Track1)",
+		.tag_desc =
+			"The CVC3 (Track1) is a 2-byte cryptogram returned by the "
+			"Card in the response to the COMPUTE CRYPTOGRAPHIC CHECKSUM "
+			"command.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F61_CVC3_TRACK2,
+		.tag_name = "CVC3 (Track2)",
+		.tag_desc =
+			"The CVC3 (Track2) is a 2-byte cryptogram returned by the "
+			"Card in the response to the COMPUTE CRYPTOGRAPHIC CHECKSUM "
+			"command.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F62_PCVC3_TRACK1,
+		.tag_name = "PCVC3(Track1)",
+		.tag_desc =
+			"Indicates to the Kernel the positions in the discretionary "
+			"data field of the Track 1 Data where the CVC3 (Track1) "
+			"digits must be copied.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 2 defines 9F63 as PUNATC(Track1) with a length of
+		// 6 bytes
+		.tag = MASTERCARD_TAG_9F63_PUNATC_TRACK1,
+		.tag_name = "PUNATC(Track1)",
+		.tag_desc =
+			"Indicates to the Kernel the positions in the "
+			"discretionary data field of Track 1 Data where the "
+			"Unpredictable Number (Numeric) digits and Application "
+			"Transaction Counter (ATC) digits have to be copied.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 6,
+		.max_len = 6,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 3 (VCPS) defines 9F63 as Offline Counter Initial
+		// Value with a length of 1 byte
+		.tag = VISA_TAG_9F63_OFFLINE_COUNTER_INITIAL_VALUE,
+		.tag_name = "Offline Counter Initial Value",
+		.tag_desc =
+			"Contains the initial value of the Consecutive "
+			"Transaction Counter International (CTCI).",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 1,
+		.max_len = 1,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 7 defines 9F63 as Product Identification Information
+		// without specifying the length or description, but unverified
+		// internet sources indicate the length to be 16 bytes
+		.tag = UNIONPAY_TAG_9F63_PRODUCT_IDENTIFICATION_INFORMATION,
+		.tag_name = "Product Identification Information",
+		.tag_desc = "Product Identification Information",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 16,
+		.max_len = 16,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F64_NATC_TRACK1,
+		.tag_name = "NATC(Track1)",
+		.tag_desc =
+			"The value of NATC(Track1) represents the number of digits of "
+			"the Application Transaction Counter to be included in the "
+			"discretionary data field of Track 1 Data.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F65_PCVC3_TRACK2,
+		.tag_name = "PCVC3(Track2)",
+		.tag_desc =
+			"Indicates to the Kernel the positions in the discretionary "
+			"data field of the Track 2 Data where the CVC3 (Track2) "
+			"digits must be copied.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Entry Point kernel as well as kernel 3, 6 and 7 define 9F66
+		// as TTQ with a length of 4 bytes
+		.tag = EMV_TAG_9F66_TTQ,
+		.tag_name = "Terminal Transaction Qualifiers (TTQ)",
+		.tag_desc =
+			"Indicates the requirements for online and CVM processing "
+			"as a result of Entry Point processing. The scope of this "
+			"tag is limited to Entry Point. Kernels may use this tag "
+			"for different purposes.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 4,
+		.max_len = 4,
+		.renderer = EMV_TAG_RENDERER_TTQ,
+	},
+	{
+		// Kernel 2 defines 9F66 as PUNATC(Track2) with a length of
+		// 2 bytes
+		.tag = MASTERCARD_TAG_9F66_PUNATC_TRACK2,
+		.tag_name = "PUNATC(Track2)",
+		.tag_desc =
+			"Indicates to the Kernel the positions in the "
+			"discretionary data field of Track 2 Data where the "
+			"Unpredictable Number (Numeric) digits and Application "
+			"Transaction Counter (ATC) digits have to be copied.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 2,
+		.max_len = 2,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 2 defines 9F67 as NATC(Track2) with a length of
+		// 1 byte
+		.tag = MASTERCARD_TAG_9F67_NATC_TRACK2,
+		.tag_name = "NATC(Track2)",
+		.tag_desc =
+			"The value of NATC(Track2) represents the number of "
+			"digits of the Application Transaction Counter to be "
+			"included in the discretionary data field of Track 2 "
+			"Data.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 1,
+		.max_len = 1,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 4 defines 9F67 as Form Factor with a length of
+		// 3 bytes
+		.tag = AMEX_TAG_9F67_FORM_FACTOR,
+		.tag_name = "Form Factor",
+		.tag_desc =
+			"Identifies the form factor of the Card.",
+		.format = EMV_FORMAT_N,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 3,
+		.max_len = 3,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 6,
+	},
+	{
+		// Kernel 3 defines 9F69 as Card Authentication Related Data
+		// with a length of 5-16 bytes and first byte 0x01
+		.tag = VISA_TAG_9F69_CARD_AUTHENTICATION_RELATED_DATA,
+		.tag_name = "Card Authentication Related Data",
+		.tag_desc =
+			"Contains the fDDA Version Number, Card Unpredictable "
+			"Number, and Card Transaction Qualifiers.\n\n"
+			"For transactions where fDDA is performed, the Card "
+			"Authentication Related Data is returned in the last "
+			"record specified by the Application File Locator for "
+			"that transaction.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_VISA_CARD_AUTH_DATA,
+		.renderer = EMV_TAG_RENDERER_VISA_CARD_AUTH_DATA,
+	},
+	{
+		// Kernel 2 defines 9F69 as UDOL
+		.tag = MASTERCARD_TAG_9F69_UDOL,
+		.tag_name = "UDOL",
+		.tag_desc =
+			"The UDOL is the DOL that specifies the data objects to "
+			"be included in the data field of the COMPUTE "
+			"CRYPTOGRAPHIC CHECKSUM command. The UDOL must at least "
+			"include the Unpredictable Number (Numeric). The UDOL is "
+			"not mandatory for the Card. If it is not present in the "
+			"Card, then the Default UDOL is used.",
+		.format = EMV_FORMAT_DOL,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = MASTERCARD_TAG_9F6A_UNPREDICTABLE_NUMBER_NUMERIC,
+		.tag_name = "Unpredictable Number (Numeric)",
+		.tag_desc =
+			"Unpredictable number generated by the Kernel during a "
+			"Mag-stripe Mode transaction. The Unpredictable Number "
+			"(Numeric) is passed to the Card in the data field of the "
+			"COMPUTE CRYPTOGRAPHIC CHECKSUM command.\n\n"
+			"The 8-nUN most significant digits must be set to zero.",
+		.format = EMV_FORMAT_N,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 3 (VCPS) defines 9F6B as Card CVM Limit with a length
+		// of 6 bytes
+		.tag = VISA_TAG_9F6B_CARD_CVM_LIMIT,
+		.tag_name = "Card CVM Limit",
+		.tag_desc =
+			"Visa proprietary data element indicating that for "
+			"domestic contactless transactions where this value is "
+			"exceeded, a CVM is required by the card.",
+		.format = EMV_FORMAT_N,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 6,
+		.max_len = 6,
+		.renderer = EMV_TAG_RENDERER_FORMAT,
+		.max_format_len = 12,
+	},
+	{
+		// Kernel 2 defines 9F6B as Track 2 Data with a length of up to
+		// 19 bytes. Assume that it is more than 6 bytes because it
+		// would be unreasonable for track2 to be shorter than that.
+		.tag = MASTERCARD_TAG_9F6B_TRACK2_DATA,
+		.tag_name = "Track 2 Data",
+		.tag_desc =
+			"Contains the data objects of the track 2 according to "
+			"ISO/IEC 7813, excluding start sentinel, end sentinel and "
+			"Longitudinal Redundancy Check (LRC)",
+		.format = EMV_FORMAT_VAR,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 7,
+		.max_len = 19,
+		.renderer = EMV_TAG_RENDERER_TRACK2_EQUIVALENT_DATA,
+	},
+	{
+		.tag = EMV_TAG_9F6C_CTQ,
+		.tag_name = "Card Transaction Qualifiers (CTQ)",
+		.tag_desc =
+			"Used to indicate to the device the card CVM requirements, "
+			"issuer preferences, and card capabilities.",
+		.format = EMV_FORMAT_B,
+		.renderer = EMV_TAG_RENDERER_CTQ,
+	},
+	{
+		// Kernel 2 defines 9F6D as Mag-stripe Application Version
+		// Number (Reader) with a length of 2 bytes
+		.tag = MASTERCARD_TAG_9F6D_MAG_APPLICATION_VERSION_NUMBER,
+		.tag_name = "Mag-stripe Application Version Number (Reader)",
+		.tag_desc =
+			"Version number assigned by the payment system for the "
+			"specific Mag-stripe Mode functionality of the Kernel.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 2,
+		.max_len = 2,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 4 defines 9F6D as Contactless Reader Capabilities
+		// with a length of 1 byte
+		.tag = AMEX_TAG_9F6D_CONTACTLESS_READER_CAPABILITIES,
+		.tag_name = "Contactless Reader Capabilities",
+		.tag_desc =
+			"A proprietary data element with bits 8, 7, and 4 only "
+			"used to indicate a terminal's capability to support "
+			"Kernel 4 mag-stripe or EMV contactless. This data "
+			"element is OR'd with Terminal Type, Tag '9F35', "
+			"resulting in a modified Tag '9F35', which is passed to "
+			"the card when requested.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 1,
+		.max_len = 1,
+		.renderer = EMV_TAG_RENDERER_AMEX_CL_READER_CAPS,
+	},
+	{
+		// Kernel 2 defines 9F6E as Third Party Data with a length of
+		// 5 to 32 bytes
+		.tag = MASTERCARD_TAG_9F6E_THIRD_PARTY_DATA,
+		.tag_name = "Third Party Data",
+		.tag_desc =
+			"The Third Party data object may be used to carry "
+			"specific product information to be optionally used by "
+			"the terminal in processing transactions.",
+		.format = EMV_FORMAT_VAR,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 5,
+		.max_len = 32,
+		.renderer = EMV_TAG_RENDERER_MASTERCARD_THIRD_PARTY_DATA,
+	},
+	{
+		// Kernel 3 defines 9F6E as Form Factor Indicator (FFI) with a
+		// length of 4 bytes and currently only FFI version number 1 is
+		// defined by VCPS.
+		.tag = VISA_TAG_9F6E_FORM_FACTOR_INDICATOR,
+		.tag_name = "Form Factor Indicator (FFI)",
+		.tag_desc =
+			"Indicates the form factor of the consumer payment device "
+			"and thetype of contactless interface over which the "
+			"transaction was conducted. This information is made "
+			"available to the issuer host.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_VISA_FFI,
+		.renderer = EMV_TAG_RENDERER_VISA_FORM_FACTOR_INDICATOR,
+	},
+	{
+		// Kernel 4 defines 9F6E as Enhanced Contactless Reader
+		// Capabilities with a length of 4 bytes and various mandatory
+		// bits
+		.tag = AMEX_TAG_9F6E_ENHANCED_CONTACTLESS_READER_CAPABILITIES,
+		.tag_name = "Enhanced Contactless Reader Capabilities",
+		.tag_desc =
+			"Proprietary Data Element for managing Contactless "
+			"transactions and includes Contactless terminal "
+			"capabilities (static) and contactless Mobile transaction "
+			"(dynamic data) around CVM",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_AMEX_ENH_CL_READER_CAPS,
+		.renderer = EMV_TAG_RENDERER_AMEX_ENH_CL_READER_CAPS,
+	},
+	{
+		// Kernel 2 defines 9F7C as Merchant Custom Data with a length
+		// of 20 bytes
+		.tag = MASTERCARD_TAG_9F7C_MERCHANT_CUSTOM_DATA,
+		.tag_name = "Merchant Custom Data",
+		.tag_desc =
+			"Proprietary merchant data that may be requested by the "
+			"card.",
+		.format = EMV_FORMAT_B,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 20,
+		.max_len = 20,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		// Kernel 3 defines 9F7C as Customer Exclusive Data (CED) with
+		// a length of up to 32 bytes. Note that this implementation
+		// cannot distinguish it from kernel 2's definition when the
+		// provided field has a length of 20 bytes.
+		.tag = VISA_TAG_9F7C_CUSTOMER_EXCLUSIVE_DATA,
+		.tag_name = "Customer Exclusive Data (CED)",
+		.tag_desc =
+			"Contains data for transmission to the issuer.",
+		.format = EMV_FORMAT_VAR,
+		.match = EMV_TAG_MATCH_LENGTH,
+		.min_len = 0,
+		.max_len = 32,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_BF0C_FCI_ISSUER_DISCRETIONARY_DATA,
+		.tag_name = "File Control Information (FCI) Issuer Discretionary Data",
+		.tag_desc =
+			"Issuer discretionary part of the File Control Information (FCI)",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_BF4C_BIOMETRIC_TRY_COUNTERS_TEMPLATE,
+		.tag_name = "Biometric Try Counters Template",
+		.tag_desc =
+			"A template that contains one or more Biometric Try Counters",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+	{
+		.tag = EMV_TAG_BF4D_PREFERRED_ATTEMPTS_TEMPLATE,
+		.tag_name = "Preferred Attempts Template",
+		.tag_desc =
+			"A template that contains the TLV-coded values for the "
+			"preferred attempts of any BIT of a Biometric Type",
+		.format = EMV_FORMAT_VAR,
+		.renderer = EMV_TAG_RENDERER_NONE,
+	},
+};
+
+__END_DECLS
+
+#endif
@@ -38,7 +38,7 @@
 
 // Helper functions
 static int emv_tal_parse_aef_record(
-	struct emv_tlv_list_t* pse_tlv_list,
+	const struct emv_tlv_list_t* pse_tlv_list,
 	const void* aef_record,
 	size_t aef_record_len,
 	const struct emv_config_t* config,
@@ -51,21 +51,19 @@ static int emv_tal_read_sfi_records(
 	struct emv_oda_ctx_t* oda
 );
 
-int emv_tal_read_pse(
+int emv_tal_select_pse(
 	struct emv_ttl_t* ttl,
-	const struct emv_config_t* config,
-	struct emv_app_list_t* app_list
+	void* fci,
+	size_t* fci_len,
+	struct emv_tlv_list_t* pse_tlv_list,
+	uint8_t* sfi
 )
 {
 	int r;
-	uint8_t fci[EMV_RAPDU_DATA_MAX];
-	size_t fci_len = sizeof(fci);
 	uint16_t sw1sw2;
-	struct emv_tlv_list_t pse_tlv_list = EMV_TLV_LIST_INIT;
-
 	const struct emv_tlv_t* pse_sfi;
 
-	if (!ttl || !config || !app_list) {
+	if (!ttl || !fci || !fci_len || !pse_tlv_list || !sfi) {
 		// Invalid parameters; terminate session
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
@@ -74,7 +72,7 @@ int emv_tal_read_pse(
 	// See EMV 4.4 Book 1, 12.2.2
 	// See EMV 4.4 Book 1, 12.3.2
 	emv_debug_info("SELECT %s", EMV_PSE);
-	r = emv_ttl_select_by_df_name(ttl, EMV_PSE, strlen(EMV_PSE), fci, &fci_len, &sw1sw2);
+	r = emv_ttl_select_by_df_name(ttl, EMV_PSE, strlen(EMV_PSE), fci, fci_len, &sw1sw2);
 	if (r) {
 		emv_debug_trace_msg("emv_ttl_select_by_df_name() failed; r=%d", r);
 
@@ -112,25 +110,26 @@ int emv_tal_read_pse(
 		return EMV_TAL_RESULT_PSE_SELECT_FAILED;
 	}
 
-	emv_debug_info_ber("FCI", fci, fci_len);
+	emv_debug_info_ber("FCI", fci, *fci_len);
 
 	// Parse File Control Information (FCI) provided by PSE DDF
 	// NOTE: FCI may contain padding (r > 0)
+	// NOTE: FCI buffer outlives the PSE TLV list and values can be borrowed
 	// See EMV 4.4 Book 1, 11.3.4, table 8
-	r = emv_tlv_parse(fci, fci_len, &pse_tlv_list);
+	r = emv_tlv_parse_borrowed(fci, *fci_len, pse_tlv_list);
 	if (r < 0) {
-		emv_debug_trace_msg("emv_tlv_parse() failed; r=%d", r);
+		emv_debug_trace_msg("emv_tlv_parse_borrowed() failed; r=%d", r);
 
 		// Internal error while parsing FCI data; terminal may continue session
 		// See EMV 4.4 Book 1, 12.3.2, step 1
 		emv_debug_error("Failed to parse FCI");
 		r = EMV_TAL_RESULT_PSE_FCI_PARSE_FAILED;
-		goto exit;
+		goto error;
 	}
 
 	// Find Short File Identifier (SFI) for PSE directory Application Elementary File (AEF)
 	// See EMV 4.4 Book 1, 11.3.4, table 8
-	pse_sfi = emv_tlv_list_find_const(&pse_tlv_list, EMV_TAG_88_SFI);
+	pse_sfi = emv_tlv_list_find_const(pse_tlv_list, EMV_TAG_88_SFI);
 	if (!pse_sfi) {
 		emv_debug_trace_msg("emv_tlv_list_find_const() failed; pse_sfi=%p", pse_sfi);
 
@@ -138,7 +137,7 @@ int emv_tal_read_pse(
 		// See EMV 4.4 Book 1, 12.3.2, step 1
 		emv_debug_error("Failed to find SFI for PSE records");
 		r = EMV_TAL_RESULT_PSE_SFI_NOT_FOUND;
-		goto exit;
+		goto error;
 	}
 	if (pse_sfi->length != 1 || !pse_sfi->value) {
 		emv_debug_trace_data("pse_sfi=", pse_sfi->value, pse_sfi->length);
@@ -147,62 +146,126 @@ int emv_tal_read_pse(
 		// See EMV 4.4 Book 1, 12.3.2, step 1
 		emv_debug_error("Invalid SFI length or value for PSE records");
 		r = EMV_TAL_RESULT_PSE_SFI_INVALID;
-		goto exit;
+		goto error;
 	}
+	*sfi = pse_sfi->value[0];
 
-	// Read all records from PSE AEF using the SFI
+	// Successful PSE selection
+	return 0;
+
+error:
+	emv_tlv_list_clear(pse_tlv_list);
+	return r;
+}
+
+int emv_tal_read_pse_record(
+	struct emv_ttl_t* ttl,
+	const struct emv_tlv_list_t* pse_tlv_list,
+	uint8_t sfi,
+	uint8_t record_number,
+	const struct emv_config_t* config,
+	struct emv_app_list_t* app_list
+)
+{
+	int r;
+	uint8_t aef_record[EMV_RAPDU_DATA_MAX];
+	size_t aef_record_len = sizeof(aef_record);
+	uint16_t sw1sw2;
+
+	if (!ttl || !pse_tlv_list || !config || !app_list) {
+		// Invalid parameters; terminate session
+		return EMV_TAL_ERROR_INVALID_PARAMETER;
+	}
+
+	// Read PSE AEF record
 	// See EMV 4.4 Book 1, 12.2.3
-	for (uint8_t record_number = 1; ; ++record_number) {
-		uint8_t aef_record[EMV_RAPDU_DATA_MAX];
-		size_t aef_record_len = sizeof(aef_record);
+	r = emv_ttl_read_record(ttl, sfi, record_number, aef_record, &aef_record_len, &sw1sw2);
+	if (r) {
+		emv_debug_trace_msg("emv_ttl_read_record() failed; r=%d", r);
 
-		// Read PSE AEF record
-		// See EMV 4.4 Book 1, 12.2.3
-		r = emv_ttl_read_record(ttl, pse_sfi->value[0], record_number, aef_record, &aef_record_len, &sw1sw2);
-		if (r) {
-			emv_debug_trace_msg("emv_ttl_read_record() failed; r=%d", r);
+		// TTL failure; terminate session
+		// (bad card or reader; infinite loop if we continue)
+		emv_debug_error("TTL failure");
+		return EMV_TAL_ERROR_TTL_FAILURE;
+	}
 
-			// TTL failure; terminate session
-			// (bad card or reader; infinite loop if we continue)
-			emv_debug_error("TTL failure");
-			r = EMV_TAL_ERROR_TTL_FAILURE;
-			goto exit;
-		}
+	if (sw1sw2 == 0x6A83) {
+		// No more records
+		// See EMV 4.4 Book 1, 12.3.2, step 2
+		emv_debug_info("No more PSE records");
+		return EMV_TAL_RESULT_PSE_RECORD_NOT_FOUND;
+	}
 
-		if (sw1sw2 == 0x6A83) {
-			// No more records
-			// See EMV 4.4 Book 1, 12.3.2, step 2
-			emv_debug_info("No more PSE records");
-			break;
-		}
+	if (sw1sw2 != 0x9000) {
+		// Unexpected error; ignore record and continue
+		// See EMV 4.4 Book 1, 12.3.2, step 2
+		emv_debug_error("Unexpected PSE record error");
+		return 0;
+	}
 
-		if (sw1sw2 != 0x9000) {
-			// Unexpected error; ignore record and continue
-			// See EMV 4.4 Book 1, 12.3.2, step 2
-			emv_debug_error("Unexpected PSE record error");
-			continue;
+	emv_debug_info_ber("AEF", aef_record, aef_record_len);
+
+	r = emv_tal_parse_aef_record(
+		pse_tlv_list,
+		aef_record,
+		aef_record_len,
+		config,
+		app_list
+	);
+	if (r) {
+		emv_debug_trace_msg("emv_tal_parse_aef_record() failed; r=%d", r);
+		if (r < 0) {
+			// Unknown error; terminate session
+			emv_debug_error("Unknown PSE AEF record error");
+			return r;
+		}
+		if (r > 0) {
+			// Invalid PSE AEF record; ignore and continue
+			emv_debug_error("Invalid PSE AEF record");
 		}
+	}
 
-		emv_debug_info_ber("AEF", aef_record, aef_record_len);
+	return 0;
+}
 
-		r = emv_tal_parse_aef_record(
+int emv_tal_read_pse(
+	struct emv_ttl_t* ttl,
+	const struct emv_config_t* config,
+	struct emv_app_list_t* app_list
+)
+{
+	int r;
+	uint8_t fci[EMV_RAPDU_DATA_MAX];
+	size_t fci_len = sizeof(fci);
+	struct emv_tlv_list_t pse_tlv_list = EMV_TLV_LIST_INIT;
+	uint8_t pse_sfi;
+
+	if (!ttl || !config || !app_list) {
+		// Invalid parameters; terminate session
+		return EMV_TAL_ERROR_INVALID_PARAMETER;
+	}
+
+	r = emv_tal_select_pse(ttl, fci, &fci_len, &pse_tlv_list, &pse_sfi);
+	if (r) {
+		return r;
+	}
+
+	// Read all records from PSE AEF using the SFI
+	// See EMV 4.4 Book 1, 12.2.3
+	for (uint8_t record_number = 1; ; ++record_number) {
+		r = emv_tal_read_pse_record(
+			ttl,
 			&pse_tlv_list,
-			aef_record,
-			aef_record_len,
+			pse_sfi,
+			record_number,
 			config,
 			app_list
 		);
-		if (r) {
-			emv_debug_trace_msg("emv_tal_parse_aef_record() failed; r=%d", r);
-			if (r < 0) {
-				// Unknown error; terminate session
-				emv_debug_error("Unknown PSE AEF record error");
-				goto exit;
-			}
-			if (r > 0) {
-				// Invalid PSE AEF record; ignore and continue
-				emv_debug_error("Invalid PSE AEF record");
-			}
+		if (r < 0) {
+			goto exit;
+		}
+		if (r == EMV_TAL_RESULT_PSE_RECORD_NOT_FOUND) {
+			break;
 		}
 	}
 
@@ -219,7 +282,7 @@ exit:
 }
 
 static int emv_tal_parse_aef_record(
-	struct emv_tlv_list_t* pse_tlv_list,
+	const struct emv_tlv_list_t* pse_tlv_list,
 	const void* aef_record,
 	size_t aef_record_len,
 	const struct emv_config_t* config,
@@ -297,167 +360,187 @@ static int emv_tal_parse_aef_record(
 	return 0;
 }
 
-int emv_tal_find_supported_apps(
+int emv_tal_select_supported_app(
 	struct emv_ttl_t* ttl,
-	const struct emv_config_t* config,
+	const struct emv_config_app_t* config_app,
+	bool next,
 	struct emv_app_list_t* app_list
 )
 {
 	int r;
-	struct emv_config_app_itr_t itr;
-	const struct emv_config_app_t* config_app;
-	bool exact_match;
+	uint8_t fci[EMV_RAPDU_DATA_MAX];
+	size_t fci_len = sizeof(fci);
+	uint16_t sw1sw2;
+	struct emv_app_t* app;
 
-	if (!ttl || !config || !app_list) {
+	if (!ttl || !config_app || !app_list) {
 		// Invalid parameters; terminate session
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
 
-	r = emv_config_app_itr_init(config, &itr);
-	if (r) {
-		emv_debug_error("Internal error");
-		return EMV_TAL_ERROR_INTERNAL;
-	}
-
-	// See EMV 4.4 Book 1, 12.3.3
-	exact_match = true;
-	do {
-		uint8_t fci[EMV_RAPDU_DATA_MAX];
-		size_t fci_len = sizeof(fci);
-		uint16_t sw1sw2;
-		struct emv_app_t* app;
+	if (!next) {
+		// SELECT application
+		// See EMV 4.4 Book 1, 12.3.3, step 1
+		emv_debug_info_data("SELECT application", config_app->aid, config_app->aid_len);
+		r = emv_ttl_select_by_df_name(ttl, config_app->aid, config_app->aid_len, fci, &fci_len, &sw1sw2);
+		if (r) {
+			emv_debug_trace_msg("emv_ttl_select_by_df_name() failed; r=%d", r);
 
-		if (exact_match) {
-			// Retrieve next supported application
-			config_app = emv_config_app_itr_next(&itr);
-			if (!config_app) {
-				// End of supported application list
-				break;
-			}
+			// TTL failure; terminate session
+			// (bad card or reader)
+			emv_debug_error("TTL failure");
+			return EMV_TAL_ERROR_TTL_FAILURE;
+		}
 
-			// SELECT application
-			// See EMV 4.4 Book 1, 12.3.3, step 1
-			emv_debug_info_data("SELECT application", config_app->aid, config_app->aid_len);
-			r = emv_ttl_select_by_df_name(ttl, config_app->aid, config_app->aid_len, fci, &fci_len, &sw1sw2);
-			if (r) {
-				emv_debug_trace_msg("emv_ttl_select_by_df_name() failed; r=%d", r);
+		if (sw1sw2 == 0x6A81) {
+			// Card blocked or SELECT not supported; terminate session
+			// See EMV 4.4 Book 1, 12.3.3, step 2
+			emv_debug_error("Card blocked or SELECT not supported");
+			return EMV_TAL_ERROR_CARD_BLOCKED;
+		}
 
-				// TTL failure; terminate session
-				// (bad card or reader)
-				emv_debug_error("TTL failure");
-				return EMV_TAL_ERROR_TTL_FAILURE;
-			}
+	} else {
+		// SELECT next application for partial AID match
+		// See EMV 4.4 Book 1, 12.3.3, step 7
+		emv_debug_info_data("SELECT next application", config_app->aid, config_app->aid_len);
+		r = emv_ttl_select_by_df_name_next(ttl, config_app->aid, config_app->aid_len, fci, &fci_len, &sw1sw2);
+		if (r) {
+			emv_debug_trace_msg("emv_ttl_select_by_df_name_next() failed; r=%d", r);
 
-			if (sw1sw2 == 0x6A81) {
-				// Card blocked or SELECT not supported; terminate session
-				// See EMV 4.4 Book 1, 12.3.3, step 2
-				emv_debug_error("Card blocked or SELECT not supported");
-				return EMV_TAL_ERROR_CARD_BLOCKED;
-			}
+			// TTL failure; terminate session
+			// (bad card or reader)
+			emv_debug_error("TTL failure");
+			return EMV_TAL_ERROR_TTL_FAILURE;
+		}
+	}
 
+	if (sw1sw2 != 0x9000 && sw1sw2 != 0x6283) {
+		// Unexpected SELECT status; ignore app and continue to next supported AID
+		// See EMV 4.4 Book 1, 12.3.3, step 3
+		if (sw1sw2 == 0x6A82) {
+			emv_debug_info("Application not found");
 		} else {
-			// SELECT next application for partial AID match
-			// See EMV 4.4 Book 1, 12.3.3, step 7
-			emv_debug_info_data("SELECT next application", config_app->aid, config_app->aid_len);
-			r = emv_ttl_select_by_df_name_next(ttl, config_app->aid, config_app->aid_len, fci, &fci_len, &sw1sw2);
-			if (r) {
-				emv_debug_trace_msg("emv_ttl_select_by_df_name_next() failed; r=%d", r);
-
-				// TTL failure; terminate session
-				// (bad card or reader)
-				emv_debug_error("TTL failure");
-				return EMV_TAL_ERROR_TTL_FAILURE;
-			}
+			emv_debug_error("Unexpected SELECT status 0x%04X", sw1sw2);
 		}
+		return 0;
+	}
 
-		if (sw1sw2 != 0x9000 && sw1sw2 != 0x6283) {
-			// Unexpected SELECT status; ignore app and continue to next supported AID
-			// See EMV 4.4 Book 1, 12.3.3, step 3
-			if (sw1sw2 == 0x6A82) {
-				emv_debug_info("Application not found");
-			} else {
-				emv_debug_error("Unexpected SELECT status 0x%04X", sw1sw2);
-			}
-			exact_match = true;
-			continue;
-		}
+	emv_debug_info_ber("FCI", fci, fci_len);
 
-		emv_debug_info_ber("FCI", fci, fci_len);
+	// Extract FCI data
+	// See EMV 4.4 Book 1, 12.3.3, step 3
+	app = emv_app_create_from_fci(fci, fci_len);
+	if (!app) {
+		emv_debug_trace_msg("emv_app_create_from_fci() failed; app=%p", app);
 
-		// Extract FCI data
+		// Unexpected error; ignore app and continue to next supported AID
 		// See EMV 4.4 Book 1, 12.3.3, step 3
-		app = emv_app_create_from_fci(fci, fci_len);
-		if (!app) {
-			emv_debug_trace_msg("emv_app_create_from_fci() failed; app=%p", app);
+		return 0;
+	}
 
-			// Unexpected error; ignore app and continue to next supported AID
-			// See EMV 4.4 Book 1, 12.3.3, step 3
-			exact_match = true;
-			continue;
-		}
+	// NOTE: It is assumed that the SELECT command will only provide
+	// AIDs that are already a partial or exact match. Therefore it is
+	// only necessary to compare the lengths to know whether it was a
+	// partial or exact match.
 
-		// NOTE: It is assumed that the SELECT command will only provide
-		// AIDs that are already a partial or exact match. Therefore it is
-		// only necessary to compare the lengths to know whether it was a
-		// partial or exact match.
+	if (config_app->aid_len == app->aid->length) {
+		// Exact match; check whether valid or blocked
+		// See EMV 4.4 Book 1, 12.3.3, step 4
 
-		if (config_app->aid_len == app->aid->length) {
-			// Exact match; check whether valid or blocked
+		if (sw1sw2 == 0x9000) {
+			// Valid app; add app and continue to next supported AID
 			// See EMV 4.4 Book 1, 12.3.3, step 4
+			emv_debug_info("Application is supported: exact match");
+			emv_app_list_push(app_list, app);
+		} else {
+			// Blocked app; ignore app and continue to next supported AID
+			// See EMV 4.4 Book 1, 12.3.3, step 4
+			emv_debug_info("Application is blocked");
+			emv_app_free(app);
+			app = NULL;
+		}
+
+		// See EMV 4.4 Book 1, 12.3.3, step 5
+		return 0;
+
+	} else {
+		// Partial match; check Application Selection Indicator (ASI)
+		// See EMV 4.4 Book 1, 12.3.3, step 6
+
+		if (config_app->asi == EMV_ASI_PARTIAL_MATCH) {
+			// Partial match allowed; check whether valid or blocked
 
 			if (sw1sw2 == 0x9000) {
-				// Valid app; add app and continue to next supported AID
-				// See EMV 4.4 Book 1, 12.3.3, step 4
-				emv_debug_info("Application is supported: exact match");
+				// Valid app; add app and continue to next partial AID
+				// See EMV 4.4 Book 1, 12.3.3, step 6
+				emv_debug_info("Application is supported: partial match");
 				emv_app_list_push(app_list, app);
 			} else {
-				// Blocked app; ignore app and continue to next supported AID
-				// See EMV 4.4 Book 1, 12.3.3, step 4
+				// Blocked app; ignore app and continue to next partial AID
+				// See EMV 4.4 Book 1, 12.3.3, step 6
 				emv_debug_info("Application is blocked");
 				emv_app_free(app);
 				app = NULL;
 			}
 
-			// See EMV 4.4 Book 1, 12.3.3, step 5
-			exact_match = true;
-			continue;
+			// See EMV 4.4 Book 1, 12.3.3, step 7
+			return EMV_TAL_RESULT_APP_SELECT_NEXT;
 
 		} else {
-			// Partial match; check Application Selection Indicator (ASI)
+			// Partial match not allowed; ignore app and continue to next supported AID
 			// See EMV 4.4 Book 1, 12.3.3, step 6
+			emv_debug_info("Application is not supported: partial match not allowed");
+			emv_app_free(app);
+			app = NULL;
 
-			if (config_app->asi == EMV_ASI_PARTIAL_MATCH) {
-				// Partial match allowed; check whether valid or blocked
-
-				if (sw1sw2 == 0x9000) {
-					// Valid app; add app and continue to next partial AID
-					// See EMV 4.4 Book 1, 12.3.3, step 6
-					emv_debug_info("Application is supported: partial match");
-					emv_app_list_push(app_list, app);
-				} else {
-					// Blocked app; ignore app and continue to next partial AID
-					// See EMV 4.4 Book 1, 12.3.3, step 6
-					emv_debug_info("Application is blocked");
-					emv_app_free(app);
-					app = NULL;
-				}
+			// See EMV 4.4 Book 1, 12.3.3, step 5
+			return 0;
+		}
+	}
+}
+
+int emv_tal_find_supported_apps(
+	struct emv_ttl_t* ttl,
+	const struct emv_config_t* config,
+	struct emv_app_list_t* app_list
+)
+{
+	int r;
+	struct emv_config_app_itr_t itr;
+	const struct emv_config_app_t* config_app = NULL;
+	bool exact_match;
 
-				// See EMV 4.4 Book 1, 12.3.3, step 7
-				exact_match = false;
-				continue;
+	if (!ttl || !config || !app_list) {
+		// Invalid parameters; terminate session
+		return EMV_TAL_ERROR_INVALID_PARAMETER;
+	}
 
-			} else {
-				// Partial match not allowed; ignore app and continue to next supported AID
-				// See EMV 4.4 Book 1, 12.3.3, step 6
-				emv_debug_info("Application is not supported: partial match not allowed");
-				emv_app_free(app);
-				app = NULL;
+	r = emv_config_app_itr_init(config, &itr);
+	if (r) {
+		emv_debug_error("Internal error");
+		return EMV_TAL_ERROR_INTERNAL;
+	}
 
-				// See EMV 4.4 Book 1, 12.3.3, step 5
-				exact_match = true;
-				continue;
+	// See EMV 4.4 Book 1, 12.3.3
+	exact_match = true;
+	do {
+		if (exact_match) {
+			// Retrieve next supported application
+			config_app = emv_config_app_itr_next(&itr);
+			if (!config_app) {
+				// End of supported application list
+				break;
 			}
 		}
+
+		r = emv_tal_select_supported_app(ttl, config_app, !exact_match, app_list);
+		if (r < 0) {
+			return r;
+		}
+
+		// Continue with next partial AID match or next supported AID
+		// See EMV 4.4 Book 1, 12.3.3, step 5 and 7
+		exact_match = r != EMV_TAL_RESULT_APP_SELECT_NEXT;
 	} while (true);
 
 	return 0;
@@ -587,6 +670,9 @@ int emv_tal_get_processing_options(
 		*afl = NULL;
 	}
 
+	// Temporary list uses the same arena as the output list
+	gpo_list.arena = list->arena;
+
 	// GET PROCESSING OPTIONS
 	// See EMV 4.4 Book 3, 10.1
 	emv_debug_info_data("GET PROCESSING OPTIONS", data, data_len);
@@ -756,192 +842,246 @@ exit:
 	return r;
 }
 
-static int emv_tal_read_sfi_records(
+int emv_tal_read_afl_record(
 	struct emv_ttl_t* ttl,
 	const struct emv_afl_entry_t* afl_entry,
+	uint8_t record_number,
 	struct emv_tlv_list_t* list,
 	struct emv_oda_ctx_t* oda
 )
 {
 	int r;
+	uint8_t sfi;
+	uint8_t record[EMV_RAPDU_DATA_MAX];
+	size_t record_len = sizeof(record);
+	uint16_t sw1sw2;
+	bool record_oda = false;
 	bool oda_record_invalid = false;
+	struct emv_tlv_list_t record_list = EMV_TLV_LIST_INIT;
 
 	if (!ttl || !afl_entry || !list) {
 		// Invalid parameters; terminate session
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
+	sfi = afl_entry->sfi;
 
-	for (uint8_t record_number = afl_entry->first_record; record_number <= afl_entry->last_record; ++record_number) {
-		uint8_t record[EMV_RAPDU_DATA_MAX];
-		size_t record_len = sizeof(record);
-		uint16_t sw1sw2;
-		bool record_oda = false;
-		struct emv_tlv_list_t record_list = EMV_TLV_LIST_INIT;
+	// Temporary list uses the same arena as the output list
+	record_list.arena = list->arena;
 
-		// READ RECORD
+	// READ RECORD
+	// See EMV 4.4 Book 3, 10.2
+	emv_debug_info("READ RECORD from SFI %u, record %u", sfi, record_number);
+	r = emv_ttl_read_record(ttl, sfi, record_number, record, &record_len, &sw1sw2);
+	if (r) {
+		emv_debug_trace_msg("emv_ttl_read_record() failed; r=%d", r);
+		// TTL failure; terminate session
+		// (bad card or reader)
+		emv_debug_error("TTL failure");
+		return EMV_TAL_ERROR_TTL_FAILURE;
+	}
+
+	if (sw1sw2 != 0x9000) {
+		// Failed to READ RECORD; terminate session
 		// See EMV 4.4 Book 3, 10.2
-		emv_debug_info("READ RECORD from SFI %u, record %u", afl_entry->sfi, record_number);
-		r = emv_ttl_read_record(ttl, afl_entry->sfi, record_number, record, &record_len, &sw1sw2);
-		if (r) {
-			emv_debug_trace_msg("emv_ttl_read_record() failed; r=%d", r);
-			// TTL failure; terminate session
-			// (bad card or reader)
-			emv_debug_error("TTL failure");
-			return EMV_TAL_ERROR_TTL_FAILURE;
-		}
+		emv_debug_error("Failed to READ RECORD");
+		return EMV_TAL_ERROR_READ_RECORD_FAILED;
+	}
 
-		if (sw1sw2 != 0x9000) {
-			// Failed to READ RECORD; terminate session
-			// See EMV 4.4 Book 3, 10.2
-			emv_debug_error("Failed to READ RECORD");
-			return EMV_TAL_ERROR_READ_RECORD_FAILED;
+	// Determine whether record is intended for offline data authentication
+	if (afl_entry->oda_record_count &&
+		record_number - afl_entry->first_record < afl_entry->oda_record_count
+	) {
+		record_oda = true;
+	}
+
+	// The records for SFIs 1 - 10 must be encoded as field 70 and the
+	// records for SFIs beyond that range are outside of EMV except for the
+	// card Transaction Log
+	// See EMV 4.4 Book 3, 5.3.2.2
+	// See EMV 4.4 Book 3, 6.5.11.4
+	// See EMV 4.4 Book 3, 7.1
+
+	// The records intended for offline data authentication must be encoded
+	// as field 70. If not, then offline data authentication will be
+	// considered to have been performed but failed.
+	// See EMV 4.4 Book 3, 10.3 (page 98)
+
+	// Therefore, any record that is not encoded as field 70 should not be
+	// parsed for EMV fields, and if that record is also intended for
+	// offline data authentication then further offline data authentication
+	// will be invalidated. However, this implementation chooses to parse
+	// proprietary records with an SFI outside 1 - 10 that are encoded as
+	// field 70.
+	if (record[0] != EMV_TAG_70_DATA_TEMPLATE) {
+		if (sfi >= 1 && sfi <= 10) {
+			// Invalid record for SFIs 1 - 10
+			// EMV 4.4 Book 3, 6.5.11.4
+			emv_debug_error("Invalid record for SFI %u", sfi);
+			return EMV_TAL_ERROR_READ_RECORD_INVALID;
 		}
 
-		// Determine whether record is intended for offline data authentication
-		if (!oda_record_invalid &&
-			afl_entry->oda_record_count &&
-			record_number - afl_entry->first_record < afl_entry->oda_record_count
-		) {
-			record_oda = true;
+		// This implementation chooses to continue reading records if a
+		// proprietary record has an SFI outside 1 - 10 and is not encoded
+		// as field 70, although it will not be parsed for EMV fields.
+		emv_debug_info("Skip proprietary record");
+
+		if (record_oda) {
+			// See EMV 4.4 Book 3, 10.3 (page 98)
+			emv_debug_error("Offline data authentication not possible due to proprietary record");
+			return EMV_TAL_RESULT_ODA_RECORD_INVALID;
 		}
+		return 0;
+	}
 
-		// The records for SFIs 1 - 10 must be encoded as field 70 and the
-		// records for SFIs beyond that range are outside of EMV except for the
-		// card Transaction Log
-		// See EMV 4.4 Book 3, 5.3.2.2
-		// See EMV 4.4 Book 3, 6.5.11.4
-		// See EMV 4.4 Book 3, 7.1
-
-		// The records intended for offline data authentication must be encoded
-		// as field 70. If not, then offline data authentication will be
-		// considered to have been performed but failed.
-		// See EMV 4.4 Book 3, 10.3 (page 98)
-
-		// Therefore, any record that is not encoded as field 70 should not be
-		// parsed for EMV fields, and if that record is also intended for
-		// offline data authentication then further offline data authentication
-		// will be invalidated. However, this implementation chooses to parse
-		// proprietary records with an SFI outside 1 - 10 that are encoded as
-		// field 70.
-		if (record[0] != EMV_TAG_70_DATA_TEMPLATE) {
-			if (afl_entry->sfi >= 1 && afl_entry->sfi <= 10) {
-				// Invalid record for SFIs 1 - 10
-				// EMV 4.4 Book 3, 6.5.11.4
-				emv_debug_error("Invalid record for SFI %u", afl_entry->sfi);
-				return EMV_TAL_ERROR_READ_RECORD_INVALID;
-			}
+	if (sfi >= 1 && sfi <= 10) {
+		struct iso8825_tlv_t record_template;
+		size_t record_template_len;
 
-			if (record_oda) {
-				// See EMV 4.4 Book 3, 10.3 (page 98)
-				emv_debug_error("Offline data authentication not possible due to proprietary record");
-				oda_record_invalid = true;
-			}
+		// Record should contain a single record template for SFIs 1 - 10
+		// See EMV 4.4 Book 3, 6.5.11.4
+		r = iso8825_ber_decode(record, record_len, &record_template);
+		if (r <= 0) {
+			emv_debug_trace_msg("iso8825_ber_decode() failed; r=%d", r);
 
-			// This implementation chooses to continue reading records if a
-			// proprietary record has an SFI outside 1 - 10 and is not encoded
-			// as field 70, although it will not be parsed for EMV fields.
-			emv_debug_info("Skip proprietary record");
-			continue;
+			// Failed to parse application data record template
+			// See EMV 4.4 Book 3, 6.5.11.4
+			emv_debug_error("Failed to parse record template");
+			return EMV_TAL_ERROR_READ_RECORD_INVALID;
 		}
-
-		if (afl_entry->sfi >= 1 && afl_entry->sfi <= 10) {
-			struct iso8825_tlv_t record_template;
-			size_t record_template_len;
-
-			// Record should contain a single record template for SFIs 1 - 10
+		record_template_len = r;
+		if (record_template.tag != EMV_TAG_70_DATA_TEMPLATE) {
+			// Invalid record template for SFIs 1 - 10
 			// See EMV 4.4 Book 3, 6.5.11.4
-			r = iso8825_ber_decode(record, record_len, &record_template);
-			if (r <= 0) {
-				emv_debug_trace_msg("iso8825_ber_decode() failed; r=%d", r);
-
-				// Failed to parse application data record template
-				// See EMV 4.4 Book 3, 6.5.11.4
-				emv_debug_error("Failed to parse record template");
-				return EMV_TAL_ERROR_READ_RECORD_INVALID;
-			}
-			record_template_len = r;
-			if (record_template.tag != EMV_TAG_70_DATA_TEMPLATE) {
-				// Invalid record template for SFIs 1 - 10
-				// See EMV 4.4 Book 3, 6.5.11.4
-				emv_debug_error("Invalid record template tag 0x%02X", record_template.tag);
-				return EMV_TAL_ERROR_READ_RECORD_INVALID;
-			}
-			if (record_template_len != record_len) {
-				// Record should contain a single record template without
-				// additional data after it
-				// See EMV 4.4 Book 3, 6.5.11.4
-				emv_debug_error("Invalid record template total length %zu; expected %zu", record_template_len, record_len);
-				return EMV_TAL_ERROR_READ_RECORD_INVALID;
-			}
+			emv_debug_error("Invalid record template tag 0x%02X", record_template.tag);
+			return EMV_TAL_ERROR_READ_RECORD_INVALID;
+		}
+		if (record_template_len != record_len) {
+			// Record should contain a single record template without
+			// additional data after it
+			// See EMV 4.4 Book 3, 6.5.11.4
+			emv_debug_error("Invalid record template total length %zu; expected %zu", record_template_len, record_len);
+			return EMV_TAL_ERROR_READ_RECORD_INVALID;
+		}
+
+		if (record_oda) {
+			emv_debug_info("Record template content used for offline data authentication");
 
-			if (record_oda) {
-				emv_debug_info("Record template content used for offline data authentication");
-
-				if (oda) {
-					// For SFIs 1 - 10, use record template content for ODA
-					// See EMV 4.4 Book 3, 10.3 (page 98)
-					r = emv_oda_append_record(oda, record_template.value, record_template.length);
-					if (r) {
-						emv_debug_trace_msg("emv_oda_append_record() failed; r=%d", r);
-						// emv_oda_append_record() also prints error
-						oda_record_invalid = true;
-					}
+			if (oda) {
+				// For SFIs 1 - 10, use record template content for ODA
+				// See EMV 4.4 Book 3, 10.3 (page 98)
+				r = emv_oda_append_record(oda, record_template.value, record_template.length);
+				if (r) {
+					emv_debug_trace_msg("emv_oda_append_record() failed; r=%d", r);
+					// emv_oda_append_record() also prints error
+					oda_record_invalid = true;
 				}
 			}
-		} else {
-			if (record_oda) {
-				emv_debug_info("Record used verbatim for offline data authentication");
-				if (oda) {
-					// For SFIs 11 - 30, use record verbatim for ODA
-					// See EMV 4.4 Book 3, 10.3 (page 98)
-					r = emv_oda_append_record(oda, record, record_len);
-					if (r) {
-						emv_debug_trace_msg("emv_oda_append_record() failed; r=%d", r);
-						// emv_oda_append_record() also prints error
-						oda_record_invalid = true;
-					}
+		}
+	} else {
+		if (record_oda) {
+			emv_debug_info("Record used verbatim for offline data authentication");
+			if (oda) {
+				// For SFIs 11 - 30, use record verbatim for ODA
+				// See EMV 4.4 Book 3, 10.3 (page 98)
+				r = emv_oda_append_record(oda, record, record_len);
+				if (r) {
+					emv_debug_trace_msg("emv_oda_append_record() failed; r=%d", r);
+					// emv_oda_append_record() also prints error
+					oda_record_invalid = true;
 				}
 			}
 		}
+	}
 
-		// Parse application data knowing that the record starts with 70 and
-		// that it contains a single record template for SFIs 1 - 10. The EMV
-		// specification does not indicate whether SFIs beyond 1 - 10 may
-		// contain multiple record templates or additional data after the
-		// record template(s), and only states that the record template tag and
-		// length should not be excluded during offline data authentication
-		// processing. This implementation therefore assumes that any record
-		// that has passed the preceding validations is suitable for parsing.
-		r = emv_tlv_parse(record, record_len, &record_list);
-		if (r) {
-			emv_debug_trace_msg("emv_tlv_parse() failed; r=%d", r);
+	// Parse application data knowing that the record starts with 70 and
+	// that it contains a single record template for SFIs 1 - 10. The EMV
+	// specification does not indicate whether SFIs beyond 1 - 10 may
+	// contain multiple record templates or additional data after the
+	// record template(s), and only states that the record template tag and
+	// length should not be excluded during offline data authentication
+	// processing. This implementation therefore assumes that any record
+	// that has passed the preceding validations is suitable for parsing.
+	r = emv_tlv_parse(record, record_len, &record_list);
+	if (r) {
+		emv_debug_trace_msg("emv_tlv_parse() failed; r=%d", r);
 
-			// Always cleanup record list
-			emv_tlv_list_clear(&record_list);
+		// Always cleanup record list
+		emv_tlv_list_clear(&record_list);
 
-			if (r < 0) {
-				// Internal error; terminate session
-				emv_debug_error("Internal error");
-				return EMV_TAL_ERROR_INTERNAL;
-			}
-			if (r > 0) {
-				// Parse error; terminate session
-				emv_debug_error("Failed to parse application data record");
-				return EMV_TAL_ERROR_READ_RECORD_PARSE_FAILED;
-			}
+		if (r < 0) {
+			// Internal error; terminate session
+			emv_debug_error("Internal error");
+			return EMV_TAL_ERROR_INTERNAL;
+		}
+		if (r > 0) {
+			// Parse error; terminate session
+			emv_debug_error("Failed to parse application data record");
+			return EMV_TAL_ERROR_READ_RECORD_PARSE_FAILED;
 		}
-		emv_debug_info_ber("READ RECORD [%u,%u] response", record, record_len, afl_entry->sfi, record_number);
+	}
+	emv_debug_info_ber("READ RECORD [%u,%u] response", record, record_len, sfi, record_number);
+
+	r = emv_tlv_list_append(list, &record_list);
+	if (r) {
+		emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
+
+		// Always cleanup record list
+		emv_tlv_list_clear(&record_list);
 
-		r = emv_tlv_list_append(list, &record_list);
+		// Internal error; terminate session
+		emv_debug_error("Internal error");
+		return EMV_TAL_ERROR_INTERNAL;
+	}
+
+	if (oda) {
+		// Allow issuer public key recovery to start while the remaining
+		// records are read
+		r = emv_oda_update_pipeline(oda, list);
 		if (r) {
-			emv_debug_trace_msg("emv_tlv_list_append() failed; r=%d", r);
+			emv_debug_trace_msg("emv_oda_update_pipeline() failed; r=%d", r);
+			// Continue without pipelining
+		}
+	}
 
-			// Always cleanup record list
-			emv_tlv_list_clear(&record_list);
+	// Successfully read record although offline data authentication may have
+	// failed
+	if (oda_record_invalid) {
+		return EMV_TAL_RESULT_ODA_RECORD_INVALID;
+	} else {
+		return 0;
+	}
+}
 
-			// Internal error; terminate session
-			emv_debug_error("Internal error");
-			return EMV_TAL_ERROR_INTERNAL;
+static int emv_tal_read_sfi_records(
+	struct emv_ttl_t* ttl,
+	const struct emv_afl_entry_t* afl_entry,
+	struct emv_tlv_list_t* list,
+	struct emv_oda_ctx_t* oda
+)
+{
+	int r;
+	bool oda_record_invalid = false;
+
+	if (!ttl || !afl_entry || !list) {
+		// Invalid parameters; terminate session
+		return EMV_TAL_ERROR_INVALID_PARAMETER;
+	}
+
+	for (uint8_t record_number = afl_entry->first_record; record_number <= afl_entry->last_record; ++record_number) {
+		// Records are no longer provided for offline data authentication
+		// once a record intended for offline data authentication is invalid
+		r = emv_tal_read_afl_record(
+			ttl,
+			afl_entry,
+			record_number,
+			list,
+			oda_record_invalid ? NULL : oda
+		);
+		if (r < 0) {
+			return r;
+		}
+		if (r == EMV_TAL_RESULT_ODA_RECORD_INVALID) {
+			oda_record_invalid = true;
 		}
 	}
 
@@ -1037,6 +1177,9 @@ int emv_tal_get_data(
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
 
+	// Temporary list uses the same arena as the output list
+	response_list.arena = list->arena;
+
 	// GET DATA
 	// See EMV 4.4 Book 3, 6.5.7
 	emv_debug_info("GET DATA [%X]", tag);
@@ -1123,6 +1266,9 @@ int emv_tal_internal_authenticate(
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
 
+	// Temporary list uses the same arena as the output list
+	response_list.arena = list->arena;
+
 	// INTERNAL AUTHENTICATE
 	// See EMV 4.4 Book 2, 6.5
 	emv_debug_info_data("INTERNAL AUTHENTICATE", data, data_len);
@@ -1275,6 +1421,9 @@ int emv_tal_genac(
 		return EMV_TAL_ERROR_INVALID_PARAMETER;
 	}
 
+	// Temporary list uses the same arena as the output list
+	response_list.arena = list->arena;
+
 	// GENERATE APPLICATION CRYPTOGRAM
 	// See EMV 4.4 Book 3, 9
 	emv_debug_info("GENAC [P1=0x%02X]", ref_ctrl);
@@ -23,6 +23,7 @@
 #define EMV_TAL_H
 
 #include <sys/cdefs.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -31,11 +32,13 @@ __BEGIN_DECLS
 // Forward declarations
 struct emv_ttl_t;
 struct emv_config_t;
+struct emv_config_app_t;
 struct emv_app_list_t;
 struct emv_app_t;
 struct emv_tlv_list_t;
 struct emv_tlv_t;
 struct emv_oda_ctx_t;
+struct emv_afl_entry_t;
 
 
 /**
@@ -86,8 +89,67 @@ enum emv_tal_result_t {
 	EMV_TAL_RESULT_GPO_CONDITIONS_NOT_SATISFIED, ///< Conditions of use not satisfied for selected application
 	EMV_TAL_RESULT_ODA_RECORD_INVALID, ///< Offline data authentication not possible due to an invalid record
 	EMV_TAL_RESULT_GET_DATA_FAILED, ///< Failed to retrieve data object
+	EMV_TAL_RESULT_PSE_RECORD_NOT_FOUND, ///< No more Payment System Environment (PSE) records
+	EMV_TAL_RESULT_APP_SELECT_NEXT, ///< Partial AID match such that the next application with the same AID should be selected
 };
 
+/**
+ * SELECT Payment System Environment (PSE) and parse its File Control
+ * Information (FCI)
+ * @remark See EMV 4.4 Book 1, 12.3.2, step 1
+ *
+ * @param ttl EMV Terminal Transport Layer context
+ * @param fci File Control Information (FCI) output. Must remain valid while
+ *            @p pse_tlv_list is in use.
+ * @param fci_len Length of File Control Information (FCI) buffer in bytes,
+ *                updated to the length of the FCI output
+ * @param pse_tlv_list PSE TLV list output. Values are borrowed from @p fci.
+ *                     Use @ref emv_tlv_list_clear() to free memory.
+ * @param sfi Short File Identifier (SFI) of PSE records output
+ *
+ * @return Zero for success
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_tal_error_t
+ * @return Greater than zero indicates that the PSE is not available and
+ *         that the terminal may continue the card session. Typically the
+ *         list of AIDs method (@ref emv_tal_find_supported_apps()) would be
+ *         next. See @ref emv_tal_result_t
+ */
+int emv_tal_select_pse(
+	struct emv_ttl_t* ttl,
+	void* fci,
+	size_t* fci_len,
+	struct emv_tlv_list_t* pse_tlv_list,
+	uint8_t* sfi
+);
+
+/**
+ * Read Payment System Environment (PSE) record and append supported
+ * applications to candidate application list
+ * @remark See EMV 4.4 Book 1, 12.3.2, steps 2 - 4
+ *
+ * @param ttl EMV Terminal Transport Layer context
+ * @param pse_tlv_list PSE TLV list provided by @ref emv_tal_select_pse()
+ * @param sfi Short File Identifier (SFI) of PSE records
+ * @param record_number Record number, starting from 1
+ * @param config EMV configuration containing supported applications
+ * @param app_list Candidate application list output
+ *
+ * @return Zero for success, including invalid records that were ignored
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_tal_error_t
+ * @return @ref EMV_TAL_RESULT_PSE_RECORD_NOT_FOUND when there are no more
+ *         PSE records
+ */
+int emv_tal_read_pse_record(
+	struct emv_ttl_t* ttl,
+	const struct emv_tlv_list_t* pse_tlv_list,
+	uint8_t sfi,
+	uint8_t record_number,
+	const struct emv_config_t* config,
+	struct emv_app_list_t* app_list
+);
+
 /**
  * Read Payment System Environment (PSE) records and build candidate
  * application list
@@ -129,6 +191,30 @@ int emv_tal_find_supported_apps(
 	struct emv_app_list_t* app_list
 );
 
+/**
+ * SELECT supported application and append it to candidate application list
+ * if it matches
+ * @remark See EMV 4.4 Book 1, 12.3.3, steps 1 - 7
+ *
+ * @param ttl EMV Terminal Transport Layer context
+ * @param config_app Supported application configuration
+ * @param next Whether to SELECT the next application with the same AID
+ * @param app_list Candidate application list output
+ *
+ * @return Zero for success and processing should continue with the next
+ *         supported application
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_tal_error_t
+ * @return @ref EMV_TAL_RESULT_APP_SELECT_NEXT when processing should continue
+ *         with the next application for the same supported application
+ */
+int emv_tal_select_supported_app(
+	struct emv_ttl_t* ttl,
+	const struct emv_config_app_t* config_app,
+	bool next,
+	struct emv_app_list_t* app_list
+);
+
 /**
  * SELECT application and validate File Control Information (FCI)
  * @remark See EMV 4.4 Book 1, 12.4
@@ -212,6 +298,33 @@ int emv_tal_read_afl_records(
 	struct emv_oda_ctx_t* oda
 );
 
+/**
+ * Perform READ RECORD for a single record of an Application File Locator
+ * (AFL) entry and process response
+ * @remark See EMV 4.4 Book 3, 10.2
+ *
+ * @param ttl EMV Terminal Transport Layer context
+ * @param afl_entry Application File Locator (AFL) entry
+ * @param record_number Record number within @p afl_entry
+ * @param list List to which decoded EMV TLV fields will be appended
+ * @param oda Offline Data Authentication (ODA) context. NULL to skip ODA processing.
+ *
+ * @return Zero for success
+ * @return Less than zero indicates that the terminal should terminate the
+ *         card session. See @ref emv_tal_error_t
+ * @return Greater than zero indicates that the terminal may continue the card
+ *         session but that the record is invalid for offline data
+ *         authentication. This function indicates this condition using a
+ *         return value of @ref EMV_TAL_RESULT_ODA_RECORD_INVALID
+ */
+int emv_tal_read_afl_record(
+	struct emv_ttl_t* ttl,
+	const struct emv_afl_entry_t* afl_entry,
+	uint8_t record_number,
+	struct emv_tlv_list_t* list,
+	struct emv_oda_ctx_t* oda
+);
+
 /**
  * Perform GET DATA and parse response
  * @remark See EMV 4.4 Book 3, 6.5.7
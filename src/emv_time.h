@@ -0,0 +1,61 @@
+/**
+ * @file emv_time.h
+ * @brief Internal monotonic time helper for latency and transcript timing
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_TIME_H
+#define EMV_TIME_H
+
+// This header depends on the build configuration and is for internal use only
+#include "emv_utils_config.h"
+
+#include <sys/cdefs.h>
+#include <stdint.h>
+
+#ifdef HAVE_TIME_H
+#include <time.h>
+#endif
+
+__BEGIN_DECLS
+
+/**
+ * Retrieve current time in microseconds for the purpose of measuring
+ * durations. The monotonic clock is preferred such that durations are not
+ * affected by wall clock adjustments. The epoch is unspecified.
+ *
+ * @return Current time in microseconds
+ */
+static inline uint64_t emv_time_now_us(void)
+{
+	struct timespec t;
+
+#if defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &t);
+#elif defined(HAVE_TIMESPEC_GET)
+	timespec_get(&t, TIME_UTC);
+#else
+#error "No platform function for current time"
+#endif
+
+	return ((uint64_t)t.tv_sec * 1000000) + (t.tv_nsec / 1000);
+}
+
+__END_DECLS
+
+#endif
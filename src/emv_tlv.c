@@ -27,13 +27,70 @@
 
 #include <stdbool.h>
 #include <stdlib.h> // For malloc() and free()
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include <stdatomic.h>
+
+// EMV TLV field allocation flags
+#define EMV_TLV_ALLOC_ARENA (0x01) ///< Field allocated from arena
+#define EMV_TLV_ALLOC_VALUE_ARENA (0x02) ///< Value allocated from arena
+#define EMV_TLV_ALLOC_VALUE_BORROWED (0x04) ///< Value borrowed from caller buffer
+
+// Arena allocations are aligned for EMV TLV fields
+#define EMV_TLV_ARENA_ALIGN(x) (((x) + _Alignof(struct emv_tlv_t) - 1) & ~(_Alignof(struct emv_tlv_t) - 1))
+
+struct emv_tlv_arena_block_t {
+	struct emv_tlv_arena_block_t* next;
+	size_t size;
+	size_t used;
+	max_align_t data[];
+};
+
+// Minimum number of tag index slots; always a power of two
+#define EMV_TLV_INDEX_CAPACITY_MIN (32)
+
+struct emv_tlv_index_entry_t {
+	unsigned int tag;
+	struct emv_tlv_t* tlv;
+};
+
+struct emv_tlv_index_t {
+	bool valid;
+	size_t count;
+	size_t capacity;
+	struct emv_tlv_index_entry_t entries[];
+};
+
+// Maximum number of fields for which duplicate detection does not allocate
+#define EMV_TLV_DUPLICATE_STACK_COUNT (32)
+
+struct emv_tlv_duplicate_entry_t {
+	bool used;
+	unsigned int tag;
+	const struct iso8825_oid_t* oid; // NULL for EMV fields
+};
 
 // Helper functions
 static inline bool emv_tlv_list_is_valid(const struct emv_tlv_list_t* list);
+static uint64_t emv_tlv_generation_next(void);
 static inline bool emv_tlv_sources_is_valid(const struct emv_tlv_sources_t* sources);
-static struct emv_tlv_t* emv_tlv_alloc(unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags);
+static void* emv_tlv_arena_alloc(struct emv_tlv_arena_t* arena, size_t size);
+static struct emv_tlv_t* emv_tlv_alloc(struct emv_tlv_arena_t* arena, unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags);
+static struct emv_tlv_t* emv_tlv_alloc_borrowed(struct emv_tlv_arena_t* arena, unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags, uint8_t value_alloc);
+static void emv_tlv_list_push_field(struct emv_tlv_list_t* list, struct emv_tlv_t* tlv);
+static int emv_tlv_parse_internal(const void* ptr, size_t len, struct emv_tlv_list_t* list, uint8_t value_alloc);
+static inline size_t emv_tlv_index_hash(unsigned int tag);
+static void emv_tlv_index_insert(struct emv_tlv_index_t* index, struct emv_tlv_t* tlv);
+static void emv_tlv_index_update(struct emv_tlv_list_t* list, struct emv_tlv_t* first);
+static int emv_tlv_index_alloc(struct emv_tlv_index_t** index, size_t count);
+static struct emv_tlv_t* emv_tlv_index_lookup(const struct emv_tlv_index_t* index, unsigned int tag);
+static int emv_tlv_index_build(struct emv_tlv_list_t* list);
+static void emv_tlv_index_free(struct emv_tlv_list_t* list);
+static bool emv_tlv_sources_index_is_valid(const struct emv_tlv_sources_t* sources);
+static int emv_tlv_sources_index_build(const struct emv_tlv_sources_t* sources);
+static inline size_t emv_tlv_oid_hash(const struct iso8825_oid_t* oid);
+static bool emv_tlv_duplicate_find(struct emv_tlv_duplicate_entry_t* entries, size_t mask, unsigned int tag, const struct iso8825_oid_t* oid, bool insert);
 
 static inline bool emv_tlv_list_is_valid(const struct emv_tlv_list_t* list)
 {
@@ -52,6 +109,16 @@ static inline bool emv_tlv_list_is_valid(const struct emv_tlv_list_t* list)
 	return true;
 }
 
+static uint64_t emv_tlv_generation_next(void)
+{
+	// List generations are unique across all lists, instead of per list, such
+	// that a different list that reuses the address of a previous list can
+	// never be mistaken for the previous list by an index or cache
+	static atomic_uint_least64_t generation = 0;
+
+	return atomic_fetch_add(&generation, 1) + 1;
+}
+
 static inline bool emv_tlv_sources_is_valid(const struct emv_tlv_sources_t* sources)
 {
 	if (!sources || !sources->count) {
@@ -64,10 +131,129 @@ static inline bool emv_tlv_sources_is_valid(const struct emv_tlv_sources_t* sour
 	return true;
 }
 
-static struct emv_tlv_t* emv_tlv_alloc(unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags)
+int emv_tlv_arena_init(struct emv_tlv_arena_t* arena, size_t block_size)
+{
+	if (!arena) {
+		return -1;
+	}
+
+	memset(arena, 0, sizeof(*arena));
+	if (block_size) {
+		arena->block_size = block_size;
+	} else {
+		arena->block_size = EMV_TLV_ARENA_BLOCK_SIZE_DEFAULT;
+	}
+
+	return 0;
+}
+
+void emv_tlv_arena_reset(struct emv_tlv_arena_t* arena)
+{
+	if (!arena) {
+		return;
+	}
+
+	// Retain all blocks for reuse
+	for (struct emv_tlv_arena_block_t* block = arena->first; block != NULL; block = block->next) {
+		block->used = 0;
+	}
+	arena->current = arena->first;
+}
+
+void emv_tlv_arena_clear(struct emv_tlv_arena_t* arena)
+{
+	if (!arena) {
+		return;
+	}
+
+	while (arena->first) {
+		struct emv_tlv_arena_block_t* block = arena->first;
+		arena->first = block->next;
+		free(block);
+	}
+	arena->current = NULL;
+}
+
+static void* emv_tlv_arena_alloc(struct emv_tlv_arena_t* arena, size_t size)
+{
+	struct emv_tlv_arena_block_t* block;
+	void* ptr;
+
+	if (size > SIZE_MAX / 2) {
+		// Unreasonably large allocation
+		return NULL;
+	}
+	size = EMV_TLV_ARENA_ALIGN(size);
+
+	block = arena->current;
+	if (block && block->size - block->used < size) {
+		// Current block is full; advance to next retained block if it is
+		// large enough, otherwise insert a new block after the current block
+		if (block->next && block->next->size >= size) {
+			block = block->next;
+		} else {
+			block = NULL;
+		}
+	}
+
+	if (!block) {
+		size_t block_size = arena->block_size;
+		if (block_size < size) {
+			block_size = size;
+		}
+
+		block = malloc(sizeof(*block) + block_size);
+		if (!block) {
+			return NULL;
+		}
+		block->size = block_size;
+		block->used = 0;
+
+		if (arena->current) {
+			block->next = arena->current->next;
+			arena->current->next = block;
+		} else {
+			block->next = NULL;
+			arena->first = block;
+		}
+	}
+	arena->current = block;
+
+	ptr = (uint8_t*)block->data + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+static struct emv_tlv_t* emv_tlv_alloc(struct emv_tlv_arena_t* arena, unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags)
 {
 	struct emv_tlv_t* tlv;
 
+	if (arena) {
+		// Allocate field and value as a single arena allocation
+		tlv = emv_tlv_arena_alloc(arena, sizeof(*tlv) + (size_t)length);
+		if (!tlv) {
+			return NULL;
+		}
+
+		tlv->tag = tag;
+		tlv->length = length;
+		if (tlv->length) {
+			tlv->value = (uint8_t*)(tlv + 1);
+			if (value) {
+				memcpy(tlv->value, value, length);
+			}
+		} else {
+			tlv->value = NULL;
+		}
+
+		tlv->flags = flags;
+		tlv->next = NULL;
+		tlv->alloc = EMV_TLV_ALLOC_ARENA | EMV_TLV_ALLOC_VALUE_ARENA;
+
+		return tlv;
+	}
+
 	tlv = malloc(sizeof(*tlv));
 	if (!tlv) {
 		return NULL;
@@ -90,10 +276,179 @@ static struct emv_tlv_t* emv_tlv_alloc(unsigned int tag, unsigned int length, co
 
 	tlv->flags = flags;
 	tlv->next = NULL;
+	tlv->alloc = 0;
+
+	return tlv;
+}
+
+static struct emv_tlv_t* emv_tlv_alloc_borrowed(struct emv_tlv_arena_t* arena, unsigned int tag, unsigned int length, const uint8_t* value, uint8_t flags, uint8_t value_alloc)
+{
+	struct emv_tlv_t* tlv;
+
+	if (arena) {
+		tlv = emv_tlv_arena_alloc(arena, sizeof(*tlv));
+	} else {
+		tlv = malloc(sizeof(*tlv));
+	}
+	if (!tlv) {
+		return NULL;
+	}
+
+	tlv->tag = tag;
+	tlv->length = length;
+	if (tlv->length) {
+		// Value remains owned by the caller, or by the arena, and is never
+		// modified
+		tlv->value = (uint8_t*)value;
+	} else {
+		tlv->value = NULL;
+	}
+
+	tlv->flags = flags;
+	tlv->next = NULL;
+	tlv->alloc = value_alloc;
+	if (arena) {
+		tlv->alloc |= EMV_TLV_ALLOC_ARENA;
+	}
 
 	return tlv;
 }
 
+static inline size_t emv_tlv_index_hash(unsigned int tag)
+{
+	uint32_t h = tag;
+
+	// EMV tags are mostly 1 or 2 bytes with similar upper bits, so mix the
+	// bits to ensure that the lower bits vary
+	h *= 0x9E3779B1;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static void emv_tlv_index_insert(struct emv_tlv_index_t* index, struct emv_tlv_t* tlv)
+{
+	size_t mask = index->capacity - 1;
+
+	// Linear probing for empty slot or existing tag
+	for (size_t i = emv_tlv_index_hash(tlv->tag) & mask; ; i = (i + 1) & mask) {
+		struct emv_tlv_index_entry_t* entry = &index->entries[i];
+
+		if (!entry->tlv) {
+			entry->tag = tlv->tag;
+			entry->tlv = tlv;
+			++index->count;
+			return;
+		}
+
+		if (entry->tag == tlv->tag) {
+			// Only index the first field having a specific tag
+			return;
+		}
+	}
+}
+
+static int emv_tlv_index_alloc(struct emv_tlv_index_t** index, size_t count)
+{
+	size_t capacity;
+
+	capacity = EMV_TLV_INDEX_CAPACITY_MIN;
+	while (capacity < count * 2) {
+		capacity <<= 1;
+	}
+
+	if (!*index || (*index)->capacity < capacity) {
+		if (*index) {
+			free(*index);
+		}
+		*index = malloc(sizeof(**index) + sizeof((*index)->entries[0]) * capacity);
+		if (!*index) {
+			return -1;
+		}
+		(*index)->capacity = capacity;
+	}
+
+	memset((*index)->entries, 0, sizeof((*index)->entries[0]) * (*index)->capacity);
+	(*index)->count = 0;
+	(*index)->valid = false;
+
+	return 0;
+}
+
+static struct emv_tlv_t* emv_tlv_index_lookup(const struct emv_tlv_index_t* index, unsigned int tag)
+{
+	size_t mask = index->capacity - 1;
+
+	for (size_t i = emv_tlv_index_hash(tag) & mask; ; i = (i + 1) & mask) {
+		const struct emv_tlv_index_entry_t* entry = &index->entries[i];
+
+		if (!entry->tlv) {
+			return NULL;
+		}
+		if (entry->tag == tag) {
+			return entry->tlv;
+		}
+	}
+}
+
+static int emv_tlv_index_build(struct emv_tlv_list_t* list)
+{
+	int r;
+	size_t count = 0;
+
+	for (struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		++count;
+	}
+
+	r = emv_tlv_index_alloc(&list->index, count);
+	if (r) {
+		return r;
+	}
+
+	for (struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		emv_tlv_index_insert(list->index, tlv);
+	}
+	list->index->valid = true;
+
+	return 0;
+}
+
+static void emv_tlv_index_update(struct emv_tlv_list_t* list, struct emv_tlv_t* first)
+{
+	size_t count = 0;
+
+	if (!list->indexed) {
+		return;
+	}
+
+	for (struct emv_tlv_t* tlv = first; tlv != NULL; tlv = tlv->next) {
+		++count;
+	}
+
+	// Index should be at most half full
+	if (list->index && list->index->valid &&
+		(list->index->count + count) * 2 <= list->index->capacity
+	) {
+		for (struct emv_tlv_t* tlv = first; tlv != NULL; tlv = tlv->next) {
+			emv_tlv_index_insert(list->index, tlv);
+		}
+		return;
+	}
+
+	// Otherwise rebuild the index now such that emv_tlv_list_find_const()
+	// never needs to modify the list. If this fails, finds will iterate the
+	// list instead.
+	emv_tlv_index_build(list);
+}
+
+static void emv_tlv_index_free(struct emv_tlv_list_t* list)
+{
+	if (list->index) {
+		free(list->index);
+		list->index = NULL;
+	}
+}
+
 int emv_tlv_free(struct emv_tlv_t* tlv)
 {
 	if (!tlv) {
@@ -104,11 +459,16 @@ int emv_tlv_free(struct emv_tlv_t* tlv)
 		return 1;
 	}
 
-	if (tlv->value) {
+	if (tlv->value &&
+		!(tlv->alloc & (EMV_TLV_ALLOC_VALUE_ARENA | EMV_TLV_ALLOC_VALUE_BORROWED))
+	) {
 		free(tlv->value);
 		tlv->value = NULL;
 	}
-	free(tlv);
+
+	if (!(tlv->alloc & EMV_TLV_ALLOC_ARENA)) {
+		free(tlv);
+	}
 
 	return 0;
 }
@@ -145,6 +505,35 @@ void emv_tlv_list_clear(struct emv_tlv_list_t* list)
 	}
 	assert(list->front == NULL);
 	assert(list->back == NULL);
+
+	// Release index but retain the indexed flag for future use
+	emv_tlv_index_free(list);
+}
+
+int emv_tlv_list_enable_index(struct emv_tlv_list_t* list)
+{
+	if (!emv_tlv_list_is_valid(list)) {
+		return -1;
+	}
+
+	// Build index now for existing fields, if any, and update it when fields
+	// are pushed or appended
+	list->indexed = true;
+	if (list->front && (!list->index || !list->index->valid)) {
+		emv_tlv_index_build(list);
+	}
+
+	return 0;
+}
+
+void emv_tlv_list_disable_index(struct emv_tlv_list_t* list)
+{
+	if (!list) {
+		return;
+	}
+
+	list->indexed = false;
+	emv_tlv_index_free(list);
 }
 
 int emv_tlv_list_push(
@@ -161,11 +550,18 @@ int emv_tlv_list_push(
 		return -1;
 	}
 
-	tlv = emv_tlv_alloc(tag, length, value, flags);
+	tlv = emv_tlv_alloc(list->arena, tag, length, value, flags);
 	if (!tlv) {
 		return -2;
 	}
+	emv_tlv_list_push_field(list, tlv);
+
+	return 0;
+}
 
+static void emv_tlv_list_push_field(struct emv_tlv_list_t* list, struct emv_tlv_t* tlv)
+{
+	list->generation = emv_tlv_generation_next();
 	if (list->back) {
 		list->back->next = tlv;
 		list->back = tlv;
@@ -173,8 +569,7 @@ int emv_tlv_list_push(
 		list->front = tlv;
 		list->back = tlv;
 	}
-
-	return 0;
+	emv_tlv_index_update(list, tlv);
 }
 
 int emv_tlv_list_push_asn1_object(
@@ -270,6 +665,7 @@ struct emv_tlv_t* emv_tlv_list_pop(struct emv_tlv_list_t* list)
 	}
 
 	if (list->front) {
+		list->generation = emv_tlv_generation_next();
 		tlv = list->front;
 		list->front = tlv->next;
 		if (!list->front) {
@@ -277,6 +673,12 @@ struct emv_tlv_t* emv_tlv_list_pop(struct emv_tlv_list_t* list)
 		}
 
 		tlv->next = NULL;
+
+		if (list->index) {
+			// Popped field may be referenced by the index; rebuild when the
+			// list is next modified or searched using emv_tlv_list_find()
+			list->index->valid = false;
+		}
 	}
 
 	return tlv;
@@ -290,6 +692,13 @@ struct emv_tlv_t* emv_tlv_list_find(struct emv_tlv_list_t* list, unsigned int ta
 		return NULL;
 	}
 
+	if (list->indexed &&
+		((list->index && list->index->valid) || emv_tlv_index_build(list) == 0)
+	) {
+		return emv_tlv_index_lookup(list->index, tag);
+	}
+
+	// Otherwise iterate the list
 	for (tlv = list->front; tlv != NULL; tlv = tlv->next) {
 		if (tlv->tag == tag) {
 			return tlv;
@@ -299,42 +708,158 @@ struct emv_tlv_t* emv_tlv_list_find(struct emv_tlv_list_t* list, unsigned int ta
 	return NULL;
 }
 
+const struct emv_tlv_t* emv_tlv_list_find_const(
+	const struct emv_tlv_list_t* list,
+	unsigned int tag
+)
+{
+	const struct emv_tlv_t* tlv = NULL;
+
+	if (!emv_tlv_list_is_valid(list)) {
+		return NULL;
+	}
+
+	// Use the index if it is up to date but never build it here because the
+	// list may be searched concurrently
+	if (list->indexed && list->index && list->index->valid) {
+		return emv_tlv_index_lookup(list->index, tag);
+	}
+
+	// Otherwise iterate the list
+	for (tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		if (tlv->tag == tag) {
+			return tlv;
+		}
+	}
+
+	return NULL;
+}
+
+static inline size_t emv_tlv_oid_hash(const struct iso8825_oid_t* oid)
+{
+	uint32_t h = oid->length;
+
+	// Combine OID arcs before mixing the bits using the tag index hash
+	for (unsigned int i = 0; i < oid->length; ++i) {
+		h = (h ^ oid->value[i]) * 0x01000193;
+	}
+
+	return emv_tlv_index_hash(h);
+}
+
+static bool emv_tlv_duplicate_find(
+	struct emv_tlv_duplicate_entry_t* entries,
+	size_t mask,
+	unsigned int tag,
+	const struct iso8825_oid_t* oid,
+	bool insert
+)
+{
+	size_t hash;
+
+	if (oid) {
+		hash = emv_tlv_oid_hash(oid);
+	} else {
+		hash = emv_tlv_index_hash(tag);
+	}
+
+	// Linear probing for empty slot or matching tag or OID
+	for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+		struct emv_tlv_duplicate_entry_t* entry = &entries[i];
+
+		if (!entry->used) {
+			if (insert) {
+				entry->used = true;
+				entry->tag = tag;
+				entry->oid = oid;
+			}
+			return false;
+		}
+
+		if (oid) {
+			if (entry->oid &&
+				oid->length == entry->oid->length && // OID arc length match
+				memcmp(oid->value, entry->oid->value, sizeof(oid->value[0]) * oid->length) == 0 // OID arc match
+			) {
+				return true;
+			}
+		} else if (!entry->oid && entry->tag == tag) {
+			return true;
+		}
+	}
+}
+
 bool emv_tlv_list_has_duplicate(const struct emv_tlv_list_t* list)
 {
 	int r;
+	bool duplicate = false;
+	size_t count = 0;
+	size_t capacity;
+	struct emv_tlv_duplicate_entry_t entries_buf[EMV_TLV_DUPLICATE_STACK_COUNT * 2];
+	struct iso8825_oid_t oids_buf[EMV_TLV_DUPLICATE_STACK_COUNT];
+	struct emv_tlv_duplicate_entry_t* entries = entries_buf;
+	struct iso8825_oid_t* oids = oids_buf;
+	size_t oid_count = 0;
+	void* heap = NULL;
 
 	if (!emv_tlv_list_is_valid(list)) {
 		return false;
 	}
 
 	for (const struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
-		struct iso8825_oid_t oid;
-		bool tlv_is_asn1_object = false;
-		r = iso8825_ber_asn1_object_decode(&tlv->ber, &oid);
+		++count;
+	}
+	if (count < 2) {
+		return false;
+	}
+
+	// Use at most half of the hash table slots
+	capacity = EMV_TLV_DUPLICATE_STACK_COUNT * 2;
+	while (capacity < count * 2) {
+		capacity <<= 1;
+	}
+
+	if (count > EMV_TLV_DUPLICATE_STACK_COUNT) {
+		heap = malloc(sizeof(*entries) * capacity + sizeof(*oids) * count);
+		if (!heap) {
+			// Unable to detect duplicates; assume the worst
+			return true;
+		}
+		entries = heap;
+		oids = (struct iso8825_oid_t*)(entries + capacity);
+	}
+	memset(entries, 0, sizeof(*entries) * capacity);
+
+	// EMV fields are duplicates if they have the same tag, while ASN.1
+	// objects are duplicates if they have the same OID. ASN.1 objects also
+	// duplicate a preceding EMV field having the same tag.
+	for (const struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		struct iso8825_oid_t* oid = &oids[oid_count];
+
+		r = iso8825_ber_asn1_object_decode(&tlv->ber, oid);
 		if (r > 0) {
-			tlv_is_asn1_object = true;
-		}
-
-		for (const struct emv_tlv_t* tlv2 = tlv->next; tlv2 != NULL; tlv2 = tlv2->next) {
-			if (tlv_is_asn1_object) {
-				struct iso8825_oid_t oid2;
-				r = iso8825_ber_asn1_object_decode(&tlv2->ber, &oid2);
-				if (r > 0 && // Is ASN.1 object
-					oid.length == oid2.length && // OID arc length match
-					memcmp(oid.value, oid2.value, sizeof(oid2.value[0]) * oid2.length) == 0 // OID arc match
-				) {
-					// Duplicate ASN.1 object
-					return true;
-				}
-
-			} else if (tlv->tag == tlv2->tag) {
-				// Duplicate EMV field
-				return true;
+			// ASN.1 object
+			++oid_count;
+			if (emv_tlv_duplicate_find(entries, capacity - 1, tlv->tag, oid, true) ||
+				emv_tlv_duplicate_find(entries, capacity - 1, tlv->tag, NULL, false)
+			) {
+				duplicate = true;
+				break;
+			}
+		} else {
+			// EMV field
+			if (emv_tlv_duplicate_find(entries, capacity - 1, tlv->tag, NULL, true)) {
+				duplicate = true;
+				break;
 			}
 		}
 	}
 
-	return false;
+	if (heap) {
+		free(heap);
+	}
+
+	return duplicate;
 }
 
 int emv_tlv_list_append(struct emv_tlv_list_t* list, struct emv_tlv_list_t* other)
@@ -347,6 +872,8 @@ int emv_tlv_list_append(struct emv_tlv_list_t* list, struct emv_tlv_list_t* othe
 		return -2;
 	}
 
+	list->generation = emv_tlv_generation_next();
+	other->generation = emv_tlv_generation_next();
 	if (list->back) {
 		// If the list is not empty, then attach the back of the list to the
 		// front of the other list
@@ -361,8 +888,52 @@ int emv_tlv_list_append(struct emv_tlv_list_t* list, struct emv_tlv_list_t* othe
 		// becomes the back of the combined list
 		list->back = other->back;
 	}
+	emv_tlv_index_update(list, other->front);
 	other->front = NULL;
 	other->back = NULL;
+	emv_tlv_index_free(other);
+
+	return 0;
+}
+
+int emv_tlv_list_materialise(struct emv_tlv_list_t* list)
+{
+	if (!emv_tlv_list_is_valid(list)) {
+		return -1;
+	}
+
+	for (struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		uint8_t* value;
+
+		if (!(tlv->alloc & EMV_TLV_ALLOC_VALUE_BORROWED)) {
+			// Value already owned by field
+			continue;
+		}
+
+		if (!tlv->length) {
+			tlv->alloc &= ~EMV_TLV_ALLOC_VALUE_BORROWED;
+			continue;
+		}
+
+		// Copy value to the same storage that the list would use for new
+		// fields. Values allocated from the heap are always freed by
+		// emv_tlv_free(), even for fields allocated from an arena.
+		if (list->arena) {
+			value = emv_tlv_arena_alloc(list->arena, tlv->length);
+		} else {
+			value = malloc(tlv->length);
+		}
+		if (!value) {
+			return -2;
+		}
+		memcpy(value, tlv->value, tlv->length);
+
+		tlv->value = value;
+		tlv->alloc &= ~EMV_TLV_ALLOC_VALUE_BORROWED;
+		if (list->arena) {
+			tlv->alloc |= EMV_TLV_ALLOC_VALUE_ARENA;
+		}
+	}
 
 	return 0;
 }
@@ -408,6 +979,107 @@ int emv_tlv_sources_init_from_ctx(
 	return 0;
 }
 
+int emv_tlv_sources_enable_index(
+	struct emv_tlv_sources_t* sources,
+	struct emv_tlv_sources_index_t* index
+)
+{
+	if (!sources || !index) {
+		return -1;
+	}
+
+	// Index will be built lazily by the next find
+	sources->index = index;
+
+	return 0;
+}
+
+void emv_tlv_sources_index_clear(struct emv_tlv_sources_index_t* index)
+{
+	if (!index) {
+		return;
+	}
+
+	if (index->table) {
+		free(index->table);
+	}
+	*index = EMV_TLV_SOURCES_INDEX_INIT;
+}
+
+static bool emv_tlv_sources_index_is_valid(const struct emv_tlv_sources_t* sources)
+{
+	const struct emv_tlv_sources_index_t* index = sources->index;
+
+	if (!index->table || !index->table->valid) {
+		return false;
+	}
+
+	// Index is only valid for the same lists, without modification, in the
+	// same order
+	if (index->count != sources->count) {
+		return false;
+	}
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		const struct emv_tlv_list_t* list = sources->list[i];
+
+		if (index->list[i].list != list) {
+			return false;
+		}
+		if (list && (
+			index->list[i].generation != list->generation ||
+			index->list[i].front != list->front ||
+			index->list[i].back != list->back
+		)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int emv_tlv_sources_index_build(const struct emv_tlv_sources_t* sources)
+{
+	int r;
+	struct emv_tlv_sources_index_t* index = sources->index;
+	size_t count = 0;
+
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		if (!sources->list[i]) {
+			continue;
+		}
+		for (const struct emv_tlv_t* tlv = sources->list[i]->front; tlv != NULL; tlv = tlv->next) {
+			++count;
+		}
+	}
+
+	r = emv_tlv_index_alloc(&index->table, count);
+	if (r) {
+		return r;
+	}
+
+	// Insert lists in priority order such that the index refers to the same
+	// field that would be found by searching each list in order
+	index->count = sources->count;
+	for (unsigned int i = 0; i < sources->count; ++i) {
+		const struct emv_tlv_list_t* list = sources->list[i];
+
+		index->list[i].list = list;
+		if (!list) {
+			continue;
+		}
+		index->list[i].front = list->front;
+		index->list[i].back = list->back;
+		index->list[i].generation = list->generation;
+
+		for (struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+			emv_tlv_index_insert(index->table, tlv);
+		}
+	}
+	index->table->valid = true;
+
+	return 0;
+}
+
 const struct emv_tlv_t* emv_tlv_sources_find_const(
 	const struct emv_tlv_sources_t* sources,
 	unsigned int tag
@@ -417,6 +1089,12 @@ const struct emv_tlv_t* emv_tlv_sources_find_const(
 		return NULL;
 	}
 
+	if (sources->index &&
+		(emv_tlv_sources_index_is_valid(sources) || emv_tlv_sources_index_build(sources) == 0)
+	) {
+		return emv_tlv_index_lookup(sources->index->table, tag);
+	}
+
 	for (unsigned int i = 0; i < sources->count; ++i) {
 		const struct emv_tlv_t* tlv;
 
@@ -540,6 +1218,35 @@ const struct emv_tlv_t* emv_tlv_sources_itr_find_next_const(
 }
 
 int emv_tlv_parse(const void* ptr, size_t len, struct emv_tlv_list_t* list)
+{
+	if (!ptr) {
+		return -1;
+	}
+
+	if (list && list->arena) {
+		void* arena_ptr;
+
+		// Copy encoded data to the arena once and refer to the values in
+		// that copy instead of copying each value individually. The values
+		// are owned by the arena and need not be materialised again.
+		arena_ptr = emv_tlv_arena_alloc(list->arena, len);
+		if (!arena_ptr) {
+			return -2;
+		}
+		memcpy(arena_ptr, ptr, len);
+
+		return emv_tlv_parse_internal(arena_ptr, len, list, EMV_TLV_ALLOC_VALUE_ARENA);
+	}
+
+	return emv_tlv_parse_internal(ptr, len, list, 0);
+}
+
+int emv_tlv_parse_borrowed(const void* ptr, size_t len, struct emv_tlv_list_t* list)
+{
+	return emv_tlv_parse_internal(ptr, len, list, EMV_TLV_ALLOC_VALUE_BORROWED);
+}
+
+static int emv_tlv_parse_internal(const void* ptr, size_t len, struct emv_tlv_list_t* list, uint8_t value_alloc)
 {
 	int r;
 	struct iso8825_ber_itr_t itr;
@@ -553,10 +1260,23 @@ int emv_tlv_parse(const void* ptr, size_t len, struct emv_tlv_list_t* list)
 	while ((r = iso8825_ber_itr_next(&itr, &tlv)) > 0) {
 		if (iso8825_ber_is_constructed(&tlv)) {
 			// Recurse into constructed/template field but omit it from the list
-			r = emv_tlv_parse(tlv.value, tlv.length, list);
+			r = emv_tlv_parse_internal(tlv.value, tlv.length, list, value_alloc);
 			if (r) {
 				return r;
 			}
+		} else if (value_alloc) {
+			// Refer to value instead of copying it
+			struct emv_tlv_t* field;
+
+			if (!emv_tlv_list_is_valid(list)) {
+				return -2;
+			}
+
+			field = emv_tlv_alloc_borrowed(list->arena, tlv.tag, tlv.length, tlv.value, 0, value_alloc);
+			if (!field) {
+				return -2;
+			}
+			emv_tlv_list_push_field(list, field);
 		} else {
 			r = emv_tlv_list_push(list, tlv.tag, tlv.length, tlv.value, 0);
 			if (r) {
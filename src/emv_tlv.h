@@ -33,6 +33,7 @@ __BEGIN_DECLS
 
 // Forward declarations
 struct emv_ctx_t;
+struct emv_cert_cache_t;
 
 /**
  * EMV TLV field
@@ -50,6 +51,31 @@ struct emv_tlv_t {
 	};
 
 	struct emv_tlv_t* next;                     ///< Next EMV TLV field in list
+
+	/// @cond INTERNAL
+	uint8_t alloc;
+	/// @endcond
+};
+
+/**
+ * EMV TLV arena
+ *
+ * An arena allows EMV TLV fields, and their values, to be allocated from a
+ * small number of large blocks instead of individual heap allocations. All
+ * fields allocated from an arena are released in a single step using
+ * @ref emv_tlv_arena_reset() or @ref emv_tlv_arena_clear().
+ *
+ * @note Fields allocated from an arena remain valid until the arena is reset
+ *       or cleared, even after they are removed from a list. Do not access
+ *       such fields after the arena is reset or cleared.
+ */
+struct emv_tlv_arena_t {
+	size_t block_size;                          ///< Minimum size of arena blocks in bytes
+
+	/// @cond INTERNAL
+	struct emv_tlv_arena_block_t* first;
+	struct emv_tlv_arena_block_t* current;
+	/// @endcond
 };
 
 /**
@@ -59,6 +85,39 @@ struct emv_tlv_t {
 struct emv_tlv_list_t {
 	struct emv_tlv_t* front;                    ///< Pointer to front of list
 	struct emv_tlv_t* back;                     ///< Pointer to end of list
+	struct emv_tlv_arena_t* arena;              ///< Arena used for new fields. NULL to use heap.
+
+	bool indexed;                               ///< Whether to use tag index. See @ref emv_tlv_list_enable_index().
+
+	/// @cond INTERNAL
+	struct emv_tlv_index_t* index;
+	uint64_t generation;
+	/// @endcond
+};
+
+/**
+ * EMV TLV sources index
+ *
+ * A merged tag index for the lists of one or more EMV TLV sources objects,
+ * such that @ref emv_tlv_sources_find_const() does not need to search each
+ * list. The index is owned by the caller and referenced by
+ * @ref emv_tlv_sources_t.index. It is built lazily and is rebuilt lazily
+ * whenever any of the lists, or the sources object, changes.
+ *
+ * @note Use @ref emv_tlv_sources_index_clear() to release the index.
+ * @note An index should not be used concurrently by multiple threads.
+ */
+struct emv_tlv_sources_index_t {
+	/// @cond INTERNAL
+	unsigned int count;
+	struct emv_tlv_sources_index_list_t {
+		const struct emv_tlv_list_t* list;
+		const struct emv_tlv_t* front;
+		const struct emv_tlv_t* back;
+		uint64_t generation;
+	} list[5];
+	struct emv_tlv_index_t* table;
+	/// @endcond
 };
 
 /**
@@ -69,6 +128,8 @@ struct emv_tlv_list_t {
 struct emv_tlv_sources_t {
 	unsigned int count;                         ///< Number of source lists
 	const struct emv_tlv_list_t* list[5];       ///< Array of source lists
+	struct emv_tlv_sources_index_t* index;      ///< Merged tag index. NULL for none. See @ref emv_tlv_sources_enable_index().
+	struct emv_cert_cache_t* cert_cache;        ///< Certificate recovery cache used by EMV strings. NULL for none. See @ref emv_tlv_sources_enable_cert_cache().
 };
 
 /**
@@ -84,17 +145,54 @@ struct emv_tlv_sources_itr_t {
 };
 
 /// Static initialiser for @ref emv_tlv_t
-#define EMV_TLV_INIT ((struct emv_tlv_t){ { { 0, 0, NULL, 0 } }, NULL })
+#define EMV_TLV_INIT ((struct emv_tlv_t){ { { 0, 0, NULL, 0 } }, NULL, 0 })
 
 /// Static initialiser for @ref emv_tlv_list_t
-#define EMV_TLV_LIST_INIT ((struct emv_tlv_list_t){ NULL, NULL })
+#define EMV_TLV_LIST_INIT ((struct emv_tlv_list_t){ NULL, NULL, NULL, false, NULL, 0 })
 
 /// Static initialiser for @ref emv_tlv_sources_t
-#define EMV_TLV_SOURCES_INIT ((struct emv_tlv_sources_t){ 0, { NULL }})
+#define EMV_TLV_SOURCES_INIT ((struct emv_tlv_sources_t){ 0, { NULL }, NULL, NULL })
+
+/// Static initialiser for @ref emv_tlv_sources_index_t
+#define EMV_TLV_SOURCES_INDEX_INIT ((struct emv_tlv_sources_index_t){ 0, { { NULL, NULL, NULL, 0 } }, NULL })
+
+/// Default minimum size of @ref emv_tlv_arena_t blocks
+#define EMV_TLV_ARENA_BLOCK_SIZE_DEFAULT (4096)
+
+/**
+ * Initialise EMV TLV arena
+ * @note This function does not allocate memory. Blocks are allocated as
+ *       needed when fields are pushed to a list that uses the arena.
+ * @param arena EMV TLV arena
+ * @param block_size Minimum size of arena blocks in bytes. Use zero for
+ *                   @ref EMV_TLV_ARENA_BLOCK_SIZE_DEFAULT.
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_tlv_arena_init(struct emv_tlv_arena_t* arena, size_t block_size);
+
+/**
+ * Reset EMV TLV arena such that all fields allocated from the arena are
+ * released in a single step, while retaining the arena blocks for reuse.
+ * @note Lists that use the arena should be cleared before calling this function
+ * @param arena EMV TLV arena
+ */
+void emv_tlv_arena_reset(struct emv_tlv_arena_t* arena);
+
+/**
+ * Clear EMV TLV arena such that all fields allocated from the arena, as well
+ * as the arena blocks, are released.
+ * @note Lists that use the arena should be cleared before calling this function
+ * @param arena EMV TLV arena
+ */
+void emv_tlv_arena_clear(struct emv_tlv_arena_t* arena);
 
 /**
  * Free EMV TLV field
  * @note This function should not be used to free EMV TLV fields that are elements of a list
+ * @note This function does nothing for EMV TLV fields that were allocated
+ *       from an arena. Use @ref emv_tlv_arena_reset() instead.
+ * @note This function will not free values that were borrowed by
+ *       @ref emv_tlv_parse_borrowed().
  * @param tlv EMV TLV field to free
  * @return Zero for success. Non-zero if it is unsafe to free the EMV TLV field.
  */
@@ -109,13 +207,44 @@ bool emv_tlv_list_is_empty(const struct emv_tlv_list_t* list);
 /**
  * Clear EMV TLV list
  * @note This function will call @ref emv_tlv_free() for every element
+ * @note This function will release the tag index, if any, but it will
+ *       remain enabled for future use of the list
  * @param list EMV TLV list object
  */
 void emv_tlv_list_clear(struct emv_tlv_list_t* list);
 
+/**
+ * Enable tag index for EMV TLV list such that @ref emv_tlv_list_find() does
+ * not need to iterate the list.
+ *
+ * The index is built by this function and is updated when fields are pushed
+ * or appended. After fields are popped, the index is rebuilt when the list is
+ * next modified or searched using @ref emv_tlv_list_find(). The order of the
+ * list and the behaviour of @ref emv_tlv_list_find() are unchanged, which
+ * means that the index always refers to the first field in the list having a
+ * specific tag.
+ *
+ * @note @ref emv_tlv_list_find_const() never modifies the list or the index
+ *       and iterates the list if the index is not up to date. It may
+ *       therefore be used concurrently by multiple threads while the list is
+ *       not modified.
+ *
+ * @param list EMV TLV list
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_tlv_list_enable_index(struct emv_tlv_list_t* list);
+
+/**
+ * Disable tag index for EMV TLV list and release the index, if any
+ * @param list EMV TLV list
+ */
+void emv_tlv_list_disable_index(struct emv_tlv_list_t* list);
+
 /**
  * Push EMV TLV field on to the back of an EMV TLV list
  * @note This function will copy the data from the @c value parameter
+ * @note This function will allocate from @ref emv_tlv_list_t.arena, if
+ *       available, or otherwise from the heap
  * @param list EMV TLV list
  * @param tag EMV TLV tag
  * @param length EMV TLV length
@@ -162,6 +291,8 @@ struct emv_tlv_t* emv_tlv_list_pop(struct emv_tlv_list_t* list);
 
 /**
  * Find EMV TLV field in an EMV TLV list
+ * @note This function uses the tag index, if enabled. See
+ *       @ref emv_tlv_list_enable_index().
  * @param list EMV TLV list
  * @param tag EMV tag to find
  * @return EMV TLV field. Do NOT free. NULL if not found.
@@ -170,24 +301,22 @@ struct emv_tlv_t* emv_tlv_list_find(struct emv_tlv_list_t* list, unsigned int ta
 
 /**
  * Const alternative for @ref emv_tlv_list_find
+ * @note This function uses the tag index, if enabled and up to date, but
+ *       never builds it. See @ref emv_tlv_list_enable_index().
  * @param list EMV TLV list
  * @param tag EMV tag to find
  * @return EMV TLV field. Do NOT free. NULL if not found.
  */
-#ifdef __GNUC__
-__attribute__((always_inline))
-#endif
-inline const struct emv_tlv_t* emv_tlv_list_find_const(
+const struct emv_tlv_t* emv_tlv_list_find_const(
 	const struct emv_tlv_list_t* list,
 	unsigned int tag
-)
-{
-	return emv_tlv_list_find((struct emv_tlv_list_t*)list, tag);
-}
+);
 
 /**
  * Determine whether EMV TLV list contains duplicate fields or duplicate
  * ASN.1 objects
+ * @note This function requires a temporary allocation for lists having many
+ *       fields and will indicate duplicates if that allocation fails
  * @param list EMV TLV list
  * @return Boolean indicating whether EMV TLV list contains duplicate fields
  */
@@ -202,6 +331,21 @@ bool emv_tlv_list_has_duplicate(const struct emv_tlv_list_t* list);
  */
 int emv_tlv_list_append(struct emv_tlv_list_t* list, struct emv_tlv_list_t* other);
 
+/**
+ * Copy all values borrowed by @ref emv_tlv_parse_borrowed() such that the
+ * EMV TLV list no longer depends on the buffer that was parsed. Values are
+ * copied to @ref emv_tlv_list_t.arena, if available, or otherwise to the heap.
+ * Fields that already own their values are not modified.
+ *
+ * @note Use this function before the parsed buffer is released or reused if
+ *       the list must outlive it, for example before appending the list to
+ *       another list.
+ *
+ * @param list EMV TLV list
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_tlv_list_materialise(struct emv_tlv_list_t* list);
+
 /**
  * Initialise EMV TLV sources from EMV processing context.
  * Sources will have this order:
@@ -218,6 +362,35 @@ int emv_tlv_sources_init_from_ctx(
 	const struct emv_ctx_t* ctx
 );
 
+/**
+ * Enable merged tag index for EMV TLV sources such that
+ * @ref emv_tlv_sources_find_const() probes a single index instead of
+ * searching each list in order. The index is resolved using the same
+ * priority as the order of the lists and is rebuilt lazily whenever any of
+ * the lists change.
+ *
+ * @note The same index may be used for multiple EMV TLV sources objects,
+ *       but will be rebuilt whenever it is used for a different set of lists.
+ * @note Because the index may be built by
+ *       @ref emv_tlv_sources_find_const(), the sources should not be searched
+ *       concurrently by multiple threads.
+ *
+ * @param sources EMV TLV sources
+ * @param index EMV TLV sources index owned by the caller. Must remain valid
+ *              while the sources are in use.
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_tlv_sources_enable_index(
+	struct emv_tlv_sources_t* sources,
+	struct emv_tlv_sources_index_t* index
+);
+
+/**
+ * Clear EMV TLV sources index and release its resources
+ * @param index EMV TLV sources index
+ */
+void emv_tlv_sources_index_clear(struct emv_tlv_sources_index_t* index);
+
 /**
  * Find EMV TLV field in EMV TLV sources
  * @param sources EMV TLV sources
@@ -270,6 +443,10 @@ const struct emv_tlv_t* emv_tlv_sources_itr_find_next_const(
  * the caller to clear the list using @ref emv_tlv_list_clear() to avoid
  * memory leaks.
  *
+ * @note If @ref emv_tlv_list_t.arena is available, the encoded EMV data is
+ *       copied to the arena once and the values of the decoded fields refer
+ *       to that copy.
+ *
  * @param ptr Encoded EMV data
  * @param len Length of encoded EMV data in bytes
  * @param list Decoded EMV TLV list output.
@@ -277,6 +454,24 @@ const struct emv_tlv_t* emv_tlv_sources_itr_find_next_const(
  */
 int emv_tlv_parse(const void* ptr, size_t len, struct emv_tlv_list_t* list);
 
+/**
+ * Parse EMV data without copying values.
+ * This function is the same as @ref emv_tlv_parse() except that the values of
+ * the decoded fields refer to the encoded EMV data instead of being copied.
+ *
+ * @note The encoded EMV data must remain valid, and must not be modified,
+ *       for as long as the decoded fields are in use. Use
+ *       @ref emv_tlv_list_materialise() if the list must outlive the encoded
+ *       EMV data.
+ * @note The values of the decoded fields must not be modified.
+ *
+ * @param ptr Encoded EMV data
+ * @param len Length of encoded EMV data in bytes
+ * @param list Decoded EMV TLV list output.
+ * @return Zero for success. Less than zero for internal error. Greater than zero for parse error.
+ */
+int emv_tlv_parse_borrowed(const void* ptr, size_t len, struct emv_tlv_list_t* list);
+
 /**
  * Determine whether a specific EMV tag should be encoded as format 'n'
  * @note This function is typically needed for Data Object List (DOL) processing
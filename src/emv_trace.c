@@ -0,0 +1,468 @@
+/**
+ * @file emv_trace.c
+ * @brief Binary trace format for EMV debug events
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_trace.h"
+#include "emv_tlv.h"
+#include "iso7816.h"
+#include "iso8825_ber.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE: This module must not emit debug events because it may be used as
+// the debug event function itself
+
+static const uint8_t emv_trace_magic[] = { 'E', 'M', 'V', 'D' };
+
+// Events up to this length are encoded without memory allocation
+#define EMV_TRACE_EVENT_STACK_LEN (512)
+
+static size_t emv_trace_tag_len(unsigned int tag)
+{
+	size_t len = 1;
+	while (tag >>= 8) {
+		++len;
+	}
+	return len;
+}
+
+static size_t emv_trace_len_len(size_t len)
+{
+	if (len < 0x80) {
+		return 1;
+	}
+	if (len <= 0xFF) {
+		return 2;
+	}
+	if (len <= 0xFFFF) {
+		return 3;
+	}
+	if (len <= 0xFFFFFF) {
+		return 4;
+	}
+	return 5;
+}
+
+static uint8_t* emv_trace_put_tag(uint8_t* ptr, unsigned int tag)
+{
+	for (size_t i = emv_trace_tag_len(tag); i > 0; --i) {
+		*ptr++ = tag >> ((i - 1) * 8);
+	}
+	return ptr;
+}
+
+static uint8_t* emv_trace_put_len(uint8_t* ptr, size_t len)
+{
+	size_t len_len = emv_trace_len_len(len);
+
+	if (len_len == 1) {
+		*ptr++ = len;
+		return ptr;
+	}
+
+	*ptr++ = ISO8825_BER_LEN_LONG_FORM | (len_len - 1);
+	for (size_t i = len_len - 1; i > 0; --i) {
+		*ptr++ = len >> ((i - 1) * 8);
+	}
+	return ptr;
+}
+
+static uint8_t* emv_trace_put_field(
+	uint8_t* ptr,
+	unsigned int tag,
+	const void* value,
+	size_t len
+)
+{
+	ptr = emv_trace_put_tag(ptr, tag);
+	ptr = emv_trace_put_len(ptr, len);
+	if (len) {
+		memcpy(ptr, value, len);
+		ptr += len;
+	}
+	return ptr;
+}
+
+static size_t emv_trace_field_len(unsigned int tag, size_t len)
+{
+	return emv_trace_tag_len(tag) + emv_trace_len_len(len) + len;
+}
+
+static size_t emv_trace_data_len(
+	enum emv_debug_type_t debug_type,
+	const void* buf,
+	size_t buf_len
+)
+{
+	if (!buf) {
+		return 0;
+	}
+
+	if (debug_type == EMV_DEBUG_TYPE_TLV_LIST) {
+		const struct emv_tlv_list_t* list = buf;
+		size_t len = 0;
+
+		for (const struct emv_tlv_t* tlv = list->front; tlv; tlv = tlv->next) {
+			len += emv_trace_field_len(tlv->tag, tlv->length);
+		}
+		return len;
+	}
+
+	if (debug_type == EMV_DEBUG_TYPE_ATR) {
+		const struct iso7816_atr_info_t* atr_info = buf;
+		return atr_info->atr_len;
+	}
+
+	return buf_len;
+}
+
+static uint8_t* emv_trace_put_data(
+	uint8_t* ptr,
+	enum emv_debug_type_t debug_type,
+	const void* buf,
+	size_t buf_len
+)
+{
+	if (debug_type == EMV_DEBUG_TYPE_TLV_LIST) {
+		const struct emv_tlv_list_t* list = buf;
+
+		for (const struct emv_tlv_t* tlv = list->front; tlv; tlv = tlv->next) {
+			ptr = emv_trace_put_field(ptr, tlv->tag, tlv->value, tlv->length);
+		}
+		return ptr;
+	}
+
+	if (debug_type == EMV_DEBUG_TYPE_ATR) {
+		const struct iso7816_atr_info_t* atr_info = buf;
+		memcpy(ptr, atr_info->atr, atr_info->atr_len);
+		return ptr + atr_info->atr_len;
+	}
+
+	memcpy(ptr, buf, buf_len);
+	return ptr + buf_len;
+}
+
+int emv_trace_event_encode(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len,
+	void* out,
+	size_t* out_len
+)
+{
+	size_t str_len;
+	size_t data_len;
+	size_t content_len;
+	size_t event_len;
+	uint8_t* ptr;
+	uint8_t value[4];
+
+	if (!out_len) {
+		return -1;
+	}
+	if (!str) {
+		str = "";
+	}
+
+	str_len = strlen(str) + 1;
+	data_len = emv_trace_data_len(debug_type, buf, buf_len);
+	content_len =
+		emv_trace_field_len(EMV_TRACE_TAG_SOURCE, 1) +
+		emv_trace_field_len(EMV_TRACE_TAG_LEVEL, 1) +
+		emv_trace_field_len(EMV_TRACE_TAG_TYPE, 1) +
+		emv_trace_field_len(EMV_TRACE_TAG_TIMESTAMP, 4) +
+		emv_trace_field_len(EMV_TRACE_TAG_STR, str_len);
+	if (buf) {
+		content_len += emv_trace_field_len(EMV_TRACE_TAG_DATA, data_len);
+	}
+	if (content_len > 0xFFFFFFFF) {
+		return -2;
+	}
+	event_len = emv_trace_field_len(EMV_TRACE_TAG_EVENT, content_len);
+
+	if (!out || *out_len < event_len) {
+		*out_len = event_len;
+		return 1;
+	}
+
+	ptr = out;
+	ptr = emv_trace_put_tag(ptr, EMV_TRACE_TAG_EVENT);
+	ptr = emv_trace_put_len(ptr, content_len);
+
+	value[0] = source;
+	ptr = emv_trace_put_field(ptr, EMV_TRACE_TAG_SOURCE, value, 1);
+	value[0] = level;
+	ptr = emv_trace_put_field(ptr, EMV_TRACE_TAG_LEVEL, value, 1);
+	value[0] = debug_type;
+	ptr = emv_trace_put_field(ptr, EMV_TRACE_TAG_TYPE, value, 1);
+
+	value[0] = timestamp >> 24;
+	value[1] = timestamp >> 16;
+	value[2] = timestamp >> 8;
+	value[3] = timestamp;
+	ptr = emv_trace_put_field(ptr, EMV_TRACE_TAG_TIMESTAMP, value, 4);
+
+	ptr = emv_trace_put_field(ptr, EMV_TRACE_TAG_STR, str, str_len);
+
+	if (buf) {
+		ptr = emv_trace_put_tag(ptr, EMV_TRACE_TAG_DATA);
+		ptr = emv_trace_put_len(ptr, data_len);
+		ptr = emv_trace_put_data(ptr, debug_type, buf, buf_len);
+	}
+
+	*out_len = ptr - (uint8_t*)out;
+	return 0;
+}
+
+int emv_trace_header_decode(const void* ptr, size_t len)
+{
+	const uint8_t* header = ptr;
+
+	if (!ptr || len < EMV_TRACE_HEADER_LEN) {
+		return -1;
+	}
+
+	if (memcmp(header, emv_trace_magic, sizeof(emv_trace_magic)) != 0) {
+		return -2;
+	}
+
+	if (header[sizeof(emv_trace_magic)] != EMV_TRACE_VERSION) {
+		return 1;
+	}
+
+	return 0;
+}
+
+int emv_trace_event_decode(
+	const void* ptr,
+	size_t len,
+	struct emv_trace_event_t* event
+)
+{
+	int r;
+	struct iso8825_ber_itr_t itr;
+	struct iso8825_tlv_t tlv;
+	unsigned int found = 0;
+
+	if (!ptr || !event) {
+		return -1;
+	}
+	memset(event, 0, sizeof(*event));
+
+	r = iso8825_ber_itr_init(ptr, len, &itr);
+	if (r) {
+		return -2;
+	}
+
+	while ((r = iso8825_ber_itr_next(&itr, &tlv)) > 0) {
+		switch (tlv.tag) {
+			case EMV_TRACE_TAG_SOURCE:
+				if (tlv.length != 1) {
+					return 1;
+				}
+				event->source = tlv.value[0];
+				found |= 0x01;
+				break;
+
+			case EMV_TRACE_TAG_LEVEL:
+				if (tlv.length != 1) {
+					return 1;
+				}
+				event->level = tlv.value[0];
+				found |= 0x02;
+				break;
+
+			case EMV_TRACE_TAG_TYPE:
+				if (tlv.length != 1) {
+					return 1;
+				}
+				event->debug_type = tlv.value[0];
+				found |= 0x04;
+				break;
+
+			case EMV_TRACE_TAG_TIMESTAMP:
+				if (tlv.length != 4) {
+					return 1;
+				}
+				event->timestamp =
+					((uint32_t)tlv.value[0] << 24) |
+					((uint32_t)tlv.value[1] << 16) |
+					((uint32_t)tlv.value[2] << 8) |
+					tlv.value[3];
+				found |= 0x08;
+				break;
+
+			case EMV_TRACE_TAG_STR:
+				// String must be null-terminated
+				if (!tlv.length || tlv.value[tlv.length - 1] != 0) {
+					return 1;
+				}
+				event->str = (const char*)tlv.value;
+				found |= 0x10;
+				break;
+
+			case EMV_TRACE_TAG_DATA:
+				event->data = tlv.value;
+				event->data_len = tlv.length;
+				break;
+
+			default:
+				// Ignore unknown fields for forward compatibility
+				break;
+		}
+	}
+	if (r < 0) {
+		return -3;
+	}
+
+	if (found != 0x1F) {
+		// Mandatory field missing
+		return 2;
+	}
+
+	return 0;
+}
+
+int emv_trace_writer_init(struct emv_trace_writer_t* writer, FILE* file)
+{
+	uint8_t header[EMV_TRACE_HEADER_LEN];
+
+	if (!writer || !file) {
+		return -1;
+	}
+
+	memset(writer, 0, sizeof(*writer));
+	writer->file = file;
+
+	memcpy(header, emv_trace_magic, sizeof(emv_trace_magic));
+	header[sizeof(emv_trace_magic)] = EMV_TRACE_VERSION;
+	if (fwrite(header, sizeof(header), 1, file) != 1) {
+		writer->error = true;
+		return -2;
+	}
+
+	return 0;
+}
+
+int emv_trace_writer_write(
+	struct emv_trace_writer_t* writer,
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	int r;
+	uint8_t stack_buf[EMV_TRACE_EVENT_STACK_LEN];
+	uint8_t* event = stack_buf;
+	size_t event_len = sizeof(stack_buf);
+
+	if (!writer || !writer->file) {
+		return -1;
+	}
+	if (writer->error) {
+		return -2;
+	}
+
+	r = emv_trace_event_encode(
+		timestamp,
+		source,
+		level,
+		debug_type,
+		str,
+		buf,
+		buf_len,
+		event,
+		&event_len
+	);
+	if (r > 0) {
+		// Event too large for stack buffer
+		event = malloc(event_len);
+		if (!event) {
+			writer->error = true;
+			return -3;
+		}
+		r = emv_trace_event_encode(
+			timestamp,
+			source,
+			level,
+			debug_type,
+			str,
+			buf,
+			buf_len,
+			event,
+			&event_len
+		);
+	}
+	if (r) {
+		r = -4;
+		goto exit;
+	}
+
+	if (fwrite(event, event_len, 1, writer->file) != 1) {
+		writer->error = true;
+		r = -5;
+		goto exit;
+	}
+	++writer->event_count;
+	r = 0;
+
+exit:
+	if (event != stack_buf) {
+		free(event);
+	}
+	return r;
+}
+
+void emv_trace_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	struct emv_trace_writer_t* writer = emv_debug_get_user_data();
+
+	if (!writer) {
+		return;
+	}
+
+	emv_trace_writer_write(
+		writer,
+		timestamp,
+		source,
+		level,
+		debug_type,
+		str,
+		buf,
+		buf_len
+	);
+}
@@ -0,0 +1,203 @@
+/**
+ * @file emv_trace.h
+ * @brief Binary trace format for EMV debug events
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_TRACE_H
+#define EMV_TRACE_H
+
+#include "emv_debug.h"
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+__BEGIN_DECLS
+
+/**
+ * @name Binary debug trace format
+ *
+ * A trace starts with a header consisting of the 4 byte magic value "EMVD"
+ * and a 1 byte format version.
+ *
+ * Each debug event that follows the header is encoded as an ISO 8825-1 BER
+ * field with tag @ref EMV_TRACE_TAG_EVENT that contains the fields below.
+ * Multi-byte integers are big endian.
+ * - @ref EMV_TRACE_TAG_SOURCE: 1 byte debug event source
+ * - @ref EMV_TRACE_TAG_LEVEL: 1 byte debug event level
+ * - @ref EMV_TRACE_TAG_TYPE: 1 byte debug event type
+ * - @ref EMV_TRACE_TAG_TIMESTAMP: 4 byte microsecond timestamp
+ * - @ref EMV_TRACE_TAG_STR: Debug event string, including null-termination
+ * - @ref EMV_TRACE_TAG_DATA: Debug event data (optional)
+ *
+ * Debug event data is stored as is, except for
+ * @ref EMV_DEBUG_TYPE_TLV_LIST events for which the EMV TLV list is stored
+ * as concatenated BER fields and @ref EMV_DEBUG_TYPE_ATR events for which
+ * the ATR bytes are stored.
+ */
+/// @{
+#define EMV_TRACE_VERSION (1) ///< Trace format version
+#define EMV_TRACE_HEADER_LEN (5) ///< Length of trace header in bytes
+#define EMV_TRACE_TAG_EVENT (0xE1) ///< Debug event template
+#define EMV_TRACE_TAG_SOURCE (0x81) ///< Debug event source
+#define EMV_TRACE_TAG_LEVEL (0x82) ///< Debug event level
+#define EMV_TRACE_TAG_TYPE (0x83) ///< Debug event type
+#define EMV_TRACE_TAG_TIMESTAMP (0x84) ///< Debug event timestamp
+#define EMV_TRACE_TAG_STR (0x85) ///< Debug event string
+#define EMV_TRACE_TAG_DATA (0x86) ///< Debug event data
+/// @}
+
+/**
+ * Debug trace file writer
+ */
+struct emv_trace_writer_t {
+	FILE* file; ///< Output file
+	unsigned long event_count; ///< Number of events written
+	bool error; ///< Writing stopped due to memory allocation or file error
+};
+
+/**
+ * Decoded debug trace event. Pointers reference the encoded event.
+ */
+struct emv_trace_event_t {
+	uint32_t timestamp; ///< Debug event timestamp
+	enum emv_debug_source_t source; ///< Debug event source
+	enum emv_debug_level_t level; ///< Debug event level
+	enum emv_debug_type_t debug_type; ///< Debug event type
+	const char* str; ///< Null-terminated debug event string
+	const uint8_t* data; ///< Debug event data. NULL if absent.
+	size_t data_len; ///< Length of debug event data in bytes
+};
+
+/**
+ * Encode debug event. Parameters are the same as for @ref emv_debug_func_t.
+ *
+ * @param timestamp Debug event timestamp
+ * @param source Debug event source
+ * @param level Debug event level
+ * @param debug_type Debug event type
+ * @param str Debug event string
+ * @param buf Debug event data
+ * @param buf_len Length of debug event data in bytes
+ * @param out Encoded event output. NULL to determine length.
+ * @param out_len Length of output buffer in bytes, updated with length of
+ *                encoded event
+ *
+ * @return Zero for success. Less than zero for error.
+ * @return Greater than zero if output buffer is too small, in which case
+ *         @p out_len is updated with the required length.
+ */
+int emv_trace_event_encode(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len,
+	void* out,
+	size_t* out_len
+);
+
+/**
+ * Validate trace header
+ *
+ * @param ptr Trace header
+ * @param len Length of trace header in bytes
+ *
+ * @return Zero for success. Less than zero for error. Greater than zero for
+ *         unsupported format version.
+ */
+int emv_trace_header_decode(const void* ptr, size_t len);
+
+/**
+ * Decode debug event
+ *
+ * @param ptr Content of @ref EMV_TRACE_TAG_EVENT field
+ * @param len Length of content in bytes
+ * @param event Decoded debug event output
+ *
+ * @return Zero for success. Less than zero for error. Greater than zero for
+ *         invalid event.
+ */
+int emv_trace_event_decode(
+	const void* ptr,
+	size_t len,
+	struct emv_trace_event_t* event
+);
+
+/**
+ * Initialise debug trace writer and write trace header
+ *
+ * @param writer Debug trace writer
+ * @param file Output file opened in binary mode
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_trace_writer_init(struct emv_trace_writer_t* writer, FILE* file);
+
+/**
+ * Write debug event to debug trace. Parameters are the same as for
+ * @ref emv_debug_func_t. Each event is written using a single call to
+ * fwrite() such that a partially written trace only ends with an incomplete
+ * event if the file itself is truncated.
+ *
+ * @param writer Debug trace writer
+ * @param timestamp Debug event timestamp
+ * @param source Debug event source
+ * @param level Debug event level
+ * @param debug_type Debug event type
+ * @param str Debug event string
+ * @param buf Debug event data
+ * @param buf_len Length of debug event data in bytes
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_trace_writer_write(
+	struct emv_trace_writer_t* writer,
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+);
+
+/**
+ * Debug event function that writes debug events to the debug trace writer
+ * provided as user data of the debug configuration. Use this function as
+ * @ref emv_debug_config_t.func with the debug trace writer as
+ * @ref emv_debug_config_t.user_data. See @ref emv_debug_set_thread_config().
+ */
+void emv_trace_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+);
+
+__END_DECLS
+
+#endif
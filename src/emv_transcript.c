@@ -0,0 +1,663 @@
+/**
+ * @file emv_transcript.c
+ * @brief Card reader transcript recording and replay
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_transcript.h"
+#include "emv_utils_config.h"
+#include "emv.h"
+#include "emv_tlv.h"
+#include "emv_tags.h"
+#include "emv_time.h"
+#include "iso8825_ber.h"
+
+#include "crypto_mem.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t emv_transcript_magic[] = { 'E', 'M', 'V', 'T' };
+
+// Header length excluding ATR
+#define EMV_TRANSCRIPT_HEADER_LEN (sizeof(emv_transcript_magic) + 3)
+
+// Exchange length excluding frames
+#define EMV_TRANSCRIPT_EXCHANGE_LEN (4 + 2 + 2)
+
+// Terminal data that is not reproducible during replay
+static const unsigned int emv_transcript_terminal_tags[] = {
+	EMV_TAG_9A_TRANSACTION_DATE,
+	EMV_TAG_9F21_TRANSACTION_TIME,
+	EMV_TAG_9F37_UNPREDICTABLE_NUMBER,
+};
+
+static inline void emv_transcript_put_u16(uint8_t* ptr, uint16_t value)
+{
+	ptr[0] = value >> 8;
+	ptr[1] = value;
+}
+
+static inline uint16_t emv_transcript_get_u16(const uint8_t* ptr)
+{
+	return ((uint16_t)ptr[0] << 8) | ptr[1];
+}
+
+static int emv_transcript_recorder_reserve(
+	struct emv_transcript_recorder_t* recorder,
+	size_t len
+)
+{
+	size_t new_size;
+	uint8_t* new_data;
+
+	if (recorder->data_size - recorder->data_len >= len) {
+		return 0;
+	}
+
+	new_size = recorder->data_size ? recorder->data_size * 2 : 4096;
+	while (new_size - recorder->data_len < len) {
+		new_size *= 2;
+	}
+
+	// Transcript contains sensitive card data and is therefore not
+	// reallocated in place
+	new_data = malloc(new_size);
+	if (!new_data) {
+		return -1;
+	}
+	if (recorder->data) {
+		memcpy(new_data, recorder->data, recorder->data_len);
+		crypto_cleanse(recorder->data, recorder->data_size);
+		free(recorder->data);
+	}
+	recorder->data = new_data;
+	recorder->data_size = new_size;
+
+	return 0;
+}
+
+static void emv_transcript_recorder_append(
+	struct emv_transcript_recorder_t* recorder,
+	uint64_t duration_us,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	const void* rx_buf,
+	size_t rx_buf_len
+)
+{
+	int r;
+	uint8_t* ptr;
+
+	if (recorder->incomplete) {
+		// Do not record further exchanges after a recording failure
+		return;
+	}
+
+	if (tx_buf_len >= EMV_TRANSCRIPT_RX_ERROR ||
+		rx_buf_len >= EMV_TRANSCRIPT_RX_ERROR
+	) {
+		// Frame too long for transcript
+		recorder->incomplete = true;
+		return;
+	}
+
+	r = emv_transcript_recorder_reserve(
+		recorder,
+		EMV_TRANSCRIPT_EXCHANGE_LEN + tx_buf_len + rx_buf_len
+	);
+	if (r) {
+		recorder->incomplete = true;
+		return;
+	}
+
+	if (duration_us > UINT32_MAX) {
+		duration_us = UINT32_MAX;
+	}
+
+	ptr = recorder->data + recorder->data_len;
+	ptr[0] = duration_us >> 24;
+	ptr[1] = duration_us >> 16;
+	ptr[2] = duration_us >> 8;
+	ptr[3] = duration_us;
+	ptr += 4;
+
+	emv_transcript_put_u16(ptr, tx_buf_len);
+	ptr += 2;
+	memcpy(ptr, tx_buf, tx_buf_len);
+	ptr += tx_buf_len;
+
+	if (rx_buf) {
+		emv_transcript_put_u16(ptr, rx_buf_len);
+		ptr += 2;
+		memcpy(ptr, rx_buf, rx_buf_len);
+		ptr += rx_buf_len;
+	} else {
+		emv_transcript_put_u16(ptr, EMV_TRANSCRIPT_RX_ERROR);
+		ptr += 2;
+	}
+
+	recorder->data_len = ptr - recorder->data;
+	++recorder->exchange_count;
+}
+
+static int emv_transcript_recorder_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	int r;
+	struct emv_transcript_recorder_t* recorder = ctx;
+	uint64_t start_us;
+
+	start_us = emv_time_now_us();
+	r = recorder->wrapped.trx(
+		recorder->wrapped.ctx,
+		tx_buf,
+		tx_buf_len,
+		rx_buf,
+		rx_buf_len
+	);
+	emv_transcript_recorder_append(
+		recorder,
+		emv_time_now_us() - start_us,
+		tx_buf,
+		tx_buf_len,
+		r ? NULL : rx_buf,
+		r ? 0 : *rx_buf_len
+	);
+
+	return r;
+}
+
+static void emv_transcript_recorder_complete(
+	void* complete_ctx,
+	int result,
+	size_t rx_buf_len
+)
+{
+	struct emv_transcript_recorder_t* recorder = complete_ctx;
+	emv_cardreader_complete_t complete;
+
+	emv_transcript_recorder_append(
+		recorder,
+		emv_time_now_us() - recorder->start_us,
+		recorder->tx_buf,
+		recorder->tx_buf_len,
+		result ? NULL : recorder->rx_buf,
+		result ? 0 : rx_buf_len
+	);
+
+	// Completion function may submit the next exchange
+	complete = recorder->complete;
+	recorder->complete = NULL;
+	complete(recorder->complete_ctx, result, rx_buf_len);
+}
+
+static int emv_transcript_recorder_submit(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t rx_buf_len,
+	emv_cardreader_complete_t complete,
+	void* complete_ctx
+)
+{
+	int r;
+	struct emv_transcript_recorder_t* recorder = ctx;
+
+	if (recorder->complete) {
+		// Only a single asynchronous exchange may be pending
+		return -1;
+	}
+
+	recorder->tx_buf = tx_buf;
+	recorder->tx_buf_len = tx_buf_len;
+	recorder->rx_buf = rx_buf;
+	recorder->start_us = emv_time_now_us();
+	recorder->complete = complete;
+	recorder->complete_ctx = complete_ctx;
+
+	r = recorder->wrapped.submit(
+		recorder->wrapped.ctx,
+		tx_buf,
+		tx_buf_len,
+		rx_buf,
+		rx_buf_len,
+		&emv_transcript_recorder_complete,
+		recorder
+	);
+	if (r) {
+		// Completion function will not be invoked
+		recorder->complete = NULL;
+		emv_transcript_recorder_append(
+			recorder,
+			emv_time_now_us() - recorder->start_us,
+			tx_buf,
+			tx_buf_len,
+			NULL,
+			0
+		);
+	}
+
+	return r;
+}
+
+int emv_transcript_recorder_init(
+	struct emv_transcript_recorder_t* recorder,
+	struct emv_cardreader_t* cardreader,
+	const uint8_t* atr,
+	size_t atr_len
+)
+{
+	int r;
+	uint8_t* ptr;
+
+	if (!recorder || !cardreader || !cardreader->trx) {
+		return -1;
+	}
+	if (!atr) {
+		atr_len = 0;
+	}
+	if (atr_len > EMV_TRANSCRIPT_ATR_MAX) {
+		return -2;
+	}
+
+	memset(recorder, 0, sizeof(*recorder));
+	r = emv_transcript_recorder_reserve(recorder, EMV_TRANSCRIPT_HEADER_LEN + atr_len);
+	if (r) {
+		return -3;
+	}
+
+	ptr = recorder->data;
+	memcpy(ptr, emv_transcript_magic, sizeof(emv_transcript_magic));
+	ptr += sizeof(emv_transcript_magic);
+	*ptr++ = EMV_TRANSCRIPT_VERSION;
+	*ptr++ = cardreader->mode;
+	*ptr++ = atr_len;
+	if (atr_len) {
+		memcpy(ptr, atr, atr_len);
+		ptr += atr_len;
+	}
+	recorder->data_len = ptr - recorder->data;
+
+	// Wrap card reader
+	recorder->cardreader = cardreader;
+	recorder->wrapped = *cardreader;
+	cardreader->ctx = recorder;
+	cardreader->trx = &emv_transcript_recorder_trx;
+	if (recorder->wrapped.submit) {
+		cardreader->submit = &emv_transcript_recorder_submit;
+	}
+
+	return 0;
+}
+
+int emv_transcript_recorder_clear(struct emv_transcript_recorder_t* recorder)
+{
+	if (!recorder) {
+		return -1;
+	}
+
+	if (recorder->cardreader) {
+		// Restore the wrapped card reader functions but retain the card
+		// reader mode because it may have been updated during recording by
+		// emv_ttl_select_protocol()
+		recorder->cardreader->ctx = recorder->wrapped.ctx;
+		recorder->cardreader->trx = recorder->wrapped.trx;
+		recorder->cardreader->submit = recorder->wrapped.submit;
+	}
+	if (recorder->data) {
+		crypto_cleanse(recorder->data, recorder->data_size);
+		free(recorder->data);
+	}
+	memset(recorder, 0, sizeof(*recorder));
+
+	return 0;
+}
+
+int emv_transcript_recorder_add_terminal_data(
+	struct emv_transcript_recorder_t* recorder,
+	const struct emv_ctx_t* ctx
+)
+{
+	int r;
+	struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
+	const struct emv_tlv_t* tlv;
+	size_t terminal_data_len = 0;
+	uint8_t* ptr;
+
+	if (!recorder || !recorder->data || !ctx) {
+		return -1;
+	}
+
+	if (recorder->incomplete) {
+		// Do not record further entries after a recording failure
+		return 0;
+	}
+
+	r = emv_tlv_sources_init_from_ctx(&sources, ctx);
+	if (r) {
+		return -2;
+	}
+
+	for (size_t i = 0; i < sizeof(emv_transcript_terminal_tags) / sizeof(emv_transcript_terminal_tags[0]); ++i) {
+		tlv = emv_tlv_sources_find_const(&sources, emv_transcript_terminal_tags[i]);
+		if (!tlv) {
+			continue;
+		}
+		if (tlv->length > 0x7F) {
+			// Only short form lengths are expected for these fields
+			return -3;
+		}
+		terminal_data_len += (tlv->tag > 0xFF ? 2 : 1) + 1 + tlv->length;
+	}
+
+	r = emv_transcript_recorder_reserve(
+		recorder,
+		EMV_TRANSCRIPT_EXCHANGE_LEN + terminal_data_len
+	);
+	if (r) {
+		recorder->incomplete = true;
+		return 0;
+	}
+
+	ptr = recorder->data + recorder->data_len;
+	memset(ptr, 0, 4); // Zero duration
+	ptr += 4;
+	emv_transcript_put_u16(ptr, EMV_TRANSCRIPT_TERMINAL_DATA);
+	ptr += 2;
+	emv_transcript_put_u16(ptr, terminal_data_len);
+	ptr += 2;
+
+	for (size_t i = 0; i < sizeof(emv_transcript_terminal_tags) / sizeof(emv_transcript_terminal_tags[0]); ++i) {
+		tlv = emv_tlv_sources_find_const(&sources, emv_transcript_terminal_tags[i]);
+		if (!tlv) {
+			continue;
+		}
+		if (tlv->tag > 0xFF) {
+			*ptr++ = tlv->tag >> 8;
+		}
+		*ptr++ = tlv->tag;
+		*ptr++ = tlv->length;
+		memcpy(ptr, tlv->value, tlv->length);
+		ptr += tlv->length;
+	}
+
+	recorder->data_len = ptr - recorder->data;
+
+	return 0;
+}
+
+static void emv_transcript_replayer_skip_terminal_data(
+	struct emv_transcript_replayer_t* replayer
+)
+{
+	const uint8_t* ptr;
+
+	// Terminal data entries are not exchanges and are only used by
+	// emv_transcript_replayer_load_terminal_data()
+	while (replayer->offset < replayer->data_len) {
+		ptr = replayer->data + replayer->offset + 4;
+		if (emv_transcript_get_u16(ptr) != EMV_TRANSCRIPT_TERMINAL_DATA) {
+			break;
+		}
+		replayer->offset += EMV_TRANSCRIPT_EXCHANGE_LEN + emv_transcript_get_u16(ptr + 2);
+	}
+}
+
+static int emv_transcript_replayer_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	struct emv_transcript_replayer_t* replayer = ctx;
+	const uint8_t* ptr;
+	size_t c_len;
+	size_t r_len;
+
+	if (replayer->offset >= replayer->data_len) {
+		// No more exchanges
+		return -1;
+	}
+
+	// Transcript was validated by emv_transcript_replayer_init() and
+	// therefore lengths need not be validated again
+	ptr = replayer->data + replayer->offset + 4;
+	c_len = emv_transcript_get_u16(ptr);
+	ptr += 2;
+	if (c_len != tx_buf_len || memcmp(ptr, tx_buf, c_len) != 0) {
+		// Transmitted frame differs from transcript
+		return -2;
+	}
+	ptr += c_len;
+	r_len = emv_transcript_get_u16(ptr);
+	ptr += 2;
+
+	if (r_len == EMV_TRANSCRIPT_RX_ERROR) {
+		// Recorded card reader error
+		replayer->offset = ptr - replayer->data;
+		emv_transcript_replayer_skip_terminal_data(replayer);
+		return -3;
+	}
+	if (r_len > *rx_buf_len) {
+		return -4;
+	}
+
+	memcpy(rx_buf, ptr, r_len);
+	*rx_buf_len = r_len;
+	replayer->offset = (ptr + r_len) - replayer->data;
+	emv_transcript_replayer_skip_terminal_data(replayer);
+
+	return 0;
+}
+
+int emv_transcript_replayer_init(
+	struct emv_transcript_replayer_t* replayer,
+	const void* data,
+	size_t data_len,
+	struct emv_cardreader_t* cardreader
+)
+{
+	const uint8_t* ptr = data;
+	size_t offset;
+	uint8_t mode;
+	size_t atr_len;
+
+	if (!replayer || !data || !cardreader) {
+		return -1;
+	}
+
+	memset(replayer, 0, sizeof(*replayer));
+
+	// Validate header
+	if (data_len < EMV_TRANSCRIPT_HEADER_LEN ||
+		memcmp(ptr, emv_transcript_magic, sizeof(emv_transcript_magic)) != 0
+	) {
+		return 1;
+	}
+	offset = sizeof(emv_transcript_magic);
+	if (ptr[offset] != EMV_TRANSCRIPT_VERSION) {
+		return 2;
+	}
+	mode = ptr[offset + 1];
+	if (mode != EMV_CARDREADER_MODE_APDU &&
+		mode != EMV_CARDREADER_MODE_TPDU &&
+		mode != EMV_CARDREADER_MODE_TPDU_T1
+	) {
+		return 3;
+	}
+	atr_len = ptr[offset + 2];
+	offset += 3;
+	if (atr_len > EMV_TRANSCRIPT_ATR_MAX || data_len - offset < atr_len) {
+		return 4;
+	}
+	memcpy(replayer->atr, ptr + offset, atr_len);
+	replayer->atr_len = atr_len;
+	offset += atr_len;
+	replayer->first_offset = offset;
+
+	// Validate exchanges
+	while (offset < data_len) {
+		size_t c_len;
+		size_t r_len;
+
+		if (data_len - offset < EMV_TRANSCRIPT_EXCHANGE_LEN) {
+			return 5;
+		}
+		offset += 4;
+
+		c_len = emv_transcript_get_u16(ptr + offset);
+		offset += 2;
+		if (c_len == EMV_TRANSCRIPT_TERMINAL_DATA) {
+			struct iso8825_ber_itr_t itr;
+			struct iso8825_tlv_t tlv;
+			size_t terminal_data_len;
+			int r;
+
+			terminal_data_len = emv_transcript_get_u16(ptr + offset);
+			offset += 2;
+			if (data_len - offset < terminal_data_len) {
+				return 8;
+			}
+
+			// Validate terminal data
+			r = iso8825_ber_itr_init(ptr + offset, terminal_data_len, &itr);
+			if (r) {
+				return 9;
+			}
+			while ((r = iso8825_ber_itr_next(&itr, &tlv)) > 0);
+			if (r < 0) {
+				return 9;
+			}
+
+			// Use the last terminal data entry
+			replayer->terminal_data = ptr + offset;
+			replayer->terminal_data_len = terminal_data_len;
+			offset += terminal_data_len;
+			continue;
+		}
+		if (data_len - offset < c_len + 2) {
+			return 6;
+		}
+		offset += c_len;
+
+		r_len = emv_transcript_get_u16(ptr + offset);
+		offset += 2;
+		if (r_len == EMV_TRANSCRIPT_RX_ERROR) {
+			r_len = 0;
+		}
+		if (data_len - offset < r_len) {
+			return 7;
+		}
+		offset += r_len;
+
+		++replayer->exchange_count;
+	}
+
+	replayer->data = data;
+	replayer->data_len = data_len;
+	replayer->offset = replayer->first_offset;
+	emv_transcript_replayer_skip_terminal_data(replayer);
+
+	cardreader->mode = mode;
+	cardreader->ctx = replayer;
+	cardreader->trx = &emv_transcript_replayer_trx;
+	cardreader->submit = NULL;
+
+	return 0;
+}
+
+int emv_transcript_replayer_rewind(struct emv_transcript_replayer_t* replayer)
+{
+	if (!replayer || !replayer->data) {
+		return -1;
+	}
+
+	replayer->offset = replayer->first_offset;
+	emv_transcript_replayer_skip_terminal_data(replayer);
+
+	return 0;
+}
+
+bool emv_transcript_replayer_is_complete(const struct emv_transcript_replayer_t* replayer)
+{
+	if (!replayer || !replayer->data) {
+		return false;
+	}
+
+	return replayer->offset >= replayer->data_len;
+}
+
+int emv_transcript_replayer_load_terminal_data(
+	const struct emv_transcript_replayer_t* replayer,
+	struct emv_ctx_t* ctx
+)
+{
+	int r;
+	struct iso8825_ber_itr_t itr;
+	struct iso8825_tlv_t tlv;
+
+	if (!replayer || !replayer->data || !ctx) {
+		return -1;
+	}
+
+	if (!replayer->terminal_data) {
+		// Transcript has no terminal data
+		return 1;
+	}
+
+	// Terminal data was validated by emv_transcript_replayer_init()
+	r = iso8825_ber_itr_init(replayer->terminal_data, replayer->terminal_data_len, &itr);
+	if (r) {
+		return -2;
+	}
+	while ((r = iso8825_ber_itr_next(&itr, &tlv)) > 0) {
+		struct emv_tlv_t* param;
+
+		param = emv_tlv_list_find(&ctx->params, tlv.tag);
+		if (param) {
+			if (param->length != tlv.length) {
+				// Existing transaction parameter cannot be replaced
+				return -3;
+			}
+			memcpy(param->value, tlv.value, tlv.length);
+			continue;
+		}
+
+		r = emv_tlv_list_push(&ctx->params, tlv.tag, tlv.length, tlv.value, 0);
+		if (r) {
+			return -4;
+		}
+	}
+	if (r < 0) {
+		return -5;
+	}
+
+	return 0;
+}
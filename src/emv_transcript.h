@@ -0,0 +1,245 @@
+/**
+ * @file emv_transcript.h
+ * @brief Card reader transcript recording and replay
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_TRANSCRIPT_H
+#define EMV_TRANSCRIPT_H
+
+#include "emv_ttl.h"
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+// Forward declarations
+struct emv_ctx_t;
+
+/**
+ * @name Card reader transcript format
+ *
+ * A transcript starts with a header consisting of the 4 byte magic value
+ * "EMVT", a 1 byte format version, a 1 byte card reader mode at the start of
+ * recording (see @ref emv_cardreader_mode_t), a 1 byte ATR length and the
+ * ATR itself.
+ *
+ * Each exchange that follows the header consists of a 4 byte duration in
+ * microseconds, a 2 byte transmitted frame length, the transmitted frame, a
+ * 2 byte received frame length and the received frame. A received frame
+ * length of @ref EMV_TRANSCRIPT_RX_ERROR indicates that the card reader
+ * transceive function failed and is not followed by a received frame.
+ *
+ * An exchange with a transmitted frame length of
+ * @ref EMV_TRANSCRIPT_TERMINAL_DATA is instead a terminal data entry that
+ * consists of a zero duration, the marker, a 2 byte data length and BER-TLV
+ * encoded terminal data. See @ref emv_transcript_recorder_add_terminal_data().
+ *
+ * All lengths and durations are big endian.
+ */
+/// @{
+#define EMV_TRANSCRIPT_VERSION (1) ///< Transcript format version
+#define EMV_TRANSCRIPT_ATR_MAX (33) ///< Maximum length of ATR in bytes
+#define EMV_TRANSCRIPT_RX_ERROR (0xFFFF) ///< Received frame length for card reader error
+#define EMV_TRANSCRIPT_TERMINAL_DATA (0xFFFF) ///< Transmitted frame length for terminal data entry
+/// @}
+
+/**
+ * Card reader transcript recorder
+ *
+ * The recorder wraps an existing card reader such that all exchanges,
+ * including asynchronous exchanges, are appended to @ref data before being
+ * returned to the caller.
+ */
+struct emv_transcript_recorder_t {
+	uint8_t* data; ///< Transcript data
+	size_t data_len; ///< Length of transcript data in bytes
+	unsigned int exchange_count; ///< Number of recorded exchanges
+	bool incomplete; ///< Recording stopped due to memory allocation failure or oversized frame
+
+	/// @cond INTERNAL
+	size_t data_size;
+	struct emv_cardreader_t* cardreader;
+	struct emv_cardreader_t wrapped;
+
+	// Pending asynchronous exchange
+	const void* tx_buf;
+	size_t tx_buf_len;
+	void* rx_buf;
+	uint64_t start_us;
+	emv_cardreader_complete_t complete;
+	void* complete_ctx;
+	/// @endcond
+};
+
+/**
+ * Card reader transcript replayer
+ *
+ * The replayer provides a card reader that responds to each exchange using
+ * the next exchange of a recorded transcript, without any delay. The
+ * transmitted frame must match the recorded frame exactly and therefore
+ * terminal data that is requested by the card using a Data Object List (DOL)
+ * must match the recorded transaction. Use
+ * @ref emv_transcript_replayer_load_terminal_data() to apply the recorded
+ * terminal data before replaying a transaction.
+ */
+struct emv_transcript_replayer_t {
+	uint8_t atr[EMV_TRANSCRIPT_ATR_MAX]; ///< Recorded Answer-To-Reset (ATR)
+	size_t atr_len; ///< Length of recorded ATR in bytes
+	unsigned int exchange_count; ///< Number of exchanges in transcript
+
+	/// @cond INTERNAL
+	const uint8_t* data;
+	size_t data_len;
+	size_t first_offset;
+	size_t offset;
+	const uint8_t* terminal_data;
+	size_t terminal_data_len;
+	/// @endcond
+};
+
+/**
+ * Start recording the exchanges of a card reader. The card reader is
+ * modified to use the recorder and is restored by
+ * @ref emv_transcript_recorder_clear().
+ *
+ * @note For TPDU mode, start recording before @ref emv_ttl_select_protocol()
+ *       such that the protocol T=1 IFSD negotiation is part of the
+ *       transcript. The card reader mode selected during recording is
+ *       retained by @ref emv_transcript_recorder_clear().
+ *
+ * @param recorder Transcript recorder
+ * @param cardreader Card reader to record. Typically @ref emv_ttl_t.cardreader
+ * @param atr Answer-To-Reset (ATR) of current card. May be NULL.
+ * @param atr_len Length of ATR in bytes
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_transcript_recorder_init(
+	struct emv_transcript_recorder_t* recorder,
+	struct emv_cardreader_t* cardreader,
+	const uint8_t* atr,
+	size_t atr_len
+);
+
+/**
+ * Stop recording, restore the card reader provided to
+ * @ref emv_transcript_recorder_init() and release the transcript data.
+ *
+ * @param recorder Transcript recorder
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_transcript_recorder_clear(struct emv_transcript_recorder_t* recorder);
+
+/**
+ * Record the terminal data of the current transaction that is not
+ * reproducible during replay. This consists of the Transaction Date
+ * (field 9A), Transaction Time (field 9F21) and Unpredictable Number
+ * (field 9F37), if available, that may be requested by the card using a
+ * Data Object List (DOL).
+ *
+ * @note Call this function after the transaction, or at least after
+ *       @ref emv_initiate_application_processing(), and before saving the
+ *       transcript data.
+ *
+ * @param recorder Transcript recorder
+ * @param ctx EMV processing context
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_transcript_recorder_add_terminal_data(
+	struct emv_transcript_recorder_t* recorder,
+	const struct emv_ctx_t* ctx
+);
+
+/**
+ * Prepare to replay a recorded transcript. The transcript is validated and
+ * the card reader is populated such that it replays the transcript. The
+ * transcript data is not copied and must remain valid until replay is
+ * complete.
+ *
+ * @note If recording started before @ref emv_ttl_select_protocol(), call it
+ *       again with the recorded ATR to replay the protocol selection. If
+ *       recording started in @ref EMV_CARDREADER_MODE_TPDU_T1 mode, the
+ *       protocol T=1 state of the TTL must match that at the start of
+ *       recording. See @ref emv_ttl_t.t1.
+ *
+ * @param replayer Transcript replayer
+ * @param data Transcript data
+ * @param data_len Length of transcript data in bytes
+ * @param cardreader Card reader to populate. Typically @ref emv_ttl_t.cardreader
+ *
+ * @return Zero for success
+ * @return Less than zero for error
+ * @return Greater than zero for invalid transcript
+ */
+int emv_transcript_replayer_init(
+	struct emv_transcript_replayer_t* replayer,
+	const void* data,
+	size_t data_len,
+	struct emv_cardreader_t* cardreader
+);
+
+/**
+ * Restart replay from the first exchange of the transcript. This allows the
+ * same transcript to be replayed many times without validating it again.
+ *
+ * @param replayer Transcript replayer
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_transcript_replayer_rewind(struct emv_transcript_replayer_t* replayer);
+
+/**
+ * Determine whether all exchanges of the transcript have been replayed
+ *
+ * @param replayer Transcript replayer
+ *
+ * @return Boolean indicating whether replay is complete
+ */
+bool emv_transcript_replayer_is_complete(const struct emv_transcript_replayer_t* replayer);
+
+/**
+ * Apply the terminal data recorded by
+ * @ref emv_transcript_recorder_add_terminal_data() to the transaction
+ * parameters such that the Data Object List (DOL) data of the replayed
+ * transaction matches the recorded transaction. Existing transaction
+ * parameters with the same tag are replaced.
+ *
+ * @note Call this function after populating @ref emv_ctx_t.params and
+ *       before @ref emv_initiate_application_processing().
+ *
+ * @param replayer Transcript replayer
+ * @param ctx EMV processing context
+ *
+ * @return Zero for success
+ * @return Less than zero for error
+ * @return Greater than zero if transcript has no terminal data
+ */
+int emv_transcript_replayer_load_terminal_data(
+	const struct emv_transcript_replayer_t* replayer,
+	struct emv_ctx_t* ctx
+);
+
+__END_DECLS
+
+#endif
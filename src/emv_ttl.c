@@ -2,7 +2,7 @@
  * @file emv_ttl.c
  * @brief EMV Terminal Transport Layer (TTL)
  *
- * Copyright 2021, 2024-2025 Leon Lynch
+ * Copyright 2021, 2024-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -20,7 +20,10 @@
  */
 
 #include "emv_ttl.h"
+#include "emv_utils_config.h"
+#include "emv_time.h"
 #include "emv_tags.h"
+#include "iso7816.h"
 #include "iso7816_apdu.h"
 
 #define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_TTL
@@ -29,7 +32,240 @@
 #include <stdbool.h>
 #include <string.h>
 
-int emv_ttl_trx(
+// Protocol T=1 block fields
+// See ISO 7816-3:2006, 11.3
+// See EMV Contact Interface Specification v1.0, 9.2.4.1
+#define EMV_TTL_T1_NAD                  (0x00) ///< Node address. Must be zero for EMV.
+#define EMV_TTL_T1_PCB_I_NS             (0x40) ///< I-block send-sequence number N(S)
+#define EMV_TTL_T1_PCB_I_M              (0x20) ///< I-block more-data bit (chaining)
+#define EMV_TTL_T1_PCB_R                (0x80) ///< R-block indicator
+#define EMV_TTL_T1_PCB_R_NR             (0x10) ///< R-block send-sequence number N(R)
+#define EMV_TTL_T1_PCB_R_ERR_EDC        (0x01) ///< R-block error: EDC and/or parity error
+#define EMV_TTL_T1_PCB_R_ERR_OTHER      (0x02) ///< R-block error: Other error
+#define EMV_TTL_T1_PCB_S                (0xC0) ///< S-block indicator
+#define EMV_TTL_T1_PCB_S_RESPONSE       (0x20) ///< S-block response bit
+#define EMV_TTL_T1_PCB_S_TYPE_MASK      (0x1F) ///< S-block type mask
+#define EMV_TTL_T1_PCB_S_RESYNCH        (0x00) ///< S-block type: RESYNCH
+#define EMV_TTL_T1_PCB_S_IFS            (0x01) ///< S-block type: IFS
+#define EMV_TTL_T1_PCB_S_ABORT          (0x02) ///< S-block type: ABORT
+#define EMV_TTL_T1_PCB_S_WTX            (0x03) ///< S-block type: WTX
+
+// Maximum number of consecutive retransmissions for protocol T=1
+// See EMV Contact Interface Specification v1.0, 9.2.5.1
+#define EMV_TTL_T1_RETRIES_MAX          (2)
+
+static enum emv_ttl_cmd_t emv_ttl_cmd_from_ins(uint8_t INS)
+{
+	switch (INS) {
+		case 0xA4: return EMV_TTL_CMD_SELECT;
+		case 0xB2: return EMV_TTL_CMD_READ_RECORD;
+		case 0xA8: return EMV_TTL_CMD_GPO;
+		case 0xCA: return EMV_TTL_CMD_GET_DATA;
+		case 0x88: return EMV_TTL_CMD_INTERNAL_AUTHENTICATE;
+		case 0xAE: return EMV_TTL_CMD_GENAC;
+		default: return EMV_TTL_CMD_OTHER;
+	}
+}
+
+static inline void emv_ttl_stats_tx(struct emv_ttl_trx_state_t* state)
+{
+	++state->exchange_count;
+	state->tx_bytes += state->tx_buf_len;
+}
+
+static inline void emv_ttl_stats_rx(struct emv_ttl_trx_state_t* state, size_t rx_len)
+{
+	state->rx_bytes += rx_len;
+}
+
+static int emv_ttl_stats_finish(struct emv_ttl_trx_state_t* state, int r)
+{
+	struct emv_ttl_cmd_stats_t* stats;
+	uint64_t latency_us;
+	uint64_t latency_ms;
+	unsigned int bucket;
+
+	// Statistics are only committed when the command completes such that the
+	// card reader may decide whether the command should be counted
+	if (!state->ttl->stats) {
+		return r;
+	}
+	stats = &state->ttl->stats->cmd[state->cmd];
+
+	latency_us = emv_time_now_us() - state->start_us;
+	if (!stats->count || latency_us < stats->min_us) {
+		stats->min_us = latency_us;
+	}
+	if (latency_us > stats->max_us) {
+		stats->max_us = latency_us;
+	}
+	stats->total_us += latency_us;
+	++stats->count;
+	if (r) {
+		++stats->error_count;
+	}
+	stats->exchange_count += state->exchange_count;
+	stats->get_response_count += state->get_response_count;
+	stats->tx_bytes += state->tx_bytes;
+	stats->rx_bytes += state->rx_bytes;
+
+	// Bucket is the bit length of the latency in milliseconds
+	latency_ms = latency_us / 1000;
+	for (bucket = 0; latency_ms && bucket < EMV_TTL_STATS_HISTOGRAM_BUCKETS - 1; ++bucket) {
+		latency_ms >>= 1;
+	}
+	++stats->histogram[bucket];
+
+	return r;
+}
+
+int emv_ttl_init(struct emv_ttl_t* ctx)
+{
+	if (!ctx) {
+		return -1;
+	}
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	return 0;
+}
+
+int emv_ttl_set_stats(struct emv_ttl_t* ctx, struct emv_ttl_stats_t* stats)
+{
+	if (!ctx) {
+		return -1;
+	}
+
+	ctx->stats = stats;
+
+	return 0;
+}
+
+void emv_ttl_stats_reset(struct emv_ttl_stats_t* stats)
+{
+	if (!stats) {
+		return;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+}
+
+const char* emv_ttl_cmd_get_string(enum emv_ttl_cmd_t cmd)
+{
+	switch (cmd) {
+		case EMV_TTL_CMD_SELECT: return "SELECT";
+		case EMV_TTL_CMD_READ_RECORD: return "READ RECORD";
+		case EMV_TTL_CMD_GPO: return "GET PROCESSING OPTIONS";
+		case EMV_TTL_CMD_GET_DATA: return "GET DATA";
+		case EMV_TTL_CMD_INTERNAL_AUTHENTICATE: return "INTERNAL AUTHENTICATE";
+		case EMV_TTL_CMD_GENAC: return "GENERATE AC";
+		case EMV_TTL_CMD_OTHER: return "Other";
+		default: return "Unknown";
+	}
+}
+
+static size_t emv_ttl_t1_build_block(
+	uint8_t* block,
+	uint8_t pcb,
+	const void* inf,
+	size_t inf_len
+)
+{
+	uint8_t lrc = 0;
+
+	// Prologue field
+	block[0] = EMV_TTL_T1_NAD;
+	block[1] = pcb;
+	block[2] = inf_len;
+
+	// Information field
+	if (inf_len) {
+		memcpy(block + 3, inf, inf_len);
+	}
+
+	// Epilogue field using LRC
+	// See ISO 7816-3:2006, 11.4.4
+	for (size_t i = 0; i < 3 + inf_len; ++i) {
+		lrc ^= block[i];
+	}
+	block[3 + inf_len] = lrc;
+
+	return 3 + inf_len + 1;
+}
+
+static bool emv_ttl_t1_block_is_valid(const uint8_t* block, size_t block_len)
+{
+	uint8_t lrc = 0;
+
+	// See EMV Contact Interface Specification v1.0, 9.2.4.1
+	if (block_len < 4 ||
+		block[0] != EMV_TTL_T1_NAD ||
+		block[2] == 0xFF ||
+		block_len != 3 + (size_t)block[2] + 1
+	) {
+		return false;
+	}
+
+	for (size_t i = 0; i < block_len; ++i) {
+		lrc ^= block[i];
+	}
+	return lrc == 0;
+}
+
+static void emv_ttl_t1_tx_iblock(struct emv_ttl_trx_state_t* state)
+{
+	struct emv_ttl_t1_t* t1 = &state->ttl->t1;
+	size_t inf_len;
+	uint8_t pcb;
+
+	// Chain C-APDU if it exceeds IFSC
+	// See ISO 7816-3:2006, 11.6.2.3
+	inf_len = state->c_apdu_len - state->t1_tx_offset;
+	if (inf_len > t1->ifsc) {
+		inf_len = t1->ifsc;
+	}
+	state->t1_tx_chaining = state->t1_tx_offset + inf_len < state->c_apdu_len;
+
+	pcb = t1->ns ? EMV_TTL_T1_PCB_I_NS : 0;
+	if (state->t1_tx_chaining) {
+		pcb |= EMV_TTL_T1_PCB_I_M;
+	}
+	state->tx_buf = state->t1_block;
+	state->tx_buf_len = emv_ttl_t1_build_block(
+		state->t1_block,
+		pcb,
+		state->c_apdu + state->t1_tx_offset,
+		inf_len
+	);
+	state->t1_tx_offset += inf_len;
+	t1->ns ^= 1;
+}
+
+static void emv_ttl_t1_tx_rblock(struct emv_ttl_trx_state_t* state, uint8_t error)
+{
+	uint8_t pcb;
+
+	pcb = EMV_TTL_T1_PCB_R | error;
+	if (state->ttl->t1.nr) {
+		pcb |= EMV_TTL_T1_PCB_R_NR;
+	}
+	state->tx_buf = state->t1_block;
+	state->tx_buf_len = emv_ttl_t1_build_block(state->t1_block, pcb, NULL, 0);
+}
+
+static void emv_ttl_t1_tx_sblock(
+	struct emv_ttl_trx_state_t* state,
+	uint8_t pcb,
+	const void* inf,
+	size_t inf_len
+)
+{
+	state->tx_buf = state->t1_block;
+	state->tx_buf_len = emv_ttl_t1_build_block(state->t1_block, pcb, inf, inf_len);
+}
+
+static int emv_ttl_trx_begin(
+	struct emv_ttl_trx_state_t* state,
 	struct emv_ttl_t* ctx,
 	const void* c_apdu,
 	size_t c_apdu_len,
@@ -40,18 +276,6 @@ int emv_ttl_trx(
 {
 	enum iso7816_apdu_case_t apdu_case;
 
-	// C-TPDU header: CLA INS P1 P2 P3
-	uint8_t c_tpdu_header[5];
-	// C-TPDU data: found after P3; NULL if absent
-	const void* c_tpdu_data = NULL;
-
-	// Next buffer to transmit
-	const void* tx_buf;
-	size_t tx_buf_len;
-
-	// Current position in R-APDU output
-	uint8_t* r_apdu_ptr = r_apdu;
-
 	if (!ctx || !c_apdu || !c_apdu_len || !r_apdu || !r_apdu_len || !*r_apdu_len || !sw1sw2) {
 		return -1;
 	}
@@ -81,32 +305,58 @@ int emv_ttl_trx(
 			return -2;
 	}
 
+	state->ttl = ctx;
+	state->apdu_case = apdu_case;
+	state->c_apdu = c_apdu;
+	state->c_apdu_len = c_apdu_len;
+	state->c_tpdu_data = NULL;
+	state->r_apdu = r_apdu;
+	state->r_apdu_ptr = r_apdu;
+	state->r_apdu_len = r_apdu_len;
+	state->sw1sw2 = sw1sw2;
+
+	state->cmd = emv_ttl_cmd_from_ins(state->c_apdu[1]);
+	state->exchange_count = 0;
+	state->get_response_count = 0;
+	state->tx_bytes = 0;
+	state->rx_bytes = 0;
+	state->start_us = emv_time_now_us();
+
 	if (ctx->cardreader.mode == EMV_CARDREADER_MODE_APDU) {
 		// For APDU mode, transmit C-APDU as-is
-		tx_buf = c_apdu;
-		tx_buf_len = c_apdu_len;
+		state->tx_buf = c_apdu;
+		state->tx_buf_len = c_apdu_len;
 
 	} else if (ctx->cardreader.mode == EMV_CARDREADER_MODE_TPDU) {
 		// For TPDU mode, transmit C-TPDU header and wait for procedure byte
 
 		if (apdu_case == ISO7816_APDU_CASE_1) {
 			// Build case 1 C-TPDU header
-			memcpy(c_tpdu_header, c_apdu, 4);
-			c_tpdu_header[4] = 0; // P3 = 0
+			memcpy(state->c_tpdu_header, c_apdu, 4);
+			state->c_tpdu_header[4] = 0; // P3 = 0
 		} else {
 			// Build case 2S/3S/4S C-TPDU header
-			memcpy(c_tpdu_header, c_apdu, 5);
+			memcpy(state->c_tpdu_header, c_apdu, 5);
 		}
 
 		if (apdu_case == ISO7816_APDU_CASE_3S ||
 			apdu_case == ISO7816_APDU_CASE_4S
 		) {
 			// Locate C-TPDU data
-			c_tpdu_data = c_apdu + 5;
+			state->c_tpdu_data = state->c_apdu + 5;
 		}
 
-		tx_buf = c_tpdu_header;
-		tx_buf_len = sizeof(c_tpdu_header);
+		state->tx_buf = state->c_tpdu_header;
+		state->tx_buf_len = sizeof(state->c_tpdu_header);
+
+	} else if (ctx->cardreader.mode == EMV_CARDREADER_MODE_TPDU_T1) {
+		// For protocol T=1, transmit C-APDU as-is using one or more
+		// I-blocks and let the R-APDU be assembled from the ICC I-blocks
+		// See ISO 7816-3:2006, 12.1.1
+		// See EMV Contact Interface Specification v1.0, 9.3.2
+		state->t1_tx_offset = 0;
+		state->t1_retries = 0;
+		emv_ttl_t1_tx_iblock(state);
 
 	} else {
 		// Unknown cardreader mode
@@ -116,311 +366,690 @@ int emv_ttl_trx(
 	// Clear SW1-SW2 to allow it to be checked later
 	*sw1sw2 = 0;
 
-	do {
-		int r;
-		uint8_t INS;
-		uint8_t rx_buf[EMV_RAPDU_MAX];
-		size_t rx_len = sizeof(rx_buf);
-		uint8_t SW1;
-		uint8_t SW2;
-		bool tx_get_response = false;
-		bool tx_update_le  = false;
+	return 0;
+}
 
-		emv_debug_ctpdu(tx_buf, tx_buf_len);
+static int emv_ttl_trx_process_t1(
+	struct emv_ttl_trx_state_t* state,
+	size_t rx_len,
+	bool* tx_next
+)
+{
+	struct emv_ttl_t1_t* t1 = &state->ttl->t1;
+	const uint8_t* rx_buf = state->rx_buf;
+	uint8_t pcb;
+	size_t inf_len;
+
+	if (!emv_ttl_t1_block_is_valid(rx_buf, rx_len)) {
+		// Request retransmission of invalid block
+		// See ISO 7816-3:2006, 11.6.3.2, rule 7.1
+		emv_debug_error("Invalid T=1 block");
+		if (state->t1_retries >= EMV_TTL_T1_RETRIES_MAX) {
+			return 12;
+		}
+		++state->t1_retries;
+		emv_ttl_t1_tx_rblock(state, EMV_TTL_T1_PCB_R_ERR_EDC);
+		*tx_next = true;
+		return 0;
+	}
+	pcb = rx_buf[1];
+	inf_len = rx_buf[2];
+
+	if ((pcb & EMV_TTL_T1_PCB_S) == EMV_TTL_T1_PCB_S) {
+		// S-block request from ICC
+		// See ISO 7816-3:2006, 11.6.2.4
+		switch (pcb & ~EMV_TTL_T1_PCB_S) {
+			case EMV_TTL_T1_PCB_S_WTX:
+				// Acknowledge waiting time extension and wait for response
+				if (inf_len != 1) {
+					return 13;
+				}
+				emv_debug_info("T=1 waiting time extension: BWT x %u", rx_buf[3]);
+				emv_ttl_t1_tx_sblock(
+					state,
+					EMV_TTL_T1_PCB_S | EMV_TTL_T1_PCB_S_RESPONSE | EMV_TTL_T1_PCB_S_WTX,
+					rx_buf + 3,
+					inf_len
+				);
+				*tx_next = true;
+				return 0;
+
+			case EMV_TTL_T1_PCB_S_IFS:
+				// Accept new IFSC from ICC
+				// See EMV Contact Interface Specification v1.0, 9.2.4.3
+				if (inf_len != 1 || rx_buf[3] < 0x10 || rx_buf[3] == 0xFF) {
+					return 13;
+				}
+				t1->ifsc = rx_buf[3];
+				emv_debug_info("T=1 IFSC=%u", t1->ifsc);
+				emv_ttl_t1_tx_sblock(
+					state,
+					EMV_TTL_T1_PCB_S | EMV_TTL_T1_PCB_S_RESPONSE | EMV_TTL_T1_PCB_S_IFS,
+					rx_buf + 3,
+					inf_len
+				);
+				*tx_next = true;
+				return 0;
 
-		r = ctx->cardreader.trx(ctx->cardreader.ctx, tx_buf, tx_buf_len, rx_buf, &rx_len);
-		if (r) {
-			return r;
+			default:
+				// RESYNCH and ABORT are not supported by EMV
+				// See EMV Contact Interface Specification v1.0, 9.2.4.2.3
+				emv_debug_error("Unsupported T=1 S-block");
+				if (*state->r_apdu_len < rx_len) {
+					// Insufficient R-APDU buffer capacity for block
+					return -4;
+				}
+				memcpy(state->r_apdu, rx_buf, rx_len);
+				*state->r_apdu_len = rx_len;
+				return 14;
 		}
-		if (rx_len == 0) {
-			// No response
-			emv_debug_error("No response");
-			return 1;
+	}
+
+	if ((pcb & EMV_TTL_T1_PCB_S) == EMV_TTL_T1_PCB_R) {
+		// R-block from ICC
+		// See ISO 7816-3:2006, 11.6.3.2
+		bool ack = !!(pcb & EMV_TTL_T1_PCB_R_NR) == !!t1->ns;
+
+		if (ack && state->t1_tx_chaining) {
+			// ICC acknowledged chained I-block; send next I-block
+			state->t1_retries = 0;
+			emv_ttl_t1_tx_iblock(state);
+			*tx_next = true;
+			return 0;
 		}
 
-		emv_debug_rtpdu(rx_buf, rx_len);
+		// Otherwise retransmit the most recent block
+		if (state->t1_retries >= EMV_TTL_T1_RETRIES_MAX) {
+			return 12;
+		}
+		++state->t1_retries;
+		*tx_next = true;
+		return 0;
+	}
 
-		// Store INS of most recent tx for later use
-		INS = *((uint8_t*)(tx_buf + 1));
+	// I-block from ICC
+	if (state->t1_tx_chaining) {
+		// ICC must acknowledge chained I-blocks using R-blocks
+		return 15;
+	}
+	if (!!(pcb & EMV_TTL_T1_PCB_I_NS) != !!t1->nr) {
+		// Unexpected send-sequence number
+		if (state->t1_retries >= EMV_TTL_T1_RETRIES_MAX) {
+			return 12;
+		}
+		++state->t1_retries;
+		emv_ttl_t1_tx_rblock(state, EMV_TTL_T1_PCB_R_ERR_OTHER);
+		*tx_next = true;
+		return 0;
+	}
+	t1->nr ^= 1;
+	state->t1_retries = 0;
 
-		// Extract SW1-SW2 status bytes
-		if (rx_len > 1) {
-			SW1 = *((uint8_t*)(rx_buf + rx_len - 2));
-			SW2 = *((uint8_t*)(rx_buf + rx_len - 1));
-		} else {
-			SW1 = *((uint8_t*)rx_buf);
-			SW2 = 0xFF;
+	// Ensure that R-APDU buffer has enough capacity for incoming data
+	if (*state->r_apdu_len < inf_len) {
+		return -4;
+	}
+
+	// Copy data to R-APDU
+	memcpy(state->r_apdu_ptr, rx_buf + 3, inf_len);
+	state->r_apdu_ptr += inf_len;
+	*state->r_apdu_len -= inf_len;
+
+	if (pcb & EMV_TTL_T1_PCB_I_M) {
+		// Acknowledge chained I-block and receive next I-block
+		emv_ttl_t1_tx_rblock(state, 0);
+		*tx_next = true;
+		return 0;
+	}
+
+	// Finalise R-APDU
+	*state->r_apdu_len = state->r_apdu_ptr - state->r_apdu;
+	if (*state->r_apdu_len < 2) {
+		// R-APDU must contain at least SW1-SW2
+		return 16;
+	}
+
+	// Output status bytes SW1-SW2 in host endianness
+	*state->sw1sw2 = ((uint16_t)state->r_apdu_ptr[-2] << 8) | state->r_apdu_ptr[-1];
+
+	// Let Terminal Application Layer (TAL) process the response
+	emv_debug_rapdu(state->r_apdu, *state->r_apdu_len);
+	return 0;
+}
+
+static int emv_ttl_trx_process(
+	struct emv_ttl_trx_state_t* state,
+	size_t rx_len,
+	bool* tx_next
+)
+{
+	const struct emv_ttl_t* ctx = state->ttl;
+	const uint8_t* rx_buf = state->rx_buf;
+	enum iso7816_apdu_case_t apdu_case = state->apdu_case;
+	uint8_t INS;
+	uint8_t SW1;
+	uint8_t SW2;
+	bool tx_get_response = false;
+	bool tx_update_le  = false;
+
+	*tx_next = false;
+
+	if (rx_len == 0) {
+		// No response
+		emv_debug_error("No response");
+		return 1;
+	}
+
+	emv_debug_rtpdu(rx_buf, rx_len);
+
+	if (ctx->cardreader.mode == EMV_CARDREADER_MODE_TPDU_T1) {
+		return emv_ttl_trx_process_t1(state, rx_len, tx_next);
+	}
+
+	// Store INS of most recent tx for later use
+	INS = *((const uint8_t*)(state->tx_buf + 1));
+
+	// Extract SW1-SW2 status bytes
+	if (rx_len > 1) {
+		SW1 = rx_buf[rx_len - 2];
+		SW2 = rx_buf[rx_len - 1];
+	} else {
+		SW1 = rx_buf[0];
+		SW2 = 0xFF;
+	}
+
+	// For APDU case 1, the R-APDU should only be SW1-SW2; no further action
+	// See ISO 7816-3:2006, 12.2.1, table 14
+	// See EMV Contact Interface Specification v1.0, 9.3.1.1.1
+	if (apdu_case == ISO7816_APDU_CASE_1) {
+		if (rx_len != 2) {
+			// Unexpected response length for APDU case 1
+			*state->r_apdu_len = 0;
+			return 2;
 		}
 
-		// For APDU case 1, the R-APDU should only be SW1-SW2; no further action
-		// See ISO 7816-3:2006, 12.2.1, table 14
-		// See EMV Contact Interface Specification v1.0, 9.3.1.1.1
-		if (apdu_case == ISO7816_APDU_CASE_1) {
-			if (rx_len != 2) {
-				// Unexpected response length for APDU case 1
-				*r_apdu_len = 0;
-				return 2;
+		// Copy data to R-APDU
+		memcpy(state->r_apdu, rx_buf, rx_len);
+		*state->r_apdu_len = rx_len;
+
+		// Output status bytes SW1-SW2 in host endianness
+		*state->sw1sw2 = ((uint16_t)SW1 << 8) | SW2;
+
+		// Let Terminal Application Layer (TAL) process the response
+		emv_debug_rapdu(state->r_apdu, *state->r_apdu_len);
+		return 0;
+	}
+
+	// Process response containing single procedure byte
+	// See ISO 7816-3:2006, 10.3.3
+	// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
+	if (rx_len == 1) {
+		uint8_t procedure_byte = rx_buf[0];
+
+		// Wait for another procedure byte
+		if (procedure_byte == 0x60) {
+			// Not supported by this TTL; assume that card reader hardware
+			// or driver will take care of this procedure byte
+			memcpy(state->r_apdu, rx_buf, rx_len);
+			*state->r_apdu_len = rx_len;
+			return 3;
+		}
+
+		// ACK: Send remaining data bytes
+		if (procedure_byte == INS) {
+			if (!state->c_tpdu_data) {
+				// Unexpected procedure byte if no data available
+				memcpy(state->r_apdu, rx_buf, rx_len);
+				*state->r_apdu_len = rx_len;
+				return 4;
 			}
 
-			// Copy data to R-APDU
-			memcpy(r_apdu, rx_buf, rx_len);
-			*r_apdu_len = rx_len;
+			state->tx_buf = state->c_tpdu_data;
+			state->tx_buf_len = state->c_tpdu_header[4]; // Next transmit length is Lc
 
-			// Output status bytes SW1-SW2 in host endianness
-			*sw1sw2 = ((uint16_t)SW1 << 8) | SW2;
+			// No more data available
+			state->c_tpdu_data = NULL;
 
-			// Let Terminal Application Layer (TAL) process the response
-			emv_debug_rapdu(r_apdu, *r_apdu_len);
+			*tx_next = true;
 			return 0;
 		}
 
-		// Process response containing single procedure byte
-		// See ISO 7816-3:2006, 10.3.3
-		// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
-		if (rx_len == 1) {
-			uint8_t procedure_byte = *((uint8_t*)rx_buf);
-
-			// Wait for another procedure byte
-			if (procedure_byte == 0x60) {
-				// Not supported by this TTL; assume that card reader hardware
-				// or driver will take care of this procedure byte
-				memcpy(r_apdu, rx_buf, rx_len);
-				*r_apdu_len = rx_len;
-				return 3;
+		// ACK: Send next byte
+		if (procedure_byte == (INS ^ 0xFF)) {
+			if (!state->c_tpdu_data) {
+				// Unexpected procedure byte if no data available
+				memcpy(state->r_apdu, rx_buf, rx_len);
+				*state->r_apdu_len = rx_len;
+				return 5;
 			}
 
-			// ACK: Send remaining data bytes
-			if (procedure_byte == INS) {
-				if (!c_tpdu_data) {
-					// Unexpected procedure byte if no data available
-					memcpy(r_apdu, rx_buf, rx_len);
-					*r_apdu_len = rx_len;
-					return 4;
-				}
+			state->tx_buf = state->c_tpdu_data;
+			state->tx_buf_len = 1;
+			++state->c_tpdu_data;
 
-				tx_buf = c_tpdu_data;
-				tx_buf_len = c_tpdu_header[4]; // Next transmit length is Lc
+			// Case 3: CLA INS P1 P2 Lc [Data(Lc)]
+			// If c_tpdu_data is at the end of [Data(Lc)],
+			// no more data is available
+			if (apdu_case == ISO7816_APDU_CASE_3S &&
+				state->c_tpdu_data - state->c_apdu >= state->c_apdu_len
+			) {
+				// No more data available
+				state->c_tpdu_data = NULL;
+			}
 
+			// Case 4: CLA INS P1 P2 Lc [Data(Lc)] Le
+			// If c_tpdu_data is at the end of [Data(Lc)],
+			// no more data is available
+			if (apdu_case == ISO7816_APDU_CASE_4S &&
+				state->c_tpdu_data - state->c_apdu >= state->c_apdu_len - 1
+			) {
 				// No more data available
-				c_tpdu_data = NULL;
+				state->c_tpdu_data = NULL;
+			}
+
+			*tx_next = true;
+			return 0;
+		}
+
+		// Unknown procedure byte
+		memcpy(state->r_apdu, rx_buf, rx_len);
+		*state->r_apdu_len = rx_len;
+		return 6;
+	}
+
+	// Process status bytes
+	// See ISO 7816-3:2006, 12.2.1, table 14
+	// See ISO 7816-4:2005, 5.1.3, table 6
+	// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
+	// See EMV Contact Interface Specification v1.0, 9.2.2.3.2
+	// See EMV Contact Interface Specification v1.0, 9.3.1.1
+	// See EMV Contact Interface Specification v1.0, 9.3.1.2
+	// See EMV Contact Interface Specification v1.0, Annex A for examples
+	switch (SW1) {
+		case 0x61: // Normal processing: SW2 encodes the number of available bytes
 
-				continue;
+			// Status 61XX is only allowed for APDU cases 2 and 4
+			// See ISO 7816-3:2006, 12.2.1, table 14
+			if (apdu_case != ISO7816_APDU_CASE_2S &&
+				apdu_case != ISO7816_APDU_CASE_4S
+			) {
+				return 7;
 			}
 
-			// ACK: Send next byte
-			if (procedure_byte == (INS ^ 0xFF)) {
-				if (!c_tpdu_data) {
-					// Unexpected procedure byte if no data available
-					memcpy(r_apdu, rx_buf, rx_len);
-					*r_apdu_len = rx_len;
-					return 5;
-				}
+			// Build GET RESPONSE for next transmission
+			tx_get_response = true;
+			break;
 
-				tx_buf = c_tpdu_data;
-				tx_buf_len = 1;
-				++c_tpdu_data;
+		case 0x6C: // Checking error: Wrong Le field; SW2 encodes the exact number of available bytes
 
-				// Case 3: CLA INS P1 P2 Lc [Data(Lc)]
-				// If c_tpdu_data is at the end of [Data(Lc)],
-				// no more data is available
-				if (apdu_case == ISO7816_APDU_CASE_3S &&
-					c_tpdu_data - c_apdu >= c_apdu_len
-				) {
-					// No more data available
-					c_tpdu_data = NULL;
-				}
+			// Status 6CXX is only allowed for APDU cases 2 and 4
+			// See ISO 7816-3:2006, 12.2.1, table 14
+			if (apdu_case != ISO7816_APDU_CASE_2S &&
+				apdu_case != ISO7816_APDU_CASE_4S
+			) {
+				return 8;
+			}
 
-				// Case 4: CLA INS P1 P2 Lc [Data(Lc)] Le
-				// If c_tpdu_data is at the end of [Data(Lc)],
-				// no more data is available
+			// Update Le for next transmission
+			tx_update_le = true;
+			break;
+
+		default:
+			// Terminal Application Layer (TAL) should receive the SW1-SW2
+			// value for all remaining cases, including normal completion
+			// and completion with a warning. Note that warning processing
+			// may occur before the response data is received.
+			// See EMV Contact Interface Specification v1.0, 9.3.1.1
+			if (!*state->sw1sw2) {
+				// Output status bytes SW1-SW2 in host endianness
+				*state->sw1sw2 = ((uint16_t)SW1 << 8) | SW2;
+
+				// For APDU case 4, if warning processing occurs without
+				// response data, it is followed by GET RESPONSE
+				// See EMV Contact Interface Specification v1.0, Annex A7 "Case 4 Command with Warning Condition"
 				if (apdu_case == ISO7816_APDU_CASE_4S &&
-					c_tpdu_data - c_apdu >= c_apdu_len - 1
+					rx_len == 2 &&
+					iso7816_sw1sw2_is_warning(SW1, SW2)
 				) {
-					// No more data available
-					c_tpdu_data = NULL;
+					tx_get_response = true;
+					break;
 				}
-
-				continue;
 			}
+	}
 
-			// Unknown procedure byte
-			memcpy(r_apdu, rx_buf, rx_len);
-			*r_apdu_len = rx_len;
-			return 6;
+	// For TPDU mode and a response that appears to contain response data
+	if (ctx->cardreader.mode == EMV_CARDREADER_MODE_TPDU &&
+		rx_len > 3
+	) {
+		// Response data is only allowed for APDU cases 2 and 4
+		if (apdu_case != ISO7816_APDU_CASE_2S &&
+			apdu_case != ISO7816_APDU_CASE_4S
+		) {
+			return 9;
 		}
 
-		// Process status bytes
-		// See ISO 7816-3:2006, 12.2.1, table 14
-		// See ISO 7816-4:2005, 5.1.3, table 6
-		// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
-		// See EMV Contact Interface Specification v1.0, 9.2.2.3.2
-		// See EMV Contact Interface Specification v1.0, 9.3.1.1
-		// See EMV Contact Interface Specification v1.0, 9.3.1.2
-		// See EMV Contact Interface Specification v1.0, Annex A for examples
-		switch (SW1) {
-			case 0x61: // Normal processing: SW2 encodes the number of available bytes
-
-				// Status 61XX is only allowed for APDU cases 2 and 4
-				// See ISO 7816-3:2006, 12.2.1, table 14
-				if (apdu_case != ISO7816_APDU_CASE_2S &&
-					apdu_case != ISO7816_APDU_CASE_4S
-				) {
-					return 7;
-				}
+		// Verify leading INS byte in R-TPDU
+		if (rx_buf[0] != INS) {
+			// R-TPDU data response should have leading INS byte
+			return 10;
+		}
 
-				// Build GET RESPONSE for next transmission
-				tx_get_response = true;
-				break;
+		// Discard leading INS byte
+		rx_len -= 1;
 
-			case 0x6C: // Checking error: Wrong Le field; SW2 encodes the exact number of available bytes
+		// Ensure that R-APDU buffer has enough capacity for incoming
+		// data as well as trailing SW1-SW2
+		if (*state->r_apdu_len < rx_len) {
+			return -4;
+		}
 
-				// Status 6CXX is only allowed for APDU cases 2 and 4
-				// See ISO 7816-3:2006, 12.2.1, table 14
-				if (apdu_case != ISO7816_APDU_CASE_2S &&
-					apdu_case != ISO7816_APDU_CASE_4S
-				) {
-					return 8;
-				}
+		// Ignore trailing status bytes
+		rx_len -= 2;
 
-				// Update Le for next transmission
-				tx_update_le = true;
-				break;
+		// Copy data to R-APDU
+		memcpy(state->r_apdu_ptr, rx_buf + 1, rx_len);
+		state->r_apdu_ptr += rx_len;
+		*state->r_apdu_len -= rx_len;
+	}
 
-			default:
-				// Terminal Application Layer (TAL) should receive the SW1-SW2
-				// value for all remaining cases, including normal completion
-				// and completion with a warning. Note that warning processing
-				// may occur before the response data is received.
-				// See EMV Contact Interface Specification v1.0, 9.3.1.1
-				if (!*sw1sw2) {
-					// Output status bytes SW1-SW2 in host endianness
-					*sw1sw2 = ((uint16_t)SW1 << 8) | SW2;
-
-					// For APDU case 4, if warning processing occurs without
-					// response data, it is followed by GET RESPONSE
-					// See EMV Contact Interface Specification v1.0, Annex A7 "Case 4 Command with Warning Condition"
-					if (apdu_case == ISO7816_APDU_CASE_4S &&
-						rx_len == 2 &&
-						iso7816_sw1sw2_is_warning(SW1, SW2)
-					) {
-						tx_get_response = true;
-						break;
-					}
-				}
+	// For APDU mode and a response that appears to contain response data
+	if (ctx->cardreader.mode == EMV_CARDREADER_MODE_APDU &&
+		rx_len > 2
+	) {
+		// Response data is only allowed for APDU cases 2 and 4
+		if (apdu_case != ISO7816_APDU_CASE_2S &&
+			apdu_case != ISO7816_APDU_CASE_4S
+		) {
+			return 11;
+		}
+
+		// Ensure that R-APDU buffer has enough capacity for incoming
+		// data as well as trailing SW1-SW2
+		if (*state->r_apdu_len < rx_len) {
+			return -5;
 		}
 
-		// For TPDU mode and a response that appears to contain response data
-		if (ctx->cardreader.mode == EMV_CARDREADER_MODE_TPDU &&
-			rx_len > 3
+		// Ignore trailing status bytes
+		rx_len -= 2;
+
+		// Copy data to R-APDU
+		memcpy(state->r_apdu_ptr, rx_buf, rx_len);
+		state->r_apdu_ptr += rx_len;
+		*state->r_apdu_len -= rx_len;
+	}
+
+	if (tx_get_response) {
+		uint8_t Le;
+
+		// Determine Le field from SW1-SW2
+		// See ISO 7816-4:2005, 5.1.3
+		if (SW1 == 0x61 ||
+			(SW1 == 0x62 && SW2 >= 0x02 && SW2 <= 0x80)
 		) {
-			// Response data is only allowed for APDU cases 2 and 4
-			if (apdu_case != ISO7816_APDU_CASE_2S &&
-				apdu_case != ISO7816_APDU_CASE_4S
-			) {
-				return 9;
-			}
+			Le = SW2;
+		} else {
+			Le = 0;
+		}
 
-			// Verify leading INS byte in R-TPDU
-			if (memcmp(rx_buf, &INS, 1) != 0) {
-				// R-TPDU data response should have leading INS byte
-				return 10;
-			}
+		// Build GET RESPONSE for next transmission
+		// See ISO 7816-4:2005, 7.6.1
+		// See EMV Contact Interface Specification v1.0, 9.3.1.3
+		state->c_tpdu_header[0] = 0x00; // CLA
+		state->c_tpdu_header[1] = 0xC0; // INS: GET RESPONSE
+		state->c_tpdu_header[2] = 0x00; // P1
+		state->c_tpdu_header[3] = 0x00; // P2
+		state->c_tpdu_header[4] = Le;   // Le
+		state->tx_buf = state->c_tpdu_header;
+		state->tx_buf_len = sizeof(state->c_tpdu_header);
+		++state->get_response_count;
+
+		// Next transmission
+		*tx_next = true;
+		return 0;
+	}
 
-			// Discard leading INS byte
-			rx_len -= 1;
+	if (tx_update_le) {
+		// Update Le for next transmission
+		// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
+		memmove(state->c_tpdu_header, state->tx_buf, 4);
+		state->c_tpdu_header[4] = SW2; // P3 = Le
+		state->tx_buf = state->c_tpdu_header;
+		state->tx_buf_len = sizeof(state->c_tpdu_header);
 
-			// Ensure that R-APDU buffer has enough capacity for incoming
-			// data as well as trailing SW1-SW2
-			if (*r_apdu_len < rx_len) {
-				return -4;
-			}
+		// Next transmission
+		*tx_next = true;
+		return 0;
+	}
+
+	// Finalise R-APDU using current SW1-SW2
+	state->r_apdu_ptr[0] = *state->sw1sw2 >> 8;
+	state->r_apdu_ptr[1] = *state->sw1sw2 & 0xFF;
+	state->r_apdu_ptr += 2;
+	*state->r_apdu_len = state->r_apdu_ptr - state->r_apdu;
+
+	// Let Terminal Application Layer (TAL) process the response
+	emv_debug_rapdu(state->r_apdu, *state->r_apdu_len);
+	return 0;
+}
+
+int emv_ttl_select_protocol(
+	struct emv_ttl_t* ctx,
+	const struct iso7816_atr_info_t* atr_info
+)
+{
+	int r;
+	unsigned int protocol;
+	uint8_t tx_buf[EMV_TTL_T1_BLOCK_MAX];
+	size_t tx_buf_len;
+	uint8_t rx_buf[EMV_TTL_T1_BLOCK_MAX];
+	size_t rx_buf_len;
+	const uint8_t ifs_response = EMV_TTL_T1_PCB_S | EMV_TTL_T1_PCB_S_RESPONSE | EMV_TTL_T1_PCB_S_IFS;
+
+	if (!ctx || !atr_info) {
+		return -1;
+	}
+
+	if (ctx->cardreader.mode == EMV_CARDREADER_MODE_APDU) {
+		// Card reader is responsible for transmission protocol
+		return 0;
+	}
+	if (ctx->cardreader.mode != EMV_CARDREADER_MODE_TPDU &&
+		ctx->cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1
+	) {
+		// Unknown cardreader mode
+		return -2;
+	}
+
+	// Specific mode protocol takes precedence over first offered protocol
+	// See ISO 7816-3:2006, 6.3.1
+	// See EMV Contact Interface Specification v1.0, 8.3.3.2
+	if (atr_info->global.specific_mode) {
+		protocol = atr_info->global.specific_mode_protocol;
+	} else {
+		protocol = atr_info->global.protocol;
+	}
+
+	if (protocol == ISO7816_PROTOCOL_T0) {
+		emv_debug_info("Selected protocol T=0");
+		ctx->cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		return 0;
+	}
+	if (protocol != ISO7816_PROTOCOL_T1) {
+		emv_debug_error("Unsupported protocol T=%u", protocol);
+		return 1;
+	}
+
+	// EMV only allows LRC
+	// See EMV Contact Interface Specification v1.0, 8.3.3.10
+	if (atr_info->protocol_T1.error_detection_code != ISO7816_ERROR_DETECTION_CODE_LRC) {
+		emv_debug_error("Unsupported T=1 error detection code");
+		return 2;
+	}
 
-			// Ignore trailing status bytes
-			rx_len -= 2;
+	ctx->cardreader.mode = EMV_CARDREADER_MODE_TPDU_T1;
+	ctx->t1.ifsc = atr_info->protocol_T1.IFSI;
+	ctx->t1.ifsd = EMV_TTL_T1_IFSD;
+	ctx->t1.ns = 0;
+	ctx->t1.nr = 0;
+	emv_debug_info("Selected protocol T=1 with IFSC=%u", ctx->t1.ifsc);
+
+	// Indicate terminal IFSD using S(IFS request) immediately after ATR
+	// See EMV Contact Interface Specification v1.0, 9.2.4.3
+	tx_buf_len = emv_ttl_t1_build_block(
+		tx_buf,
+		EMV_TTL_T1_PCB_S | EMV_TTL_T1_PCB_S_IFS,
+		&ctx->t1.ifsd,
+		sizeof(ctx->t1.ifsd)
+	);
+	for (unsigned int retries = 0; ; ++retries) {
+		emv_debug_ctpdu(tx_buf, tx_buf_len);
 
-			// Copy data to R-APDU
-			memcpy(r_apdu_ptr, rx_buf + 1, rx_len);
-			r_apdu_ptr += rx_len;
-			*r_apdu_len -= rx_len;
+		rx_buf_len = sizeof(rx_buf);
+		r = ctx->cardreader.trx(ctx->cardreader.ctx, tx_buf, tx_buf_len, rx_buf, &rx_buf_len);
+		if (r) {
+			return r;
 		}
+		emv_debug_rtpdu(rx_buf, rx_buf_len);
 
-		// For APDU mode and a response that appears to contain response data
-		if (ctx->cardreader.mode == EMV_CARDREADER_MODE_APDU &&
-			rx_len > 2
+		if (emv_ttl_t1_block_is_valid(rx_buf, rx_buf_len) &&
+			rx_buf[1] == ifs_response &&
+			rx_buf[2] == 1 &&
+			rx_buf[3] == ctx->t1.ifsd
 		) {
-			// Response data is only allowed for APDU cases 2 and 4
-			if (apdu_case != ISO7816_APDU_CASE_2S &&
-				apdu_case != ISO7816_APDU_CASE_4S
-			) {
-				return 11;
-			}
+			// IFSD accepted by ICC
+			return 0;
+		}
 
-			// Ensure that R-APDU buffer has enough capacity for incoming
-			// data as well as trailing SW1-SW2
-			if (*r_apdu_len < rx_len) {
-				return -5;
-			}
+		if (retries >= EMV_TTL_T1_RETRIES_MAX) {
+			emv_debug_error("T=1 IFSD negotiation failed");
+			return 3;
+		}
+	}
+}
 
-			// Ignore trailing status bytes
-			rx_len -= 2;
+int emv_ttl_trx(
+	struct emv_ttl_t* ctx,
+	const void* c_apdu,
+	size_t c_apdu_len,
+	void* r_apdu,
+	size_t* r_apdu_len,
+	uint16_t* sw1sw2
+)
+{
+	int r;
+	struct emv_ttl_trx_state_t state;
+	bool tx_next;
 
-			// Copy data to R-APDU
-			memcpy(r_apdu_ptr, rx_buf, rx_len);
-			r_apdu_ptr += rx_len;
-			*r_apdu_len -= rx_len;
+	r = emv_ttl_trx_begin(&state, ctx, c_apdu, c_apdu_len, r_apdu, r_apdu_len, sw1sw2);
+	if (r) {
+		return r;
+	}
+
+	do {
+		size_t rx_len = sizeof(state.rx_buf);
+
+		emv_debug_ctpdu(state.tx_buf, state.tx_buf_len);
+		emv_ttl_stats_tx(&state);
+
+		r = ctx->cardreader.trx(
+			ctx->cardreader.ctx,
+			state.tx_buf,
+			state.tx_buf_len,
+			state.rx_buf,
+			&rx_len
+		);
+		if (r) {
+			return emv_ttl_stats_finish(&state, r);
 		}
+		emv_ttl_stats_rx(&state, rx_len);
 
-		if (tx_get_response) {
-			uint8_t Le;
+		r = emv_ttl_trx_process(&state, rx_len, &tx_next);
+	} while (!r && tx_next);
 
-			// Determine Le field from SW1-SW2
-			// See ISO 7816-4:2005, 5.1.3
-			if (SW1 == 0x61 ||
-				(SW1 == 0x62 && SW2 >= 0x02 && SW2 <= 0x80)
-			) {
-				Le = SW2;
-			} else {
-				Le = 0;
-			}
+	return emv_ttl_stats_finish(&state, r);
+}
 
-			// Build GET RESPONSE for next transmission
-			// See ISO 7816-4:2005, 7.6.1
-			// See EMV Contact Interface Specification v1.0, 9.3.1.3
-			c_tpdu_header[0] = 0x00; // CLA
-			c_tpdu_header[1] = 0xC0; // INS: GET RESPONSE
-			c_tpdu_header[2] = 0x00; // P1
-			c_tpdu_header[3] = 0x00; // P2
-			c_tpdu_header[4] = Le;   // Le
-			tx_buf = c_tpdu_header;
-			tx_buf_len = sizeof(c_tpdu_header);
-
-			// Next transmission
-			continue;
-		}
+static void emv_ttl_trx_async_complete(void* ctx, int result, size_t rx_len)
+{
+	int r;
+	struct emv_ttl_trx_state_t* state = ctx;
+	bool tx_next;
 
-		if (tx_update_le) {
-			// Update Le for next transmission
-			// See EMV Contact Interface Specification v1.0, 9.2.2.3.1, table 25
-			memcpy(c_tpdu_header, tx_buf, 4);
-			c_tpdu_header[4] = SW2; // P3 = Le
-			tx_buf = c_tpdu_header;
-			tx_buf_len = sizeof(c_tpdu_header);
-
-			// Next transmission
-			continue;
-		}
+	if (result) {
+		state->complete(state->complete_ctx, emv_ttl_stats_finish(state, result));
+		return;
+	}
+	emv_ttl_stats_rx(state, rx_len);
 
-		// Finalise R-APDU using current SW1-SW2
-		r_apdu_ptr[0] = *sw1sw2 >> 8;
-		r_apdu_ptr[1] = *sw1sw2 & 0xFF;
-		r_apdu_ptr += 2;
-		*r_apdu_len = (void*)r_apdu_ptr - r_apdu;
+	r = emv_ttl_trx_process(state, rx_len, &tx_next);
+	if (r || !tx_next) {
+		state->complete(state->complete_ctx, emv_ttl_stats_finish(state, r));
+		return;
+	}
 
-		// Let Terminal Application Layer (TAL) process the response
-		emv_debug_rapdu(r_apdu, *r_apdu_len);
-		return 0;
+	emv_debug_ctpdu(state->tx_buf, state->tx_buf_len);
+	emv_ttl_stats_tx(state);
+	r = state->ttl->cardreader.submit(
+		state->ttl->cardreader.ctx,
+		state->tx_buf,
+		state->tx_buf_len,
+		state->rx_buf,
+		sizeof(state->rx_buf),
+		&emv_ttl_trx_async_complete,
+		state
+	);
+	if (r) {
+		state->complete(state->complete_ctx, emv_ttl_stats_finish(state, r));
+		return;
+	}
+}
+
+int emv_ttl_trx_async(
+	struct emv_ttl_t* ctx,
+	struct emv_ttl_trx_state_t* state,
+	const void* c_apdu,
+	size_t c_apdu_len,
+	void* r_apdu,
+	size_t* r_apdu_len,
+	uint16_t* sw1sw2,
+	emv_ttl_trx_complete_t complete,
+	void* complete_ctx
+)
+{
+	int r;
 
-	} while (true);
+	if (!ctx || !state || !complete) {
+		return -1;
+	}
+	if (!ctx->cardreader.submit) {
+		// Asynchronous transmission not supported by card reader
+		return -6;
+	}
+
+	r = emv_ttl_trx_begin(state, ctx, c_apdu, c_apdu_len, r_apdu, r_apdu_len, sw1sw2);
+	if (r) {
+		return r;
+	}
+	state->complete = complete;
+	state->complete_ctx = complete_ctx;
+
+	emv_debug_ctpdu(state->tx_buf, state->tx_buf_len);
+	emv_ttl_stats_tx(state);
+	r = ctx->cardreader.submit(
+		ctx->cardreader.ctx,
+		state->tx_buf,
+		state->tx_buf_len,
+		state->rx_buf,
+		sizeof(state->rx_buf),
+		&emv_ttl_trx_async_complete,
+		state
+	);
+	if (r) {
+		// Completion function will not be invoked
+		return emv_ttl_stats_finish(state, r);
+	}
+
+	return 0;
 }
 
 int emv_ttl_select_by_df_name(
@@ -2,7 +2,7 @@
  * @file emv_ttl.h
  * @brief EMV Terminal Transport Layer (TTL)
  *
- * Copyright 2021, 2024-2025 Leon Lynch
+ * Copyright 2021, 2024-2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -23,11 +23,15 @@
 #define EMV_TTL_H
 
 #include <sys/cdefs.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 __BEGIN_DECLS
 
+// Forward declarations
+struct iso7816_atr_info_t;
+
 /// Maximum length of C-APDU data field in bytes
 #define EMV_CAPDU_DATA_MAX (255)
 
@@ -40,10 +44,19 @@ __BEGIN_DECLS
 /// Maximum length of R-APDU buffer in bytes
 #define EMV_RAPDU_MAX (EMV_RAPDU_DATA_MAX + 2)
 
+/// Information Field Size for the terminal (IFSD) used for protocol T=1
+/// @remark See EMV Contact Interface Specification v1.0, 9.2.4.2.1
+#define EMV_TTL_T1_IFSD (254)
+
+/// Maximum length of protocol T=1 block in bytes, consisting of prologue
+/// field, information field and LRC epilogue field
+#define EMV_TTL_T1_BLOCK_MAX (3 + 254 + 1)
+
 /// Card reader mode
 enum emv_cardreader_mode_t {
 	EMV_CARDREADER_MODE_APDU = 1,               ///< Card reader is in APDU mode
-	EMV_CARDREADER_MODE_TPDU,                   ///< Card reader is in TPDU mode
+	EMV_CARDREADER_MODE_TPDU,                   ///< Card reader is in TPDU mode using protocol T=0
+	EMV_CARDREADER_MODE_TPDU_T1,                ///< Card reader is in TPDU mode using protocol T=1. See @ref emv_ttl_select_protocol().
 };
 
 /// Card reader transceive function type
@@ -55,21 +68,174 @@ typedef int (*emv_cardreader_trx_t)(
 	size_t* rx_buf_len
 );
 
+/**
+ * Card reader asynchronous transceive completion function type
+ * @param complete_ctx Completion context provided to @ref emv_cardreader_submit_t
+ * @param result Zero for success. Non-zero for card reader error.
+ * @param rx_buf_len Length of received data in bytes
+ */
+typedef void (*emv_cardreader_complete_t)(
+	void* complete_ctx,
+	int result,
+	size_t rx_buf_len
+);
+
+/**
+ * Card reader asynchronous transceive submission function type
+ *
+ * This function should queue the transmission and return immediately. When
+ * the response is received, the card reader implementation should invoke
+ * the completion function from its own event loop. The transmit buffer and
+ * receive buffer remain valid until the completion function is invoked.
+ *
+ * @return Zero if submitted. Non-zero for card reader error, in which case
+ *         the completion function will not be invoked.
+ */
+typedef int (*emv_cardreader_submit_t)(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t rx_buf_len,
+	emv_cardreader_complete_t complete,
+	void* complete_ctx
+);
+
 /**
  * EMV Terminal Transport Layer (TTL) abstraction for card reader
  * @note the card reader mode determines whether the @ref trx function
  * operates on TPDU frames or APDU frames. Typically PC/SC card readers use
  * APDU mode.
+ * @note The @ref submit function is optional and only required for
+ * @ref emv_ttl_trx_async().
  */
 struct emv_cardreader_t {
 	enum emv_cardreader_mode_t mode;            ///< Card reader mode (TPDU vs APDU)
 	void* ctx;                                  ///< Card reader transceive function context
 	emv_cardreader_trx_t trx;                   ///< Card reader transceive function
+	emv_cardreader_submit_t submit;             ///< Card reader asynchronous transceive function (optional)
 };
 
-/// EMV Terminal Transport Layer context
+/**
+ * EMV Terminal Transport Layer (TTL) protocol T=1 state
+ * @note Only used when the card reader mode is
+ * @ref EMV_CARDREADER_MODE_TPDU_T1 and initialised by
+ * @ref emv_ttl_select_protocol().
+ */
+struct emv_ttl_t1_t {
+	uint8_t ifsc; ///< Information Field Size for the ICC (IFSC)
+	uint8_t ifsd; ///< Information Field Size for the terminal (IFSD)
+	uint8_t ns; ///< Send-sequence number N(S) of next terminal I-block
+	uint8_t nr; ///< Send-sequence number N(S) expected for next ICC I-block
+};
+
+/// EMV Terminal Transport Layer (TTL) command classes used for statistics
+enum emv_ttl_cmd_t {
+	EMV_TTL_CMD_SELECT = 0,                     ///< SELECT (0xA4)
+	EMV_TTL_CMD_READ_RECORD,                    ///< READ RECORD (0xB2)
+	EMV_TTL_CMD_GPO,                            ///< GET PROCESSING OPTIONS (0xA8)
+	EMV_TTL_CMD_GET_DATA,                       ///< GET DATA (0xCA)
+	EMV_TTL_CMD_INTERNAL_AUTHENTICATE,          ///< INTERNAL AUTHENTICATE (0x88)
+	EMV_TTL_CMD_GENAC,                          ///< GENERATE AC (0xAE)
+	EMV_TTL_CMD_OTHER,                          ///< Any other command
+
+	EMV_TTL_CMD_COUNT,                          ///< Number of command classes
+};
+
+/**
+ * Number of latency histogram buckets in @ref emv_ttl_cmd_stats_t. Bucket 0
+ * counts commands completing in less than 1 ms, bucket N counts commands
+ * completing in [2^(N-1), 2^N) ms and the last bucket also counts all slower
+ * commands.
+ */
+#define EMV_TTL_STATS_HISTOGRAM_BUCKETS (16)
+
+/**
+ * EMV Terminal Transport Layer (TTL) statistics for a single command class.
+ * Byte counts and exchange counts are those of the card reader interface and
+ * therefore include TPDU headers, procedure bytes and protocol T=1 blocks
+ * where applicable.
+ */
+struct emv_ttl_cmd_stats_t {
+	unsigned long count;                        ///< Number of commands
+	unsigned long error_count;                  ///< Number of commands that failed with a card reader or transport error
+	unsigned long exchange_count;               ///< Number of card reader exchanges
+	unsigned long get_response_count;           ///< Number of extra GET RESPONSE exchanges
+	uint64_t tx_bytes;                          ///< Number of bytes sent to card reader
+	uint64_t rx_bytes;                          ///< Number of bytes received from card reader
+	uint64_t total_us;                          ///< Total command latency in microseconds
+	uint64_t min_us;                            ///< Minimum command latency in microseconds
+	uint64_t max_us;                            ///< Maximum command latency in microseconds
+	unsigned long histogram[EMV_TTL_STATS_HISTOGRAM_BUCKETS]; ///< Command latency histogram. See @ref EMV_TTL_STATS_HISTOGRAM_BUCKETS.
+};
+
+/**
+ * EMV Terminal Transport Layer (TTL) statistics
+ * @note Statistics are updated without locking and a statistics object must
+ * therefore not be shared by TTL contexts used concurrently on different
+ * threads.
+ */
+struct emv_ttl_stats_t {
+	struct emv_ttl_cmd_stats_t cmd[EMV_TTL_CMD_COUNT]; ///< Statistics per command class. See @ref emv_ttl_cmd_t.
+};
+
+/**
+ * EMV Terminal Transport Layer context
+ * @note This context must be initialised using @ref emv_ttl_init() before
+ * populating the card reader, unless it is only used via an EMV processing
+ * context initialised using @ref emv_ctx_init(). Use @ref emv_ttl_set_stats()
+ * to enable command statistics.
+ */
 struct emv_ttl_t {
 	struct emv_cardreader_t cardreader;
+	struct emv_ttl_t1_t t1; ///< Protocol T=1 state
+
+	/// @cond INTERNAL
+	struct emv_ttl_stats_t* stats;
+	/// @endcond
+};
+
+/**
+ * EMV Terminal Transport Layer (TTL) asynchronous transceive completion
+ * function type
+ * @param complete_ctx Completion context provided to @ref emv_ttl_trx_async()
+ * @param r Same as return value of @ref emv_ttl_trx()
+ */
+typedef void (*emv_ttl_trx_complete_t)(void* complete_ctx, int r);
+
+/**
+ * EMV Terminal Transport Layer (TTL) asynchronous transceive state. This
+ * allows many exchanges to be in progress on the same thread, each with its
+ * own state, and must remain valid until the completion function is invoked.
+ */
+struct emv_ttl_trx_state_t {
+	/// @cond INTERNAL
+	struct emv_ttl_t* ttl;
+	int apdu_case;
+	const uint8_t* c_apdu;
+	size_t c_apdu_len;
+	uint8_t c_tpdu_header[5];
+	const uint8_t* c_tpdu_data;
+	const void* tx_buf;
+	size_t tx_buf_len;
+	uint8_t* r_apdu;
+	uint8_t* r_apdu_ptr;
+	size_t* r_apdu_len;
+	uint16_t* sw1sw2;
+	uint8_t rx_buf[EMV_RAPDU_MAX];
+	enum emv_ttl_cmd_t cmd;
+	unsigned long exchange_count;
+	unsigned long get_response_count;
+	uint64_t tx_bytes;
+	uint64_t rx_bytes;
+	uint64_t start_us;
+	uint8_t t1_block[EMV_TTL_T1_BLOCK_MAX];
+	size_t t1_tx_offset;
+	bool t1_tx_chaining;
+	unsigned int t1_retries;
+	emv_ttl_trx_complete_t complete;
+	void* complete_ctx;
+	/// @endcond
 };
 
 /**
@@ -89,6 +255,62 @@ struct emv_ttl_t {
 #define EMV_TTL_GENAC_SIG_XDA                   (0x08) ///< Requested signature: XDA signature requested
 /// @}
 
+/**
+ * Select transmission protocol for TPDU mode from the Answer To Reset (ATR).
+ * If the ATR indicates protocol T=1, the card reader mode is updated to
+ * @ref EMV_CARDREADER_MODE_TPDU_T1, the protocol T=1 state is initialised
+ * and the terminal IFSD is negotiated using an S(IFS request). If the ATR
+ * indicates protocol T=0, the card reader mode is updated to
+ * @ref EMV_CARDREADER_MODE_TPDU. This function has no effect in APDU mode
+ * because the card reader is responsible for the transmission protocol.
+ *
+ * @remark See EMV Contact Interface Specification v1.0, 9.2.4
+ * @remark See ISO 7816-3:2006, 11
+ *
+ * @param ctx EMV Terminal Transport Layer context
+ * @param atr_info Parsed ATR information. See @ref iso7816_atr_parse().
+ * @return Zero for success. Less than zero for error. Greater than zero for
+ *         unsupported protocol or invalid reader response.
+ */
+int emv_ttl_select_protocol(
+	struct emv_ttl_t* ctx,
+	const struct iso7816_atr_info_t* atr_info
+);
+
+/**
+ * Initialise EMV Terminal Transport Layer (TTL) context. The card reader
+ * must be populated afterwards and command statistics are disabled.
+ *
+ * @param ctx EMV Terminal Transport Layer context
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_ttl_init(struct emv_ttl_t* ctx);
+
+/**
+ * Set EMV Terminal Transport Layer (TTL) statistics to be updated by
+ * subsequent commands. Statistics for a command are updated when the command
+ * completes.
+ *
+ * @param ctx EMV Terminal Transport Layer context
+ * @param stats EMV Terminal Transport Layer statistics. NULL to disable.
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_ttl_set_stats(struct emv_ttl_t* ctx, struct emv_ttl_stats_t* stats);
+
+/**
+ * Reset EMV Terminal Transport Layer (TTL) statistics
+ * @param stats EMV Terminal Transport Layer statistics
+ */
+void emv_ttl_stats_reset(struct emv_ttl_stats_t* stats);
+
+/**
+ * Retrieve string associated with EMV Terminal Transport Layer (TTL) command
+ * class
+ * @param cmd Command class
+ * @return Pointer to null-terminated string. Do not free.
+ */
+const char* emv_ttl_cmd_get_string(enum emv_ttl_cmd_t cmd);
+
 /**
  * EMV Terminal Transport Layer (TTL) transceive function for sending a
  * Command Application Protocol Data Unit (C-APDU) and receiving a
@@ -110,6 +332,40 @@ int emv_ttl_trx(
 	uint16_t* sw1sw2
 );
 
+/**
+ * EMV Terminal Transport Layer (TTL) asynchronous transceive function for
+ * sending a Command Application Protocol Data Unit (C-APDU) and receiving a
+ * Response Application Protocol Data Unit (R-APDU) without blocking. This
+ * function performs the same TPDU/APDU processing as @ref emv_ttl_trx() but
+ * uses the card reader's @ref emv_cardreader_t::submit function such that
+ * the card reader's event loop drives the exchange.
+ *
+ * @param ctx EMV Terminal Transport Layer context
+ * @param state Transceive state that must remain valid until completion
+ * @param c_apdu Command Application Protocol Data Unit (C-APDU) buffer
+ * @param c_apdu_len Length of C-APDU buffer in bytes
+ * @param r_apdu Response Application Protocol Data Unit (R-APDU) buffer
+ * @param r_apdu_len Length of R-APDU buffer in bytes
+ * @param sw1sw2 Status bytes (SW1-SW2) output in host endianness
+ * @param complete Completion function
+ * @param complete_ctx Completion function context
+ * @return Zero if submitted, in which case the completion function will be
+ *         invoked exactly once. Less than zero for error. Greater than zero
+ *         for card reader error. The completion function is not invoked for
+ *         non-zero return values.
+ */
+int emv_ttl_trx_async(
+	struct emv_ttl_t* ctx,
+	struct emv_ttl_trx_state_t* state,
+	const void* c_apdu,
+	size_t c_apdu_len,
+	void* r_apdu,
+	size_t* r_apdu_len,
+	uint16_t* sw1sw2,
+	emv_ttl_trx_complete_t complete,
+	void* complete_ctx
+);
+
 /**
  * SELECT (0xA4) the first or only application by Dedicated File (DF) name
  * and provide File Control Information (FCI) template.
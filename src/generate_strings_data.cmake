@@ -0,0 +1,233 @@
+##############################################################################
+# Copyright 2026 Leon Lynch
+#
+# This file is licensed under the terms of the LGPL v2.1 license.
+# See LICENSE file.
+##############################################################################
+
+# This script converts the iso-codes and mcc-codes JSON files to compact
+# constant tables that can be built into the emv_strings library. Each
+# generated header provides a single string pool and tables that reference
+# the string pool by offset. Offset zero is an empty string that indicates an
+# absent entry. Numeric codes directly index dense tables while alpha codes
+# are packed into integer keys, one byte per character, and stored in tables
+# sorted by key. The generated headers rely on the including source file to
+# provide the table entry types.
+#
+# Usage:
+# cmake
+#	-DISOCODES_JSON_PATH=<iso-codes JSON directory>
+#	-DMCC_JSON_PATH=<mcc_codes.json path>
+#	-DOUTPUT_DIR=<output directory>
+#	-P generate_strings_data.cmake
+
+cmake_minimum_required(VERSION 3.22)
+
+if(NOT ISOCODES_JSON_PATH OR NOT MCC_JSON_PATH OR NOT OUTPUT_DIR)
+	message(FATAL_ERROR "ISOCODES_JSON_PATH, MCC_JSON_PATH and OUTPUT_DIR must be specified")
+endif()
+
+# Convert string to C string literal content using octal escapes for
+# characters that are not printable ASCII
+function(strings_data_escape str out_var)
+	if(str MATCHES "^[ -~]*$")
+		string(REPLACE "\\" "\\\\" str "${str}")
+		string(REPLACE "\"" "\\\"" str "${str}")
+		string(REPLACE "?" "\\?" str "${str}") # Avoid trigraphs
+		set(${out_var} "${str}" PARENT_SCOPE)
+		return()
+	endif()
+
+	string(HEX "${str}" hex)
+	string(LENGTH "${hex}" hex_len)
+	set(escaped "")
+	set(i 0)
+	while(i LESS hex_len)
+		string(SUBSTRING "${hex}" ${i} 2 byte_hex)
+		math(EXPR byte "0x${byte_hex}")
+		if(byte LESS 32 OR byte GREATER 126 OR byte EQUAL 34 OR byte EQUAL 63 OR byte EQUAL 92)
+			math(EXPR d0 "${byte} >> 6")
+			math(EXPR d1 "(${byte} >> 3) & 7")
+			math(EXPR d2 "${byte} & 7")
+			string(APPEND escaped "\\${d0}${d1}${d2}")
+		else()
+			string(ASCII ${byte} c)
+			string(APPEND escaped "${c}")
+		endif()
+		math(EXPR i "${i} + 2")
+	endwhile()
+	set(${out_var} "${escaped}" PARENT_SCOPE)
+endfunction()
+
+# Append string to string pool of the current header and provide its offset
+function(strings_data_pool_add str offset_var)
+	strings_data_escape("${str}" escaped)
+	string(LENGTH "${str}" len)
+	string(APPEND pool "\t\"${escaped}\\0\"\n")
+	set(${offset_var} ${pool_len} PARENT_SCOPE)
+	math(EXPR pool_len "${pool_len} + ${len} + 1")
+	set(pool "${pool}" PARENT_SCOPE)
+	set(pool_len ${pool_len} PARENT_SCOPE)
+endfunction()
+
+# Add entry to table, where each table is a list of keys and the string pool
+# offset for each key is stored in a separate variable. Only the first entry
+# for each key is retained unless REPLACE is specified.
+macro(strings_data_table_add table key offset)
+	if(NOT DEFINED ${table}_${key})
+		list(APPEND ${table} "${key}")
+		set(${table}_${key} ${offset})
+	elseif("${ARGN}" STREQUAL "REPLACE")
+		set(${table}_${key} ${offset})
+	endif()
+endmacro()
+
+# Generate C definition of dense table that is directly indexed by numeric
+# code. Keys must be numeric values without leading zeros.
+function(strings_data_table_emit_dense name table count out_var)
+	set(content "static const uint32_t ${name}[${count}] = {")
+	math(EXPR last "${count} - 1")
+	foreach(i RANGE ${last})
+		math(EXPR column "${i} % 16")
+		if(column EQUAL 0)
+			string(APPEND content "\n\t")
+		else()
+			string(APPEND content " ")
+		endif()
+		if(DEFINED ${table}_${i})
+			string(APPEND content "${${table}_${i}},")
+		else()
+			string(APPEND content "0,")
+		endif()
+	endforeach()
+	string(APPEND content "\n};\n\n")
+	set(${out_var} "${content}" PARENT_SCOPE)
+endfunction()
+
+# Generate C definition of table that is sorted by packed alpha code
+function(strings_data_table_emit_alpha name table out_var)
+	set(keys ${${table}})
+	list(SORT keys)
+	set(content "static const struct isocodes_alpha_t ${name}[] = {\n")
+	foreach(key IN LISTS keys)
+		string(HEX "${key}" packed)
+		string(TOUPPER "${packed}" packed)
+		string(APPEND content "\t{ 0x${packed}, ${${table}_${key}} }, // ${key}\n")
+	endforeach()
+	string(APPEND content "};\n\n")
+	set(${out_var} "${content}" PARENT_SCOPE)
+endfunction()
+
+# Read top-level array of iso-codes JSON file
+function(strings_data_read_isocodes filename key out_json out_len)
+	file(READ "${ISOCODES_JSON_PATH}/${filename}" json)
+	string(JSON array GET "${json}" "${key}")
+	string(JSON len LENGTH "${array}")
+	set(${out_json} "${array}" PARENT_SCOPE)
+	set(${out_len} ${len} PARENT_SCOPE)
+endfunction()
+
+set(header_comment "// Generated by generate_strings_data.cmake. Do not edit.\n\n")
+
+# Build iso-codes string pool and tables
+set(pool "")
+set(pool_len 0)
+strings_data_pool_add("" offset)
+set(country_alpha2 "")
+set(country_alpha3 "")
+set(country_numeric "")
+set(currency_alpha3 "")
+set(currency_numeric "")
+set(language_alpha2 "")
+set(language_alpha3 "")
+
+strings_data_read_isocodes(iso_3166-1.json 3166-1 array len)
+math(EXPR last "${len} - 1")
+foreach(i RANGE ${last})
+	string(JSON item GET "${array}" ${i})
+	string(JSON name GET "${item}" name)
+	string(JSON alpha2 GET "${item}" alpha_2)
+	string(JSON alpha3 GET "${item}" alpha_3)
+	string(JSON numeric GET "${item}" numeric)
+	math(EXPR numeric "${numeric}") # Remove leading zeros
+	strings_data_pool_add("${name}" offset)
+	strings_data_table_add(country_alpha2 "${alpha2}" ${offset})
+	strings_data_table_add(country_alpha3 "${alpha3}" ${offset})
+	strings_data_table_add(country_numeric "${numeric}" ${offset})
+endforeach()
+
+strings_data_read_isocodes(iso_4217.json 4217 array len)
+math(EXPR last "${len} - 1")
+foreach(i RANGE ${last})
+	string(JSON item GET "${array}" ${i})
+	string(JSON name GET "${item}" name)
+	string(JSON alpha3 GET "${item}" alpha_3)
+	string(JSON numeric GET "${item}" numeric)
+	math(EXPR numeric "${numeric}") # Remove leading zeros
+	strings_data_pool_add("${name}" offset)
+	strings_data_table_add(currency_alpha3 "${alpha3}" ${offset})
+	strings_data_table_add(currency_numeric "${numeric}" ${offset})
+endforeach()
+
+strings_data_read_isocodes(iso_639-2.json 639-2 array len)
+math(EXPR last "${len} - 1")
+foreach(i RANGE ${last})
+	string(JSON item GET "${array}" ${i})
+	string(JSON name GET "${item}" name)
+	string(JSON alpha2 ERROR_VARIABLE alpha2_error GET "${item}" alpha_2) # Optional
+	string(JSON alpha3 GET "${item}" alpha_3)
+	strings_data_pool_add("${name}" offset)
+	if(NOT alpha2_error AND NOT alpha2 STREQUAL "")
+		strings_data_table_add(language_alpha2 "${alpha2}" ${offset})
+	endif()
+	# Ignore reserved ranges like qaa-qtz
+	string(LENGTH "${alpha3}" alpha3_len)
+	if(alpha3_len EQUAL 3)
+		strings_data_table_add(language_alpha3 "${alpha3}" ${offset})
+	endif()
+endforeach()
+
+set(content "${header_comment}")
+string(APPEND content "#ifndef ISOCODES_DATA_H\n#define ISOCODES_DATA_H\n\n#include <cstdint>\n\n")
+string(APPEND content "static const char isocodes_data_str[] =\n${pool};\n\n")
+foreach(table IN ITEMS country_numeric currency_numeric)
+	strings_data_table_emit_dense(isocodes_data_${table} ${table} 1000 table_content)
+	string(APPEND content "${table_content}")
+endforeach()
+foreach(table IN ITEMS country_alpha2 country_alpha3 currency_alpha3 language_alpha2 language_alpha3)
+	strings_data_table_emit_alpha(isocodes_data_${table} ${table} table_content)
+	string(APPEND content "${table_content}")
+endforeach()
+string(APPEND content "#endif\n")
+file(WRITE "${OUTPUT_DIR}/isocodes_data.h" "${content}")
+
+# Build mcc-codes string pool and table
+set(pool "")
+set(pool_len 0)
+strings_data_pool_add("" offset)
+set(mcc "")
+
+file(READ "${MCC_JSON_PATH}" json)
+string(JSON len LENGTH "${json}")
+math(EXPR last "${len} - 1")
+foreach(i RANGE ${last})
+	string(JSON item GET "${json}" ${i})
+	string(JSON code GET "${item}" mcc)
+	string(JSON desc GET "${item}" edited_description)
+	strings_data_pool_add("${desc}" offset)
+
+	# Retain the last entry for each MCC, as is the case for runtime JSON
+	# parsing, and ignore invalid MCCs
+	math(EXPR code "${code}") # Remove leading zeros
+	if(code LESS 10000)
+		strings_data_table_add(mcc "${code}" ${offset} REPLACE)
+	endif()
+endforeach()
+
+set(content "${header_comment}")
+string(APPEND content "#ifndef MCC_DATA_H\n#define MCC_DATA_H\n\n#include <cstdint>\n\n")
+string(APPEND content "static const char mcc_data_str[] =\n${pool};\n\n")
+strings_data_table_emit_dense(mcc_data_desc mcc 10000 table_content)
+string(APPEND content "${table_content}")
+string(APPEND content "#endif\n")
+file(WRITE "${OUTPUT_DIR}/mcc_data.h" "${content}")
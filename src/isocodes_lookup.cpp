@@ -24,9 +24,13 @@
 
 #include <string>
 #include <vector>
-#include <map>
-#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 
 // Some versions of json-c headers have unused static inline functions that
 // trigger -Wunused-function
@@ -38,35 +42,160 @@
 
 typedef bool (*isocodes_list_append_func_t)(json_object* jso);
 
-struct isocodes_country_t {
-	std::string name;
-	std::string alpha2;
-	std::string alpha3;
-	std::string numeric;
+// Lookup tables reference names in a string pool by offset, where offset
+// zero is an empty string that indicates an absent entry. Numeric codes
+// directly index dense tables while alpha codes are packed into integer keys,
+// one byte per character, for binary search of tables sorted by key.
+#define ISOCODES_NUMERIC_COUNT (1000)
+
+struct isocodes_alpha_t {
+	uint32_t code; // Packed alpha code
+	uint32_t name; // Offset of name in string pool
 };
-static std::vector<isocodes_country_t> country_list;
-static std::map<std::string,const isocodes_country_t&> country_alpha2_map;
-static std::map<std::string,const isocodes_country_t&> country_alpha3_map;
-static std::map<unsigned int,const isocodes_country_t&> country_numeric_map;
-
-struct isocodes_currency_t {
-	std::string name;
-	std::string alpha3;
-	std::string numeric;
+
+struct isocodes_alpha_table_t {
+	const isocodes_alpha_t* entries;
+	std::size_t count;
 };
-static std::vector<isocodes_currency_t> currency_list;
-static std::map<std::string,const isocodes_currency_t&> currency_alpha3_map;
-static std::map<unsigned int,const isocodes_currency_t&> currency_numeric_map;
-
-struct isocodes_language_t {
-	std::string name;
-	std::string alpha2;
-	std::string alpha3;
+
+struct isocodes_tables_t {
+	const char* str;
+	const uint32_t* country_numeric;
+	const uint32_t* currency_numeric;
+	isocodes_alpha_table_t country_alpha2;
+	isocodes_alpha_table_t country_alpha3;
+	isocodes_alpha_table_t currency_alpha3;
+	isocodes_alpha_table_t language_alpha2;
+	isocodes_alpha_table_t language_alpha3;
 };
-static std::vector<isocodes_language_t> language_list;
-static std::map<std::string,const isocodes_language_t&> language_alpha2_map;
-static std::map<std::string,const isocodes_language_t&> language_alpha3_map;
 
+// Tables used by lookups. Empty until isocodes_init() succeeds.
+static isocodes_tables_t isocodes_tables;
+
+#ifdef EMV_STRINGS_BUILTIN_DATA
+#include "isocodes_data.h"
+
+template <std::size_t N>
+static constexpr isocodes_alpha_table_t isocodes_alpha_table(const isocodes_alpha_t (&entries)[N])
+{
+	return { entries, N };
+}
+
+// Tables generated from iso-codes package at build time
+static const isocodes_tables_t isocodes_builtin_tables = {
+	isocodes_data_str,
+	isocodes_data_country_numeric,
+	isocodes_data_currency_numeric,
+	isocodes_alpha_table(isocodes_data_country_alpha2),
+	isocodes_alpha_table(isocodes_data_country_alpha3),
+	isocodes_alpha_table(isocodes_data_currency_alpha3),
+	isocodes_alpha_table(isocodes_data_language_alpha2),
+	isocodes_alpha_table(isocodes_data_language_alpha3),
+};
+#endif
+
+// Tables built from iso-codes JSON files at runtime
+struct isocodes_json_tables_t {
+	std::string str;
+	std::vector<uint32_t> country_numeric;
+	std::vector<uint32_t> currency_numeric;
+	std::vector<isocodes_alpha_t> country_alpha2;
+	std::vector<isocodes_alpha_t> country_alpha3;
+	std::vector<isocodes_alpha_t> currency_alpha3;
+	std::vector<isocodes_alpha_t> language_alpha2;
+	std::vector<isocodes_alpha_t> language_alpha3;
+};
+static isocodes_json_tables_t json_tables;
+
+// Lazy initialisation state. Lookups only acquire the mutex until the data
+// has been loaded, either explicitly or upon first lookup.
+static std::atomic<bool> isocodes_loaded(false);
+static std::mutex isocodes_mutex;
+static std::string isocodes_lazy_path; // Empty for default path
+static std::atomic<int> isocodes_load_result(0); // Result of most recent load
+
+static uint32_t isocodes_pack_alpha(const char* code, std::size_t len)
+{
+	uint32_t packed = 0;
+
+	if (!code) {
+		return 0;
+	}
+
+	for (std::size_t i = 0; i < len; ++i) {
+		if (!code[i]) {
+			// Code too short
+			return 0;
+		}
+		packed = (packed << 8) | static_cast<unsigned char>(code[i]);
+	}
+	if (code[len]) {
+		// Code too long
+		return 0;
+	}
+
+	return packed;
+}
+
+static uint32_t json_tables_add_str(const char* str)
+{
+	uint32_t offset = json_tables.str.size();
+
+	// Include null-termination in string pool
+	json_tables.str.append(str, std::char_traits<char>::length(str) + 1);
+	return offset;
+}
+
+static bool json_tables_add_numeric(
+	std::vector<uint32_t>& table,
+	const char* numeric_str,
+	uint32_t name
+)
+{
+	char* endptr;
+	unsigned long numeric;
+
+	numeric = std::strtoul(numeric_str, &endptr, 10);
+	if (!*numeric_str || *endptr || numeric >= ISOCODES_NUMERIC_COUNT) {
+		return false;
+	}
+
+	// Retain first entry for each numeric code
+	if (!table[numeric]) {
+		table[numeric] = name;
+	}
+	return true;
+}
+
+static void json_tables_add_alpha(
+	std::vector<isocodes_alpha_t>& table,
+	const char* alpha_str,
+	std::size_t len,
+	uint32_t name
+)
+{
+	uint32_t packed = isocodes_pack_alpha(alpha_str, len);
+	if (!packed) {
+		// Ignore codes of unexpected length, like the qaa-qtz range
+		return;
+	}
+
+	table.push_back({ packed, name });
+}
+
+static void json_tables_sort_alpha(std::vector<isocodes_alpha_t>& table)
+{
+	auto less = [](const isocodes_alpha_t& a, const isocodes_alpha_t& b) {
+		return a.code < b.code;
+	};
+	auto equal = [](const isocodes_alpha_t& a, const isocodes_alpha_t& b) {
+		return a.code == b.code;
+	};
+
+	// Retain first entry for each alpha code
+	std::stable_sort(table.begin(), table.end(), less);
+	table.erase(std::unique(table.begin(), table.end(), equal), table.end());
+}
 
 static bool country_list_append(json_object* jso)
 {
@@ -126,8 +255,13 @@ static bool country_list_append(json_object* jso)
 		return false;
 	}
 
-	// Populate country list entry
-	country_list.push_back({ name_str, alpha_2_str, alpha_3_str, numeric_str });
+	// Populate country tables
+	uint32_t name = json_tables_add_str(name_str);
+	json_tables_add_alpha(json_tables.country_alpha2, alpha_2_str, 2, name);
+	json_tables_add_alpha(json_tables.country_alpha3, alpha_3_str, 3, name);
+	if (!json_tables_add_numeric(json_tables.country_numeric, numeric_str, name)) {
+		return false;
+	}
 
 	return true;
 }
@@ -178,8 +312,12 @@ static bool currency_list_append(json_object* jso)
 		return false;
 	}
 
-	// Populate currency list entry
-	currency_list.push_back({ name_str, alpha_3_str, numeric_str });
+	// Populate currency tables
+	uint32_t name = json_tables_add_str(name_str);
+	json_tables_add_alpha(json_tables.currency_alpha3, alpha_3_str, 3, name);
+	if (!json_tables_add_numeric(json_tables.currency_numeric, numeric_str, name)) {
+		return false;
+	}
 
 	return true;
 }
@@ -230,8 +368,10 @@ static bool language_list_append(json_object* jso)
 		return false;
 	}
 
-	// Populate language list entry
-	language_list.push_back({ name_str, alpha_2_str, alpha_3_str });
+	// Populate language tables
+	uint32_t name = json_tables_add_str(name_str);
+	json_tables_add_alpha(json_tables.language_alpha2, alpha_2_str, 2, name);
+	json_tables_add_alpha(json_tables.language_alpha3, alpha_3_str, 3, name);
 
 	return true;
 }
@@ -319,26 +459,15 @@ static bool build_country_list(json_object* json_root) noexcept
 		return false;
 	}
 
-	country_list.reserve(iso3166_1_array_length);
+	json_tables.country_alpha2.reserve(iso3166_1_array_length);
+	json_tables.country_alpha3.reserve(iso3166_1_array_length);
 	r = json_c_visit(iso3166_1_obj, 0, &json_array_visit_userfunc, (void*)&country_list_append);
 	if (r) {
 		return false;
 	}
 
-	// Build alpha2->country map
-	for (auto&& country : country_list) {
-		country_alpha2_map.emplace(country.alpha2, country);
-	}
-
-	// Build alpha3->country map
-	for (auto&& country : country_list) {
-		country_alpha3_map.emplace(country.alpha3, country);
-	}
-
-	// Build numeric->country map
-	for (auto&& country : country_list) {
-		country_numeric_map.emplace(std::stoul(country.numeric), country);
-	}
+	json_tables_sort_alpha(json_tables.country_alpha2);
+	json_tables_sort_alpha(json_tables.country_alpha3);
 
 	return true;
 }
@@ -378,21 +507,13 @@ static bool build_currency_list(json_object* json_root) noexcept
 		return false;
 	}
 
-	currency_list.reserve(iso4217_array_length);
+	json_tables.currency_alpha3.reserve(iso4217_array_length);
 	r = json_c_visit(iso4217_obj, 0, &json_array_visit_userfunc, (void*)&currency_list_append);
 	if (r) {
 		return false;
 	}
 
-	// Build alpha3->currency map
-	for (auto&& currency : currency_list) {
-		currency_alpha3_map.emplace(currency.alpha3, currency);
-	}
-
-	// Build numeric->currency map
-	for (auto&& currency : currency_list) {
-		currency_numeric_map.emplace(std::stoul(currency.numeric), currency);
-	}
+	json_tables_sort_alpha(json_tables.currency_alpha3);
 
 	return true;
 }
@@ -432,34 +553,41 @@ static bool build_language_list(json_object* json_root) noexcept
 		return false;
 	}
 
-	language_list.reserve(iso_639_2_array_length);
+	json_tables.language_alpha2.reserve(iso_639_2_array_length);
+	json_tables.language_alpha3.reserve(iso_639_2_array_length);
 	r = json_c_visit(iso_639_2_obj, 0, &json_array_visit_userfunc, (void*)language_list_append);
 	if (r) {
 		return false;
 	}
 
-	// Build alpha2->language map
-	for (auto&& language : language_list) {
-		if (!language.alpha2.empty()) {
-			language_alpha2_map.emplace(language.alpha2, language);
-		}
-	}
-
-	// Build alpha3->language map
-	for (auto&& language : language_list) {
-		language_alpha3_map.emplace(language.alpha3, language);
-	}
+	json_tables_sort_alpha(json_tables.language_alpha2);
+	json_tables_sort_alpha(json_tables.language_alpha3);
 
 	return true;
 }
 
-int isocodes_init(const char* path)
+static int isocodes_load(const char* path)
 {
 	bool result;
 	std::string path_str;
 	json_object* json_root;
 	std::string filename;
 
+#ifdef EMV_STRINGS_BUILTIN_DATA
+	if (!path) {
+		// Use data generated from iso-codes package at build time
+		isocodes_tables = isocodes_builtin_tables;
+		return 0;
+	}
+#endif
+
+	// Prepare tables for JSON data
+	isocodes_tables = isocodes_tables_t();
+	json_tables = isocodes_json_tables_t();
+	json_tables.str.assign(1, 0); // Offset zero is an empty string
+	json_tables.country_numeric.assign(ISOCODES_NUMERIC_COUNT, 0);
+	json_tables.currency_numeric.assign(ISOCODES_NUMERIC_COUNT, 0);
+
 	if (path) {
 		path_str = path;
 	} else {
@@ -511,82 +639,145 @@ int isocodes_init(const char* path)
 		return -3;
 	}
 
+	// Use tables built from JSON data
+	isocodes_tables.str = json_tables.str.c_str();
+	isocodes_tables.country_numeric = json_tables.country_numeric.data();
+	isocodes_tables.currency_numeric = json_tables.currency_numeric.data();
+	isocodes_tables.country_alpha2 = { json_tables.country_alpha2.data(), json_tables.country_alpha2.size() };
+	isocodes_tables.country_alpha3 = { json_tables.country_alpha3.data(), json_tables.country_alpha3.size() };
+	isocodes_tables.currency_alpha3 = { json_tables.currency_alpha3.data(), json_tables.currency_alpha3.size() };
+	isocodes_tables.language_alpha2 = { json_tables.language_alpha2.data(), json_tables.language_alpha2.size() };
+	isocodes_tables.language_alpha3 = { json_tables.language_alpha3.data(), json_tables.language_alpha3.size() };
+
 	return 0;
 }
 
-const char* isocodes_lookup_country_by_alpha2(const char* alpha2)
+int isocodes_init(const char* path)
 {
-	auto itr = country_alpha2_map.find(alpha2);
-	if (itr == country_alpha2_map.end()) {
-		// Alpha2 country code not found
-		return nullptr;
-	}
+	int r;
+	std::lock_guard<std::mutex> lock(isocodes_mutex);
 
-	return itr->second.name.c_str();
+	r = isocodes_load(path);
+	isocodes_load_result.store(r);
+	isocodes_loaded.store(true, std::memory_order_release);
+
+	return r;
 }
 
-const char* isocodes_lookup_country_by_alpha3(const char* alpha3)
+void isocodes_init_lazy(const char* path)
 {
-	auto itr = country_alpha3_map.find(alpha3);
-	if (itr == country_alpha3_map.end()) {
-		// Alpha3 country code not found
-		return nullptr;
+	std::lock_guard<std::mutex> lock(isocodes_mutex);
+
+	if (path) {
+		isocodes_lazy_path = path;
+	} else {
+		isocodes_lazy_path.clear();
 	}
+	isocodes_load_result.store(0);
+	isocodes_loaded.store(false, std::memory_order_release);
+}
 
-	return itr->second.name.c_str();
+int isocodes_get_load_result(void)
+{
+	return isocodes_load_result.load();
 }
 
-const char* isocodes_lookup_country_by_numeric(unsigned int numeric)
+static void isocodes_lazy_load()
 {
-	auto itr = country_numeric_map.find(numeric);
-	if (itr == country_numeric_map.end()) {
-		// Numeric country code not found
-		return nullptr;
+	if (isocodes_loaded.load(std::memory_order_acquire)) {
+		// Already loaded
+		return;
 	}
 
-	return itr->second.name.c_str();
+	std::lock_guard<std::mutex> lock(isocodes_mutex);
+	if (isocodes_loaded.load(std::memory_order_relaxed)) {
+		// Loaded by another thread
+		return;
+	}
+
+	// Failure is not retried for every lookup and lookups will not find
+	// anything. Use isocodes_get_load_result() to obtain the error.
+	isocodes_load_result.store(isocodes_load(isocodes_lazy_path.empty() ? nullptr : isocodes_lazy_path.c_str()));
+	isocodes_loaded.store(true, std::memory_order_release);
 }
 
-const char* isocodes_lookup_currency_by_alpha3(const char* alpha3)
+static const char* isocodes_lookup_numeric(const uint32_t* table, unsigned int numeric)
 {
-	auto itr = currency_alpha3_map.find(alpha3);
-	if (itr == currency_alpha3_map.end()) {
-		// Alpha3 currency code not found
+	if (!table || numeric >= ISOCODES_NUMERIC_COUNT || !table[numeric]) {
 		return nullptr;
 	}
 
-	return itr->second.name.c_str();
+	return isocodes_tables.str + table[numeric];
 }
 
-const char* isocodes_lookup_currency_by_numeric(unsigned int numeric)
+static const char* isocodes_lookup_alpha(
+	const isocodes_alpha_table_t& table,
+	const char* alpha,
+	std::size_t len
+)
 {
-	auto itr = currency_numeric_map.find(numeric);
-	if (itr == currency_numeric_map.end()) {
-		// Numeric currency code not found
+	uint32_t packed;
+	const isocodes_alpha_t* end;
+
+	packed = isocodes_pack_alpha(alpha, len);
+	if (!packed || !table.count) {
+		return nullptr;
+	}
+
+	end = table.entries + table.count;
+	auto itr = std::lower_bound(
+		table.entries,
+		end,
+		packed,
+		[](const isocodes_alpha_t& entry, uint32_t code) {
+			return entry.code < code;
+		}
+	);
+	if (itr == end || itr->code != packed) {
 		return nullptr;
 	}
 
-	return itr->second.name.c_str();
+	return isocodes_tables.str + itr->name;
 }
 
-const char* isocodes_lookup_language_by_alpha2(const char* alpha2)
+const char* isocodes_lookup_country_by_alpha2(const char* alpha2)
 {
-	auto itr = language_alpha2_map.find(alpha2);
-	if (itr == language_alpha2_map.end()) {
-		// Alpha2 language code not found
-		return nullptr;
-	}
+	isocodes_lazy_load();
+	return isocodes_lookup_alpha(isocodes_tables.country_alpha2, alpha2, 2);
+}
 
-	return itr->second.name.c_str();
+const char* isocodes_lookup_country_by_alpha3(const char* alpha3)
+{
+	isocodes_lazy_load();
+	return isocodes_lookup_alpha(isocodes_tables.country_alpha3, alpha3, 3);
 }
 
-const char* isocodes_lookup_language_by_alpha3(const char* alpha3)
+const char* isocodes_lookup_country_by_numeric(unsigned int numeric)
 {
-	auto itr = language_alpha3_map.find(alpha3);
-	if (itr == language_alpha3_map.end()) {
-		// Alpha3 language code not found
-		return nullptr;
-	}
+	isocodes_lazy_load();
+	return isocodes_lookup_numeric(isocodes_tables.country_numeric, numeric);
+}
 
-	return itr->second.name.c_str();
+const char* isocodes_lookup_currency_by_alpha3(const char* alpha3)
+{
+	isocodes_lazy_load();
+	return isocodes_lookup_alpha(isocodes_tables.currency_alpha3, alpha3, 3);
+}
+
+const char* isocodes_lookup_currency_by_numeric(unsigned int numeric)
+{
+	isocodes_lazy_load();
+	return isocodes_lookup_numeric(isocodes_tables.currency_numeric, numeric);
+}
+
+const char* isocodes_lookup_language_by_alpha2(const char* alpha2)
+{
+	isocodes_lazy_load();
+	return isocodes_lookup_alpha(isocodes_tables.language_alpha2, alpha2, 2);
+}
+
+const char* isocodes_lookup_language_by_alpha3(const char* alpha3)
+{
+	isocodes_lazy_load();
+	return isocodes_lookup_alpha(isocodes_tables.language_alpha3, alpha3, 3);
 }
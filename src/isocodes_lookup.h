@@ -2,7 +2,7 @@
  * @file isocodes_lookup.h
  * @brief Wrapper for iso-codes package
  *
- * Copyright 2021, 2023 Leon Lynch
+ * Copyright 2021, 2023, 2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -28,12 +28,42 @@ __BEGIN_DECLS
 
 /**
  * Initialise lookup data from installed iso-codes package
+ *
+ * If emv_strings was built with the BUILD_EMV_STRINGS_DATA option, the
+ * default is to use lookup tables generated from the iso-codes package at
+ * build time and no JSON files are parsed at runtime. Specify @p path to
+ * parse the JSON files at runtime instead, for example to use newer data.
+ *
+ * Calling this function is optional because the first lookup will load the
+ * lookup data if it has not been loaded yet. See @ref isocodes_init_lazy().
+ * This function should not be called concurrently with lookups.
+ *
  * @param path Override directory path where iso-codes JSON files can be found.
- *             NULL for default path.
+ *             NULL for default path or built-in data.
  * @return Zero for success. Less than zero for internal error. Greater than zero if iso-codes package not found.
  */
 int isocodes_init(const char* path);
 
+/**
+ * Configure lookup data to be loaded upon first lookup, using the same
+ * process as @ref isocodes_init(). Loading upon first lookup is thread-safe
+ * and a failure to load results in lookups not finding any data. This
+ * function should not be called concurrently with lookups.
+ *
+ * @param path Override directory path where iso-codes JSON files can be found.
+ *             NULL for default path or built-in data.
+ */
+void isocodes_init_lazy(const char* path);
+
+/**
+ * Retrieve result of most recent attempt to load lookup data, either by
+ * @ref isocodes_init() or upon first lookup after @ref isocodes_init_lazy().
+ * This allows the caller to detect a failure to load upon first lookup.
+ *
+ * @return Zero for success or if no attempt was made yet. Less than zero for internal error. Greater than zero if iso-codes package not found.
+ */
+int isocodes_get_load_result(void);
+
 /**
  * Lookup country name by ISO 3166-1 2-digit alpha code
  * @param alpha2 ISO 3166-1 2-digit alpha code
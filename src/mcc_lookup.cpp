@@ -23,7 +23,10 @@
 #include "emv_utils_config.h"
 
 #include <string>
-#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 
 // Some versions of json-c headers have unused static inline functions that
 // trigger -Wunused-function
@@ -33,11 +36,43 @@
 #include <json-c/json_visit.h>
 #pragma GCC diagnostic pop
 
-typedef bool (*mcc_map_add_func_t)(json_object* jso);
+typedef bool (*mcc_table_add_func_t)(json_object* jso);
 
-static std::map<unsigned int,std::string> mcc_map;
+// The lookup table is directly indexed by MCC and references descriptions in
+// a string pool by offset, where offset zero is an empty string that
+// indicates an absent entry
+#define MCC_COUNT (10000)
 
-static bool mcc_map_add(json_object* jso)
+struct mcc_tables_t {
+	const char* str;
+	const uint32_t* desc;
+};
+
+// Tables used by lookups. Empty until mcc_init() succeeds.
+static mcc_tables_t mcc_tables;
+
+#ifdef EMV_STRINGS_BUILTIN_DATA
+#include "mcc_data.h"
+
+// Tables generated from mcc-codes JSON file at build time
+static const mcc_tables_t mcc_builtin_tables = {
+	mcc_data_str,
+	mcc_data_desc,
+};
+#endif
+
+// Tables built from mcc-codes JSON file at runtime
+static std::string json_str;
+static std::vector<uint32_t> json_desc;
+
+// Lazy initialisation state. Lookups only acquire the mutex until the data
+// has been loaded, either explicitly or upon first lookup.
+static std::atomic<bool> mcc_loaded(false);
+static std::mutex mcc_mutex;
+static std::string mcc_lazy_path; // Empty for default path
+static std::atomic<int> mcc_load_result(0); // Result of most recent load
+
+static bool mcc_table_add(json_object* jso)
 {
 	/* mcc-codes submodule's mcc_codes.json file should have this structure
 	{
@@ -77,8 +112,14 @@ static bool mcc_map_add(json_object* jso)
 		return false;
 	}
 
-	// Add to map
-	mcc_map[mcc_number] = desc_str;
+	if (mcc_number >= MCC_COUNT) {
+		// Ignore invalid MCC
+		return true;
+	}
+
+	// Add to table and retain last entry for each MCC
+	json_desc[mcc_number] = json_str.size();
+	json_str.append(desc_str, std::char_traits<char>::length(desc_str) + 1);
 
 	return true;
 }
@@ -105,12 +146,12 @@ static int json_array_visit_userfunc(
 
 	// If there is an index and it is an object, then it is an array entry
 	if (jso_index && json_object_is_type(jso, json_type_object)) {
-		mcc_map_add_func_t mcc_map_add;
+		mcc_table_add_func_t mcc_table_add;
 		bool result;
 
 		// Append object to the appropriate using the function pointer provided by userarg
-		mcc_map_add = (mcc_map_add_func_t)userarg;
-		result = mcc_map_add(jso);
+		mcc_table_add = (mcc_table_add_func_t)userarg;
+		result = mcc_table_add(jso);
 		if (!result) {
 			return JSON_C_VISIT_RETURN_ERROR;
 		}
@@ -162,7 +203,7 @@ static bool build_mcc_list(json_object* json_root) noexcept
 		return false;
 	}
 
-	r = json_c_visit(json_root, 0, &json_array_visit_userfunc, (void*)&mcc_map_add);
+	r = json_c_visit(json_root, 0, &json_array_visit_userfunc, (void*)&mcc_table_add);
 	if (r) {
 		return false;
 	}
@@ -170,19 +211,32 @@ static bool build_mcc_list(json_object* json_root) noexcept
 	return true;
 }
 
-int mcc_init(const char* path)
+static int mcc_load(const char* path)
 {
 	bool result;
 	std::string filename;
 	json_object* json_root;
 
+#ifdef EMV_STRINGS_BUILTIN_DATA
+	if (!path) {
+		// Use data generated from mcc-codes submodule at build time
+		mcc_tables = mcc_builtin_tables;
+		return 0;
+	}
+#endif
+
+	// Prepare tables for JSON data
+	mcc_tables = mcc_tables_t();
+	json_str.assign(1, 0); // Offset zero is an empty string
+	json_desc.assign(MCC_COUNT, 0);
+
 	if (path) {
 		filename = path;
 	} else {
 		filename = MCC_JSON_INSTALL_PATH;
 	}
 
-	// Parse JSON file and build MCC list
+	// Parse JSON file and build MCC table
 	json_root = json_object_from_file(filename.c_str());
 	if (!json_root) {
 		std::fprintf(stderr, "%s", json_util_get_last_err());
@@ -195,16 +249,70 @@ int mcc_init(const char* path)
 		return -1;
 	}
 
+	// Use tables built from JSON data
+	mcc_tables.str = json_str.c_str();
+	mcc_tables.desc = json_desc.data();
+
 	return 0;
 }
 
+int mcc_init(const char* path)
+{
+	int r;
+	std::lock_guard<std::mutex> lock(mcc_mutex);
+
+	r = mcc_load(path);
+	mcc_load_result.store(r);
+	mcc_loaded.store(true, std::memory_order_release);
+
+	return r;
+}
+
+void mcc_init_lazy(const char* path)
+{
+	std::lock_guard<std::mutex> lock(mcc_mutex);
+
+	if (path) {
+		mcc_lazy_path = path;
+	} else {
+		mcc_lazy_path.clear();
+	}
+	mcc_load_result.store(0);
+	mcc_loaded.store(false, std::memory_order_release);
+}
+
+int mcc_get_load_result(void)
+{
+	return mcc_load_result.load();
+}
+
+static void mcc_lazy_load()
+{
+	if (mcc_loaded.load(std::memory_order_acquire)) {
+		// Already loaded
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mcc_mutex);
+	if (mcc_loaded.load(std::memory_order_relaxed)) {
+		// Loaded by another thread
+		return;
+	}
+
+	// Failure is not retried for every lookup and lookups will not find
+	// anything. Use mcc_get_load_result() to obtain the error.
+	mcc_load_result.store(mcc_load(mcc_lazy_path.empty() ? nullptr : mcc_lazy_path.c_str()));
+	mcc_loaded.store(true, std::memory_order_release);
+}
+
 const char* mcc_lookup(unsigned int mcc)
 {
-	auto itr = mcc_map.find(mcc);
-	if (itr == mcc_map.end()) {
+	mcc_lazy_load();
+
+	if (!mcc_tables.desc || mcc >= MCC_COUNT || !mcc_tables.desc[mcc]) {
 		// Merchant Category Code (MCC) not found
 		return nullptr;
 	}
 
-	return itr->second.c_str();
+	return mcc_tables.str + mcc_tables.desc[mcc];
 }
@@ -2,7 +2,7 @@
  * @file mcc_lookup.h
  * @brief ISO 18245 Merchant Category Code (MCC) lookup helper functions
  *
- * Copyright 2023 Leon Lynch
+ * Copyright 2023, 2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -28,11 +28,43 @@ __BEGIN_DECLS
 
 /**
  * Initialise Merchant Category Code (MCC) data
- * @param path Override path of mcc-codes JSON file. NULL for default path.
+ *
+ * If emv_strings was built with the BUILD_EMV_STRINGS_DATA option, the
+ * default is to use a lookup table generated from the mcc-codes JSON file at
+ * build time and no JSON file is parsed at runtime. Specify @p path to parse
+ * the JSON file at runtime instead, for example to use newer data.
+ *
+ * Calling this function is optional because the first lookup will load the
+ * lookup data if it has not been loaded yet. See @ref mcc_init_lazy().
+ * This function should not be called concurrently with lookups.
+ *
+ * @param path Override path of mcc-codes JSON file. NULL for default path or
+ *             built-in data.
  * @return Zero for success. Less than zero for internal error. Greater than zero if mcc-codes JSON file not found.
  */
 int mcc_init(const char* path);
 
+/**
+ * Configure Merchant Category Code (MCC) data to be loaded upon first
+ * lookup, using the same process as @ref mcc_init(). Loading upon first
+ * lookup is thread-safe and a failure to load results in lookups not finding
+ * any data. This function should not be called concurrently with lookups.
+ *
+ * @param path Override path of mcc-codes JSON file. NULL for default path or
+ *             built-in data.
+ */
+void mcc_init_lazy(const char* path);
+
+/**
+ * Retrieve result of most recent attempt to load Merchant Category Code (MCC)
+ * data, either by @ref mcc_init() or upon first lookup after
+ * @ref mcc_init_lazy(). This allows the caller to detect a failure to load
+ * upon first lookup.
+ *
+ * @return Zero for success or if no attempt was made yet. Less than zero for internal error. Greater than zero if mcc-codes JSON file not found.
+ */
+int mcc_get_load_result(void);
+
 /**
  * Lookup Merchant Category Code (MCC) string
  * @param mcc Merchant Category Code (MCC)
@@ -0,0 +1,210 @@
+/**
+ * @file emv_capk_concurrency_test.c
+ * @brief Unit tests for concurrent use of CAPK helper functions
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_capk.h"
+#include "emv_utils_config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define READER_COUNT (4)
+#define WRITER_ITERATIONS (500)
+
+static const uint8_t visa_92_rid[] = { 0xA0, 0x00, 0x00, 0x00, 0x03 };
+static const uint8_t visa_92_index = 0x92;
+
+// Copy of the expected CAPK content because readers compare the CAPK that
+// they retrieve against it while the CAPK store is being updated
+static uint8_t expected_modulus[256];
+static size_t expected_modulus_len;
+
+static atomic_bool stop = false;
+static atomic_uint found_total = 0;
+
+struct reader_t {
+	pthread_t thread;
+	unsigned int found_count;
+	unsigned int itr_count;
+	unsigned int error_count;
+};
+
+static void* reader_func(void* arg)
+{
+	struct reader_t* reader = arg;
+
+	while (!atomic_load(&stop)) {
+		struct emv_capk_ref_t ref;
+		const struct emv_capk_t* capk;
+		struct emv_capk_itr_t itr;
+		unsigned int i = 0;
+
+		// Lookup CAPK and use it while the CAPK store may be cleared
+		capk = emv_capk_acquire(visa_92_rid, visa_92_index, &ref);
+		if (capk) {
+			++reader->found_count;
+			atomic_fetch_add(&found_total, 1);
+			if (capk->modulus_len != expected_modulus_len ||
+				memcmp(capk->modulus, expected_modulus, expected_modulus_len) != 0 ||
+				memcmp(capk->rid, visa_92_rid, sizeof(visa_92_rid)) != 0 ||
+				capk->index != visa_92_index
+			) {
+				++reader->error_count;
+			}
+		}
+		emv_capk_release(&ref);
+
+		// Iterate part of the CAPK store and release the iterator early
+		if (emv_capk_itr_init(&itr)) {
+			++reader->error_count;
+			continue;
+		}
+		while ((capk = emv_capk_itr_next(&itr)) != NULL) {
+			if (capk->index == visa_92_index &&
+				memcmp(capk->rid, visa_92_rid, sizeof(visa_92_rid)) == 0 &&
+				(capk->modulus_len != expected_modulus_len ||
+				memcmp(capk->modulus, expected_modulus, expected_modulus_len) != 0)
+			) {
+				++reader->error_count;
+			}
+			++reader->itr_count;
+			if (++i == 3) {
+				break;
+			}
+		}
+		emv_capk_itr_release(&itr);
+	}
+
+	return NULL;
+}
+
+int main(void)
+{
+	int r;
+	const struct emv_capk_t* capk;
+	struct emv_capk_t dynamic_capk;
+	struct reader_t readers[READER_COUNT];
+	unsigned int found_count = 0;
+	unsigned int itr_count = 0;
+
+	r = emv_capk_load_static();
+	if (r) {
+		fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Use a copy of a built-in CAPK as a dynamic CAPK that overrides the
+	// built-in CAPK such that readers find both versions
+	capk = emv_capk_lookup(visa_92_rid, visa_92_index);
+	if (!capk || capk->modulus_len > sizeof(expected_modulus)) {
+		fprintf(stderr, "emv_capk_lookup() failed\n");
+		return 1;
+	}
+	memcpy(expected_modulus, capk->modulus, capk->modulus_len);
+	expected_modulus_len = capk->modulus_len;
+	dynamic_capk = *capk;
+
+	printf("Testing concurrent lookup and iteration during updates...\n");
+	memset(readers, 0, sizeof(readers));
+	for (size_t i = 0; i < READER_COUNT; ++i) {
+		r = pthread_create(&readers[i].thread, NULL, &reader_func, &readers[i]);
+		if (r) {
+			fprintf(stderr, "pthread_create() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < WRITER_ITERATIONS; ++i) {
+		r = emv_capk_add(&dynamic_capk);
+		if (r) {
+			fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+			break;
+		}
+		r = emv_capk_add(&dynamic_capk);
+		if (r) {
+			fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+			break;
+		}
+		emv_capk_clear();
+		r = emv_capk_add(&dynamic_capk);
+		if (r) {
+			fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+			break;
+		}
+		r = emv_capk_load_static();
+		if (r) {
+			fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+			break;
+		}
+		emv_capk_clear();
+		r = emv_capk_load_static();
+		if (r) {
+			fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+			break;
+		}
+	}
+
+	// Ensure that readers had the opportunity to find the CAPK, even on
+	// systems where the writer was not preempted
+	while (!r && !atomic_load(&found_total)) {
+		sched_yield();
+	}
+	atomic_store(&stop, true);
+	for (size_t i = 0; i < READER_COUNT; ++i) {
+		pthread_join(readers[i].thread, NULL);
+		found_count += readers[i].found_count;
+		itr_count += readers[i].itr_count;
+		if (readers[i].error_count) {
+			fprintf(stderr, "Reader %zu found %u invalid CAPKs\n", i, readers[i].error_count);
+			r = 1;
+		}
+	}
+	emv_capk_clear();
+	if (r) {
+		return 1;
+	}
+	if (!found_count || !itr_count) {
+		fprintf(stderr, "Readers did not find any CAPKs\n");
+		return 1;
+	}
+	printf("Readers found %u CAPKs and iterated %u CAPKs\n", found_count, itr_count);
+
+	printf("Success\n");
+
+	return 0;
+}
+
+#else
+
+int main(void)
+{
+	printf("Thread support not available; skipping\n");
+	return 0;
+}
+
+#endif
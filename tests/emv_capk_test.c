@@ -407,6 +407,29 @@ int main(void)
 		return 1;
 	}
 
+	// Most recently added CAPK should take priority
+	r = emv_capk_add(&capk_lookup_tests[0]);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		return 1;
+	}
+
+	printf("Looking up CAPK %02X%02X%02X%02X%02X #%02X\n",
+		visa_92_rid[0], visa_92_rid[1], visa_92_rid[2], visa_92_rid[3], visa_92_rid[4],
+		0x92
+	);
+	capk = emv_capk_lookup(visa_92_rid, 0x92);
+	if (!capk) {
+		fprintf(stderr, "emv_capk_lookup(%02X%02X%02X%02X%02X, 0x%02X) failed\n",
+			visa_92_rid[0], visa_92_rid[1], visa_92_rid[2], visa_92_rid[3], visa_92_rid[4],
+			0x92
+		);
+		return 1;
+	}
+	if (verify_capk(capk, &capk_lookup_tests[0], 0)) {
+		return 1;
+	}
+
 	printf("\nTesting CAPK clear...\n");
 	emv_capk_clear();
 	capk = emv_capk_lookup(visa_92_rid, 0x92);
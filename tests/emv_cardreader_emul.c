@@ -2,7 +2,7 @@
  * @file emv_cardreader_emul.c
  * @brief Basic card reader emulation for unit tests
  *
- * Copyright 2024 Leon Lynch
+ * Copyright 2024, 2026 Leon Lynch
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -67,3 +67,50 @@ int emv_cardreader_emul(
 
 	return 0;
 }
+
+int emv_cardreader_emul_submit(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t rx_buf_len,
+	emv_cardreader_emul_complete_t complete,
+	void* complete_ctx
+) {
+	struct emv_cardreader_emul_ctx_t* emul_ctx = ctx;
+
+	if (emul_ctx->pending) {
+		fprintf(stderr, "Transmission already pending\n");
+		exit(1);
+		return -104;
+	}
+
+	emul_ctx->pending = true;
+	emul_ctx->tx_buf = tx_buf;
+	emul_ctx->tx_buf_len = tx_buf_len;
+	emul_ctx->rx_buf = rx_buf;
+	emul_ctx->rx_buf_len = rx_buf_len;
+	emul_ctx->complete = complete;
+	emul_ctx->complete_ctx = complete_ctx;
+
+	return 0;
+}
+
+bool emv_cardreader_emul_poll(struct emv_cardreader_emul_ctx_t* ctx)
+{
+	int r;
+	size_t rx_buf_len;
+
+	if (!ctx->pending) {
+		return false;
+	}
+	ctx->pending = false;
+
+	rx_buf_len = ctx->rx_buf_len;
+	r = emv_cardreader_emul(ctx, ctx->tx_buf, ctx->tx_buf_len, ctx->rx_buf, &rx_buf_len);
+
+	// Completion function may submit the next transmission
+	ctx->complete(ctx->complete_ctx, r, rx_buf_len);
+
+	return true;
+}
@@ -22,6 +22,7 @@
 #ifndef EMV_CARDREADER_EMUL_H
 #define EMV_CARDREADER_EMUL_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -33,10 +34,22 @@ struct xpdu_t {
 	const uint8_t* r_xpdu;
 };
 
+/// Card reader emulator asynchronous completion function type
+typedef void (*emv_cardreader_emul_complete_t)(void* complete_ctx, int result, size_t rx_buf_len);
+
 /// Card reader emulator context
 struct emv_cardreader_emul_ctx_t {
 	const struct xpdu_t* xpdu_list;
 	const struct xpdu_t* xpdu_current;
+
+	// Pending asynchronous transmission
+	bool pending;
+	const void* tx_buf;
+	size_t tx_buf_len;
+	void* rx_buf;
+	size_t rx_buf_len;
+	emv_cardreader_emul_complete_t complete;
+	void* complete_ctx;
 };
 
 /**
@@ -56,4 +69,35 @@ int emv_cardreader_emul(
 	size_t* rx_buf_len
 );
 
+/**
+ * Emulate card reader asynchronous transceive submission. The transmission
+ * is only processed by @ref emv_cardreader_emul_poll().
+ *
+ * @param ctx Card reader emulator context
+ * @param tx_buf Transmit buffer
+ * @param tx_buf_len Length of transmit buffer in bytes
+ * @param rx_buf Receive buffer
+ * @param rx_buf_len Length of receive buffer in bytes
+ * @param complete Completion function
+ * @param complete_ctx Completion function context
+ */
+int emv_cardreader_emul_submit(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t rx_buf_len,
+	emv_cardreader_emul_complete_t complete,
+	void* complete_ctx
+);
+
+/**
+ * Process pending asynchronous transmission, if any, and invoke its
+ * completion function. This emulates a single event loop iteration.
+ *
+ * @param ctx Card reader emulator context
+ * @return True if a transmission was processed
+ */
+bool emv_cardreader_emul_poll(struct emv_cardreader_emul_ctx_t* ctx);
+
 #endif
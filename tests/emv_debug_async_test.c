@@ -0,0 +1,358 @@
+/**
+ * @file emv_debug_async_test.c
+ * @brief Unit tests for asynchronous EMV debug event delivery
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_APP
+#include "emv_debug.h"
+#include "emv_tlv.h"
+#include "emv_utils_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+#define TEST_EVENT_MAX (32)
+
+struct test_event_t {
+	enum emv_debug_level_t level;
+	enum emv_debug_type_t debug_type;
+	char str[256];
+	const void* buf_ptr;
+	uint8_t buf[1024];
+	size_t buf_len;
+	bool main_thread;
+};
+
+static struct test_event_t test_events[TEST_EVENT_MAX];
+static unsigned int test_event_count = 0;
+static _Thread_local bool is_main_thread = false;
+
+static const uint8_t test_data[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+static uint8_t test_large_data[600];
+
+static void test_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	struct test_event_t* event;
+
+	if (test_event_count >= TEST_EVENT_MAX) {
+		++test_event_count;
+		return;
+	}
+	event = &test_events[test_event_count++];
+
+	event->level = level;
+	event->debug_type = debug_type;
+	snprintf(event->str, sizeof(event->str), "%s", str);
+	event->buf_ptr = buf;
+	event->buf_len = buf_len;
+	if (buf && debug_type != EMV_DEBUG_TYPE_TLV_LIST && buf_len <= sizeof(event->buf)) {
+		memcpy(event->buf, buf, buf_len);
+	}
+	event->main_thread = is_main_thread;
+}
+
+static void emit_events(const struct emv_tlv_list_t* list)
+{
+	char str[16];
+
+	emv_debug_error("int=%d uint=%u hex=%02X long=%ld llong=%lld size=%zu", -5, 7u, 0xAB, -123456789L, 1234567890123LL, (size_t)42);
+
+	// Strings must be copied because they may not outlive the event
+	snprintf(str, sizeof(str), "hello");
+	emv_debug_info("str=%s|%-8s| pct=100%% double=%.2f char=%c", str, "left", 3.14159, 'x');
+	str[0] = 0;
+
+	// Field width provided as argument is formatted before recording
+	emv_debug_info("width=[%*d]", 6, 42);
+
+	// More arguments than can be recorded
+	emv_debug_info("%d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+
+	emv_debug_info_data("data %u", test_data, sizeof(test_data), 4);
+	emv_debug_trace_msg("trace %s", "message");
+
+	// EMV TLV lists and large data are delivered synchronously
+	emv_debug_info_tlv_list("list", list);
+	emv_debug_info_data("large", test_large_data, sizeof(test_large_data));
+
+	// Data that leaves no room for a string formatted before recording
+	emv_debug_info_data("full width=[%*d]", test_large_data, 512, 6, 42);
+
+	emv_debug_info("last");
+}
+
+#ifdef HAVE_PTHREAD
+#define PRODUCER_COUNT (4)
+#define RESTART_ITERATIONS (200)
+
+static atomic_bool producers_stop = false;
+static atomic_uint producer_event_count = 0;
+static atomic_uint start_success_count = 0;
+
+static void test_count_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	atomic_fetch_add(&producer_event_count, 1);
+}
+
+static void* producer_func(void* arg)
+{
+	unsigned int i = 0;
+
+	while (!atomic_load(&producers_stop)) {
+		// Flushing frequently ensures that producers are likely to be
+		// waiting on the ring buffer when it is stopped
+		emv_debug_info_data("producer %u", test_data, sizeof(test_data), i);
+		if ((++i & 0x3) == 0) {
+			emv_debug_async_flush();
+			emv_debug_async_dropped_count();
+		}
+	}
+
+	return NULL;
+}
+
+static void* starter_func(void* arg)
+{
+	if (emv_debug_async_start(4) == 0) {
+		atomic_fetch_add(&start_success_count, 1);
+	}
+
+	return NULL;
+}
+
+static int test_concurrent_restart(void)
+{
+	int r;
+	pthread_t producers[PRODUCER_COUNT];
+	pthread_t starters[PRODUCER_COUNT];
+
+	r = emv_debug_init(EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_ALL, &test_count_func);
+	if (r) {
+		fprintf(stderr, "emv_debug_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	for (unsigned int i = 0; i < PRODUCER_COUNT; ++i) {
+		r = pthread_create(&producers[i], NULL, &producer_func, NULL);
+		if (r) {
+			fprintf(stderr, "pthread_create() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	// Ring buffer is released while producers may be recording events
+	for (unsigned int i = 0; i < RESTART_ITERATIONS && !r; ++i) {
+		r = emv_debug_async_start(4);
+		if (r) {
+			fprintf(stderr, "emv_debug_async_start() failed; r=%d\n", r);
+		}
+		emv_debug_async_stop();
+	}
+
+	// Only one of many concurrent starts may succeed
+	for (unsigned int i = 0; i < RESTART_ITERATIONS && !r; ++i) {
+		atomic_store(&start_success_count, 0);
+		for (unsigned int j = 0; j < PRODUCER_COUNT; ++j) {
+			pthread_create(&starters[j], NULL, &starter_func, NULL);
+		}
+		for (unsigned int j = 0; j < PRODUCER_COUNT; ++j) {
+			pthread_join(starters[j], NULL);
+		}
+		emv_debug_async_stop();
+		if (atomic_load(&start_success_count) != 1) {
+			fprintf(stderr, "%u concurrent starts succeeded\n", atomic_load(&start_success_count));
+			r = 1;
+		}
+	}
+
+	atomic_store(&producers_stop, true);
+	for (unsigned int i = 0; i < PRODUCER_COUNT; ++i) {
+		pthread_join(producers[i], NULL);
+	}
+	if (r) {
+		return 1;
+	}
+	if (!atomic_load(&producer_event_count)) {
+		fprintf(stderr, "No events delivered\n");
+		return 1;
+	}
+	printf("Delivered %u events\n", atomic_load(&producer_event_count));
+
+	return 0;
+}
+#endif
+
+int main(void)
+{
+	int r;
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+	struct test_event_t expected_events[TEST_EVENT_MAX];
+	unsigned int expected_event_count;
+	unsigned long dropped_count;
+
+	is_main_thread = true;
+	for (size_t i = 0; i < sizeof(test_large_data); ++i) {
+		test_large_data[i] = i;
+	}
+
+	r = emv_debug_init(EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_ALL, &test_debug_func);
+	if (r) {
+		fprintf(stderr, "emv_debug_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Obtain expected events using synchronous delivery
+	emit_events(&list);
+	memcpy(expected_events, test_events, sizeof(expected_events));
+	expected_event_count = test_event_count;
+	if (expected_event_count != 10) {
+		fprintf(stderr, "Unexpected synchronous event count %u\n", expected_event_count);
+		return 1;
+	}
+
+	printf("Testing asynchronous delivery...\n");
+	r = emv_debug_async_start(64);
+	if (r > 0) {
+		printf("Asynchronous delivery not supported\n");
+		return 0;
+	}
+	if (r) {
+		fprintf(stderr, "emv_debug_async_start() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_debug_async_start(64);
+	if (r <= 0) {
+		fprintf(stderr, "emv_debug_async_start() unexpectedly succeeded twice; r=%d\n", r);
+		return 1;
+	}
+
+	memset(test_events, 0, sizeof(test_events));
+	test_event_count = 0;
+	emit_events(&list);
+	emv_debug_async_flush();
+
+	if (test_event_count != expected_event_count) {
+		fprintf(stderr, "Unexpected asynchronous event count %u\n", test_event_count);
+		return 1;
+	}
+	for (unsigned int i = 0; i < expected_event_count; ++i) {
+		const struct test_event_t* event = &test_events[i];
+		const struct test_event_t* expected = &expected_events[i];
+		bool sync_expected;
+
+		if (event->level != expected->level ||
+			event->debug_type != expected->debug_type ||
+			strcmp(event->str, expected->str) != 0 ||
+			event->buf_len != expected->buf_len ||
+			(event->buf_ptr == NULL) != (expected->buf_ptr == NULL)
+		) {
+			fprintf(stderr, "Event %u mismatch: \"%s\" != \"%s\"\n", i, event->str, expected->str);
+			return 1;
+		}
+		if (event->debug_type != EMV_DEBUG_TYPE_TLV_LIST &&
+			memcmp(event->buf, expected->buf, event->buf_len) != 0
+		) {
+			fprintf(stderr, "Event %u data mismatch\n", i);
+			return 1;
+		}
+
+		sync_expected = event->debug_type == EMV_DEBUG_TYPE_TLV_LIST || event->buf_len >= 512;
+		if (event->main_thread != sync_expected) {
+			fprintf(stderr, "Event %u delivered by unexpected thread\n", i);
+			return 1;
+		}
+		if (event->debug_type == EMV_DEBUG_TYPE_TLV_LIST && event->buf_ptr != &list) {
+			fprintf(stderr, "EMV TLV list not delivered by reference\n");
+			return 1;
+		}
+	}
+	if (strcmp(test_events[1].str, "str=hello|left    | pct=100% double=3.14 char=x") != 0) {
+		fprintf(stderr, "Incorrect deferred formatting \"%s\"\n", test_events[1].str);
+		return 1;
+	}
+	if (emv_debug_async_dropped_count() != 0) {
+		fprintf(stderr, "Unexpected dropped events\n");
+		return 1;
+	}
+	emv_debug_async_stop();
+	printf("Success\n");
+
+	printf("Testing asynchronous delivery with full ring buffer...\n");
+	r = emv_debug_async_start(2);
+	if (r) {
+		fprintf(stderr, "emv_debug_async_start() failed; r=%d\n", r);
+		return 1;
+	}
+	test_event_count = 0;
+	for (unsigned int i = 0; i < 100; ++i) {
+		emv_debug_info("event %u", i);
+	}
+	emv_debug_async_flush();
+	dropped_count = emv_debug_async_dropped_count();
+	emv_debug_async_stop();
+	if (test_event_count + dropped_count != 100) {
+		fprintf(stderr, "Delivered %u and dropped %lu events\n", test_event_count, dropped_count);
+		return 1;
+	}
+	printf("Delivered %u and dropped %lu events\n", test_event_count, dropped_count);
+	printf("Success\n");
+
+	printf("Testing synchronous delivery after stop...\n");
+	test_event_count = 0;
+	emv_debug_info("sync");
+	if (test_event_count != 1 || !test_events[0].main_thread) {
+		fprintf(stderr, "Event not delivered synchronously\n");
+		return 1;
+	}
+	printf("Success\n");
+
+#ifdef HAVE_PTHREAD
+	printf("Testing stop and start while other threads emit events...\n");
+	r = test_concurrent_restart();
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+#endif
+
+	return 0;
+}
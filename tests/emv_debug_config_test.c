@@ -0,0 +1,241 @@
+/**
+ * @file emv_debug_config_test.c
+ * @brief Unit tests for per-thread EMV debug configuration
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_TTL
+#include "emv_debug.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+struct test_sink_t {
+	const char* name;
+	unsigned int count;
+	enum emv_debug_level_t last_level;
+	char last_str[256];
+	void* last_user_data;
+};
+
+static struct test_sink_t global_sink = { "global" };
+static struct test_sink_t lane_sink = { "lane" };
+
+static void test_debug_func(
+	struct test_sink_t* sink,
+	enum emv_debug_level_t level,
+	const char* str
+)
+{
+	++sink->count;
+	sink->last_level = level;
+	snprintf(sink->last_str, sizeof(sink->last_str), "%s", str);
+	sink->last_user_data = emv_debug_get_user_data();
+}
+
+static void global_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	test_debug_func(&global_sink, level, str);
+}
+
+static void lane_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	test_debug_func(&lane_sink, level, str);
+}
+
+static void reset_sinks(void)
+{
+	global_sink.count = 0;
+	global_sink.last_str[0] = 0;
+	global_sink.last_user_data = NULL;
+	lane_sink.count = 0;
+	lane_sink.last_str[0] = 0;
+	lane_sink.last_user_data = NULL;
+}
+
+int main(void)
+{
+	int r;
+	int lane_user_data = 42;
+	struct emv_debug_config_t lane_config = {
+		.sources_mask = EMV_DEBUG_SOURCE_TTL,
+		.level = EMV_DEBUG_LEVEL_TRACE,
+		.func = &lane_debug_func,
+		.user_data = &lane_user_data,
+	};
+	struct emv_debug_config_t config;
+	const struct emv_debug_config_t none_config = {
+		.sources_mask = EMV_DEBUG_SOURCE_ALL,
+		.level = EMV_DEBUG_LEVEL_NONE,
+		.func = &lane_debug_func,
+	};
+
+	r = emv_debug_init(EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_INFO, &global_debug_func);
+	if (r) {
+		fprintf(stderr, "emv_debug_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	printf("Testing process-wide configuration...\n");
+	reset_sinks();
+	emv_debug_info("info %d", 1);
+	emv_debug_trace_msg("trace %d", 1);
+	if (global_sink.count != 1 || lane_sink.count != 0) {
+		fprintf(stderr, "Unexpected event count; global=%u; lane=%u\n", global_sink.count, lane_sink.count);
+		return 1;
+	}
+	if (strcmp(global_sink.last_str, "info 1") != 0 || global_sink.last_user_data) {
+		fprintf(stderr, "Unexpected global event \"%s\"\n", global_sink.last_str);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("Testing thread configuration...\n");
+	reset_sinks();
+	r = emv_debug_set_thread_config(&lane_config);
+	if (r) {
+		fprintf(stderr, "emv_debug_set_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Configuration is copied
+	lane_config.level = EMV_DEBUG_LEVEL_NONE;
+
+	emv_debug_info("info %d", 2);
+	emv_debug_trace_msg("trace %d", 2);
+	if (global_sink.count != 0 || lane_sink.count != 2) {
+		fprintf(stderr, "Unexpected event count; global=%u; lane=%u\n", global_sink.count, lane_sink.count);
+		return 1;
+	}
+	if (lane_sink.last_level != EMV_DEBUG_LEVEL_TRACE ||
+		strstr(lane_sink.last_str, "trace 2") == NULL ||
+		lane_sink.last_user_data != &lane_user_data
+	) {
+		fprintf(stderr, "Unexpected lane event \"%s\"\n", lane_sink.last_str);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("Testing thread configuration with asynchronous delivery...\n");
+	reset_sinks();
+	r = emv_debug_async_start(16);
+	if (r < 0) {
+		fprintf(stderr, "emv_debug_async_start() failed; r=%d\n", r);
+		return 1;
+	}
+	emv_debug_info("async %d", 3);
+	emv_debug_async_flush();
+	emv_debug_async_stop();
+	if (global_sink.count != 0 || lane_sink.count != 1) {
+		fprintf(stderr, "Unexpected event count; global=%u; lane=%u\n", global_sink.count, lane_sink.count);
+		return 1;
+	}
+	if (strcmp(lane_sink.last_str, "async 3") != 0 ||
+		lane_sink.last_user_data != &lane_user_data
+	) {
+		fprintf(stderr, "Unexpected lane event \"%s\"\n", lane_sink.last_str);
+		return 1;
+	}
+	if (emv_debug_get_user_data()) {
+		fprintf(stderr, "User data unexpectedly available outside delivery\n");
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("Testing disabled thread configuration...\n");
+	reset_sinks();
+	r = emv_debug_set_thread_config(&none_config);
+	if (r) {
+		fprintf(stderr, "emv_debug_set_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+	emv_debug_error("error %d", 4);
+	if (global_sink.count != 0 || lane_sink.count != 0) {
+		fprintf(stderr, "Unexpected event count; global=%u; lane=%u\n", global_sink.count, lane_sink.count);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("Testing reverting to process-wide configuration...\n");
+	reset_sinks();
+	r = emv_debug_set_thread_config(NULL);
+	if (r) {
+		fprintf(stderr, "emv_debug_set_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+	emv_debug_info("info %d", 5);
+	if (global_sink.count != 1 || lane_sink.count != 0) {
+		fprintf(stderr, "Unexpected event count; global=%u; lane=%u\n", global_sink.count, lane_sink.count);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("Testing retrieval of effective thread configuration...\n");
+	r = emv_debug_get_thread_config(&config);
+	if (r) {
+		fprintf(stderr, "emv_debug_get_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+	if (config.func != &global_debug_func || config.level != EMV_DEBUG_LEVEL_INFO) {
+		fprintf(stderr, "Unexpected process-wide configuration\n");
+		return 1;
+	}
+	lane_config.level = EMV_DEBUG_LEVEL_TRACE;
+	emv_debug_set_thread_config(&lane_config);
+	r = emv_debug_get_thread_config(&config);
+	if (r) {
+		fprintf(stderr, "emv_debug_get_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+	if (config.func != &lane_debug_func || config.user_data != &lane_user_data) {
+		fprintf(stderr, "Unexpected thread configuration\n");
+		return 1;
+	}
+	emv_debug_suppress(true);
+	r = emv_debug_get_thread_config(&config);
+	emv_debug_suppress(false);
+	if (r) {
+		fprintf(stderr, "emv_debug_get_thread_config() failed; r=%d\n", r);
+		return 1;
+	}
+	if (config.func) {
+		fprintf(stderr, "Suppression not reflected by thread configuration\n");
+		return 1;
+	}
+	emv_debug_set_thread_config(NULL);
+	printf("Success\n");
+
+	return 0;
+}
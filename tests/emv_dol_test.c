@@ -163,6 +163,9 @@ int main(void)
 	struct emv_tlv_list_t source1 = EMV_TLV_LIST_INIT;
 	struct emv_tlv_list_t source2 = EMV_TLV_LIST_INIT;
 	const struct emv_tlv_sources_t sources = { 2, { &source1, &source2 } };
+	struct emv_dol_plan_t plan;
+	static struct emv_dol_cache_t cache;
+	const struct emv_dol_plan_t* cached_plan;
 
 	printf("\nTest 1: Iterate valid DOL\n");
 	r = emv_dol_itr_init(test1_dol, sizeof(test1_dol), &itr);
@@ -323,6 +326,89 @@ int main(void)
 	}
 	printf("Success\n");
 
+	printf("\nTest 8: Build DOL data using compiled plan\n");
+	r = emv_dol_plan_compile(test7_dol, sizeof(test7_dol), &plan);
+	if (r) {
+		fprintf(stderr, "emv_dol_plan_compile() failed; r=%d\n", r);
+		return 1;
+	}
+	if (plan.count != 11 || plan.data_len != sizeof(test7_data)) {
+		fprintf(stderr, "emv_dol_plan_compile() failed; count=%u; data_len=%zu\n", plan.count, plan.data_len);
+		return 1;
+	}
+	for (size_t i = 0; i < sizeof(data); ++i) { data[i] = i; }
+	data_len = sizeof(test7_data) - 1;
+	r = emv_dol_plan_build_data(&plan, &sources, data, &data_len);
+	if (r <= 0) {
+		fprintf(stderr, "emv_dol_plan_build_data() did not detect insufficient output length; r=%d\n", r);
+		return 1;
+	}
+	data_len = sizeof(data);
+	r = emv_dol_plan_build_data(&plan, &sources, data, &data_len);
+	if (r) {
+		fprintf(stderr, "emv_dol_plan_build_data() failed; r=%d\n", r);
+		return 1;
+	}
+	if (data_len != sizeof(test7_data) ||
+		memcmp(data, test7_data, sizeof(test7_data)) != 0
+	) {
+		fprintf(stderr, "emv_dol_plan_build_data() failed; incorrect output data\n");
+		print_buf("data", data, data_len);
+		print_buf("test7_data", test7_data, sizeof(test7_data));
+		return 1;
+	}
+	r = emv_dol_plan_compile(test5_dol, sizeof(test5_dol), &plan);
+	if (r >= 0) {
+		fprintf(stderr, "emv_dol_plan_compile() did not detect invalid DOL; r=%d\n", r);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 9: Build DOL data using DOL cache\n");
+	cached_plan = emv_dol_cache_get(&cache, test7_dol, sizeof(test7_dol));
+	if (!cached_plan) {
+		fprintf(stderr, "emv_dol_cache_get() failed\n");
+		return 1;
+	}
+	if (emv_dol_cache_get(&cache, test7_dol, sizeof(test7_dol)) != cached_plan) {
+		fprintf(stderr, "emv_dol_cache_get() did not reuse plan\n");
+		return 1;
+	}
+	if (emv_dol_cache_get(&cache, test5_dol, sizeof(test5_dol))) {
+		fprintf(stderr, "emv_dol_cache_get() did not detect invalid DOL\n");
+		return 1;
+	}
+	// Fill cache with other DOLs using different lengths of the last entry
+	for (uint8_t i = 0; i < EMV_DOL_CACHE_SIZE * 2; ++i) {
+		uint8_t dol[] = { 0x9F, 0x37, i + 1 };
+		if (!emv_dol_cache_get(&cache, dol, sizeof(dol))) {
+			fprintf(stderr, "emv_dol_cache_get() failed\n");
+			return 1;
+		}
+		// Keep first plan in use such that it is not replaced
+		if (emv_dol_cache_get(&cache, test7_dol, sizeof(test7_dol)) != cached_plan) {
+			fprintf(stderr, "emv_dol_cache_get() replaced recently used plan\n");
+			return 1;
+		}
+	}
+	for (size_t i = 0; i < sizeof(data); ++i) { data[i] = i; }
+	data_len = sizeof(data);
+	r = emv_dol_cache_build_data(&cache, test7_dol, sizeof(test7_dol), &sources, data, &data_len);
+	if (r) {
+		fprintf(stderr, "emv_dol_cache_build_data() failed; r=%d\n", r);
+		return 1;
+	}
+	if (data_len != sizeof(test7_data) ||
+		memcmp(data, test7_data, sizeof(test7_data)) != 0
+	) {
+		fprintf(stderr, "emv_dol_cache_build_data() failed; incorrect output data\n");
+		print_buf("data", data, data_len);
+		print_buf("test7_data", test7_data, sizeof(test7_data));
+		return 1;
+	}
+	emv_dol_cache_clear(&cache);
+	printf("Success\n");
+
 	emv_tlv_list_clear(&source1);
 	emv_tlv_list_clear(&source2);
 	return 0;
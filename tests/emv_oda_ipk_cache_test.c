@@ -0,0 +1,467 @@
+/**
+ * @file emv_oda_ipk_cache_test.c
+ * @brief Unit tests for Offline Data Authentication (ODA) issuer public key cache
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_oda.h"
+#include "emv_pki.h"
+#include "emv_capk.h"
+#include "emv_tlv.h"
+#include "emv_tags.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_ISSUER_CERT_COUNT (EMV_ODA_IPK_CACHE_SIZE + 1)
+
+static const uint8_t test_rid[] = { 0xA0, 0x00, 0x00, 0x09, 0x99 };
+static const uint8_t test_aid[] = { 0xA0, 0x00, 0x00, 0x09, 0x99, 0x10, 0x10 };
+static const uint8_t test_capk_index = 0xF1;
+static const uint8_t test_pan[] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10, 0xFF, 0xFF };
+static const uint8_t test_issuer_id[] = { 0x47, 0x61, 0x73, 0x90 };
+static const uint8_t test_cert_exp[] = { 0x12, 0x49 };
+static const uint8_t test_txn_date[] = { 0x31, 0x12, 0x31 };
+static const uint8_t test_afl[] = { 0x08, 0x01, 0x01, 0x01 };
+static const uint8_t test_static_data[] = {
+	0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10,
+	0x5F, 0x24, 0x03, 0x49, 0x12, 0x31, 0x82, 0x02, 0x39, 0x00,
+};
+
+static struct emv_pki_key_t ca_key;
+static struct emv_pki_key_t other_ca_key;
+static struct emv_pki_key_t issuer_key;
+static struct emv_pki_key_t icc_key;
+static struct emv_pki_cert_t issuer_certs[TEST_ISSUER_CERT_COUNT];
+static struct emv_pki_cert_t icc_cert;
+
+static int populate_icc_data(
+	struct emv_ctx_t* ctx,
+	const struct emv_pki_cert_t* issuer_cert
+)
+{
+	int r;
+
+	// Replace ICC data such that only the issuer certificate fields differ
+	// between invocations
+	emv_tlv_list_clear(&ctx->icc);
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_5A_APPLICATION_PAN, 8, test_pan, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX, 1, &test_capk_index, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, issuer_cert->cert_len, issuer_cert->cert, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER, issuer_cert->remainder_len, issuer_cert->remainder, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, issuer_key.exponent_len, issuer_key.exponent, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_9F46_ICC_PUBLIC_KEY_CERTIFICATE, icc_cert.cert_len, icc_cert.cert, 0);
+	if (r) {
+		return r;
+	}
+	r = emv_tlv_list_push(&ctx->icc, EMV_TAG_9F47_ICC_PUBLIC_KEY_EXPONENT, icc_key.exponent_len, icc_key.exponent, 0);
+	if (r) {
+		return r;
+	}
+
+	return 0;
+}
+
+static int apply_cda(struct emv_ctx_t* ctx, const struct emv_pki_cert_t* issuer_cert)
+{
+	int r;
+
+	r = populate_icc_data(ctx, issuer_cert);
+	if (r) {
+		fprintf(stderr, "populate_icc_data() failed; r=%d\n", r);
+		return -1;
+	}
+
+	// Replace terminal data, including TVR and TSI, and the cached fields
+	// that reference it
+	emv_tlv_list_clear(&ctx->terminal);
+	r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_9F06_AID, sizeof(test_aid), test_aid, 0);
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS, 5, (uint8_t[]){ 0x00, 0x00, 0x00, 0x00, 0x00 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION, 2, (uint8_t[]){ 0x00, 0x00 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE, 2, (uint8_t[]){ 0x39, 0x00 }, 0);
+	}
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		return -1;
+	}
+	ctx->aid = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_9F06_AID);
+	ctx->tvr = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS);
+	ctx->tsi = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION);
+	ctx->aip = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE);
+
+	return emv_oda_apply_cda(ctx);
+}
+
+static unsigned int cache_count(const struct emv_oda_ipk_cache_t* cache)
+{
+	unsigned int count = 0;
+
+	for (size_t i = 0; i < EMV_ODA_IPK_CACHE_SIZE; ++i) {
+		if (cache->entries[i].last_used) {
+			++count;
+		}
+	}
+
+	return count;
+}
+
+static int cache_last_used(const struct emv_oda_ipk_cache_t* cache)
+{
+	for (size_t i = 0; i < EMV_ODA_IPK_CACHE_SIZE; ++i) {
+		if (cache->entries[i].last_used == cache->tick) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int main(void)
+{
+	int r;
+	struct emv_ctx_t ctx;
+	struct emv_oda_ipk_cache_t cache;
+	struct emv_capk_t capk;
+	struct emv_capk_t other_capk;
+	uint8_t capk_hash[20];
+	uint8_t other_capk_hash[20];
+	struct emv_pki_cert_t tampered_cert;
+	int entry_idx[TEST_ISSUER_CERT_COUNT];
+	unsigned long tick;
+
+	r = emv_ctx_init(&ctx, NULL);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		return 1;
+	}
+	memset(&cache, 0, sizeof(cache));
+	ctx.ipk_cache = &cache;
+
+	// Generate CA, issuer and ICC keys such that the issuer public key
+	// requires a remainder
+	r = emv_pki_generate_key(1024 / 8, 3, &ca_key);
+	if (!r) {
+		r = emv_pki_generate_key(1024 / 8, 3, &other_ca_key);
+	}
+	if (!r) {
+		r = emv_pki_generate_key(1152 / 8, 3, &issuer_key);
+	}
+	if (!r) {
+		r = emv_pki_generate_key(768 / 8, 3, &icc_key);
+	}
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_pki_populate_capk(&ca_key, test_rid, test_capk_index, capk_hash, &capk);
+	if (!r) {
+		r = emv_pki_populate_capk(&other_ca_key, test_rid, test_capk_index, other_capk_hash, &other_capk);
+	}
+	if (r) {
+		fprintf(stderr, "emv_pki_populate_capk() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_capk_add(&capk);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	// Create distinct issuer certificates for the same issuer key using
+	// different certificate serial numbers
+	for (unsigned int i = 0; i < TEST_ISSUER_CERT_COUNT; ++i) {
+		r = emv_pki_create_issuer_cert(
+			&ca_key,
+			test_issuer_id,
+			test_cert_exp,
+			(uint8_t[]){ 0x00, 0x00, i },
+			&issuer_key,
+			&issuer_certs[i]
+		);
+		if (r) {
+			fprintf(stderr, "emv_pki_create_issuer_cert() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (!issuer_certs[i].remainder_len) {
+			fprintf(stderr, "Issuer public key certificate has no remainder\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	r = emv_pki_create_icc_cert(
+		&issuer_key,
+		test_pan,
+		test_cert_exp,
+		(uint8_t[]){ 0x00, 0x00, 0x01 },
+		&icc_key,
+		test_static_data,
+		sizeof(test_static_data),
+		&icc_cert
+	);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_icc_cert() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	r = emv_tlv_list_push(&ctx.params, EMV_TAG_9A_TRANSACTION_DATE, sizeof(test_txn_date), test_txn_date, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_oda_prepare_records(&ctx.oda, test_afl, sizeof(test_afl));
+	if (r) {
+		fprintf(stderr, "emv_oda_prepare_records() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_oda_append_record(&ctx.oda, test_static_data, sizeof(test_static_data));
+	if (r) {
+		fprintf(stderr, "emv_oda_append_record() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	printf("\nTest 1: Cache miss followed by cache hit...\n");
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache.tick != 1 || cache_count(&cache) != 1) {
+		fprintf(stderr, "Issuer public key not cached; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	entry_idx[0] = cache_last_used(&cache);
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	// A cache hit updates the existing entry while a cache miss would
+	// populate another unused entry
+	if (cache.tick != 2 || cache_count(&cache) != 1 || cache_last_used(&cache) != entry_idx[0]) {
+		fprintf(stderr, "Cached issuer public key not used; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 2: Cache miss for different issuer certificate...\n");
+	tampered_cert = issuer_certs[0];
+	tampered_cert.cert[tampered_cert.cert_len - 1] ^= 0x01;
+	tick = cache.tick;
+	r = apply_cda(&ctx, &tampered_cert);
+	if (r != EMV_ODA_CDA_FAILED) {
+		fprintf(stderr, "Unexpected apply_cda() result for tampered issuer certificate; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache.tick != tick || cache_count(&cache) != 1) {
+		fprintf(stderr, "Cache used for tampered issuer certificate; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	r = apply_cda(&ctx, &issuer_certs[1]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	entry_idx[1] = cache_last_used(&cache);
+	if (cache.tick != tick + 1 || cache_count(&cache) != 2 || entry_idx[1] == entry_idx[0]) {
+		fprintf(stderr, "Issuer public key not cached for different certificate; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 3: Cache miss for different issuer public key remainder...\n");
+	tampered_cert = issuer_certs[0];
+	tampered_cert.remainder[0] ^= 0x01;
+	tick = cache.tick;
+	r = apply_cda(&ctx, &tampered_cert);
+	if (r != EMV_ODA_CDA_FAILED) {
+		fprintf(stderr, "Unexpected apply_cda() result for tampered remainder; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache.tick != tick || cache_count(&cache) != 2) {
+		fprintf(stderr, "Cache used for tampered remainder; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Cache miss for different CAPK...\n");
+	// Replace CAPK using the same RID and index but a different CA key
+	emv_capk_clear();
+	r = emv_capk_add(&other_capk);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r != EMV_ODA_CDA_FAILED) {
+		fprintf(stderr, "Unexpected apply_cda() result for different CAPK; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache.tick != tick || cache_count(&cache) != 2) {
+		fprintf(stderr, "Cache used for different CAPK; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+
+	// Restore original CAPK and confirm that the entry remains usable
+	emv_capk_clear();
+	r = emv_capk_add(&capk);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache.tick != tick + 1 || cache_count(&cache) != 2 || cache_last_used(&cache) != entry_idx[0]) {
+		fprintf(stderr, "Cached issuer public key not used for original CAPK; tick=%lu, count=%u\n", cache.tick, cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Least recently used entry eviction...\n");
+	emv_oda_ipk_cache_clear(&cache);
+	for (unsigned int i = 0; i < EMV_ODA_IPK_CACHE_SIZE; ++i) {
+		r = apply_cda(&ctx, &issuer_certs[i]);
+		if (r) {
+			fprintf(stderr, "apply_cda() failed for certificate %u; r=%d\n", i, r);
+			r = 1;
+			goto exit;
+		}
+		entry_idx[i] = cache_last_used(&cache);
+	}
+	if (cache_count(&cache) != EMV_ODA_IPK_CACHE_SIZE) {
+		fprintf(stderr, "Cache not populated; count=%u\n", cache_count(&cache));
+		r = 1;
+		goto exit;
+	}
+
+	// Use first entry such that the second entry is least recently used
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache_last_used(&cache) != entry_idx[0]) {
+		fprintf(stderr, "Cached issuer public key not used for first certificate\n");
+		r = 1;
+		goto exit;
+	}
+
+	// Additional certificate should replace the least recently used entry
+	r = apply_cda(&ctx, &issuer_certs[EMV_ODA_IPK_CACHE_SIZE]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	entry_idx[EMV_ODA_IPK_CACHE_SIZE] = cache_last_used(&cache);
+	if (entry_idx[EMV_ODA_IPK_CACHE_SIZE] != entry_idx[1]) {
+		fprintf(stderr, "Least recently used entry %d not replaced; replaced=%d\n",
+			entry_idx[1], entry_idx[EMV_ODA_IPK_CACHE_SIZE]
+		);
+		r = 1;
+		goto exit;
+	}
+
+	// Recently used entry should have been retained
+	r = apply_cda(&ctx, &issuer_certs[0]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache_last_used(&cache) != entry_idx[0]) {
+		fprintf(stderr, "Recently used entry was evicted\n");
+		r = 1;
+		goto exit;
+	}
+
+	// Evicted certificate should replace the next least recently used entry
+	r = apply_cda(&ctx, &issuer_certs[1]);
+	if (r) {
+		fprintf(stderr, "apply_cda() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (cache_last_used(&cache) != entry_idx[2]) {
+		fprintf(stderr, "Evicted issuer public key not recovered again\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	r = 0;
+	goto exit;
+
+exit:
+	ctx.ipk_cache = NULL;
+	emv_oda_ipk_cache_clear(&cache);
+	emv_ctx_clear(&ctx);
+	emv_capk_clear();
+
+	return r;
+}
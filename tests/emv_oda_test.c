@@ -0,0 +1,400 @@
+/**
+ * @file emv_oda_test.c
+ * @brief Unit tests for Offline Data Authentication (ODA) record processing
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_oda.h"
+#include "emv_oda_types.h"
+#include "emv_capk.h"
+#include "emv_tlv.h"
+#include "emv_tags.h"
+#include "emv_debug.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// For debug output
+#include "print_helpers.h"
+
+// AFL with 2 records in SFI 1 and 3 records in SFI 2 for ODA
+static const uint8_t test_afl[] = { 0x08, 0x01, 0x02, 0x02, 0x10, 0x01, 0x04, 0x03 };
+
+// 1984-bit CAPK A000000003 #94
+static const uint8_t test_capk_rid[] = { 0xA0, 0x00, 0x00, 0x00, 0x03 };
+
+// 1984-bit Issuer Public Key Certificate
+static const uint8_t valid_issuer_cert[] = {
+	0x66, 0x5C, 0xD6, 0x5C, 0x20, 0xDE, 0xAE, 0x63, 0x8C, 0x73, 0x20, 0xEA, 0x01, 0x1E, 0x5E, 0x2B,
+	0x33, 0xFC, 0x50, 0x70, 0xFF, 0x7D, 0x15, 0x3D, 0x74, 0xFE, 0x9A, 0x01, 0xAB, 0xFF, 0x0B, 0x95,
+	0x87, 0xB3, 0x77, 0x9C, 0x52, 0x45, 0x77, 0xF8, 0xA5, 0x7C, 0x19, 0x92, 0x3B, 0x39, 0xCD, 0x3F,
+	0x5C, 0xCD, 0xD4, 0x57, 0xD3, 0x60, 0xDC, 0x26, 0x19, 0xCD, 0xBB, 0x94, 0x32, 0x87, 0x77, 0xBB,
+	0x90, 0x5E, 0x1C, 0xB7, 0x9E, 0x28, 0x04, 0x58, 0xF6, 0x0C, 0x8C, 0x55, 0x93, 0xEF, 0xD2, 0x2D,
+	0x63, 0x85, 0x51, 0x2B, 0x11, 0xB7, 0xF2, 0xEA, 0xFE, 0x11, 0x84, 0xCF, 0x90, 0x66, 0xB9, 0xB4,
+	0x7A, 0x0B, 0xF8, 0x32, 0x04, 0x50, 0x66, 0x35, 0x9A, 0xE4, 0x65, 0x47, 0x3D, 0x31, 0xB9, 0xF8,
+	0x30, 0xA6, 0xDE, 0x7D, 0x88, 0xE9, 0x69, 0xCB, 0x45, 0x60, 0x33, 0xF8, 0x07, 0x3B, 0xEC, 0x51,
+	0x22, 0x05, 0x92, 0x0E, 0x3D, 0xEA, 0x77, 0x3D, 0x3E, 0x36, 0xE1, 0xF4, 0x6C, 0x2E, 0x8B, 0xDD,
+	0xC4, 0x23, 0xFB, 0x67, 0x5C, 0xA1, 0x71, 0x0A, 0x3D, 0x0A, 0x06, 0xE9, 0xC7, 0x57, 0x09, 0x19,
+	0x73, 0x51, 0x90, 0xBD, 0x6E, 0xD6, 0x5B, 0xD5, 0xEF, 0x92, 0xC0, 0x41, 0x6B, 0xFE, 0x40, 0x94,
+	0xEA, 0x96, 0xA2, 0x18, 0x01, 0x38, 0x38, 0xEF, 0x33, 0x71, 0x51, 0xA8, 0xBE, 0x72, 0x22, 0xDC,
+	0xF0, 0x71, 0x73, 0x99, 0x55, 0x3C, 0x4D, 0xDA, 0x16, 0xEB, 0xAB, 0xB2, 0xDD, 0x38, 0x6A, 0x07,
+	0xBD, 0xF3, 0x13, 0xD9, 0x70, 0xC1, 0x32, 0x4C, 0xAA, 0xB8, 0x85, 0x06, 0x76, 0x91, 0xE3, 0xEE,
+	0x5E, 0x5D, 0x8B, 0x91, 0x27, 0x99, 0xBD, 0x53, 0xC8, 0xE1, 0x83, 0x02, 0x37, 0xE9, 0xEC, 0x0A,
+	0x92, 0x54, 0xD8, 0x0B, 0x2B, 0xD3, 0x62, 0x2C,
+};
+
+// Transaction parameters for issuer public key validation
+static const uint8_t test_txn_date[] = { 0x31, 0x12, 0x31 };
+
+static const uint8_t test_aid[] = { 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 };
+static const uint8_t test_pan[] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19 };
+
+static bool pipelined_ipk_used;
+static bool ipk_failed;
+
+static void test_debug_func(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	if (strcmp(str, "Using pipelined issuer public key") == 0) {
+		pipelined_ipk_used = true;
+	}
+	if (strcmp(str, "Failed to retrieve issuer public key") == 0) {
+		ipk_failed = true;
+	}
+}
+
+static int prepare_sda(struct emv_ctx_t* ctx, const uint8_t* ipk_cert, size_t ipk_cert_len)
+{
+	int r;
+	struct emv_tlv_list_t gpo = EMV_TLV_LIST_INIT;
+	struct emv_tlv_list_t records = EMV_TLV_LIST_INIT;
+	uint8_t ssad[sizeof(valid_issuer_cert)];
+
+	r = emv_oda_prepare_records(&ctx->oda, test_afl, sizeof(test_afl));
+	if (r) {
+		fprintf(stderr, "emv_oda_prepare_records() failed; r=%d\n", r);
+		goto exit;
+	}
+	r = emv_oda_enable_pipeline(&ctx->oda, test_aid, &ctx->params);
+	if (r) {
+		// Caller handles lack of pipelining support
+		goto exit;
+	}
+
+	// Provide some fields in the GPO response and the others in records
+	r = emv_tlv_list_push(&gpo, EMV_TAG_5A_APPLICATION_PAN, sizeof(test_pan), test_pan, 0);
+	if (!r) {
+		r = emv_tlv_list_push(&gpo, EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX, 1, (uint8_t[]){ 0x94 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&records, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, sizeof(valid_issuer_cert), valid_issuer_cert, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&records, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, 1, (uint8_t[]){ 0x03 }, 0);
+	}
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto exit;
+	}
+	r = emv_oda_update_pipeline(&ctx->oda, &gpo);
+	if (!r) {
+		r = emv_oda_update_pipeline(&ctx->oda, &records);
+	}
+	if (r) {
+		fprintf(stderr, "emv_oda_update_pipeline() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	// Provide the ICC data that will be used by SDA, including an invalid
+	// Signed Static Application Data (field 93) because only the issuer public
+	// key recovery is of interest
+	memset(ssad, 0x6A, sizeof(ssad));
+	r = emv_tlv_list_append(&ctx->icc, &gpo);
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, ipk_cert_len, ipk_cert, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, 1, (uint8_t[]){ 0x03 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->icc, EMV_TAG_93_SIGNED_STATIC_APPLICATION_DATA, sizeof(ssad), ssad, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_9F06_AID, sizeof(test_aid), test_aid, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS, 5, (uint8_t[]){ 0x00, 0x00, 0x00, 0x00, 0x00 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION, 2, (uint8_t[]){ 0x00, 0x00 }, 0);
+	}
+	if (!r) {
+		r = emv_tlv_list_push(&ctx->terminal, EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE, 2, (uint8_t[]){ 0x40, 0x00 }, 0);
+	}
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto exit;
+	}
+	ctx->aid = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_9F06_AID);
+	ctx->tvr = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_95_TERMINAL_VERIFICATION_RESULTS);
+	ctx->tsi = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_9B_TRANSACTION_STATUS_INFORMATION);
+	ctx->aip = emv_tlv_list_find_const(&ctx->terminal, EMV_TAG_82_APPLICATION_INTERCHANGE_PROFILE);
+
+exit:
+	emv_tlv_list_clear(&gpo);
+	emv_tlv_list_clear(&records);
+	return r;
+}
+
+int main(void)
+{
+	int r;
+	struct emv_oda_ctx_t oda;
+	struct emv_tlv_list_t icc = EMV_TLV_LIST_INIT;
+	struct emv_tlv_list_t params = EMV_TLV_LIST_INIT;
+	uint8_t record[200];
+	uint8_t verify[sizeof(record) * 5];
+	struct emv_ctx_t ctx;
+	struct emv_debug_config_t debug_config = { EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_ALL, NULL, NULL };
+	uint8_t tampered_issuer_cert[sizeof(valid_issuer_cert)];
+
+	r = emv_oda_init(&oda);
+	if (r) {
+		fprintf(stderr, "emv_oda_init() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_ctx_init(&ctx, NULL);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	printf("\nTest 1: Append record without preparing buffer...\n");
+	memset(record, 0x5A, sizeof(record));
+	r = emv_oda_append_record(&oda, record, sizeof(record));
+	if (r >= 0) {
+		fprintf(stderr, "Unexpected emv_oda_append_record() result; r=%d\n", r);
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 2: Append records beyond initial buffer size...\n");
+	r = emv_oda_prepare_records(&oda, test_afl, sizeof(test_afl));
+	if (r) {
+		fprintf(stderr, "emv_oda_prepare_records() failed; r=%d\n", r);
+		return 1;
+	}
+	for (unsigned int i = 0; i < 5; ++i) {
+		memset(record, i + 1, sizeof(record));
+		r = emv_oda_append_record(&oda, record, sizeof(record));
+		if (r) {
+			fprintf(stderr, "emv_oda_append_record() failed; r=%d\n", r);
+			return 1;
+		}
+		memcpy(verify + sizeof(record) * i, record, sizeof(record));
+	}
+	if (oda.record_buf_len != sizeof(verify)) {
+		fprintf(stderr, "Incorrect record buffer length %u\n", oda.record_buf_len);
+		return 1;
+	}
+	if (oda.record_buf_size < oda.record_buf_len) {
+		fprintf(stderr, "Incorrect record buffer size %u\n", oda.record_buf_size);
+		return 1;
+	}
+	if (memcmp(oda.record_buf, verify, sizeof(verify)) != 0) {
+		fprintf(stderr, "Incorrect record buffer content\n");
+		print_buf("record_buf", oda.record_buf, oda.record_buf_len);
+		print_buf("verify", verify, sizeof(verify));
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 3: Clear records...\n");
+	r = emv_oda_clear_records(&oda);
+	if (r) {
+		fprintf(stderr, "emv_oda_clear_records() failed; r=%d\n", r);
+		return 1;
+	}
+	if (oda.record_buf || oda.record_buf_len || oda.record_buf_size) {
+		fprintf(stderr, "Record buffer not cleared\n");
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Pipelined issuer public key recovery...\n");
+	r = emv_capk_load_static();
+	if (r) {
+		fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_tlv_list_push(&params, EMV_TAG_9A_TRANSACTION_DATE, sizeof(test_txn_date), test_txn_date, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_oda_prepare_records(&oda, test_afl, sizeof(test_afl));
+	if (r) {
+		fprintf(stderr, "emv_oda_prepare_records() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_oda_enable_pipeline(&oda, test_capk_rid, &params);
+	if (r > 0) {
+		printf("Pipelining not supported\n");
+		goto success;
+	}
+	if (r) {
+		fprintf(stderr, "emv_oda_enable_pipeline() failed; r=%d\n", r);
+		goto error;
+	}
+	if (!oda.pipeline) {
+		fprintf(stderr, "Pipeline not enabled\n");
+		goto error;
+	}
+
+	// Provide application data in stages similar to records being read
+	r = emv_tlv_list_push(&icc, EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX, 1, (uint8_t[]){ 0x94 }, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, sizeof(valid_issuer_cert), valid_issuer_cert, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_oda_update_pipeline(&oda, &icc);
+	if (r) {
+		fprintf(stderr, "emv_oda_update_pipeline() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, 1, (uint8_t[]){ 0x03 }, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_5A_APPLICATION_PAN, 8, (uint8_t[]){ 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19 }, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_oda_update_pipeline(&oda, &icc);
+	if (r) {
+		fprintf(stderr, "emv_oda_update_pipeline() failed; r=%d\n", r);
+		goto error;
+	}
+
+	// Clearing records should wait for the worker thread
+	r = emv_oda_clear_records(&oda);
+	if (r) {
+		fprintf(stderr, "emv_oda_clear_records() failed; r=%d\n", r);
+		goto error;
+	}
+	if (oda.pipeline) {
+		fprintf(stderr, "Pipeline not released\n");
+		goto error;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Pipelined issuer public key used by SDA...\n");
+	debug_config.func = &test_debug_func;
+	emv_debug_set_thread_config(&debug_config);
+	r = emv_tlv_list_push(&ctx.params, EMV_TAG_9A_TRANSACTION_DATE, sizeof(test_txn_date), test_txn_date, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	r = prepare_sda(&ctx, valid_issuer_cert, sizeof(valid_issuer_cert));
+	if (r) {
+		fprintf(stderr, "prepare_sda() failed; r=%d\n", r);
+		goto error;
+	}
+	pipelined_ipk_used = false;
+	ipk_failed = false;
+	r = emv_oda_apply_sda(&ctx);
+	if (r != EMV_ODA_SDA_FAILED) {
+		fprintf(stderr, "Unexpected emv_oda_apply_sda() result; r=%d\n", r);
+		goto error;
+	}
+	if (!pipelined_ipk_used || ipk_failed) {
+		fprintf(stderr, "Pipelined issuer public key not used\n");
+		goto error;
+	}
+	printf("Success\n");
+
+	printf("\nTest 6: Pipelined issuer public key ignored for different certificate...\n");
+	emv_ctx_clear(&ctx);
+	r = emv_ctx_init(&ctx, NULL);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		goto error;
+	}
+	r = emv_tlv_list_push(&ctx.params, EMV_TAG_9A_TRANSACTION_DATE, sizeof(test_txn_date), test_txn_date, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		goto error;
+	}
+	// Worker thread recovers the issuer public key from the valid
+	// certificate while SDA uses a different certificate
+	memcpy(tampered_issuer_cert, valid_issuer_cert, sizeof(valid_issuer_cert));
+	tampered_issuer_cert[sizeof(tampered_issuer_cert) - 1] ^= 0x01;
+	r = prepare_sda(&ctx, tampered_issuer_cert, sizeof(tampered_issuer_cert));
+	if (r) {
+		fprintf(stderr, "prepare_sda() failed; r=%d\n", r);
+		goto error;
+	}
+	pipelined_ipk_used = false;
+	ipk_failed = false;
+	r = emv_oda_apply_sda(&ctx);
+	if (r != EMV_ODA_SDA_FAILED) {
+		fprintf(stderr, "Unexpected emv_oda_apply_sda() result; r=%d\n", r);
+		goto error;
+	}
+	if (pipelined_ipk_used || !ipk_failed) {
+		fprintf(stderr, "Pipelined issuer public key used for different certificate\n");
+		goto error;
+	}
+
+success:
+	printf("Success\n");
+	r = 0;
+	goto exit;
+
+error:
+	r = 1;
+	goto exit;
+
+exit:
+	emv_debug_set_thread_config(NULL);
+	emv_ctx_clear(&ctx);
+	emv_oda_clear(&oda);
+	emv_tlv_list_clear(&icc);
+	emv_tlv_list_clear(&params);
+	emv_capk_clear();
+
+	return r;
+}
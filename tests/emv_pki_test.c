@@ -0,0 +1,338 @@
+/**
+ * @file emv_pki_test.c
+ * @brief Unit tests for EMV test PKI generation
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_pki.h"
+#include "emv_rsa.h"
+#include "emv_oda_types.h"
+#include "emv_capk.h"
+#include "emv_tlv.h"
+#include "emv_tags.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// For debug output
+#include "print_helpers.h"
+
+#define TEST_BATCH_COUNT (16)
+#define TEST_BATCH_THREADS (4)
+
+static const uint8_t test_rid[] = { 0xA0, 0x00, 0x00, 0x09, 0x99 };
+static const uint8_t test_capk_index = 0xF1;
+static const uint8_t test_pan[] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10 };
+static const uint8_t test_issuer_id[] = { 0x47, 0x61, 0x73, 0x90 };
+static const uint8_t test_cert_exp[] = { 0x12, 0x49 };
+static const uint8_t test_cert_sn[] = { 0x00, 0x00, 0x01 };
+static const uint8_t test_txn_date[] = { 0x31, 0x12, 0x31 };
+static const uint8_t test_static_data[] = {
+	0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10,
+	0x5F, 0x24, 0x03, 0x49, 0x12, 0x31, 0x82, 0x02, 0x39, 0x00,
+};
+
+static void test_pan_bcd(unsigned int seq, uint8_t* pan)
+{
+	memset(pan, 0xFF, 10);
+	memcpy(pan, test_pan, sizeof(test_pan));
+	pan[6] = ((seq / 10) % 10) << 4 | (seq % 10);
+}
+
+int main(void)
+{
+	int r;
+	struct emv_pki_key_t ca_key;
+	struct emv_pki_key_t issuer_key;
+	struct emv_pki_key_t key;
+	struct emv_capk_t capk;
+	uint8_t capk_hash[20];
+	const struct emv_capk_t* capk_found;
+	struct emv_pki_cert_t issuer_cert;
+	struct emv_pki_icc_request_t requests[TEST_BATCH_COUNT];
+	struct emv_tlv_list_t icc = EMV_TLV_LIST_INIT;
+	struct emv_tlv_list_t params = EMV_TLV_LIST_INIT;
+	struct emv_oda_ctx_t oda;
+	struct emv_rsa_issuer_pkey_t ipk;
+	struct emv_rsa_icc_pkey_t icc_pkey;
+	uint8_t tampered_static_data[sizeof(test_static_data)];
+
+	// Enable debug output
+	r = emv_debug_init(EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_ALL, &print_emv_debug);
+	if (r) {
+		fprintf(stderr, "emv_debug_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Test invalid key parameters
+	r = emv_pki_generate_key(EMV_PKI_MODULUS_MIN - 1, 3, &key);
+	if (r >= 0) {
+		fprintf(stderr, "Unexpected emv_pki_generate_key() result for short modulus; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_pki_generate_key(EMV_PKI_MODULUS_MAX + 1, 3, &key);
+	if (r >= 0) {
+		fprintf(stderr, "Unexpected emv_pki_generate_key() result for long modulus; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_pki_generate_key(1024 / 8, 5, &key);
+	if (r >= 0) {
+		fprintf(stderr, "Unexpected emv_pki_generate_key() result for invalid exponent; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	// Test key generation for odd modulus length, 65537 exponent and
+	// full length modulus
+	r = emv_pki_generate_key(1000 / 8, 65537, &key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (key.modulus_len != 1000 / 8 ||
+		key.exponent_len != 3 ||
+		memcmp(key.exponent, (uint8_t[]){ 0x01, 0x00, 0x01 }, 3) != 0 ||
+		!(key.modulus[0] & 0x80) ||
+		!(key.modulus[key.modulus_len - 1] & 0x01)
+	) {
+		fprintf(stderr, "Generated key is invalid\n");
+		print_buf("modulus", key.modulus, key.modulus_len);
+		r = 1;
+		goto exit;
+	}
+
+	// Generate CA and issuer keys such that the issuer public key requires
+	// a remainder
+	r = emv_pki_generate_key(1024 / 8, 3, &ca_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for CA key; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_pki_generate_key(1152 / 8, 65537, &issuer_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for issuer key; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	// Test CAPK population and loading
+	r = emv_pki_populate_capk(&ca_key, test_rid, test_capk_index, capk_hash, &capk);
+	if (r) {
+		fprintf(stderr, "emv_pki_populate_capk() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_capk_add(&capk);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	capk_found = emv_capk_lookup(test_rid, test_capk_index);
+	if (!capk_found) {
+		fprintf(stderr, "emv_capk_lookup() failed\n");
+		r = 1;
+		goto exit;
+	}
+
+	// Test issuer public key certificate
+	r = emv_pki_create_issuer_cert(
+		&ca_key,
+		test_issuer_id,
+		test_cert_exp,
+		test_cert_sn,
+		&issuer_key,
+		&issuer_cert
+	);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_issuer_cert() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (issuer_cert.cert_len != ca_key.modulus_len ||
+		issuer_cert.remainder_len != issuer_key.modulus_len - (ca_key.modulus_len - 36)
+	) {
+		fprintf(stderr, "Issuer public key certificate length is incorrect\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = emv_tlv_list_push(&params, EMV_TAG_9A_TRANSACTION_DATE, sizeof(test_txn_date), test_txn_date, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_5A_APPLICATION_PAN, sizeof(test_pan), test_pan, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER, issuer_cert.remainder_len, issuer_cert.remainder, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_tlv_list_push(&icc, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, issuer_key.exponent_len, issuer_key.exponent, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	memset(&ipk, 0, sizeof(ipk));
+	r = emv_rsa_retrieve_issuer_pkey(
+		issuer_cert.cert,
+		issuer_cert.cert_len,
+		capk_found,
+		&icc,
+		&params,
+		&ipk
+	);
+	if (r) {
+		fprintf(stderr, "emv_rsa_retrieve_issuer_pkey() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (ipk.modulus_len != issuer_key.modulus_len ||
+		memcmp(ipk.modulus, issuer_key.modulus, issuer_key.modulus_len) != 0
+	) {
+		fprintf(stderr, "Retrieved issuer public key is incorrect\n");
+		print_buf("retrieved", ipk.modulus, ipk.modulus_len);
+		print_buf("expected", issuer_key.modulus, issuer_key.modulus_len);
+		r = 1;
+		goto exit;
+	}
+
+	// Test ICC public key certificate batch using ICC keys that alternate
+	// between requiring a remainder and requiring padding
+	memset(requests, 0, sizeof(requests));
+	for (unsigned int i = 0; i < TEST_BATCH_COUNT; ++i) {
+		test_pan_bcd(i, requests[i].pan);
+		memcpy(requests[i].cert_exp, test_cert_exp, sizeof(test_cert_exp));
+		requests[i].cert_sn[2] = i;
+		requests[i].modulus_len = (i & 1) ? 1024 / 8 : 768 / 8;
+		requests[i].exponent = 3;
+		requests[i].static_data = test_static_data;
+		requests[i].static_data_len = sizeof(test_static_data);
+	}
+	r = emv_pki_create_icc_batch(&issuer_key, requests, TEST_BATCH_COUNT, TEST_BATCH_THREADS);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_icc_batch() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
+	memcpy(tampered_static_data, test_static_data, sizeof(test_static_data));
+	tampered_static_data[sizeof(tampered_static_data) - 1] ^= 0x01;
+	for (unsigned int i = 0; i < TEST_BATCH_COUNT; ++i) {
+		const struct emv_pki_icc_request_t* req = &requests[i];
+		struct emv_tlv_list_t card = EMV_TLV_LIST_INIT;
+
+		if (req->result) {
+			fprintf(stderr, "ICC request %u failed; r=%d\n", i, req->result);
+			r = 1;
+			goto exit;
+		}
+		if (i && memcmp(req->icc_key.modulus, requests[i - 1].icc_key.modulus, 96) == 0) {
+			fprintf(stderr, "ICC request %u key is not unique\n", i);
+			r = 1;
+			goto exit;
+		}
+
+		r = emv_tlv_list_push(&card, EMV_TAG_5A_APPLICATION_PAN, sizeof(test_pan), req->pan, 0);
+		if (!r) {
+			r = emv_tlv_list_push(&card, EMV_TAG_9F47_ICC_PUBLIC_KEY_EXPONENT, req->icc_key.exponent_len, req->icc_key.exponent, 0);
+		}
+		if (!r && req->cert.remainder_len) {
+			r = emv_tlv_list_push(&card, EMV_TAG_9F48_ICC_PUBLIC_KEY_REMAINDER, req->cert.remainder_len, req->cert.remainder, 0);
+		}
+		if (r) {
+			fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+			emv_tlv_list_clear(&card);
+			r = 1;
+			goto exit;
+		}
+
+		memset(&oda, 0, sizeof(oda));
+		oda.record_buf = (uint8_t*)test_static_data;
+		oda.record_buf_len = sizeof(test_static_data);
+		memset(&icc_pkey, 0, sizeof(icc_pkey));
+		r = emv_rsa_retrieve_icc_pkey(
+			req->cert.cert,
+			req->cert.cert_len,
+			&ipk,
+			&card,
+			&params,
+			&oda,
+			&icc_pkey
+		);
+		if (r) {
+			fprintf(stderr, "emv_rsa_retrieve_icc_pkey() failed for request %u; r=%d\n", i, r);
+			emv_tlv_list_clear(&card);
+			r = 1;
+			goto exit;
+		}
+		if (icc_pkey.modulus_len != req->icc_key.modulus_len ||
+			memcmp(icc_pkey.modulus, req->icc_key.modulus, req->icc_key.modulus_len) != 0
+		) {
+			fprintf(stderr, "Retrieved ICC public key is incorrect for request %u\n", i);
+			print_buf("retrieved", icc_pkey.modulus, icc_pkey.modulus_len);
+			print_buf("expected", req->icc_key.modulus, req->icc_key.modulus_len);
+			emv_tlv_list_clear(&card);
+			r = 1;
+			goto exit;
+		}
+
+		// Test that static data is covered by the certificate hash
+		oda.record_buf = tampered_static_data;
+		r = emv_rsa_retrieve_icc_pkey(
+			req->cert.cert,
+			req->cert.cert_len,
+			&ipk,
+			&card,
+			&params,
+			&oda,
+			&icc_pkey
+		);
+		emv_tlv_list_clear(&card);
+		if (r == 0) {
+			fprintf(stderr, "Unexpected emv_rsa_retrieve_icc_pkey() result for tampered static data\n");
+			r = 1;
+			goto exit;
+		}
+	}
+
+	printf("Success\n");
+	r = 0;
+	goto exit;
+
+exit:
+	emv_capk_clear();
+	emv_tlv_list_clear(&icc);
+	emv_tlv_list_clear(&params);
+	return r;
+}
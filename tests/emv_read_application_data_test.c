@@ -600,6 +600,53 @@ int main(void)
 	emv_tlv_list_clear(&emv.icc);
 	printf("Success\n");
 
+	printf("\nTest 12: Normal processing using per-transaction arena...\n");
+	r = emv_ctx_arena_init(&emv, 0);
+	if (r) {
+		fprintf(stderr, "emv_ctx_arena_init() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = populate_afl(&emv, test11_afl, sizeof(test11_afl));
+	if (r) {
+		fprintf(stderr, "populate_afl() failed; r=%d", r);
+		r = 1;
+		goto exit;
+	}
+	emul_ctx.xpdu_list = test11_apdu_list;
+	emul_ctx.xpdu_current = NULL;
+	r = emv_read_application_data(&emv);
+	if (r) {
+		fprintf(stderr, "emv_read_application_data() failed; error %d: %s\n", r, r < 0 ? emv_error_get_string(r) : emv_outcome_get_string(r));
+		r = 1;
+		goto exit;
+	}
+	if (emul_ctx.xpdu_current->c_xpdu_len != 0) {
+		fprintf(stderr, "Incomplete card interaction\n");
+		r = 1;
+		goto exit;
+	}
+	print_emv_tlv_list(&emv.icc);
+	if (!emv_tlv_list_find_const(&emv.icc, EMV_TAG_5A_APPLICATION_PAN) ||
+		!emv_tlv_list_find_const(&emv.icc, EMV_TAG_8C_CDOL1)
+	) {
+		fprintf(stderr, "Application data not found\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_ctx_reset(&emv);
+	if (r) {
+		fprintf(stderr, "emv_ctx_reset() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (!emv_tlv_list_is_empty(&emv.icc) || emv.icc.arena != &emv.arena) {
+		fprintf(stderr, "emv_ctx_reset() did not preserve ICC data arena\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
 	// Success
 	r = 0;
 	goto exit;
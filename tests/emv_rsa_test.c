@@ -537,6 +537,26 @@ int main(void)
 		goto exit;
 	}
 
+	// Test validation of previously retrieved issuer public key
+	r = emv_rsa_validate_issuer_pkey(&ipk, &valid_icc, &valid_params_2031);
+	if (r) {
+		fprintf(stderr, "emv_rsa_validate_issuer_pkey() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_rsa_validate_issuer_pkey(&ipk, &valid_icc, &expired_params);
+	if (r != 10) {
+		fprintf(stderr, "Unexpected emv_rsa_validate_issuer_pkey() result; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_rsa_validate_issuer_pkey(&ipk, &valid_params_2031, &valid_params_2031);
+	if (r != 7) {
+		fprintf(stderr, "Unexpected emv_rsa_validate_issuer_pkey() result; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+
 	// Test failed retrieval of signed static application data
 	memset(&ssad, 0, sizeof(ssad));
 	r = emv_rsa_retrieve_ssad(
@@ -0,0 +1,312 @@
+/**
+ * @file emv_tlv_bench.c
+ * @brief Microbenchmarks for EMV TLV list processing
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_tlv.h"
+#include "iso8825_ber.h"
+#include "emv_utils_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double now_ns(void)
+{
+	struct timespec t;
+
+#if defined(HAVE_TIMESPEC_GET)
+	timespec_get(&t, TIME_UTC);
+#elif defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+static int populate_list(struct emv_tlv_list_t* list, unsigned int count)
+{
+	int r;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		// Use two byte tags similar to EMV tags
+		r = emv_tlv_list_push(list, 0x9F00 + i, 1, (uint8_t[]){ i & 0xFF }, 0);
+		if (r) {
+			fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static double bench_find(struct emv_tlv_list_t* list, unsigned int count, unsigned int iterations)
+{
+	double start;
+	double end;
+	volatile unsigned int found = 0;
+
+	start = now_ns();
+	for (unsigned int i = 0; i < iterations; ++i) {
+		// Find every field, as well as one absent field, per iteration
+		for (unsigned int j = 0; j <= count; ++j) {
+			if (emv_tlv_list_find(list, 0x9F00 + j)) {
+				++found;
+			}
+		}
+	}
+	end = now_ns();
+
+	if (found != count * iterations) {
+		fprintf(stderr, "Unexpected number of fields found\n");
+		return -1;
+	}
+
+	return (end - start) / ((double)(count + 1) * iterations);
+}
+
+static int bench_list_find(void)
+{
+	static const unsigned int list_sizes[] = { 8, 32, 128, 512, 2048 };
+
+	printf("\nemv_tlv_list_find() cost versus list size\n");
+	printf("%8s %16s %16s\n", "Fields", "Linear [ns]", "Indexed [ns]");
+
+	for (size_t i = 0; i < sizeof(list_sizes) / sizeof(list_sizes[0]); ++i) {
+		int r;
+		unsigned int count = list_sizes[i];
+		unsigned int iterations = 1000000 / count;
+		struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+		struct emv_tlv_list_t indexed_list = EMV_TLV_LIST_INIT;
+		double linear_ns;
+		double indexed_ns;
+
+		emv_tlv_list_enable_index(&indexed_list);
+		r = populate_list(&list, count);
+		if (r) {
+			return r;
+		}
+		r = populate_list(&indexed_list, count);
+		if (r) {
+			return r;
+		}
+
+		linear_ns = bench_find(&list, count, iterations);
+		indexed_ns = bench_find(&indexed_list, count, iterations);
+		emv_tlv_list_clear(&list);
+		emv_tlv_list_clear(&indexed_list);
+		emv_tlv_list_disable_index(&indexed_list);
+		if (linear_ns < 0 || indexed_ns < 0) {
+			return 1;
+		}
+
+		printf("%8u %16.1f %16.1f\n", count, linear_ns, indexed_ns);
+	}
+
+	return 0;
+}
+
+static int bench_sources_find(void)
+{
+	int r;
+	struct emv_tlv_list_t lists[5] = {
+		EMV_TLV_LIST_INIT, EMV_TLV_LIST_INIT, EMV_TLV_LIST_INIT, EMV_TLV_LIST_INIT, EMV_TLV_LIST_INIT,
+	};
+	struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
+	struct emv_tlv_sources_index_t sources_index = EMV_TLV_SOURCES_INDEX_INIT;
+	const unsigned int count = 20;
+	const unsigned int iterations = 100000;
+	double start;
+	double linear_ns;
+	double indexed_ns;
+	volatile unsigned int found = 0;
+
+	// Five sources similar to emv_tlv_sources_init_from_ctx() with distinct
+	// fields in each list
+	for (unsigned int i = 0; i < 5; ++i) {
+		for (unsigned int j = 0; j < count; ++j) {
+			r = emv_tlv_list_push(&lists[i], 0x9F00 + i * count + j, 1, (uint8_t[]){ j }, 0);
+			if (r) {
+				fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+				goto exit;
+			}
+		}
+		sources.list[sources.count++] = &lists[i];
+	}
+
+	start = now_ns();
+	for (unsigned int i = 0; i < iterations; ++i) {
+		for (unsigned int j = 0; j < 5 * count; ++j) {
+			found += emv_tlv_sources_find_const(&sources, 0x9F00 + j) != NULL;
+		}
+	}
+	linear_ns = (now_ns() - start) / ((double)5 * count * iterations);
+
+	emv_tlv_sources_enable_index(&sources, &sources_index);
+	start = now_ns();
+	for (unsigned int i = 0; i < iterations; ++i) {
+		for (unsigned int j = 0; j < 5 * count; ++j) {
+			found += emv_tlv_sources_find_const(&sources, 0x9F00 + j) != NULL;
+		}
+	}
+	indexed_ns = (now_ns() - start) / ((double)5 * count * iterations);
+
+	if (found != 2 * 5 * count * iterations) {
+		fprintf(stderr, "Unexpected number of fields found\n");
+		r = 1;
+		goto exit;
+	}
+
+	printf("\nemv_tlv_sources_find_const() cost for 5 sources of %u fields\n", count);
+	printf("%16s %16s\n", "Linear [ns]", "Indexed [ns]");
+	printf("%16.1f %16.1f\n", linear_ns, indexed_ns);
+
+	r = 0;
+	goto exit;
+
+exit:
+	for (unsigned int i = 0; i < 5; ++i) {
+		emv_tlv_list_clear(&lists[i]);
+	}
+	emv_tlv_sources_index_clear(&sources_index);
+	return r;
+}
+
+// Previous pairwise implementation of emv_tlv_list_has_duplicate() for
+// comparison
+static bool has_duplicate_pairwise(const struct emv_tlv_list_t* list)
+{
+	int r;
+
+	for (const struct emv_tlv_t* tlv = list->front; tlv != NULL; tlv = tlv->next) {
+		struct iso8825_oid_t oid;
+		bool tlv_is_asn1_object = false;
+		r = iso8825_ber_asn1_object_decode(&tlv->ber, &oid);
+		if (r > 0) {
+			tlv_is_asn1_object = true;
+		}
+
+		for (const struct emv_tlv_t* tlv2 = tlv->next; tlv2 != NULL; tlv2 = tlv2->next) {
+			if (tlv_is_asn1_object) {
+				struct iso8825_oid_t oid2;
+				r = iso8825_ber_asn1_object_decode(&tlv2->ber, &oid2);
+				if (r > 0 &&
+					oid.length == oid2.length &&
+					memcmp(oid.value, oid2.value, sizeof(oid2.value[0]) * oid2.length) == 0
+				) {
+					return true;
+				}
+
+			} else if (tlv->tag == tlv2->tag) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static int populate_asn1_list(struct emv_tlv_list_t* list, unsigned int count)
+{
+	int r;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		struct iso8825_oid_t oid = { 4, { 1, 2, 840, i } };
+		r = emv_tlv_list_push_asn1_object(list, &oid, 3, (uint8_t[]){ 0x02, 0x01, i & 0xFF });
+		if (r) {
+			fprintf(stderr, "emv_tlv_list_push_asn1_object() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int bench_list_has_duplicate(void)
+{
+	static const unsigned int list_sizes[] = { 100, 1000, 10000 };
+
+	printf("\nemv_tlv_list_has_duplicate() cost versus list size\n");
+	printf("%8s %8s %16s %16s\n", "Fields", "Type", "Pairwise [us]", "Hashed [us]");
+
+	for (size_t i = 0; i < sizeof(list_sizes) / sizeof(list_sizes[0]); ++i) {
+		for (unsigned int asn1 = 0; asn1 <= 1; ++asn1) {
+			int r;
+			unsigned int count = list_sizes[i];
+			struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+			double start;
+			double pairwise_us;
+			double hashed_us;
+			bool pairwise_duplicate;
+			bool hashed_duplicate;
+
+			if (asn1) {
+				r = populate_asn1_list(&list, count);
+			} else {
+				r = populate_list(&list, count);
+			}
+			if (r) {
+				emv_tlv_list_clear(&list);
+				return r;
+			}
+
+			start = now_ns();
+			pairwise_duplicate = has_duplicate_pairwise(&list);
+			pairwise_us = (now_ns() - start) / 1e3;
+
+			start = now_ns();
+			hashed_duplicate = emv_tlv_list_has_duplicate(&list);
+			hashed_us = (now_ns() - start) / 1e3;
+
+			emv_tlv_list_clear(&list);
+			if (pairwise_duplicate || hashed_duplicate) {
+				fprintf(stderr, "Unexpected duplicate found\n");
+				return 1;
+			}
+
+			printf("%8u %8s %16.1f %16.1f\n", count, asn1 ? "ASN.1" : "EMV", pairwise_us, hashed_us);
+		}
+	}
+
+	return 0;
+}
+
+int main(void)
+{
+	int r;
+
+	r = bench_list_find();
+	if (r) {
+		return 1;
+	}
+
+	r = bench_sources_find();
+	if (r) {
+		return 1;
+	}
+
+	r = bench_list_has_duplicate();
+	if (r) {
+		return 1;
+	}
+
+	return 0;
+}
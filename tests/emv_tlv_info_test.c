@@ -0,0 +1,357 @@
+/**
+ * @file emv_tlv_info_test.c
+ * @brief Unit tests for EMV TLV information lookup
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_strings.h"
+#include "emv_tlv.h"
+#include "emv_tags.h"
+#include "emv_fields.h"
+#include "emv_capk.h"
+#include "emv_utils_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif
+
+struct test_tlv_t {
+	unsigned int tag;
+	size_t length;
+	const uint8_t* value;
+	const char* tag_name;
+	enum emv_format_t format;
+};
+
+static const uint8_t test_iin[] = { 0x47, 0x61, 0x73 };
+static const uint8_t test_amount[] = { 0x00, 0x00, 0x00, 0x01, 0x23, 0x45 };
+static const uint8_t test_third_party_data[] = { 0x08, 0x26, 0x00, 0x00, 0x12, 0x34 };
+static const uint8_t test_visa_ffi[] = {
+	VISA_FFI_VERSION_NUMBER_1,
+	0x00,
+	0x00,
+	VISA_FFI_PAYMENT_TXN_TECHNOLOGY_CONTACTLESS,
+};
+static const uint8_t test_amex_enh_cl_reader_caps[] = {
+	AMEX_ENH_CL_READER_CAPS_PARTIAL_ONLINE_MODE_SUPPORTED | AMEX_ENH_CL_READER_CAPS_MOBILE_SUPPORTED,
+	AMEX_ENH_CL_READER_CAPS_MOBILE_CVM_SUPPORTED,
+	0x00,
+	AMEX_ENH_CL_READER_CAPS_KERNEL_VERSION_27,
+};
+static const uint8_t test_unknown[] = { 0xDE, 0xAD };
+
+// 1984-bit Issuer Public Key Certificate for CAPK A000000003 #94
+static const uint8_t valid_issuer_cert[] = {
+	0x66, 0x5C, 0xD6, 0x5C, 0x20, 0xDE, 0xAE, 0x63, 0x8C, 0x73, 0x20, 0xEA, 0x01, 0x1E, 0x5E, 0x2B,
+	0x33, 0xFC, 0x50, 0x70, 0xFF, 0x7D, 0x15, 0x3D, 0x74, 0xFE, 0x9A, 0x01, 0xAB, 0xFF, 0x0B, 0x95,
+	0x87, 0xB3, 0x77, 0x9C, 0x52, 0x45, 0x77, 0xF8, 0xA5, 0x7C, 0x19, 0x92, 0x3B, 0x39, 0xCD, 0x3F,
+	0x5C, 0xCD, 0xD4, 0x57, 0xD3, 0x60, 0xDC, 0x26, 0x19, 0xCD, 0xBB, 0x94, 0x32, 0x87, 0x77, 0xBB,
+	0x90, 0x5E, 0x1C, 0xB7, 0x9E, 0x28, 0x04, 0x58, 0xF6, 0x0C, 0x8C, 0x55, 0x93, 0xEF, 0xD2, 0x2D,
+	0x63, 0x85, 0x51, 0x2B, 0x11, 0xB7, 0xF2, 0xEA, 0xFE, 0x11, 0x84, 0xCF, 0x90, 0x66, 0xB9, 0xB4,
+	0x7A, 0x0B, 0xF8, 0x32, 0x04, 0x50, 0x66, 0x35, 0x9A, 0xE4, 0x65, 0x47, 0x3D, 0x31, 0xB9, 0xF8,
+	0x30, 0xA6, 0xDE, 0x7D, 0x88, 0xE9, 0x69, 0xCB, 0x45, 0x60, 0x33, 0xF8, 0x07, 0x3B, 0xEC, 0x51,
+	0x22, 0x05, 0x92, 0x0E, 0x3D, 0xEA, 0x77, 0x3D, 0x3E, 0x36, 0xE1, 0xF4, 0x6C, 0x2E, 0x8B, 0xDD,
+	0xC4, 0x23, 0xFB, 0x67, 0x5C, 0xA1, 0x71, 0x0A, 0x3D, 0x0A, 0x06, 0xE9, 0xC7, 0x57, 0x09, 0x19,
+	0x73, 0x51, 0x90, 0xBD, 0x6E, 0xD6, 0x5B, 0xD5, 0xEF, 0x92, 0xC0, 0x41, 0x6B, 0xFE, 0x40, 0x94,
+	0xEA, 0x96, 0xA2, 0x18, 0x01, 0x38, 0x38, 0xEF, 0x33, 0x71, 0x51, 0xA8, 0xBE, 0x72, 0x22, 0xDC,
+	0xF0, 0x71, 0x73, 0x99, 0x55, 0x3C, 0x4D, 0xDA, 0x16, 0xEB, 0xAB, 0xB2, 0xDD, 0x38, 0x6A, 0x07,
+	0xBD, 0xF3, 0x13, 0xD9, 0x70, 0xC1, 0x32, 0x4C, 0xAA, 0xB8, 0x85, 0x06, 0x76, 0x91, 0xE3, 0xEE,
+	0x5E, 0x5D, 0x8B, 0x91, 0x27, 0x99, 0xBD, 0x53, 0xC8, 0xE1, 0x83, 0x02, 0x37, 0xE9, 0xEC, 0x0A,
+	0x92, 0x54, 0xD8, 0x0B, 0x2B, 0xD3, 0x62, 0x2C,
+};
+
+static const struct test_tlv_t test_tlvs[] = {
+	// First and last entries of tag information table
+	{ EMV_TAG_42_IIN, sizeof(test_iin), test_iin, "Issuer Identification Number (IIN)", EMV_FORMAT_N },
+	{ EMV_TAG_BF4D_PREFERRED_ATTEMPTS_TEMPLATE, 0, NULL, "Preferred Attempts Template", EMV_FORMAT_VAR },
+
+	{ EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, sizeof(test_amount), test_amount, "Amount, Authorised (Numeric)", EMV_FORMAT_N },
+
+	// Tag used for different purposes by different kernels
+	{ 0x9F6E, sizeof(test_third_party_data), test_third_party_data, "Third Party Data", EMV_FORMAT_VAR },
+	{ 0x9F6E, sizeof(test_visa_ffi), test_visa_ffi, "Form Factor Indicator (FFI)", EMV_FORMAT_B },
+	{ 0x9F6E, sizeof(test_amex_enh_cl_reader_caps), test_amex_enh_cl_reader_caps, "Enhanced Contactless Reader Capabilities", EMV_FORMAT_B },
+	{ 0x9F6E, sizeof(test_unknown), test_unknown, NULL, EMV_FORMAT_B },
+
+	// Unknown field
+	{ 0x9F99, sizeof(test_unknown), test_unknown, NULL, EMV_FORMAT_B },
+};
+
+#ifdef HAVE_PTHREAD
+#define READER_COUNT (4)
+#define CLEAR_ITERATIONS (200)
+
+struct cert_cache_reader_t {
+	pthread_t thread;
+	const struct emv_tlv_sources_t* sources;
+	const char* expected_str;
+	unsigned int error_count;
+};
+
+static atomic_bool readers_stop = false;
+
+static void* cert_cache_reader_func(void* arg)
+{
+	struct cert_cache_reader_t* reader = arg;
+	char value_str[2048];
+
+	while (!atomic_load(&readers_stop)) {
+		int r;
+
+		r = emv_tlv_get_value_string(
+			reader->sources->list[0]->front,
+			reader->sources,
+			value_str,
+			sizeof(value_str)
+		);
+		if (r || strcmp(value_str, reader->expected_str) != 0) {
+			++reader->error_count;
+		}
+	}
+
+	return NULL;
+}
+
+static int test_cert_cache_concurrency(
+	const struct emv_tlv_sources_t* sources,
+	const char* expected_str
+)
+{
+	int r = 0;
+	struct cert_cache_reader_t readers[READER_COUNT];
+
+	// Readers share the sources and the cache while the cache is cleared
+	memset(readers, 0, sizeof(readers));
+	for (unsigned int i = 0; i < READER_COUNT; ++i) {
+		readers[i].sources = sources;
+		readers[i].expected_str = expected_str;
+		r = pthread_create(&readers[i].thread, NULL, &cert_cache_reader_func, &readers[i]);
+		if (r) {
+			fprintf(stderr, "pthread_create() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < CLEAR_ITERATIONS; ++i) {
+		emv_cert_cache_clear(sources->cert_cache);
+		sched_yield();
+	}
+
+	atomic_store(&readers_stop, true);
+	for (unsigned int i = 0; i < READER_COUNT; ++i) {
+		pthread_join(readers[i].thread, NULL);
+		if (readers[i].error_count) {
+			fprintf(stderr, "Reader %u found %u unexpected values\n", i, readers[i].error_count);
+			r = 1;
+		}
+	}
+
+	return r;
+}
+#endif
+
+int main(void)
+{
+	int r;
+
+	for (size_t i = 0; i < sizeof(test_tlvs) / sizeof(test_tlvs[0]); ++i) {
+		const struct test_tlv_t* test = &test_tlvs[i];
+		struct emv_tlv_t tlv;
+		struct emv_tlv_info_t info;
+		struct emv_tlv_info_t tag_info;
+		char value_str[2048];
+		char split_value_str[2048];
+		int r_split;
+
+		memset(&tlv, 0, sizeof(tlv));
+		tlv.tag = test->tag;
+		tlv.length = test->length;
+		tlv.value = (uint8_t*)test->value;
+
+		r = emv_tlv_get_tag_info(&tlv, &tag_info);
+		if (r < 0) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) failed; r=%d\n", test->tag, r);
+			return 1;
+		}
+		if ((r == 0) != (test->tag_name != NULL)) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) unexpected result; r=%d\n", test->tag, r);
+			return 1;
+		}
+		if (test->tag_name &&
+			(!tag_info.tag_name || strcmp(tag_info.tag_name, test->tag_name) != 0)
+		) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) found unexpected tag name \"%s\"\n", test->tag, tag_info.tag_name);
+			return 1;
+		}
+		if (!test->tag_name && tag_info.tag_name) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) found unexpected tag name \"%s\"\n", test->tag, tag_info.tag_name);
+			return 1;
+		}
+		if (tag_info.format != test->format) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) found unexpected format %d\n", test->tag, tag_info.format);
+			return 1;
+		}
+
+		// Tag information and value string must be the same as when
+		// obtained together
+		r = emv_tlv_get_info(&tlv, NULL, &info, value_str, sizeof(value_str));
+		r_split = emv_tlv_get_value_string(&tlv, NULL, split_value_str, sizeof(split_value_str));
+		if (r != r_split) {
+			fprintf(stderr, "emv_tlv_get_value_string(%X) unexpected result; r=%d; expected r=%d\n", test->tag, r_split, r);
+			return 1;
+		}
+		if (info.tag_name != tag_info.tag_name ||
+			info.tag_desc != tag_info.tag_desc ||
+			info.format != tag_info.format
+		) {
+			fprintf(stderr, "emv_tlv_get_tag_info(%X) differs from emv_tlv_get_info()\n", test->tag);
+			return 1;
+		}
+		if (strcmp(value_str, split_value_str) != 0) {
+			fprintf(stderr, "emv_tlv_get_value_string(%X) found \"%s\"; expected \"%s\"\n", test->tag, split_value_str, value_str);
+			return 1;
+		}
+	}
+
+	// Amount value string
+	{
+		struct emv_tlv_t tlv;
+		char value_str[64];
+
+		memset(&tlv, 0, sizeof(tlv));
+		tlv.tag = EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC;
+		tlv.length = sizeof(test_amount);
+		tlv.value = (uint8_t*)test_amount;
+
+		r = emv_tlv_get_value_string(&tlv, NULL, value_str, sizeof(value_str));
+		if (r) {
+			fprintf(stderr, "emv_tlv_get_value_string() failed; r=%d\n", r);
+			return 1;
+		}
+		if (strcmp(value_str, "12345") != 0) {
+			fprintf(stderr, "emv_tlv_get_value_string() found unexpected value \"%s\"\n", value_str);
+			return 1;
+		}
+	}
+
+	// Certificate recovery cache
+	{
+		struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+		struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
+		struct emv_cert_cache_t cert_cache = EMV_CERT_CACHE_INIT;
+		char expected_str[2048];
+		char value_str[2048];
+
+		r = emv_capk_load_static();
+		if (r) {
+			fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+			return 1;
+		}
+
+		emv_tlv_list_push(&list, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, sizeof(valid_issuer_cert), valid_issuer_cert, 0);
+		sources.count = 1;
+		sources.list[0] = &list;
+
+		r = emv_tlv_get_value_string(list.front, &sources, expected_str, sizeof(expected_str));
+		if (r) {
+			fprintf(stderr, "emv_tlv_get_value_string() failed; r=%d\n", r);
+			return 1;
+		}
+		if (!strstr(expected_str, "Retrieved using CAPK A000000003 #94")) {
+			fprintf(stderr, "emv_tlv_get_value_string() found unexpected value \"%s\"\n", expected_str);
+			return 1;
+		}
+
+		r = emv_tlv_sources_enable_cert_cache(&sources, &cert_cache);
+		if (r) {
+			fprintf(stderr, "emv_tlv_sources_enable_cert_cache() failed; r=%d\n", r);
+			return 1;
+		}
+		for (unsigned int i = 0; i < 3; ++i) {
+			if (i == 2) {
+				// Modifying the sources must discard the cache
+				emv_tlv_list_push(&list, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, 1, (uint8_t[]){ 0x03 }, 0);
+			}
+
+			r = emv_tlv_get_value_string(list.front, &sources, value_str, sizeof(value_str));
+			if (r) {
+				fprintf(stderr, "emv_tlv_get_value_string() failed; r=%d\n", r);
+				return 1;
+			}
+			if (strcmp(value_str, expected_str) != 0) {
+				fprintf(stderr, "emv_tlv_get_value_string() found \"%s\"; expected \"%s\"\n", value_str, expected_str);
+				return 1;
+			}
+			if (!cert_cache.entries || cert_cache.list[0].generation != list.generation) {
+				fprintf(stderr, "Certificate recovery cache not populated\n");
+				return 1;
+			}
+		}
+
+		// Clearing the CAPK store must discard the cache instead of using
+		// the CAPK that was previously found
+		emv_capk_clear();
+		r = emv_tlv_get_value_string(list.front, &sources, value_str, sizeof(value_str));
+		if (r == 0 && strstr(value_str, "Retrieved using CAPK")) {
+			fprintf(stderr, "emv_tlv_get_value_string() found unexpected value \"%s\"\n", value_str);
+			return 1;
+		}
+		if (!cert_cache.entries || cert_cache.capk_generation != emv_capk_get_generation()) {
+			fprintf(stderr, "Certificate recovery cache not populated\n");
+			return 1;
+		}
+
+		// Loading CAPKs must discard the cached failure
+		r = emv_capk_load_static();
+		if (r) {
+			fprintf(stderr, "emv_capk_load_static() failed; r=%d\n", r);
+			return 1;
+		}
+		r = emv_tlv_get_value_string(list.front, &sources, value_str, sizeof(value_str));
+		if (r) {
+			fprintf(stderr, "emv_tlv_get_value_string() failed; r=%d\n", r);
+			return 1;
+		}
+		if (strcmp(value_str, expected_str) != 0) {
+			fprintf(stderr, "emv_tlv_get_value_string() found \"%s\"; expected \"%s\"\n", value_str, expected_str);
+			return 1;
+		}
+
+#ifdef HAVE_PTHREAD
+		r = test_cert_cache_concurrency(&sources, expected_str);
+		if (r) {
+			return 1;
+		}
+#endif
+
+		emv_cert_cache_clear(&cert_cache);
+		emv_tlv_list_clear(&list);
+		emv_capk_clear();
+	}
+
+	printf("Success\n");
+
+	return 0;
+}
@@ -0,0 +1,495 @@
+/**
+ * @file emv_tlv_test.c
+ * @brief Unit tests for EMV TLV list processing
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_tlv.h"
+#include "emv_tags.h"
+#include "iso8825_ber.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+// For debug output
+#include "print_helpers.h"
+
+static int compare_find(
+	struct emv_tlv_list_t* indexed_list,
+	struct emv_tlv_list_t* list,
+	unsigned int first_tag,
+	unsigned int last_tag
+)
+{
+	for (unsigned int tag = first_tag; tag <= last_tag; ++tag) {
+		const struct emv_tlv_t* tlv1;
+		const struct emv_tlv_t* tlv2;
+
+		tlv1 = emv_tlv_list_find_const(indexed_list, tag);
+		tlv2 = emv_tlv_list_find_const(list, tag);
+		if (!tlv1 != !tlv2) {
+			fprintf(stderr, "Indexed find mismatch for tag %X\n", tag);
+			return 1;
+		}
+		if (tlv1 && (tlv1->length != tlv2->length || tlv1->value[0] != tlv2->value[0])) {
+			fprintf(stderr, "Indexed find found incorrect field for tag %X\n", tag);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(void)
+{
+	int r;
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+	struct emv_tlv_list_t indexed_list = EMV_TLV_LIST_INIT;
+	struct emv_tlv_list_t other = EMV_TLV_LIST_INIT;
+	struct emv_tlv_arena_t arena = { 0 };
+	struct emv_tlv_sources_t sources = EMV_TLV_SOURCES_INIT;
+	struct emv_tlv_sources_t other_sources = EMV_TLV_SOURCES_INIT;
+	struct emv_tlv_sources_index_t sources_index = EMV_TLV_SOURCES_INDEX_INIT;
+	const struct emv_tlv_t* tlv;
+	struct emv_tlv_t* popped;
+	const uint8_t* arena_value;
+	uint8_t record[] = {
+		0x70, 0x0E,
+			0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10,
+			0x5F, 0x34, 0x01, 0x01,
+	};
+
+	printf("\nTest 1: Indexed find of duplicate fields...\n");
+	r = emv_tlv_list_enable_index(&indexed_list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_enable_index() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_push(&indexed_list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x01 }, 0);
+	emv_tlv_list_push(&indexed_list, EMV_TAG_5A_APPLICATION_PAN, 1, (uint8_t[]){ 0x02 }, 0);
+	emv_tlv_list_push(&indexed_list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x03 }, 0);
+	print_emv_tlv_list(&indexed_list);
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x01) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find first field\n");
+		r = 1;
+		goto exit;
+	}
+	// Push after index is built
+	emv_tlv_list_push(&indexed_list, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC, 1, (uint8_t[]){ 0x04 }, 0);
+	emv_tlv_list_push(&indexed_list, EMV_TAG_5A_APPLICATION_PAN, 1, (uint8_t[]){ 0x05 }, 0);
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_5A_APPLICATION_PAN);
+	if (!tlv || tlv->value[0] != 0x02) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find first field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x04) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find pushed field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+	if (tlv) {
+		fprintf(stderr, "emv_tlv_list_find_const() found unexpected field\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 2: Indexed find after pop...\n");
+	popped = emv_tlv_list_pop(&indexed_list);
+	emv_tlv_free(popped);
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x03) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find remaining field\n");
+		r = 1;
+		goto exit;
+	}
+	// Rebuild index after pop
+	tlv = emv_tlv_list_find(&indexed_list, EMV_TAG_5A_APPLICATION_PAN);
+	if (!tlv || tlv->value[0] != 0x02) {
+		fprintf(stderr, "emv_tlv_list_find() did not find remaining field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&indexed_list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x03) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find remaining field\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 3: Indexed find after append and growth...\n");
+	emv_tlv_list_clear(&indexed_list);
+	for (unsigned int tag = 0x9F00; tag < 0x9F80; ++tag) {
+		emv_tlv_list_push(&indexed_list, tag, 1, (uint8_t[]){ tag & 0xFF }, 0);
+		emv_tlv_list_push(&list, tag, 1, (uint8_t[]){ tag & 0xFF }, 0);
+		if (tag == 0x9F08 && !emv_tlv_list_find_const(&indexed_list, tag)) {
+			// Index is built while list is small and grows as fields are pushed
+			fprintf(stderr, "emv_tlv_list_find_const() did not find pushed field\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	for (unsigned int tag = 0x9F40; tag < 0x9FC0; ++tag) {
+		emv_tlv_list_push(&other, tag, 2, (uint8_t[]){ 0xFF, 0xFF }, 0);
+	}
+	r = emv_tlv_list_append(&indexed_list, &other);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_append() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	for (unsigned int tag = 0x9F40; tag < 0x9FC0; ++tag) {
+		emv_tlv_list_push(&other, tag, 2, (uint8_t[]){ 0xFF, 0xFF }, 0);
+	}
+	r = emv_tlv_list_append(&list, &other);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_append() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = compare_find(&indexed_list, &list, 0x9EF0, 0x9FD0);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Indexed find after clear...\n");
+	emv_tlv_list_clear(&indexed_list);
+	if (!indexed_list.indexed) {
+		fprintf(stderr, "emv_tlv_list_clear() unexpectedly disabled index\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&indexed_list, 0x9F10);
+	if (tlv) {
+		fprintf(stderr, "emv_tlv_list_find_const() found unexpected field\n");
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_push(&indexed_list, 0x9F10, 1, (uint8_t[]){ 0x10 }, 0);
+	tlv = emv_tlv_list_find_const(&indexed_list, 0x9F10);
+	if (!tlv || tlv->value[0] != 0x10) {
+		fprintf(stderr, "emv_tlv_list_find_const() did not find pushed field\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Parse with borrowed values...\n");
+	emv_tlv_list_clear(&list);
+	r = emv_tlv_parse_borrowed(record, sizeof(record), &list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_parse_borrowed() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	print_emv_tlv_list(&list);
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_5A_APPLICATION_PAN);
+	if (!tlv || tlv->length != 8 || tlv->value != record + 4) {
+		fprintf(stderr, "emv_tlv_parse_borrowed() did not borrow value\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_5F34_APPLICATION_PAN_SEQUENCE_NUMBER);
+	if (!tlv || tlv->length != 1 || tlv->value != record + 15) {
+		fprintf(stderr, "emv_tlv_parse_borrowed() did not borrow value\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 6: Materialise borrowed values...\n");
+	r = emv_tlv_list_materialise(&list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_materialise() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	// Modify buffer to ensure that values are no longer borrowed
+	record[15] = 0x02;
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_5F34_APPLICATION_PAN_SEQUENCE_NUMBER);
+	if (!tlv || tlv->length != 1 || tlv->value == record + 15 || tlv->value[0] != 0x01) {
+		fprintf(stderr, "emv_tlv_list_materialise() did not copy value\n");
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_clear(&list);
+	record[15] = 0x01;
+	printf("Success\n");
+
+	printf("\nTest 7: Parse and materialise using arena...\n");
+	r = emv_tlv_arena_init(&arena, 0);
+	if (r) {
+		fprintf(stderr, "emv_tlv_arena_init() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	list.arena = &arena;
+	r = emv_tlv_parse(record, sizeof(record), &list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_parse() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_5A_APPLICATION_PAN);
+	if (!tlv || (tlv->value >= record && tlv->value < record + sizeof(record))) {
+		fprintf(stderr, "emv_tlv_parse() did not copy value to arena\n");
+		r = 1;
+		goto exit;
+	}
+	arena_value = tlv->value;
+	r = emv_tlv_parse_borrowed(record, sizeof(record), &list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_parse_borrowed() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_tlv_list_materialise(&list);
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_materialise() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	// Values copied to the arena by emv_tlv_parse() should not be copied again
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_5A_APPLICATION_PAN);
+	if (!tlv || tlv->value != arena_value) {
+		fprintf(stderr, "emv_tlv_list_materialise() unexpectedly copied arena value\n");
+		r = 1;
+		goto exit;
+	}
+	// Modify buffer to ensure that no values refer to it
+	record[15] = 0x02;
+	for (tlv = list.front; tlv != NULL; tlv = tlv->next) {
+		if (tlv->value >= record && tlv->value < record + sizeof(record)) {
+			fprintf(stderr, "Arena list refers to parsed buffer\n");
+			r = 1;
+			goto exit;
+		}
+		if (tlv->tag == EMV_TAG_5F34_APPLICATION_PAN_SEQUENCE_NUMBER && tlv->value[0] != 0x01) {
+			fprintf(stderr, "Arena list has incorrect value\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	printf("\nTest 8: Duplicate EMV fields...\n");
+	emv_tlv_list_clear(&list);
+	list.arena = NULL;
+	emv_tlv_list_push(&list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x01 }, 0);
+	emv_tlv_list_push(&list, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC, 1, (uint8_t[]){ 0x02 }, 0);
+	if (emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() unexpectedly found duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_push(&list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x03 }, 0);
+	if (!emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() did not find duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 9: Duplicate ASN.1 objects...\n");
+	emv_tlv_list_clear(&list);
+	for (unsigned int i = 0; i < 100; ++i) {
+		// Enough objects to require heap allocation
+		struct iso8825_oid_t oid = { 4, { 1, 2, 840, i } };
+		r = emv_tlv_list_push_asn1_object(&list, &oid, 3, (uint8_t[]){ 0x02, 0x01, i & 0xFF });
+		if (r) {
+			fprintf(stderr, "emv_tlv_list_push_asn1_object() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+	}
+	if (emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() unexpectedly found duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_tlv_list_push_asn1_object(&list, &(struct iso8825_oid_t){ 4, { 1, 2, 840, 42 } }, 3, (uint8_t[]){ 0x02, 0x01, 0xFF });
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push_asn1_object() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (!emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() did not find duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 10: ASN.1 object after EMV field with same tag...\n");
+	emv_tlv_list_clear(&list);
+	// Sequence without OID is not an ASN.1 object
+	emv_tlv_list_push(&list, ISO8825_BER_CONSTRUCTED | ASN1_SEQUENCE, 3, (uint8_t[]){ 0x02, 0x01, 0x00 }, ISO8825_BER_CONSTRUCTED);
+	emv_tlv_list_push_asn1_object(&list, &(struct iso8825_oid_t){ 4, { 1, 2, 840, 1 } }, 3, (uint8_t[]){ 0x02, 0x01, 0x00 });
+	if (!emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() did not find duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_clear(&list);
+	// ASN.1 object is not a duplicate of a subsequent EMV field
+	emv_tlv_list_push_asn1_object(&list, &(struct iso8825_oid_t){ 4, { 1, 2, 840, 1 } }, 3, (uint8_t[]){ 0x02, 0x01, 0x00 });
+	emv_tlv_list_push(&list, ISO8825_BER_CONSTRUCTED | ASN1_SEQUENCE, 3, (uint8_t[]){ 0x02, 0x01, 0x00 }, ISO8825_BER_CONSTRUCTED);
+	if (emv_tlv_list_has_duplicate(&list)) {
+		fprintf(stderr, "emv_tlv_list_has_duplicate() unexpectedly found duplicate\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 11: Indexed find in sources...\n");
+	emv_tlv_list_clear(&list);
+	emv_tlv_list_clear(&other);
+	emv_tlv_list_push(&list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x01 }, 0);
+	emv_tlv_list_push(&list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x02 }, 0);
+	emv_tlv_list_push(&other, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x03 }, 0);
+	emv_tlv_list_push(&other, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC, 1, (uint8_t[]){ 0x04 }, 0);
+	sources.count = 2;
+	sources.list[0] = &list;
+	sources.list[1] = &other;
+	r = emv_tlv_sources_enable_index(&sources, &sources_index);
+	if (r) {
+		fprintf(stderr, "emv_tlv_sources_enable_index() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x01) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find highest priority field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x04) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+	if (tlv) {
+		fprintf(stderr, "emv_tlv_sources_find_const() found unexpected field\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 12: Indexed find in sources after list changes...\n");
+	// Higher priority list now provides the field
+	emv_tlv_list_push(&list, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC, 1, (uint8_t[]){ 0x05 }, 0);
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F03_AMOUNT_OTHER_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x05) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find pushed field\n");
+		r = 1;
+		goto exit;
+	}
+	// Popped field must no longer be found
+	popped = emv_tlv_list_pop(&list);
+	emv_tlv_free(popped);
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x02) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find remaining field\n");
+		r = 1;
+		goto exit;
+	}
+	// Same index used for different sources in a different order
+	other_sources.count = 2;
+	other_sources.list[0] = &other;
+	other_sources.list[1] = &list;
+	emv_tlv_sources_enable_index(&other_sources, &sources_index);
+	tlv = emv_tlv_sources_find_const(&other_sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x03) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find highest priority field\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x02) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find highest priority field\n");
+		r = 1;
+		goto exit;
+	}
+	// Cleared list must no longer be found
+	emv_tlv_list_clear(&list);
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x03) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find remaining field\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 13: Indexed find in sources after list is replaced...\n");
+	emv_tlv_arena_reset(&arena);
+	list = EMV_TLV_LIST_INIT;
+	list.arena = &arena;
+	emv_tlv_list_push(&list, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 1, (uint8_t[]){ 0x06 }, 0);
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x06) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find pushed field\n");
+		r = 1;
+		goto exit;
+	}
+	// Replace list with a new list at the same address having the same
+	// number of modifications and a field at the same address
+	emv_tlv_list_clear(&list);
+	emv_tlv_arena_reset(&arena);
+	list = EMV_TLV_LIST_INIT;
+	list.arena = &arena;
+	emv_tlv_list_push(&list, EMV_TAG_9F37_UNPREDICTABLE_NUMBER, 1, (uint8_t[]){ 0x07 }, 0);
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC);
+	if (!tlv || tlv->value[0] != 0x03) {
+		fprintf(stderr, "emv_tlv_sources_find_const() found field of previous list\n");
+		r = 1;
+		goto exit;
+	}
+	tlv = emv_tlv_sources_find_const(&sources, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+	if (!tlv || tlv->value[0] != 0x07) {
+		fprintf(stderr, "emv_tlv_sources_find_const() did not find pushed field\n");
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_clear(&list);
+	list.arena = NULL;
+	printf("Success\n");
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	emv_tlv_list_clear(&list);
+	emv_tlv_list_clear(&indexed_list);
+	emv_tlv_list_disable_index(&indexed_list);
+	emv_tlv_list_clear(&other);
+	emv_tlv_arena_clear(&arena);
+	emv_tlv_sources_index_clear(&sources_index);
+
+	return r;
+}
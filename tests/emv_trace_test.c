@@ -0,0 +1,331 @@
+/**
+ * @file emv_trace_test.c
+ * @brief Unit tests for binary EMV debug trace format
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_TTL
+#include "emv_debug.h"
+#include "emv_trace.h"
+#include "emv_tlv.h"
+#include "iso7816.h"
+#include "iso8825_ber.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t test_atr[] = { 0x3B, 0xE0, 0x00, 0xFF, 0x81, 0x31, 0x7C, 0x41, 0x92 };
+static const uint8_t test_capdu[] = { 0x00, 0xA4, 0x04, 0x00, 0x07, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x00 };
+static const uint8_t test_pan[] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10 };
+static const uint8_t test_amount[] = { 0x00, 0x00, 0x00, 0x01, 0x23, 0x45 };
+static const uint8_t test_tlv_list_data[] = {
+	0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x00, 0x10,
+	0x9F, 0x02, 0x06, 0x00, 0x00, 0x00, 0x01, 0x23, 0x45,
+};
+static uint8_t test_large_data[1000];
+
+static void* load_trace(FILE* file, size_t* len)
+{
+	long file_len;
+	void* buf;
+
+	file_len = ftell(file);
+	if (file_len <= 0) {
+		return NULL;
+	}
+	rewind(file);
+
+	buf = malloc(file_len);
+	if (fread(buf, file_len, 1, file) != 1) {
+		free(buf);
+		return NULL;
+	}
+
+	*len = file_len;
+	return buf;
+}
+
+static int decode_next_event(
+	const uint8_t** ptr,
+	size_t* len,
+	struct emv_trace_event_t* event
+)
+{
+	int r;
+	struct iso8825_tlv_t tlv;
+
+	r = iso8825_ber_decode(*ptr, *len, &tlv);
+	if (r <= 0) {
+		fprintf(stderr, "iso8825_ber_decode() failed; r=%d\n", r);
+		return -1;
+	}
+	if (tlv.tag != EMV_TRACE_TAG_EVENT) {
+		fprintf(stderr, "Unexpected event tag %02X\n", tlv.tag);
+		return -2;
+	}
+	*ptr += r;
+	*len -= r;
+
+	r = emv_trace_event_decode(tlv.value, tlv.length, event);
+	if (r) {
+		fprintf(stderr, "emv_trace_event_decode() failed; r=%d\n", r);
+		return -3;
+	}
+
+	return 0;
+}
+
+int main(void)
+{
+	int r;
+	FILE* file;
+	struct emv_trace_writer_t writer;
+	struct iso7816_atr_info_t atr_info;
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+	uint8_t* trace = NULL;
+	size_t trace_len;
+	const uint8_t* ptr;
+	size_t len;
+	struct emv_trace_event_t event;
+	size_t event_len;
+	uint8_t event_buf[16];
+	struct emv_debug_config_t trace_config = {
+		.sources_mask = EMV_DEBUG_SOURCE_ALL,
+		.level = EMV_DEBUG_LEVEL_ALL,
+		.func = &emv_trace_debug_func,
+	};
+
+	for (size_t i = 0; i < sizeof(test_large_data); ++i) {
+		test_large_data[i] = i;
+	}
+
+	r = iso7816_atr_parse(test_atr, sizeof(test_atr), &atr_info);
+	if (r) {
+		fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+		return 1;
+	}
+	emv_tlv_list_push(&list, 0x5A, sizeof(test_pan), test_pan, 0);
+	emv_tlv_list_push(&list, 0x9F02, sizeof(test_amount), test_amount, 0);
+
+	file = tmpfile();
+	if (!file) {
+		fprintf(stderr, "tmpfile() failed\n");
+		r = 1;
+		goto exit;
+	}
+
+	printf("Testing event encoding with small output buffer...\n");
+	event_len = sizeof(event_buf);
+	r = emv_trace_event_encode(
+		0x12345678,
+		EMV_DEBUG_SOURCE_TTL,
+		EMV_DEBUG_LEVEL_CARD,
+		EMV_DEBUG_TYPE_CAPDU,
+		"C-APDU",
+		test_capdu,
+		sizeof(test_capdu),
+		event_buf,
+		&event_len
+	);
+	if (r <= 0 || event_len <= sizeof(event_buf)) {
+		fprintf(stderr, "emv_trace_event_encode() unexpected result; r=%d; event_len=%zu\n", r, event_len);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("Testing trace writer...\n");
+	r = emv_trace_writer_init(&writer, file);
+	if (r) {
+		fprintf(stderr, "emv_trace_writer_init() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_trace_writer_write(&writer, 0x12345678, EMV_DEBUG_SOURCE_TTL, EMV_DEBUG_LEVEL_CARD, EMV_DEBUG_TYPE_CAPDU, "C-APDU", test_capdu, sizeof(test_capdu));
+	if (r) {
+		fprintf(stderr, "emv_trace_writer_write() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_trace_writer_write(&writer, 2, EMV_DEBUG_SOURCE_TAL, EMV_DEBUG_LEVEL_INFO, EMV_DEBUG_TYPE_TLV_LIST, "Fields", &list, sizeof(list));
+	if (r) {
+		fprintf(stderr, "emv_trace_writer_write() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_trace_writer_write(&writer, 3, EMV_DEBUG_SOURCE_TTL, EMV_DEBUG_LEVEL_CARD, EMV_DEBUG_TYPE_ATR, "ATR", &atr_info, sizeof(atr_info));
+	if (r) {
+		fprintf(stderr, "emv_trace_writer_write() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r = emv_trace_writer_write(&writer, 4, EMV_DEBUG_SOURCE_ODA, EMV_DEBUG_LEVEL_TRACE, EMV_DEBUG_TYPE_DATA, "Large", test_large_data, sizeof(test_large_data));
+	if (r) {
+		fprintf(stderr, "emv_trace_writer_write() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("Testing trace debug event function...\n");
+	trace_config.user_data = &writer;
+	r = emv_debug_set_thread_config(&trace_config);
+	if (r) {
+		fprintf(stderr, "emv_debug_set_thread_config() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	emv_debug_info("Message %d", 42);
+	emv_debug_set_thread_config(NULL);
+	if (writer.event_count != 5 || writer.error) {
+		fprintf(stderr, "Unexpected writer state; event_count=%lu; error=%d\n", writer.event_count, writer.error);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("Testing trace decoding...\n");
+	trace = load_trace(file, &trace_len);
+	if (!trace) {
+		fprintf(stderr, "Failed to load trace\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_trace_header_decode(trace, trace_len);
+	if (r) {
+		fprintf(stderr, "emv_trace_header_decode() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	ptr = trace + EMV_TRACE_HEADER_LEN;
+	len = trace_len - EMV_TRACE_HEADER_LEN;
+
+	r = decode_next_event(&ptr, &len, &event);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (event.timestamp != 0x12345678 ||
+		event.source != EMV_DEBUG_SOURCE_TTL ||
+		event.level != EMV_DEBUG_LEVEL_CARD ||
+		event.debug_type != EMV_DEBUG_TYPE_CAPDU ||
+		strcmp(event.str, "C-APDU") != 0 ||
+		event.data_len != sizeof(test_capdu) ||
+		memcmp(event.data, test_capdu, sizeof(test_capdu)) != 0
+	) {
+		fprintf(stderr, "Incorrect C-APDU event\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = decode_next_event(&ptr, &len, &event);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (event.debug_type != EMV_DEBUG_TYPE_TLV_LIST ||
+		strcmp(event.str, "Fields") != 0 ||
+		event.data_len != sizeof(test_tlv_list_data) ||
+		memcmp(event.data, test_tlv_list_data, sizeof(test_tlv_list_data)) != 0
+	) {
+		fprintf(stderr, "Incorrect EMV TLV list event\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = decode_next_event(&ptr, &len, &event);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (event.debug_type != EMV_DEBUG_TYPE_ATR ||
+		event.data_len != sizeof(test_atr) ||
+		memcmp(event.data, test_atr, sizeof(test_atr)) != 0
+	) {
+		fprintf(stderr, "Incorrect ATR event\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = decode_next_event(&ptr, &len, &event);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (event.source != EMV_DEBUG_SOURCE_ODA ||
+		event.data_len != sizeof(test_large_data) ||
+		memcmp(event.data, test_large_data, sizeof(test_large_data)) != 0
+	) {
+		fprintf(stderr, "Incorrect large data event\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = decode_next_event(&ptr, &len, &event);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (event.debug_type != EMV_DEBUG_TYPE_MSG ||
+		event.level != EMV_DEBUG_LEVEL_INFO ||
+		strcmp(event.str, "Message 42") != 0 ||
+		event.data
+	) {
+		fprintf(stderr, "Incorrect message event \"%s\"\n", event.str);
+		r = 1;
+		goto exit;
+	}
+	if (len) {
+		fprintf(stderr, "Unexpected trailing trace data\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("Testing invalid trace header...\n");
+	trace[EMV_TRACE_HEADER_LEN - 1] = EMV_TRACE_VERSION + 1;
+	r = emv_trace_header_decode(trace, trace_len);
+	if (r <= 0) {
+		fprintf(stderr, "emv_trace_header_decode() did not reject version; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	trace[0] = 'X';
+	r = emv_trace_header_decode(trace, trace_len);
+	if (r >= 0) {
+		fprintf(stderr, "emv_trace_header_decode() did not reject magic; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	r = 0;
+
+exit:
+	if (trace) {
+		free(trace);
+	}
+	if (file) {
+		fclose(file);
+	}
+	emv_tlv_list_clear(&list);
+
+	return r;
+}
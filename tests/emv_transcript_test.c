@@ -0,0 +1,805 @@
+/**
+ * @file emv_transcript_test.c
+ * @brief Unit tests for card reader transcript recording and replay
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_transcript.h"
+#include "emv_cardreader_emul.h"
+#include "emv_ttl.h"
+#include "emv_app.h"
+#include "emv_fields.h"
+#include "emv_tags.h"
+#include "emv_utils_config.h"
+#include "iso7816.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// For debug output
+#include "print_helpers.h"
+
+static const uint8_t test_atr[] = { 0x3B, 0x02, 0x14, 0x50 };
+
+#define TEST_PSE \
+	{ \
+		20, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0x00 }, /* SELECT 1PAY.SYS.DDF01 */ \
+		36, (uint8_t[]){ 0x6F, 0x20, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0xA5, 0x0E, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x04, 0x6E, 0x6C, 0x65, 0x6E, 0x9F, 0x11, 0x01, 0x01, 0x90, 0x00 }, /* FCI */ \
+	}, \
+	{ \
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, /* READ RECORD 1,1 */ \
+		42, (uint8_t[]){ 0x70, 0x26, 0x61, 0x11, 0x4F, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0x50, 0x02, 0x41, 0x31, 0x87, 0x01, 0x01, 0x61, 0x11, 0x4F, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x02, 0x50, 0x02, 0x41, 0x32, 0x87, 0x01, 0x02, 0x90, 0x00 }, /* AEF with two applications */ \
+	}, \
+	{ \
+		5, (uint8_t[]){ 0x00, 0xB2, 0x02, 0x0C, 0x00 }, /* READ RECORD 1,2 */ \
+		2, (uint8_t[]){ 0x6A, 0x83 }, /* Record not found */ \
+	}
+
+static const struct xpdu_t test_pse[] = {
+	TEST_PSE,
+	{ 0 }
+};
+
+// Transaction with PDOL and CDOL1 requesting Unpredictable Number
+// (field 9F37) and Transaction Date (field 9A)
+static const uint8_t test_txn_un[] = { 0x11, 0x22, 0x33, 0x44 };
+static const uint8_t test_txn_date[] = { 0x26, 0x02, 0x14 };
+static const uint8_t test_txn_time[] = { 0x10, 0x11, 0x12 };
+static const struct xpdu_t test_txn[] = {
+	TEST_PSE,
+	{
+		14, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0x00 }, // SELECT A000000003101001
+		31, (uint8_t[]){ 0x6F, 0x1B, 0x84, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0xA5, 0x0F, 0x50, 0x02, 0x41, 0x31, 0x87, 0x01, 0x01, 0x9F, 0x38, 0x05, 0x9F, 0x37, 0x04, 0x9A, 0x03, 0x90, 0x00 }, // FCI with PDOL requesting 9F37 and 9A
+	},
+	{
+		15, (uint8_t[]){ 0x80, 0xA8, 0x00, 0x00, 0x09, 0x83, 0x07, 0x11, 0x22, 0x33, 0x44, 0x26, 0x02, 0x14, 0x00 }, // GPO
+		10, (uint8_t[]){ 0x80, 0x06, 0x18, 0x00, 0x08, 0x01, 0x01, 0x00, 0x90, 0x00 }, // GPO response format 1
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, // READ RECORD 1,1
+		34, (uint8_t[]){ 0x70, 0x1E, 0x5F, 0x24, 0x03, 0x25, 0x12, 0x31, 0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0x8C, 0x08, 0x9F, 0x02, 0x06, 0x9F, 0x37, 0x04, 0x9A, 0x03, 0x8D, 0x02, 0x8A, 0x02, 0x90, 0x00 }, // AEF with CDOL1 requesting 9F37 and 9A
+	},
+	{
+		19, (uint8_t[]){ 0x80, 0xAE, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x01, 0x23, 0x45, 0x11, 0x22, 0x33, 0x44, 0x26, 0x02, 0x14, 0x00 }, // GENAC1 requesting AAC
+		15, (uint8_t[]){ 0x80, 0x0B, 0x00, 0x00, 0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x90, 0x00 }, // GENAC response format 1
+	},
+	{ 0 }
+};
+
+static const uint8_t test_tpdu_c_apdu[] = { 0x00, 0xA4, 0x04, 0x00, 0x07, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x00 };
+static const struct xpdu_t test_tpdu[] = {
+	{
+		5, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x07 }, // SELECT
+		1, (uint8_t[]){ 0xA4 }, // Procedure byte
+	},
+	{
+		7, (uint8_t[]){ 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 }, // A0000000031010
+		2, (uint8_t[]){ 0x61, 0x04 }, // 4 bytes available
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xC0, 0x00, 0x00, 0x04 }, // GET RESPONSE
+		7, (uint8_t[]){ 0xC0, 0x6F, 0x02, 0xA5, 0x00, 0x90, 0x00 }, // FCI
+	},
+	{ 0 }
+};
+
+// ATR indicating protocol T=1
+static const uint8_t test_atr_t1[] = { 0x3B, 0x80, 0x81, 0x31, 0x10, 0x45, 0x65 };
+
+static const uint8_t test_t1_c_apdu[] = { 0x00, 0xB2, 0x01, 0x0C, 0x00 };
+static const struct xpdu_t test_t1[] = {
+	{
+		5, (uint8_t[]){ 0x00, 0xC1, 0x01, 0xFE, 0x3E }, // S(IFS request)
+		5, (uint8_t[]){ 0x00, 0xE1, 0x01, 0xFE, 0x1E }, // S(IFS response)
+	},
+	{
+		9, (uint8_t[]){ 0x00, 0x00, 0x05, 0x00, 0xB2, 0x01, 0x0C, 0x00, 0xBA }, // I(0,0) READ RECORD 1,1
+		15, (uint8_t[]){ 0x00, 0x00, 0x0B, 0x70, 0x07, 0x5A, 0x05, 0x47, 0x61, 0x73, 0x90, 0x01, 0x90, 0x00, 0x77 }, // I(0,0) AEF
+	},
+	{ 0 }
+};
+
+struct async_result_t {
+	bool done;
+	int r;
+};
+
+static void async_complete(void* complete_ctx, int r)
+{
+	struct async_result_t* result = complete_ctx;
+	result->done = true;
+	result->r = r;
+}
+
+static double now_s(void)
+{
+	struct timespec t;
+
+#if defined(HAVE_TIMESPEC_GET)
+	timespec_get(&t, TIME_UTC);
+#elif defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+
+	return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+static int prepare_ctx(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl)
+{
+	int r;
+
+	r = emv_ctx_init(ctx, ttl);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_config_app_create(ctx, (uint8_t[]){ 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 }, 7, EMV_ASI_PARTIAL_MATCH, NULL, NULL); // Visa
+	if (r) {
+		fprintf(stderr, "emv_config_app_create() failed; r=%d\n", r);
+		return 1;
+	}
+
+	return 0;
+}
+
+static unsigned int app_list_count(const struct emv_app_list_t* app_list)
+{
+	unsigned int count = 0;
+
+	for (const struct emv_app_t* app = app_list->front; app != NULL; app = app->next) {
+		++count;
+	}
+
+	return count;
+}
+
+static int prepare_txn_ctx(
+	struct emv_ctx_t* ctx,
+	struct emv_ttl_t* ttl,
+	const uint8_t* txn_date,
+	const uint8_t* txn_time,
+	const uint8_t* un
+)
+{
+	int r;
+
+	r = prepare_ctx(ctx, ttl);
+	if (r) {
+		return r;
+	}
+
+	r = 0;
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F09_APPLICATION_VERSION_NUMBER_TERMINAL, 2, (uint8_t[]){ 0x00, 0x8C }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F1A_TERMINAL_COUNTRY_CODE, 2, (uint8_t[]){ 0x05, 0x28 }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F1B_TERMINAL_FLOOR_LIMIT, 4, (uint8_t[]){ 0x00, 0x00, 0x27, 0x10 }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F33_TERMINAL_CAPABILITIES, 3, (uint8_t[]){ 0x60, 0xF0, 0xC8 }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F35_TERMINAL_TYPE, 1, (uint8_t[]){ 0x22 }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F40_ADDITIONAL_TERMINAL_CAPABILITIES, 5, (uint8_t[]){ 0xFA, 0x00, 0xF0, 0xA0, 0x01 }, 0);
+	r |= emv_tlv_list_push(&ctx->config.data, EMV_TAG_9F49_DDOL, 3, (uint8_t[]){ 0x9F, 0x37, 0x04 }, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_9C_TRANSACTION_TYPE, 1, (uint8_t[]){ 0x00 }, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_9A_TRANSACTION_DATE, 3, txn_date, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_9F21_TRANSACTION_TIME, 3, txn_time, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_5F2A_TRANSACTION_CURRENCY_CODE, 2, (uint8_t[]){ 0x09, 0x78 }, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 6, (uint8_t[]){ 0x00, 0x00, 0x00, 0x01, 0x23, 0x45 }, 0);
+	r |= emv_tlv_list_push(&ctx->params, EMV_TAG_81_AMOUNT_AUTHORISED_BINARY, 4, (uint8_t[]){ 0x00, 0x00, 0x30, 0x39 }, 0);
+	if (un) {
+		// Fixed Unpredictable Number for emulated card
+		r |= emv_tlv_list_push(&ctx->params, EMV_TAG_9F37_UNPREDICTABLE_NUMBER, 4, un, 0);
+	}
+	if (r) {
+		fprintf(stderr, "emv_tlv_list_push() failed; r=%d\n", r);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int run_txn(struct emv_ctx_t* ctx)
+{
+	int r;
+	struct emv_app_list_t app_list = EMV_APP_LIST_INIT;
+
+	r = emv_build_candidate_list(ctx, &app_list);
+	if (r) {
+		fprintf(stderr, "emv_build_candidate_list() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_select_application(ctx, &app_list, 0);
+	if (r) {
+		fprintf(stderr, "emv_select_application() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_initiate_application_processing(ctx, EMV_POS_ENTRY_MODE_ICC_WITH_CVV);
+	if (r) {
+		fprintf(stderr, "emv_initiate_application_processing() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_read_application_data(ctx);
+	if (r) {
+		fprintf(stderr, "emv_read_application_data() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_offline_data_authentication(ctx);
+	if (r) {
+		fprintf(stderr, "emv_offline_data_authentication() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_processing_restrictions(ctx);
+	if (r) {
+		fprintf(stderr, "emv_processing_restrictions() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_terminal_risk_management(ctx, NULL, 0);
+	if (r) {
+		fprintf(stderr, "emv_terminal_risk_management() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_card_action_analysis(ctx);
+	if (r) {
+		fprintf(stderr, "emv_card_action_analysis() failed; r=%d\n", r);
+		goto exit;
+	}
+
+exit:
+	emv_app_list_clear(&app_list);
+	return r;
+}
+
+int main(void)
+{
+	int r;
+	struct emv_cardreader_emul_ctx_t emul_ctx;
+	struct emv_ttl_t ttl;
+	struct emv_ctx_t emv;
+	struct emv_app_list_t app_list = EMV_APP_LIST_INIT;
+	struct emv_transcript_recorder_t recorder;
+	struct emv_transcript_replayer_t replayer;
+	uint8_t* transcript = NULL;
+	size_t transcript_len;
+	uint8_t r_apdu[EMV_RAPDU_MAX];
+	size_t r_apdu_len;
+	uint16_t sw1sw2;
+
+	memset(&recorder, 0, sizeof(recorder));
+	memset(&ttl, 0, sizeof(ttl));
+	ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+	ttl.cardreader.ctx = &emul_ctx;
+	ttl.cardreader.trx = &emv_cardreader_emul;
+
+	r = prepare_ctx(&emv, &ttl);
+	if (r) {
+		goto exit;
+	}
+
+	printf("\nTest 1: Record candidate list processing...\n");
+	r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, test_atr, sizeof(test_atr));
+	if (r) {
+		fprintf(stderr, "emv_transcript_recorder_init() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (ttl.cardreader.ctx != &recorder || ttl.cardreader.submit) {
+		fprintf(stderr, "Card reader not wrapped by recorder\n");
+		r = 1;
+		goto exit;
+	}
+	emul_ctx.xpdu_list = test_pse;
+	emul_ctx.xpdu_current = NULL;
+	r = emv_build_candidate_list(&emv, &app_list);
+	if (r) {
+		fprintf(stderr, "emv_build_candidate_list() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (recorder.exchange_count != 3 || recorder.incomplete) {
+		fprintf(stderr, "Unexpected number of recorded exchanges %u\n", recorder.exchange_count);
+		r = 1;
+		goto exit;
+	}
+	print_buf("transcript", recorder.data, recorder.data_len);
+
+	// Keep transcript after recorder is cleared
+	transcript_len = recorder.data_len;
+	transcript = malloc(transcript_len);
+	if (!transcript) {
+		r = 1;
+		goto exit;
+	}
+	memcpy(transcript, recorder.data, transcript_len);
+	emv_transcript_recorder_clear(&recorder);
+	if (ttl.cardreader.ctx != &emul_ctx || ttl.cardreader.trx != &emv_cardreader_emul) {
+		fprintf(stderr, "Card reader not restored by recorder\n");
+		r = 1;
+		goto exit;
+	}
+	emv_ctx_clear(&emv);
+	printf("Success\n");
+
+	printf("\nTest 2: Replay candidate list processing...\n");
+	r = emv_transcript_replayer_init(&replayer, transcript, transcript_len, &ttl.cardreader);
+	if (r) {
+		fprintf(stderr, "emv_transcript_replayer_init() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (replayer.exchange_count != 3 ||
+		replayer.atr_len != sizeof(test_atr) ||
+		memcmp(replayer.atr, test_atr, sizeof(test_atr)) != 0 ||
+		ttl.cardreader.mode != EMV_CARDREADER_MODE_APDU
+	) {
+		fprintf(stderr, "Incorrect transcript header\n");
+		r = 1;
+		goto exit;
+	}
+	r = prepare_ctx(&emv, &ttl);
+	if (r) {
+		goto exit;
+	}
+	emv_app_list_clear(&app_list);
+	r = emv_build_candidate_list(&emv, &app_list);
+	if (r) {
+		fprintf(stderr, "emv_build_candidate_list() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (app_list_count(&app_list) != 2) {
+		fprintf(stderr, "Incorrect candidate list\n");
+		r = 1;
+		goto exit;
+	}
+	if (!emv_transcript_replayer_is_complete(&replayer)) {
+		fprintf(stderr, "Incomplete replay\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 3: Repeated replay of candidate list processing...\n");
+	{
+		const unsigned int iterations = 1000;
+		double start = now_s();
+
+		for (unsigned int i = 0; i < iterations; ++i) {
+			emv_transcript_replayer_rewind(&replayer);
+			emv_app_list_clear(&app_list);
+			r = emv_build_candidate_list(&emv, &app_list);
+			if (r || !emv_transcript_replayer_is_complete(&replayer)) {
+				fprintf(stderr, "Replay %u failed; r=%d\n", i, r);
+				r = 1;
+				goto exit;
+			}
+		}
+		printf("%u replays in %.3f s\n", iterations, now_s() - start);
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Replay with different C-APDU...\n");
+	emv_transcript_replayer_rewind(&replayer);
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_ttl_trx(&ttl, test_tpdu_c_apdu, sizeof(test_tpdu_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+	if (r >= 0) {
+		fprintf(stderr, "Unexpected emv_ttl_trx() result; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Invalid transcripts...\n");
+	r = emv_transcript_replayer_init(&replayer, transcript, transcript_len - 1, &ttl.cardreader);
+	if (r <= 0) {
+		fprintf(stderr, "Truncated transcript not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	transcript[0] ^= 0xFF;
+	r = emv_transcript_replayer_init(&replayer, transcript, transcript_len, &ttl.cardreader);
+	if (r <= 0) {
+		fprintf(stderr, "Invalid transcript magic not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 6: Record asynchronous exchanges in TPDU mode...\n");
+	{
+		struct emv_ttl_trx_state_t state;
+		struct async_result_t result = { 0 };
+
+		memset(&ttl, 0, sizeof(ttl));
+		memset(&emul_ctx, 0, sizeof(emul_ctx));
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		ttl.cardreader.submit = &emv_cardreader_emul_submit;
+		emul_ctx.xpdu_list = test_tpdu;
+
+		r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, NULL, 0);
+		if (r) {
+			fprintf(stderr, "emv_transcript_recorder_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx_async(
+			&ttl,
+			&state,
+			test_tpdu_c_apdu,
+			sizeof(test_tpdu_c_apdu),
+			r_apdu,
+			&r_apdu_len,
+			&sw1sw2,
+			&async_complete,
+			&result
+		);
+		if (r) {
+			fprintf(stderr, "emv_ttl_trx_async() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		while (emv_cardreader_emul_poll(&emul_ctx));
+		if (!result.done || result.r || sw1sw2 != 0x9000) {
+			fprintf(stderr, "Asynchronous exchange failed; r=%d\n", result.r);
+			r = 1;
+			goto exit;
+		}
+		if (recorder.exchange_count != 3 || recorder.incomplete) {
+			fprintf(stderr, "Unexpected number of recorded exchanges %u\n", recorder.exchange_count);
+			r = 1;
+			goto exit;
+		}
+
+		// Replay recorded TPDU exchanges synchronously
+		r = emv_transcript_replayer_init(&replayer, recorder.data, recorder.data_len, &ttl.cardreader);
+		if (r) {
+			fprintf(stderr, "emv_transcript_replayer_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU || replayer.atr_len) {
+			fprintf(stderr, "Incorrect transcript header\n");
+			r = 1;
+			goto exit;
+		}
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx(&ttl, test_tpdu_c_apdu, sizeof(test_tpdu_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000 || r_apdu_len != 6) {
+			fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (!emv_transcript_replayer_is_complete(&replayer)) {
+			fprintf(stderr, "Incomplete replay\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	printf("\nTest 7: Record and replay protocol T=1 selection...\n");
+	{
+		struct iso7816_atr_info_t atr_info;
+
+		emv_transcript_recorder_clear(&recorder);
+		emv_ttl_init(&ttl);
+		memset(&emul_ctx, 0, sizeof(emul_ctx));
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		emul_ctx.xpdu_list = test_t1;
+
+		r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, test_atr_t1, sizeof(test_atr_t1));
+		if (r) {
+			fprintf(stderr, "emv_transcript_recorder_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = iso7816_atr_parse(test_atr_t1, sizeof(test_atr_t1), &atr_info);
+		if (r) {
+			fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = emv_ttl_select_protocol(&ttl, &atr_info);
+		if (r || ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1) {
+			fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx(&ttl, test_t1_c_apdu, sizeof(test_t1_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000 || r_apdu_len != 11) {
+			fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (recorder.exchange_count != 2 || recorder.incomplete) {
+			fprintf(stderr, "Unexpected number of recorded exchanges %u\n", recorder.exchange_count);
+			r = 1;
+			goto exit;
+		}
+
+		free(transcript);
+		transcript_len = recorder.data_len;
+		transcript = malloc(transcript_len);
+		if (!transcript) {
+			r = 1;
+			goto exit;
+		}
+		memcpy(transcript, recorder.data, transcript_len);
+		emv_transcript_recorder_clear(&recorder);
+		if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1 ||
+			ttl.cardreader.ctx != &emul_ctx
+		) {
+			fprintf(stderr, "Selected protocol not retained by recorder\n");
+			r = 1;
+			goto exit;
+		}
+
+		// Replay protocol selection using recorded ATR
+		emv_ttl_init(&ttl);
+		r = emv_transcript_replayer_init(&replayer, transcript, transcript_len, &ttl.cardreader);
+		if (r) {
+			fprintf(stderr, "emv_transcript_replayer_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU) {
+			fprintf(stderr, "Incorrect transcript header\n");
+			r = 1;
+			goto exit;
+		}
+		r = iso7816_atr_parse(replayer.atr, replayer.atr_len, &atr_info);
+		if (r) {
+			fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = emv_ttl_select_protocol(&ttl, &atr_info);
+		if (r || ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1) {
+			fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx(&ttl, test_t1_c_apdu, sizeof(test_t1_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000 || r_apdu_len != 11) {
+			fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (!emv_transcript_replayer_is_complete(&replayer)) {
+			fprintf(stderr, "Incomplete replay\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	printf("\nTest 8: Record and replay after protocol T=1 selection...\n");
+	{
+		struct iso7816_atr_info_t atr_info;
+		struct emv_ttl_t1_t t1;
+
+		emv_ttl_init(&ttl);
+		memset(&emul_ctx, 0, sizeof(emul_ctx));
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		emul_ctx.xpdu_list = test_t1;
+
+		r = iso7816_atr_parse(test_atr_t1, sizeof(test_atr_t1), &atr_info);
+		if (r) {
+			fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = emv_ttl_select_protocol(&ttl, &atr_info);
+		if (r || ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1) {
+			fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		t1 = ttl.t1;
+
+		r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, test_atr_t1, sizeof(test_atr_t1));
+		if (r) {
+			fprintf(stderr, "emv_transcript_recorder_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx(&ttl, test_t1_c_apdu, sizeof(test_t1_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000 || r_apdu_len != 11) {
+			fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+
+		// Replay into TTL with the same protocol T=1 state
+		emv_ttl_init(&ttl);
+		ttl.t1 = t1;
+		r = emv_transcript_replayer_init(&replayer, recorder.data, recorder.data_len, &ttl.cardreader);
+		if (r) {
+			fprintf(stderr, "emv_transcript_replayer_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1 || replayer.exchange_count != 1) {
+			fprintf(stderr, "Incorrect transcript header\n");
+			r = 1;
+			goto exit;
+		}
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx(&ttl, test_t1_c_apdu, sizeof(test_t1_c_apdu), r_apdu, &r_apdu_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000 || r_apdu_len != 11) {
+			fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (!emv_transcript_replayer_is_complete(&replayer)) {
+			fprintf(stderr, "Incomplete replay\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	printf("\nTest 9: Record and replay GPO and GENAC with terminal data...\n");
+	{
+		static const uint8_t replay_date[] = { 0x26, 0x10, 0x16 };
+		static const uint8_t replay_time[] = { 0x08, 0x30, 0x00 };
+		const struct emv_tlv_t* un;
+
+		emv_transcript_recorder_clear(&recorder);
+		emv_ctx_clear(&emv);
+		emv_ttl_init(&ttl);
+		memset(&emul_ctx, 0, sizeof(emul_ctx));
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		emul_ctx.xpdu_list = test_txn;
+
+		r = prepare_txn_ctx(&emv, &ttl, test_txn_date, test_txn_time, test_txn_un);
+		if (r) {
+			goto exit;
+		}
+		r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, test_atr, sizeof(test_atr));
+		if (r) {
+			fprintf(stderr, "emv_transcript_recorder_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = run_txn(&emv);
+		if (r) {
+			r = 1;
+			goto exit;
+		}
+		r = emv_transcript_recorder_add_terminal_data(&recorder, &emv);
+		if (r) {
+			fprintf(stderr, "emv_transcript_recorder_add_terminal_data() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (recorder.exchange_count != 7 || recorder.incomplete) {
+			fprintf(stderr, "Unexpected number of recorded exchanges %u\n", recorder.exchange_count);
+			r = 1;
+			goto exit;
+		}
+
+		free(transcript);
+		transcript_len = recorder.data_len;
+		transcript = malloc(transcript_len);
+		if (!transcript) {
+			r = 1;
+			goto exit;
+		}
+		memcpy(transcript, recorder.data, transcript_len);
+		emv_transcript_recorder_clear(&recorder);
+		emv_ctx_clear(&emv);
+
+		// Replay with different transaction date and time and without
+		// recorded terminal data
+		emv_ttl_init(&ttl);
+		r = emv_transcript_replayer_init(&replayer, transcript, transcript_len, &ttl.cardreader);
+		if (r) {
+			fprintf(stderr, "emv_transcript_replayer_init() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		if (replayer.exchange_count != 7) {
+			fprintf(stderr, "Incorrect transcript exchange count %u\n", replayer.exchange_count);
+			r = 1;
+			goto exit;
+		}
+		r = prepare_txn_ctx(&emv, &ttl, replay_date, replay_time, NULL);
+		if (r) {
+			goto exit;
+		}
+		r = run_txn(&emv);
+		if (r == 0 || emv_transcript_replayer_is_complete(&replayer)) {
+			fprintf(stderr, "Replay without recorded terminal data unexpectedly succeeded\n");
+			r = 1;
+			goto exit;
+		}
+		emv_ctx_clear(&emv);
+
+		// Replay with recorded terminal data
+		emv_transcript_replayer_rewind(&replayer);
+		r = prepare_txn_ctx(&emv, &ttl, replay_date, replay_time, NULL);
+		if (r) {
+			goto exit;
+		}
+		r = emv_transcript_replayer_load_terminal_data(&replayer, &emv);
+		if (r) {
+			fprintf(stderr, "emv_transcript_replayer_load_terminal_data() failed; r=%d\n", r);
+			r = 1;
+			goto exit;
+		}
+		r = run_txn(&emv);
+		if (r) {
+			r = 1;
+			goto exit;
+		}
+		if (!emv_transcript_replayer_is_complete(&replayer)) {
+			fprintf(stderr, "Incomplete replay\n");
+			r = 1;
+			goto exit;
+		}
+		un = emv_tlv_list_find_const(&emv.terminal, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+		if (!un || un->length != sizeof(test_txn_un) ||
+			memcmp(un->value, test_txn_un, sizeof(test_txn_un)) != 0
+		) {
+			fprintf(stderr, "Recorded Unpredictable Number not used\n");
+			r = 1;
+			goto exit;
+		}
+		if (!emv_tlv_list_find_const(&emv.icc, EMV_TAG_9F26_APPLICATION_CRYPTOGRAM)) {
+			fprintf(stderr, "Application Cryptogram not found\n");
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	r = 0;
+	goto exit;
+
+exit:
+	emv_app_list_clear(&app_list);
+	emv_transcript_recorder_clear(&recorder);
+	emv_ctx_clear(&emv);
+	if (transcript) {
+		free(transcript);
+	}
+
+	return r;
+}
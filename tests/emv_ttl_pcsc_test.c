@@ -251,6 +251,7 @@ int main(void)
 
 	struct emv_ttl_t ttl;
 	struct emv_cardreader_emul_ctx_t emul_ctx;
+	memset(&ttl, 0, sizeof(ttl));
 	ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
 	ttl.cardreader.ctx = &emul_ctx;
 	ttl.cardreader.trx = &emv_cardreader_emul;
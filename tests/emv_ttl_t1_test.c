@@ -0,0 +1,493 @@
+/**
+ * @file emv_ttl_t1_test.c
+ * @brief Unit tests for EMV TTL protocol T=1 in TPDU mode
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_ttl.h"
+#include "emv_cardreader_emul.h"
+#include "iso7816.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// For debug output
+#include "emv_debug.h"
+#include "print_helpers.h"
+
+// ATR indicating protocol T=1 with IFSC=16 such that C-APDUs are chained
+static const uint8_t test_atr_t1[] = { 0x3B, 0x80, 0x81, 0x31, 0x10, 0x45, 0x65 };
+
+// ATR indicating protocol T=0
+static const uint8_t test_atr_t0[] = { 0x3B, 0x60, 0x00, 0x00 };
+
+// TPDU exchanges for IFSD negotiation after ATR
+// See EMV Contact Interface Specification v1.0, 9.2.4.3
+static const struct xpdu_t test_t1_ifsd[] = {
+	{
+		5, (uint8_t[]){ // S(IFS request)
+			0x00, 0xC1, 0x01, 0xFE, 0x3E,
+		},
+		5, (uint8_t[]){ // S(IFS response)
+			0x00, 0xE1, 0x01, 0xFE, 0x1E,
+		},
+	},
+	{ 0 }
+};
+
+// TPDU exchanges for case 4 using chaining in both directions and a waiting
+// time extension requested by the ICC
+// See ISO 7816-3:2006, Annex A
+static const struct xpdu_t test_t1_case_4_chaining[] = {
+	{
+		20, (uint8_t[]){ // I(0,1)
+			0x00, 0x20, 0x10, 0x00, 0xA4, 0x04, 0x00, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53,
+			0x2E, 0x44, 0x44, 0xBE,
+		},
+		4, (uint8_t[]){ // R(1)
+			0x00, 0x90, 0x00, 0x90,
+		},
+	},
+	{
+		8, (uint8_t[]){ // I(1,0)
+			0x00, 0x40, 0x04, 0x46, 0x30, 0x31, 0x00, 0x03,
+		},
+		5, (uint8_t[]){ // S(WTX request)
+			0x00, 0xC3, 0x01, 0x01, 0xC3,
+		},
+	},
+	{
+		5, (uint8_t[]){ // S(WTX response)
+			0x00, 0xE3, 0x01, 0x01, 0xE3,
+		},
+		20, (uint8_t[]){ // I(0,1)
+			0x00, 0x20, 0x10, 0x6F, 0x1A, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E,
+			0x44, 0x44, 0x46, 0xA9,
+		},
+	},
+	{
+		4, (uint8_t[]){ // R(1)
+			0x00, 0x90, 0x00, 0x90,
+		},
+		18, (uint8_t[]){ // I(1,0)
+			0x00, 0x40, 0x0E, 0x30, 0x31, 0xA5, 0x08, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x02, 0x65, 0x6E, 0x90,
+			0x00, 0x81,
+		},
+	},
+	{ 0 }
+};
+static const uint8_t test_t1_case_4_chaining_data[] = {
+	0x6F, 0x1A, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46,
+	0x30, 0x31, 0xA5, 0x08, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x02, 0x65, 0x6E,
+};
+
+// TPDU exchanges for case 2 with an invalid ICC block that is retransmitted
+// See ISO 7816-3:2006, 11.6.3.2, rule 7.1
+static const struct xpdu_t test_t1_case_2_retransmit[] = {
+	{
+		9, (uint8_t[]){ // I(0,0)
+			0x00, 0x00, 0x05, 0x00, 0xB2, 0x01, 0x0C, 0x00, 0xBA,
+		},
+		15, (uint8_t[]){ // I(0,0) with invalid LRC
+			0x00, 0x00, 0x0B, 0x70, 0x07, 0x5A, 0x05, 0x47, 0x61, 0x73, 0x90, 0x01, 0x90, 0x00, 0x88,
+		},
+	},
+	{
+		4, (uint8_t[]){ // R(0) with EDC error
+			0x00, 0x81, 0x00, 0x81,
+		},
+		15, (uint8_t[]){ // I(0,0)
+			0x00, 0x00, 0x0B, 0x70, 0x07, 0x5A, 0x05, 0x47, 0x61, 0x73, 0x90, 0x01, 0x90, 0x00, 0x77,
+		},
+	},
+	{ 0 }
+};
+static const uint8_t test_t1_case_2_retransmit_data[] = {
+	0x70, 0x07, 0x5A, 0x05, 0x47, 0x61, 0x73, 0x90, 0x01,
+};
+
+// TPDU exchanges for case 1 with IFSC update requested by the ICC
+// See ISO 7816-3:2006, 11.6.2.4
+static const struct xpdu_t test_t1_case_1_ifsc[] = {
+	{
+		8, (uint8_t[]){ // I(1,0)
+			0x00, 0x40, 0x04, 0x12, 0x34, 0x56, 0x78, 0x4C,
+		},
+		5, (uint8_t[]){ // S(IFS request)
+			0x00, 0xC1, 0x01, 0x20, 0xE0,
+		},
+	},
+	{
+		5, (uint8_t[]){ // S(IFS response)
+			0x00, 0xE1, 0x01, 0x20, 0xC0,
+		},
+		6, (uint8_t[]){ // I(1,0)
+			0x00, 0x40, 0x02, 0x90, 0x00, 0xD2,
+		},
+	},
+	{ 0 }
+};
+
+// TPDU exchanges for case 1 with an unsupported S-block from the ICC
+// See EMV Contact Interface Specification v1.0, 9.2.4.2.3
+static const struct xpdu_t test_t1_case_1_abort[] = {
+	{
+		8, (uint8_t[]){ // I(0,0)
+			0x00, 0x00, 0x04, 0x12, 0x34, 0x56, 0x78, 0x0C,
+		},
+		14, (uint8_t[]){ // S(ABORT request)
+			0x00, 0xC2, 0x0A, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0xC3,
+		},
+	},
+	{ 0 }
+};
+
+// TPDU exchanges for IFSD negotiation followed by asynchronous case 2
+static const struct xpdu_t test_t1_async[] = {
+	{
+		5, (uint8_t[]){ // S(IFS request)
+			0x00, 0xC1, 0x01, 0xFE, 0x3E,
+		},
+		5, (uint8_t[]){ // S(IFS response)
+			0x00, 0xE1, 0x01, 0xFE, 0x1E,
+		},
+	},
+	{
+		9, (uint8_t[]){ // I(0,0)
+			0x00, 0x00, 0x05, 0x80, 0xCA, 0x9F, 0x36, 0x00, 0xE6,
+		},
+		11, (uint8_t[]){ // I(0,0)
+			0x00, 0x00, 0x07, 0x9F, 0x36, 0x02, 0x00, 0x01, 0x90, 0x00, 0x3D,
+		},
+	},
+	{ 0 }
+};
+static const uint8_t test_t1_async_data[] = { 0x9F, 0x36, 0x02, 0x00, 0x01 };
+
+struct async_result_t {
+	bool done;
+	int r;
+};
+
+static void async_complete(void* ctx, int r)
+{
+	struct async_result_t* result = ctx;
+	result->done = true;
+	result->r = r;
+}
+
+int main(void)
+{
+	int r;
+	struct iso7816_atr_info_t atr_info;
+	struct emv_ttl_t ttl;
+	struct emv_cardreader_emul_ctx_t emul_ctx;
+	uint8_t r_apdu[EMV_RAPDU_MAX];
+	size_t r_apdu_len;
+	uint8_t data[EMV_RAPDU_DATA_MAX];
+	size_t data_len;
+	uint16_t sw1sw2;
+
+	memset(&ttl, 0, sizeof(ttl));
+	ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+	ttl.cardreader.ctx = &emul_ctx;
+	ttl.cardreader.trx = &emv_cardreader_emul;
+
+	// Enable debug output
+	r = emv_debug_init(EMV_DEBUG_SOURCE_ALL, EMV_DEBUG_LEVEL_ALL, &print_emv_debug);
+	if (r) {
+		fprintf(stderr, "emv_debug_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Test protocol T=0 selection
+	printf("\nTesting protocol T=0 selection...\n");
+	r = iso7816_atr_parse(test_atr_t0, sizeof(test_atr_t0), &atr_info);
+	if (r) {
+		fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_ttl_select_protocol(&ttl, &atr_info);
+	if (r) {
+		fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+		return 1;
+	}
+	if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU) {
+		fprintf(stderr, "Unexpected card reader mode %d\n", ttl.cardreader.mode);
+		return 1;
+	}
+	printf("Success\n");
+
+	// Test protocol T=1 selection and IFSD negotiation
+	printf("\nTesting protocol T=1 selection and IFSD negotiation...\n");
+	emul_ctx.xpdu_list = test_t1_ifsd;
+	emul_ctx.xpdu_current = NULL;
+	r = iso7816_atr_parse(test_atr_t1, sizeof(test_atr_t1), &atr_info);
+	if (r) {
+		fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_ttl_select_protocol(&ttl, &atr_info);
+	if (r) {
+		fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+		return 1;
+	}
+	if (ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1) {
+		fprintf(stderr, "Unexpected card reader mode %d\n", ttl.cardreader.mode);
+		return 1;
+	}
+	if (ttl.t1.ifsc != 16 || ttl.t1.ifsd != EMV_TTL_T1_IFSD) {
+		fprintf(stderr, "Unexpected IFSC=%u or IFSD=%u\n", ttl.t1.ifsc, ttl.t1.ifsd);
+		return 1;
+	}
+	if (emul_ctx.xpdu_current->c_xpdu_len) {
+		fprintf(stderr, "Incomplete exchanges\n");
+		return 1;
+	}
+	printf("Success\n");
+
+	// Test APDU case 4 with chaining and waiting time extension
+	printf("\nTesting APDU case 4 (T=1) with chaining and waiting time extension...\n");
+	emul_ctx.xpdu_list = test_t1_case_4_chaining;
+	emul_ctx.xpdu_current = NULL;
+	data_len = sizeof(data);
+	r = emv_ttl_select_by_df_name(
+		&ttl,
+		"1PAY.SYS.DDF01",
+		14,
+		data,
+		&data_len,
+		&sw1sw2
+	);
+	if (r) {
+		fprintf(stderr, "emv_ttl_select_by_df_name() failed; r=%d\n", r);
+		return 1;
+	}
+	if (data_len != sizeof(test_t1_case_4_chaining_data) ||
+		memcmp(data, test_t1_case_4_chaining_data, data_len) != 0
+	) {
+		fprintf(stderr, "emv_ttl_select_by_df_name() failed; incorrect response data\n");
+		print_buf("data", data, data_len);
+		return 1;
+	}
+	if (sw1sw2 != 0x9000) {
+		fprintf(stderr, "Unexpected SW1-SW2 %04X\n", sw1sw2);
+		return 1;
+	}
+	if (emul_ctx.xpdu_current->c_xpdu_len) {
+		fprintf(stderr, "Incomplete exchanges\n");
+		return 1;
+	}
+	printf("Success\n");
+
+	// Test APDU case 2 with retransmission of invalid block
+	printf("\nTesting APDU case 2 (T=1) with retransmission of invalid block...\n");
+	emul_ctx.xpdu_list = test_t1_case_2_retransmit;
+	emul_ctx.xpdu_current = NULL;
+	data_len = sizeof(data);
+	r = emv_ttl_read_record(
+		&ttl,
+		1,
+		1,
+		data,
+		&data_len,
+		&sw1sw2
+	);
+	if (r) {
+		fprintf(stderr, "emv_ttl_read_record() failed; r=%d\n", r);
+		return 1;
+	}
+	if (data_len != sizeof(test_t1_case_2_retransmit_data) ||
+		memcmp(data, test_t1_case_2_retransmit_data, data_len) != 0
+	) {
+		fprintf(stderr, "emv_ttl_read_record() failed; incorrect response data\n");
+		print_buf("data", data, data_len);
+		return 1;
+	}
+	if (sw1sw2 != 0x9000) {
+		fprintf(stderr, "Unexpected SW1-SW2 %04X\n", sw1sw2);
+		return 1;
+	}
+	printf("Success\n");
+
+	// Test APDU case 1 with IFSC update
+	printf("\nTesting APDU case 1 (T=1) with IFSC update...\n");
+	emul_ctx.xpdu_list = test_t1_case_1_ifsc;
+	emul_ctx.xpdu_current = NULL;
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_ttl_trx(
+		&ttl,
+		(uint8_t[]){ 0x12, 0x34, 0x56, 0x78 },
+		4,
+		r_apdu,
+		&r_apdu_len,
+		&sw1sw2
+	);
+	if (r) {
+		fprintf(stderr, "emv_ttl_trx() failed; r=%d\n", r);
+		return 1;
+	}
+	if (r_apdu_len != 2 || sw1sw2 != 0x9000) {
+		fprintf(stderr, "Unexpected R-APDU length %zu or SW1-SW2 %04X\n", r_apdu_len, sw1sw2);
+		return 1;
+	}
+	if (ttl.t1.ifsc != 0x20) {
+		fprintf(stderr, "Unexpected IFSC=%u\n", ttl.t1.ifsc);
+		return 1;
+	}
+	printf("Success\n");
+
+	// Test unsupported S-block that does not fit the R-APDU buffer
+	printf("\nTesting APDU case 1 (T=1) with unsupported S-block...\n");
+	emul_ctx.xpdu_list = test_t1_case_1_abort;
+	emul_ctx.xpdu_current = NULL;
+	memset(r_apdu, 0xFF, sizeof(r_apdu));
+	r_apdu_len = 4;
+	r = emv_ttl_trx(
+		&ttl,
+		(uint8_t[]){ 0x12, 0x34, 0x56, 0x78 },
+		4,
+		r_apdu,
+		&r_apdu_len,
+		&sw1sw2
+	);
+	if (r != -4) {
+		fprintf(stderr, "emv_ttl_trx() did not fail as expected; r=%d\n", r);
+		return 1;
+	}
+	for (size_t i = 4; i < sizeof(r_apdu); ++i) {
+		if (r_apdu[i] != 0xFF) {
+			fprintf(stderr, "R-APDU buffer overflow at offset %zu\n", i);
+			return 1;
+		}
+	}
+	printf("Success\n");
+
+	// Test protocol selection upon card activation
+	printf("\nTesting protocol T=1 selection upon card activation...\n");
+	{
+		struct emv_ctx_t emv;
+
+		r = emv_ctx_init(&emv, NULL);
+		if (r) {
+			fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+			return 1;
+		}
+
+		emv_ttl_init(&ttl);
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		emul_ctx.xpdu_list = test_t1_ifsd;
+		emul_ctx.xpdu_current = NULL;
+		r = emv_card_activated_atr(&emv, &ttl, test_atr_t1, sizeof(test_atr_t1));
+		if (r) {
+			fprintf(stderr, "emv_card_activated_atr() failed; r=%d\n", r);
+			emv_ctx_clear(&emv);
+			return 1;
+		}
+		if (emv.ttl != &ttl ||
+			ttl.cardreader.mode != EMV_CARDREADER_MODE_TPDU_T1 ||
+			ttl.t1.ifsc != 16 ||
+			emul_ctx.xpdu_current->c_xpdu_len
+		) {
+			fprintf(stderr, "Protocol T=1 not selected upon card activation\n");
+			emv_ctx_clear(&emv);
+			return 1;
+		}
+
+		// Statistics must not outlive the EMV processing context
+		emv_ttl_set_stats(&ttl, NULL);
+		emv_ctx_clear(&emv);
+	}
+	printf("Success\n");
+
+	// Test asynchronous transceive using protocol T=1
+	printf("\nTesting asynchronous APDU case 2 (T=1)...\n");
+	{
+		struct emv_cardreader_emul_ctx_t async_emul_ctx = { .xpdu_list = test_t1_async };
+		struct emv_ttl_t async_ttl;
+		struct emv_ttl_trx_state_t state;
+		struct async_result_t result = { 0 };
+
+		memset(&async_ttl, 0, sizeof(async_ttl));
+		async_ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+		async_ttl.cardreader.ctx = &async_emul_ctx;
+		async_ttl.cardreader.trx = &emv_cardreader_emul;
+		async_ttl.cardreader.submit = &emv_cardreader_emul_submit;
+
+		r = iso7816_atr_parse(
+			(uint8_t[]){ 0x3B, 0x80, 0x81, 0x31, 0xFE, 0x45, 0x8B },
+			7,
+			&atr_info
+		);
+		if (r) {
+			fprintf(stderr, "iso7816_atr_parse() failed; r=%d\n", r);
+			return 1;
+		}
+		r = emv_ttl_select_protocol(&async_ttl, &atr_info);
+		if (r) {
+			fprintf(stderr, "emv_ttl_select_protocol() failed; r=%d\n", r);
+			return 1;
+		}
+
+		r_apdu_len = sizeof(r_apdu);
+		r = emv_ttl_trx_async(
+			&async_ttl,
+			&state,
+			(uint8_t[]){ 0x80, 0xCA, 0x9F, 0x36, 0x00 },
+			5,
+			r_apdu,
+			&r_apdu_len,
+			&sw1sw2,
+			&async_complete,
+			&result
+		);
+		if (r) {
+			fprintf(stderr, "emv_ttl_trx_async() failed; r=%d\n", r);
+			return 1;
+		}
+		while (emv_cardreader_emul_poll(&async_emul_ctx));
+
+		if (!result.done) {
+			fprintf(stderr, "Asynchronous exchange not completed\n");
+			return 1;
+		}
+		if (result.r) {
+			fprintf(stderr, "Asynchronous exchange failed; r=%d\n", result.r);
+			return 1;
+		}
+		if (r_apdu_len != sizeof(test_t1_async_data) + 2 ||
+			memcmp(r_apdu, test_t1_async_data, sizeof(test_t1_async_data)) != 0
+		) {
+			fprintf(stderr, "emv_ttl_trx_async() failed; incorrect response data\n");
+			print_buf("r_apdu", r_apdu, r_apdu_len);
+			return 1;
+		}
+		if (sw1sw2 != 0x9000) {
+			fprintf(stderr, "Unexpected SW1-SW2 %04X\n", sw1sw2);
+			return 1;
+		}
+	}
+	printf("Success\n");
+
+	return 0;
+}
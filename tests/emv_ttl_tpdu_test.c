@@ -2,7 +2,7 @@
  * @file emv_ttl_tpdu_test.c
  * @brief Unit tests for EMV TTL APDU cases in TPDU mode
  *
- * Copyright 2021, 2023-2025 Leon Lynch
+ * Copyright 2021, 2023-2026 Leon Lynch
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -22,6 +22,7 @@
 #include "emv_ttl.h"
 #include "emv_cardreader_emul.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -299,12 +300,25 @@ static const uint8_t test_tpdu_case_4_warning2_data[] = {
 	0x6F, 0x24, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0xA5, 0x12, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x08, 0x65, 0x6E, 0x65, 0x73, 0x66, 0x72, 0x64, 0x65, 0x9F, 0x11, 0x01, 0x01,
 };
 
+struct async_result_t {
+	bool done;
+	int r;
+};
+
+static void async_complete(void* ctx, int r)
+{
+	struct async_result_t* result = ctx;
+	result->done = true;
+	result->r = r;
+}
+
 int main(void)
 {
 	int r;
 
 	struct emv_ttl_t ttl;
 	struct emv_cardreader_emul_ctx_t emul_ctx;
+	memset(&ttl, 0, sizeof(ttl));
 	ttl.cardreader.mode = EMV_CARDREADER_MODE_TPDU;
 	ttl.cardreader.ctx = &emul_ctx;
 	ttl.cardreader.trx = &emv_cardreader_emul;
@@ -851,5 +865,181 @@ int main(void)
 	}
 	printf("Success\n");
 
+	// Test asynchronous transceive of multiple exchanges on the same thread
+	printf("\nTesting asynchronous APDU case 4 (TPDU mode) using two card readers...\n");
+	{
+		struct emv_cardreader_emul_ctx_t async_emul_ctx[2] = {
+			{ .xpdu_list = test_tpdu_case_4_normal },
+			{ .xpdu_list = test_tpdu_case_4_warning2 },
+		};
+		struct emv_ttl_t async_ttl[2];
+		struct emv_ttl_trx_state_t state[2];
+		struct async_result_t result[2] = { 0 };
+		uint8_t async_r_apdu[2][EMV_RAPDU_MAX];
+		size_t async_r_apdu_len[2];
+		uint16_t async_sw1sw2[2];
+		const uint8_t c_apdu[] = { 0x00, 0xA4, 0x04, 0x00, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0x00 };
+		struct emv_ttl_stats_t async_stats[2];
+		bool busy;
+
+		memset(async_ttl, 0, sizeof(async_ttl));
+		memset(async_stats, 0, sizeof(async_stats));
+		for (unsigned int i = 0; i < 2; ++i) {
+			emv_ttl_set_stats(&async_ttl[i], &async_stats[i]);
+			async_ttl[i].cardreader.mode = EMV_CARDREADER_MODE_TPDU;
+			async_ttl[i].cardreader.ctx = &async_emul_ctx[i];
+			async_ttl[i].cardreader.trx = &emv_cardreader_emul;
+			async_ttl[i].cardreader.submit = &emv_cardreader_emul_submit;
+			async_r_apdu_len[i] = sizeof(async_r_apdu[i]);
+
+			r = emv_ttl_trx_async(
+				&async_ttl[i],
+				&state[i],
+				c_apdu,
+				sizeof(c_apdu),
+				async_r_apdu[i],
+				&async_r_apdu_len[i],
+				&async_sw1sw2[i],
+				&async_complete,
+				&result[i]
+			);
+			if (r) {
+				fprintf(stderr, "emv_ttl_trx_async() failed; r=%d\n", r);
+				return 1;
+			}
+		}
+
+		// Drive both exchanges from a single event loop
+		do {
+			busy = false;
+			for (unsigned int i = 0; i < 2; ++i) {
+				busy |= emv_cardreader_emul_poll(&async_emul_ctx[i]);
+			}
+		} while (busy);
+
+		for (unsigned int i = 0; i < 2; ++i) {
+			const uint8_t* expected_data = i ? test_tpdu_case_4_warning2_data : test_tpdu_case_4_normal_data;
+			size_t expected_data_len = i ? sizeof(test_tpdu_case_4_warning2_data) : sizeof(test_tpdu_case_4_normal_data);
+			uint16_t expected_sw1sw2 = i ? 0x6286 : 0x9000;
+
+			if (!result[i].done) {
+				fprintf(stderr, "Asynchronous exchange %u not completed\n", i);
+				return 1;
+			}
+			if (result[i].r) {
+				fprintf(stderr, "Asynchronous exchange %u failed; r=%d\n", i, result[i].r);
+				return 1;
+			}
+			if (async_r_apdu_len[i] != expected_data_len + 2 ||
+				memcmp(async_r_apdu[i], expected_data, expected_data_len) != 0
+			) {
+				fprintf(stderr, "emv_ttl_trx_async() failed; incorrect response data\n");
+				print_buf("r_apdu", async_r_apdu[i], async_r_apdu_len[i]);
+				return 1;
+			}
+			if (async_sw1sw2[i] != expected_sw1sw2) {
+				fprintf(stderr, "Unexpected SW1-SW2 %04X\n", async_sw1sw2[i]);
+				return 1;
+			}
+			if (async_stats[i].cmd[EMV_TTL_CMD_SELECT].count != 1 ||
+				async_stats[i].cmd[EMV_TTL_CMD_SELECT].error_count != 0 ||
+				async_stats[i].cmd[EMV_TTL_CMD_SELECT].exchange_count < 2
+			) {
+				fprintf(stderr, "Incorrect statistics for asynchronous exchange %u\n", i);
+				return 1;
+			}
+		}
+	}
+	printf("Success\n");
+
+	// Test TTL statistics
+	printf("\nTesting TTL statistics (TPDU mode)...\n");
+	{
+		struct emv_ttl_stats_t stats;
+		const struct emv_ttl_cmd_stats_t* cmd_stats;
+		unsigned long histogram_total;
+
+		emv_ttl_stats_reset(&stats);
+		emv_ttl_set_stats(&ttl, &stats);
+
+		// READ RECORD using both '61' and '6C' procedure bytes
+		emul_ctx.xpdu_list = test_tpdu_case_2_normal_advanced;
+		emul_ctx.xpdu_current = NULL;
+		data_len = sizeof(data);
+		r = emv_ttl_read_record(&ttl, 1, 1, data, &data_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000) {
+			fprintf(stderr, "emv_ttl_read_record() failed; r=%d; sw1sw2=%04X\n", r, sw1sw2);
+			return 1;
+		}
+
+		// SELECT using multiple '61' procedure bytes
+		emul_ctx.xpdu_list = test_tpdu_case_4_normal_advanced;
+		emul_ctx.xpdu_current = NULL;
+		data_len = sizeof(data);
+		r = emv_ttl_select_by_df_name(&ttl, PSE, sizeof(PSE) - 1, data, &data_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000) {
+			fprintf(stderr, "emv_ttl_select_by_df_name() failed; r=%d; sw1sw2=%04X\n", r, sw1sw2);
+			return 1;
+		}
+
+		// Repeat SELECT to accumulate latency statistics
+		emul_ctx.xpdu_list = test_tpdu_case_4_normal_advanced;
+		emul_ctx.xpdu_current = NULL;
+		data_len = sizeof(data);
+		r = emv_ttl_select_by_df_name(&ttl, PSE, sizeof(PSE) - 1, data, &data_len, &sw1sw2);
+		if (r || sw1sw2 != 0x9000) {
+			fprintf(stderr, "emv_ttl_select_by_df_name() failed; r=%d; sw1sw2=%04X\n", r, sw1sw2);
+			return 1;
+		}
+
+		emv_ttl_set_stats(&ttl, NULL);
+
+		cmd_stats = &stats.cmd[EMV_TTL_CMD_READ_RECORD];
+		if (cmd_stats->count != 1 ||
+			cmd_stats->error_count != 0 ||
+			cmd_stats->exchange_count != 4 ||
+			cmd_stats->get_response_count != 2 ||
+			cmd_stats->tx_bytes != 4 * 5 ||
+			cmd_stats->rx_bytes != 2 + 2 + 0x10 + 0x12
+		) {
+			fprintf(stderr, "Incorrect READ RECORD statistics\n");
+			return 1;
+		}
+
+		cmd_stats = &stats.cmd[EMV_TTL_CMD_SELECT];
+		if (cmd_stats->count != 2 ||
+			cmd_stats->error_count != 0 ||
+			cmd_stats->exchange_count != 8 ||
+			cmd_stats->get_response_count != 4 ||
+			cmd_stats->tx_bytes != 2 * (5 + 14 + 5 + 5) ||
+			cmd_stats->rx_bytes != 2 * (1 + 2 + 0x12 + 0x1A) ||
+			cmd_stats->min_us > cmd_stats->max_us ||
+			cmd_stats->total_us < cmd_stats->max_us
+		) {
+			fprintf(stderr, "Incorrect SELECT statistics\n");
+			return 1;
+		}
+
+		histogram_total = 0;
+		for (unsigned int i = 0; i < EMV_TTL_STATS_HISTOGRAM_BUCKETS; ++i) {
+			histogram_total += cmd_stats->histogram[i];
+		}
+		if (histogram_total != cmd_stats->count) {
+			fprintf(stderr, "Incorrect SELECT latency histogram\n");
+			return 1;
+		}
+
+		for (unsigned int i = 0; i < EMV_TTL_CMD_COUNT; ++i) {
+			if (i == EMV_TTL_CMD_READ_RECORD || i == EMV_TTL_CMD_SELECT) {
+				continue;
+			}
+			if (stats.cmd[i].count || stats.cmd[i].exchange_count) {
+				fprintf(stderr, "Unexpected %s statistics\n", emv_ttl_cmd_get_string(i));
+				return 1;
+			}
+		}
+	}
+	printf("Success\n");
+
 	return 0;
 }
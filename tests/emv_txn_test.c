@@ -0,0 +1,1061 @@
+/**
+ * @file emv_txn_test.c
+ * @brief Unit tests for resumable EMV transaction processing
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_cardreader_emul.h"
+#include "emv_ttl.h"
+#include "emv_tlv.h"
+#include "emv_app.h"
+#include "emv_tags.h"
+#include "emv_fields.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// For debug output
+#include "emv_debug.h"
+#include "print_helpers.h"
+
+const struct emv_tlv_t test_param_data[] = {
+	{ {{ EMV_TAG_9C_TRANSACTION_TYPE, 1, (uint8_t[]){ 0x00 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9A_TRANSACTION_DATE, 3, (uint8_t[]){ 0x24, 0x02, 0x17 }, 0 }}, NULL },
+	{ {{ EMV_TAG_5F2A_TRANSACTION_CURRENCY_CODE, 2, (uint8_t[]){ 0x09, 0x78 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 6, (uint8_t[]){ 0x00, 0x00, 0x00, 0x01, 0x23, 0x45 }, 0 }}, NULL },
+	{ {{ EMV_TAG_81_AMOUNT_AUTHORISED_BINARY, 4, (uint8_t[]){ 0x00, 0x00, 0x30, 0x39 }, 0 }}, NULL },
+};
+const struct emv_tlv_t test_config_data[] = {
+	{ {{ EMV_TAG_9F09_APPLICATION_VERSION_NUMBER_TERMINAL, 2, (uint8_t[]){ 0x00, 0x8C }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F1A_TERMINAL_COUNTRY_CODE, 2, (uint8_t[]){ 0x05, 0x28 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F1B_TERMINAL_FLOOR_LIMIT, 4, (uint8_t[]){ 0x00, 0x00, 0x27, 0x10 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F33_TERMINAL_CAPABILITIES, 3, (uint8_t[]){ 0x60, 0xF0, 0xC8 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F35_TERMINAL_TYPE, 1, (uint8_t[]){ 0x22 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F40_ADDITIONAL_TERMINAL_CAPABILITIES, 5, (uint8_t[]){ 0xFA, 0x00, 0xF0, 0xA0, 0x01 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F49_DDOL, 3, (uint8_t[]){ 0x9F, 0x37, 0x04 }, 0 }}, NULL },
+};
+
+#define TEST_PSE \
+	{ \
+		20, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0x00 }, /* SELECT 1PAY.SYS.DDF01 */ \
+		36, (uint8_t[]){ 0x6F, 0x20, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46, 0x30, 0x31, 0xA5, 0x0E, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x04, 0x6E, 0x6C, 0x65, 0x6E, 0x9F, 0x11, 0x01, 0x01, 0x90, 0x00 }, /* FCI */ \
+	}, \
+	{ \
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, /* READ RECORD 1,1 */ \
+		42, (uint8_t[]){ 0x70, 0x26, 0x61, 0x11, 0x4F, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0x50, 0x02, 0x41, 0x31, 0x87, 0x01, 0x01, 0x61, 0x11, 0x4F, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x02, 0x50, 0x02, 0x41, 0x32, 0x87, 0x01, 0x02, 0x90, 0x00 }, /* AEF with two applications */ \
+	}, \
+	{ \
+		5, (uint8_t[]){ 0x00, 0xB2, 0x02, 0x0C, 0x00 }, /* READ RECORD 1,2 */ \
+		2, (uint8_t[]){ 0x6A, 0x83 }, /* Record not found */ \
+	}
+
+#define TEST_SELECT_APP1 \
+	{ \
+		14, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0x00 }, /* SELECT A000000003101001 */ \
+		23, (uint8_t[]){ 0x6F, 0x13, 0x84, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0xA5, 0x07, 0x50, 0x02, 0x41, 0x31, 0x87, 0x01, 0x01, 0x90, 0x00 }, /* FCI */ \
+	}
+
+#define TEST_SELECT_APP2 \
+	{ \
+		14, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x02, 0x00 }, /* SELECT A000000003101002 */ \
+		23, (uint8_t[]){ 0x6F, 0x13, 0x84, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x02, 0xA5, 0x07, 0x50, 0x02, 0x41, 0x32, 0x87, 0x01, 0x02, 0x90, 0x00 }, /* FCI */ \
+	}
+
+#define TEST_GPO_AND_RECORDS \
+	{ \
+		8, (uint8_t[]){ 0x80, 0xA8, 0x00, 0x00, 0x02, 0x83, 0x00, 0x00 }, /* GPO */ \
+		10, (uint8_t[]){ 0x80, 0x06, 0x18, 0x00, 0x08, 0x01, 0x01, 0x00, 0x90, 0x00 }, /* GPO response format 1 */ \
+	}, \
+	{ \
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, /* READ RECORD 1,1 */ \
+		29, (uint8_t[]){ 0x70, 0x19, 0x5F, 0x24, 0x03, 0x25, 0x12, 0x31, 0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0x8C, 0x03, 0x9F, 0x02, 0x06, 0x8D, 0x02, 0x8A, 0x02, 0x90, 0x00 }, /* AEF */ \
+	}
+
+#define TEST_GENAC \
+	{ \
+		12, (uint8_t[]){ 0x80, 0xAE, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x23, 0x45, 0x00 }, /* GENAC1 requesting AAC */ \
+		15, (uint8_t[]){ 0x80, 0x0B, 0x00, 0x00, 0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x90, 0x00 }, /* GENAC response format 1 */ \
+	}
+
+static const struct xpdu_t test1_apdu_list[] = {
+	TEST_PSE,
+	TEST_SELECT_APP1,
+	TEST_GPO_AND_RECORDS,
+	TEST_GENAC,
+	{ 0 }
+};
+
+static const struct xpdu_t test2_apdu_list[] = {
+	TEST_PSE,
+	TEST_SELECT_APP1,
+	{
+		8, (uint8_t[]){ 0x80, 0xA8, 0x00, 0x00, 0x02, 0x83, 0x00, 0x00 }, // GPO
+		2, (uint8_t[]){ 0x69, 0x85 }, // Conditions of use not satisfied
+	},
+	TEST_SELECT_APP2,
+	TEST_GPO_AND_RECORDS,
+	TEST_GENAC,
+	{ 0 }
+};
+
+// GPO with Unpredictable Number (field 9F37) that is updated by
+// test_card_trx() because it is generated by the kernel
+static uint8_t test3_gpo_un[] = { 0x80, 0xA8, 0x00, 0x00, 0x06, 0x83, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static const struct xpdu_t test3_apdu_list[] = {
+	TEST_PSE,
+	{
+		14, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0x00 }, // SELECT A000000003101001
+		29, (uint8_t[]){ 0x6F, 0x19, 0x84, 0x08, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x01, 0xA5, 0x0D, 0x50, 0x02, 0x41, 0x31, 0x87, 0x01, 0x01, 0x9F, 0x38, 0x03, 0x9F, 0x37, 0x04, 0x90, 0x00 }, // FCI with PDOL requesting 9F37
+	},
+	{
+		sizeof(test3_gpo_un), test3_gpo_un, // GPO
+		10, (uint8_t[]){ 0x80, 0x06, 0x18, 0x00, 0x08, 0x01, 0x01, 0x00, 0x90, 0x00 }, // GPO response format 1
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, // READ RECORD 1,1
+		29, (uint8_t[]){ 0x70, 0x19, 0x5F, 0x24, 0x03, 0x25, 0x12, 0x31, 0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0x8C, 0x03, 0x9F, 0x02, 0x06, 0x8D, 0x02, 0x8A, 0x02, 0x90, 0x00 }, // AEF
+	},
+	TEST_GENAC,
+	{ 0 }
+};
+
+static const struct xpdu_t test4_apdu_list[] = {
+	TEST_PSE,
+	TEST_SELECT_APP1,
+	{
+		8, (uint8_t[]){ 0x80, 0xA8, 0x00, 0x00, 0x02, 0x83, 0x00, 0x00 }, // GPO
+		10, (uint8_t[]){ 0x80, 0x06, 0x58, 0x00, 0x08, 0x01, 0x02, 0x02, 0x90, 0x00 }, // GPO response format 1 with SDA and two ODA records
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, // READ RECORD 1,1
+		29, (uint8_t[]){ 0x70, 0x19, 0x5F, 0x24, 0x03, 0x25, 0x12, 0x31, 0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0x8C, 0x03, 0x9F, 0x02, 0x06, 0x8D, 0x02, 0x8A, 0x02, 0x90, 0x00 }, // AEF
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x02, 0x0C, 0x00 }, // READ RECORD 1,2
+		12, (uint8_t[]){ 0x70, 0x08, 0x8F, 0x01, 0xF1, 0x5F, 0x28, 0x02, 0x05, 0x28, 0x90, 0x00 }, // AEF
+	},
+	TEST_GENAC,
+	{ 0 }
+};
+
+static const struct xpdu_t test5_apdu_list[] = {
+	TEST_PSE,
+	TEST_SELECT_APP1,
+	{
+		8, (uint8_t[]){ 0x80, 0xA8, 0x00, 0x00, 0x02, 0x83, 0x00, 0x00 }, // GPO
+		10, (uint8_t[]){ 0x80, 0x06, 0x18, 0x00, 0x08, 0x01, 0x03, 0x00, 0x90, 0x00 }, // GPO response format 1 with three records
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x01, 0x0C, 0x00 }, // READ RECORD 1,1
+		29, (uint8_t[]){ 0x70, 0x19, 0x5F, 0x24, 0x03, 0x25, 0x12, 0x31, 0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0x8C, 0x03, 0x9F, 0x02, 0x06, 0x8D, 0x02, 0x8A, 0x02, 0x90, 0x00 }, // AEF
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x02, 0x0C, 0x00 }, // READ RECORD 1,2
+		12, (uint8_t[]){ 0x70, 0x08, 0x9F, 0x14, 0x01, 0x01, 0x9F, 0x23, 0x01, 0x03, 0x90, 0x00 }, // AEF with Consecutive Offline Limits
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xB2, 0x03, 0x0C, 0x00 }, // READ RECORD 1,3
+		9, (uint8_t[]){ 0x70, 0x05, 0x5F, 0x28, 0x02, 0x05, 0x28, 0x90, 0x00 }, // AEF
+	},
+	{
+		5, (uint8_t[]){ 0x80, 0xCA, 0x9F, 0x36, 0x00 }, // GET DATA 9F36
+		7, (uint8_t[]){ 0x9F, 0x36, 0x02, 0x00, 0x01, 0x90, 0x00 }, // Application Transaction Counter
+	},
+	{
+		5, (uint8_t[]){ 0x80, 0xCA, 0x9F, 0x13, 0x00 }, // GET DATA 9F13
+		7, (uint8_t[]){ 0x9F, 0x13, 0x02, 0x00, 0x00, 0x90, 0x00 }, // Last Online ATC Register
+	},
+	{
+		12, (uint8_t[]){ 0x80, 0xAE, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01, 0x23, 0x45, 0x00 }, // GENAC1 requesting AAC
+		2, (uint8_t[]){ 0x61, 0x0D }, // Response bytes still available
+	},
+	{
+		5, (uint8_t[]){ 0x00, 0xC0, 0x00, 0x00, 0x0D }, // GET RESPONSE
+		15, (uint8_t[]){ 0x80, 0x0B, 0x00, 0x00, 0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x90, 0x00 }, // GENAC response format 1
+	},
+	{ 0 }
+};
+
+// Debug events are recorded, without timestamps, such that step based
+// processing can be compared to blocking processing
+struct test_trace_t {
+	uint8_t buf[65536];
+	size_t len;
+	bool overflow;
+};
+static struct test_trace_t* test_trace = NULL;
+
+static void test_trace_append(const void* data, size_t len)
+{
+	if (test_trace->overflow || sizeof(test_trace->buf) - test_trace->len < len) {
+		test_trace->overflow = true;
+		return;
+	}
+	memcpy(test_trace->buf + test_trace->len, data, len);
+	test_trace->len += len;
+}
+
+static void test_debug(
+	unsigned int timestamp,
+	enum emv_debug_source_t source,
+	enum emv_debug_level_t level,
+	enum emv_debug_type_t debug_type,
+	const char* str,
+	const void* buf,
+	size_t buf_len
+)
+{
+	if (test_trace) {
+		uint8_t header[] = { source, level, debug_type };
+
+		test_trace_append(header, sizeof(header));
+		test_trace_append(str, strlen(str) + 1);
+		if (debug_type != EMV_DEBUG_TYPE_TLV_LIST) {
+			// TLV list event data is a pointer to the list itself
+			test_trace_append(buf, buf_len);
+		}
+	}
+
+	print_emv_debug(timestamp, source, level, debug_type, str, buf, buf_len);
+}
+
+static unsigned int test_gpo_count = 0;
+
+static int test_card_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	const uint8_t* c_apdu = tx_buf;
+
+	if (tx_buf_len > 1 && c_apdu[1] == 0xA8) {
+		++test_gpo_count;
+
+		// Accept the Unpredictable Number provided by the kernel
+		if (tx_buf_len == sizeof(test3_gpo_un)) {
+			memcpy(test3_gpo_un + 7, c_apdu + 7, 4);
+		}
+	}
+
+	return emv_cardreader_emul(ctx, tx_buf, tx_buf_len, rx_buf, rx_buf_len);
+}
+
+// Exchanges provided to the kernel by the resumable transaction are counted
+// to confirm that resumed processing only repeats the current command
+static emv_cardreader_trx_t test_txn_trx = NULL;
+static unsigned int test_replay_count = 0;
+
+static int test_txn_trx_count(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	int r;
+
+	r = test_txn_trx(ctx, tx_buf, tx_buf_len, rx_buf, rx_buf_len);
+	if (r == 0) {
+		++test_replay_count;
+	}
+
+	return r;
+}
+
+static int populate_tlv_list(
+	const struct emv_tlv_t* tlv_array,
+	size_t tlv_array_count,
+	struct emv_tlv_list_t* source
+)
+{
+	int r;
+
+	emv_tlv_list_clear(source);
+	for (size_t i = 0; i < tlv_array_count; ++i) {
+		r = emv_tlv_list_push(source, tlv_array[i].tag, tlv_array[i].length, tlv_array[i].value, 0);
+		if (r) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+static int prepare_ctx(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl)
+{
+	int r;
+
+	r = emv_ctx_init(ctx, ttl);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_config_app_create(ctx, (uint8_t[]){ 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 }, 7, EMV_ASI_PARTIAL_MATCH, NULL, NULL); // Visa
+	if (r) {
+		fprintf(stderr, "emv_config_app_create() failed; r=%d\n", r);
+		return 1;
+	}
+	r = populate_tlv_list(test_param_data, sizeof(test_param_data) / sizeof(test_param_data[0]), &ctx->params);
+	if (r) {
+		fprintf(stderr, "populate_tlv_list() failed; r=%d\n", r);
+		return 1;
+	}
+	r = populate_tlv_list(test_config_data, sizeof(test_config_data) / sizeof(test_config_data[0]), &ctx->config.data);
+	if (r) {
+		fprintf(stderr, "populate_tlv_list() failed; r=%d\n", r);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int run_blocking(struct emv_ctx_t* ctx, unsigned int gpo_attempts)
+{
+	int r;
+	struct emv_app_list_t app_list = EMV_APP_LIST_INIT;
+
+	r = emv_build_candidate_list(ctx, &app_list);
+	if (r) {
+		fprintf(stderr, "emv_build_candidate_list() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	for (unsigned int i = 0; i < gpo_attempts; ++i) {
+		r = emv_select_application(ctx, &app_list, 0);
+		if (r) {
+			fprintf(stderr, "emv_select_application() failed; r=%d\n", r);
+			goto exit;
+		}
+
+		r = emv_initiate_application_processing(ctx, EMV_POS_ENTRY_MODE_ICC_WITH_CVV);
+		if (r != EMV_OUTCOME_GPO_NOT_ACCEPTED) {
+			break;
+		}
+	}
+	if (r) {
+		fprintf(stderr, "emv_initiate_application_processing() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_read_application_data(ctx);
+	if (r) {
+		fprintf(stderr, "emv_read_application_data() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_offline_data_authentication(ctx);
+	if (r) {
+		fprintf(stderr, "emv_offline_data_authentication() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_processing_restrictions(ctx);
+	if (r) {
+		fprintf(stderr, "emv_processing_restrictions() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_terminal_risk_management(ctx, NULL, 0);
+	if (r) {
+		fprintf(stderr, "emv_terminal_risk_management() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_card_action_analysis(ctx);
+	if (r) {
+		fprintf(stderr, "emv_card_action_analysis() failed; r=%d\n", r);
+		goto exit;
+	}
+
+exit:
+	emv_app_list_clear(&app_list);
+	return r;
+}
+
+static int run_steps(
+	struct emv_ctx_t* ctx,
+	struct emv_cardreader_emul_ctx_t* emul_ctx,
+	unsigned int* app_selection_count,
+	unsigned int* capdu_count
+)
+{
+	int r;
+	struct emv_txn_t txn;
+	enum emv_txn_event_t event;
+	uint8_t r_apdu[EMV_RAPDU_MAX];
+	size_t r_apdu_len = 0;
+	struct emv_ttl_t* ctx_ttl = ctx->ttl;
+	struct test_trace_t* trace = test_trace;
+
+	*app_selection_count = 0;
+	*capdu_count = 0;
+
+	r = emv_txn_init(&txn, ctx, EMV_POS_ENTRY_MODE_ICC_WITH_CVV);
+	if (r) {
+		fprintf(stderr, "emv_txn_init() failed; r=%d\n", r);
+		return r;
+	}
+	test_txn_trx = txn.ttl.cardreader.trx;
+	txn.ttl.cardreader.trx = &test_txn_trx_count;
+	test_replay_count = 0;
+
+	while (true) {
+		r = emv_txn_step(&txn, r_apdu, r_apdu_len, &event);
+		if (r) {
+			fprintf(stderr, "emv_txn_step() failed; r=%d\n", r);
+			goto exit;
+		}
+
+		if (event == EMV_TXN_EVENT_CAPDU) {
+			++*capdu_count;
+
+			// Exchange C-APDU with card on behalf of the kernel
+			r_apdu_len = sizeof(r_apdu);
+			r = test_card_trx(emul_ctx, txn.c_apdu, txn.c_apdu_len, r_apdu, &r_apdu_len);
+			if (r) {
+				fprintf(stderr, "test_card_trx() failed; r=%d\n", r);
+				goto exit;
+			}
+			continue;
+		}
+		r_apdu_len = 0;
+
+		if (event == EMV_TXN_EVENT_APP_SELECTION) {
+			++*app_selection_count;
+
+			// Invalid application index must be rejected without
+			// affecting the transaction. Its debug events are not part of
+			// blocking processing.
+			test_trace = NULL;
+			r = emv_txn_select_app(&txn, 5);
+			if (r) {
+				fprintf(stderr, "emv_txn_select_app() failed; r=%d\n", r);
+				goto exit;
+			}
+			r = emv_txn_step(&txn, NULL, 0, &event);
+			if (r != EMV_ERROR_INVALID_PARAMETER) {
+				fprintf(stderr, "emv_txn_step() did not reject invalid application index; r=%d\n", r);
+				r = 1;
+				goto exit;
+			}
+			test_trace = trace;
+
+			r = emv_txn_select_app(&txn, 0);
+			if (r) {
+				fprintf(stderr, "emv_txn_select_app() failed; r=%d\n", r);
+				goto exit;
+			}
+			continue;
+		}
+
+		if (event == EMV_TXN_EVENT_DONE) {
+			if (ctx->ttl != ctx_ttl) {
+				fprintf(stderr, "EMV_TXN_EVENT_DONE did not restore TTL\n");
+				r = 1;
+				goto exit;
+			}
+			break;
+		}
+
+		fprintf(stderr, "Unexpected transaction event %d\n", event);
+		r = 1;
+		goto exit;
+	}
+
+	// Once done, the transaction must remain done
+	r = emv_txn_step(&txn, NULL, 0, &event);
+	if (r || event != EMV_TXN_EVENT_DONE) {
+		fprintf(stderr, "Unexpected emv_txn_step() result; r=%d; event=%d\n", r, event);
+		r = 1;
+		goto exit;
+	}
+
+exit:
+	test_trace = trace;
+	emv_txn_clear(&txn);
+	if (ctx->ttl != ctx_ttl) {
+		fprintf(stderr, "emv_txn_clear() did not restore TTL\n");
+		r = 1;
+	}
+	return r;
+}
+
+static int verify_icc_data(
+	const struct emv_tlv_list_t* list,
+	const struct emv_tlv_list_t* verify
+)
+{
+	const struct emv_tlv_t* tlv = list->front;
+	const struct emv_tlv_t* tlv_verify = verify->front;
+
+	if (!tlv) {
+		fprintf(stderr, "ICC list unexpectedly empty\n");
+		return 1;
+	}
+
+	while (tlv && tlv_verify) {
+		if (tlv->tag != tlv_verify->tag ||
+			tlv->length != tlv_verify->length ||
+			memcmp(tlv->value, tlv_verify->value, tlv->length) != 0
+		) {
+			fprintf(stderr, "ICC data differs from blocking processing\n");
+			print_emv_tlv_list(list);
+			print_emv_tlv_list(verify);
+			return 1;
+		}
+		tlv = tlv->next;
+		tlv_verify = tlv_verify->next;
+	}
+	if (tlv || tlv_verify) {
+		fprintf(stderr, "ICC data differs from blocking processing\n");
+		print_emv_tlv_list(list);
+		print_emv_tlv_list(verify);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int verify_stats(
+	const struct emv_ttl_stats_t* stats,
+	const struct emv_ttl_stats_t* verify
+)
+{
+	for (unsigned int i = 0; i < EMV_TTL_CMD_COUNT; ++i) {
+		const struct emv_ttl_cmd_stats_t* cmd_stats = &stats->cmd[i];
+		const struct emv_ttl_cmd_stats_t* cmd_verify = &verify->cmd[i];
+
+		// Replayed exchanges must not be counted again and abandoned
+		// processing must not be counted as errors
+		if (cmd_stats->count != cmd_verify->count ||
+			cmd_stats->error_count != cmd_verify->error_count ||
+			cmd_stats->exchange_count != cmd_verify->exchange_count ||
+			cmd_stats->get_response_count != cmd_verify->get_response_count ||
+			cmd_stats->tx_bytes != cmd_verify->tx_bytes ||
+			cmd_stats->rx_bytes != cmd_verify->rx_bytes
+		) {
+			fprintf(stderr, "%s statistics differ from blocking processing; count=%lu/%lu; error_count=%lu/%lu; exchange_count=%lu/%lu\n",
+				emv_ttl_cmd_get_string(i),
+				cmd_stats->count, cmd_verify->count,
+				cmd_stats->error_count, cmd_verify->error_count,
+				cmd_stats->exchange_count, cmd_verify->exchange_count
+			);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Each asynchronous transaction uses its own emulated card reader and all of
+// them are multiplexed by the event loop in run_async_test()
+struct test_async_reader_t {
+	const struct xpdu_t* apdu_list;
+	unsigned int submit_fail; // Fail submission with this number. Zero to ignore.
+	unsigned int submit_count;
+	struct emv_cardreader_emul_ctx_t emul_ctx;
+	struct emv_ttl_t ttl;
+	struct emv_ctx_t emv;
+	struct emv_txn_t txn;
+	unsigned int complete_count;
+	bool done;
+	int r;
+};
+
+static int test_async_submit(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t rx_buf_len,
+	emv_cardreader_complete_t complete,
+	void* complete_ctx
+)
+{
+	struct test_async_reader_t* reader = ctx;
+
+	++reader->submit_count;
+	if (reader->submit_count == reader->submit_fail) {
+		return -1;
+	}
+
+	return emv_cardreader_emul_submit(
+		&reader->emul_ctx,
+		tx_buf,
+		tx_buf_len,
+		rx_buf,
+		rx_buf_len,
+		complete,
+		complete_ctx
+	);
+}
+
+static void test_async_complete(
+	void* complete_ctx,
+	int r,
+	enum emv_txn_event_t event
+)
+{
+	struct test_async_reader_t* reader = complete_ctx;
+
+	++reader->complete_count;
+	if (!r && event == EMV_TXN_EVENT_APP_SELECTION) {
+		// Continue with first application from the completion function
+		r = emv_txn_select_app(&reader->txn, 0);
+		if (!r) {
+			r = emv_txn_run_async(&reader->txn, &test_async_complete, reader);
+		}
+		if (!r) {
+			return;
+		}
+	} else if (!r && event != EMV_TXN_EVENT_DONE) {
+		fprintf(stderr, "Unexpected transaction event %d\n", event);
+		r = 1;
+	}
+
+	reader->done = true;
+	reader->r = r;
+}
+
+static int verify_replay(
+	const struct emv_ttl_stats_t* stats,
+	unsigned int capdu_count
+)
+{
+	unsigned int get_response_count = 0;
+
+	for (unsigned int i = 0; i < EMV_TTL_CMD_COUNT; ++i) {
+		get_response_count += stats->cmd[i].get_response_count;
+	}
+
+	// Each exchange must be replayed once to complete its command. Only the
+	// commands in this test that require GET RESPONSE, which consist of two
+	// exchanges, replay their first exchange again when completed.
+	if (test_replay_count != capdu_count + get_response_count) {
+		fprintf(stderr, "Unexpected number of replayed exchanges %u for %u exchanges\n",
+			test_replay_count, capdu_count
+		);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int verify_tvr_tsi(
+	const struct emv_ctx_t* ctx,
+	const struct emv_ctx_t* verify
+)
+{
+	// Offline data authentication, processing restrictions and terminal risk
+	// management must reach the same results
+	if (!ctx->tvr || !verify->tvr ||
+		ctx->tvr->length != verify->tvr->length ||
+		memcmp(ctx->tvr->value, verify->tvr->value, verify->tvr->length) != 0
+	) {
+		fprintf(stderr, "TVR differs from blocking processing\n");
+		return 1;
+	}
+	if (!ctx->tsi || !verify->tsi ||
+		ctx->tsi->length != verify->tsi->length ||
+		memcmp(ctx->tsi->value, verify->tsi->value, verify->tsi->length) != 0
+	) {
+		fprintf(stderr, "TSI differs from blocking processing\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int run_test(
+	const struct xpdu_t* apdu_list,
+	unsigned int gpo_attempts,
+	bool verify_trace
+)
+{
+	int r;
+	struct emv_cardreader_emul_ctx_t emul_ctx;
+	struct emv_ttl_t ttl;
+	struct emv_ctx_t emv_blocking;
+	struct emv_ctx_t emv;
+	unsigned int app_selection_count;
+	unsigned int capdu_count;
+	static struct test_trace_t trace_blocking;
+	static struct test_trace_t trace;
+
+	ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+	ttl.cardreader.ctx = &emul_ctx;
+	ttl.cardreader.trx = &test_card_trx;
+	memset(&trace_blocking, 0, sizeof(trace_blocking));
+	memset(&trace, 0, sizeof(trace));
+
+	r = prepare_ctx(&emv_blocking, &ttl);
+	if (r) {
+		goto exit;
+	}
+	r = prepare_ctx(&emv, NULL);
+	if (r) {
+		goto exit;
+	}
+
+	// Blocking processing as reference
+	emul_ctx.xpdu_list = apdu_list;
+	emul_ctx.xpdu_current = NULL;
+	test_trace = &trace_blocking;
+	r = run_blocking(&emv_blocking, gpo_attempts);
+	test_trace = NULL;
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (emul_ctx.xpdu_current->c_xpdu_len != 0) {
+		fprintf(stderr, "Incomplete card interaction\n");
+		r = 1;
+		goto exit;
+	}
+
+	// Step based processing of the same card interaction
+	emul_ctx.xpdu_list = apdu_list;
+	emul_ctx.xpdu_current = NULL;
+	test_gpo_count = 0;
+	test_trace = &trace;
+	r = run_steps(&emv, &emul_ctx, &app_selection_count, &capdu_count);
+	test_trace = NULL;
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+	if (emul_ctx.xpdu_current->c_xpdu_len != 0) {
+		fprintf(stderr, "Incomplete card interaction\n");
+		r = 1;
+		goto exit;
+	}
+	if (app_selection_count != 1) {
+		fprintf(stderr, "Unexpected number of application selection events %u\n", app_selection_count);
+		r = 1;
+		goto exit;
+	}
+	if (!emv.selected_app || !emv.afl) {
+		fprintf(stderr, "Transaction state not populated\n");
+		r = 1;
+		goto exit;
+	}
+
+	r = verify_icc_data(&emv.icc, &emv_blocking.icc);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+
+	r = verify_stats(&emv.stats, &emv_blocking.stats);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+
+	if (gpo_attempts != test_gpo_count) {
+		fprintf(stderr, "Unexpected number of GPO exchanges %u\n", test_gpo_count);
+		r = 1;
+		goto exit;
+	}
+
+	if (emv.oda.pdol_data_len) {
+		const struct emv_tlv_t* un;
+
+		// Unpredictable Number must only be generated once such that the
+		// value sent to the card is the value used by further processing
+		un = emv_tlv_list_find_const(&emv.terminal, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+		if (!un || un->length != 4 ||
+			emv.oda.pdol_data_len != un->length ||
+			memcmp(emv.oda.pdol_data, un->value, un->length) != 0 ||
+			memcmp(test3_gpo_un + 7, un->value, un->length) != 0
+		) {
+			fprintf(stderr, "Unpredictable Number differs from GPO\n");
+			r = 1;
+			goto exit;
+		}
+	}
+
+	r = verify_replay(&emv.stats, capdu_count);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+
+	r = verify_tvr_tsi(&emv, &emv_blocking);
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+
+	if (trace_blocking.overflow || trace.overflow) {
+		fprintf(stderr, "Debug trace too large\n");
+		r = 1;
+		goto exit;
+	}
+	if (verify_trace && (
+		trace.len != trace_blocking.len ||
+		memcmp(trace.buf, trace_blocking.buf, trace.len) != 0
+	)) {
+		fprintf(stderr, "Debug trace differs from blocking processing; len=%zu/%zu\n", trace.len, trace_blocking.len);
+		r = 1;
+		goto exit;
+	}
+
+	r = 0;
+	goto exit;
+
+exit:
+	emv_ctx_clear(&emv_blocking);
+	emv_ctx_clear(&emv);
+	return r;
+}
+
+static int run_async_test(
+	struct test_async_reader_t* readers,
+	size_t reader_count
+)
+{
+	int r;
+	unsigned int max_pending = 0;
+	bool pending;
+
+	for (size_t i = 0; i < reader_count; ++i) {
+		struct test_async_reader_t* reader = &readers[i];
+
+		// Each asynchronous transaction uses its own card reader
+		memset(&reader->emul_ctx, 0, sizeof(reader->emul_ctx));
+		reader->emul_ctx.xpdu_list = reader->apdu_list;
+		reader->ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+		reader->ttl.cardreader.ctx = reader;
+		reader->ttl.cardreader.trx = NULL;
+		reader->ttl.cardreader.submit = &test_async_submit;
+		reader->submit_count = 0;
+		reader->complete_count = 0;
+		reader->done = false;
+		r = prepare_ctx(&reader->emv, &reader->ttl);
+		if (r) {
+			return 1;
+		}
+		r = emv_txn_init(&reader->txn, &reader->emv, EMV_POS_ENTRY_MODE_ICC_WITH_CVV);
+		if (r) {
+			fprintf(stderr, "emv_txn_init() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < reader_count; ++i) {
+		r = emv_txn_run_async(&readers[i].txn, &test_async_complete, &readers[i]);
+		if (r) {
+			fprintf(stderr, "emv_txn_run_async() failed; r=%d\n", r);
+			return 1;
+		}
+	}
+
+	// Single threaded event loop for all card readers
+	do {
+		unsigned int pending_count = 0;
+
+		for (size_t i = 0; i < reader_count; ++i) {
+			pending_count += readers[i].emul_ctx.pending;
+		}
+		if (pending_count > max_pending) {
+			max_pending = pending_count;
+		}
+
+		pending = false;
+		for (size_t i = 0; i < reader_count; ++i) {
+			pending |= emv_cardreader_emul_poll(&readers[i].emul_ctx);
+		}
+	} while (pending);
+
+	if (max_pending < 2) {
+		fprintf(stderr, "Transactions were not interleaved\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < reader_count; ++i) {
+		struct test_async_reader_t* reader = &readers[i];
+
+		if (!reader->done || reader->complete_count != 2) {
+			fprintf(stderr, "Transaction %zu not completed once per event; complete_count=%u\n", i, reader->complete_count);
+			return 1;
+		}
+		if (reader->emv.ttl != &reader->ttl) {
+			fprintf(stderr, "Transaction %zu did not restore TTL\n", i);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int run_async_tests(void)
+{
+	int r;
+	static struct test_async_reader_t readers[4];
+	static const struct xpdu_t* apdu_list[] = {
+		test1_apdu_list,
+		test4_apdu_list,
+		test5_apdu_list,
+		test1_apdu_list,
+	};
+	struct emv_ttl_t ttl;
+	struct emv_ctx_t emv_blocking;
+	struct emv_cardreader_emul_ctx_t emul_ctx;
+
+	memset(readers, 0, sizeof(readers));
+	for (size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); ++i) {
+		readers[i].apdu_list = apdu_list[i];
+	}
+
+	// Card reader failure when submitting GPO
+	readers[3].submit_fail = 5;
+
+	r = run_async_test(readers, sizeof(readers) / sizeof(readers[0]));
+	if (r) {
+		r = 1;
+		goto exit;
+	}
+
+	for (size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); ++i) {
+		struct test_async_reader_t* reader = &readers[i];
+
+		if (reader->submit_fail) {
+			if (reader->r != EMV_OUTCOME_CARD_ERROR) {
+				fprintf(stderr, "Unexpected outcome after card reader failure; r=%d\n", reader->r);
+				r = 1;
+				goto exit;
+			}
+			continue;
+		}
+		if (reader->r) {
+			fprintf(stderr, "Transaction %zu failed; r=%d\n", i, reader->r);
+			r = 1;
+			goto exit;
+		}
+		if (reader->emul_ctx.xpdu_current->c_xpdu_len != 0) {
+			fprintf(stderr, "Incomplete card interaction\n");
+			r = 1;
+			goto exit;
+		}
+
+		// Blocking processing as reference
+		memset(&emul_ctx, 0, sizeof(emul_ctx));
+		emul_ctx.xpdu_list = reader->apdu_list;
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+		ttl.cardreader.ctx = &emul_ctx;
+		ttl.cardreader.trx = &emv_cardreader_emul;
+		ttl.cardreader.submit = NULL;
+		r = prepare_ctx(&emv_blocking, &ttl);
+		if (!r) {
+			r = run_blocking(&emv_blocking, 1);
+		}
+		if (!r) {
+			r = verify_icc_data(&reader->emv.icc, &emv_blocking.icc);
+		}
+		if (!r) {
+			r = verify_stats(&reader->emv.stats, &emv_blocking.stats);
+		}
+		if (!r) {
+			r = verify_tvr_tsi(&reader->emv, &emv_blocking);
+		}
+		emv_ctx_clear(&emv_blocking);
+		if (r) {
+			r = 1;
+			goto exit;
+		}
+	}
+
+	r = 0;
+	goto exit;
+
+exit:
+	for (size_t i = 0; i < sizeof(readers) / sizeof(readers[0]); ++i) {
+		emv_txn_clear(&readers[i].txn);
+		emv_ctx_clear(&readers[i].emv);
+	}
+	return r;
+}
+
+int main(void)
+{
+	int r;
+
+	r = emv_debug_init(
+		EMV_DEBUG_SOURCE_ALL,
+		EMV_DEBUG_LEVEL_CARD,
+		&test_debug
+	);
+	if (r) {
+		printf("Failed to initialise EMV debugging\n");
+		return 1;
+	}
+
+	printf("\nTest 1: Step based processing matches blocking processing...\n");
+	r = run_test(test1_apdu_list, 1, true);
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 2: Step based processing returns to application selection...\n");
+	r = run_test(test2_apdu_list, 2, true);
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 3: Step based processing uses single Unpredictable Number for PDOL...\n");
+	r = run_test(test3_apdu_list, 1, false);
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Step based processing reads ODA records once...\n");
+	r = run_test(test4_apdu_list, 1, true);
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Step based processing performs velocity checking and GET RESPONSE...\n");
+	r = run_test(test5_apdu_list, 1, true);
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	printf("\nTest 6: Asynchronous transactions are multiplexed on a single thread...\n");
+	r = run_async_tests();
+	if (r) {
+		return 1;
+	}
+	printf("Success\n");
+
+	return 0;
+}
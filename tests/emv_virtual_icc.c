@@ -0,0 +1,803 @@
+/**
+ * @file emv_virtual_icc.c
+ * @brief Virtual ICC that answers EMV commands from an application model
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_virtual_icc.h"
+#include "emv_ttl.h"
+#include "emv_tags.h"
+#include "emv_fields.h"
+#include "emv_dol.h"
+#include "iso7816_apdu.h"
+#include "iso8825_ber.h"
+
+#include "crypto_rsa.h"
+#include "crypto_sha.h"
+#include "crypto_mem.h"
+
+#include <string.h>
+
+// Payment System Environment (PSE) name
+// See EMV 4.4 Book 1, 12.2.2
+static const uint8_t pse_name[] = { '1', 'P', 'A', 'Y', '.', 'S', 'Y', 'S', '.', 'D', 'D', 'F', '0', '1' };
+
+// Length of ICC Dynamic Number generated by the virtual ICC
+#define EMV_VIRTUAL_ICC_IDN_LEN (4)
+
+static int emv_virtual_icc_sw(uint16_t sw1sw2, void* rx_buf, size_t* rx_buf_len)
+{
+	uint8_t* ptr = rx_buf;
+
+	if (*rx_buf_len < 2) {
+		return -1;
+	}
+	ptr[0] = sw1sw2 >> 8;
+	ptr[1] = sw1sw2 & 0xFF;
+	*rx_buf_len = 2;
+
+	return 0;
+}
+
+static int emv_virtual_icc_data(
+	const void* data,
+	size_t data_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	uint8_t* ptr = rx_buf;
+
+	if (data_len > EMV_RAPDU_DATA_MAX || *rx_buf_len < data_len + 2) {
+		return -1;
+	}
+	memcpy(ptr, data, data_len);
+	ptr[data_len] = 0x90;
+	ptr[data_len + 1] = 0x00;
+	*rx_buf_len = data_len + 2;
+
+	return 0;
+}
+
+static int emv_virtual_icc_put_tlv(
+	unsigned int tag,
+	const void* value,
+	size_t value_len,
+	uint8_t* buf,
+	size_t buf_size,
+	size_t* buf_len
+)
+{
+	size_t tag_len = tag > 0xFF ? 2 : 1;
+	size_t len_len = value_len > 0x7F ? 2 : 1;
+	uint8_t* ptr = buf + *buf_len;
+
+	if (value_len > 0xFF) {
+		return -1;
+	}
+	if (*buf_len + tag_len + len_len + value_len > buf_size) {
+		return -2;
+	}
+
+	if (tag_len == 2) {
+		*ptr++ = tag >> 8;
+	}
+	*ptr++ = tag & 0xFF;
+	if (len_len == 2) {
+		*ptr++ = 0x81;
+	}
+	*ptr++ = value_len;
+	memcpy(ptr, value, value_len);
+	*buf_len += tag_len + len_len + value_len;
+
+	return 0;
+}
+
+static bool emv_virtual_icc_find_field(
+	const struct emv_virtual_icc_app_t* app,
+	unsigned int tag,
+	struct iso8825_tlv_t* tlv
+)
+{
+	for (size_t i = 0; i < app->record_count; ++i) {
+		int r;
+		struct iso8825_tlv_t record_tlv;
+		struct iso8825_ber_itr_t itr;
+
+		r = iso8825_ber_decode(app->records[i].data, app->records[i].data_len, &record_tlv);
+		if (r <= 0 || record_tlv.tag != EMV_TAG_70_DATA_TEMPLATE) {
+			continue;
+		}
+
+		r = iso8825_ber_itr_init(record_tlv.value, record_tlv.length, &itr);
+		if (r) {
+			continue;
+		}
+		while (iso8825_ber_itr_next(&itr, tlv) > 0) {
+			if (tlv->tag == tag) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static int emv_virtual_icc_find_dol_offset(
+	const struct iso8825_tlv_t* dol,
+	unsigned int tag,
+	size_t* offset,
+	size_t* length
+)
+{
+	int r;
+	struct emv_dol_itr_t itr;
+	struct emv_dol_entry_t entry;
+
+	r = emv_dol_itr_init(dol->value, dol->length, &itr);
+	if (r) {
+		return -1;
+	}
+
+	*offset = 0;
+	while ((r = emv_dol_itr_next(&itr, &entry)) > 0) {
+		if (entry.tag == tag) {
+			*length = entry.length;
+			return 0;
+		}
+		*offset += entry.length;
+	}
+
+	// Not found
+	return 1;
+}
+
+static int emv_virtual_icc_sign(
+	const struct emv_virtual_icc_key_t* key,
+	const void* dyn_data,
+	size_t dyn_data_len,
+	const void* hash_data,
+	size_t hash_data_len,
+	uint8_t* sdad
+)
+{
+	int r;
+	uint8_t buf[1984 / 8];
+	size_t n = key->modulus_len;
+	crypto_sha1_ctx_t sha1_ctx = NULL;
+
+	// Build Signed Dynamic Application Data (SDAD) before encryption
+	// See EMV 4.4 Book 2, 6.5.1, table 17
+	// See EMV 4.4 Book 2, 6.6.1, table 19
+	if (n > sizeof(buf) || dyn_data_len + 25 > n) {
+		return -1;
+	}
+	buf[0] = 0x6A; // Recovered Data Header
+	buf[1] = 0x05; // Signed Data Format
+	buf[2] = 0x01; // Hash Algorithm Indicator: SHA-1
+	buf[3] = dyn_data_len;
+	memcpy(buf + 4, dyn_data, dyn_data_len);
+	memset(buf + 4 + dyn_data_len, 0xBB, n - 25 - dyn_data_len);
+	buf[n - 1] = 0xBC; // Recovered Data Trailer
+
+	// Hash the signed data followed by DDOL data or Unpredictable Number
+	r = crypto_sha1_init(&sha1_ctx);
+	if (r) {
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, buf + 1, n - 22);
+	if (r) {
+		r = -3;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, hash_data, hash_data_len);
+	if (r) {
+		r = -4;
+		goto exit;
+	}
+	r = crypto_sha1_finish(&sha1_ctx, buf + n - 21);
+	if (r) {
+		r = -5;
+		goto exit;
+	}
+
+	r = crypto_rsa_mod_exp(
+		key->modulus,
+		key->modulus_len,
+		key->exponent,
+		key->exponent_len,
+		buf,
+		sdad
+	);
+	if (r) {
+		r = -6;
+		goto exit;
+	}
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	crypto_cleanse(buf, sizeof(buf));
+	return r;
+}
+
+static int emv_virtual_icc_select(
+	struct emv_virtual_icc_t* icc,
+	uint8_t p1,
+	uint8_t p2,
+	const uint8_t* data,
+	size_t data_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	const struct emv_virtual_icc_profile_t* profile = icc->profile;
+	size_t i;
+
+	// See EMV 4.4 Book 1, 11.3.2, table 5
+	if (p1 != 0x04) {
+		return emv_virtual_icc_sw(0x6A86, rx_buf, rx_buf_len);
+	}
+
+	if (data_len == sizeof(pse_name) &&
+		memcmp(data, pse_name, sizeof(pse_name)) == 0
+	) {
+		if (!profile->pse_fci) {
+			return emv_virtual_icc_sw(0x6A82, rx_buf, rx_buf_len);
+		}
+		icc->pse_selected = true;
+		icc->app = NULL;
+		icc->gpo_done = false;
+		icc->genac_count = 0;
+		return emv_virtual_icc_data(profile->pse_fci, profile->pse_fci_len, rx_buf, rx_buf_len);
+	}
+
+	// Find first or next application using partial AID matching
+	// See EMV 4.4 Book 1, 12.3.3
+	switch (p2 & ISO7816_SELECT_P2_FILE_OCCURRENCE_MASK) {
+		case ISO7816_SELECT_P2_FILE_OCCURRENCE_FIRST:
+			i = 0;
+			break;
+
+		case ISO7816_SELECT_P2_FILE_OCCURRENCE_NEXT:
+			i = icc->next_app_index;
+			break;
+
+		default:
+			return emv_virtual_icc_sw(0x6A86, rx_buf, rx_buf_len);
+	}
+	for (; i < profile->app_count; ++i) {
+		const struct emv_virtual_icc_app_t* app = &profile->apps[i];
+
+		if (data_len <= app->aid_len &&
+			memcmp(app->aid, data, data_len) == 0
+		) {
+			icc->pse_selected = false;
+			icc->app = app;
+			icc->next_app_index = i + 1;
+			icc->gpo_done = false;
+			icc->genac_count = 0;
+			return emv_virtual_icc_data(app->fci, app->fci_len, rx_buf, rx_buf_len);
+		}
+	}
+
+	// File or application not found
+	icc->next_app_index = profile->app_count;
+	return emv_virtual_icc_sw(0x6A82, rx_buf, rx_buf_len);
+}
+
+static int emv_virtual_icc_read_record(
+	struct emv_virtual_icc_t* icc,
+	uint8_t p1,
+	uint8_t p2,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	const struct emv_virtual_icc_record_t* records;
+	size_t record_count;
+	uint8_t sfi = p2 >> 3;
+
+	// See EMV 4.4 Book 1, 11.2.2, table 3
+	if ((p2 & 0x07) != 0x04 || !p1) {
+		return emv_virtual_icc_sw(0x6A86, rx_buf, rx_buf_len);
+	}
+
+	if (icc->pse_selected) {
+		records = icc->profile->pse_records;
+		record_count = icc->profile->pse_record_count;
+	} else if (icc->app) {
+		records = icc->app->records;
+		record_count = icc->app->record_count;
+	} else {
+		// No current file
+		return emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+	}
+
+	for (size_t i = 0; i < record_count; ++i) {
+		if (records[i].sfi == sfi && records[i].record_number == p1) {
+			return emv_virtual_icc_data(records[i].data, records[i].data_len, rx_buf, rx_buf_len);
+		}
+	}
+
+	// Record not found
+	return emv_virtual_icc_sw(0x6A83, rx_buf, rx_buf_len);
+}
+
+static int emv_virtual_icc_gpo(
+	struct emv_virtual_icc_t* icc,
+	const uint8_t* data,
+	size_t data_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	int r;
+	const struct emv_virtual_icc_app_t* app = icc->app;
+	struct iso8825_tlv_t tlv;
+	uint8_t response[2 + 2 + 252];
+	size_t response_len;
+
+	if (!app || icc->gpo_done) {
+		return emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+	}
+
+	// Command template must contain the PDOL data
+	// See EMV 4.4 Book 3, 6.5.8.3
+	r = iso8825_ber_decode(data, data_len, &tlv);
+	if (r <= 0 ||
+		(size_t)r != data_len ||
+		tlv.tag != EMV_TAG_83_COMMAND_TEMPLATE
+	) {
+		return emv_virtual_icc_sw(0x6A80, rx_buf, rx_buf_len);
+	}
+	if (2 + app->afl_len > sizeof(response) - 2) {
+		return -1;
+	}
+	memcpy(icc->pdol_data, tlv.value, tlv.length);
+	icc->pdol_data_len = tlv.length;
+
+	icc->atc++;
+	icc->gpo_done = true;
+
+	// Response format 1
+	// See EMV 4.4 Book 3, 6.5.8.4
+	response[0] = EMV_TAG_80_RESPONSE_MESSAGE_TEMPLATE_FORMAT_1;
+	response[1] = 2 + app->afl_len;
+	memcpy(response + 2, app->aip, 2);
+	memcpy(response + 4, app->afl, app->afl_len);
+	response_len = 4 + app->afl_len;
+
+	return emv_virtual_icc_data(response, response_len, rx_buf, rx_buf_len);
+}
+
+static int emv_virtual_icc_get_data(
+	struct emv_virtual_icc_t* icc,
+	uint8_t p1,
+	uint8_t p2,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	uint8_t value[2];
+	size_t value_len;
+	uint8_t response[5];
+	size_t response_len = 0;
+	unsigned int tag = (p1 << 8) | p2;
+
+	// See EMV 4.4 Book 3, 6.5.7
+	switch (tag) {
+		case EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER:
+			value[0] = icc->atc >> 8;
+			value[1] = icc->atc & 0xFF;
+			value_len = 2;
+			break;
+
+		case EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER:
+			value[0] = icc->last_online_atc >> 8;
+			value[1] = icc->last_online_atc & 0xFF;
+			value_len = 2;
+			break;
+
+		case EMV_TAG_9F17_PIN_TRY_COUNTER:
+			value[0] = icc->pin_try_counter;
+			value_len = 1;
+			break;
+
+		default:
+			// Referenced data not found
+			return emv_virtual_icc_sw(0x6A88, rx_buf, rx_buf_len);
+	}
+
+	emv_virtual_icc_put_tlv(tag, value, value_len, response, sizeof(response), &response_len);
+	return emv_virtual_icc_data(response, response_len, rx_buf, rx_buf_len);
+}
+
+static void emv_virtual_icc_next_idn(struct emv_virtual_icc_t* icc, uint8_t* idn)
+{
+	icc->icc_dynamic_number++;
+	idn[0] = icc->icc_dynamic_number >> 24;
+	idn[1] = icc->icc_dynamic_number >> 16;
+	idn[2] = icc->icc_dynamic_number >> 8;
+	idn[3] = icc->icc_dynamic_number;
+}
+
+static int emv_virtual_icc_internal_authenticate(
+	struct emv_virtual_icc_t* icc,
+	const uint8_t* data,
+	size_t data_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	int r;
+	const struct emv_virtual_icc_key_t* key;
+	uint8_t dyn_data[1 + EMV_VIRTUAL_ICC_IDN_LEN];
+	uint8_t response[3 + 1984 / 8];
+
+	if (!icc->app || !icc->app->icc_key) {
+		return emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+	}
+	key = icc->app->icc_key;
+	if (key->modulus_len > sizeof(response) - 3) {
+		return -1;
+	}
+
+	// ICC Dynamic Data consists of the length and value of the
+	// ICC Dynamic Number
+	// See EMV 4.4 Book 2, 6.5.1, table 16
+	dyn_data[0] = EMV_VIRTUAL_ICC_IDN_LEN;
+	emv_virtual_icc_next_idn(icc, dyn_data + 1);
+
+	// Response format 1
+	// See EMV 4.4 Book 3, 6.5.9.4
+	response[0] = EMV_TAG_80_RESPONSE_MESSAGE_TEMPLATE_FORMAT_1;
+	if (key->modulus_len > 0x7F) {
+		response[1] = 0x81;
+		response[2] = key->modulus_len;
+	} else {
+		response[1] = key->modulus_len;
+	}
+	r = emv_virtual_icc_sign(
+		key,
+		dyn_data,
+		sizeof(dyn_data),
+		data,
+		data_len,
+		response + (key->modulus_len > 0x7F ? 3 : 2)
+	);
+	if (r) {
+		return r;
+	}
+
+	return emv_virtual_icc_data(
+		response,
+		(key->modulus_len > 0x7F ? 3 : 2) + key->modulus_len,
+		rx_buf,
+		rx_buf_len
+	);
+}
+
+static int emv_virtual_icc_genac(
+	struct emv_virtual_icc_t* icc,
+	uint8_t p1,
+	const uint8_t* data,
+	size_t data_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	int r;
+	const struct emv_virtual_icc_app_t* app = icc->app;
+	uint8_t cid;
+	uint8_t atc[2];
+	uint8_t digest[SHA1_SIZE];
+	crypto_sha1_ctx_t sha1_ctx = NULL;
+	uint8_t response[EMV_RAPDU_DATA_MAX];
+	size_t response_len = 0;
+	uint8_t fields[EMV_RAPDU_DATA_MAX];
+	size_t fields_len = 0;
+
+	if (!app || !icc->gpo_done) {
+		return emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+	}
+
+	// Only allow the second GENERATE AC after an ARQC
+	// See EMV 4.4 Book 3, 6.5.5.1
+	if (icc->genac_count >= 2 ||
+		(icc->genac_count == 1 &&
+		(icc->last_cid & EMV_CID_APPLICATION_CRYPTOGRAM_TYPE_MASK) != EMV_CID_APPLICATION_CRYPTOGRAM_TYPE_ARQC)
+	) {
+		return emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+	}
+	if ((p1 & EMV_TTL_GENAC_TYPE_MASK) == EMV_CID_APPLICATION_CRYPTOGRAM_TYPE_RFU) {
+		return emv_virtual_icc_sw(0x6A86, rx_buf, rx_buf_len);
+	}
+
+	// Always provide the requested cryptogram type
+	cid = p1 & EMV_TTL_GENAC_TYPE_MASK;
+	atc[0] = icc->atc >> 8;
+	atc[1] = icc->atc & 0xFF;
+
+	// Derive Application Cryptogram from the transaction data. This is not
+	// an issuer verifiable cryptogram but it is unique per transaction.
+	r = crypto_sha1_init(&sha1_ctx);
+	if (r) {
+		r = -1;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, data, data_len);
+	if (r) {
+		r = -2;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, atc, sizeof(atc));
+	if (r) {
+		r = -3;
+		goto exit;
+	}
+	r = crypto_sha1_update(&sha1_ctx, &cid, 1);
+	if (r) {
+		r = -4;
+		goto exit;
+	}
+	r = crypto_sha1_finish(&sha1_ctx, digest);
+	if (r) {
+		r = -5;
+		goto exit;
+	}
+	crypto_sha1_free(&sha1_ctx);
+
+	icc->genac_count++;
+	icc->last_cid = cid;
+
+	if ((p1 & EMV_TTL_GENAC_SIG_MASK) == EMV_TTL_GENAC_SIG_CDA && app->icc_key) {
+		const struct emv_virtual_icc_key_t* key = app->icc_key;
+		struct iso8825_tlv_t cdol;
+		size_t un_offset;
+		size_t un_len;
+		uint8_t head[4 + 5];
+		size_t head_len = 0;
+		uint8_t tail[3 + 32];
+		size_t tail_len = 0;
+		uint8_t dyn_data[1 + EMV_VIRTUAL_ICC_IDN_LEN + 1 + 8 + SHA1_SIZE];
+		uint8_t sdad[1984 / 8];
+
+		// Find Unpredictable Number in CDOL data
+		if (!emv_virtual_icc_find_field(
+				app,
+				icc->genac_count == 1 ? EMV_TAG_8C_CDOL1 : EMV_TAG_8D_CDOL2,
+				&cdol
+			) ||
+			emv_virtual_icc_find_dol_offset(&cdol, EMV_TAG_9F37_UNPREDICTABLE_NUMBER, &un_offset, &un_len) ||
+			un_offset + un_len > data_len
+		) {
+			r = emv_virtual_icc_sw(0x6985, rx_buf, rx_buf_len);
+			goto exit;
+		}
+
+		// Response format 2 with CID and ATC before SDAD and IAD after SDAD
+		// See EMV 4.4 Book 3, 6.5.5.4
+		r = emv_virtual_icc_put_tlv(EMV_TAG_9F27_CRYPTOGRAM_INFORMATION_DATA, &cid, 1, head, sizeof(head), &head_len);
+		if (r) {
+			goto exit;
+		}
+		r = emv_virtual_icc_put_tlv(EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER, atc, sizeof(atc), head, sizeof(head), &head_len);
+		if (r) {
+			goto exit;
+		}
+		if (app->iad) {
+			r = emv_virtual_icc_put_tlv(EMV_TAG_9F10_ISSUER_APPLICATION_DATA, app->iad, app->iad_len, tail, sizeof(tail), &tail_len);
+			if (r) {
+				goto exit;
+			}
+		}
+
+		// ICC Dynamic Data consists of the ICC Dynamic Number, CID,
+		// Application Cryptogram and Transaction Data Hash Code. The latter
+		// is computed over the PDOL data, CDOL data and response fields
+		// excluding SDAD.
+		// See EMV 4.4 Book 2, 6.6.1, table 18
+		dyn_data[0] = EMV_VIRTUAL_ICC_IDN_LEN;
+		emv_virtual_icc_next_idn(icc, dyn_data + 1);
+		dyn_data[1 + EMV_VIRTUAL_ICC_IDN_LEN] = cid;
+		memcpy(dyn_data + 1 + EMV_VIRTUAL_ICC_IDN_LEN + 1, digest, 8);
+		r = crypto_sha1_init(&sha1_ctx);
+		if (r) {
+			r = -6;
+			goto exit;
+		}
+		r = crypto_sha1_update(&sha1_ctx, icc->pdol_data, icc->pdol_data_len);
+		if (r) {
+			r = -7;
+			goto exit;
+		}
+		r = crypto_sha1_update(&sha1_ctx, data, data_len);
+		if (r) {
+			r = -8;
+			goto exit;
+		}
+		r = crypto_sha1_update(&sha1_ctx, head, head_len);
+		if (r) {
+			r = -9;
+			goto exit;
+		}
+		r = crypto_sha1_update(&sha1_ctx, tail, tail_len);
+		if (r) {
+			r = -10;
+			goto exit;
+		}
+		r = crypto_sha1_finish(&sha1_ctx, dyn_data + 1 + EMV_VIRTUAL_ICC_IDN_LEN + 1 + 8);
+		if (r) {
+			r = -11;
+			goto exit;
+		}
+
+		r = emv_virtual_icc_sign(key, dyn_data, sizeof(dyn_data), data + un_offset, un_len, sdad);
+		if (r) {
+			goto exit;
+		}
+
+		// Assemble response template
+		memcpy(fields, head, head_len);
+		fields_len = head_len;
+		r = emv_virtual_icc_put_tlv(EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA, sdad, key->modulus_len, fields, sizeof(fields), &fields_len);
+		if (r) {
+			goto exit;
+		}
+		if (fields_len + tail_len > sizeof(fields)) {
+			r = -12;
+			goto exit;
+		}
+		memcpy(fields + fields_len, tail, tail_len);
+		fields_len += tail_len;
+		r = emv_virtual_icc_put_tlv(EMV_TAG_77_RESPONSE_MESSAGE_TEMPLATE_FORMAT_2, fields, fields_len, response, sizeof(response), &response_len);
+		if (r) {
+			goto exit;
+		}
+
+	} else {
+		// Response format 1
+		// See EMV 4.4 Book 3, 6.5.5.4
+		fields[0] = cid;
+		memcpy(fields + 1, atc, sizeof(atc));
+		memcpy(fields + 3, digest, 8);
+		fields_len = 11;
+		if (app->iad) {
+			if (app->iad_len > 32) {
+				r = -12;
+				goto exit;
+			}
+			memcpy(fields + fields_len, app->iad, app->iad_len);
+			fields_len += app->iad_len;
+		}
+		r = emv_virtual_icc_put_tlv(EMV_TAG_80_RESPONSE_MESSAGE_TEMPLATE_FORMAT_1, fields, fields_len, response, sizeof(response), &response_len);
+		if (r) {
+			goto exit;
+		}
+	}
+
+	r = emv_virtual_icc_data(response, response_len, rx_buf, rx_buf_len);
+	goto exit;
+
+exit:
+	crypto_sha1_free(&sha1_ctx);
+	return r;
+}
+
+int emv_virtual_icc_init(
+	struct emv_virtual_icc_t* icc,
+	const struct emv_virtual_icc_profile_t* profile
+)
+{
+	if (!icc || !profile) {
+		return -1;
+	}
+
+	memset(icc, 0, sizeof(*icc));
+	icc->profile = profile;
+	icc->atc = profile->atc;
+	icc->last_online_atc = profile->last_online_atc;
+	icc->pin_try_counter = profile->pin_try_counter;
+
+	return 0;
+}
+
+int emv_virtual_icc_reset(struct emv_virtual_icc_t* icc)
+{
+	if (!icc) {
+		return -1;
+	}
+
+	icc->pse_selected = false;
+	icc->app = NULL;
+	icc->next_app_index = 0;
+	icc->gpo_done = false;
+	icc->genac_count = 0;
+	icc->last_cid = 0;
+	icc->pdol_data_len = 0;
+
+	return 0;
+}
+
+int emv_virtual_icc_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+)
+{
+	struct emv_virtual_icc_t* icc = ctx;
+	const uint8_t* c_apdu = tx_buf;
+	const uint8_t* data = NULL;
+	size_t data_len = 0;
+
+	if (!icc || !icc->profile || !tx_buf || !rx_buf || !rx_buf_len) {
+		return -1;
+	}
+	if (tx_buf_len < 4) {
+		return -2;
+	}
+
+	// Determine C-APDU data field for cases 1 to 4 using short lengths
+	// See ISO 7816-3:2006, 12.1.3
+	if (tx_buf_len > 5) {
+		data_len = c_apdu[4];
+		data = c_apdu + 5;
+		if (tx_buf_len != 5 + data_len && tx_buf_len != 5 + data_len + 1) {
+			return emv_virtual_icc_sw(0x6700, rx_buf, rx_buf_len);
+		}
+	}
+	icc->command_count++;
+
+	switch ((c_apdu[0] << 8) | c_apdu[1]) {
+		case 0x00A4: // SELECT
+			return emv_virtual_icc_select(icc, c_apdu[2], c_apdu[3], data, data_len, rx_buf, rx_buf_len);
+
+		case 0x00B2: // READ RECORD
+			return emv_virtual_icc_read_record(icc, c_apdu[2], c_apdu[3], rx_buf, rx_buf_len);
+
+		case 0x80A8: // GET PROCESSING OPTIONS
+			return emv_virtual_icc_gpo(icc, data, data_len, rx_buf, rx_buf_len);
+
+		case 0x80CA: // GET DATA
+			return emv_virtual_icc_get_data(icc, c_apdu[2], c_apdu[3], rx_buf, rx_buf_len);
+
+		case 0x0088: // INTERNAL AUTHENTICATE
+			return emv_virtual_icc_internal_authenticate(icc, data, data_len, rx_buf, rx_buf_len);
+
+		case 0x80AE: // GENERATE AC
+			return emv_virtual_icc_genac(icc, c_apdu[2], data, data_len, rx_buf, rx_buf_len);
+
+		default:
+			if (c_apdu[0] != ISO7816_CLA_INTERINDUSTRY &&
+				c_apdu[0] != ISO7816_CLA_PROPRIETARY
+			) {
+				// Class not supported
+				return emv_virtual_icc_sw(0x6E00, rx_buf, rx_buf_len);
+			}
+
+			// Instruction not supported
+			return emv_virtual_icc_sw(0x6D00, rx_buf, rx_buf_len);
+	}
+}
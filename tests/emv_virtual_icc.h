@@ -0,0 +1,149 @@
+/**
+ * @file emv_virtual_icc.h
+ * @brief Virtual ICC that answers EMV commands from an application model
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMV_VIRTUAL_ICC_H
+#define EMV_VIRTUAL_ICC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Virtual ICC record in a Short File Identifier (SFI)
+struct emv_virtual_icc_record_t {
+	uint8_t sfi; ///< Short File Identifier (SFI)
+	uint8_t record_number; ///< Record number
+	size_t data_len; ///< Length of record data in bytes
+	const uint8_t* data; ///< Record data, including template 70
+};
+
+/// Virtual ICC private key used for Signed Dynamic Application Data (SDAD)
+struct emv_virtual_icc_key_t {
+	size_t modulus_len; ///< Length of modulus in bytes
+	const uint8_t* modulus; ///< Modulus
+	size_t exponent_len; ///< Length of private exponent in bytes
+	const uint8_t* exponent; ///< Private exponent
+};
+
+/// Virtual ICC application
+struct emv_virtual_icc_app_t {
+	size_t aid_len; ///< Length of Application Identifier (AID) in bytes
+	const uint8_t* aid; ///< Application Identifier (AID)
+	size_t fci_len; ///< Length of File Control Information (FCI) in bytes
+	const uint8_t* fci; ///< File Control Information (FCI), including template 6F
+	uint8_t aip[2]; ///< Application Interchange Profile (field 82)
+	size_t afl_len; ///< Length of Application File Locator (AFL) in bytes
+	const uint8_t* afl; ///< Application File Locator (field 94)
+	size_t record_count; ///< Number of records
+	const struct emv_virtual_icc_record_t* records; ///< Records of this application
+	size_t iad_len; ///< Length of Issuer Application Data (IAD) in bytes
+	const uint8_t* iad; ///< Issuer Application Data (field 9F10). May be NULL.
+	const struct emv_virtual_icc_key_t* icc_key; ///< ICC private key. NULL if DDA and CDA are not supported.
+};
+
+/// Virtual ICC profile describing the card file system and initial state
+struct emv_virtual_icc_profile_t {
+	size_t pse_fci_len; ///< Length of Payment System Environment (PSE) FCI in bytes
+	const uint8_t* pse_fci; ///< PSE FCI, including template 6F. NULL if PSE is not present.
+	size_t pse_record_count; ///< Number of PSE records
+	const struct emv_virtual_icc_record_t* pse_records; ///< PSE directory records
+	size_t app_count; ///< Number of applications
+	const struct emv_virtual_icc_app_t* apps; ///< Applications
+	uint16_t atc; ///< Initial Application Transaction Counter (field 9F36)
+	uint16_t last_online_atc; ///< Initial Last Online ATC Register (field 9F13)
+	uint8_t pin_try_counter; ///< Initial PIN Try Counter (field 9F17)
+};
+
+/**
+ * Virtual ICC context
+ *
+ * The virtual ICC answers SELECT, READ RECORD, GET PROCESSING OPTIONS,
+ * GET DATA, INTERNAL AUTHENTICATE and GENERATE AC from its profile instead
+ * of a scripted list of exchanges. Signed Dynamic Application Data (SDAD) is
+ * computed using the ICC private key of the selected application while the
+ * Application Cryptogram is derived from a hash of the transaction data and is
+ * not verifiable by an issuer.
+ */
+struct emv_virtual_icc_t {
+	const struct emv_virtual_icc_profile_t* profile; ///< Virtual ICC profile
+	uint16_t atc; ///< Application Transaction Counter (field 9F36)
+	uint16_t last_online_atc; ///< Last Online ATC Register (field 9F13)
+	uint8_t pin_try_counter; ///< PIN Try Counter (field 9F17)
+	unsigned long command_count; ///< Number of commands processed
+
+	/// @cond INTERNAL
+	bool pse_selected;
+	const struct emv_virtual_icc_app_t* app;
+	size_t next_app_index;
+	bool gpo_done;
+	unsigned int genac_count;
+	uint8_t last_cid;
+	uint8_t pdol_data[255];
+	size_t pdol_data_len;
+	uint32_t icc_dynamic_number;
+	/// @endcond
+};
+
+/**
+ * Initialise virtual ICC using profile. The profile is not copied and must
+ * remain valid for the lifetime of the virtual ICC.
+ *
+ * @param icc Virtual ICC context
+ * @param profile Virtual ICC profile
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_virtual_icc_init(
+	struct emv_virtual_icc_t* icc,
+	const struct emv_virtual_icc_profile_t* profile
+);
+
+/**
+ * Reset virtual ICC session state, similar to a card reset. The counters are
+ * retained such that successive transactions behave like a real card.
+ *
+ * @param icc Virtual ICC context
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_virtual_icc_reset(struct emv_virtual_icc_t* icc);
+
+/**
+ * Virtual ICC card reader transceive in APDU mode. Use this function as
+ * @ref emv_cardreader_t.trx with @ref EMV_CARDREADER_MODE_APDU and the virtual
+ * ICC context as @ref emv_cardreader_t.ctx.
+ *
+ * @param ctx Virtual ICC context
+ * @param tx_buf C-APDU
+ * @param tx_buf_len Length of C-APDU in bytes
+ * @param rx_buf R-APDU output
+ * @param rx_buf_len Length of R-APDU buffer in bytes, updated with R-APDU length
+ *
+ * @return Zero for success. Less than zero for error.
+ */
+int emv_virtual_icc_trx(
+	void* ctx,
+	const void* tx_buf,
+	size_t tx_buf_len,
+	void* rx_buf,
+	size_t* rx_buf_len
+);
+
+#endif
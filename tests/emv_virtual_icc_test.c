@@ -0,0 +1,741 @@
+/**
+ * @file emv_virtual_icc_test.c
+ * @brief End-to-end transaction tests using the virtual ICC
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv_virtual_icc.h"
+#include "emv.h"
+#include "emv_ttl.h"
+#include "emv_tal.h"
+#include "emv_tlv.h"
+#include "emv_app.h"
+#include "emv_oda_types.h"
+#include "emv_rsa.h"
+#include "emv_pki.h"
+#include "emv_capk.h"
+#include "emv_tags.h"
+#include "emv_fields.h"
+#include "emv_utils_config.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// For debug output
+#include "emv_debug.h"
+#include "print_helpers.h"
+
+// 1024-bit ICC key with public exponent 3, for testing only
+static const uint8_t test_icc_modulus[] = {
+	0xBC, 0x50, 0x4A, 0x2F, 0xED, 0xEB, 0x42, 0x74, 0x7E, 0xB5, 0x97, 0xBE, 0x8D, 0x60, 0xE9, 0xBB,
+	0xD2, 0x8A, 0x95, 0x16, 0x16, 0xF0, 0xB0, 0xBC, 0x87, 0xF5, 0xB6, 0xB9, 0xE3, 0x37, 0x91, 0xE9,
+	0x55, 0x38, 0x57, 0xAA, 0x17, 0xCE, 0xF9, 0xF1, 0x8D, 0x3A, 0x21, 0xCA, 0xAA, 0xEB, 0x2B, 0x78,
+	0xEB, 0x22, 0x1D, 0xAA, 0x03, 0xE5, 0x47, 0x8C, 0x48, 0x26, 0x9C, 0x8E, 0x32, 0x29, 0x6D, 0xFD,
+	0x22, 0xD2, 0x8E, 0x34, 0xD3, 0x5F, 0xDE, 0x03, 0x7D, 0xB7, 0x36, 0x14, 0xB8, 0xE0, 0x08, 0x55,
+	0x57, 0x69, 0x85, 0x69, 0xEB, 0x5E, 0x88, 0x3C, 0xDD, 0x84, 0x5F, 0x3E, 0xB9, 0x41, 0x91, 0xE9,
+	0xC3, 0xDD, 0x8C, 0x70, 0xD0, 0xAD, 0x4D, 0x50, 0x97, 0xD7, 0xA1, 0xF3, 0xCF, 0x7F, 0x11, 0x9E,
+	0xA3, 0xEB, 0x53, 0xFF, 0x76, 0xC6, 0x4C, 0x5E, 0x60, 0xA7, 0x11, 0x8B, 0x56, 0x70, 0x86, 0x9F,
+};
+static const uint8_t test_icc_private_exponent[] = {
+	0x7D, 0x8A, 0xDC, 0x1F, 0xF3, 0xF2, 0x2C, 0x4D, 0xA9, 0xCE, 0x65, 0x29, 0xB3, 0x95, 0xF1, 0x27,
+	0xE1, 0xB1, 0xB8, 0xB9, 0x64, 0xA0, 0x75, 0xD3, 0x05, 0x4E, 0x79, 0xD1, 0x42, 0x25, 0x0B, 0xF0,
+	0xE3, 0x7A, 0xE5, 0x1C, 0x0F, 0xDF, 0x51, 0x4B, 0xB3, 0x7C, 0x16, 0x87, 0x1C, 0x9C, 0xC7, 0xA5,
+	0xF2, 0x16, 0xBE, 0x71, 0x57, 0xEE, 0x2F, 0xB2, 0xDA, 0xC4, 0x68, 0x5E, 0xCC, 0x1B, 0x9E, 0xA7,
+	0x9B, 0x68, 0x00, 0x0F, 0x33, 0x20, 0x50, 0xB3, 0x72, 0x08, 0x71, 0xF7, 0x49, 0xCF, 0x38, 0xCB,
+	0x79, 0x06, 0x4F, 0x6A, 0xF4, 0x2D, 0x44, 0x3F, 0xEE, 0x7C, 0xCB, 0xB8, 0xA4, 0x36, 0x55, 0x51,
+	0x45, 0x22, 0x90, 0x29, 0xDD, 0x4E, 0xA1, 0x5F, 0x16, 0x41, 0xB0, 0x85, 0xCF, 0x34, 0xEF, 0xA9,
+	0xD8, 0x00, 0xDD, 0xF4, 0x16, 0x92, 0xC7, 0x56, 0xE8, 0x6F, 0x24, 0x1B, 0xC7, 0xA2, 0xD3, 0x2B,
+};
+static const struct emv_virtual_icc_key_t test_icc_key = {
+	sizeof(test_icc_modulus), test_icc_modulus,
+	sizeof(test_icc_private_exponent), test_icc_private_exponent,
+};
+
+static const uint8_t test_pse_fci[] = {
+	0x6F, 0x20, 0x84, 0x0E, 0x31, 0x50, 0x41, 0x59, 0x2E, 0x53, 0x59, 0x53, 0x2E, 0x44, 0x44, 0x46,
+	0x30, 0x31, 0xA5, 0x0E, 0x88, 0x01, 0x01, 0x5F, 0x2D, 0x04, 0x6E, 0x6C, 0x65, 0x6E, 0x9F, 0x11,
+	0x01, 0x01,
+};
+static const struct emv_virtual_icc_record_t test_pse_records[] = {
+	{
+		1, 1, 22, (uint8_t[]){ 0x70, 0x14, 0x61, 0x12, 0x4F, 0x07, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x50, 0x04, 0x56, 0x49, 0x53, 0x41, 0x87, 0x01, 0x01 }, // A0000000031010
+	},
+};
+
+static const uint8_t test_app_fci[] = {
+	0x6F, 0x1D, 0x84, 0x07, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0xA5, 0x12, 0x50, 0x04, 0x56,
+	0x49, 0x53, 0x41, 0x87, 0x01, 0x01, 0x9F, 0x38, 0x06, 0x9F, 0x1A, 0x02, 0x9F, 0x37, 0x04, // PDOL with Unpredictable Number
+};
+static const uint8_t test_app_afl[] = { 0x08, 0x01, 0x04, 0x01 }; // First record is static data to be authenticated
+
+// Certificate records are populated by prepare_pki() because the CA and
+// issuer keys are generated for each test run
+static uint8_t test_issuer_cert_record[256];
+static uint8_t test_icc_cert_record[256];
+static struct emv_virtual_icc_record_t test_app_records[] = {
+	{
+		1, 1, 38, (uint8_t[]){
+			0x70, 0x24,
+			0x5A, 0x08, 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, // Application PAN
+			0x5F, 0x24, 0x03, 0x30, 0x12, 0x31, // Application Expiration Date
+			0x5F, 0x25, 0x03, 0x24, 0x01, 0x01, // Application Effective Date
+			0x5F, 0x34, 0x01, 0x01, // Application PAN Sequence Number
+			0x9F, 0x07, 0x02, 0xFF, 0x00, // Application Usage Control
+			0x9F, 0x08, 0x02, 0x00, 0x8C, // Application Version Number
+		},
+	},
+	{
+		1, 2, 55, (uint8_t[]){
+			0x70, 0x35,
+			0x8C, 0x15, 0x9F, 0x02, 0x06, 0x9F, 0x03, 0x06, 0x9F, 0x1A, 0x02, 0x95, 0x05, 0x5F, 0x2A, 0x02, 0x9A, 0x03, 0x9C, 0x01, 0x9F, 0x37, 0x04, // CDOL1
+			0x8D, 0x0A, 0x8A, 0x02, 0x9F, 0x02, 0x06, 0x95, 0x05, 0x9F, 0x37, 0x04, // CDOL2
+			0x9F, 0x14, 0x01, 0x03, // Lower Consecutive Offline Limit
+			0x9F, 0x23, 0x01, 0x05, // Upper Consecutive Offline Limit
+			0x9F, 0x49, 0x03, 0x9F, 0x37, 0x04, // DDOL
+			0x9F, 0x4A, 0x01, 0x82, // SDA Tag List
+		},
+	},
+	{ 1, 3, 0, test_issuer_cert_record },
+	{ 1, 4, 0, test_icc_cert_record },
+};
+static const uint8_t test_app_iad[] = { 0x06, 0x01, 0x0A, 0x03, 0xA0, 0x00, 0x00 };
+
+static const struct emv_virtual_icc_app_t test_apps[] = {
+	{
+		7, (uint8_t[]){ 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 },
+		sizeof(test_app_fci), test_app_fci,
+		{ EMV_AIP_CDA_SUPPORTED | EMV_AIP_TERMINAL_RISK_MANAGEMENT_REQUIRED | EMV_AIP_DDA_SUPPORTED, 0x00 },
+		sizeof(test_app_afl), test_app_afl,
+		sizeof(test_app_records) / sizeof(test_app_records[0]), test_app_records,
+		sizeof(test_app_iad), test_app_iad,
+		&test_icc_key,
+	},
+};
+
+static const struct emv_virtual_icc_profile_t test_profile = {
+	sizeof(test_pse_fci), test_pse_fci,
+	sizeof(test_pse_records) / sizeof(test_pse_records[0]), test_pse_records,
+	sizeof(test_apps) / sizeof(test_apps[0]), test_apps,
+	0x0010, // ATC
+	0x000E, // Last online ATC
+	3, // PIN try counter
+};
+
+static const uint8_t test_rid[] = { 0xA0, 0x00, 0x00, 0x00, 0x03 };
+static const uint8_t test_capk_index = 0xF1;
+static const uint8_t test_pan[] = { 0x47, 0x61, 0x73, 0x90, 0x01, 0x01, 0x01, 0x19, 0xFF, 0xFF };
+static const uint8_t test_issuer_id[] = { 0x47, 0x61, 0x73, 0x90 };
+static const uint8_t test_cert_exp[] = { 0x12, 0x49 };
+static const uint8_t test_cert_sn[] = { 0x00, 0x00, 0x01 };
+
+const struct emv_tlv_t test_param_data[] = {
+	{ {{ EMV_TAG_9C_TRANSACTION_TYPE, 1, (uint8_t[]){ 0x00 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9A_TRANSACTION_DATE, 3, (uint8_t[]){ 0x26, 0x10, 0x15 }, 0 }}, NULL },
+	{ {{ EMV_TAG_5F2A_TRANSACTION_CURRENCY_CODE, 2, (uint8_t[]){ 0x09, 0x78 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F02_AMOUNT_AUTHORISED_NUMERIC, 6, (uint8_t[]){ 0x00, 0x00, 0x00, 0x01, 0x23, 0x45 }, 0 }}, NULL },
+	{ {{ EMV_TAG_81_AMOUNT_AUTHORISED_BINARY, 4, (uint8_t[]){ 0x00, 0x00, 0x30, 0x39 }, 0 }}, NULL },
+};
+const struct emv_tlv_t test_config_data[] = {
+	{ {{ EMV_TAG_9F09_APPLICATION_VERSION_NUMBER_TERMINAL, 2, (uint8_t[]){ 0x00, 0x8C }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F1A_TERMINAL_COUNTRY_CODE, 2, (uint8_t[]){ 0x05, 0x28 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F1B_TERMINAL_FLOOR_LIMIT, 4, (uint8_t[]){ 0x00, 0x00, 0x27, 0x10 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F33_TERMINAL_CAPABILITIES, 3, (uint8_t[]){ 0x60, 0xF0, 0xC8 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F35_TERMINAL_TYPE, 1, (uint8_t[]){ 0x22 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F40_ADDITIONAL_TERMINAL_CAPABILITIES, 5, (uint8_t[]){ 0xFA, 0x00, 0xF0, 0xA0, 0x01 }, 0 }}, NULL },
+	{ {{ EMV_TAG_9F49_DDOL, 3, (uint8_t[]){ 0x9F, 0x37, 0x04 }, 0 }}, NULL },
+};
+
+static double now_ns(void)
+{
+	struct timespec t;
+
+#if defined(HAVE_TIMESPEC_GET)
+	timespec_get(&t, TIME_UTC);
+#elif defined(HAVE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+
+	return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+static void put_tlv(
+	uint8_t* buf,
+	size_t* offset,
+	unsigned int tag,
+	size_t length,
+	const uint8_t* value
+)
+{
+	if (tag > 0xFF) {
+		buf[(*offset)++] = tag >> 8;
+	}
+	buf[(*offset)++] = tag;
+	if (length > 0x7F) {
+		buf[(*offset)++] = 0x81;
+	}
+	buf[(*offset)++] = length;
+	memcpy(buf + *offset, value, length);
+	*offset += length;
+}
+
+static int prepare_pki(
+	struct emv_pki_key_t* ca_key,
+	struct emv_pki_key_t* issuer_key,
+	uint8_t* capk_hash,
+	struct emv_capk_t* capk
+)
+{
+	int r;
+	struct emv_pki_key_t icc_key;
+	struct emv_pki_cert_t cert;
+	uint8_t static_data[64];
+	size_t static_data_len;
+	uint8_t data[250];
+	size_t data_len;
+
+	// Generate CA and issuer keys such that both the issuer public key and
+	// the ICC public key require a remainder
+	r = emv_pki_generate_key(1152 / 8, 3, ca_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for CA key; r=%d\n", r);
+		return 1;
+	}
+	r = emv_pki_generate_key(1024 / 8, 3, issuer_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for issuer key; r=%d\n", r);
+		return 1;
+	}
+	r = emv_pki_populate_capk(ca_key, test_rid, test_capk_index, capk_hash, capk);
+	if (r) {
+		fprintf(stderr, "emv_pki_populate_capk() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_capk_add(capk);
+	if (r) {
+		fprintf(stderr, "emv_capk_add() failed; r=%d\n", r);
+		return 1;
+	}
+
+	r = emv_pki_create_issuer_cert(ca_key, test_issuer_id, test_cert_exp, test_cert_sn, issuer_key, &cert);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_issuer_cert() failed; r=%d\n", r);
+		return 1;
+	}
+	data_len = 0;
+	put_tlv(data, &data_len, EMV_TAG_8F_CERTIFICATION_AUTHORITY_PUBLIC_KEY_INDEX, 1, &test_capk_index);
+	put_tlv(data, &data_len, EMV_TAG_90_ISSUER_PUBLIC_KEY_CERTIFICATE, cert.cert_len, cert.cert);
+	put_tlv(data, &data_len, EMV_TAG_92_ISSUER_PUBLIC_KEY_REMAINDER, cert.remainder_len, cert.remainder);
+	put_tlv(data, &data_len, EMV_TAG_9F32_ISSUER_PUBLIC_KEY_EXPONENT, issuer_key->exponent_len, issuer_key->exponent);
+	test_app_records[2].data_len = 0;
+	put_tlv(test_issuer_cert_record, &test_app_records[2].data_len, EMV_TAG_70_DATA_TEMPLATE, data_len, data);
+
+	// Certify the fixed ICC key of the virtual ICC application
+	memset(&icc_key, 0, sizeof(icc_key));
+	icc_key.modulus_len = sizeof(test_icc_modulus);
+	memcpy(icc_key.modulus, test_icc_modulus, sizeof(test_icc_modulus));
+	icc_key.exponent_len = 1;
+	icc_key.exponent[0] = 0x03;
+
+	// Static data to be authenticated consists of the first record,
+	// excluding template 70, followed by the AIP listed by the SDA Tag List
+	// See EMV 4.4 Book 3, 10.3
+	static_data_len = test_app_records[0].data_len - 2;
+	memcpy(static_data, test_app_records[0].data + 2, static_data_len);
+	memcpy(static_data + static_data_len, test_apps[0].aip, sizeof(test_apps[0].aip));
+	static_data_len += sizeof(test_apps[0].aip);
+
+	r = emv_pki_create_icc_cert(issuer_key, test_pan, test_cert_exp, test_cert_sn, &icc_key, static_data, static_data_len, &cert);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_icc_cert() failed; r=%d\n", r);
+		return 1;
+	}
+	data_len = 0;
+	put_tlv(data, &data_len, EMV_TAG_9F46_ICC_PUBLIC_KEY_CERTIFICATE, cert.cert_len, cert.cert);
+	put_tlv(data, &data_len, EMV_TAG_9F47_ICC_PUBLIC_KEY_EXPONENT, icc_key.exponent_len, icc_key.exponent);
+	put_tlv(data, &data_len, EMV_TAG_9F48_ICC_PUBLIC_KEY_REMAINDER, cert.remainder_len, cert.remainder);
+	test_app_records[3].data_len = 0;
+	put_tlv(test_icc_cert_record, &test_app_records[3].data_len, EMV_TAG_70_DATA_TEMPLATE, data_len, data);
+
+	return 0;
+}
+
+static int populate_tlv_list(
+	const struct emv_tlv_t* tlv_array,
+	size_t tlv_array_count,
+	struct emv_tlv_list_t* source
+)
+{
+	int r;
+
+	emv_tlv_list_clear(source);
+	for (size_t i = 0; i < tlv_array_count; ++i) {
+		r = emv_tlv_list_push(source, tlv_array[i].tag, tlv_array[i].length, tlv_array[i].value, 0);
+		if (r) {
+			return r;
+		}
+	}
+
+	return 0;
+}
+
+static int prepare_ctx(struct emv_ctx_t* ctx, struct emv_ttl_t* ttl)
+{
+	int r;
+
+	r = emv_ctx_init(ctx, ttl);
+	if (r) {
+		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_config_app_create(ctx, (uint8_t[]){ 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10 }, 7, EMV_ASI_PARTIAL_MATCH, NULL, NULL); // Visa
+	if (r) {
+		fprintf(stderr, "emv_config_app_create() failed; r=%d\n", r);
+		return 1;
+	}
+	r = populate_tlv_list(test_config_data, sizeof(test_config_data) / sizeof(test_config_data[0]), &ctx->config.data);
+	if (r) {
+		fprintf(stderr, "populate_tlv_list() failed; r=%d\n", r);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int prepare_params(struct emv_ctx_t* ctx)
+{
+	int r;
+
+	r = populate_tlv_list(test_param_data, sizeof(test_param_data) / sizeof(test_param_data[0]), &ctx->params);
+	if (r) {
+		fprintf(stderr, "populate_tlv_list() failed; r=%d\n", r);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int run_until_card_action_analysis(struct emv_ctx_t* ctx)
+{
+	int r;
+	struct emv_app_list_t app_list = EMV_APP_LIST_INIT;
+
+	r = prepare_params(ctx);
+	if (r) {
+		goto exit;
+	}
+
+	r = emv_build_candidate_list(ctx, &app_list);
+	if (r) {
+		fprintf(stderr, "emv_build_candidate_list() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_select_application(ctx, &app_list, 0);
+	if (r) {
+		fprintf(stderr, "emv_select_application() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_initiate_application_processing(ctx, EMV_POS_ENTRY_MODE_ICC_WITH_CVV);
+	if (r) {
+		fprintf(stderr, "emv_initiate_application_processing() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_read_application_data(ctx);
+	if (r) {
+		fprintf(stderr, "emv_read_application_data() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_offline_data_authentication(ctx);
+	if (r) {
+		fprintf(stderr, "emv_offline_data_authentication() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_processing_restrictions(ctx);
+	if (r) {
+		fprintf(stderr, "emv_processing_restrictions() failed; r=%d\n", r);
+		goto exit;
+	}
+
+	r = emv_terminal_risk_management(ctx, NULL, 0);
+	if (r) {
+		fprintf(stderr, "emv_terminal_risk_management() failed; r=%d\n", r);
+		goto exit;
+	}
+
+exit:
+	emv_app_list_clear(&app_list);
+	return r;
+}
+
+static int verify_genac(
+	const struct emv_ctx_t* ctx,
+	const struct emv_virtual_icc_t* icc
+)
+{
+	const struct emv_tlv_t* tlv;
+
+	// CDA must be performed successfully using the certificates of the
+	// virtual ICC
+	if (ctx->oda.method != EMV_ODA_METHOD_CDA ||
+		(ctx->tvr->value[0] & (EMV_TVR_OFFLINE_DATA_AUTH_NOT_PERFORMED | EMV_TVR_CDA_FAILED)) ||
+		!(ctx->tsi->value[0] & EMV_TSI_OFFLINE_DATA_AUTH_PERFORMED)
+	) {
+		fprintf(stderr, "CDA not performed successfully\n");
+		print_emv_tlv_list(&ctx->terminal);
+		return 1;
+	}
+	if (!emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F4C_ICC_DYNAMIC_NUMBER)) {
+		fprintf(stderr, "ICC Dynamic Number not found\n");
+		print_emv_tlv_list(&ctx->icc);
+		return 1;
+	}
+
+	tlv = emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F27_CRYPTOGRAM_INFORMATION_DATA);
+	if (!tlv || tlv->length != 1 ||
+		(tlv->value[0] & EMV_CID_APPLICATION_CRYPTOGRAM_TYPE_MASK) != EMV_CID_APPLICATION_CRYPTOGRAM_TYPE_AAC
+	) {
+		fprintf(stderr, "Invalid Cryptogram Information Data\n");
+		print_emv_tlv_list(&ctx->icc);
+		return 1;
+	}
+
+	tlv = emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F36_APPLICATION_TRANSACTION_COUNTER);
+	if (!tlv || tlv->length != 2 ||
+		tlv->value[0] != (icc->atc >> 8) || tlv->value[1] != (icc->atc & 0xFF)
+	) {
+		fprintf(stderr, "Invalid Application Transaction Counter\n");
+		print_emv_tlv_list(&ctx->icc);
+		return 1;
+	}
+
+	tlv = emv_tlv_list_find_const(&ctx->icc, EMV_TAG_9F26_APPLICATION_CRYPTOGRAM);
+	if (!tlv || tlv->length != 8) {
+		fprintf(stderr, "Invalid Application Cryptogram\n");
+		print_emv_tlv_list(&ctx->icc);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	int r;
+	struct emv_virtual_icc_t icc;
+	struct emv_ttl_t ttl;
+	struct emv_ctx_t emv;
+	struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+	const struct emv_tlv_t* tlv;
+	const struct emv_tlv_t* un;
+	struct emv_pki_key_t ca_key;
+	struct emv_pki_key_t issuer_key;
+	uint8_t capk_hash[20];
+	struct emv_capk_t capk;
+	struct emv_rsa_icc_pkey_t icc_pkey;
+	struct emv_rsa_sdad_t sdad;
+	uint8_t r_apdu[EMV_RAPDU_MAX];
+	size_t r_apdu_len;
+	unsigned int soak_count = 1000;
+	uint16_t atc;
+	double start;
+	double elapsed;
+
+	if (argc > 1) {
+		// Allow long soak runs from the command line
+		soak_count = strtoul(argv[1], NULL, 0);
+	}
+
+	r = prepare_pki(&ca_key, &issuer_key, capk_hash, &capk);
+	if (r) {
+		emv_capk_clear();
+		return 1;
+	}
+
+	r = emv_virtual_icc_init(&icc, &test_profile);
+	if (r) {
+		fprintf(stderr, "emv_virtual_icc_init() failed; r=%d\n", r);
+		return 1;
+	}
+	ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+	ttl.cardreader.ctx = &icc;
+	ttl.cardreader.trx = &emv_virtual_icc_trx;
+
+	r = prepare_ctx(&emv, &ttl);
+	if (r) {
+		goto exit;
+	}
+
+	r = emv_debug_init(
+		EMV_DEBUG_SOURCE_ALL,
+		EMV_DEBUG_LEVEL_CARD,
+		&print_emv_debug
+	);
+	if (r) {
+		printf("Failed to initialise EMV debugging\n");
+		goto exit;
+	}
+
+	printf("\nTest 1: Unmodified kernel transaction with certificates...\n");
+	r = run_until_card_action_analysis(&emv);
+	if (r) {
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&emv.icc, EMV_TAG_9F13_LAST_ONLINE_ATC_REGISTER);
+	if (!tlv || tlv->length != 2 || tlv->value[1] != 0x0E) {
+		fprintf(stderr, "Last Online ATC Register not obtained by velocity checking\n");
+		r = 1;
+		goto exit;
+	}
+	if (emv.oda.method != EMV_ODA_METHOD_CDA ||
+		(emv.tvr->value[0] & EMV_TVR_CDA_FAILED)
+	) {
+		// CDA must be selected and the ICC public key retrieved
+		fprintf(stderr, "CDA not selected or failed\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_card_action_analysis(&emv);
+	if (r) {
+		fprintf(stderr, "emv_card_action_analysis() failed; r=%d\n", r);
+		goto exit;
+	}
+	r = verify_genac(&emv, &icc);
+	if (r) {
+		goto exit;
+	}
+	if (icc.atc != 0x0011) {
+		fprintf(stderr, "Incorrect virtual ICC ATC 0x%04X\n", icc.atc);
+		r = 1;
+		goto exit;
+	}
+	if (emv.stats.cmd[EMV_TTL_CMD_SELECT].count == 0 ||
+		emv.stats.cmd[EMV_TTL_CMD_READ_RECORD].count == 0 ||
+		emv.stats.cmd[EMV_TTL_CMD_GPO].count != 1 ||
+		emv.stats.cmd[EMV_TTL_CMD_GET_DATA].count == 0 ||
+		emv.stats.cmd[EMV_TTL_CMD_GENAC].count != 1
+	) {
+		fprintf(stderr, "Incorrect TTL command statistics\n");
+		r = 1;
+		goto exit;
+	}
+	for (unsigned int i = 0; i < EMV_TTL_CMD_COUNT; ++i) {
+		// Virtual ICC responds in APDU mode without GET RESPONSE
+		if (emv.stats.cmd[i].exchange_count != emv.stats.cmd[i].count ||
+			emv.stats.cmd[i].get_response_count != 0 ||
+			emv.stats.cmd[i].error_count != 0
+		) {
+			fprintf(stderr, "Incorrect %s statistics\n", emv_ttl_cmd_get_string(i));
+			r = 1;
+			goto exit;
+		}
+	}
+	printf("Success\n");
+
+	printf("\nTest 2: INTERNAL AUTHENTICATE with Signed Dynamic Application Data...\n");
+	un = emv_tlv_list_find_const(&emv.terminal, EMV_TAG_9F37_UNPREDICTABLE_NUMBER);
+	if (!un) {
+		fprintf(stderr, "Unpredictable Number not found\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_tal_internal_authenticate(emv.ttl, un->value, un->length, &list);
+	if (r) {
+		fprintf(stderr, "emv_tal_internal_authenticate() failed; r=%d\n", r);
+		goto exit;
+	}
+	tlv = emv_tlv_list_find_const(&list, EMV_TAG_9F4B_SIGNED_DYNAMIC_APPLICATION_DATA);
+	if (!tlv) {
+		fprintf(stderr, "SDAD not found\n");
+		r = 1;
+		goto exit;
+	}
+	memset(&icc_pkey, 0, sizeof(icc_pkey));
+	icc_pkey.modulus_len = sizeof(test_icc_modulus);
+	memcpy(icc_pkey.modulus, test_icc_modulus, sizeof(test_icc_modulus));
+	icc_pkey.exponent_len = 1;
+	icc_pkey.exponent[0] = 0x03;
+	r = emv_rsa_retrieve_sdad(tlv->value, tlv->length, &icc_pkey, un->value, un->length, &sdad);
+	if (r) {
+		fprintf(stderr, "emv_rsa_retrieve_sdad() failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	if (sdad.icc_dynamic_number_len != 4) {
+		fprintf(stderr, "Incorrect ICC Dynamic Number length %u\n", sdad.icc_dynamic_number_len);
+		r = 1;
+		goto exit;
+	}
+	// Hash validation must fail for different DDOL data
+	r = emv_rsa_retrieve_sdad(tlv->value, tlv->length, &icc_pkey, "asdf", 4, &sdad);
+	if (r <= 0) {
+		fprintf(stderr, "emv_rsa_retrieve_sdad() did not detect invalid hash; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	emv_tlv_list_clear(&list);
+	printf("Success\n");
+
+	printf("\nTest 3: Unmodified kernel card action analysis with CDA...\n");
+	r = emv_ctx_reset(&emv);
+	if (r) {
+		fprintf(stderr, "emv_ctx_reset() failed; r=%d\n", r);
+		goto exit;
+	}
+	emv_virtual_icc_reset(&icc);
+	r = run_until_card_action_analysis(&emv);
+	if (r) {
+		goto exit;
+	}
+	// ICC public key must be retrieved from the certificates during ODA
+	if (emv.oda.icc_pkey.modulus_len != sizeof(test_icc_modulus) ||
+		memcmp(emv.oda.icc_pkey.modulus, test_icc_modulus, sizeof(test_icc_modulus)) != 0
+	) {
+		fprintf(stderr, "Incorrect ICC public key retrieved during ODA\n");
+		r = 1;
+		goto exit;
+	}
+	r = emv_card_action_analysis(&emv);
+	if (r) {
+		fprintf(stderr, "emv_card_action_analysis() failed; r=%d\n", r);
+		goto exit;
+	}
+	if (emv.tvr->value[0] & EMV_TVR_CDA_FAILED) {
+		fprintf(stderr, "CDA failed\n");
+		r = 1;
+		goto exit;
+	}
+	r = verify_genac(&emv, &icc);
+	if (r) {
+		goto exit;
+	}
+	if (!emv_tlv_list_find_const(&emv.icc, EMV_TAG_9F4C_ICC_DYNAMIC_NUMBER)) {
+		fprintf(stderr, "ICC Dynamic Number not found\n");
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 4: Card responses outside of the transaction flow...\n");
+	emv_virtual_icc_reset(&icc);
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x80, 0xAE, 0x40, 0x00, 0x01, 0x00, 0x00 }, 7, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != 2 || r_apdu[0] != 0x69 || r_apdu[1] != 0x85) {
+		fprintf(stderr, "GENERATE AC without application not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x05, 0xA0, 0x00, 0x00, 0x00, 0x04, 0x00 }, 11, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != 2 || r_apdu[0] != 0x6A || r_apdu[1] != 0x82) {
+		fprintf(stderr, "SELECT of unknown application not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x00, 0xA4, 0x04, 0x00, 0x05, 0xA0, 0x00, 0x00, 0x00, 0x03, 0x00 }, 11, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != sizeof(test_app_fci) + 2 || memcmp(r_apdu, test_app_fci, sizeof(test_app_fci)) != 0) {
+		fprintf(stderr, "SELECT using partial AID failed; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x00, 0xB2, 0x05, 0x0C, 0x00 }, 5, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != 2 || r_apdu[0] != 0x6A || r_apdu[1] != 0x83) {
+		fprintf(stderr, "READ RECORD of unknown record not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x80, 0xCA, 0x9F, 0x4F, 0x00 }, 5, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != 2 || r_apdu[0] != 0x6A || r_apdu[1] != 0x88) {
+		fprintf(stderr, "GET DATA of unknown field not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	r_apdu_len = sizeof(r_apdu);
+	r = emv_virtual_icc_trx(&icc, (uint8_t[]){ 0x00, 0x20, 0x00, 0x80, 0x00 }, 5, r_apdu, &r_apdu_len);
+	if (r || r_apdu_len != 2 || r_apdu[0] != 0x6D || r_apdu[1] != 0x00) {
+		fprintf(stderr, "Unsupported instruction not rejected; r=%d\n", r);
+		r = 1;
+		goto exit;
+	}
+	printf("Success\n");
+
+	printf("\nTest 5: Soak test of %u transactions...\n", soak_count);
+	emv_debug_init(EMV_DEBUG_SOURCE_NONE, EMV_DEBUG_LEVEL_NONE, NULL);
+	atc = icc.atc;
+	start = now_ns();
+	for (unsigned int i = 0; i < soak_count; ++i) {
+		r = emv_ctx_reset(&emv);
+		if (r) {
+			fprintf(stderr, "emv_ctx_reset() failed; r=%d\n", r);
+			goto exit;
+		}
+		emv_virtual_icc_reset(&icc);
+
+		r = run_until_card_action_analysis(&emv);
+		if (r) {
+			fprintf(stderr, "Transaction %u failed\n", i);
+			goto exit;
+		}
+		r = emv_card_action_analysis(&emv);
+		if (r) {
+			fprintf(stderr, "emv_card_action_analysis() failed; r=%d\n", r);
+			fprintf(stderr, "Transaction %u failed\n", i);
+			goto exit;
+		}
+		r = verify_genac(&emv, &icc);
+		if (r) {
+			fprintf(stderr, "Transaction %u failed\n", i);
+			goto exit;
+		}
+	}
+	elapsed = now_ns() - start;
+	if (icc.atc != (uint16_t)(atc + soak_count)) {
+		fprintf(stderr, "Incorrect virtual ICC ATC 0x%04X\n", icc.atc);
+		r = 1;
+		goto exit;
+	}
+	if (soak_count) {
+		printf("%u transactions, %lu commands in %.3f ms (%.0f transactions/s)\n",
+			soak_count,
+			icc.command_count,
+			elapsed / 1e6,
+			soak_count / (elapsed / 1e9)
+		);
+	}
+	printf("Success\n");
+
+	// Success
+	r = 0;
+	goto exit;
+
+exit:
+	emv_tlv_list_clear(&list);
+	emv_ctx_clear(&emv);
+	emv_capk_clear();
+
+	return r;
+}
@@ -2,7 +2,7 @@
  * @file isocodes_test.c
  * @brief Various tests related to iso-codes package
  *
- * Copyright 2021, 2023 Leon Lynch
+ * Copyright 2021, 2023, 2026 Leon Lynch
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -20,6 +20,7 @@
  */
 
 #include "isocodes_lookup.h"
+#include "emv_utils_config.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -43,6 +44,17 @@ int main(void)
 	printf("%s\n", dgettext("iso_3166-3", "710")); // Cannot resolve numeric codes via libintl
 #endif
 
+	// Data should be loaded upon first lookup without explicit initialisation
+	country = isocodes_lookup_country_by_alpha2("NL");
+	if (!country) {
+		fprintf(stderr, "isocodes_lookup_country_by_alpha2() failed without isocodes_init()\n");
+		return 1;
+	}
+	if (strcmp(country, "Netherlands") != 0) {
+		fprintf(stderr, "isocodes_lookup_country_by_alpha2() found unexpected country '%s'\n", country);
+		return 1;
+	}
+
 	r = isocodes_init(NULL);
 	if (r) {
 		fprintf(stderr, "isocodes_init() failed; r=%d\n", r);
@@ -119,6 +131,61 @@ int main(void)
 		return 1;
 	}
 
+	country = isocodes_lookup_country_by_numeric(4);
+	if (!country) {
+		fprintf(stderr, "isocodes_lookup_country_by_numeric() failed\n");
+		return 1;
+	}
+	if (strcmp(country, "Afghanistan") != 0) {
+		fprintf(stderr, "isocodes_lookup_country_by_numeric() found unexpected country '%s'\n", country);
+		return 1;
+	}
+
+	country = isocodes_lookup_country_by_numeric(1528);
+	if (country) {
+		fprintf(stderr, "isocodes_lookup_country_by_numeric() found unexpected country '%s'\n", country);
+		return 1;
+	}
+
+	country = isocodes_lookup_country_by_alpha2("NLD");
+	if (country) {
+		fprintf(stderr, "isocodes_lookup_country_by_alpha2() found unexpected country '%s'\n", country);
+		return 1;
+	}
+
+	country = isocodes_lookup_country_by_alpha3("NL");
+	if (country) {
+		fprintf(stderr, "isocodes_lookup_country_by_alpha3() found unexpected country '%s'\n", country);
+		return 1;
+	}
+
+	currency = isocodes_lookup_currency_by_numeric(1);
+	if (currency) {
+		fprintf(stderr, "isocodes_lookup_currency_by_numeric() found unexpected currency '%s'\n", currency);
+		return 1;
+	}
+
+#ifdef EMV_STRINGS_BUILTIN_DATA
+	// Built-in data is used by default; explicit path should parse JSON files
+	r = isocodes_init(ISOCODES_JSON_PATH);
+	if (r) {
+		fprintf(stderr, "isocodes_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	country = isocodes_lookup_country_by_numeric(528);
+	if (!country || strcmp(country, "Netherlands") != 0) {
+		fprintf(stderr, "isocodes_lookup_country_by_numeric() failed for JSON data\n");
+		return 1;
+	}
+
+	language = isocodes_lookup_language_by_alpha3("frr");
+	if (!language || strcmp(language, "Northern Frisian") != 0) {
+		fprintf(stderr, "isocodes_lookup_language_by_alpha3() failed for JSON data\n");
+		return 1;
+	}
+#endif
+
 	printf("Success\n");
 
 	return 0;
@@ -2,7 +2,7 @@
  * @file mcc_test.c
  * @brief Unit tests for Merchant Category Code (MCC) lookups
  *
- * Copyright 2023 Leon Lynch
+ * Copyright 2023, 2026 Leon Lynch
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -31,6 +31,38 @@ int main(void)
 	const char* mcc_str;
 
 	// Let unit tests use build path, not install path, for JSON file
+	mcc_init_lazy(MCC_JSON_BUILD_PATH);
+
+	// Data should be loaded upon first lookup
+	mcc_str = mcc_lookup(5999);
+	if (!mcc_str) {
+		fprintf(stderr, "mcc_lookup() failed after mcc_init_lazy()\n");
+		return 1;
+	}
+	if (strcmp(mcc_str, "Miscellaneous and Specialty Retail Stores") != 0) {
+		fprintf(stderr, "mcc_lookup() found unexpected MCC '%s'\n", mcc_str);
+		return 1;
+	}
+	r = mcc_get_load_result();
+	if (r) {
+		fprintf(stderr, "mcc_get_load_result() failed; r=%d\n", r);
+		return 1;
+	}
+
+	// Failure to load upon first lookup should be available to the caller
+	mcc_init_lazy(MCC_JSON_BUILD_PATH ".missing");
+	r = mcc_get_load_result();
+	if (r) {
+		fprintf(stderr, "mcc_get_load_result() found unexpected result before lookup; r=%d\n", r);
+		return 1;
+	}
+	mcc_lookup(5999);
+	r = mcc_get_load_result();
+	if (r <= 0) {
+		fprintf(stderr, "mcc_get_load_result() found unexpected result after lookup; r=%d\n", r);
+		return 1;
+	}
+
 	r = mcc_init(MCC_JSON_BUILD_PATH);
 	if (r) {
 		fprintf(stderr, "mcc_init() failed; r=%d\n", r);
@@ -69,6 +101,41 @@ int main(void)
 		return 1;
 	}
 
+#ifdef EMV_STRINGS_BUILTIN_DATA
+	// Default path should use built-in data generated at build time
+	r = mcc_init(NULL);
+	if (r) {
+		fprintf(stderr, "mcc_init() failed; r=%d\n", r);
+		return 1;
+	}
+
+	mcc_str = mcc_lookup(0);
+	if (mcc_str) {
+		fprintf(stderr, "mcc_lookup() found unexpected MCC '%s'\n", mcc_str);
+		return 1;
+	}
+
+	mcc_str = mcc_lookup(5999);
+	if (!mcc_str) {
+		fprintf(stderr, "mcc_lookup() failed for built-in data\n");
+		return 1;
+	}
+	if (strcmp(mcc_str, "Miscellaneous and Specialty Retail Stores") != 0) {
+		fprintf(stderr, "mcc_lookup() found unexpected MCC '%s'\n", mcc_str);
+		return 1;
+	}
+
+	mcc_str = mcc_lookup(7629);
+	if (!mcc_str) {
+		fprintf(stderr, "mcc_lookup() failed for built-in data\n");
+		return 1;
+	}
+	if (strcmp(mcc_str, "Electrical And Small Appliance Repair Shops") != 0) {
+		fprintf(stderr, "mcc_lookup() found unexpected MCC '%s'\n", mcc_str);
+		return 1;
+	}
+#endif
+
 	printf("Success\n");
 
 	return 0;
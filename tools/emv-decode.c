@@ -21,6 +21,8 @@
 #include "emv.h"
 #include "emv_capk.h"
 #include "emv_strings.h"
+#include "emv_tlv.h"
+#include "emv_trace.h"
 #include "iso7816.h"
 #include "print_helpers.h"
 #include "isocodes_lookup.h"
@@ -44,6 +46,7 @@
 static error_t argp_parser_helper(int key, char* arg, struct argp_state* state);
 static int parse_hex(const char* hex, void* buf, size_t* buf_len);
 static void* load_from_file(FILE* file, size_t* len);
+static int decode_trace(FILE* file);
 
 // Input data
 static uint8_t* data = NULL;
@@ -79,6 +82,7 @@ enum emv_decode_mode_t {
 	EMV_DECODE_ISO3166_1,
 	EMV_DECODE_ISO4217,
 	EMV_DECODE_ISO639,
+	EMV_DECODE_TRACE,
 	EMV_DECODE_ISO8859_X,
 	EMV_DECODE_ISO8859_1,
 	EMV_DECODE_ISO8859_2,
@@ -160,6 +164,8 @@ static struct argp_option argp_options[] = {
 	{ "language", EMV_DECODE_ISO639, NULL, 0, "Lookup language name by ISO 639 alpha-2 or alpha-3 code" },
 	{ "iso639", EMV_DECODE_ISO639, NULL, OPTION_ALIAS },
 
+	{ "trace", EMV_DECODE_TRACE, NULL, 0, "Decode binary debug trace. INPUT is the trace file path or \"-\" to read from stdin" },
+
 	{ "iso8859-x", EMV_DECODE_ISO8859_X, NULL, 0, "Decode INPUT as ISO8859 using the code page specified by 'x' and print as UTF-8" },
 	{ "iso8859-1", EMV_DECODE_ISO8859_1, NULL, OPTION_HIDDEN },
 	{ "iso8859-2", EMV_DECODE_ISO8859_2, NULL, OPTION_HIDDEN },
@@ -178,7 +184,7 @@ static struct argp_option argp_options[] = {
 	{ "iso8859-15", EMV_DECODE_ISO8859_15, NULL, OPTION_HIDDEN },
 
 	{ "ignore-padding", EMV_DECODE_IGNORE_PADDING, NULL, 0, "Ignore invalid data if the input aligns with either the DES or AES cipher block size and invalid data is less than the cipher block size. Only applies to --ber and --tlv" },
-	{ "verbose", EMV_DECODE_VERBOSE, NULL, 0, "Enable verbose output. This will prevent the truncation of content bytes for longer fields. Only applies to --ber and --tlv" },
+	{ "verbose", EMV_DECODE_VERBOSE, NULL, 0, "Enable verbose output. This will prevent the truncation of content bytes for longer fields. Only applies to --ber, --tlv and --trace" },
 
 	{ "version", EMV_DECODE_VERSION, NULL, 0, "Display emv-utils version" },
 
@@ -216,6 +222,12 @@ static error_t argp_parser_helper(int key, char* arg, struct argp_state* state)
 				arg_str_len = strlen(arg);
 				return 0;
 			}
+			if (emv_decode_mode == EMV_DECODE_TRACE) {
+				// Debug trace is streamed from the file path or stdin in main()
+				arg_str = strdup(arg);
+				arg_str_len = strlen(arg);
+				return 0;
+			}
 
 			// Parse INPUT argument
 			size_t arg_len = strlen(arg);
@@ -283,6 +295,7 @@ static error_t argp_parser_helper(int key, char* arg, struct argp_state* state)
 		case EMV_DECODE_ISO3166_1:
 		case EMV_DECODE_ISO4217:
 		case EMV_DECODE_ISO639:
+		case EMV_DECODE_TRACE:
 		case EMV_DECODE_ISO8859_1:
 		case EMV_DECODE_ISO8859_2:
 		case EMV_DECODE_ISO8859_3:
@@ -434,6 +447,159 @@ static void* load_from_file(FILE* file, size_t* len)
 	return buf;
 }
 
+// Debug trace decoder helper function
+static int decode_trace(FILE* file)
+{
+	int r;
+	uint8_t header[EMV_TRACE_HEADER_LEN];
+	uint8_t* buf = NULL;
+	size_t buf_size = 0;
+	unsigned long event_count = 0;
+
+#ifdef _WIN32
+	_setmode(_fileno(file), _O_BINARY);
+#endif
+
+	if (fread(header, sizeof(header), 1, file) != 1) {
+		fprintf(stderr, "Failed to read debug trace header\n");
+		return -1;
+	}
+	r = emv_trace_header_decode(header, sizeof(header));
+	if (r < 0) {
+		fprintf(stderr, "Invalid debug trace header\n");
+		return -2;
+	}
+	if (r > 0) {
+		fprintf(stderr, "Unsupported debug trace version %u\n", header[sizeof(header) - 1]);
+		return -3;
+	}
+
+	// Stream events such that arbitrarily large traces can be decoded
+	while (true) {
+		int c;
+		size_t len;
+		struct emv_trace_event_t event;
+
+		c = fgetc(file);
+		if (c == EOF) {
+			// End of trace
+			r = 0;
+			break;
+		}
+		if (c != EMV_TRACE_TAG_EVENT) {
+			fprintf(stderr, "Invalid debug trace event %lu\n", event_count);
+			r = -4;
+			break;
+		}
+
+		// Decode BER length
+		c = fgetc(file);
+		if (c == EOF) {
+			fprintf(stderr, "Truncated debug trace event %lu\n", event_count);
+			r = -5;
+			break;
+		}
+		if (c & ISO8825_BER_LEN_LONG_FORM) {
+			unsigned int len_count = c & ISO8825_BER_LEN_LONG_FORM_COUNT_MASK;
+
+			if (!len_count || len_count > 4) {
+				fprintf(stderr, "Invalid debug trace event %lu length\n", event_count);
+				r = -6;
+				break;
+			}
+			len = 0;
+			while (len_count--) {
+				c = fgetc(file);
+				if (c == EOF) {
+					break;
+				}
+				len = (len << 8) | c;
+			}
+			if (c == EOF) {
+				fprintf(stderr, "Truncated debug trace event %lu\n", event_count);
+				r = -5;
+				break;
+			}
+		} else {
+			len = c;
+		}
+
+		if (len > buf_size) {
+			uint8_t* new_buf = realloc(buf, len);
+			if (!new_buf) {
+				fprintf(stderr, "Failed to allocate %zu bytes for debug trace event %lu\n", len, event_count);
+				r = -7;
+				break;
+			}
+			buf = new_buf;
+			buf_size = len;
+		}
+		if (len && fread(buf, len, 1, file) != 1) {
+			fprintf(stderr, "Truncated debug trace event %lu\n", event_count);
+			r = -5;
+			break;
+		}
+
+		r = emv_trace_event_decode(buf, len, &event);
+		if (r) {
+			fprintf(stderr, "Failed to decode debug trace event %lu; r=%d\n", event_count, r);
+			r = -8;
+			break;
+		}
+		++event_count;
+
+		if (event.debug_type == EMV_DEBUG_TYPE_TLV_LIST) {
+			// Rebuild EMV TLV list for print helpers
+			struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
+
+			if (event.data_len) {
+				r = emv_tlv_parse(event.data, event.data_len, &list);
+				if (r) {
+					fprintf(stderr, "Failed to parse EMV TLV list of debug trace event %lu; r=%d\n", event_count - 1, r);
+					emv_tlv_list_clear(&list);
+					r = -9;
+					break;
+				}
+			}
+			if (verbose) {
+				print_emv_debug_verbose(event.timestamp, event.source, event.level, event.debug_type, event.str, &list, sizeof(list));
+			} else {
+				print_emv_debug(event.timestamp, event.source, event.level, event.debug_type, event.str, &list, sizeof(list));
+			}
+			emv_tlv_list_clear(&list);
+
+		} else if (event.debug_type == EMV_DEBUG_TYPE_ATR) {
+			// Rebuild ATR info for print helpers
+			struct iso7816_atr_info_t atr_info;
+
+			r = iso7816_atr_parse(event.data, event.data_len, &atr_info);
+			if (r) {
+				fprintf(stderr, "Failed to parse ATR of debug trace event %lu; r=%d\n", event_count - 1, r);
+				r = -10;
+				break;
+			}
+			if (verbose) {
+				print_emv_debug_verbose(event.timestamp, event.source, event.level, event.debug_type, event.str, &atr_info, sizeof(atr_info));
+			} else {
+				print_emv_debug(event.timestamp, event.source, event.level, event.debug_type, event.str, &atr_info, sizeof(atr_info));
+			}
+
+		} else {
+			if (verbose) {
+				print_emv_debug_verbose(event.timestamp, event.source, event.level, event.debug_type, event.str, event.data, event.data_len);
+			} else {
+				print_emv_debug(event.timestamp, event.source, event.level, event.debug_type, event.str, event.data, event.data_len);
+			}
+		}
+	}
+
+	if (buf) {
+		free(buf);
+	}
+
+	return r;
+}
+
 int main(int argc, char** argv)
 {
 	int r;
@@ -459,13 +625,19 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 
-	r = emv_strings_init(isocodes_path, mcc_json);
-	if (r < 0) {
-		fprintf(stderr, "Failed to initialise EMV strings\n");
-		return EXIT_FAILURE;
-	}
-	if (r > 0) {
-		fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups may not be possible\n");
+	if (isocodes_path || mcc_json) {
+		// Load overridden data immediately to report errors
+		r = emv_strings_init(isocodes_path, mcc_json);
+		if (r < 0) {
+			fprintf(stderr, "Failed to initialise EMV strings\n");
+			return EXIT_FAILURE;
+		}
+		if (r > 0) {
+			fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups may not be possible\n");
+		}
+	} else {
+		// Load default data upon first use to avoid startup delay
+		emv_strings_init_lazy(NULL, NULL);
 	}
 
 	switch (emv_decode_mode) {
@@ -521,7 +693,7 @@ int main(int argc, char** argv)
 			// Cache all available fields for better output
 			struct emv_tlv_list_t list = EMV_TLV_LIST_INIT;
 			const struct emv_tlv_sources_t sources = { 1, { &list } };
-			emv_tlv_parse(data, data_len, &list);
+			emv_tlv_parse_borrowed(data, data_len, &list);
 			print_set_sources(&sources);
 
 			// Actual output
@@ -957,6 +1129,32 @@ int main(int argc, char** argv)
 			break;
 		}
 
+		case EMV_DECODE_TRACE: {
+			FILE* file;
+
+			if (arg_str_len == 1 && *arg_str == '-') {
+				file = stdin;
+			} else {
+				file = fopen(arg_str, "rb");
+				if (!file) {
+					fprintf(stderr, "Failed to open \"%s\"\n", arg_str);
+					ret = EXIT_FAILURE;
+					break;
+				}
+			}
+
+			r = decode_trace(file);
+			if (r) {
+				ret = EXIT_FAILURE;
+			}
+
+			if (file != stdin) {
+				fclose(file);
+			}
+
+			break;
+		}
+
 		case EMV_DECODE_ISO8859_1:
 		case EMV_DECODE_ISO8859_2:
 		case EMV_DECODE_ISO8859_3:
@@ -1004,6 +1202,14 @@ int main(int argc, char** argv)
 			break;
 	}
 
+	if (!isocodes_path && !mcc_json) {
+		// Report failure to load default data upon first use
+		r = emv_strings_get_load_result();
+		if (r) {
+			fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups were not possible\n");
+		}
+	}
+
 	if (data) {
 		free(data);
 	}
@@ -0,0 +1,514 @@
+/**
+ * @file emv-pki.c
+ * @brief Tool for generating EMV test keys and certificates
+ *
+ * Copyright 2026 Leon Lynch
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "emv.h"
+#include "emv_capk.h"
+#include "emv_pki.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <argp.h>
+
+// Helper functions
+static error_t argp_parser_helper(int key, char* arg, struct argp_state* state);
+static int parse_hex(const char* hex, void* buf, size_t* buf_len);
+static int parse_modulus_bits(const char* str, size_t* modulus_len);
+static int pan_to_bcd(const char* pan, uint8_t* bcd);
+static void pan_increment(char* pan);
+static void print_hex(const void* buf, size_t len);
+static void print_tlv(const char* name, uint16_t tag, const void* value, size_t len);
+
+// Parameters
+static size_t ca_modulus_len = 1408 / 8;
+static size_t issuer_modulus_len = 1152 / 8;
+static size_t icc_modulus_len = 1024 / 8;
+static uint32_t exponent = 3;
+static uint8_t rid[EMV_CAPK_RID_LEN] = { 0xA0, 0x00, 0x00, 0x09, 0x99 };
+static uint8_t capk_index = 0xF1;
+static char pan[20] = "4761739001010010";
+static uint8_t cert_exp[2] = { 0x12, 0x49 };
+static uint8_t* static_data = NULL;
+static size_t static_data_len = 0;
+static size_t card_count = 1;
+static unsigned int thread_count = 1;
+
+enum emv_pki_option_t {
+	EMV_PKI_CA_BITS = -255, // Negative value to avoid short options
+	EMV_PKI_ISSUER_BITS,
+	EMV_PKI_ICC_BITS,
+	EMV_PKI_EXPONENT,
+	EMV_PKI_RID,
+	EMV_PKI_INDEX,
+	EMV_PKI_PAN,
+	EMV_PKI_CERT_EXP,
+	EMV_PKI_STATIC_DATA,
+	EMV_PKI_COUNT,
+	EMV_PKI_THREADS,
+	EMV_PKI_VERSION,
+};
+
+// argp option structure
+static struct argp_option argp_options[] = {
+	{ NULL, 0, NULL, 0, "Keys:", 1 },
+	{ "ca-bits", EMV_PKI_CA_BITS, "BITS", 0, "Certificate Authority (CA) modulus length in bits. Default is 1408." },
+	{ "issuer-bits", EMV_PKI_ISSUER_BITS, "BITS", 0, "Issuer modulus length in bits. Default is 1152." },
+	{ "icc-bits", EMV_PKI_ICC_BITS, "BITS", 0, "ICC modulus length in bits. Default is 1024." },
+	{ "exponent", EMV_PKI_EXPONENT, "3|65537", 0, "Public exponent for all keys. Default is 3." },
+
+	{ NULL, 0, NULL, 0, "Certificates:", 2 },
+	{ "rid", EMV_PKI_RID, "RID", 0, "Registered Application Provider Identifier (RID) of CAPK. Default is A000000999." },
+	{ "index", EMV_PKI_INDEX, "XX", 0, "CAPK index as two hex digits. Default is F1." },
+	{ "pan", EMV_PKI_PAN, "PAN", 0, "Application PAN of first card. Subsequent cards use consecutive account numbers. Default is 4761739001010010." },
+	{ "cert-exp", EMV_PKI_CERT_EXP, "MMYY", 0, "Certificate expiration date. Default is 1249." },
+	{ "static-data", EMV_PKI_STATIC_DATA, "HEX", 0, "Static data to be authenticated by ICC public key certificates. Default is none." },
+
+	{ NULL, 0, NULL, 0, "Batch:", 3 },
+	{ "count", EMV_PKI_COUNT, "N", 0, "Number of cards for which to generate ICC keys and certificates. Default is 1." },
+	{ "threads", EMV_PKI_THREADS, "N", 0, "Number of worker threads. Default is 1." },
+
+	{ "version", EMV_PKI_VERSION, NULL, 0, "Display emv-utils version" },
+
+	{ 0 },
+};
+
+// argp configuration
+static struct argp argp_config = {
+	argp_options,
+	argp_parser_helper,
+	NULL,
+	"Generate EMV test CA, issuer and ICC keys and certificates for Offline Data Authentication (ODA) testing."
+	"\v" // Print remaining text after options
+	"The CAPK is printed in the emv-tool XML configuration format, followed by "
+	"the issuer and per-card fields as EMV TLV hex strings.\n\n"
+	"WARNING: Keys are printed in the clear and must only be used for testing.",
+};
+
+// argp parser helper function
+static error_t argp_parser_helper(int key, char* arg, struct argp_state* state)
+{
+	int r;
+	size_t len;
+	char* endptr;
+	unsigned long value;
+
+	switch (key) {
+		case EMV_PKI_CA_BITS:
+			if (parse_modulus_bits(arg, &ca_modulus_len)) {
+				argp_error(state, "Invalid CA modulus length");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_ISSUER_BITS:
+			if (parse_modulus_bits(arg, &issuer_modulus_len)) {
+				argp_error(state, "Invalid issuer modulus length");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_ICC_BITS:
+			if (parse_modulus_bits(arg, &icc_modulus_len)) {
+				argp_error(state, "Invalid ICC modulus length");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_EXPONENT:
+			value = strtoul(arg, &endptr, 10);
+			if (*endptr || (value != 3 && value != 65537)) {
+				argp_error(state, "Exponent must be 3 or 65537");
+				return EINVAL;
+			}
+			exponent = value;
+			return 0;
+
+		case EMV_PKI_RID:
+			len = sizeof(rid);
+			r = parse_hex(arg, rid, &len);
+			if (r || len != sizeof(rid)) {
+				argp_error(state, "RID must be 5 bytes (thus 10 hex digits)");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_INDEX:
+			len = sizeof(capk_index);
+			r = parse_hex(arg, &capk_index, &len);
+			if (r || len != sizeof(capk_index)) {
+				argp_error(state, "CAPK index must be 1 byte (thus 2 hex digits)");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_PAN: {
+			uint8_t bcd[10];
+
+			if (strlen(arg) >= sizeof(pan) || pan_to_bcd(arg, bcd)) {
+				argp_error(state, "PAN must consist of 12 to 19 digits");
+				return EINVAL;
+			}
+			strcpy(pan, arg);
+			return 0;
+		}
+
+		case EMV_PKI_CERT_EXP:
+			len = sizeof(cert_exp);
+			r = parse_hex(arg, cert_exp, &len);
+			if (r || len != sizeof(cert_exp) || strlen(arg) != 4) {
+				argp_error(state, "Certificate expiration date must be 4 digits (MMYY)");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_STATIC_DATA:
+			static_data_len = (strlen(arg) + 1) / 2;
+			static_data = malloc(static_data_len);
+			r = parse_hex(arg, static_data, &static_data_len);
+			if (r) {
+				argp_error(state, "Static data must consist of an even number of hex digits");
+				return EINVAL;
+			}
+			return 0;
+
+		case EMV_PKI_COUNT:
+			value = strtoul(arg, &endptr, 10);
+			if (*endptr || !value) {
+				argp_error(state, "Invalid count");
+				return EINVAL;
+			}
+			card_count = value;
+			return 0;
+
+		case EMV_PKI_THREADS:
+			value = strtoul(arg, &endptr, 10);
+			if (*endptr || !value || value > 1024) {
+				argp_error(state, "Invalid number of threads");
+				return EINVAL;
+			}
+			thread_count = value;
+			return 0;
+
+		case EMV_PKI_VERSION: {
+			const char* version;
+
+			version = emv_lib_version_string();
+			if (version) {
+				printf("%s\n", version);
+			} else {
+				printf("Unknown\n");
+			}
+			exit(EXIT_SUCCESS);
+			return 0;
+		}
+
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+}
+
+// Hex parser helper function
+static int parse_hex(const char* hex, void* buf, size_t* buf_len)
+{
+	size_t max_buf_len;
+	uint8_t* ptr = buf;
+
+	if (!buf_len) {
+		return -1;
+	}
+	max_buf_len = *buf_len;
+	*buf_len = 0;
+
+	while (*hex) {
+		char str[3];
+
+		if (!isxdigit(hex[0]) || !isxdigit(hex[1])) {
+			return -2;
+		}
+		if (*buf_len >= max_buf_len) {
+			return -3;
+		}
+		str[0] = hex[0];
+		str[1] = hex[1];
+		str[2] = 0;
+
+		*ptr = strtoul(str, NULL, 16);
+		++ptr;
+		++*buf_len;
+		hex += 2;
+	}
+
+	return 0;
+}
+
+static int parse_modulus_bits(const char* str, size_t* modulus_len)
+{
+	char* endptr;
+	unsigned long bits;
+
+	bits = strtoul(str, &endptr, 10);
+	if (*endptr || bits % 8 ||
+		bits / 8 < EMV_PKI_MODULUS_MIN ||
+		bits / 8 > EMV_PKI_MODULUS_MAX
+	) {
+		return -1;
+	}
+
+	*modulus_len = bits / 8;
+	return 0;
+}
+
+static int pan_to_bcd(const char* pan, uint8_t* bcd)
+{
+	size_t len = strlen(pan);
+
+	if (len < 12 || len > 19) {
+		return -1;
+	}
+
+	memset(bcd, 0xFF, 10);
+	for (size_t i = 0; i < len; ++i) {
+		if (!isdigit(pan[i])) {
+			return -2;
+		}
+		if (i & 1) {
+			bcd[i / 2] = (bcd[i / 2] & 0xF0) | (pan[i] - '0');
+		} else {
+			bcd[i / 2] = ((pan[i] - '0') << 4) | 0x0F;
+		}
+	}
+
+	return 0;
+}
+
+// Increment account number and update Luhn check digit
+static void pan_increment(char* pan)
+{
+	size_t len = strlen(pan);
+	unsigned int sum = 0;
+
+	for (size_t i = len - 1; i > 0; --i) {
+		if (pan[i - 1] != '9') {
+			++pan[i - 1];
+			break;
+		}
+		pan[i - 1] = '0';
+	}
+
+	for (size_t i = 0; i < len - 1; ++i) {
+		unsigned int digit = pan[len - 2 - i] - '0';
+		if ((i & 1) == 0) {
+			digit *= 2;
+			if (digit > 9) {
+				digit -= 9;
+			}
+		}
+		sum += digit;
+	}
+	pan[len - 1] = '0' + (10 - (sum % 10)) % 10;
+}
+
+static void print_hex(const void* buf, size_t len)
+{
+	const uint8_t* ptr = buf;
+
+	for (size_t i = 0; i < len; ++i) {
+		printf("%02X", ptr[i]);
+	}
+}
+
+static void print_tlv(const char* name, uint16_t tag, const void* value, size_t len)
+{
+	printf("%s: ", name);
+	if (tag > 0xFF) {
+		printf("%04X", tag);
+	} else {
+		printf("%02X", tag);
+	}
+	if (len > 0xFF) {
+		printf("82%04zX", len);
+	} else if (len > 0x7F) {
+		printf("81%02zX", len);
+	} else {
+		printf("%02zX", len);
+	}
+	print_hex(value, len);
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	int r;
+	struct emv_pki_key_t ca_key;
+	struct emv_pki_key_t issuer_key;
+	struct emv_pki_cert_t issuer_cert;
+	struct emv_capk_t capk;
+	uint8_t capk_hash[20];
+	uint8_t issuer_id[4];
+	uint8_t bcd[10];
+	struct emv_pki_icc_request_t* requests;
+	struct timespec start;
+	struct timespec end;
+	double elapsed;
+
+	if (argc == 1) {
+		// No command line arguments
+		argp_help(&argp_config, stdout, ARGP_HELP_STD_HELP, argv[0]);
+		return 1;
+	}
+
+	r = argp_parse(&argp_config, argc, argv, 0, 0, 0);
+	if (r) {
+		fprintf(stderr, "Failed to parse command line\n");
+		return 1;
+	}
+
+	// Issuer identifier is the leftmost 8 digits of the PAN. Although EMV
+	// allows 3-8 digits, using 8 digits allows consecutive PANs to remain
+	// valid for the same issuer certificate.
+	pan_to_bcd(pan, bcd);
+	memcpy(issuer_id, bcd, sizeof(issuer_id));
+
+	r = emv_pki_generate_key(ca_modulus_len, exponent, &ca_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for CA key; r=%d\n", r);
+		return 1;
+	}
+	r = emv_pki_generate_key(issuer_modulus_len, exponent, &issuer_key);
+	if (r) {
+		fprintf(stderr, "emv_pki_generate_key() failed for issuer key; r=%d\n", r);
+		return 1;
+	}
+	r = emv_pki_populate_capk(&ca_key, rid, capk_index, capk_hash, &capk);
+	if (r) {
+		fprintf(stderr, "emv_pki_populate_capk() failed; r=%d\n", r);
+		return 1;
+	}
+	r = emv_pki_create_issuer_cert(
+		&ca_key,
+		issuer_id,
+		cert_exp,
+		(const uint8_t[]){ 0x00, 0x00, 0x01 },
+		&issuer_key,
+		&issuer_cert
+	);
+	if (r) {
+		fprintf(stderr, "emv_pki_create_issuer_cert() failed; r=%d\n", r);
+		return 1;
+	}
+
+	requests = calloc(card_count, sizeof(*requests));
+	if (!requests) {
+		fprintf(stderr, "Failed to allocate %zu requests\n", card_count);
+		return 1;
+	}
+	for (size_t i = 0; i < card_count; ++i) {
+		if (i) {
+			pan_increment(pan);
+		}
+		pan_to_bcd(pan, requests[i].pan);
+		memcpy(requests[i].cert_exp, cert_exp, sizeof(requests[i].cert_exp));
+		requests[i].cert_sn[0] = (i + 1) >> 16;
+		requests[i].cert_sn[1] = (i + 1) >> 8;
+		requests[i].cert_sn[2] = (i + 1);
+		requests[i].modulus_len = icc_modulus_len;
+		requests[i].exponent = exponent;
+		requests[i].static_data = static_data;
+		requests[i].static_data_len = static_data_len;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	r = emv_pki_create_icc_batch(&issuer_key, requests, card_count, thread_count);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (r < 0) {
+		fprintf(stderr, "emv_pki_create_icc_batch() failed; r=%d\n", r);
+		free(requests);
+		return 1;
+	}
+	elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "Generated %zu ICC keys and certificates in %.3f seconds using %u thread(s)",
+		card_count - r, elapsed, thread_count
+	);
+	if (r) {
+		fprintf(stderr, "; %d failed", r);
+	}
+	fprintf(stderr, "\n");
+
+	// CAPK in emv-tool XML configuration format
+	printf("<capk rid='");
+	print_hex(rid, sizeof(rid));
+	printf("' index='%02X' hash_id='%02X'>\n", capk.index, capk.hash_id);
+	printf("  <modulus>");
+	print_hex(ca_key.modulus, ca_key.modulus_len);
+	printf("</modulus>\n");
+	printf("  <exponent>");
+	print_hex(ca_key.exponent, ca_key.exponent_len);
+	printf("</exponent>\n");
+	printf("  <hash>");
+	print_hex(capk_hash, sizeof(capk_hash));
+	printf("</hash>\n");
+	printf("</capk>\n");
+
+	// Issuer fields common to all cards
+	print_tlv("CA Public Key Index", 0x8F, &capk_index, 1);
+	print_tlv("Issuer Public Key Certificate", 0x90, issuer_cert.cert, issuer_cert.cert_len);
+	if (issuer_cert.remainder_len) {
+		print_tlv("Issuer Public Key Remainder", 0x92, issuer_cert.remainder, issuer_cert.remainder_len);
+	}
+	print_tlv("Issuer Public Key Exponent", 0x9F32, issuer_key.exponent, issuer_key.exponent_len);
+
+	// Per-card fields
+	for (size_t i = 0; i < card_count; ++i) {
+		const struct emv_pki_icc_request_t* req = &requests[i];
+		size_t pan_len = 10;
+
+		printf("Card %zu:", i + 1);
+		if (req->result) {
+			printf(" failed; r=%d\n", req->result);
+			continue;
+		}
+		printf("\n");
+
+		while (pan_len && req->pan[pan_len - 1] == 0xFF) {
+			--pan_len;
+		}
+		print_tlv("Application PAN", 0x5A, req->pan, pan_len);
+		print_tlv("ICC Public Key Certificate", 0x9F46, req->cert.cert, req->cert.cert_len);
+		print_tlv("ICC Public Key Exponent", 0x9F47, req->icc_key.exponent, req->icc_key.exponent_len);
+		if (req->cert.remainder_len) {
+			print_tlv("ICC Public Key Remainder", 0x9F48, req->cert.remainder, req->cert.remainder_len);
+		}
+		printf("ICC Private Key Modulus: ");
+		print_hex(req->icc_key.modulus, req->icc_key.modulus_len);
+		printf("\nICC Private Key Exponent: ");
+		print_hex(req->icc_key.private_exponent, req->icc_key.modulus_len);
+		printf("\n");
+	}
+
+	free(requests);
+	free(static_data);
+
+	return r ? 1 : 0;
+}
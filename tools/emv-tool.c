@@ -29,12 +29,15 @@
 #include "emv_strings.h"
 #include "emv_tlv.h"
 #include "emv_app.h"
+#include "emv_transcript.h"
+#include "emv_trace.h"
 
 #define EMV_DEBUG_SOURCE EMV_DEBUG_SOURCE_APP
 #include "emv_debug.h"
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -50,6 +53,9 @@ static const char* pcsc_get_reader_state_string(unsigned int reader_state);
 static void print_pcsc_readers(pcsc_ctx_t pcsc);
 static void emv_txn_load_params(struct emv_ctx_t* emv, uint32_t txn_seq_cnt, uint8_t txn_type, uint32_t amount, uint32_t amount_other);
 static int emv_txn_load_config(struct emv_ctx_t* emv);
+static int save_transcript(const char* filename, const struct emv_transcript_recorder_t* recorder);
+static uint8_t* load_transcript(const char* filename, size_t* len);
+static void print_ttl_stats(const struct emv_ttl_stats_t* stats);
 
 // argp option keys
 enum emv_tool_param_t {
@@ -63,6 +69,10 @@ enum emv_tool_param_t {
 	EMV_TOOL_PARAM_DEBUG_VERBOSE,
 	EMV_TOOL_PARAM_DEBUG_SOURCES_MASK,
 	EMV_TOOL_PARAM_DEBUG_LEVEL,
+	EMV_TOOL_PARAM_DEBUG_RECORD,
+	EMV_TOOL_PARAM_DEBUG_REPLAY,
+	EMV_TOOL_PARAM_DEBUG_STATS,
+	EMV_TOOL_PARAM_DEBUG_TRACE,
 	EMV_TOOL_VERSION,
 	EMV_TOOL_OVERRIDE_ISOCODES_PATH,
 	EMV_TOOL_OVERRIDE_MCC_JSON,
@@ -85,6 +95,10 @@ static struct argp_option argp_options[] = {
 	{ "debug-verbose", EMV_TOOL_PARAM_DEBUG_VERBOSE, NULL, 0, "Enable verbose debug output. This will include the timestamp, debug source and debug level in the debug output." },
 	{ "debug-source", EMV_TOOL_PARAM_DEBUG_SOURCES_MASK, "x,y,z...", 0, "Comma separated list of debug sources. Allowed values are TTL, TAL, ODA, EMV, APP, ALL. Default is ALL." },
 	{ "debug-level", EMV_TOOL_PARAM_DEBUG_LEVEL, "LEVEL", 0, "Maximum debug level. Allowed values are NONE, ERROR, INFO, CARD, TRACE, ALL. Default is INFO." },
+	{ "debug-record", EMV_TOOL_PARAM_DEBUG_RECORD, "FILE", 0, "Record card reader transcript to file for later replay." },
+	{ "debug-replay", EMV_TOOL_PARAM_DEBUG_REPLAY, "FILE", 0, "Replay card reader transcript from file instead of using PC/SC. The recorded transaction date, time and unpredictable number are used but the configuration and other transaction parameters must match the recorded transaction." },
+	{ "debug-stats", EMV_TOOL_PARAM_DEBUG_STATS, NULL, 0, "Print card reader statistics and latency histograms per command after the transaction." },
+	{ "debug-trace", EMV_TOOL_PARAM_DEBUG_TRACE, "FILE", 0, "Write debug events to binary debug trace file instead of printing them. Use emv-decode --trace to decode the file." },
 
 	{ "version", EMV_TOOL_VERSION, NULL, 0, "Display emv-utils version" },
 
@@ -137,6 +151,12 @@ static const char* debug_level_str[] = {
 	"ALL",
 };
 static enum emv_debug_level_t debug_level = EMV_DEBUG_LEVEL_INFO;
+static char* debug_record_filename = NULL;
+static char* debug_replay_filename = NULL;
+static bool debug_stats = false;
+static char* debug_trace_filename = NULL;
+static FILE* debug_trace_file = NULL;
+static struct emv_trace_writer_t debug_trace_writer;
 
 // Testing parameters
 static char* isocodes_path = NULL;
@@ -330,6 +350,26 @@ static error_t argp_parser_helper(int key, char* arg, struct argp_state* state)
 			return EINVAL;
 		}
 
+		case EMV_TOOL_PARAM_DEBUG_RECORD: {
+			debug_record_filename = arg;
+			return 0;
+		}
+
+		case EMV_TOOL_PARAM_DEBUG_REPLAY: {
+			debug_replay_filename = arg;
+			return 0;
+		}
+
+		case EMV_TOOL_PARAM_DEBUG_STATS: {
+			debug_stats = true;
+			return 0;
+		}
+
+		case EMV_TOOL_PARAM_DEBUG_TRACE: {
+			debug_trace_filename = arg;
+			return 0;
+		}
+
 		case EMV_TOOL_VERSION: {
 			const char* version;
 
@@ -729,12 +769,139 @@ static int emv_txn_load_config(struct emv_ctx_t* emv)
 	return 0;
 }
 
+static int save_transcript(const char* filename, const struct emv_transcript_recorder_t* recorder)
+{
+	FILE* file;
+	size_t len;
+
+	if (recorder->incomplete) {
+		fprintf(stderr, "Card reader transcript is incomplete\n");
+	}
+
+	file = fopen(filename, "wb");
+	if (!file) {
+		fprintf(stderr, "Failed to open transcript file \"%s\"\n", filename);
+		return 1;
+	}
+	len = fwrite(recorder->data, 1, recorder->data_len, file);
+	fclose(file);
+	if (len != recorder->data_len) {
+		fprintf(stderr, "Failed to write transcript file \"%s\"\n", filename);
+		return 1;
+	}
+	printf("\nRecorded %u card reader exchanges to %s\n", recorder->exchange_count, filename);
+
+	return 0;
+}
+
+static uint8_t* load_transcript(const char* filename, size_t* len)
+{
+	FILE* file;
+	const size_t block_size = 4096;
+	uint8_t* buf = NULL;
+	size_t buf_len = 0;
+	size_t total_len = 0;
+
+	file = fopen(filename, "rb");
+	if (!file) {
+		fprintf(stderr, "Failed to open transcript file \"%s\"\n", filename);
+		return NULL;
+	}
+
+	do {
+		uint8_t* new_buf;
+
+		// Grow buffer
+		buf_len += block_size;
+		new_buf = realloc(buf, buf_len);
+		if (!new_buf) {
+			free(buf);
+			fclose(file);
+			return NULL;
+		}
+		buf = new_buf;
+
+		// Read next block
+		total_len += fread(buf + total_len, 1, block_size, file);
+		if (ferror(file)) {
+			fprintf(stderr, "Failed to read transcript file \"%s\"\n", filename);
+			free(buf);
+			fclose(file);
+			return NULL;
+		}
+	} while (!feof(file));
+	fclose(file);
+
+	*len = total_len;
+	return buf;
+}
+
+static void print_ttl_stats(const struct emv_ttl_stats_t* stats)
+{
+	printf("\nCard reader statistics:\n");
+	for (unsigned int i = 0; i < EMV_TTL_CMD_COUNT; ++i) {
+		const struct emv_ttl_cmd_stats_t* cmd_stats = &stats->cmd[i];
+		unsigned long histogram_max = 0;
+		unsigned int histogram_last = 0;
+
+		if (!cmd_stats->count) {
+			continue;
+		}
+
+		printf("%s: count=%lu; errors=%lu; exchanges=%lu; GET RESPONSE=%lu; tx=%" PRIu64 " bytes; rx=%" PRIu64 " bytes\n",
+			emv_ttl_cmd_get_string(i),
+			cmd_stats->count,
+			cmd_stats->error_count,
+			cmd_stats->exchange_count,
+			cmd_stats->get_response_count,
+			cmd_stats->tx_bytes,
+			cmd_stats->rx_bytes
+		);
+		printf("  latency: min=%.3f ms; avg=%.3f ms; max=%.3f ms\n",
+			cmd_stats->min_us / 1000.0,
+			cmd_stats->total_us / 1000.0 / cmd_stats->count,
+			cmd_stats->max_us / 1000.0
+		);
+
+		for (unsigned int j = 0; j < EMV_TTL_STATS_HISTOGRAM_BUCKETS; ++j) {
+			if (cmd_stats->histogram[j]) {
+				histogram_last = j;
+				if (cmd_stats->histogram[j] > histogram_max) {
+					histogram_max = cmd_stats->histogram[j];
+				}
+			}
+		}
+
+		for (unsigned int j = 0; j <= histogram_last; ++j) {
+			char range[32];
+			unsigned int bar_len;
+
+			if (j == 0) {
+				snprintf(range, sizeof(range), "< 1 ms");
+			} else if (j == EMV_TTL_STATS_HISTOGRAM_BUCKETS - 1) {
+				snprintf(range, sizeof(range), ">= %lu ms", 1UL << (j - 1));
+			} else {
+				snprintf(range, sizeof(range), "%lu-%lu ms", 1UL << (j - 1), 1UL << j);
+			}
+
+			// Scale bars to at most 40 characters
+			bar_len = (cmd_stats->histogram[j] * 40 + histogram_max - 1) / histogram_max;
+			printf("  %12s |%.*s %lu\n",
+				range,
+				(int)bar_len,
+				"########################################",
+				cmd_stats->histogram[j]
+			);
+		}
+	}
+}
+
 int main(int argc, char** argv)
 {
 	int r;
-	pcsc_ctx_t pcsc;
+	pcsc_ctx_t pcsc = NULL;
 	size_t pcsc_count;
-	pcsc_reader_ctx_t reader;
+	pcsc_reader_ctx_t reader = NULL;
 	unsigned int reader_state;
 	const char* reader_state_str;
 	size_t reader_idx;
@@ -745,6 +912,10 @@ int main(int argc, char** argv)
 	struct emv_ctx_t emv;
 	struct emv_app_list_t app_list = EMV_APP_LIST_INIT; // Candidate list
 	bool application_selection_required;
+	struct emv_transcript_recorder_t recorder;
+	struct emv_transcript_replayer_t replayer;
+	uint8_t* transcript = NULL;
+	size_t transcript_len = 0;
 
 	if (argc == 1) {
 		// No command line arguments
@@ -780,15 +951,27 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	print_set_verbose(debug_verbose);
-
-	r = emv_strings_init(isocodes_path, mcc_json);
-	if (r < 0) {
-		fprintf(stderr, "Failed to initialise EMV strings\n");
+	if (debug_record_filename && debug_replay_filename) {
+		fprintf(stderr, "Card reader transcript cannot be recorded (--debug-record) during replay (--debug-replay)\n");
+		argp_help(&argp_config, stdout, ARGP_HELP_STD_HELP, argv[0]);
 		return 1;
 	}
-	if (r > 0) {
-		fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups may not be possible\n");
+
+	print_set_verbose(debug_verbose);
+
+	if (isocodes_path || mcc_json) {
+		// Load overridden data immediately to report errors
+		r = emv_strings_init(isocodes_path, mcc_json);
+		if (r < 0) {
+			fprintf(stderr, "Failed to initialise EMV strings\n");
+			return 1;
+		}
+		if (r > 0) {
+			fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups may not be possible\n");
+		}
+	} else {
+		// Load default data upon first use to avoid startup delay
+		emv_strings_init_lazy(NULL, NULL);
 	}
 
 	r = emv_debug_init(
@@ -800,9 +983,31 @@ int main(int argc, char** argv)
 		printf("Failed to initialise EMV debugging\n");
 		return 1;
 	}
+	if (debug_trace_filename) {
+		struct emv_debug_config_t trace_config;
+
+		debug_trace_file = fopen(debug_trace_filename, "wb");
+		if (!debug_trace_file) {
+			fprintf(stderr, "Failed to open debug trace file \"%s\"\n", debug_trace_filename);
+			return 1;
+		}
+		r = emv_trace_writer_init(&debug_trace_writer, debug_trace_file);
+		if (r) {
+			fprintf(stderr, "emv_trace_writer_init() failed; r=%d\n", r);
+			fclose(debug_trace_file);
+			return 1;
+		}
+
+		trace_config.sources_mask = debug_sources_mask;
+		trace_config.level = debug_level;
+		trace_config.func = &emv_trace_debug_func;
+		trace_config.user_data = &debug_trace_writer;
+		emv_debug_set_thread_config(&trace_config);
+	}
 	emv_debug_trace_msg("Debugging enabled; debug_verbose=%d; debug_sources_mask=0x%02X; debug_level=%u", debug_verbose, debug_sources_mask, debug_level);
 
 	// Prepare for EMV transaction
+	memset(&recorder, 0, sizeof(recorder));
 	r = emv_ctx_init(&emv, NULL);
 	if (r) {
 		fprintf(stderr, "emv_ctx_init() failed; r=%d\n", r);
@@ -822,6 +1027,32 @@ int main(int argc, char** argv)
 		txn_amount_other // Transaction Amount, Other
 	);
 
+	if (debug_replay_filename) {
+		// Replace PC/SC card reader with card reader transcript
+		transcript = load_transcript(debug_replay_filename, &transcript_len);
+		if (!transcript) {
+			printf("Failed to load card reader transcript\n");
+			goto pcsc_exit;
+		}
+		emv_ttl_init(&ttl);
+		r = emv_transcript_replayer_init(&replayer, transcript, transcript_len, &ttl.cardreader);
+		if (r) {
+			printf("Invalid card reader transcript \"%s\"; r=%d\n", debug_replay_filename, r);
+			goto pcsc_exit;
+		}
+
+		// Use recorded terminal data that is not reproducible such that
+		// the Data Object List (DOL) data matches the recorded transaction
+		r = emv_transcript_replayer_load_terminal_data(&replayer, &emv);
+		if (r < 0) {
+			printf("Failed to load terminal data from card reader transcript; r=%d\n", r);
+			goto pcsc_exit;
+		}
+		if (r > 0) {
+			printf("Card reader transcript has no terminal data; replay may fail\n");
+		}
+	}
+
 	printf("\nTerminal config:\n");
 	print_emv_tlv_list(&emv.config.data);
 
@@ -831,6 +1062,14 @@ int main(int argc, char** argv)
 	printf("\nTransaction parameters:\n");
 	print_emv_tlv_list(&emv.params);
 
+	if (transcript) {
+		printf("\nReplaying %u card reader exchanges from %s\n", replayer.exchange_count, debug_replay_filename);
+		memcpy(atr, replayer.atr, replayer.atr_len);
+		atr_len = replayer.atr_len;
+		pos_entry_mode = EMV_POS_ENTRY_MODE_ICC_WITH_CVV;
+		goto card_activated;
+	}
+
 	printf("\nActivating card readers\n");
 	r = pcsc_init(&pcsc);
 	if (r < 0) {
@@ -906,6 +1145,7 @@ int main(int argc, char** argv)
 		printf("Failed to retrieve ATR\n");
 		goto pcsc_exit;
 	}
+card_activated:
 	emv_debug_trace_data("ATR", atr, atr_len);
 
 	r = emv_atr_parse(atr, atr_len);
@@ -918,12 +1158,26 @@ int main(int argc, char** argv)
 		goto pcsc_exit;
 	}
 
-	// Populate Terminal Transport Layer (TTL) for current reader
-	memset(&ttl, 0, sizeof(ttl));
-	ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
-	ttl.cardreader.ctx = reader;
-	ttl.cardreader.trx = &pcsc_reader_trx;
-	r = emv_card_activated(&emv, &ttl);
+	// Populate Terminal Transport Layer (TTL) for current reader. PC/SC
+	// implements the transmission protocol selected during card connection
+	// and therefore APDU mode is used. Card readers in TPDU mode rely on
+	// emv_card_activated_atr() to select the transmission protocol.
+	// The card reader transcript replayer was already populated and uses
+	// the recorded card reader mode instead.
+	if (!transcript) {
+		emv_ttl_init(&ttl);
+		ttl.cardreader.mode = EMV_CARDREADER_MODE_APDU;
+		ttl.cardreader.ctx = reader;
+		ttl.cardreader.trx = &pcsc_reader_trx;
+	}
+	if (debug_record_filename) {
+		r = emv_transcript_recorder_init(&recorder, &ttl.cardreader, atr, atr_len);
+		if (r) {
+			printf("Failed to start card reader transcript recording\n");
+			goto pcsc_exit;
+		}
+	}
+	r = emv_card_activated_atr(&emv, &ttl, atr, atr_len);
 	if (r < 0) {
 		printf("ERROR: %s\n", emv_error_get_string(r));
 		goto emv_exit;
@@ -1095,6 +1349,13 @@ int main(int argc, char** argv)
 	printf("\nTerminal data:\n");
 	print_emv_tlv_list(&emv.terminal);
 
+	if (transcript) {
+		if (!emv_transcript_replayer_is_complete(&replayer)) {
+			printf("\nCard reader transcript not completely replayed\n");
+		}
+		goto emv_exit;
+	}
+
 	r = pcsc_reader_disconnect(reader);
 	if (r) {
 		printf("PC/SC reader deactivation failed\n");
@@ -1104,16 +1365,48 @@ int main(int argc, char** argv)
 
 emv_exit:
 	emv_app_list_clear(&app_list);
+	if (debug_stats) {
+		print_ttl_stats(&emv.stats);
+	}
+	if (recorder.data) {
+		r = emv_transcript_recorder_add_terminal_data(&recorder, &emv);
+		if (r) {
+			printf("Failed to record terminal data; r=%d\n", r);
+		}
+		r = save_transcript(debug_record_filename, &recorder);
+		if (r) {
+			printf("Failed to save card reader transcript\n");
+		}
+	}
 pcsc_exit:
+	emv_transcript_recorder_clear(&recorder);
+	if (transcript) {
+		free(transcript);
+	}
 	pcsc_release(&pcsc);
 config_exit:
 	emv_capk_clear();
 	emv_ctx_clear(&emv);
 
+	if (!isocodes_path && !mcc_json) {
+		// Report failure to load default data upon first use
+		r = emv_strings_get_load_result();
+		if (r) {
+			fprintf(stderr, "Failed to load iso-codes data or mcc-codes data; currency, country, language or MCC lookups were not possible\n");
+		}
+	}
+
 	if (isocodes_path) {
 		free(isocodes_path);
 	}
 	if (mcc_json) {
 		free(mcc_json);
 	}
+	if (debug_trace_file) {
+		emv_debug_set_thread_config(NULL);
+		if (debug_trace_writer.error) {
+			fprintf(stderr, "Failed to write debug trace file \"%s\"\n", debug_trace_filename);
+		}
+		fclose(debug_trace_file);
+	}
 }
@@ -43,6 +43,8 @@
 
 static bool verbose_enabled = true;
 static struct emv_tlv_sources_t cached_sources = EMV_TLV_SOURCES_INIT;
+static struct emv_tlv_sources_index_t cached_sources_index = EMV_TLV_SOURCES_INDEX_INIT;
+static struct emv_cert_cache_t cached_cert_cache = EMV_CERT_CACHE_INIT;
 
 void print_set_verbose(bool enabled)
 {
@@ -57,6 +59,14 @@ void print_set_sources(const struct emv_tlv_sources_t* sources)
 	}
 
 	cached_sources = *sources;
+	if (!cached_sources.index) {
+		// Use merged tag index for repeated lookups while rendering
+		emv_tlv_sources_enable_index(&cached_sources, &cached_sources_index);
+	}
+	if (!cached_sources.cert_cache) {
+		// Recover each certificate at most once while rendering
+		emv_tlv_sources_enable_cert_cache(&cached_sources, &cached_cert_cache);
+	}
 }
 
 void print_set_sources_from_ctx(const struct emv_ctx_t* ctx)
@@ -69,6 +79,8 @@ void print_set_sources_from_ctx(const struct emv_ctx_t* ctx)
 	cached_sources.count = 2;
 	cached_sources.list[0] = &ctx->icc;
 	cached_sources.list[1] = &ctx->terminal;
+	emv_tlv_sources_enable_index(&cached_sources, &cached_sources_index);
+	emv_tlv_sources_enable_cert_cache(&cached_sources, &cached_cert_cache);
 }
 
 void print_buf(const char* buf_name, const void* buf, size_t length)
@@ -899,7 +911,7 @@ void print_emv_dol(const void* ptr, size_t len, const char* prefix, unsigned int
 		memset(&emv_tlv, 0, sizeof(emv_tlv));
 		emv_tlv.tag = entry.tag;
 		emv_tlv.length = entry.length;
-		emv_tlv_get_info(&emv_tlv, NULL, &info, NULL, 0);
+		emv_tlv_get_tag_info(&emv_tlv, &info);
 
 		for (unsigned int i = 0; i < depth; ++i) {
 			printf("%s", prefix ? prefix : "");
@@ -930,7 +942,7 @@ void print_emv_tag_list(const void* ptr, size_t len, const char* prefix, unsigne
 
 		memset(&emv_tlv, 0, sizeof(emv_tlv));
 		emv_tlv.tag = tag;
-		emv_tlv_get_info(&emv_tlv, NULL, &info, NULL, 0);
+		emv_tlv_get_tag_info(&emv_tlv, &info);
 
 		for (unsigned int i = 0; i < depth; ++i) {
 			printf("%s", prefix ? prefix : "");
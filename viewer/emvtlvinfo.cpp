@@ -32,6 +32,7 @@
 
 static struct emv_tlv_sources_t defaultSources = EMV_TLV_SOURCES_INIT;
 static struct emv_tlv_list_t defaultSourcesList = EMV_TLV_LIST_INIT;
+static struct emv_cert_cache_t defaultCertCache = EMV_CERT_CACHE_INIT;
 
 static constexpr EmvFormat convertFormat(enum emv_format_t format)
 {
@@ -120,7 +121,7 @@ EmvTlvInfo::EmvTlvInfo(const struct emv_dol_entry_t* entry)
 	emv_tlv.tag = entry->tag;
 	emv_tlv.length = entry->length;
 
-	emv_tlv_get_info(&emv_tlv, &defaultSources, &info, nullptr, 0);
+	emv_tlv_get_tag_info(&emv_tlv, &info);
 	if (info.tag_name) {
 		m_tagName = info.tag_name;
 	}
@@ -143,7 +144,7 @@ EmvTlvInfo::EmvTlvInfo(unsigned int tag)
 	std::memset(&emv_tlv, 0, sizeof(emv_tlv));
 	emv_tlv.tag = tag;
 
-	emv_tlv_get_info(&emv_tlv, &defaultSources, &info, nullptr, 0);
+	emv_tlv_get_tag_info(&emv_tlv, &info);
 	if (info.tag_name) {
 		m_tagName = info.tag_name;
 	}
@@ -167,6 +168,7 @@ bool EmvTlvInfo::valueStrIsList() const
 void EmvTlvInfo::clearDefaultSources()
 {
 	emv_tlv_list_clear(&defaultSourcesList);
+	emv_cert_cache_clear(&defaultCertCache);
 	defaultSources = EMV_TLV_SOURCES_INIT;
 }
 
@@ -175,4 +177,7 @@ void EmvTlvInfo::setDefaultSources(const QByteArray& data)
 	clearDefaultSources();
 	emv_tlv_parse(data.constData(), data.size(), &defaultSourcesList);
 	defaultSources = { 1, { &defaultSourcesList } };
+
+	// Recover each certificate at most once while rendering
+	emv_tlv_sources_enable_cert_cache(&defaultSources, &defaultCertCache);
 }